@@ -0,0 +1,48 @@
+#
+# Build time SPIR-V for the VulkanFilterYuvCompute shader variants.
+#
+# Including this module adds the host tool vk-video-filter-shader-gen, which
+# compiles every filter variant with glslangValidator into
+# VulkanFilterYuvComputeSpirv.h. vk_video_precompile_filter_shaders(<target>)
+# then lets <target> use that table instead of compiling the filter shaders
+# at runtime. Nothing is done when BUILD_FILTER_SHADERS_SPIRV is OFF, when
+# cross compiling or when glslangValidator is not found; the filters then
+# fall back to shaderc.
+#
+# Include it from the top-level directory, after GLSLANG_VALIDATOR is searched
+# for, so that the tool does not pick up the libraries linked by the demos.
+#
+
+set(VK_VIDEO_FILTER_SHADERS_DIR ${CMAKE_BINARY_DIR}/filter_shaders)
+
+if(BUILD_FILTER_SHADERS_SPIRV AND NOT CMAKE_CROSSCOMPILING AND GLSLANG_VALIDATOR)
+    set(common_root ${CMAKE_CURRENT_LIST_DIR}/../common)
+    set(out_header ${VK_VIDEO_FILTER_SHADERS_DIR}/VulkanFilterYuvComputeSpirv.h)
+
+    add_executable(vk-video-filter-shader-gen
+        ${common_root}/tools/vk-video-filter-shader-gen/Main.cpp
+        ${common_root}/libs/VkCodecUtils/VulkanFilterYuvComputeShaders.cpp
+        ${common_root}/libs/VkCodecUtils/VulkanFilterYuvComputeShaders.h)
+    target_include_directories(vk-video-filter-shader-gen PRIVATE
+        ${common_root}/libs
+        ${common_root}/include)
+    target_compile_definitions(vk-video-filter-shader-gen PRIVATE -DVK_NO_PROTOTYPES)
+
+    add_custom_command(OUTPUT ${out_header}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${VK_VIDEO_FILTER_SHADERS_DIR}
+        COMMAND vk-video-filter-shader-gen ${out_header} ${GLSLANG_VALIDATOR} ${VK_VIDEO_FILTER_SHADERS_DIR}
+        DEPENDS vk-video-filter-shader-gen ${GLSLANG_VALIDATOR}
+        COMMENT "Compiling the YCbCr compute filter shaders to SPIR-V")
+    add_custom_target(vk-video-filter-shaders DEPENDS ${out_header})
+
+    unset(common_root)
+    unset(out_header)
+endif()
+
+function(vk_video_precompile_filter_shaders target)
+    if(TARGET vk-video-filter-shaders)
+        add_dependencies(${target} vk-video-filter-shaders)
+        target_include_directories(${target} PRIVATE ${VK_VIDEO_FILTER_SHADERS_DIR})
+        target_compile_definitions(${target} PRIVATE -DVK_VIDEO_PRECOMPILED_FILTER_SHADERS)
+    endif()
+endfunction()
@@ -68,11 +68,14 @@ struct ProgramConfig {
         gpuIndex = -1;
         forceParserType = VK_VIDEO_CODEC_OPERATION_NONE_KHR;
         decoderQueueSize = 5;
+        demuxReadAheadPackets = 0;
         enablePostProcessFilter = -1,
         enableStreamDemuxing = true;
         deviceId = (uint32_t)-1;
         directMode = false;
         enableHwLoadBalancing = false;
+        pipelinedParsing = false;
+        parserTelemetry = false;
         selectVideoWithComputeQueue = false;
         enableVideoEncoder = false;
         crcOutput = nullptr;
@@ -184,6 +187,20 @@ struct ProgramConfig {
                     enableHwLoadBalancing = true;
                     return true;
                 }},
+            {"--pipelinedParsing", nullptr, 0,
+                "Search the start codes of large packets on a separate thread, "
+                "concurrently with the parsing of the NAL units",
+                [this](const char **args, const ProgramArgs &a) {
+                    pipelinedParsing = true;
+                    return true;
+                }},
+            {"--parserTelemetry", nullptr, 0,
+                "Print the parser counters and client callback timings at the end "
+                "of the stream (also printed with --verboseValidate)",
+                [this](const char **args, const ProgramArgs &a) {
+                    parserTelemetry = true;
+                    return true;
+                }},
             {"--input", "-i", 1, "Input filename to decode",
                 [this](const char **args, const ProgramArgs &a) {
                     videoFileName = args[0];
@@ -207,6 +224,13 @@ struct ProgramConfig {
                     decoderQueueSize = std::atoi(args[0]);
                     return true;
                 }},
+            {"--demuxReadAhead", nullptr, 1,
+                "Demux up to the given number of packets ahead of the parser on a "
+                "separate thread - only used with the FFmpeg demuxer",
+                [this](const char **args, const ProgramArgs &a) {
+                    demuxReadAheadPackets = std::atoi(args[0]);
+                    return true;
+                }},
             {"--decodeImagesInFlight", nullptr, 1,
                 "The number of decode images that are in-flight in addition to the DPB required",
                 [this](const char **args, const ProgramArgs &a) {
@@ -322,6 +346,16 @@ struct ProgramConfig {
                     crcInitValue = crcInitValueTemp;
                     return true;
                 }},
+            {"--traceFile", nullptr, 1, "Record per-stage latency spans and write them to this file in the Chrome trace JSON format",
+                [this](const char **args, const ProgramArgs &a) {
+                    traceFileName = args[0];
+                    return true;
+                }},
+            {"--shaderCacheDir", nullptr, 1, "Directory for the persistent SPIR-V and pipeline cache of the compute filters",
+                [this](const char **args, const ProgramArgs &a) {
+                    shaderCacheDir = args[0];
+                    return true;
+                }},
         };
 
         for (int i = 1; i < argc; i++) {
@@ -451,6 +485,8 @@ struct ProgramConfig {
 
     std::string videoFileName;
     std::string outputFileName;
+    std::string traceFileName;
+    std::string shaderCacheDir;
     int gpuIndex;
     int loopCount;
     int queueId;
@@ -459,6 +495,7 @@ struct ProgramConfig {
     uint32_t *crcValues;
     uint32_t deviceId;
     uint32_t decoderQueueSize;
+    uint32_t demuxReadAheadPackets;
     int32_t enablePostProcessFilter;
     uint32_t *crcOutput;
     uint32_t enableStreamDemuxing : 1;
@@ -469,6 +506,8 @@ struct ProgramConfig {
     uint32_t verbose : 1;
     uint32_t noPresent : 1;
     uint32_t enableHwLoadBalancing : 1;
+    uint32_t pipelinedParsing : 1;
+    uint32_t parserTelemetry : 1;
     uint32_t selectVideoWithComputeQueue : 1;
     uint32_t enableVideoEncoder : 1;
     uint32_t outputy4m : 1;
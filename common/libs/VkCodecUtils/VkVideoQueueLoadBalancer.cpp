@@ -0,0 +1,190 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <assert.h>
+#include "VkCodecUtils/VkVideoQueueLoadBalancer.h"
+
+void VkVideoQueueLoadBalancer::Reset(uint32_t numQueues, uint32_t affinitySlack)
+{
+    assert(numQueues > 0);
+    m_queues.assign((numQueues > 0) ? numQueues : 1, QueueState());
+    for (size_t queueIndex = 0; queueIndex < m_queues.size(); queueIndex++) {
+        m_queues[queueIndex].submittedValue = 0;
+        m_queues[queueIndex].completedValue = 0;
+        m_queues[queueIndex].load = 0;
+        m_queues[queueIndex].numAffineStreams = 0;
+    }
+    m_streams.clear();
+    m_affinitySlack = affinitySlack;
+    m_totalLoad = 0;
+}
+
+int32_t VkVideoQueueLoadBalancer::RegisterStream(uint32_t weight)
+{
+    StreamState stream;
+    stream.active = 1;
+    stream.weight = (weight > 0) ? weight : 1;
+    stream.queueIndex = -1;
+    stream.load = 0;
+
+    // Reuse the slot of a stream that is gone and has no outstanding work left.
+    for (size_t streamId = 0; streamId < m_streams.size(); streamId++) {
+        if (!m_streams[streamId].active && (m_streams[streamId].load == 0)) {
+            m_streams[streamId] = stream;
+            return (int32_t)streamId;
+        }
+    }
+
+    m_streams.push_back(stream);
+    return (int32_t)(m_streams.size() - 1);
+}
+
+void VkVideoQueueLoadBalancer::UnregisterStream(int32_t streamId)
+{
+    if (!IsValidStream(streamId)) {
+        return;
+    }
+
+    SetStreamQueue(m_streams[streamId], -1);
+    m_streams[streamId].active = 0;
+}
+
+void VkVideoQueueLoadBalancer::SetStreamQueue(StreamState& stream, int32_t queueIndex)
+{
+    if (stream.queueIndex == queueIndex) {
+        return;
+    }
+
+    if (stream.queueIndex >= 0) {
+        assert(m_queues[stream.queueIndex].numAffineStreams > 0);
+        m_queues[stream.queueIndex].numAffineStreams--;
+    }
+    if (queueIndex >= 0) {
+        m_queues[queueIndex].numAffineStreams++;
+    }
+    stream.queueIndex = queueIndex;
+}
+
+uint32_t VkVideoQueueLoadBalancer::GetBusyWeight(int32_t streamId) const
+{
+    uint32_t busyWeight = 0;
+    for (size_t i = 0; i < m_streams.size(); i++) {
+        if (m_streams[i].active && ((m_streams[i].load > 0) || ((int32_t)i == streamId))) {
+            busyWeight += m_streams[i].weight;
+        }
+    }
+    return busyWeight;
+}
+
+int32_t VkVideoQueueLoadBalancer::SelectQueue(int32_t streamId) const
+{
+    assert(IsValidStream(streamId));
+
+    uint32_t minLoad = m_queues[0].load;
+    for (size_t queueIndex = 1; queueIndex < m_queues.size(); queueIndex++) {
+        if (m_queues[queueIndex].load < minLoad) {
+            minLoad = m_queues[queueIndex].load;
+        }
+    }
+
+    if (IsValidStream(streamId) && (m_streams[streamId].queueIndex >= 0)) {
+
+        const StreamState& stream = m_streams[streamId];
+
+        // Affinity: stay on the same queue while it isn't noticeably busier than the others.
+        if (m_queues[stream.queueIndex].load <= (minLoad + m_affinitySlack)) {
+            return stream.queueIndex;
+        }
+
+        // Fairness: load * busyWeight > totalLoad * weight is load > weight / busyWeight of the total.
+        if (((uint64_t)stream.load * GetBusyWeight(streamId)) > ((uint64_t)m_totalLoad * stream.weight)) {
+            return stream.queueIndex;
+        }
+    }
+
+    // The least loaded queue, then the one with the fewest streams attached to it.
+    int32_t bestQueue = -1;
+    for (size_t queueIndex = 0; queueIndex < m_queues.size(); queueIndex++) {
+        const QueueState& queue = m_queues[queueIndex];
+        if (queue.load != minLoad) {
+            continue;
+        }
+        if ((bestQueue < 0) || (queue.numAffineStreams < m_queues[bestQueue].numAffineStreams)) {
+            bestQueue = (int32_t)queueIndex;
+        }
+    }
+
+    assert(bestQueue >= 0);
+    return bestQueue;
+}
+
+uint64_t VkVideoQueueLoadBalancer::Submit(int32_t streamId, uint32_t queueIndex, uint32_t cost)
+{
+    assert(queueIndex < m_queues.size());
+    assert(IsValidStream(streamId));
+
+    QueueState& queue = m_queues[queueIndex];
+    Submission submission;
+    submission.value = ++queue.submittedValue;
+    submission.streamId = streamId;
+    submission.cost = cost;
+    queue.pending.push_back(submission);
+    queue.load += cost;
+    m_totalLoad += cost;
+
+    if (IsValidStream(streamId)) {
+        StreamState& stream = m_streams[streamId];
+        stream.load += cost;
+        SetStreamQueue(stream, (int32_t)queueIndex);
+    }
+
+    return submission.value;
+}
+
+uint32_t VkVideoQueueLoadBalancer::Complete(uint32_t queueIndex, uint64_t completedValue)
+{
+    assert(queueIndex < m_queues.size());
+
+    QueueState& queue = m_queues[queueIndex];
+    if (completedValue > queue.submittedValue) {
+        // The semaphore can't be ahead of what was submitted to it.
+        assert(!"The completed value is ahead of the submitted value");
+        completedValue = queue.submittedValue;
+    }
+    if (completedValue <= queue.completedValue) {
+        return 0;
+    }
+    queue.completedValue = completedValue;
+
+    uint32_t numRetired = 0;
+    while (!queue.pending.empty() && (queue.pending.front().value <= completedValue)) {
+
+        const Submission& submission = queue.pending.front();
+        assert(queue.load >= submission.cost);
+        queue.load -= submission.cost;
+        assert(m_totalLoad >= submission.cost);
+        m_totalLoad -= submission.cost;
+        if ((submission.streamId >= 0) && ((size_t)submission.streamId < m_streams.size())) {
+            assert(m_streams[submission.streamId].load >= submission.cost);
+            m_streams[submission.streamId].load -= submission.cost;
+        }
+
+        queue.pending.pop_front();
+        numRetired++;
+    }
+
+    return numRetired;
+}
@@ -0,0 +1,122 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _VKCODECUTILS_VKVIDEOQUEUELOADBALANCER_H_
+#define _VKCODECUTILS_VKVIDEOQUEUELOADBALANCER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <deque>
+
+// The queue selection policy of VulkanVideoQueueScheduler. It has no Vulkan
+// dependencies: the submissions of each queue are numbered with the values
+// the queue's timeline semaphore is going to be signaled with, and Complete()
+// is called with the value the semaphore has reached. This way the policy can
+// also be driven with simulated completion times on the CPU, as
+// vk-video-queue-simulator does.
+//
+// The load of a queue is the sum of the costs of its outstanding submissions.
+// Each stream has an affinity to the queue it last submitted to and stays
+// there unless the queue is loaded by more than the affinity slack compared
+// to the least loaded one. For fairness, a stream that already has more than
+// its weighted share of the outstanding work can't migrate to another queue,
+// so a busy stream can't spread over all the queues and starve the others.
+class VkVideoQueueLoadBalancer {
+
+public:
+
+    enum { INVALID_STREAM_ID = -1 };
+
+    explicit VkVideoQueueLoadBalancer(uint32_t numQueues = 1, uint32_t affinitySlack = 1)
+        : m_queues()
+        , m_streams()
+        , m_affinitySlack(affinitySlack)
+        , m_totalLoad(0)
+    {
+        Reset(numQueues, affinitySlack);
+    }
+
+    // Drops all the streams and outstanding submissions.
+    void Reset(uint32_t numQueues, uint32_t affinitySlack = 1);
+
+    // Returns the stream id, with a weight > 1 for the streams that deserve
+    // more than one share of the queues (e.g. higher resolution or frame rate).
+    int32_t RegisterStream(uint32_t weight = 1);
+    // The outstanding submissions of the stream are still accounted to their
+    // queues until they complete.
+    void UnregisterStream(int32_t streamId);
+
+    // The queue the next submission of streamId should go to.
+    int32_t SelectQueue(int32_t streamId) const;
+
+    // Records a submission of the stream to the queue and returns the timeline
+    // value the submission must signal when it completes.
+    uint64_t Submit(int32_t streamId, uint32_t queueIndex, uint32_t cost = 1);
+
+    // Retires the submissions of the queue up to and including completedValue.
+    // Returns the number of retired submissions.
+    uint32_t Complete(uint32_t queueIndex, uint64_t completedValue);
+
+    uint32_t GetNumQueues() const { return (uint32_t)m_queues.size(); }
+    uint32_t GetQueueLoad(uint32_t queueIndex) const { return m_queues[queueIndex].load; }
+    uint32_t GetQueuePendingCount(uint32_t queueIndex) const { return (uint32_t)m_queues[queueIndex].pending.size(); }
+    uint64_t GetQueueSubmittedValue(uint32_t queueIndex) const { return m_queues[queueIndex].submittedValue; }
+    uint64_t GetQueueCompletedValue(uint32_t queueIndex) const { return m_queues[queueIndex].completedValue; }
+    uint32_t GetTotalLoad() const { return m_totalLoad; }
+    uint32_t GetAffinitySlack() const { return m_affinitySlack; }
+
+    bool IsValidStream(int32_t streamId) const
+    {
+        return (streamId >= 0) && ((size_t)streamId < m_streams.size()) && m_streams[streamId].active;
+    }
+    uint32_t GetStreamLoad(int32_t streamId) const { return m_streams[streamId].load; }
+    int32_t  GetStreamQueue(int32_t streamId) const { return m_streams[streamId].queueIndex; }
+
+private:
+
+    struct Submission {
+        uint64_t value;
+        int32_t  streamId;
+        uint32_t cost;
+    };
+
+    struct QueueState {
+        std::deque<Submission> pending;
+        uint64_t submittedValue;
+        uint64_t completedValue;
+        uint32_t load;
+        uint32_t numAffineStreams;
+    };
+
+    struct StreamState {
+        uint32_t active : 1;
+        uint32_t weight;
+        int32_t  queueIndex;
+        uint32_t load;
+    };
+
+    // Sum of the weights of the streams with outstanding work, plus streamId's.
+    uint32_t GetBusyWeight(int32_t streamId) const;
+    void SetStreamQueue(StreamState& stream, int32_t queueIndex);
+
+    std::vector<QueueState>  m_queues;
+    std::vector<StreamState> m_streams;
+    uint32_t                 m_affinitySlack;
+    uint32_t                 m_totalLoad;
+};
+
+#endif /* _VKCODECUTILS_VKVIDEOQUEUELOADBALANCER_H_ */
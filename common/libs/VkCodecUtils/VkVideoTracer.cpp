@@ -0,0 +1,229 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#if defined(_WIN32)
+#include <process.h>
+#define VK_VIDEO_TRACER_GETPID _getpid
+#else
+#include <unistd.h>
+#define VK_VIDEO_TRACER_GETPID getpid
+#endif
+#include "VkCodecUtils/VkVideoTracer.h"
+
+namespace {
+
+struct TraceEvent {
+    const char* category;
+    const char* name;
+    int64_t     frameId;
+    uint64_t    startNs;
+    uint64_t    durationNs;
+};
+
+// Single writer (the owning thread), read by the exporter.
+struct ThreadTraceBuffer {
+    ThreadTraceBuffer(uint32_t threadId)
+        : events(VkVideoTracer::ThreadBufferSize)
+        , writeIndex(0)
+        , tid(threadId)
+        , name()
+    { }
+
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t>   writeIndex;
+    const uint32_t          tid;
+    std::string             name; // protected by the registry mutex
+};
+
+struct TraceRegistry {
+    TraceRegistry()
+        : lock()
+        , threadBuffers()
+        , nextThreadId(0)
+        , baseTimeNs(0)
+    { }
+
+    std::mutex                      lock;
+    std::vector<ThreadTraceBuffer*> threadBuffers;
+    uint32_t                        nextThreadId;
+    uint64_t                        baseTimeNs;
+};
+
+// Intentionally never freed, so the buffers outlive any thread still recording at exit.
+TraceRegistry* GetRegistry()
+{
+    static TraceRegistry* registry = new TraceRegistry();
+    return registry;
+}
+
+thread_local ThreadTraceBuffer* t_threadBuffer = nullptr;
+
+ThreadTraceBuffer* GetThreadBuffer()
+{
+    if (t_threadBuffer == nullptr) {
+        TraceRegistry* registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry->lock);
+        t_threadBuffer = new ThreadTraceBuffer(++registry->nextThreadId);
+        registry->threadBuffers.push_back(t_threadBuffer);
+    }
+    return t_threadBuffer;
+}
+
+void WriteJsonString(FILE* fp, const char* str)
+{
+    fputc('"', fp);
+    for (const char* p = str; *p != '\0'; p++) {
+        const unsigned char c = (unsigned char)*p;
+        if ((c == '"') || (c == '\\')) {
+            fputc('\\', fp);
+            fputc(c, fp);
+        } else if (c < 0x20) {
+            fprintf(fp, "\\u%04x", c);
+        } else {
+            fputc(c, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+} // namespace
+
+std::atomic<bool> VkVideoTracer::s_enabled(false);
+
+uint64_t VkVideoTracer::GetTimestampNs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void VkVideoTracer::Enable(bool enable)
+{
+    if (enable) {
+        TraceRegistry* registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry->lock);
+        if (registry->baseTimeNs == 0) {
+            registry->baseTimeNs = GetTimestampNs();
+        }
+    }
+    s_enabled.store(enable, std::memory_order_relaxed);
+}
+
+void VkVideoTracer::RecordSpan(const char* category, const char* name, int64_t frameId,
+                               uint64_t startNs, uint64_t endNs)
+{
+    ThreadTraceBuffer* buffer = GetThreadBuffer();
+    const uint64_t index = buffer->writeIndex.load(std::memory_order_relaxed);
+
+    TraceEvent& event = buffer->events[index % ThreadBufferSize];
+    event.category = category;
+    event.name = name;
+    event.frameId = frameId;
+    event.startNs = startNs;
+    event.durationNs = (endNs > startNs) ? (endNs - startNs) : 0;
+
+    buffer->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void VkVideoTracer::SetThreadName(const char* name)
+{
+    if (!IsEnabled()) {
+        return;
+    }
+
+    ThreadTraceBuffer* buffer = GetThreadBuffer();
+    TraceRegistry* registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry->lock);
+    buffer->name = name;
+}
+
+bool VkVideoTracer::WriteChromeTrace(const char* fileName)
+{
+    FILE* fp = fopen(fileName, "wb");
+    if (fp == nullptr) {
+        fprintf(stderr, "Tracer: can't open the trace file %s\n", fileName);
+        return false;
+    }
+
+    TraceRegistry* registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry->lock);
+
+    const int pid = (int)VK_VIDEO_TRACER_GETPID();
+    uint64_t numEvents = 0;
+    uint64_t numOverwritten = 0;
+    bool first = true;
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    for (size_t t = 0; t < registry->threadBuffers.size(); t++) {
+        const ThreadTraceBuffer* buffer = registry->threadBuffers[t];
+
+        if (!buffer->name.empty()) {
+            fprintf(fp, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":",
+                    first ? "" : ",\n", pid, buffer->tid);
+            WriteJsonString(fp, buffer->name.c_str());
+            fprintf(fp, "}}");
+            first = false;
+        }
+
+        const uint64_t endIndex = buffer->writeIndex.load(std::memory_order_acquire);
+        const uint64_t startIndex = (endIndex > ThreadBufferSize) ? (endIndex - ThreadBufferSize) : 0;
+        numOverwritten += startIndex;
+
+        for (uint64_t i = startIndex; i < endIndex; i++) {
+            const TraceEvent event = buffer->events[i % ThreadBufferSize];
+
+            // If the thread is still recording, the oldest slots may have been
+            // reused while copying; skip those rather than emit a torn span.
+            const uint64_t currentIndex = buffer->writeIndex.load(std::memory_order_acquire);
+            if (currentIndex >= (i + ThreadBufferSize)) {
+                continue;
+            }
+
+            const uint64_t startNs = (event.startNs > registry->baseTimeNs) ?
+                                         (event.startNs - registry->baseTimeNs) : 0;
+
+            fprintf(fp, "%s{\"ph\":\"X\",\"cat\":", first ? "" : ",\n");
+            WriteJsonString(fp, event.category);
+            fprintf(fp, ",\"name\":");
+            WriteJsonString(fp, event.name);
+            fprintf(fp, ",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                    pid, buffer->tid, startNs / 1000.0, event.durationNs / 1000.0);
+            if (event.frameId >= 0) {
+                fprintf(fp, ",\"args\":{\"frame\":%lld}", (long long)event.frameId);
+            }
+            fprintf(fp, "}");
+            first = false;
+            numEvents++;
+        }
+    }
+
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+
+    printf("Tracer: wrote %llu spans from %u threads to %s\n",
+           (unsigned long long)numEvents, (uint32_t)registry->threadBuffers.size(), fileName);
+    if (numOverwritten > 0) {
+        fprintf(stderr, "Tracer: %llu older spans were overwritten, the per-thread buffers hold %u spans\n",
+                (unsigned long long)numOverwritten, ThreadBufferSize);
+    }
+
+    return true;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKCODECUTILS_VKVIDEOTRACER_H_
+#define _VKCODECUTILS_VKVIDEOTRACER_H_
+
+#include <stdint.h>
+#include <atomic>
+
+// Per-stage latency tracer for the decoder and encoder pipelines.
+//
+// Each thread records its spans into its own fixed-size ring buffer, so the
+// recording path takes no locks: the only shared access is the buffer
+// registration done once per thread. When tracing is disabled at runtime a
+// span costs a single relaxed atomic load. Defining VK_VIDEO_DISABLE_TRACING
+// removes the trace macros from the build altogether.
+//
+// The category and name of a span must be string literals (or otherwise
+// outlive the tracer), only the pointers are stored.
+class VkVideoTracer
+{
+public:
+    // Number of spans kept per thread, older spans are overwritten.
+    static const uint32_t ThreadBufferSize = 64 * 1024;
+
+    static bool IsEnabled() {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static void Enable(bool enable);
+
+    // Monotonic time in nanoseconds.
+    static uint64_t GetTimestampNs();
+
+    // frameId < 0 means the span is not tied to a frame.
+    static void RecordSpan(const char* category, const char* name, int64_t frameId,
+                           uint64_t startNs, uint64_t endNs);
+
+    // Name of the calling thread as shown by the trace viewer.
+    // Has no effect while tracing is disabled.
+    static void SetThreadName(const char* name);
+
+    // Writes all the recorded spans in the Chrome trace event JSON format,
+    // which can be loaded in chrome://tracing or ui.perfetto.dev.
+    // Should be called once the traced threads are idle.
+    static bool WriteChromeTrace(const char* fileName);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+class VkVideoTraceScope
+{
+public:
+    VkVideoTraceScope(const char* category, const char* name, int64_t frameId = -1)
+        : m_category(category)
+        , m_name(name)
+        , m_frameId(frameId)
+        , m_startNs(0)
+        , m_active(VkVideoTracer::IsEnabled())
+    {
+        if (m_active) {
+            m_startNs = VkVideoTracer::GetTimestampNs();
+        }
+    }
+
+    ~VkVideoTraceScope()
+    {
+        if (m_active) {
+            VkVideoTracer::RecordSpan(m_category, m_name, m_frameId,
+                                      m_startNs, VkVideoTracer::GetTimestampNs());
+        }
+    }
+
+    // For spans where the frame is only known once the work is done.
+    void SetFrameId(int64_t frameId) { m_frameId = frameId; }
+
+private:
+    VkVideoTraceScope(const VkVideoTraceScope&);
+    VkVideoTraceScope& operator=(const VkVideoTraceScope&);
+
+    const char* m_category;
+    const char* m_name;
+    int64_t     m_frameId;
+    uint64_t    m_startNs;
+    bool        m_active;
+};
+
+#define VK_VIDEO_TRACE_CONCAT_IMPL(a, b) a##b
+#define VK_VIDEO_TRACE_CONCAT(a, b) VK_VIDEO_TRACE_CONCAT_IMPL(a, b)
+
+#if !defined(VK_VIDEO_DISABLE_TRACING)
+#define VK_VIDEO_TRACE_SCOPE(category, name, frameId) \
+    VkVideoTraceScope VK_VIDEO_TRACE_CONCAT(vkVideoTraceScope, __LINE__)(category, name, (int64_t)(frameId))
+#define VK_VIDEO_TRACE_NAMED_SCOPE(var, category, name, frameId) \
+    VkVideoTraceScope var(category, name, (int64_t)(frameId))
+#define VK_VIDEO_TRACE_SET_FRAME_ID(var, frameId) (var).SetFrameId((int64_t)(frameId))
+#define VK_VIDEO_TRACE_THREAD_NAME(name) VkVideoTracer::SetThreadName(name)
+#else
+#define VK_VIDEO_TRACE_SCOPE(category, name, frameId)
+#define VK_VIDEO_TRACE_NAMED_SCOPE(var, category, name, frameId)
+#define VK_VIDEO_TRACE_SET_FRAME_ID(var, frameId)
+#define VK_VIDEO_TRACE_THREAD_NAME(name)
+#endif
+
+#endif /* _VKCODECUTILS_VKVIDEOTRACER_H_ */
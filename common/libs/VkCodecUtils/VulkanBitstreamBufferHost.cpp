@@ -0,0 +1,255 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+#include "VkCodecUtils/VulkanBitstreamBufferHost.h"
+
+VkResult
+VulkanBitstreamBufferHost::Create(VkDeviceSize bufferSize, VkDeviceSize bufferOffsetAlignment, VkDeviceSize bufferSizeAlignment,
+                                  const void* pInitializeBufferMemory, VkDeviceSize initializeBufferMemorySize,
+                                  VkSharedBaseObj<VulkanBitstreamBufferHost>& vulkanBitstreamBuffer)
+{
+    VkSharedBaseObj<VulkanBitstreamBufferHost> hostBitstreamBuffer(new VulkanBitstreamBufferHost(bufferOffsetAlignment,
+                                                                                                 bufferSizeAlignment));
+    if (!hostBitstreamBuffer) {
+        assert(!"Out of host memory!");
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    VkResult result = hostBitstreamBuffer->Initialize(bufferSize,
+                                                      pInitializeBufferMemory,
+                                                      initializeBufferMemorySize);
+    if (result == VK_SUCCESS) {
+        vulkanBitstreamBuffer = hostBitstreamBuffer;
+    } else {
+        assert(!"Initialize failed!");
+    }
+
+    return result;
+}
+
+VkResult VulkanBitstreamBufferHost::Initialize(VkDeviceSize bufferSize,
+                                               const void* pInitializeBufferMemory,
+                                               VkDeviceSize initializeBufferMemorySize)
+{
+    bufferSize = ((bufferSize + (m_bufferSizeAlignment - 1)) & ~(m_bufferSizeAlignment - 1));
+    if (initializeBufferMemorySize > bufferSize) {
+        assert(!"The initialization data does not fit in the buffer!");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    // New storage is zero-initialized, the parser relies on zero padding past the data.
+    m_data.assign((size_t)bufferSize, 0);
+    m_bufferSize = bufferSize;
+
+    if ((pInitializeBufferMemory != nullptr) && (initializeBufferMemorySize != 0)) {
+        memcpy(m_data.data(), pInitializeBufferMemory, (size_t)initializeBufferMemorySize);
+    }
+
+    m_streamMarkers.reserve(256);
+    ResetStreamMarkers();
+
+    return VK_SUCCESS;
+}
+
+VkDeviceSize VulkanBitstreamBufferHost::Clone(VkDeviceSize newSize, VkDeviceSize copySize, VkDeviceSize copyOffset,
+                                              VkSharedBaseObj<VulkanBitstreamBuffer>& vulkanBitstreamBuffer)
+{
+    const uint8_t* oldBufPtr = nullptr;
+    if (copySize) {
+        oldBufPtr = CheckAccess(copyOffset, copySize);
+        if (oldBufPtr == nullptr) {
+            return 0;
+        }
+    }
+
+    VkSharedBaseObj<VulkanBitstreamBufferHost> hostBitstreamBuffer;
+    VkResult result = Create(newSize, m_bufferOffsetAlignment, m_bufferSizeAlignment,
+                             oldBufPtr, copySize, hostBitstreamBuffer);
+    if (result != VK_SUCCESS) {
+        return 0;
+    }
+
+    vulkanBitstreamBuffer = hostBitstreamBuffer;
+    return hostBitstreamBuffer->GetMaxSize();
+}
+
+VkDeviceSize VulkanBitstreamBufferHost::Resize(VkDeviceSize newSize, VkDeviceSize copySize, VkDeviceSize copyOffset)
+{
+    if (m_bufferSize >= newSize) {
+        return m_bufferSize;
+    }
+
+    newSize = ((newSize + (m_bufferSizeAlignment - 1)) & ~(m_bufferSizeAlignment - 1));
+
+    std::vector<uint8_t> newData((size_t)newSize, 0);
+    if (copySize) {
+        const uint8_t* pCopyData = CheckAccess(copyOffset, copySize);
+        if (pCopyData == nullptr) {
+            return 0;
+        }
+        memcpy(newData.data(), pCopyData, (size_t)copySize);
+    }
+
+    m_data.swap(newData);
+    m_bufferSize = newSize;
+
+    return newSize;
+}
+
+uint8_t* VulkanBitstreamBufferHost::CheckAccess(VkDeviceSize offset, VkDeviceSize size) const
+{
+    if (offset + size <= m_bufferSize) {
+        return const_cast<uint8_t*>(m_data.data()) + offset;
+    }
+
+    assert(!"Bad buffer access - out of range!");
+    return nullptr;
+}
+
+int64_t VulkanBitstreamBufferHost::MemsetData(uint32_t value, VkDeviceSize offset, VkDeviceSize size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    uint8_t* pData = CheckAccess(offset, size);
+    if (pData == nullptr) {
+        return -1;
+    }
+    memset(pData, (int)value, (size_t)size);
+    return size;
+}
+
+int64_t VulkanBitstreamBufferHost::CopyDataToBuffer(uint8_t *dstBuffer, VkDeviceSize dstOffset,
+                                                    VkDeviceSize srcOffset, VkDeviceSize size) const
+{
+    if (size == 0) {
+        return 0;
+    }
+    const uint8_t* readData = CheckAccess(srcOffset, size);
+    if (readData == nullptr) {
+        assert(!"Could not CopyDataToBuffer!");
+        return -1;
+    }
+    memcpy(dstBuffer + dstOffset, readData, (size_t)size);
+    return size;
+}
+
+int64_t VulkanBitstreamBufferHost::CopyDataToBuffer(VkSharedBaseObj<VulkanBitstreamBuffer>& dstBuffer, VkDeviceSize dstOffset,
+                                                    VkDeviceSize srcOffset, VkDeviceSize size) const
+{
+    if (size == 0) {
+        return 0;
+    }
+    const uint8_t* readData = CheckAccess(srcOffset, size);
+    if (readData == nullptr) {
+        assert(!"Could not CopyDataToBuffer!");
+        return -1;
+    }
+    return dstBuffer->CopyDataFromBuffer(readData, 0, dstOffset, size);
+}
+
+int64_t VulkanBitstreamBufferHost::CopyDataFromBuffer(const uint8_t *sourceBuffer, VkDeviceSize srcOffset,
+                                                      VkDeviceSize dstOffset, VkDeviceSize size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    uint8_t* writeData = CheckAccess(dstOffset, size);
+    if (writeData == nullptr) {
+        assert(!"Could not CopyDataFromBuffer!");
+        return -1;
+    }
+    memcpy(writeData, sourceBuffer + srcOffset, (size_t)size);
+    return size;
+}
+
+int64_t VulkanBitstreamBufferHost::CopyDataFromBuffer(const VkSharedBaseObj<VulkanBitstreamBuffer>& sourceBuffer,
+                                                      VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    VkDeviceSize maxSize = 0;
+    const uint8_t* readData = sourceBuffer->GetReadOnlyDataPtr(srcOffset, maxSize);
+    if ((readData == nullptr) || (maxSize < size)) {
+        assert(!"Could not CopyDataFromBuffer!");
+        return -1;
+    }
+    return CopyDataFromBuffer(readData, 0, dstOffset, size);
+}
+
+uint8_t* VulkanBitstreamBufferHost::GetDataPtr(VkDeviceSize offset, VkDeviceSize &maxSize)
+{
+    uint8_t* readData = CheckAccess(offset, 1);
+    if (readData == nullptr) {
+        assert(!"Could not GetDataPtr()!");
+        return nullptr;
+    }
+    maxSize = m_bufferSize - offset;
+    return readData;
+}
+
+const uint8_t* VulkanBitstreamBufferHost::GetReadOnlyDataPtr(VkDeviceSize offset, VkDeviceSize &maxSize) const
+{
+    const uint8_t* readData = CheckAccess(offset, 1);
+    if (readData == nullptr) {
+        assert(!"Could not GetReadOnlyDataPtr()!");
+        return nullptr;
+    }
+    maxSize = m_bufferSize - offset;
+    return readData;
+}
+
+uint32_t VulkanBitstreamBufferHost::AddStreamMarker(uint32_t streamOffset)
+{
+    m_streamMarkers.push_back(streamOffset);
+    return (uint32_t)(m_streamMarkers.size() - 1);
+}
+
+uint32_t VulkanBitstreamBufferHost::SetStreamMarker(uint32_t streamOffset, uint32_t index)
+{
+    assert(index < (uint32_t)m_streamMarkers.size());
+    if (!(index < (uint32_t)m_streamMarkers.size())) {
+        return uint32_t(-1);
+    }
+    m_streamMarkers[index] = streamOffset;
+    return index;
+}
+
+uint32_t VulkanBitstreamBufferHost::GetStreamMarker(uint32_t index) const
+{
+    assert(index < (uint32_t)m_streamMarkers.size());
+    return m_streamMarkers[index];
+}
+
+uint32_t VulkanBitstreamBufferHost::GetStreamMarkersCount() const
+{
+    return (uint32_t)m_streamMarkers.size();
+}
+
+const uint32_t* VulkanBitstreamBufferHost::GetStreamMarkersPtr(uint32_t startIndex, uint32_t& maxCount) const
+{
+    maxCount = (uint32_t)m_streamMarkers.size() - startIndex;
+    return m_streamMarkers.data() + startIndex;
+}
+
+uint32_t VulkanBitstreamBufferHost::ResetStreamMarkers()
+{
+    uint32_t oldSize = (uint32_t)m_streamMarkers.size();
+    m_streamMarkers.clear();
+    return oldSize;
+}
@@ -0,0 +1,117 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _VULKANBITSTREAMBUFFERHOST_H_
+#define _VULKANBITSTREAMBUFFERHOST_H_
+
+#include <atomic>
+#include <vector>
+#include "VkCodecUtils/VulkanBitstreamBuffer.h"
+
+// System memory implementation of the VulkanBitstreamBuffer interface.
+// Used by clients of the parser that never submit the bitstream to a
+// Vulkan device (stream analysis, parser benchmarking), so it does not
+// require a VulkanDeviceContext. GetBuffer() and GetDeviceMemory() return
+// VK_NULL_HANDLE and Flush/Invalidate are no-ops.
+class VulkanBitstreamBufferHost : public VulkanBitstreamBuffer
+{
+public:
+
+    static VkResult Create(VkDeviceSize bufferSize, VkDeviceSize bufferOffsetAlignment, VkDeviceSize bufferSizeAlignment,
+                           const void* pInitializeBufferMemory, VkDeviceSize initializeBufferMemorySize,
+                           VkSharedBaseObj<VulkanBitstreamBufferHost>& vulkanBitstreamBuffer);
+
+    virtual int32_t AddRef()
+    {
+        return ++m_refCount;
+    }
+
+    virtual int32_t Release()
+    {
+        uint32_t ret = --m_refCount;
+        // Destroy the buffer if ref-count reaches zero
+        if (ret == 0) {
+            delete this;
+        }
+        return ret;
+    }
+
+    virtual int32_t GetRefCount()
+    {
+        assert(m_refCount > 0);
+        return m_refCount;
+    }
+
+    virtual VkDeviceSize GetMaxSize() const { return m_bufferSize; }
+    virtual VkDeviceSize GetOffsetAlignment() const { return m_bufferOffsetAlignment; }
+    virtual VkDeviceSize GetSizeAlignment() const { return m_bufferSizeAlignment; }
+    virtual VkDeviceSize Resize(VkDeviceSize newSize, VkDeviceSize copySize = 0, VkDeviceSize copyOffset = 0);
+    virtual VkDeviceSize Clone(VkDeviceSize newSize, VkDeviceSize copySize, VkDeviceSize copyOffset,
+                               VkSharedBaseObj<VulkanBitstreamBuffer>& vulkanBitstreamBuffer);
+
+    virtual int64_t  MemsetData(uint32_t value, VkDeviceSize offset, VkDeviceSize size);
+    virtual int64_t  CopyDataToBuffer(uint8_t *dstBuffer, VkDeviceSize dstOffset,
+                                      VkDeviceSize srcOffset, VkDeviceSize size) const;
+    virtual int64_t  CopyDataToBuffer(VkSharedBaseObj<VulkanBitstreamBuffer>& dstBuffer, VkDeviceSize dstOffset,
+                                      VkDeviceSize srcOffset, VkDeviceSize size) const;
+    virtual int64_t  CopyDataFromBuffer(const uint8_t *sourceBuffer, VkDeviceSize srcOffset,
+                                        VkDeviceSize dstOffset, VkDeviceSize size);
+    virtual int64_t  CopyDataFromBuffer(const VkSharedBaseObj<VulkanBitstreamBuffer>& sourceBuffer, VkDeviceSize srcOffset,
+                                        VkDeviceSize dstOffset, VkDeviceSize size);
+    virtual uint8_t* GetDataPtr(VkDeviceSize offset, VkDeviceSize &maxSize);
+    virtual const uint8_t* GetReadOnlyDataPtr(VkDeviceSize offset, VkDeviceSize &maxSize) const;
+
+    virtual void FlushRange(VkDeviceSize, VkDeviceSize) const { }
+    virtual void InvalidateRange(VkDeviceSize, VkDeviceSize) const { }
+
+    virtual VkBuffer GetBuffer() const { return VK_NULL_HANDLE; }
+    virtual VkDeviceMemory GetDeviceMemory() const { return VK_NULL_HANDLE; }
+
+    virtual uint32_t  AddStreamMarker(uint32_t streamOffset);
+    virtual uint32_t  SetStreamMarker(uint32_t streamOffset, uint32_t index);
+    virtual uint32_t  GetStreamMarker(uint32_t index) const;
+    virtual uint32_t  GetStreamMarkersCount() const;
+    virtual const uint32_t* GetStreamMarkersPtr(uint32_t startIndex, uint32_t& maxCount) const;
+    virtual uint32_t  ResetStreamMarkers();
+
+private:
+
+    uint8_t* CheckAccess(VkDeviceSize offset, VkDeviceSize size) const;
+
+    VkResult Initialize(VkDeviceSize bufferSize, const void* pInitializeBufferMemory, VkDeviceSize initializeBufferMemorySize);
+
+    VulkanBitstreamBufferHost(VkDeviceSize bufferOffsetAlignment,
+                              VkDeviceSize bufferSizeAlignment)
+        : VulkanBitstreamBuffer()
+        , m_refCount(0)
+        , m_bufferOffsetAlignment(bufferOffsetAlignment ? bufferOffsetAlignment : 1)
+        , m_bufferSizeAlignment(bufferSizeAlignment ? bufferSizeAlignment : 1)
+        , m_bufferSize(0)
+        , m_data()
+        , m_streamMarkers() { }
+
+    virtual ~VulkanBitstreamBufferHost() { }
+
+private:
+    std::atomic<int32_t>   m_refCount;
+    const VkDeviceSize     m_bufferOffsetAlignment;
+    const VkDeviceSize     m_bufferSizeAlignment;
+    VkDeviceSize           m_bufferSize;
+    std::vector<uint8_t>   m_data;
+    std::vector<uint32_t>  m_streamMarkers;
+};
+
+#endif /* _VULKANBITSTREAMBUFFERHOST_H_ */
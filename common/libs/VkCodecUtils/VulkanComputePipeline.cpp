@@ -16,7 +16,10 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 #include "VulkanComputePipeline.h"
+#include "VkCodecUtils/VulkanShaderCache.h"
+#include "VkCodecUtils/VkVideoTracer.h"
 
 // Create Graphics Pipeline
 VkResult VulkanComputePipeline::CreatePipeline(const VulkanDeviceContext* vkDevCtx,
@@ -25,17 +28,22 @@ VkResult VulkanComputePipeline::CreatePipeline(const VulkanDeviceContext* vkDevC
                                                const char* pEntryName, // "main"
                                                uint32_t workgroupSizeX, // usually 16
                                                uint32_t workgroupSizeY, // usually 16
-                                               const VulkanDescriptorSetLayout* pDescriptorSetLayout)
+                                               const VulkanDescriptorSetLayout* pDescriptorSetLayout,
+                                               const uint32_t* pSpirvCode,
+                                               size_t spirvCodeSize)
 {
     m_vkDevCtx = vkDevCtx;
 
     if (m_pipelineCache == VkPipelineCache(0)) {
-        // Create the pipeline cache
+        // Create the pipeline cache, seeded from the on-disk cache when enabled
+        std::vector<uint8_t> initialData;
+        VulkanShaderCache::LoadPipelineCacheData(m_vkDevCtx, initialData);
+
         VkPipelineCacheCreateInfo pipelineCacheInfo = VkPipelineCacheCreateInfo();
         pipelineCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
         pipelineCacheInfo.pNext = nullptr;
-        pipelineCacheInfo.initialDataSize = 0;
-        pipelineCacheInfo.pInitialData = nullptr;
+        pipelineCacheInfo.initialDataSize = initialData.size();
+        pipelineCacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
         pipelineCacheInfo.flags = 0;  // reserved, must be 0
         VkResult result = m_vkDevCtx->CreatePipelineCache(*m_vkDevCtx, &pipelineCacheInfo, nullptr, &m_pipelineCache);
         if (result != VK_SUCCESS) {
@@ -45,13 +53,20 @@ VkResult VulkanComputePipeline::CreatePipeline(const VulkanDeviceContext* vkDevC
 
     const bool verbose = false;
 
-    if (verbose) printf("\nCompute shader code:\n %s", shaderCode);
-
     DestroyShaderModule();
-    m_shaderModule = shaderCompiler.BuildGlslShader(shaderCode,
-                                                    shaderSize,
-                                                    VK_SHADER_STAGE_COMPUTE_BIT,
-                                                    m_vkDevCtx);
+    if (pSpirvCode != nullptr) {
+        m_shaderModule = shaderCompiler.BuildSpirvShader(pSpirvCode, spirvCodeSize, m_vkDevCtx);
+    } else {
+        if (verbose) printf("\nCompute shader code:\n %s", shaderCode);
+
+        m_shaderModule = shaderCompiler.BuildGlslShader(shaderCode,
+                                                        shaderSize,
+                                                        VK_SHADER_STAGE_COMPUTE_BIT,
+                                                        m_vkDevCtx);
+    }
+    if (m_shaderModule == VK_NULL_HANDLE) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
 
     // Create the pipeline
     VkComputePipelineCreateInfo computePipelineCreateInfo {};
@@ -81,6 +96,7 @@ VkResult VulkanComputePipeline::CreatePipeline(const VulkanDeviceContext* vkDevC
 
     // Make sure we destroy the existing pipeline, if it were to exist.
     DestroyPipeline();
+    VK_VIDEO_TRACE_SCOPE("init", "CreateComputePipelines", -1);
     VkResult pipelineResult = m_vkDevCtx->CreateComputePipelines(*m_vkDevCtx, m_pipelineCache, 1,
                                                                   &computePipelineCreateInfo,
                                                                   nullptr, &m_pipeline);
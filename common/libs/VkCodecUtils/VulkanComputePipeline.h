@@ -21,6 +21,7 @@
 #include "VkCodecUtils/VulkanDeviceContext.h"
 #include "VkCodecUtils/VulkanDescriptorSetLayout.h"
 #include "VkCodecUtils/VulkanShaderCompiler.h"
+#include "VkCodecUtils/VulkanShaderCache.h"
 
 class VulkanComputePipeline
 {
@@ -64,6 +65,7 @@ public:
     void DestroyPipelineCache()
     {
         if (m_pipelineCache) {
+            VulkanShaderCache::StorePipelineCache(m_vkDevCtx, m_pipelineCache);
             m_vkDevCtx->DestroyPipelineCache(*m_vkDevCtx, m_pipelineCache, nullptr);
             m_pipelineCache = VkPipelineCache(0);
         }
@@ -79,13 +81,16 @@ public:
 
 
     // Create Compute Pipeline
+    // When pSpirvCode is set, the shader module is created from it and the GLSL source is not used.
     VkResult CreatePipeline(const VulkanDeviceContext* vkDevCtx,
                             VulkanShaderCompiler& shaderCompiler,
                             const char* shaderCode, size_t shaderSize,
                             const char* pEntryName,
                             uint32_t workgroupSizeX, // usually 16
                             uint32_t workgroupSizeY, // usually 16
-                            const VulkanDescriptorSetLayout* pBufferDescriptorSets);
+                            const VulkanDescriptorSetLayout* pBufferDescriptorSets,
+                            const uint32_t* pSpirvCode = nullptr,
+                            size_t spirvCodeSize = 0);
 
     VkPipeline getPipeline() {
         return m_pipeline;
@@ -30,6 +30,7 @@
 #include <algorithm>    // std::find_if
 #include "VkCodecUtils/Helpers.h"
 #include "VkCodecUtils/VulkanDeviceContext.h"
+#include "VkCodecUtils/VulkanVideoQueueScheduler.h"
 
 #if !defined(VK_USE_PLATFORM_WIN32_KHR)
 PFN_vkGetInstanceProcAddr VulkanDeviceContext::LoadVk(VulkanLibraryHandleType &vulkanLibHandle,
@@ -707,14 +708,20 @@ VkResult VulkanDeviceContext::CreateVulkanDevice(int32_t numDecodeQueues,
                                                                                      nullptr,
                                                                              false};
 
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+                                                                          &videoMaintenance1Features,
+                                                                          false // timelineSemaphore
+                                                                         };
+
     VkPhysicalDeviceSynchronization2Features synchronization2Features { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES,
-                                                                        &videoMaintenance1Features,
+                                                                        &timelineSemaphoreFeatures,
                                                                         false
                                                                        };
 
     VkPhysicalDeviceFeatures2 deviceFeatures { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &synchronization2Features};
     GetPhysicalDeviceFeatures2(m_physDevice, &deviceFeatures);
     devInfo.pNext = &deviceFeatures;
+    m_timelineSemaphoreSupport = (timelineSemaphoreFeatures.timelineSemaphore != VK_FALSE);
 
     if ((numDecodeQueues > 0) &&
             (m_videoDecodeQueueFamily != -1) &&
@@ -805,6 +812,21 @@ VkResult VulkanDeviceContext::CreateVulkanDevice(int32_t numDecodeQueues,
         }
     }
 
+    // Spread the submissions of all the streams over the video queues by their outstanding work.
+    if (m_timelineSemaphoreSupport && (numDecodeQueues > 1)) {
+        m_videoDecodeQueueScheduler.reset(new VulkanVideoQueueScheduler(this, DECODE));
+        if (m_videoDecodeQueueScheduler->Init(numDecodeQueues) != VK_SUCCESS) {
+            m_videoDecodeQueueScheduler.reset();
+        }
+    }
+
+    if (m_timelineSemaphoreSupport && (numEncodeQueues > 1)) {
+        m_videoEncodeQueueScheduler.reset(new VulkanVideoQueueScheduler(this, ENCODE));
+        if (m_videoEncodeQueueScheduler->Init(numEncodeQueues) != VK_SUCCESS) {
+            m_videoEncodeQueueScheduler.reset();
+        }
+    }
+
     return result;
 }
 
@@ -828,6 +850,7 @@ VulkanDeviceContext::VulkanDeviceContext()
     , m_videoEncodeQueueFlags(0)
     , m_videoDecodeQueryResultStatusSupport(false)
     , m_videoEncodeQueryResultStatusSupport(false)
+    , m_timelineSemaphoreSupport(false)
     , m_device()
     , m_gfxQueue()
     , m_computeQueue()
@@ -850,6 +873,10 @@ void VulkanDeviceContext::DeviceWaitIdle() const
 
 VulkanDeviceContext::~VulkanDeviceContext() {
 
+    // The schedulers own semaphores of the device.
+    m_videoDecodeQueueScheduler.reset();
+    m_videoEncodeQueueScheduler.reset();
+
     if (m_device) {
         if (!m_isExternallyManagedDevice) {
             DestroyDevice(m_device, nullptr);
@@ -21,10 +21,13 @@
 #include <vector>
 #include <array>
 #include <mutex>
+#include <memory>
 #include <vulkan_interfaces.h>
 #include <VkCodecUtils/HelpersDispatchTable.h>
 #include "VkShell/VkWsiDisplay.h"
 
+class VulkanVideoQueueScheduler;
+
 class VulkanDeviceContext : public vk::VkInterfaceFunctions {
 
 public:
@@ -93,6 +96,19 @@ public:
     bool    GetVideoEncodeQueryResultStatusSupport() const { return m_videoEncodeQueryResultStatusSupport; }
     VkQueueFlags GetVideoDecodeQueueFlag() const { return m_videoDecodeQueueFlags; }
     VkQueueFlags GetVideoEncodeQueueFlag() const { return m_videoEncodeQueueFlags; }
+    bool    GetTimelineSemaphoreSupport() const { return m_timelineSemaphoreSupport; }
+    // The device wide scheduler of the DECODE or ENCODE queues. Only created
+    // for more than one queue, when the device supports timeline semaphores.
+    VulkanVideoQueueScheduler* GetVideoQueueScheduler(const QueueFamilySubmitType submitType) const {
+        switch (submitType) {
+        case DECODE:
+            return m_videoDecodeQueueScheduler.get();
+        case ENCODE:
+            return m_videoEncodeQueueScheduler.get();
+        default:
+            return nullptr;
+        }
+    }
     class MtQueueMutex {
 
     public:
@@ -291,6 +307,7 @@ private:
     VkQueueFlags m_videoEncodeQueueFlags;
     uint32_t m_videoDecodeQueryResultStatusSupport : 1;
     uint32_t m_videoEncodeQueryResultStatusSupport : 1;
+    uint32_t m_timelineSemaphoreSupport : 1;
     VkDevice                m_device;
     VkQueue                 m_gfxQueue;
     VkQueue                 m_computeQueue;
@@ -304,6 +321,8 @@ private:
     mutable std::mutex                                  m_presentQueueMutex;
     mutable std::array<std::mutex, MAX_QUEUE_INSTANCES> m_videoDecodeQueueMutexes;
     mutable std::array<std::mutex, MAX_QUEUE_INSTANCES> m_videoEncodeQueueMutexes;
+    std::unique_ptr<VulkanVideoQueueScheduler>          m_videoDecodeQueueScheduler;
+    std::unique_ptr<VulkanVideoQueueScheduler>          m_videoEncodeQueueScheduler;
     bool m_isExternallyManagedDevice;
     VkDebugReportCallbackEXT           m_debugReport;
     std::vector<const char *>          m_reqInstanceLayers;
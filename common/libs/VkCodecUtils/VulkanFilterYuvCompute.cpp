@@ -17,6 +17,13 @@
 
 #include "VulkanFilterYuvCompute.h"
 #include "nvidia_utils/vulkan/ycbcrvkinfo.h"
+#include "VkCodecUtils/VulkanFilterYuvComputeShaders.h"
+
+static_assert(((int)VulkanFilterYuvCompute::YCBCRCOPY == (int)VulkanFilterYuvComputeShaders::YCBCRCOPY) &&
+              ((int)VulkanFilterYuvCompute::YCBCRCLEAR == (int)VulkanFilterYuvComputeShaders::YCBCRCLEAR) &&
+              ((int)VulkanFilterYuvCompute::YCBCR2RGBA == (int)VulkanFilterYuvComputeShaders::YCBCR2RGBA) &&
+              ((int)VulkanFilterYuvCompute::RGBA2YCBCR == (int)VulkanFilterYuvComputeShaders::RGBA2YCBCR),
+              "The filter types must match the precompiled shader variants");
 
 VkResult VulkanFilterYuvCompute::Create(const VulkanDeviceContext* vkDevCtx,
                                         uint32_t queueFamilyIndex,
@@ -83,18 +90,45 @@ VkResult VulkanFilterYuvCompute::Init(const VkSamplerYcbcrConversionCreateInfo*
         return result;
     }
 
-    std::string computeShader;
-    size_t computeShaderSize = 0;
+    VulkanFilterYuvComputeShaders::Variant variant = VulkanFilterYuvComputeShaders::Variant();
+    variant.filterType = (VulkanFilterYuvComputeShaders::FilterType)m_filterType;
     switch (m_filterType) {
      case YCBCRCOPY:
-         computeShaderSize = InitYCBCRCOPY(computeShader);
+         // The compute filter uses two input images as separate planes
+         // Y (R) binding = 1
+         // CbCr (RG) binding = 2
+         // TODO: Add more YCbCr formats
+         m_inputImageAspects = VK_IMAGE_ASPECT_PLANE_0_BIT | VK_IMAGE_ASPECT_PLANE_1_BIT;
+         // The compute filter uses two output images as separate planes
+         // Y (R) binding = 5
+         // CbCr (RG) binding = 6
+         m_outputImageAspects = VK_IMAGE_ASPECT_PLANE_0_BIT | VK_IMAGE_ASPECT_PLANE_1_BIT;
          break;
      case YCBCRCLEAR:
-         computeShaderSize = InitYCBCRCLEAR(computeShader);
+         // The compute filter uses NO input images
+         m_inputImageAspects = VK_IMAGE_ASPECT_NONE;
+         // The compute filter uses two output images as separate planes
+         // Y (R) binding = 5
+         // CbCr (RG) binding = 6
+         m_outputImageAspects = VK_IMAGE_ASPECT_PLANE_0_BIT | VK_IMAGE_ASPECT_PLANE_1_BIT;
          break;
      case YCBCR2RGBA:
-         computeShaderSize = InitYCBCR2RGBA(computeShader);
+     {
+         // The compute filter uses two input images as separate planes
+         // Y (R) binding = 1
+         // CbCr (RG) binding = 2
+         // TODO: Add more YCbCr formats
+         m_inputImageAspects = VK_IMAGE_ASPECT_PLANE_0_BIT | VK_IMAGE_ASPECT_PLANE_1_BIT;
+         // The compute filter uses RGBA output image with binding = 4
+         m_outputImageAspects = VK_IMAGE_ASPECT_COLOR_BIT;
+
+         const VkSamplerYcbcrConversionCreateInfo& samplerYcbcrConversionCreateInfo = m_samplerYcbcrConversion.GetSamplerYcbcrConversionCreateInfo();
+         const VkMpFormatInfo * mpInfo = YcbcrVkFormatInfo(samplerYcbcrConversionCreateInfo.format);
+         variant.bitDepth = (8 + mpInfo->planesLayout.bpp * 2);
+         variant.ycbcrModel = samplerYcbcrConversionCreateInfo.ycbcrModel;
+         variant.ycbcrRange = samplerYcbcrConversionCreateInfo.ycbcrRange;
          break;
+     }
      case RGBA2YCBCR:
          assert(!"TODO RGBA2YCBCR");
          break;
@@ -103,13 +137,28 @@ VkResult VulkanFilterYuvCompute::Init(const VkSamplerYcbcrConversionCreateInfo*
          break;
     }
 
+    // Use the SPIR-V compiled at build time when available, so that creating
+    // a filter on a format change does not need the GLSL compiler.
+    const uint32_t* pSpirvCode = nullptr;
+    size_t spirvCodeSize = 0;
+    if (VulkanFilterYuvComputeShaders::GetPrecompiledSpirv(variant, &pSpirvCode, &spirvCodeSize)) {
+        return m_computePipeline.CreatePipeline(m_vkDevCtx, m_vulkanShaderCompiler,
+                                                nullptr, 0,
+                                                "main",
+                                                m_workgroupSizeX, m_workgroupSizeY,
+                                                &m_descriptorSetLayout,
+                                                pSpirvCode, spirvCodeSize);
+    }
+
+    std::string computeShader;
+    const size_t computeShaderSize = VulkanFilterYuvComputeShaders::GenerateShader(variant, computeShader);
+    std::cout << "\nCompute Shader:\n" << computeShader;
+
     return m_computePipeline.CreatePipeline(m_vkDevCtx, m_vulkanShaderCompiler,
                                             computeShader.c_str(), computeShaderSize,
                                             "main",
                                             m_workgroupSizeX, m_workgroupSizeY,
                                             &m_descriptorSetLayout);
-
-    return VK_ERROR_LAYER_NOT_PRESENT;
 }
 
 VkResult VulkanFilterYuvCompute::InitDescriptorSetLayout(uint32_t maxNumFrames)
@@ -157,229 +206,3 @@ VkResult VulkanFilterYuvCompute::InitDescriptorSetLayout(uint32_t maxNumFrames)
                                                      maxNumFrames,
                                                      false);
 }
-
-static YcbcrBtStandard GetYcbcrPrimariesConstantsId(VkSamplerYcbcrModelConversion modelConversion)
-{
-    switch (modelConversion) {
-    case VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_709:
-        return YcbcrBtStandardBt709;
-    case VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_601:
-        return YcbcrBtStandardBt601Ebu;
-    case VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_2020:
-        return YcbcrBtStandardBt709;
-    default:
-        ;// assert(0);
-    }
-
-    return YcbcrBtStandardUnknown;
-}
-
-size_t VulkanFilterYuvCompute::InitYCBCR2RGBA(std::string& computeShader)
-{
-    // The compute filter uses two input images as separate planes
-    // Y (R) binding = 1
-    // CbCr (RG) binding = 2
-    // TODO: Add more YCbCr formats
-    m_inputImageAspects = VK_IMAGE_ASPECT_PLANE_0_BIT | VK_IMAGE_ASPECT_PLANE_1_BIT;
-
-    // The compute filter uses RGBA output image with binding = 4
-    m_outputImageAspects = VK_IMAGE_ASPECT_COLOR_BIT;
-
-    // Create compute pipeline
-    std::stringstream shaderStr;
-    shaderStr << "#version 450\n"
-                        "layout(push_constant) uniform PushConstants {\n"
-                        "    uint srcImageLayer;\n"
-                        "    uint dstImageLayer;\n"
-                        "} pushConstants;\n"
-                        "\n"
-                        "layout (local_size_x = 16, local_size_y = 16) in;\n"
-                        " // TODO: use set and binding from the layout\n"
-                        " // TODO: use r16 for 16-bit formats\n"
-                        "layout (set = 0, binding = 1, r8) uniform readonly image2DArray inputImageY;\n"
-                        " // TODO: use rg16 for 16-bit formats\n"
-                        "layout (set = 0, binding = 2, rg8) uniform readonly image2DArray inputImageCbCr;\n"
-                        " // TODO: use rgba16 for 16-bit formats\n"
-                        "layout (set = 0, binding = 4, rgba8) uniform writeonly image2DArray outImage;\n"
-                        "\n"
-                        " // TODO: normalize only narrow\n"
-                        "float normalizeY(float Y) {\n"
-                            "//    return (Y - (16.0 / 255.0)) * (255.0 / (235.0 - 16.0));\n"
-                            "return (Y - 0.0627451) * 1.164383562;\n"
-                        "}\n"
-                        "\n"
-                        "vec2 shiftCbCr(vec2 CbCr) {\n"
-                        "    return CbCr - 0.5;\n"
-                        "}\n"
-                        "\n"
-                        "vec3 shiftCbCr(vec3 ycbcr) {\n"
-                        "    const vec3 shiftCbCr  = vec3(0.0, -0.5, -0.5);\n"
-                        "    return ycbcr + shiftCbCr;\n"
-                        "}\n"
-                        "\n"
-                        " // TODO: normalize only narrow\n"
-                        "vec2 normalizeCbCr(vec2 CbCr) {\n"
-                        "    // return (CbCr - (16.0 / 255.0)) / ((240.0 - 16.0) / 255.0);\n"
-                        "    return (CbCr - 0.0627451) * 1.138392857;\n"
-                        "}\n"
-                        "\n";
-
-
-    const VkSamplerYcbcrConversionCreateInfo& samplerYcbcrConversionCreateInfo = m_samplerYcbcrConversion.GetSamplerYcbcrConversionCreateInfo();
-    const VkMpFormatInfo * mpInfo = YcbcrVkFormatInfo(samplerYcbcrConversionCreateInfo.format);
-    const unsigned int bpp = (8 + mpInfo->planesLayout.bpp * 2);
-
-    const YcbcrBtStandard btStandard = GetYcbcrPrimariesConstantsId(samplerYcbcrConversionCreateInfo.ycbcrModel);
-    const YcbcrPrimariesConstants primariesConstants = GetYcbcrPrimariesConstants(btStandard);
-    const YcbcrRangeConstants rangeConstants = GetYcbcrRangeConstants(YcbcrLevelsDigital);
-    const YcbcrBtMatrix yCbCrMatrix(primariesConstants.kb,
-                                    primariesConstants.kr,
-                                    rangeConstants.cbMax,
-                                    rangeConstants.crMax);
-
-
-    shaderStr <<
-        "vec3 convertYCbCrToRgb(vec3 yuv) {\n"
-        "    vec3 rgb;\n";
-    yCbCrMatrix.ConvertYCbCrToRgbString(shaderStr);
-    shaderStr <<
-        "    return rgb;\n"
-        "}\n"
-        "\n";
-
-
-    YcbcrNormalizeColorRange yCbCrNormalizeColorRange(bpp,
-            (samplerYcbcrConversionCreateInfo.ycbcrModel == VK_SAMPLER_YCBCR_MODEL_CONVERSION_RGB_IDENTITY) ?
-                    YCBCR_COLOR_RANGE_NATURAL : (YCBCR_COLOR_RANGE)samplerYcbcrConversionCreateInfo.ycbcrRange);
-    shaderStr <<
-        "vec3 normalizeYCbCr(vec3 yuv) {\n"
-        "    vec3 yuvNorm;\n";
-    yCbCrNormalizeColorRange.NormalizeYCbCrString(shaderStr);
-    shaderStr <<
-        "    return yuvNorm;\n"
-        "}\n"
-        "\n";
-
-    shaderStr <<
-        "void main()\n"
-        "{\n"
-        "    ivec2 pos = ivec2(gl_GlobalInvocationID.xy);\n"
-        "\n"
-        "    // Fetch from the texture.\n"
-        "    float Y = imageLoad(inputImageY, ivec3(pos, pushConstants.srcImageLayer)).r;\n"
-        "    // TODO: it is /2 only for sub-sampled formats\n"
-        "    vec2 CbCr = imageLoad(inputImageCbCr, ivec3(pos/2, pushConstants.srcImageLayer)).rg;\n"
-        "\n"
-        "    vec3 ycbcr = shiftCbCr(normalizeYCbCr(vec3(Y, CbCr)));\n"
-        "    vec4 rgba = vec4(convertYCbCrToRgb(ycbcr),1.0);\n"
-        "    // Store it back.\n"
-        "    imageStore(outImage, ivec3(pos, pushConstants.dstImageLayer), rgba);\n"
-        "}\n";
-
-    computeShader = shaderStr.str();
-    std::cout << "\nCompute Shader:\n" << computeShader;
-    return computeShader.size();
-}
-
-size_t VulkanFilterYuvCompute::InitYCBCRCOPY(std::string& computeShader)
-{
-    // The compute filter uses two input images as separate planes
-    // Y (R) binding = 1
-    // CbCr (RG) binding = 2
-    // TODO: Add more YCbCr formats
-    m_inputImageAspects = VK_IMAGE_ASPECT_PLANE_0_BIT | VK_IMAGE_ASPECT_PLANE_1_BIT;
-
-    // The compute filter uses two output images as separate planes
-    // Y (R) binding = 5
-    // CbCr (RG) binding = 6
-    // TODO: Add more YCbCr formats
-    m_outputImageAspects = VK_IMAGE_ASPECT_PLANE_0_BIT | VK_IMAGE_ASPECT_PLANE_1_BIT;
-
-    std::stringstream shaderStr;
-    // Create compute pipeline
-    shaderStr << "#version 450\n"
-                        "layout(push_constant) uniform PushConstants {\n"
-                        "    uint srcImageLayer;\n"
-                        "    uint dstImageLayer;\n"
-                        "} pushConstants;\n"
-                        "\n"
-                        "layout (local_size_x = 16, local_size_y = 16) in;\n"
-                        " // TODO: use set and binding from the layout\n"
-                        " // TODO: use r16 for 16-bit formats\n"
-                        "layout (set = 0, binding = 1, r8) uniform  readonly  image2DArray inputImageY;\n"
-                        " // TODO: use rg16 for 16-bit formats\n"
-                        "layout (set = 0, binding = 2, rg8) uniform readonly  image2DArray inputImageCbCr;\n"
-                        " // TODO: use rgba16 for 16-bit formats\n"
-                        "layout (set = 0, binding = 5, r8) uniform  writeonly image2DArray outImageY;\n"
-                        " // TODO: use rg16 for 16-bit formats\n"
-                        "layout (set = 0, binding = 6, rg8) uniform writeonly image2DArray outImageCbCr;\n"
-                        "\n"
-                        "\n";
-
-    shaderStr <<
-        "void main()\n"
-        "{\n"
-        "    ivec2 pos = ivec2(gl_GlobalInvocationID.xy);\n"
-        "\n"
-        "    // Read Y value from source Y plane and write it to destination Y plane\n"
-        "    float Y = imageLoad(inputImageY, ivec3(pos, pushConstants.srcImageLayer)).r;\n"
-        "    imageStore(outImageY, ivec3(pos, pushConstants.dstImageLayer), vec4(Y, 0, 0, 1));\n"
-        "\n"
-        "    // Do the same for the CbCr plane, but remember about the 4:2:0 subsampling\n"
-        "    if (pos % 2 == ivec2(0, 0)) {\n"
-        "        pos /= 2;\n"
-        "        vec2 CbCr = imageLoad(inputImageCbCr, ivec3(pos, pushConstants.srcImageLayer)).rg;\n"
-        "        imageStore(outImageCbCr, ivec3(pos, pushConstants.dstImageLayer), vec4(CbCr, 0, 1));\n"
-        "    }\n"
-        "}\n";
-
-    computeShader = shaderStr.str();
-    std::cout << "\nCompute Shader:\n" << computeShader;
-    return computeShader.size();
-}
-
-size_t VulkanFilterYuvCompute::InitYCBCRCLEAR(std::string& computeShader)
-{
-    // The compute filter uses NO input images
-    m_inputImageAspects = VK_IMAGE_ASPECT_NONE;
-
-    // The compute filter uses two output images as separate planes
-    // Y (R) binding = 5
-    // CbCr (RG) binding = 6
-    // TODO: Add more YCbCr formats
-    m_outputImageAspects = VK_IMAGE_ASPECT_PLANE_0_BIT | VK_IMAGE_ASPECT_PLANE_1_BIT;
-
-    // Create compute pipeline
-    std::stringstream shaderStr;
-    shaderStr << "#version 450\n"
-                        "layout(push_constant) uniform PushConstants {\n"
-                        "    uint srcImageLayer;\n"
-                        "    uint dstImageLayer;\n"
-                        "} pushConstants;\n"
-                        "\n"
-                        "layout (local_size_x = 16, local_size_y = 16) in;\n"
-                        " // TODO: use rgba16 for 16-bit formats\n"
-                        "layout (set = 0, binding = 5, r8) uniform writeonly image2DArray outImageY;\n"
-                        " // TODO: use rg16 for 16-bit formats\n"
-                        "layout (set = 0, binding = 6, rg8) uniform writeonly image2DArray outImageCbCr;\n"
-                        "\n"
-                        "\n";
-
-    shaderStr <<
-        "void main()\n"
-        "{\n"
-        "    ivec2 pos = ivec2(gl_GlobalInvocationID.xy);\n"
-        "\n"
-        "    imageStore(outImageY, ivec3(pos, pushConstants.dstImageLayer), vec4(0.5, 0, 0, 1));\n"
-        "\n"
-        "    // Do the same for the CbCr plane, but remember about the 4:2:0 subsampling\n"
-        "    if (pos % 2 == ivec2(0, 0)) {\n"
-        "        pos /= 2;\n"
-        "        imageStore(outImageCbCr, ivec3(pos, pushConstants.dstImageLayer), vec4(0.5, 0.5, 0.0, 1.0));\n"
-        "    }\n"
-        "}\n";
-
-    computeShader = shaderStr.str();
-    std::cout << "\nCompute Shader:\n" << computeShader;
-    return computeShader.size();
-}
@@ -316,9 +316,6 @@ public:
 
 private:
     VkResult InitDescriptorSetLayout(uint32_t maxNumFrames);
-    size_t InitYCBCRCOPY(std::string& computeShader);
-    size_t InitYCBCRCLEAR(std::string& computeShader);
-    size_t InitYCBCR2RGBA(std::string& computeShader);
 
 private:
     const FilterType                         m_filterType;
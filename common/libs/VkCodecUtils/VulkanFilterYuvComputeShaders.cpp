@@ -0,0 +1,322 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sstream>
+#include "VkCodecUtils/VulkanFilterYuvComputeShaders.h"
+#include "nvidia_utils/vulkan/ycbcr_utils.h"
+
+#if defined(VK_VIDEO_PRECOMPILED_FILTER_SHADERS)
+struct PrecompiledFilterShader {
+    VulkanFilterYuvComputeShaders::FilterType filterType;
+    uint32_t                                  bitDepth;
+    VkSamplerYcbcrModelConversion             ycbcrModel;
+    VkSamplerYcbcrRange                       ycbcrRange;
+    const uint32_t*                           pCode;
+    size_t                                    codeSize;
+};
+// Generated by vk-video-filter-shader-gen, defines precompiledFilterShaders[].
+#include "VulkanFilterYuvComputeSpirv.h"
+#endif
+
+static YcbcrBtStandard GetYcbcrPrimariesConstantsId(VkSamplerYcbcrModelConversion modelConversion)
+{
+    switch (modelConversion) {
+    case VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_709:
+        return YcbcrBtStandardBt709;
+    case VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_601:
+        return YcbcrBtStandardBt601Ebu;
+    case VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_2020:
+        return YcbcrBtStandardBt709;
+    default:
+        ;// assert(0);
+    }
+
+    return YcbcrBtStandardUnknown;
+}
+
+static size_t InitYCBCR2RGBA(const VulkanFilterYuvComputeShaders::Variant& variant, std::string& computeShader)
+{
+    // Create compute pipeline
+    std::stringstream shaderStr;
+    shaderStr << "#version 450\n"
+                        "layout(push_constant) uniform PushConstants {\n"
+                        "    uint srcImageLayer;\n"
+                        "    uint dstImageLayer;\n"
+                        "} pushConstants;\n"
+                        "\n"
+                        "layout (local_size_x = 16, local_size_y = 16) in;\n"
+                        " // TODO: use set and binding from the layout\n"
+                        " // TODO: use r16 for 16-bit formats\n"
+                        "layout (set = 0, binding = 1, r8) uniform readonly image2DArray inputImageY;\n"
+                        " // TODO: use rg16 for 16-bit formats\n"
+                        "layout (set = 0, binding = 2, rg8) uniform readonly image2DArray inputImageCbCr;\n"
+                        " // TODO: use rgba16 for 16-bit formats\n"
+                        "layout (set = 0, binding = 4, rgba8) uniform writeonly image2DArray outImage;\n"
+                        "\n"
+                        " // TODO: normalize only narrow\n"
+                        "float normalizeY(float Y) {\n"
+                            "//    return (Y - (16.0 / 255.0)) * (255.0 / (235.0 - 16.0));\n"
+                            "return (Y - 0.0627451) * 1.164383562;\n"
+                        "}\n"
+                        "\n"
+                        "vec2 shiftCbCr(vec2 CbCr) {\n"
+                        "    return CbCr - 0.5;\n"
+                        "}\n"
+                        "\n"
+                        "vec3 shiftCbCr(vec3 ycbcr) {\n"
+                        "    const vec3 shiftCbCr  = vec3(0.0, -0.5, -0.5);\n"
+                        "    return ycbcr + shiftCbCr;\n"
+                        "}\n"
+                        "\n"
+                        " // TODO: normalize only narrow\n"
+                        "vec2 normalizeCbCr(vec2 CbCr) {\n"
+                        "    // return (CbCr - (16.0 / 255.0)) / ((240.0 - 16.0) / 255.0);\n"
+                        "    return (CbCr - 0.0627451) * 1.138392857;\n"
+                        "}\n"
+                        "\n";
+
+    const YcbcrBtStandard btStandard = GetYcbcrPrimariesConstantsId(variant.ycbcrModel);
+    const YcbcrPrimariesConstants primariesConstants = GetYcbcrPrimariesConstants(btStandard);
+    const YcbcrRangeConstants rangeConstants = GetYcbcrRangeConstants(YcbcrLevelsDigital);
+    const YcbcrBtMatrix yCbCrMatrix(primariesConstants.kb,
+                                    primariesConstants.kr,
+                                    rangeConstants.cbMax,
+                                    rangeConstants.crMax);
+
+    shaderStr <<
+        "vec3 convertYCbCrToRgb(vec3 yuv) {\n"
+        "    vec3 rgb;\n";
+    yCbCrMatrix.ConvertYCbCrToRgbString(shaderStr);
+    shaderStr <<
+        "    return rgb;\n"
+        "}\n"
+        "\n";
+
+    YcbcrNormalizeColorRange yCbCrNormalizeColorRange(variant.bitDepth,
+            (variant.ycbcrModel == VK_SAMPLER_YCBCR_MODEL_CONVERSION_RGB_IDENTITY) ?
+                    YCBCR_COLOR_RANGE_NATURAL : (YCBCR_COLOR_RANGE)variant.ycbcrRange);
+    shaderStr <<
+        "vec3 normalizeYCbCr(vec3 yuv) {\n"
+        "    vec3 yuvNorm;\n";
+    yCbCrNormalizeColorRange.NormalizeYCbCrString(shaderStr);
+    shaderStr <<
+        "    return yuvNorm;\n"
+        "}\n"
+        "\n";
+
+    shaderStr <<
+        "void main()\n"
+        "{\n"
+        "    ivec2 pos = ivec2(gl_GlobalInvocationID.xy);\n"
+        "\n"
+        "    // Fetch from the texture.\n"
+        "    float Y = imageLoad(inputImageY, ivec3(pos, pushConstants.srcImageLayer)).r;\n"
+        "    // TODO: it is /2 only for sub-sampled formats\n"
+        "    vec2 CbCr = imageLoad(inputImageCbCr, ivec3(pos/2, pushConstants.srcImageLayer)).rg;\n"
+        "\n"
+        "    vec3 ycbcr = shiftCbCr(normalizeYCbCr(vec3(Y, CbCr)));\n"
+        "    vec4 rgba = vec4(convertYCbCrToRgb(ycbcr),1.0);\n"
+        "    // Store it back.\n"
+        "    imageStore(outImage, ivec3(pos, pushConstants.dstImageLayer), rgba);\n"
+        "}\n";
+
+    computeShader = shaderStr.str();
+    return computeShader.size();
+}
+
+static size_t InitYCBCRCOPY(std::string& computeShader)
+{
+    std::stringstream shaderStr;
+    // Create compute pipeline
+    shaderStr << "#version 450\n"
+                        "layout(push_constant) uniform PushConstants {\n"
+                        "    uint srcImageLayer;\n"
+                        "    uint dstImageLayer;\n"
+                        "} pushConstants;\n"
+                        "\n"
+                        "layout (local_size_x = 16, local_size_y = 16) in;\n"
+                        " // TODO: use set and binding from the layout\n"
+                        " // TODO: use r16 for 16-bit formats\n"
+                        "layout (set = 0, binding = 1, r8) uniform  readonly  image2DArray inputImageY;\n"
+                        " // TODO: use rg16 for 16-bit formats\n"
+                        "layout (set = 0, binding = 2, rg8) uniform readonly  image2DArray inputImageCbCr;\n"
+                        " // TODO: use rgba16 for 16-bit formats\n"
+                        "layout (set = 0, binding = 5, r8) uniform  writeonly image2DArray outImageY;\n"
+                        " // TODO: use rg16 for 16-bit formats\n"
+                        "layout (set = 0, binding = 6, rg8) uniform writeonly image2DArray outImageCbCr;\n"
+                        "\n"
+                        "\n";
+
+    shaderStr <<
+        "void main()\n"
+        "{\n"
+        "    ivec2 pos = ivec2(gl_GlobalInvocationID.xy);\n"
+        "\n"
+        "    // Read Y value from source Y plane and write it to destination Y plane\n"
+        "    float Y = imageLoad(inputImageY, ivec3(pos, pushConstants.srcImageLayer)).r;\n"
+        "    imageStore(outImageY, ivec3(pos, pushConstants.dstImageLayer), vec4(Y, 0, 0, 1));\n"
+        "\n"
+        "    // Do the same for the CbCr plane, but remember about the 4:2:0 subsampling\n"
+        "    if (pos % 2 == ivec2(0, 0)) {\n"
+        "        pos /= 2;\n"
+        "        vec2 CbCr = imageLoad(inputImageCbCr, ivec3(pos, pushConstants.srcImageLayer)).rg;\n"
+        "        imageStore(outImageCbCr, ivec3(pos, pushConstants.dstImageLayer), vec4(CbCr, 0, 1));\n"
+        "    }\n"
+        "}\n";
+
+    computeShader = shaderStr.str();
+    return computeShader.size();
+}
+
+static size_t InitYCBCRCLEAR(std::string& computeShader)
+{
+    // Create compute pipeline
+    std::stringstream shaderStr;
+    shaderStr << "#version 450\n"
+                        "layout(push_constant) uniform PushConstants {\n"
+                        "    uint srcImageLayer;\n"
+                        "    uint dstImageLayer;\n"
+                        "} pushConstants;\n"
+                        "\n"
+                        "layout (local_size_x = 16, local_size_y = 16) in;\n"
+                        " // TODO: use rgba16 for 16-bit formats\n"
+                        "layout (set = 0, binding = 5, r8) uniform writeonly image2DArray outImageY;\n"
+                        " // TODO: use rg16 for 16-bit formats\n"
+                        "layout (set = 0, binding = 6, rg8) uniform writeonly image2DArray outImageCbCr;\n"
+                        "\n"
+                        "\n";
+
+    shaderStr <<
+        "void main()\n"
+        "{\n"
+        "    ivec2 pos = ivec2(gl_GlobalInvocationID.xy);\n"
+        "\n"
+        "    imageStore(outImageY, ivec3(pos, pushConstants.dstImageLayer), vec4(0.5, 0, 0, 1));\n"
+        "\n"
+        "    // Do the same for the CbCr plane, but remember about the 4:2:0 subsampling\n"
+        "    if (pos % 2 == ivec2(0, 0)) {\n"
+        "        pos /= 2;\n"
+        "        imageStore(outImageCbCr, ivec3(pos, pushConstants.dstImageLayer), vec4(0.5, 0.5, 0.0, 1.0));\n"
+        "    }\n"
+        "}\n";
+
+    computeShader = shaderStr.str();
+    return computeShader.size();
+}
+
+VulkanFilterYuvComputeShaders::Variant VulkanFilterYuvComputeShaders::NormalizeVariant(const Variant& variant)
+{
+    Variant normalized = variant;
+    if (variant.filterType != YCBCR2RGBA) {
+        normalized.bitDepth = 0;
+        normalized.ycbcrModel = VK_SAMPLER_YCBCR_MODEL_CONVERSION_RGB_IDENTITY;
+        normalized.ycbcrRange = VK_SAMPLER_YCBCR_RANGE_ITU_FULL;
+    } else if (variant.ycbcrModel == VK_SAMPLER_YCBCR_MODEL_CONVERSION_RGB_IDENTITY) {
+        // The range is not used, the values are taken as they are.
+        normalized.ycbcrRange = VK_SAMPLER_YCBCR_RANGE_ITU_FULL;
+    }
+    return normalized;
+}
+
+size_t VulkanFilterYuvComputeShaders::GenerateShader(const Variant& variant, std::string& computeShader)
+{
+    switch (variant.filterType) {
+    case YCBCRCOPY:
+        return InitYCBCRCOPY(computeShader);
+    case YCBCRCLEAR:
+        return InitYCBCRCLEAR(computeShader);
+    case YCBCR2RGBA:
+        return InitYCBCR2RGBA(variant, computeShader);
+    default:
+        break;
+    }
+
+    computeShader.clear();
+    return 0;
+}
+
+void VulkanFilterYuvComputeShaders::EnumerateVariants(std::vector<Variant>& variants)
+{
+    static const uint32_t bitDepths[] = { 8, 10, 12, 16 };
+    static const VkSamplerYcbcrModelConversion ycbcrModels[] = {
+        VK_SAMPLER_YCBCR_MODEL_CONVERSION_RGB_IDENTITY,
+        VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_IDENTITY,
+        VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_709,
+        VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_601,
+        VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_2020,
+    };
+    static const VkSamplerYcbcrRange ycbcrRanges[] = {
+        VK_SAMPLER_YCBCR_RANGE_ITU_FULL,
+        VK_SAMPLER_YCBCR_RANGE_ITU_NARROW,
+    };
+
+    variants.clear();
+
+    Variant variant = Variant();
+    variant.filterType = YCBCRCOPY;
+    variants.push_back(NormalizeVariant(variant));
+    variant.filterType = YCBCRCLEAR;
+    variants.push_back(NormalizeVariant(variant));
+
+    variant.filterType = YCBCR2RGBA;
+    for (uint32_t d = 0; d < sizeof(bitDepths) / sizeof(bitDepths[0]); d++) {
+        for (uint32_t m = 0; m < sizeof(ycbcrModels) / sizeof(ycbcrModels[0]); m++) {
+            for (uint32_t r = 0; r < sizeof(ycbcrRanges) / sizeof(ycbcrRanges[0]); r++) {
+                variant.bitDepth = bitDepths[d];
+                variant.ycbcrModel = ycbcrModels[m];
+                variant.ycbcrRange = ycbcrRanges[r];
+                const Variant normalized = NormalizeVariant(variant);
+
+                bool duplicate = false;
+                for (size_t i = 0; i < variants.size(); i++) {
+                    if ((variants[i].filterType == normalized.filterType) &&
+                            (variants[i].bitDepth == normalized.bitDepth) &&
+                            (variants[i].ycbcrModel == normalized.ycbcrModel) &&
+                            (variants[i].ycbcrRange == normalized.ycbcrRange)) {
+                        duplicate = true;
+                        break;
+                    }
+                }
+                if (!duplicate) {
+                    variants.push_back(normalized);
+                }
+            }
+        }
+    }
+}
+
+bool VulkanFilterYuvComputeShaders::GetPrecompiledSpirv(const Variant& variant, const uint32_t** ppCode, size_t* pCodeSize)
+{
+#if defined(VK_VIDEO_PRECOMPILED_FILTER_SHADERS)
+    const Variant normalized = NormalizeVariant(variant);
+    for (size_t i = 0; i < sizeof(precompiledFilterShaders) / sizeof(precompiledFilterShaders[0]); i++) {
+        const PrecompiledFilterShader& entry = precompiledFilterShaders[i];
+        if ((entry.filterType == normalized.filterType) &&
+                (entry.bitDepth == normalized.bitDepth) &&
+                (entry.ycbcrModel == normalized.ycbcrModel) &&
+                (entry.ycbcrRange == normalized.ycbcrRange)) {
+            *ppCode = entry.pCode;
+            *pCodeSize = entry.codeSize;
+            return true;
+        }
+    }
+#else
+    (void)variant;
+#endif
+    *ppCode = nullptr;
+    *pCodeSize = 0;
+    return false;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKCODECUTILS_VULKANFILTERYUVCOMPUTESHADERS_H_
+#define _VKCODECUTILS_VULKANFILTERYUVCOMPUTESHADERS_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "vulkan_interfaces.h"
+
+// GLSL sources of the VulkanFilterYuvCompute filters.
+//
+// The source only depends on the filter type and, for the YCbCr to RGBA
+// conversion, on the bit depth, the YCbCr model and the YCbCr range, so the
+// whole variant space is small enough to be compiled at build time. The
+// build runs vk-video-filter-shader-gen, which compiles every variant with
+// glslangValidator into VulkanFilterYuvComputeSpirv.h, and then defines
+// VK_VIDEO_PRECOMPILED_FILTER_SHADERS. Without it, or for a variant that is
+// not in the table, the filter falls back to compiling the GLSL at runtime.
+//
+// This file has no Vulkan device dependencies so that the generator can be
+// built for the host.
+class VulkanFilterYuvComputeShaders
+{
+public:
+    // Must match VulkanFilterYuvCompute::FilterType.
+    enum FilterType { YCBCRCOPY, YCBCRCLEAR, YCBCR2RGBA, RGBA2YCBCR };
+
+    struct Variant {
+        FilterType                    filterType;
+        uint32_t                      bitDepth;    // 8, 10, 12 or 16
+        VkSamplerYcbcrModelConversion ycbcrModel;
+        VkSamplerYcbcrRange           ycbcrRange;
+    };
+
+    // Clears the fields the shader of the filter type does not depend on,
+    // so that equivalent variants share the same table entry.
+    static Variant NormalizeVariant(const Variant& variant);
+
+    // Returns the size of the source, 0 if the filter type is not supported.
+    static size_t GenerateShader(const Variant& variant, std::string& computeShader);
+
+    // All the normalized variants compiled at build time.
+    static void EnumerateVariants(std::vector<Variant>& variants);
+
+    // Returns false if the variant was not compiled at build time.
+    static bool GetPrecompiledSpirv(const Variant& variant, const uint32_t** ppCode, size_t* pCodeSize);
+};
+
+#endif /* _VKCODECUTILS_VULKANFILTERYUVCOMPUTESHADERS_H_ */
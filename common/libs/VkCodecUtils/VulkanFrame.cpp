@@ -23,6 +23,7 @@
 #include "VkCodecUtils/VulkanDeviceContext.h"
 #include "VkShell/Shell.h"
 #include "VkCodecUtils/VulkanVideoUtils.h"
+#include "VkCodecUtils/VkVideoTracer.h"
 #include "VulkanFrame.h"
 #include "vk_enum_string_helper.h"
 #include "VkVideoCore/DecodeFrameBufferIf.h"
@@ -512,6 +513,7 @@ VkResult VulkanFrame<FrameDataType>::DrawFrame( int32_t            renderIndex,
     VkResult result = VK_SUCCESS;
     if (!m_videoRenderer->m_useTestImage && inFrame) {
         if (inFrame->frameCompleteSemaphore == VkSemaphore()) {
+            VK_VIDEO_TRACE_SCOPE("decode", "WaitDecodeComplete", inFrame->decodeOrder);
             if (inFrame->frameCompleteFence == VkFence()) {
                 VkQueue videoDecodeQueue = m_vkDevCtx->GetVideoDecodeQueue();
                 if (videoDecodeQueue != VkQueue()) {
@@ -0,0 +1,339 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#if defined(_WIN32)
+#include <direct.h>
+#include <process.h>
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#include "VkCodecUtils/VulkanShaderCache.h"
+
+namespace {
+
+const uint32_t SpirvMagic = 0x07230203;
+const uint32_t SpirvCacheMagic = 0x43535656; // "VVSC"
+const uint32_t SpirvCacheVersion = 1;
+
+struct SpirvCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceSize;
+    uint64_t checkHash;
+    uint64_t codeSize;
+};
+
+std::mutex  g_cacheDirLock;
+std::string g_cacheDir;
+
+std::string GetCacheDirectory()
+{
+    std::lock_guard<std::mutex> lock(g_cacheDirLock);
+    return g_cacheDir;
+}
+
+// FNV-1a, the two keys use different offset bases.
+uint64_t HashBytes(const void* pData, size_t size, uint64_t hash)
+{
+    const uint8_t* p = (const uint8_t*)pData;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+void HashSource(const char* compileTag, const char* source, size_t sourceSize,
+                uint64_t& nameHash, uint64_t& checkHash)
+{
+    nameHash = HashBytes(compileTag, strlen(compileTag) + 1, 0xcbf29ce484222325ULL);
+    nameHash = HashBytes(source, sourceSize, nameHash);
+    checkHash = HashBytes(compileTag, strlen(compileTag) + 1, 0x84222325cbf29ce4ULL);
+    checkHash = HashBytes(source, sourceSize, checkHash);
+}
+
+std::string ToHex(const uint8_t* pData, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string str;
+    str.reserve(size * 2);
+    for (size_t i = 0; i < size; i++) {
+        str.push_back(digits[pData[i] >> 4]);
+        str.push_back(digits[pData[i] & 0xf]);
+    }
+    return str;
+}
+
+std::string GetSpirvFileName(const std::string& cacheDir, uint64_t nameHash)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.spv", (unsigned long long)nameHash);
+    return cacheDir + "/" + name;
+}
+
+} // namespace
+
+bool VulkanShaderCache::SetCacheDirectory(const char* path)
+{
+    std::lock_guard<std::mutex> lock(g_cacheDirLock);
+    g_cacheDir.clear();
+
+    if ((path == nullptr) || (path[0] == '\0')) {
+        return true;
+    }
+
+#if defined(_WIN32)
+    const int ret = _mkdir(path);
+#else
+    const int ret = mkdir(path, 0755);
+#endif
+    if ((ret != 0) && (errno != EEXIST)) {
+        fprintf(stderr, "Shader cache: can't create the cache directory %s, the cache is disabled\n", path);
+        return false;
+    }
+
+    g_cacheDir = path;
+    return true;
+}
+
+bool VulkanShaderCache::IsEnabled()
+{
+    std::lock_guard<std::mutex> lock(g_cacheDirLock);
+    return !g_cacheDir.empty();
+}
+
+bool VulkanShaderCache::ReadFile(const std::string& fileName, std::vector<uint8_t>& data)
+{
+    FILE* fp = fopen(fileName.c_str(), "rb");
+    if (fp == nullptr) {
+        return false;
+    }
+
+    bool success = false;
+    if (fseek(fp, 0, SEEK_END) == 0) {
+        const long size = ftell(fp);
+        if ((size > 0) && (fseek(fp, 0, SEEK_SET) == 0)) {
+            data.resize((size_t)size);
+            success = (fread(data.data(), 1, data.size(), fp) == data.size());
+        }
+    }
+    fclose(fp);
+
+    if (!success) {
+        data.clear();
+    }
+    return success;
+}
+
+bool VulkanShaderCache::WriteFileAtomic(const std::string& fileName,
+                                        const void* pHeader, size_t headerSize,
+                                        const void* pData, size_t dataSize)
+{
+    static std::atomic<uint32_t> tempFileCounter(0);
+
+#if defined(_WIN32)
+    const int pid = _getpid();
+#else
+    const int pid = (int)getpid();
+#endif
+    char suffix[48];
+    snprintf(suffix, sizeof(suffix), ".%d.%u.tmp", pid, tempFileCounter++);
+    const std::string tempFileName = fileName + suffix;
+
+    FILE* fp = fopen(tempFileName.c_str(), "wb");
+    if (fp == nullptr) {
+        return false;
+    }
+
+    bool success = true;
+    if (headerSize > 0) {
+        success = (fwrite(pHeader, 1, headerSize, fp) == headerSize);
+    }
+    if (success && (dataSize > 0)) {
+        success = (fwrite(pData, 1, dataSize, fp) == dataSize);
+    }
+    success = (fclose(fp) == 0) && success;
+
+    if (success) {
+#if defined(_WIN32)
+        success = (MoveFileExA(tempFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+        success = (rename(tempFileName.c_str(), fileName.c_str()) == 0);
+#endif
+    }
+
+    if (!success) {
+        remove(tempFileName.c_str());
+        fprintf(stderr, "Shader cache: failed to write %s\n", fileName.c_str());
+    }
+    return success;
+}
+
+bool VulkanShaderCache::LoadSpirv(const char* compileTag, const char* source, size_t sourceSize,
+                                  std::vector<uint32_t>& spirv)
+{
+    const std::string cacheDir = GetCacheDirectory();
+    if (cacheDir.empty()) {
+        return false;
+    }
+
+    uint64_t nameHash, checkHash;
+    HashSource(compileTag, source, sourceSize, nameHash, checkHash);
+
+    std::vector<uint8_t> data;
+    if (!ReadFile(GetSpirvFileName(cacheDir, nameHash), data)) {
+        return false;
+    }
+
+    SpirvCacheHeader header;
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+
+    const size_t codeSize = data.size() - sizeof(header);
+    if ((header.magic != SpirvCacheMagic) || (header.version != SpirvCacheVersion) ||
+            (header.sourceSize != sourceSize) || (header.checkHash != checkHash) ||
+            (header.codeSize != codeSize) || (codeSize < sizeof(uint32_t)) ||
+            ((codeSize % sizeof(uint32_t)) != 0)) {
+        return false;
+    }
+
+    spirv.resize(codeSize / sizeof(uint32_t));
+    memcpy(spirv.data(), data.data() + sizeof(header), codeSize);
+
+    return (spirv[0] == SpirvMagic);
+}
+
+bool VulkanShaderCache::StoreSpirv(const char* compileTag, const char* source, size_t sourceSize,
+                                   const uint32_t* pCode, size_t codeSize)
+{
+    const std::string cacheDir = GetCacheDirectory();
+    if (cacheDir.empty() || (pCode == nullptr) || (codeSize < sizeof(uint32_t))) {
+        return false;
+    }
+
+    uint64_t nameHash, checkHash;
+    HashSource(compileTag, source, sourceSize, nameHash, checkHash);
+
+    SpirvCacheHeader header;
+    header.magic = SpirvCacheMagic;
+    header.version = SpirvCacheVersion;
+    header.sourceSize = sourceSize;
+    header.checkHash = checkHash;
+    header.codeSize = codeSize;
+
+    return WriteFileAtomic(GetSpirvFileName(cacheDir, nameHash), &header, sizeof(header), pCode, codeSize);
+}
+
+std::string VulkanShaderCache::GetPipelineCacheFileName(const VulkanDeviceContext* vkDevCtx,
+                                                        VkPhysicalDeviceProperties& props)
+{
+    const std::string cacheDir = GetCacheDirectory();
+    if (cacheDir.empty() || (vkDevCtx == nullptr) || (vkDevCtx->getPhysicalDevice() == VK_NULL_HANDLE)) {
+        return std::string();
+    }
+
+    vkDevCtx->GetPhysicalDeviceProperties(vkDevCtx->getPhysicalDevice(), &props);
+
+    char name[64];
+    snprintf(name, sizeof(name), "pipeline_%04x_%04x_", props.vendorID, props.deviceID);
+    return cacheDir + "/" + name + ToHex(props.pipelineCacheUUID, VK_UUID_SIZE) + ".bin";
+}
+
+bool VulkanShaderCache::LoadPipelineCacheData(const VulkanDeviceContext* vkDevCtx, std::vector<uint8_t>& data)
+{
+    data.clear();
+
+    VkPhysicalDeviceProperties props;
+    const std::string fileName = GetPipelineCacheFileName(vkDevCtx, props);
+    if (fileName.empty() || !ReadFile(fileName, data)) {
+        return false;
+    }
+
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header)) {
+        data.clear();
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+
+    if ((header.headerSize < sizeof(header)) ||
+            (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) ||
+            (header.vendorID != props.vendorID) || (header.deviceID != props.deviceID) ||
+            (memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)) {
+        data.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool VulkanShaderCache::StorePipelineCache(const VulkanDeviceContext* vkDevCtx, VkPipelineCache pipelineCache)
+{
+    if (pipelineCache == VK_NULL_HANDLE) {
+        return false;
+    }
+
+    VkPhysicalDeviceProperties props;
+    const std::string fileName = GetPipelineCacheFileName(vkDevCtx, props);
+    if (fileName.empty()) {
+        return false;
+    }
+
+    // Pick up what other processes stored since this cache was created.
+    std::vector<uint8_t> storedData;
+    if (LoadPipelineCacheData(vkDevCtx, storedData)) {
+        VkPipelineCacheCreateInfo pipelineCacheInfo = VkPipelineCacheCreateInfo();
+        pipelineCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        pipelineCacheInfo.initialDataSize = storedData.size();
+        pipelineCacheInfo.pInitialData = storedData.data();
+        VkPipelineCache storedCache = VK_NULL_HANDLE;
+        if (vkDevCtx->CreatePipelineCache(*vkDevCtx, &pipelineCacheInfo, nullptr, &storedCache) == VK_SUCCESS) {
+            vkDevCtx->MergePipelineCaches(*vkDevCtx, pipelineCache, 1, &storedCache);
+            vkDevCtx->DestroyPipelineCache(*vkDevCtx, storedCache, nullptr);
+        }
+    }
+
+    size_t dataSize = 0;
+    VkResult result = vkDevCtx->GetPipelineCacheData(*vkDevCtx, pipelineCache, &dataSize, nullptr);
+    if ((result != VK_SUCCESS) || (dataSize == 0)) {
+        return false;
+    }
+
+    std::vector<uint8_t> data(dataSize);
+    result = vkDevCtx->GetPipelineCacheData(*vkDevCtx, pipelineCache, &dataSize, data.data());
+    if ((result != VK_SUCCESS) && (result != VK_INCOMPLETE)) {
+        return false;
+    }
+    data.resize(dataSize);
+
+    if (data == storedData) {
+        // Nothing new, don't touch the file.
+        return true;
+    }
+
+    return WriteFileAtomic(fileName, nullptr, 0, data.data(), data.size());
+}
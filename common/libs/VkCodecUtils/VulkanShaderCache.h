@@ -0,0 +1,67 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKCODECUTILS_VULKANSHADERCACHE_H_
+#define _VKCODECUTILS_VULKANSHADERCACHE_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "VkCodecUtils/VulkanDeviceContext.h"
+
+// On-disk cache for the runtime generated shaders.
+//
+// SPIR-V binaries are content addressed: the file name is a hash of the GLSL
+// source and of the compile options, and the file header repeats a second
+// hash and the source size so that a collision is detected rather than used.
+// The VkPipelineCache data is stored per device, keyed by the vendor ID,
+// device ID and pipelineCacheUUID, and is only handed back to the driver if
+// its header matches the current device.
+//
+// Every file is written to a unique temporary name and renamed into place,
+// so concurrent processes sharing the directory never read a partial file.
+// When two processes update the pipeline cache at the same time the last
+// one wins, which only costs a cache miss later on.
+//
+// The cache is disabled until a directory is set.
+class VulkanShaderCache
+{
+public:
+    // An empty path disables the cache. The directory is created if needed.
+    static bool SetCacheDirectory(const char* path);
+    static bool IsEnabled();
+
+    // compileTag identifies the compiler version and options used to build the source.
+    static bool LoadSpirv(const char* compileTag, const char* source, size_t sourceSize,
+                          std::vector<uint32_t>& spirv);
+    static bool StoreSpirv(const char* compileTag, const char* source, size_t sourceSize,
+                           const uint32_t* pCode, size_t codeSize);
+
+    // Returns the stored pipeline cache data if it was created by the same device and driver.
+    static bool LoadPipelineCacheData(const VulkanDeviceContext* vkDevCtx, std::vector<uint8_t>& data);
+    // Merges the stored data into pipelineCache and writes the result back.
+    static bool StorePipelineCache(const VulkanDeviceContext* vkDevCtx, VkPipelineCache pipelineCache);
+
+private:
+    static std::string GetPipelineCacheFileName(const VulkanDeviceContext* vkDevCtx,
+                                                VkPhysicalDeviceProperties& props);
+    static bool ReadFile(const std::string& fileName, std::vector<uint8_t>& data);
+    static bool WriteFileAtomic(const std::string& fileName,
+                                const void* pHeader, size_t headerSize,
+                                const void* pData, size_t dataSize);
+};
+
+#endif /* _VKCODECUTILS_VULKANSHADERCACHE_H_ */
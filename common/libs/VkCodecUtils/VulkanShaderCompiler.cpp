@@ -15,13 +15,18 @@
 */
 
 #include "assert.h"
+#include <stdio.h>
+#include <string.h>
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 #include "VulkanShaderCompiler.h"
 #include <shaderc/shaderc.h>
 #include "Helpers.h"
 #include "VkCodecUtils/VulkanDeviceContext.h"
+#include "VkCodecUtils/VulkanShaderCache.h"
+#include "VkCodecUtils/VkVideoTracer.h"
 
 // Translate Vulkan Shader Type to shaderc shader type
 static shaderc_shader_kind getShadercShaderType(VkShaderStageFlagBits type)
@@ -45,11 +50,11 @@ static shaderc_shader_kind getShadercShaderType(VkShaderStageFlagBits type)
     return static_cast<shaderc_shader_kind>(-1);
 }
 
+// The shaderc compiler is only initialized on the first GLSL build, so that
+// users of the precompiled SPIR-V never pay for it.
 VulkanShaderCompiler::VulkanShaderCompiler()
     : compilerHandle(0)
 {
-    shaderc_compiler_t compiler = shaderc_compiler_initialize();
-    compilerHandle = compiler;
 }
 
 VulkanShaderCompiler::~VulkanShaderCompiler() {
@@ -65,8 +70,25 @@ VkShaderModule VulkanShaderCompiler::BuildGlslShader(const char *shaderCode, siz
                                                      VkShaderStageFlagBits type,
                                                      const VulkanDeviceContext* vkDevCtx)
 {
-    VkShaderModule shaderModule = VK_NULL_HANDLE;
-    if (compilerHandle) {
+    VK_VIDEO_TRACE_SCOPE("init", "BuildGlslShader", -1);
+
+    // The cached SPIR-V is only valid for the same compiler version, stage and entry point.
+    unsigned int spvVersion = 0, spvRevision = 0;
+    shaderc_get_spv_version(&spvVersion, &spvRevision);
+    char compileTag[128];
+    snprintf(compileTag, sizeof(compileTag), "shaderc spv 0x%x.%u stage 0x%x entry main",
+             spvVersion, spvRevision, (uint32_t)type);
+
+    std::vector<uint32_t> spirv;
+    if (!VulkanShaderCache::LoadSpirv(compileTag, shaderCode, shaderSize, spirv)) {
+
+        if (!compilerHandle) {
+            compilerHandle = shaderc_compiler_initialize();
+            if (!compilerHandle) {
+                return VK_NULL_HANDLE;
+            }
+        }
+
         shaderc_compiler_t compiler = (shaderc_compiler_t)compilerHandle;
 
         shaderc_compilation_result_t spvShader = shaderc_compile_into_spv(
@@ -76,24 +98,39 @@ VkShaderModule VulkanShaderCompiler::BuildGlslShader(const char *shaderCode, siz
                 shaderc_compilation_status_success) {
 
             std::cerr << "Compilation error: \n" << shaderc_result_get_error_message(spvShader) << std::endl;
+            shaderc_result_release(spvShader);
 
             return VK_NULL_HANDLE;
         }
 
-        // build vulkan shader module
-        VkShaderModuleCreateInfo shaderModuleCreateInfo = VkShaderModuleCreateInfo();
-        shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        shaderModuleCreateInfo.pNext = nullptr;
-        shaderModuleCreateInfo.codeSize = shaderc_result_get_length(spvShader);
-        shaderModuleCreateInfo.pCode = (const uint32_t *)shaderc_result_get_bytes(spvShader);
-        shaderModuleCreateInfo.flags = 0;
-        VkResult result = vkDevCtx->CreateShaderModule(*vkDevCtx, &shaderModuleCreateInfo, nullptr, &shaderModule);
-        assert(result == VK_SUCCESS);
-        if (result != VK_SUCCESS) {
-            std::cerr << "Failed to create shader module" << std::endl;
-            return VK_NULL_HANDLE;
-        }
+        const size_t spvSize = shaderc_result_get_length(spvShader);
+        spirv.resize(spvSize / sizeof(uint32_t));
+        memcpy(spirv.data(), shaderc_result_get_bytes(spvShader), spirv.size() * sizeof(uint32_t));
         shaderc_result_release(spvShader);
+
+        VulkanShaderCache::StoreSpirv(compileTag, shaderCode, shaderSize,
+                                      spirv.data(), spirv.size() * sizeof(uint32_t));
+    }
+
+    return BuildSpirvShader(spirv.data(), spirv.size() * sizeof(uint32_t), vkDevCtx);
+}
+
+VkShaderModule VulkanShaderCompiler::BuildSpirvShader(const uint32_t* pCode, size_t codeSize,
+                                                      const VulkanDeviceContext* vkDevCtx)
+{
+    // build vulkan shader module
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    VkShaderModuleCreateInfo shaderModuleCreateInfo = VkShaderModuleCreateInfo();
+    shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shaderModuleCreateInfo.pNext = nullptr;
+    shaderModuleCreateInfo.codeSize = codeSize;
+    shaderModuleCreateInfo.pCode = pCode;
+    shaderModuleCreateInfo.flags = 0;
+    VkResult result = vkDevCtx->CreateShaderModule(*vkDevCtx, &shaderModuleCreateInfo, nullptr, &shaderModule);
+    assert(result == VK_SUCCESS);
+    if (result != VK_SUCCESS) {
+        std::cerr << "Failed to create shader module" << std::endl;
+        return VK_NULL_HANDLE;
     }
     return shaderModule;
 }
@@ -29,6 +29,10 @@ public:
     VkShaderModule BuildGlslShader(const char *shaderCode, size_t shaderSize, VkShaderStageFlagBits type,
                                    const VulkanDeviceContext* vkDevCtx);
 
+    // Create VK shader module from SPIR-V compiled ahead of time, codeSize is in bytes
+    VkShaderModule BuildSpirvShader(const uint32_t* pCode, size_t codeSize,
+                                    const VulkanDeviceContext* vkDevCtx);
+
     // Create VK shader module from given glsl shader file
     VkShaderModule BuildShaderFromFile(const char *fileName, VkShaderStageFlagBits type,
                                        const VulkanDeviceContext* vkDevCtx);
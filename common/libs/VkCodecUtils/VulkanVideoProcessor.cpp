@@ -28,6 +28,7 @@
 
 #include "VkCodecUtils/Helpers.h"
 #include "VkCodecUtils/VulkanDeviceContext.h"
+#include "VkCodecUtils/VkVideoTracer.h"
 #include "VkVideoCore/VulkanVideoCapabilities.h"
 #include "VulkanVideoProcessor.h"
 #include "vulkan_interfaces.h"
@@ -90,6 +91,7 @@ int32_t VulkanVideoProcessor::Initialize(const VulkanDeviceContext* vkDevCtx,
                                                  defaultWidth,
                                                  defaultHeight,
                                                  defaultBitDepth,
+                                                 programConfig.demuxReadAheadPackets,
                                                  m_videoStreamDemuxer);
 
     if (result != VK_SUCCESS) {
@@ -249,6 +251,10 @@ int32_t VulkanVideoProcessor::GetBitDepth()  const
 
 void VulkanVideoProcessor::Deinit()
 {
+    VkParserTelemetry telemetry;
+    if (m_vkParser && m_vkParser->GetTelemetry(&telemetry)) {
+        VkParserAddTelemetry(&m_parserTelemetry, &telemetry);
+    }
     m_vkParser = nullptr;
     m_vkVideoFrameBuffer = nullptr;
     m_vkVideoDecoder = nullptr;
@@ -515,6 +521,8 @@ size_t VulkanVideoProcessor::OutputFrameToFile(VulkanDecodedFrame* pFrame)
 
     assert(pFrame != nullptr);
 
+    VK_VIDEO_TRACE_SCOPE("decode", "OutputFrameToFile", pFrame->decodeOrder);
+
     VkSharedBaseObj<VkImageResourceView> imageResourceView;
     pFrame->imageViews[VulkanDecodedFrame::IMAGE_VIEW_TYPE_LINEAR].GetImageResourceView(imageResourceView);
     assert(!!imageResourceView);
@@ -586,10 +594,72 @@ bool VulkanVideoProcessor::StreamCompleted()
         return false;
     } else {
         std::cout << "End of Video Stream with status  " << VK_SUCCESS << std::endl;
+        VideoStreamDemuxer::ReadAheadStats readAheadStats;
+        if (m_videoStreamDemuxer->GetReadAheadStats(readAheadStats) && (readAheadStats.numPackets > 0)) {
+            std::cout << "Demux read-ahead: " << readAheadStats.numPackets << " packets, average queue depth "
+                      << ((double)readAheadStats.queueDepthSum / readAheadStats.numPackets)
+                      << " (max " << readAheadStats.maxQueueDepth << "), "
+                      << readAheadStats.parserStalls << " parser stalls for "
+                      << (readAheadStats.parserStallTimeUs / 1000) << " ms, "
+                      << readAheadStats.demuxerStalls << " demuxer stalls" << std::endl;
+        }
+        VkParserTelemetry parserTelemetry;
+        if (((m_settings.parserTelemetry != 0) || (m_settings.verbose != 0)) &&
+                GetParserTelemetry(parserTelemetry) && (parserTelemetry.pictures > 0)) {
+            DumpParserTelemetry(parserTelemetry);
+        }
         return true;
     }
 }
 
+bool VulkanVideoProcessor::GetParserTelemetry(VkParserTelemetry& telemetry) const
+{
+    telemetry = m_parserTelemetry;
+    VkParserTelemetry current;
+    if (m_vkParser && m_vkParser->GetTelemetry(&current)) {
+        VkParserAddTelemetry(&telemetry, &current);
+    }
+    return (telemetry.bytesParsed > 0);
+}
+
+void VulkanVideoProcessor::DumpParserTelemetry(const VkParserTelemetry& telemetry)
+{
+    const double mbParsed = (double)telemetry.bytesParsed / (1024.0 * 1024.0);
+    std::cout << "Parser: " << telemetry.bytesParsed << " bytes, "
+              << telemetry.startCodes << " start codes (" << (mbParsed > 0.0 ? telemetry.startCodes / mbParsed : 0.0) << " per MB), "
+              << telemetry.emulationPreventionBytes << " emulation prevention bytes in the headers" << std::endl;
+    std::cout << "Parser bitstream buffers: " << telemetry.bytesCopied << " bytes copied, "
+              << telemetry.bytesCarriedOver << " bytes carried over by " << telemetry.bufferSwaps << " swaps, "
+              << telemetry.bufferResizes << " resizes, max size " << telemetry.maxBufferSize << " bytes" << std::endl;
+    std::cout << "Parser pictures: " << telemetry.pictures << ", "
+              << ((double)telemetry.slices / telemetry.pictures) << " slices per picture (max "
+              << telemetry.maxSlicesPerPicture << ")" << std::endl;
+    std::stringstream unitTypes;
+    for (uint32_t i = 0; i < 64; i++) {
+        if (telemetry.nalUnitTypes[i] > 0) {
+            unitTypes << " " << i << ":" << telemetry.nalUnitTypes[i];
+        }
+    }
+    if (!unitTypes.str().empty()) {
+        std::cout << "Parser NAL unit / OBU types:" << unitTypes.str() << std::endl;
+    }
+    const struct {
+        const char* name;
+        const VkParserCallbackTiming& timing;
+    } callbacks[] = {
+        { "BeginSequence", telemetry.beginSequence },
+        { "DecodePicture", telemetry.decodePicture },
+        { "DisplayPicture", telemetry.displayPicture },
+    };
+    for (const auto& callback : callbacks) {
+        if (callback.timing.count > 0) {
+            std::cout << "Parser callback " << callback.name << ": " << callback.timing.count << " calls, average "
+                      << (callback.timing.totalNs / callback.timing.count / 1000.0) << " us (max "
+                      << (callback.timing.maxNs / 1000.0) << " us)" << std::endl;
+        }
+    }
+}
+
 int32_t VulkanVideoProcessor::ParserProcessNextDataChunk()
 {
     if (m_videoStreamsCompleted) {
@@ -602,10 +672,12 @@ int32_t VulkanVideoProcessor::ParserProcessNextDataChunk()
     const uint8_t* pBitstreamData = nullptr;
     bool requiresPartialParsing = false;
     if (m_usesFramePreparser || m_usesStreamDemuxer) {
+        VK_VIDEO_TRACE_SCOPE("decode", "DemuxFrame", m_videoFrameNum);
         bitstreamChunkSize = m_videoStreamDemuxer->DemuxFrame(&pBitstreamData);
         assert(bitstreamBytesConsumed <= (size_t)std::numeric_limits<int32_t>::max());
         retValue = (int32_t)bitstreamChunkSize;
     } else {
+        VK_VIDEO_TRACE_SCOPE("decode", "ReadBitstreamData", m_videoFrameNum);
         bitstreamChunkSize = m_videoStreamDemuxer->ReadBitstreamData(&pBitstreamData, m_currentBitstreamOffset);
         requiresPartialParsing = true;
     }
@@ -734,6 +806,8 @@ VkResult VulkanVideoProcessor::CreateParser(const char*,
                                    bufferOffsetAlignment,
                                    bufferSizeAlignment,
                                    0, // clockRate - default 0 = 10Mhz
+                                   (m_settings.pipelinedParsing != 0),
+                                   (m_settings.parserTelemetry != 0) || (m_settings.verbose != 0),
                                    m_vkParser);
 }
 
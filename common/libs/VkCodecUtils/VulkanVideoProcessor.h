@@ -65,6 +65,10 @@ public:
     size_t OutputFrameToFile(VulkanDecodedFrame* pFrame);
     void Restart(void);
 
+    // Parser counters of all the parser instances created by this processor
+    bool GetParserTelemetry(VkParserTelemetry& telemetry) const;
+    static void DumpParserTelemetry(const VkParserTelemetry& telemetry);
+
 private:
 
     VulkanVideoProcessor(const ProgramConfig& settings, const VulkanDeviceContext* vkDevCtx)
@@ -83,6 +87,7 @@ private:
         , m_loopCount(1)
         , m_startFrame(0)
         , m_maxFrameCount(-1)
+        , m_parserTelemetry()
         , m_settings(settings)
     {
     }
@@ -122,6 +127,7 @@ private:
     int32_t   m_loopCount;
     uint32_t  m_startFrame;
     int32_t   m_maxFrameCount;
+    VkParserTelemetry m_parserTelemetry;  // Of the parser instances already released
     const ProgramConfig& m_settings;
 };
 
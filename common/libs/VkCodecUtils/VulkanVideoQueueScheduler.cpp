@@ -0,0 +1,236 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <assert.h>
+#include <iostream>
+#include "VkCodecUtils/VulkanVideoQueueScheduler.h"
+
+VulkanVideoQueueScheduler::VulkanVideoQueueScheduler(const VulkanDeviceContext* vkDevCtx,
+                                                     VulkanDeviceContext::QueueFamilySubmitType submitType,
+                                                     uint32_t affinitySlack)
+    : m_vkDevCtx(vkDevCtx)
+    , m_submitType(submitType)
+    , m_mutex()
+    , m_loadBalancer(1, affinitySlack)
+    , m_timelineSemaphores()
+{
+    assert((submitType == VulkanDeviceContext::DECODE) || (submitType == VulkanDeviceContext::ENCODE));
+}
+
+VulkanVideoQueueScheduler::~VulkanVideoQueueScheduler()
+{
+    Deinit();
+}
+
+VkResult VulkanVideoQueueScheduler::Init(int32_t numQueues)
+{
+    Deinit();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    assert((numQueues > 0) && (numQueues <= VulkanDeviceContext::MAX_QUEUE_INSTANCES));
+    if ((numQueues <= 0) || (numQueues > VulkanDeviceContext::MAX_QUEUE_INSTANCES)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkSemaphoreTypeCreateInfo timelineCreateInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+    timelineCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    timelineCreateInfo.initialValue = 0; // the first submission of each queue signals 1
+
+    VkSemaphoreCreateInfo createInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, &timelineCreateInfo };
+
+    m_timelineSemaphores.resize(numQueues, VK_NULL_HANDLE);
+    for (int32_t queueIndex = 0; queueIndex < numQueues; queueIndex++) {
+        VkResult result = m_vkDevCtx->CreateSemaphore(*m_vkDevCtx, &createInfo, nullptr, &m_timelineSemaphores[queueIndex]);
+        if (result != VK_SUCCESS) {
+            std::cerr << "ERROR: Can't create the timeline semaphore of the video queue scheduler: " << result << std::endl;
+            for (int32_t i = 0; i < queueIndex; i++) {
+                m_vkDevCtx->DestroySemaphore(*m_vkDevCtx, m_timelineSemaphores[i], nullptr);
+            }
+            m_timelineSemaphores.clear();
+            return result;
+        }
+    }
+
+    m_loadBalancer.Reset((uint32_t)numQueues, m_loadBalancer.GetAffinitySlack());
+
+    return VK_SUCCESS;
+}
+
+void VulkanVideoQueueScheduler::Deinit()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_timelineSemaphores.empty()) {
+        return;
+    }
+
+    // The semaphores can still be waited on by the pending submissions.
+    for (int32_t queueIndex = 0; queueIndex < (int32_t)m_timelineSemaphores.size(); queueIndex++) {
+        m_vkDevCtx->MultiThreadedQueueWaitIdle(m_submitType, queueIndex);
+    }
+
+    for (size_t queueIndex = 0; queueIndex < m_timelineSemaphores.size(); queueIndex++) {
+        m_vkDevCtx->DestroySemaphore(*m_vkDevCtx, m_timelineSemaphores[queueIndex], nullptr);
+    }
+    m_timelineSemaphores.clear();
+    m_loadBalancer.Reset(1, m_loadBalancer.GetAffinitySlack());
+}
+
+int32_t VulkanVideoQueueScheduler::RegisterStream(uint32_t weight)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_loadBalancer.RegisterStream(weight);
+}
+
+void VulkanVideoQueueScheduler::UnregisterStream(int32_t streamId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_loadBalancer.UnregisterStream(streamId);
+}
+
+void VulkanVideoQueueScheduler::UpdateCompletedWorkLocked()
+{
+    for (uint32_t queueIndex = 0; queueIndex < (uint32_t)m_timelineSemaphores.size(); queueIndex++) {
+
+        if (m_loadBalancer.GetQueuePendingCount(queueIndex) == 0) {
+            continue;
+        }
+
+        uint64_t completedValue = 0;
+        VkResult result = m_vkDevCtx->GetSemaphoreCounterValue(*m_vkDevCtx, m_timelineSemaphores[queueIndex], &completedValue);
+        if (result != VK_SUCCESS) {
+            continue;
+        }
+        // With an implementation that never advances the counter (e.g. a mock
+        // ICD), nothing retires and the selection balances the total cost
+        // submitted to each queue instead.
+        if (completedValue > m_loadBalancer.GetQueueSubmittedValue(queueIndex)) {
+            completedValue = m_loadBalancer.GetQueueSubmittedValue(queueIndex);
+        }
+        m_loadBalancer.Complete(queueIndex, completedValue);
+    }
+}
+
+void VulkanVideoQueueScheduler::UpdateCompletedWork()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    UpdateCompletedWorkLocked();
+}
+
+uint32_t VulkanVideoQueueScheduler::GetQueueLoad(int32_t queueIndex)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if ((queueIndex < 0) || (queueIndex >= (int32_t)m_timelineSemaphores.size())) {
+        return 0;
+    }
+    UpdateCompletedWorkLocked();
+    return m_loadBalancer.GetQueueLoad(queueIndex);
+}
+
+VkResult VulkanVideoQueueScheduler::QueueSubmit(int32_t streamId, const VkSubmitInfo* pSubmitInfo, VkFence fence,
+                                                int32_t& queueIndex, uint32_t cost)
+{
+    assert(pSubmitInfo != nullptr);
+    assert(pSubmitInfo->signalSemaphoreCount < MAX_SUBMIT_SEMAPHORES);
+    if ((pSubmitInfo == nullptr) || (pSubmitInfo->signalSemaphoreCount >= MAX_SUBMIT_SEMAPHORES)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    // The lock is held over vkQueueSubmit, so the values are signaled in order on each queue.
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_timelineSemaphores.empty() || !m_loadBalancer.IsValidStream(streamId)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    UpdateCompletedWorkLocked();
+
+    const int32_t selectedQueue = m_loadBalancer.SelectQueue(streamId);
+
+    // The caller's timeline values can be anywhere in the pNext chain. The chain
+    // can only have one VkTimelineSemaphoreSubmitInfo, so the queue's value is
+    // merged into the caller's struct for the duration of the submission.
+    VkTimelineSemaphoreSubmitInfo* pTimelineInfo = nullptr;
+    for (const VkBaseInStructure* pStruct = (const VkBaseInStructure*)pSubmitInfo->pNext; pStruct != nullptr; pStruct = pStruct->pNext) {
+        if (pStruct->sType == VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO) {
+            pTimelineInfo = (VkTimelineSemaphoreSubmitInfo*)pStruct;
+            break;
+        }
+    }
+
+    uint64_t waitValues[MAX_SUBMIT_SEMAPHORES] = { 0 /* ignored for binary semaphores */ };
+    assert(pSubmitInfo->waitSemaphoreCount <= MAX_SUBMIT_SEMAPHORES);
+    if (pSubmitInfo->waitSemaphoreCount > MAX_SUBMIT_SEMAPHORES) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if ((pTimelineInfo != nullptr) && (pTimelineInfo->pWaitSemaphoreValues != nullptr)) {
+        for (uint32_t i = 0; (i < pTimelineInfo->waitSemaphoreValueCount) && (i < pSubmitInfo->waitSemaphoreCount); i++) {
+            waitValues[i] = pTimelineInfo->pWaitSemaphoreValues[i];
+        }
+    }
+
+    VkSemaphore signalSemaphores[MAX_SUBMIT_SEMAPHORES] = {};
+    uint64_t signalValues[MAX_SUBMIT_SEMAPHORES] = { 0 /* ignored for binary semaphores */ };
+    uint32_t signalSemaphoreCount = 0;
+    for (; signalSemaphoreCount < pSubmitInfo->signalSemaphoreCount; signalSemaphoreCount++) {
+        signalSemaphores[signalSemaphoreCount] = pSubmitInfo->pSignalSemaphores[signalSemaphoreCount];
+        if ((pTimelineInfo != nullptr) && (pTimelineInfo->pSignalSemaphoreValues != nullptr) &&
+                (signalSemaphoreCount < pTimelineInfo->signalSemaphoreValueCount)) {
+            signalValues[signalSemaphoreCount] = pTimelineInfo->pSignalSemaphoreValues[signalSemaphoreCount];
+        }
+    }
+    const uint64_t queueSignalValue = m_loadBalancer.GetQueueSubmittedValue(selectedQueue) + 1;
+    signalSemaphores[signalSemaphoreCount] = m_timelineSemaphores[selectedQueue];
+    signalValues[signalSemaphoreCount] = queueSignalValue;
+    signalSemaphoreCount++;
+
+    VkSubmitInfo submitInfo = *pSubmitInfo;
+    submitInfo.signalSemaphoreCount = signalSemaphoreCount;
+    submitInfo.pSignalSemaphores = signalSemaphores;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO, pSubmitInfo->pNext };
+    VkTimelineSemaphoreSubmitInfo callerTimelineInfo = timelineInfo;
+    VkTimelineSemaphoreSubmitInfo* pMergedTimelineInfo = &timelineInfo;
+    if (pTimelineInfo != nullptr) {
+        callerTimelineInfo = *pTimelineInfo;
+        pMergedTimelineInfo = pTimelineInfo;
+    } else {
+        submitInfo.pNext = &timelineInfo;
+    }
+    pMergedTimelineInfo->waitSemaphoreValueCount = pSubmitInfo->waitSemaphoreCount;
+    pMergedTimelineInfo->pWaitSemaphoreValues = waitValues;
+    pMergedTimelineInfo->signalSemaphoreValueCount = signalSemaphoreCount;
+    pMergedTimelineInfo->pSignalSemaphoreValues = signalValues;
+
+    VkResult result = m_vkDevCtx->MultiThreadedQueueSubmit(m_submitType, selectedQueue, 1, &submitInfo, fence);
+
+    if (pTimelineInfo != nullptr) {
+        *pTimelineInfo = callerTimelineInfo;
+    }
+
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    const uint64_t submittedValue = m_loadBalancer.Submit(streamId, (uint32_t)selectedQueue, cost);
+    assert(submittedValue == queueSignalValue);
+    (void)submittedValue;
+
+    queueIndex = selectedQueue;
+
+    return VK_SUCCESS;
+}
@@ -0,0 +1,73 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _VKCODECUTILS_VULKANVIDEOQUEUESCHEDULER_H_
+#define _VKCODECUTILS_VULKANVIDEOQUEUESCHEDULER_H_
+
+#include <mutex>
+#include <vector>
+#include "VkCodecUtils/VulkanDeviceContext.h"
+#include "VkCodecUtils/VkVideoQueueLoadBalancer.h"
+
+// Device wide scheduler of the submissions to the video decode or encode
+// queues of a VulkanDeviceContext. Each queue gets a timeline semaphore that
+// every scheduled submission signals with the next value of the queue, so the
+// outstanding work of each queue is known without fences. The choice of the
+// queue is done by VkVideoQueueLoadBalancer.
+class VulkanVideoQueueScheduler {
+
+public:
+
+    // Maximum number of semaphores of the VkSubmitInfo given to QueueSubmit().
+    enum { MAX_SUBMIT_SEMAPHORES = 8 };
+
+    VulkanVideoQueueScheduler(const VulkanDeviceContext* vkDevCtx,
+                              VulkanDeviceContext::QueueFamilySubmitType submitType,
+                              uint32_t affinitySlack = 1);
+    ~VulkanVideoQueueScheduler();
+
+    // Creates the timeline semaphores of the numQueues queues.
+    VkResult Init(int32_t numQueues);
+    void Deinit();
+
+    int32_t GetNumQueues() const { return (int32_t)m_timelineSemaphores.size(); }
+
+    int32_t RegisterStream(uint32_t weight = 1);
+    void UnregisterStream(int32_t streamId);
+
+    // Submits pSubmitInfo of the stream to the least loaded queue, adding the
+    // signal of the queue's timeline semaphore. The VkSubmitInfo may chain a
+    // VkTimelineSemaphoreSubmitInfo anywhere in its pNext, which is restored
+    // after the submission. queueIndex returns the queue used.
+    VkResult QueueSubmit(int32_t streamId, const VkSubmitInfo* pSubmitInfo, VkFence fence,
+                         int32_t& queueIndex, uint32_t cost = 1);
+
+    // Polls the timeline semaphores and retires the completed submissions.
+    void UpdateCompletedWork();
+
+    uint32_t GetQueueLoad(int32_t queueIndex);
+
+private:
+    void UpdateCompletedWorkLocked();
+
+    const VulkanDeviceContext*                 m_vkDevCtx;
+    const VulkanDeviceContext::QueueFamilySubmitType m_submitType;
+    std::mutex                                 m_mutex;
+    VkVideoQueueLoadBalancer                   m_loadBalancer;
+    std::vector<VkSemaphore>                   m_timelineSemaphores;
+};
+
+#endif /* _VKCODECUTILS_VULKANVIDEOQUEUESCHEDULER_H_ */
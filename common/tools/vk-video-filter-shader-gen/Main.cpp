@@ -0,0 +1,181 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Build time generator of VulkanFilterYuvComputeSpirv.h: compiles every
+// VulkanFilterYuvCompute shader variant with glslangValidator and writes the
+// SPIR-V as C arrays, along with the variant lookup table.
+//
+// Usage: vk-video-filter-shader-gen <output header> <glslangValidator> <work directory>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "VkCodecUtils/VulkanFilterYuvComputeShaders.h"
+
+static const uint32_t SpirvMagic = 0x07230203;
+
+static const char* GetFilterTypeName(VulkanFilterYuvComputeShaders::FilterType filterType)
+{
+    switch (filterType) {
+    case VulkanFilterYuvComputeShaders::YCBCRCOPY:
+        return "VulkanFilterYuvComputeShaders::YCBCRCOPY";
+    case VulkanFilterYuvComputeShaders::YCBCRCLEAR:
+        return "VulkanFilterYuvComputeShaders::YCBCRCLEAR";
+    case VulkanFilterYuvComputeShaders::YCBCR2RGBA:
+        return "VulkanFilterYuvComputeShaders::YCBCR2RGBA";
+    case VulkanFilterYuvComputeShaders::RGBA2YCBCR:
+        return "VulkanFilterYuvComputeShaders::RGBA2YCBCR";
+    }
+    return nullptr;
+}
+
+static bool WriteTextFile(const std::string& fileName, const std::string& text)
+{
+    FILE* fp = fopen(fileName.c_str(), "wb");
+    if (fp == nullptr) {
+        fprintf(stderr, "Can't open %s for writing\n", fileName.c_str());
+        return false;
+    }
+    const bool success = (fwrite(text.data(), 1, text.size(), fp) == text.size());
+    return (fclose(fp) == 0) && success;
+}
+
+static bool ReadSpirvFile(const std::string& fileName, std::vector<uint32_t>& spirv)
+{
+    FILE* fp = fopen(fileName.c_str(), "rb");
+    if (fp == nullptr) {
+        fprintf(stderr, "Can't open %s\n", fileName.c_str());
+        return false;
+    }
+
+    spirv.clear();
+    uint32_t word;
+    while (fread(&word, sizeof(word), 1, fp) == 1) {
+        spirv.push_back(word);
+    }
+    fclose(fp);
+
+    // glslangValidator writes the module in the host byte order.
+    return !spirv.empty() && (spirv[0] == SpirvMagic);
+}
+
+static bool CompileShader(const std::string& validator, const std::string& workDir,
+                          size_t shaderIndex, const std::string& source,
+                          std::vector<uint32_t>& spirv)
+{
+    char baseName[64];
+    snprintf(baseName, sizeof(baseName), "/vk_video_filter_%u", (uint32_t)shaderIndex);
+    const std::string glslFileName = workDir + baseName + ".comp";
+    const std::string spirvFileName = workDir + baseName + ".spv";
+
+    if (!WriteTextFile(glslFileName, source)) {
+        return false;
+    }
+
+    const std::string command = "\"" + validator + "\" -V -S comp -o \"" + spirvFileName + "\" \"" + glslFileName + "\"";
+    if (system(command.c_str()) != 0) {
+        fprintf(stderr, "Failed to compile %s:\n%s\n", glslFileName.c_str(), source.c_str());
+        return false;
+    }
+
+    const bool success = ReadSpirvFile(spirvFileName, spirv);
+    remove(glslFileName.c_str());
+    remove(spirvFileName.c_str());
+    return success;
+}
+
+int main(int argc, const char** argv)
+{
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s <output header> <glslangValidator> <work directory>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::string outFileName(argv[1]);
+    const std::string validator(argv[2]);
+    const std::string workDir(argv[3]);
+
+    std::vector<VulkanFilterYuvComputeShaders::Variant> variants;
+    VulkanFilterYuvComputeShaders::EnumerateVariants(variants);
+
+    // Variants with the same source share the same SPIR-V array.
+    std::vector<std::string> sources;
+    std::vector<size_t> variantShaders(variants.size());
+    std::string arrays;
+
+    for (size_t v = 0; v < variants.size(); v++) {
+        std::string source;
+        if (VulkanFilterYuvComputeShaders::GenerateShader(variants[v], source) == 0) {
+            fprintf(stderr, "No shader for the filter type %d\n", variants[v].filterType);
+            return EXIT_FAILURE;
+        }
+
+        size_t shaderIndex = 0;
+        while ((shaderIndex < sources.size()) && (sources[shaderIndex] != source)) {
+            shaderIndex++;
+        }
+        variantShaders[v] = shaderIndex;
+        if (shaderIndex < sources.size()) {
+            continue;
+        }
+        sources.push_back(source);
+
+        std::vector<uint32_t> spirv;
+        if (!CompileShader(validator, workDir, shaderIndex, source, spirv)) {
+            return EXIT_FAILURE;
+        }
+
+        char line[128];
+        snprintf(line, sizeof(line), "static const uint32_t filterShaderSpirv%u[%u] = {\n",
+                 (uint32_t)shaderIndex, (uint32_t)spirv.size());
+        arrays += line;
+        for (size_t i = 0; i < spirv.size(); i += 4) {
+            arrays += "   ";
+            for (size_t j = i; (j < i + 4) && (j < spirv.size()); j++) {
+                snprintf(line, sizeof(line), " 0x%08x,", spirv[j]);
+                arrays += line;
+            }
+            arrays += "\n";
+        }
+        arrays += "};\n\n";
+    }
+
+    std::string header =
+        "// Generated by vk-video-filter-shader-gen, do not edit.\n"
+        "\n";
+    header += arrays;
+    header += "static const PrecompiledFilterShader precompiledFilterShaders[] = {\n";
+    for (size_t v = 0; v < variants.size(); v++) {
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "    { %s, %u, (VkSamplerYcbcrModelConversion)%d, (VkSamplerYcbcrRange)%d, "
+                 "filterShaderSpirv%u, sizeof(filterShaderSpirv%u) },\n",
+                 GetFilterTypeName(variants[v].filterType), variants[v].bitDepth,
+                 (int)variants[v].ycbcrModel, (int)variants[v].ycbcrRange,
+                 (uint32_t)variantShaders[v], (uint32_t)variantShaders[v]);
+        header += line;
+    }
+    header += "};\n";
+
+    if (!WriteTextFile(outFileName, header)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("Compiled %u filter shaders for %u variants into %s\n",
+           (uint32_t)sources.size(), (uint32_t)variants.size(), outFileName.c_str());
+    return EXIT_SUCCESS;
+}
@@ -25,6 +25,8 @@
 #include "VkCodecUtils/ProgramConfig.h"
 #include "VkCodecUtils/VulkanVideoProcessor.h"
 #include "VkCodecUtils/VulkanDecoderFrameProcessor.h"
+#include "VkCodecUtils/VkVideoTracer.h"
+#include "VkCodecUtils/VulkanShaderCache.h"
 #include "VkShell/Shell.h"
 
 int main(int argc, const char **argv) {
@@ -32,6 +34,15 @@ int main(int argc, const char **argv) {
     ProgramConfig programConfig(argv[0]);
     programConfig.ParseArgs(argc, argv);
 
+    if (!programConfig.traceFileName.empty()) {
+        VkVideoTracer::Enable(true);
+        VK_VIDEO_TRACE_THREAD_NAME("decoder");
+    }
+
+    if (!programConfig.shaderCacheDir.empty()) {
+        VulkanShaderCache::SetCacheDirectory(programConfig.shaderCacheDir.c_str());
+    }
+
     // In the regular application usecase the CRC output variables are allocated here and also output as part of main.
     // In the library case it is up to the caller of the library to allocate the values and initialize them.
     std::vector<uint32_t> crcAllocation;
@@ -286,5 +297,9 @@ int main(int argc, const char **argv) {
         }
     }
 
+    if (!programConfig.traceFileName.empty()) {
+        VkVideoTracer::WriteChromeTrace(programConfig.traceFileName.c_str());
+    }
+
     return 0;
 }
@@ -52,6 +52,7 @@ public:
 };
 
 struct VkParserSourceDataPacket;
+struct VkParserTelemetry;
 class IVulkanVideoParser : public VkVideoRefCountBase {
 public:
     static VkResult Create(
@@ -65,6 +66,8 @@ public:
         uint32_t bufferSizeAlignment,
         uint64_t clockRate,
         uint32_t errorThreshold,
+        bool pipelinedParsing,
+        bool callbackTimings,
         VkSharedBaseObj<IVulkanVideoParser>& vulkanVideoParser);
 
     // doPartialParsing 0: parse entire packet, 1: parse until next decode/display event
@@ -72,6 +75,9 @@ public:
                                     size_t* pParsedBytes,
                                     bool doPartialParsing = false) = 0;
 
+    // Counters of the underlying parser instance, see VkParserTelemetry
+    virtual bool GetTelemetry(VkParserTelemetry* pTelemetry) = 0;
+
 protected:
     virtual ~IVulkanVideoParser() { }
 };
@@ -91,6 +97,8 @@ VkResult vulkanCreateVideoParser(
     uint32_t bufferOffsetAlignment,
     uint32_t bufferSizeAlignment,
     uint64_t clockRate,
+    bool pipelinedParsing,
+    bool callbackTimings,
     VkSharedBaseObj<IVulkanVideoParser>& vulkanVideoParser);
 
 #endif /* _VULKANVIDEOPARSER_H_ */
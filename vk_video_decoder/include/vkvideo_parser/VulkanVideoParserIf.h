@@ -214,6 +214,36 @@ typedef struct VkParserH264PictureData {
     };
 } VkParserH264PictureData;
 
+// Slice segment header values of an H.265 slice segment (7.3.6.1). A dependent
+// slice segment carries the values of the independent slice segment it follows.
+typedef struct VkParserHevcSliceSegment {
+    uint32_t slice_segment_address;     // First CTB of the slice segment, in tile scan
+    uint32_t sliceDataOffset;           // Offset of slice_segment_data() in the bitstream buffer
+    uint32_t sliceDataSize;             // Bytes up to the end of the NAL unit, emulation prevention bytes included
+    uint32_t firstEntryPoint;           // Index of the first entry point of the slice segment in pEntryPointOffsets
+    uint32_t numEntryPoints;            // num_entry_point_offsets
+    uint8_t  slice_type;                // 0 = B, 1 = P, 2 = I
+    uint8_t  dependent_slice_segment_flag;
+    int8_t   SliceQpY;                  // 26 + init_qp_minus26 + slice_qp_delta
+    int8_t   slice_cb_qp_offset;
+    int8_t   slice_cr_qp_offset;
+    uint8_t  slice_sao_luma_flag : 1;
+    uint8_t  slice_sao_chroma_flag : 1;
+    uint8_t  slice_deblocking_filter_disabled_flag : 1;
+    uint8_t  slice_loop_filter_across_slices_enabled_flag : 1;
+    uint8_t  cu_chroma_qp_offset_enabled_flag : 1;
+    uint8_t  cabac_init_flag : 1;
+    uint8_t  mvd_l1_zero_flag : 1;
+    uint8_t  collocated_from_l0_flag : 1;
+    int8_t   slice_beta_offset_div2;
+    int8_t   slice_tc_offset_div2;
+    uint8_t  MaxNumMergeCand;           // 5 - five_minus_max_num_merge_cand
+    uint8_t  num_ref_idx_l0_active_minus1;
+    uint8_t  num_ref_idx_l1_active_minus1;
+    uint8_t  collocated_ref_idx;
+    uint8_t  weighted_pred_flag;        // A pred_weight_table() is present
+} VkParserHevcSliceSegment;
+
 typedef struct VkParserHevcPictureData {
     // VPS
     const StdVideoPictureParametersSet* pStdVps;
@@ -267,8 +297,23 @@ typedef struct VkParserHevcPictureData {
     int8_t RefPicSetInterLayer0[8];
     int8_t RefPicSetInterLayer1[8];
 
+    // The slice segments of the picture, VkParserPictureData::numSlices of
+    // them in bitstream order, and the entry points of their substreams (tiles,
+    // or CTB rows with entropy_coding_sync_enabled_flag) after the first one,
+    // as offsets in the bitstream buffer. Both arrays are owned by the parser
+    // and valid during the DecodePicture() callback.
+    const VkParserHevcSliceSegment* pSliceSegments;
+    const uint32_t* pEntryPointOffsets;
+    uint32_t numEntryPointOffsets;
+
 } VkParserHevcPictureData;
 
+#if !defined(VK_KHR_video_decode_vp9)
+// VK_KHR_video_decode_vp9 is newer than the Vulkan headers in use, the parser
+// accepts VP9 under the codec operation value of the extension.
+#define VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR ((VkVideoCodecOperationFlagBitsKHR)0x00000008)
+#endif
+
 typedef struct VkParserVp9PictureData {
     uint32_t width;
     uint32_t height;
@@ -373,6 +418,72 @@ struct VkParserAv1PictureData {
     uint32_t frame_height;
 };
 
+// Metadata carried in the bitstream with a picture: H.264/H.265 SEI messages
+// and AV1 metadata OBUs.
+enum VkParserMetadataType {
+    VK_PARSER_METADATA_TYPE_UNKNOWN = 0,                // Any other SEI message or metadata OBU, see payloadType
+    VK_PARSER_METADATA_TYPE_PICTURE_TIMING,             // H.26x pic_timing SEI (H.264 clock timestamps)
+    VK_PARSER_METADATA_TYPE_TIMECODE,                   // H.265 time_code SEI, AV1 METADATA_TYPE_TIMECODE
+    VK_PARSER_METADATA_TYPE_MASTERING_DISPLAY,          // H.26x mastering_display_colour_volume SEI, AV1 METADATA_TYPE_HDR_MDCV
+    VK_PARSER_METADATA_TYPE_CONTENT_LIGHT_LEVEL,        // H.26x content_light_level_info SEI, AV1 METADATA_TYPE_HDR_CLL
+    VK_PARSER_METADATA_TYPE_HDR10PLUS,                  // ITU-T T.35 SMPTE ST 2094-40 dynamic metadata
+    VK_PARSER_METADATA_TYPE_CLOSED_CAPTIONS,            // ITU-T T.35 ATSC A/53 (GA94) caption data
+    VK_PARSER_METADATA_TYPE_ITU_T_T35,                  // Any other ITU-T T.35 registered user data
+    VK_PARSER_METADATA_TYPE_USER_DATA_UNREGISTERED,     // H.26x user_data_unregistered SEI (UUID + data)
+    VK_PARSER_METADATA_TYPE_SCALABILITY,                // AV1 METADATA_TYPE_SCALABILITY
+    VK_PARSER_METADATA_TYPE_USER_PRIVATE,               // AV1 METADATA_TYPE_UNREGISTERED_USER_PRIVATE_6..31
+};
+
+// Location of a metadata payload in the bitstream buffer of the picture
+// (VkParserPictureData::bitstreamData). The payload is not copied: for
+// H.264/H.265 it may contain emulation prevention bytes, VkParserMetadataReader
+// returns the payload bytes without them.
+typedef struct VkParserMetadata {
+    VkParserMetadataType type;
+    uint32_t payloadType;          // SEI payloadType or AV1 metadata_type
+    uint32_t offset;               // Offset of the payload in the bitstream buffer (after metadata_type for AV1)
+    uint32_t size;                 // Bytes of the payload in the buffer, emulation prevention bytes included
+    uint32_t payloadSize;          // Bytes of the payload once the emulation prevention bytes are removed
+    uint32_t suffix : 1;           // H.265 suffix SEI
+    uint32_t emulationPrevention : 1;  // The payload bytes are escaped (H.264/H.265)
+    uint32_t precedingZeros : 2;   // Zero bytes right before the payload, for the emulation prevention state
+} VkParserMetadata;
+
+// Reads a metadata payload from the bitstream buffer, skipping the emulation
+// prevention bytes, without copying the whole payload.
+class VkParserMetadataReader {
+public:
+    VkParserMetadataReader(const uint8_t* pBitstream, const VkParserMetadata& metadata)
+        : m_pData(pBitstream + metadata.offset)
+        , m_size(metadata.size)
+        , m_pos(0)
+        , m_zeroCount(metadata.precedingZeros)
+        , m_emulationPrevention(metadata.emulationPrevention) { }
+
+    // Returns the number of bytes read, 0 at the end of the payload.
+    size_t Read(uint8_t* pDst, size_t size)
+    {
+        size_t bytes = 0;
+        while ((bytes < size) && (m_pos < m_size)) {
+            const uint8_t c = m_pData[m_pos++];
+            if (m_emulationPrevention && (m_zeroCount >= 2) && (c == 0x03)) {
+                m_zeroCount = 0;
+                continue;
+            }
+            m_zeroCount = (c == 0) ? (m_zeroCount + 1) : 0;
+            pDst[bytes++] = c;
+        }
+        return bytes;
+    }
+
+private:
+    const uint8_t* m_pData;
+    uint32_t       m_size;
+    uint32_t       m_pos;
+    uint32_t       m_zeroCount;
+    bool           m_emulationPrevention;
+};
+
 typedef struct VkParserPictureData {
     int32_t PicWidthInMbs;            // Coded Frame Size
     int32_t FrameHeightInMbs;         // Coded Frame Height
@@ -407,6 +518,12 @@ typedef struct VkParserPictureData {
     size_t bitstreamDataOffset;                            // bitstream data offset in bitstreamData buffer
     size_t bitstreamDataLen;                               // Number of bytes in bitstream data buffer
     VkSharedBaseObj<VulkanBitstreamBuffer> bitstreamData;  // bitstream data for this picture (slice-layer)
+    // Metadata of this picture, in bitstream order (only with
+    // VkParserInitDecodeParameters::pictureMetadata). The array is owned by
+    // the parser and valid during the DecodePicture() callback, the payloads
+    // are in bitstreamData and live as long as the client references it.
+    const VkParserMetadata* pMetadata;
+    uint32_t numMetadata;
 } VkParserPictureData;
 
 // Packet input for parsing
@@ -482,6 +599,74 @@ typedef struct VkParserDisplayMasteringInfo {
     uint32_t min_display_mastering_luminance;
 } VkParserDisplayMasteringInfo;
 
+// Host memory used by a parser instance, in bytes. The bitstream buffers and
+// the picture buffers belong to the client and are not counted.
+typedef struct VkParserMemoryFootprint {
+    size_t parserSize;         // The parser object and the codec state it always allocates
+    size_t onDemandSize;       // State allocated on first use: MVC/SVC, multi-layer, pipelined parsing, H.265 slice segments
+    size_t parameterSetsSize;  // The parameter sets currently held by the parser
+} VkParserMemoryFootprint;
+
+// Time spent by the client in one of its callbacks, in nanoseconds
+typedef struct VkParserCallbackTiming {
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+} VkParserCallbackTiming;
+
+// Counters of a parser instance, accumulated since Initialize(). They are
+// maintained with a few integer updates per NAL unit and picture, and only
+// read by GetTelemetry().
+typedef struct VkParserTelemetry {
+    // Byte stream
+    uint64_t bytesParsed;              // Input bytes passed to ParseByteStream()
+    uint64_t startCodes;               // Start codes found by the start code scanner (H.264/H.265)
+    uint64_t emulationPreventionBytes; // Removed while reading the headers, the slice data is not read
+    uint64_t nalUnitTypes[64];         // H.264/H.265 nal_unit_type, AV1 obu_type
+    // Bitstream buffers
+    uint64_t bytesCopied;              // Input bytes copied to the bitstream buffers
+    uint64_t bytesCarriedOver;         // Bytes copied to the next bitstream buffer by a swap
+    uint32_t bufferResizes;            // Bitstream buffer grown by resizeBitstreamBuffer()
+    uint32_t bufferSwaps;              // New bitstream buffer requested for the next picture
+    uint64_t maxBufferSize;
+    // Pictures
+    uint64_t pictures;                 // Pictures passed to DecodePicture()
+    uint64_t slices;                   // H.26x slices, AV1/VP9 tiles
+    uint32_t maxSlicesPerPicture;
+    uint32_t reserved;
+    // Client callbacks
+    VkParserCallbackTiming beginSequence;
+    VkParserCallbackTiming decodePicture;
+    VkParserCallbackTiming displayPicture;
+} VkParserTelemetry;
+
+// Adds the counters of another parser instance
+inline void VkParserAddTelemetry(VkParserTelemetry* pTotal, const VkParserTelemetry* pTelemetry)
+{
+    pTotal->bytesParsed += pTelemetry->bytesParsed;
+    pTotal->startCodes += pTelemetry->startCodes;
+    pTotal->emulationPreventionBytes += pTelemetry->emulationPreventionBytes;
+    for (uint32_t i = 0; i < 64; i++) {
+        pTotal->nalUnitTypes[i] += pTelemetry->nalUnitTypes[i];
+    }
+    pTotal->bytesCopied += pTelemetry->bytesCopied;
+    pTotal->bytesCarriedOver += pTelemetry->bytesCarriedOver;
+    pTotal->bufferResizes += pTelemetry->bufferResizes;
+    pTotal->bufferSwaps += pTelemetry->bufferSwaps;
+    pTotal->maxBufferSize = (pTelemetry->maxBufferSize > pTotal->maxBufferSize) ? pTelemetry->maxBufferSize : pTotal->maxBufferSize;
+    pTotal->pictures += pTelemetry->pictures;
+    pTotal->slices += pTelemetry->slices;
+    pTotal->maxSlicesPerPicture = (pTelemetry->maxSlicesPerPicture > pTotal->maxSlicesPerPicture) ?
+                                      pTelemetry->maxSlicesPerPicture : pTotal->maxSlicesPerPicture;
+    VkParserCallbackTiming* pTotalTimings[3] = { &pTotal->beginSequence, &pTotal->decodePicture, &pTotal->displayPicture };
+    const VkParserCallbackTiming* pTimings[3] = { &pTelemetry->beginSequence, &pTelemetry->decodePicture, &pTelemetry->displayPicture };
+    for (uint32_t i = 0; i < 3; i++) {
+        pTotalTimings[i]->count += pTimings[i]->count;
+        pTotalTimings[i]->totalNs += pTimings[i]->totalNs;
+        pTotalTimings[i]->maxNs = (pTimings[i]->maxNs > pTotalTimings[i]->maxNs) ? pTimings[i]->maxNs : pTotalTimings[i]->maxNs;
+    }
+}
+
 // Interface to allow decoder to communicate with the client
 class VkParserVideoDecodeClient {
    public:
@@ -524,6 +709,20 @@ typedef struct VkParserInitDecodeParameters {
 
     // If set, Picture Parameters are going to be provided via UpdatePictureParameters callback
     bool outOfBandPictureParameters;
+
+    // If set, the start codes of large byte stream packets are searched on a separate
+    // thread, concurrently with the parsing of the NAL units. The results are the same.
+    bool pipelinedParsing;
+
+    // If set, the SEI messages and AV1 metadata OBUs of each picture are reported
+    // in VkParserPictureData::pMetadata. The SEI NAL units are then kept in the
+    // bitstream buffer of the picture, outside of its slices.
+    bool pictureMetadata;
+
+    // If set, the time spent in the client callbacks is added to the telemetry
+    // (VkParserTelemetry::beginSequence, decodePicture, displayPicture), at the
+    // cost of two clock reads per callback. The counters are always kept.
+    bool callbackTimings;
 } VkParserInitDecodeParameters;
 
 // High-level interface to video decoder (Note that parsing and decoding
@@ -533,6 +732,8 @@ class VulkanVideoDecodeParser : public virtual VkVideoRefCountBase {
     virtual VkResult Initialize(const VkParserInitDecodeParameters* pParserPictureData) = 0;
     virtual bool ParseByteStream(const VkParserBitstreamPacket* pck, size_t* pParsedBytes = NULL) = 0;
     virtual bool GetDisplayMasteringInfo(VkParserDisplayMasteringInfo* pdisp) = 0;
+    virtual bool GetMemoryFootprint(VkParserMemoryFootprint* pFootprint) = 0;
+    virtual bool GetTelemetry(VkParserTelemetry* pTelemetry) = 0;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////
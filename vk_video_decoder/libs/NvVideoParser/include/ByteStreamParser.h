@@ -4,6 +4,7 @@
 #include <stdarg.h>
 #include "VulkanVideoParserIf.h"
 #include "VulkanVideoDecoder.h"
+#include "StartCodeScanner.h"
 #include "NvVideoParser/nvVulkanVideoUtils.h"
 #include "NvVideoParser/nvVulkanVideoParser.h"
 #include <algorithm>
@@ -45,6 +46,7 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
             framesinpkt++;
 
             m_bitstreamDataLen = swapBitstreamBuffer(m_nalu.start_offset, m_nalu.end_offset - m_nalu.start_offset);
+            ResetMetadata();
         }
         // Reset the PTS queue to prevent timestamps from before the discontinuity to be associated with
         // a frame past the discontinuity
@@ -75,6 +77,7 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
             m_nalu.end_offset = m_nalu.start_offset + curr_data_size;
             VkSharedBaseObj<VulkanBitstreamBuffer> bitstreamBuffer(m_bitstreamData.GetBitstreamBuffer());
             bitstreamBuffer->CopyDataFromBuffer(pdatain, 0, m_nalu.start_offset, curr_data_size);
+            m_telemetry.bytesCopied += curr_data_size;
             m_llNaluStartLocation = m_llParsedBytes;
             m_llParsedBytes += curr_data_size;
             m_bitstreamData.ResetStreamMarkers();
@@ -107,6 +110,13 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
 
         return (m_eError == NV_NO_ERROR ? true : false);
     }
+    // In the pipelined mode, the start codes of large packets are searched on the scanner
+    // thread while the NAL units found so far are parsed on this one.
+    StartCodeScanner* pScanner = ((m_pStartCodeScanner != nullptr) && !pck->bPartialParsing &&
+                                  (curr_data_size >= MIN_PIPELINED_PACKET_SIZE)) ? m_pStartCodeScanner : nullptr;
+    if (pScanner != nullptr) {
+        pScanner->Start(&next_start_code<T>, pdatain, (size_t)curr_data_size, m_BitBfr);
+    }
     // Parse start codes
     while (curr_data_size > 0) {
 
@@ -122,7 +132,9 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
             buflen = std::min<VkDeviceSize>(buflen, (m_lMinBytesForBoundaryDetection - (m_nalu.end_offset - m_nalu.start_offset)));
         }
         bool found_start_code = false;
-        VkDeviceSize start_offset = next_start_code<T>(pdatain, (size_t)buflen, found_start_code);
+        VkDeviceSize start_offset = (pScanner != nullptr) ?
+            pScanner->Next((size_t)(pck->nDataLength - curr_data_size), (size_t)buflen, found_start_code) :
+            next_start_code<T>(pdatain, (size_t)buflen, m_BitBfr, found_start_code);
         VkDeviceSize data_used = found_start_code ? start_offset : buflen;
         if (data_used > 0)
         {
@@ -134,6 +146,7 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
             if (bytes > 0) {
                 VkSharedBaseObj<VulkanBitstreamBuffer> bitstreamBuffer(m_bitstreamData.GetBitstreamBuffer());
                 bitstreamBuffer->CopyDataFromBuffer(pdatain, 0, m_nalu.end_offset, bytes);
+                m_telemetry.bytesCopied += bytes;
             }
             m_nalu.end_offset += bytes;
             m_llParsedBytes += bytes;
@@ -143,25 +156,21 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
             if ((m_nalu.start_offset > 0) && (m_nalu.end_offset == (m_nalu.start_offset + (int64_t)m_lMinBytesForBoundaryDetection)))
             {
                 init_dbits();
-                if (IsPictureBoundary(available_bits() >> 3)) {
+                if (IsPictureBoundary(available_bits() >> 3) && (GetPictureDataEnd() > 0)) {
                     // Decode only one frame if EOP is set and ignore remaining frames in current packet
                     if ((!pck->bEOP) || (pck->bEOP && (framesinpkt < 1)))
                     {
                         end_of_picture();
                         framesinpkt++;
                     }
-                    // This swap will copy to the new buffer most of the time.
-                    m_bitstreamDataLen = swapBitstreamBuffer(m_nalu.start_offset, m_nalu.end_offset - m_nalu.start_offset);
-                    m_nalu.end_offset -= m_nalu.start_offset;
-                    m_nalu.start_offset = 0;
-                    m_bitstreamData.ResetStreamMarkers();
-                    m_llNaluStartLocation = m_llParsedBytes - m_nalu.end_offset;
+                    StartNextPictureBuffer();
                 }
             }
         }
         // Did we find a startcode ?
         if (found_start_code)
         {
+            m_telemetry.startCodes++;
             if (m_nalu.start_offset == 0) {
                 m_llNaluStartLocation = m_llParsedBytes - m_nalu.end_offset;
             }
@@ -170,6 +179,10 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
             nal_unit();
             if (m_bDecoderInitFailed)
             {
+                if (pScanner != nullptr) {
+                    pScanner->Abort();
+                    m_BitBfr = 1; // State right after the 00.00.01 just found
+                }
                 return false;
             }
             // Add back the start code prefix for the next NAL unit
@@ -177,6 +190,9 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
             m_nalu.end_offset += 3;
         }
     }
+    if (pScanner != nullptr) {
+        m_BitBfr = pScanner->Finish();
+    }
     if (pParsedBytes)
     {
         assert(curr_data_size < std::numeric_limits<size_t>::max());
@@ -213,6 +229,7 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
         m_nalu.end_offset = 0;
         m_nalu.start_offset = 0;
         m_bitstreamData.ResetStreamMarkers();
+        ResetMetadata();
         m_llNaluStartLocation = m_llParsedBytes;
         if (pck->bEOS)
         {
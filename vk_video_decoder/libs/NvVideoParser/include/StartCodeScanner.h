@@ -0,0 +1,92 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _STARTCODESCANNER_H_
+#define _STARTCODESCANNER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// StartCodeScanner runs the start code search of a packet on a worker thread,
+// ahead of the NAL unit parsing done by the caller.
+//
+// The positions of the start codes only depend on the data (and on the last
+// bytes of the previous packet), so the worker scans the whole packet with the
+// SIMD next_start_code() and publishes the offsets following each 00.00.01
+// through a bounded queue. The parser then calls Next() in place of
+// next_start_code(), with the same arguments, and gets the same results.
+//
+class StartCodeScanner
+{
+public:
+    typedef size_t (*PfnNextStartCode)(const uint8_t *pdatain, size_t datasize, uint32_t& bitBfr, bool& found_start_code);
+
+    enum { SEGMENT_SIZE = 64 * 1024 };       // Bytes scanned before the results are published
+    enum { MAX_QUEUED_START_CODES = 4096 };  // Queue depth, the worker waits when it is full
+
+    StartCodeScanner();
+    ~StartCodeScanner();
+
+    // Starts scanning pData, bitBfr is the start code state at its beginning.
+    // pData must remain valid until Finish() or Abort() return.
+    void Start(PfnNextStartCode pfnNextStartCode, const uint8_t *pData, size_t dataSize, uint32_t bitBfr);
+
+    // Same as next_start_code(pData + offset, datasize, ...), offset being the
+    // number of bytes already consumed. Must be called with increasing offsets.
+    size_t Next(size_t offset, size_t datasize, bool& found_start_code);
+
+    // Waits for the end of the scan and returns the start code state at the
+    // end of the data.
+    uint32_t Finish();
+
+    // Stops the scan without waiting for the end of the data.
+    void Abort();
+
+    // Host memory used by the scanner, the stack of the worker thread excepted.
+    size_t GetMemorySize() const { return sizeof(*this) + (m_queue.capacity() + m_batch.capacity()) * sizeof(size_t); }
+
+private:
+    void Run();
+    void WaitIdle();
+
+    std::thread              m_thread;
+    std::mutex               m_mutex;
+    std::condition_variable  m_producerCond;    // Signaled to the worker: new packet, queue space, exit
+    std::condition_variable  m_consumerCond;    // Signaled to the parser: new results, end of the scan
+    // Shared state, protected by m_mutex
+    PfnNextStartCode         m_pfnNextStartCode;
+    const uint8_t*           m_pData;
+    size_t                   m_dataSize;
+    uint32_t                 m_bitBfr;          // Start code state, at the start and then at the end of the scan
+    bool                     m_busy;            // A packet is being scanned
+    bool                     m_abort;
+    bool                     m_exit;
+    size_t                   m_scannedBytes;    // All the start codes before this offset have been queued
+    std::vector<size_t>      m_queue;           // Ring buffer of the offsets following the start codes
+    size_t                   m_queueRead;
+    size_t                   m_queueCount;
+    // Parser side state
+    std::vector<size_t>      m_batch;           // Offsets dequeued by the parser
+    size_t                   m_batchPos;
+    size_t                   m_localScanned;    // m_scannedBytes when m_batch was dequeued
+};
+
+#endif // _STARTCODESCANNER_H_
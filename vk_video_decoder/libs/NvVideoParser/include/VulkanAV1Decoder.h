@@ -413,6 +413,7 @@ class VulkanAV1Decoder : public VulkanVideoDecoder {
     bool ParseObuSequenceHeader();
     bool ParseObuFrameHeader();
     bool ParseObuTileGroup(const AV1ObuHeader&);
+    void AddObuMetadata(const uint8_t* pPayload, uint32_t payloadSize);
     bool ReadFilmGrainParams();
 
     void ReadTimingInfoHeader();
@@ -452,6 +453,10 @@ class VulkanAV1Decoder : public VulkanVideoDecoder {
 
     void CreatePrivateContext() override {}
     void FreeContext() override {}
+    void GetCodecMemoryFootprint(VkParserMemoryFootprint* pFootprint) const override {
+        pFootprint->parserSize += sizeof(*this);
+        pFootprint->parameterSetsSize += m_sps ? sizeof(av1_seq_param_s) : 0;
+    }
     int GetRelativeDist(int a, int b);
 };
 
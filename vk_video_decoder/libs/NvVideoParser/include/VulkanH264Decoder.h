@@ -21,6 +21,7 @@
 #include "VulkanVideoDecoder.h"
 #include "VulkanH26xDecoder.h"
 #include "nvVulkanh264ScalingList.h"
+#include <vector>
 
 #define VK_H264_SPS_VUI_FIELD(pStdVui, nvSpsIn, name) pStdVui->name = nvSpsIn->vui.name
 #define SET_VK_H264_SPS_VUI_FIELD(pStdVui, name, value) pStdVui->name = value
@@ -95,7 +96,7 @@ struct seq_parameter_set_s : public StdVideoPictureParametersSet, public StdVide
 {
     static const char*                   m_refClassId;
     StdVideoH264ScalingLists             stdScalingLists;
-    int32_t                              offset_for_ref_frame[255];
+    std::vector<int32_t>                 offset_for_ref_frame; // only sized for pic_order_cnt_type 1
     StdVideoH264SequenceParameterSetVui  stdVui;
     StdVideoH264HrdParameters            stdHrdParameters;
     // private interface
@@ -113,7 +114,7 @@ struct seq_parameter_set_s : public StdVideoPictureParametersSet, public StdVide
                                    m_refClassId, updateSequenceCount)
     , StdVideoH264SequenceParameterSet()
     , stdScalingLists()
-    , offset_for_ref_frame{0}
+    , offset_for_ref_frame()
     , stdVui()
     , stdHrdParameters()
     , seqScalingList()
@@ -121,7 +122,6 @@ struct seq_parameter_set_s : public StdVideoPictureParametersSet, public StdVide
     , svc()
     , constraint_set_flags()
       {
-          pOffsetForRefFrame = offset_for_ref_frame;
       }
 
     virtual ~seq_parameter_set_s() {
@@ -173,6 +173,7 @@ struct seq_parameter_set_s : public StdVideoPictureParametersSet, public StdVide
     void Reset() {
 
         StdVideoH264SequenceParameterSet::operator=(StdVideoH264SequenceParameterSet());
+        offset_for_ref_frame.clear();
         stdScalingLists = StdVideoH264ScalingLists();
         stdVui = StdVideoH264SequenceParameterSetVui();
         seqScalingList = NvScalingListH264();
@@ -752,7 +753,6 @@ protected:
         H264ParserData()
         : slh(),
           spssClientUpdateCount(),
-          spsmes(),
           spsmesClientUpdateCount(),
           spssvcsClientUpdateCount(),
           ppssClientUpdateCount(),
@@ -767,13 +767,42 @@ protected:
 
         slice_header_s slh;    // first slice of the picture (for dpb management)
         uint64_t  spssClientUpdateCount[MAX_NUM_SPS];
-        seq_parameter_set_mvc_extension_s spsmes[MAX_NUM_SPS];
         uint64_t spsmesClientUpdateCount[MAX_NUM_SPS];
         uint64_t spssvcsClientUpdateCount[MAX_NUM_SPS];
         uint64_t ppssClientUpdateCount[MAX_NUM_PPS];
         nalu_header_extension_u nhe;
     };
 
+    // MVC state, allocated with the first MVC subset SPS
+    struct H264MvcData
+    {
+        H264MvcData()
+        : CurrFrmViewPic(),
+          spsmes()
+        {
+
+        }
+
+        VkPicIf *CurrFrmViewPic[1024];    // frame buffer for the non-base views of the current frame
+        seq_parameter_set_mvc_extension_s spsmes[MAX_NUM_SPS];
+    };
+
+    // SVC layer representations, allocated with the first slice parsed in SVC mode
+    struct H264SvcData
+    {
+        H264SvcData()
+        : layer_data(),
+          dependency_state(),
+          dependency_data()
+        {
+
+        }
+
+        layer_data_s layer_data[8 * 16];         // [DQId]
+        dependency_state_s dependency_state[8];  // [dependency_id]
+        dependency_data_s dependency_data[8];    // [dependency_id]
+    };
+
     // CNvVideoDecoder
     virtual void CreatePrivateContext();
     virtual void InitParser();
@@ -783,6 +812,7 @@ protected:
     virtual void EndOfStream();
     virtual int32_t  ParseNalUnit();
     virtual void FreeContext();
+    virtual void GetCodecMemoryFootprint(VkParserMemoryFootprint *pFootprint) const;
 
 private:
     // Header parsing
@@ -834,7 +864,13 @@ private:
     void sei_payload(int payloadType, int payloadSize);
     // MVC
     int get_view_output_index(int view_id);
+    H264MvcData *GetMvcData();
+    VkPicIf *GetCurrFrmViewPic(int VOIdx) const;
+    void SetCurrFrmViewPic(int VOIdx, VkPicIf *pPicBuf);
+    void ResetCurrFrmViewPics();
     // SVC
+    H264SvcData *GetSvcData();
+    void ResetSvcLayerData();
     bool prefix_nal_unit_svc(int nal_ref_idc);
     int dec_ref_base_pic_marking(memory_management_base_control_operation_s mmbco[MAX_MMCOS]);
     void update_layer_info(seq_parameter_set_s *sps, pic_parameter_set_s *pps, slice_header_s *slh);
@@ -910,17 +946,16 @@ private:
     int m_prevFrameNumOffset, m_prevFrameNum;
     int m_PrevRefFrameNum, m_PrevViewId;
     int m_MaxRefFramesPerView;
-    VkPicIf *CurrFrmViewPic[1024];    // frame buffer for all views of the current frame
+    VkPicIf *m_CurrFrmBaseViewPic;    // frame buffer for the base view of the current frame
+    H264MvcData *m_pMvcData;          // other views, NULL until an MVC stream is parsed
     // use SVC decoder
     bool m_bUseSVC;
     bool m_bLayerFirstSlice;
     uint32_t m_iDQIdMax;
     prefix_nal_unit_svc_s m_prefix_nal_unit_svc;
     slice_header_s m_slh_prev;
-    layer_data_s m_layer_data[8 * 16];
-    dependency_state_s m_dependency_state[8];
+    H264SvcData *m_pSvcData; // NULL until the first slice parsed in SVC mode
     dependency_state_s *m_ds; // current dependency state
-    dependency_data_s m_dependency_data[8];
     dependency_data_s *m_dd; // current dependency data
     slice_group_map_s* m_slice_group_map; // [pps_id] (base layer only)
 };
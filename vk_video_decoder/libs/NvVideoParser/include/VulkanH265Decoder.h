@@ -22,6 +22,7 @@
 #include "nvVulkanh265ScalingList.h"
 #include "VulkanH26xDecoder.h"
 #include <memory>
+#include <vector>
 
 #define MAX_NUM_VPS                 16
 #define MAX_NUM_SPS                 16
@@ -148,14 +149,12 @@ struct hevc_video_hrd_param_s : public StdVideoH265HrdParameters
 
     void BindSubLayers(uint32_t maxNumSubLayersMinus1)
     {
-        if (maxNumSubLayersMinus1) {
-            if (flags.nal_hrd_parameters_present_flag) {
-                pSubLayerHrdParametersNal = stdSubLayerHrdParametersNal;
-            }
+        if (flags.nal_hrd_parameters_present_flag) {
+            pSubLayerHrdParametersNal = stdSubLayerHrdParametersNal;
+        }
 
-            if (flags.vcl_hrd_parameters_present_flag) {
-                pSubLayerHrdParametersVcl = stdSubLayerHrdParametersVcl;
-            }
+        if (flags.vcl_hrd_parameters_present_flag) {
+            pSubLayerHrdParametersVcl = stdSubLayerHrdParametersVcl;
         }
         maxNumSubLayers = maxNumSubLayersMinus1 + 1;
     }
@@ -473,6 +472,76 @@ struct hevc_video_param_flags {
     uint32_t vps_poc_lsb_aligned_flag : 1;
 };
 
+// VPS extension (F.7.3.2.1.1): the tables describing the layers of a multi-layer
+// stream. They take about 1 MB, so they are only allocated for a VPS that has an
+// extension, single-layer streams never touch them.
+struct hevc_video_param_ext_s
+{
+    uint8_t  scalability_mask_flag[MAX_NUM_SCALABILITY_TYPES];
+    uint32_t numScalabilityTypes; 
+    uint8_t  dimension_id_len[MAX_NUM_SCALABILITY_TYPES];
+
+    uint8_t  layer_id_in_nuh[MAX_NUM_LAYER_IDS];
+    uint8_t LayerIdxInVps[MAX_NUM_LAYER_IDS];
+    uint8_t  dimension_id[MAX_NUM_LAYER_IDS][MAX_NUM_SCALABILITY_TYPES];
+    uint32_t numViews;
+    uint8_t  viewOrderIdx[MAX_NUM_LAYER_IDS];
+    uint32_t view_id_len;
+    uint8_t  view_id_val[MAX_NUM_LAYER_IDS];
+    uint8_t  direct_dependency_flag[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
+    uint8_t  DependencyFlag[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
+    uint8_t  numDirectRefLayers[MAX_NUM_LAYER_IDS];
+    uint8_t  idDirectRefLayer[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
+    uint8_t  numRefLayers[MAX_NUM_LAYER_IDS];
+    uint8_t  idRefLayer[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
+    uint8_t  numPredictedLayers[MAX_NUM_LAYER_IDS];
+    uint8_t  idPredictedLayer[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
+
+    uint8_t  layerIdInListFlag[MAX_NUM_LAYER_IDS];
+    uint32_t numLayersInTreePartition[MAX_NUM_LAYER_IDS];
+    uint8_t  treePartitionLayerIdList[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
+    uint32_t numIndependentLayers;
+    uint32_t num_add_layer_sets;
+    uint8_t  highest_layer_idx_plus1[MAX_VPS_LAYER_SETS][MAX_NUM_LAYER_IDS];
+
+    uint8_t  sub_layers_vps_max_minus1[MAX_NUM_LAYER_IDS];
+    uint8_t  max_tid_il_ref_pics_plus1[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
+
+    uint32_t vps_num_profile_tier_level_minus1;
+    uint8_t  vps_profile_present_flag[MAX_VPS_OP_SETS_PLUS1];
+
+    /* Operation Points */
+    uint32_t num_add_olss;
+    uint32_t numOutputLayerSets;
+    uint32_t default_output_layer_idc;
+    uint32_t layer_set_idx_for_ols_minus1[MAX_VPS_OUTPUTLAYER_SETS];
+    uint32_t output_layer_flag[MAX_VPS_OUTPUTLAYER_SETS][MAX_NUM_LAYER_IDS];
+
+    uint8_t  numNecessaryLayers[MAX_VPS_OUTPUTLAYER_SETS];
+    uint8_t  necessaryLayerFlag[MAX_VPS_OUTPUTLAYER_SETS][MAX_NUM_LAYER_IDS];
+
+    uint8_t  numOutputLayersInOutputLayerSet[MAX_VPS_OUTPUTLAYER_SETS];
+    uint8_t  olsHighestOutputLayerId[MAX_VPS_OUTPUTLAYER_SETS];
+
+    uint8_t  profile_tier_level_idx[MAX_VPS_OUTPUTLAYER_SETS][MAX_NUM_LAYER_IDS];
+
+    /* Output Format */
+    uint32_t vps_num_rep_formats_minus1;
+    repFormat_t repFormat[MAX_NUM_LAYER_IDS];
+    uint8_t  vps_rep_format_idx[MAX_NUM_LAYER_IDS];
+    uint8_t  poc_lsb_not_present_flag[MAX_NUM_LAYER_IDS];
+
+    /* DPB size */
+    uint8_t  sub_layer_flag_info_present_flag[MAX_VPS_OUTPUTLAYER_SETS];
+    uint8_t  sub_layer_dpb_info_present_flag[MAX_VPS_OUTPUTLAYER_SETS][MAX_SUB_LAYERS];
+    uint8_t  max_vps_dec_pic_buffering_minus1[MAX_VPS_OUTPUTLAYER_SETS][MAX_SUB_LAYERS][MAX_NUM_LAYER_IDS];
+    uint8_t  max_vps_num_reorder_pics[MAX_VPS_OUTPUTLAYER_SETS][MAX_SUB_LAYERS];
+    uint8_t  max_vps_latency_increase_plus1[MAX_VPS_OUTPUTLAYER_SETS][MAX_SUB_LAYERS];
+
+    /* VPS Extension 2 */
+    uint32_t vps_extension2_flag;
+};
+
 struct hevc_video_param_s : public StdVideoPictureParametersSet, public StdVideoH265VideoParameterSet
 {
 
@@ -547,9 +616,19 @@ struct hevc_video_param_s : public StdVideoPictureParametersSet, public StdVideo
         memset(&privFlags, 0x00, clearSize);
 
         client = nullptr;
+        pExtension.reset();
+    }
+
+    hevc_video_param_ext_s* CreateExtension() {
+        pExtension.reset(new hevc_video_param_ext_s());
+        return pExtension.get();
     }
 
+    // The extension of a VPS without one reads as all zero
+    const hevc_video_param_ext_s& GetExtension() const { return pExtension ? *pExtension : m_noExtension; }
+
     static const char*                           m_refClassId;
+    static hevc_video_param_ext_s                m_noExtension;
     StdVideoH265DecPicBufMgr                     stdDecPicBufMgr;
     std::shared_ptr<hevc_video_hrd_param_s[]>    stdHrdParameters;
     StdVideoH265ProfileTierLevel                 stdProfileTierLevel;
@@ -568,74 +647,22 @@ struct hevc_video_param_s : public StdVideoPictureParametersSet, public StdVideo
     uint32_t hrd_layer_set_idx[MAX_VPS_LAYER_SETS];
     uint8_t  cprms_present_flag[MAX_VPS_LAYER_SETS];
 
-    /* VPS Extension */
-    uint8_t  scalability_mask_flag[MAX_NUM_SCALABILITY_TYPES];
-    uint32_t numScalabilityTypes; 
-    uint8_t  dimension_id_len[MAX_NUM_SCALABILITY_TYPES];
-
-    uint8_t  layer_id_in_nuh[MAX_NUM_LAYER_IDS];
-    uint8_t LayerIdxInVps[MAX_NUM_LAYER_IDS];
-    uint8_t  dimension_id[MAX_NUM_LAYER_IDS][MAX_NUM_SCALABILITY_TYPES];
-    uint32_t numViews;
-    uint8_t  viewOrderIdx[MAX_NUM_LAYER_IDS];
-    uint32_t view_id_len;
-    uint8_t  view_id_val[MAX_NUM_LAYER_IDS];
-    uint8_t  direct_dependency_flag[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
-    uint8_t  DependencyFlag[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
-    uint8_t  numDirectRefLayers[MAX_NUM_LAYER_IDS];
-    uint8_t  idDirectRefLayer[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
-    uint8_t  numRefLayers[MAX_NUM_LAYER_IDS];
-    uint8_t  idRefLayer[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
-    uint8_t  numPredictedLayers[MAX_NUM_LAYER_IDS];
-    uint8_t  idPredictedLayer[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
-
-    uint8_t  layerIdInListFlag[MAX_NUM_LAYER_IDS];
-    uint32_t numLayersInTreePartition[MAX_NUM_LAYER_IDS];
-    uint8_t  treePartitionLayerIdList[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
-    uint32_t numIndependentLayers;
-    uint32_t num_add_layer_sets;
-    uint8_t  highest_layer_idx_plus1[MAX_VPS_LAYER_SETS][MAX_NUM_LAYER_IDS];
-
-    uint8_t  sub_layers_vps_max_minus1[MAX_NUM_LAYER_IDS];
-    uint8_t  max_tid_il_ref_pics_plus1[MAX_NUM_LAYER_IDS][MAX_NUM_LAYER_IDS];
-
-    uint32_t vps_num_profile_tier_level_minus1;
-    uint8_t  vps_profile_present_flag[MAX_VPS_OP_SETS_PLUS1];
-
-    /* Operation Points */
-    uint32_t num_add_olss;
-    uint32_t numOutputLayerSets;
-    uint32_t default_output_layer_idc;
-    uint32_t layer_set_idx_for_ols_minus1[MAX_VPS_OUTPUTLAYER_SETS];
-    uint32_t output_layer_flag[MAX_VPS_OUTPUTLAYER_SETS][MAX_NUM_LAYER_IDS];
-
-    uint8_t  numNecessaryLayers[MAX_VPS_OUTPUTLAYER_SETS];
-    uint8_t  necessaryLayerFlag[MAX_VPS_OUTPUTLAYER_SETS][MAX_NUM_LAYER_IDS];
-
-    uint8_t  numOutputLayersInOutputLayerSet[MAX_VPS_OUTPUTLAYER_SETS];
-    uint8_t  olsHighestOutputLayerId[MAX_VPS_OUTPUTLAYER_SETS];
-
-    uint8_t  profile_tier_level_idx[MAX_VPS_OUTPUTLAYER_SETS][MAX_NUM_LAYER_IDS];
-
-    /* Output Format */
-    uint32_t vps_num_rep_formats_minus1;
-    repFormat_t repFormat[MAX_NUM_LAYER_IDS];
-    uint8_t  vps_rep_format_idx[MAX_NUM_LAYER_IDS];
-    uint8_t  poc_lsb_not_present_flag[MAX_NUM_LAYER_IDS];
-
-    /* DPB size */
-    uint8_t  sub_layer_flag_info_present_flag[MAX_VPS_OUTPUTLAYER_SETS];
-    uint8_t  sub_layer_dpb_info_present_flag[MAX_VPS_OUTPUTLAYER_SETS][MAX_SUB_LAYERS];
-    uint8_t  max_vps_dec_pic_buffering_minus1[MAX_VPS_OUTPUTLAYER_SETS][MAX_SUB_LAYERS][MAX_NUM_LAYER_IDS];
-    uint8_t  max_vps_num_reorder_pics[MAX_VPS_OUTPUTLAYER_SETS][MAX_SUB_LAYERS];
-    uint8_t  max_vps_latency_increase_plus1[MAX_VPS_OUTPUTLAYER_SETS][MAX_SUB_LAYERS];
-
-    /* VPS Extension 2 */
-    uint32_t vps_extension2_flag;
-
     VkSharedBaseObj<VkVideoRefCountBase> client;
+    std::unique_ptr<hevc_video_param_ext_s> pExtension;    // Only set if vps_extension_flag
 };
 
+typedef struct _hevc_pred_weight_table_s
+{
+    uint8_t luma_log2_weight_denom;
+    int8_t  delta_chroma_log2_weight_denom;
+    uint16_t luma_weight_flags[2];          // bitmask [MAX_NUM_REF_PICS], per list
+    uint16_t chroma_weight_flags[2];        // bitmask [MAX_NUM_REF_PICS], per list
+    int8_t  delta_luma_weight[2][MAX_NUM_REF_PICS];
+    int16_t luma_offset[2][MAX_NUM_REF_PICS];
+    int8_t  delta_chroma_weight[2][MAX_NUM_REF_PICS][2];
+    int32_t delta_chroma_offset[2][MAX_NUM_REF_PICS][2];
+} hevc_pred_weight_table_s;
+
 typedef struct _hevc_slice_header_s
 {
     uint8_t nal_unit_type;
@@ -678,6 +705,35 @@ typedef struct _hevc_slice_header_s
     uint8_t reserved2[2];
 
     short_term_ref_pic_set_s strps;
+
+    uint8_t slice_sao_luma_flag;
+    uint8_t slice_sao_chroma_flag;
+    uint8_t ref_pic_list_modification_flag_l0;
+    uint8_t ref_pic_list_modification_flag_l1;
+
+    uint8_t list_entry_l0[MAX_NUM_REF_PICS];
+    uint8_t list_entry_l1[MAX_NUM_REF_PICS];
+
+    uint8_t mvd_l1_zero_flag;
+    uint8_t cabac_init_flag;
+    uint8_t collocated_ref_idx;
+    uint8_t five_minus_max_num_merge_cand;
+
+    int8_t slice_qp_delta;
+    int8_t slice_cb_qp_offset;
+    int8_t slice_cr_qp_offset;
+    uint8_t cu_chroma_qp_offset_enabled_flag;
+
+    uint8_t deblocking_filter_override_flag;
+    uint8_t slice_deblocking_filter_disabled_flag;
+    int8_t slice_beta_offset_div2;
+    int8_t slice_tc_offset_div2;
+
+    uint8_t slice_loop_filter_across_slices_enabled_flag;
+    uint8_t weighted_pred_flag;             // pred_weight_table() present
+    uint8_t reserved3[2];
+
+    hevc_pred_weight_table_s pwt;
 } hevc_slice_header_s;
 
 
@@ -746,6 +802,7 @@ protected:
     virtual void EndOfStream();
     virtual int32_t  ParseNalUnit();
     virtual void FreeContext();
+    virtual void GetCodecMemoryFootprint(VkParserMemoryFootprint *pFootprint) const;
 
 protected:
     // Syntax
@@ -771,6 +828,7 @@ protected:
     void hrd_parameters(hevc_video_hrd_param_s* pStdHrdParameters, bool commonInfPresentFlag, uint8_t maxNumSubLayersMinus1);
     void sub_layer_hrd_parameters(StdVideoH265SubLayerHrdParameters* pStdSubLayerHrdParameters, int subLayerId, int cpb_cnt_minus1, int sub_pic_cpb_params_present_flag);
     bool slice_header(int nal_unit_type, int nuh_temporal_id_plus1);
+    bool pred_weight_table(hevc_slice_header_s *slh, int ChromaArrayType);
     uint32_t getNumRefLayerPics(const hevc_video_param_s* vps, hevc_slice_header_s *pSliceHeader);
     void getNumActiveRefLayerPics(const hevc_video_param_s *pVideoParamSet, hevc_slice_header_s *pSliceHeader);
     // DPB management
@@ -816,6 +874,9 @@ protected:
     int8_t            m_current_dpb_id;
     hevc_dpb_entry_s m_dpb[HEVC_DPB_SIZE];
     hevc_slice_header_s m_slh;
+    // Slice segments of the current picture, indexed like its slice stream markers, and their entry points
+    std::vector<VkParserHevcSliceSegment> m_sliceSegments;
+    std::vector<uint32_t> m_entryPointOffsets;
     VkSharedBaseObj<hevc_seq_param_s> m_active_sps[MAX_VPS_LAYERS];
     VkSharedBaseObj<hevc_pic_param_s> m_active_pps[MAX_VPS_LAYERS];
     VkSharedBaseObj<hevc_video_param_s> m_active_vps;
@@ -402,15 +402,24 @@ typedef struct _vp9_prob_update_s
     uint32_t            probsDecoded;
 } vp9_prob_update_s;
 
-typedef uint32_t VP9_BD_VALUE;
+// Reference frame slot
+typedef struct _vp9_ref_frame_s
+{
+    VkPicIf*            buffer;
+    uint32_t            width;
+    uint32_t            height;
+} vp9_ref_frame_s;
+
+typedef uint64_t VP9_BD_VALUE;
 
+// Boolean decoder: value holds the next bits of the partition MSB first,
+// count is the number of them past the top 8 (refilled a word at a time).
 typedef struct {
-    uint32_t buffer_end;
-    uint32_t buffer;
-    int32_t value;
+    const uint8_t* buffer;
+    const uint8_t* buffer_end;
+    VP9_BD_VALUE value;
     int32_t count;
     uint32_t range;
-    uint32_t pos;
 } vp9_reader;
 
 const vp9_tree_index vp9_coef_tree[ 22] =     /* corresponding _CONTEXT_NODEs */
@@ -468,18 +477,6 @@ const vp9_tree_index vp9_mv_fp_tree [2 * 4 - 2] = {
   -2, -3
 };
 
-static const uint32_t vp9dx_bitreader_norm[256] =
-{
-    0, 7, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4, 4, 4, 4, 4, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
-    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-};
-
 //*****************************************************************
 //vp9_entropymode.c
 typedef uint8_t vp9_prob;
@@ -1462,87 +1459,107 @@ static const uint8_t vp9_kf_default_bmode_probs[VP9_INTRA_MODES]
 class VulkanVP9Decoder : public VulkanVideoDecoder
 {
 protected:
+    enum { MAX_SUPERFRAME_FRAMES = 8 };     // Frames in a superframe index
+
     vp9_reader                      reader;
     nvdec_vp9EntropyProbs_t         m_EntropyLast[FRAME_CONTEXTS];
     nvdec_vp9AdaptiveEntropyProbs_t m_PrevCtx;
-    const unsigned char*            m_pCompressedHeader;
+    nvdec_vp9EntropyProbs_t         m_EntropyCurr;      // Probabilities of the current frame
+    vp9_prob_update_s               m_ProbSetup;
+    VkParserVp9PictureData          m_PicData;          // Uncompressed header, the loop filter deltas and segmentation persist
+    vp9_ref_frame_s                 m_pBuffers[NUM_REF_FRAMES];
+    VkPicIf*                        m_pCurrPic;
+    uint32_t                        m_colorRange;
+    uint32_t                        m_renderWidth;
+    uint32_t                        m_renderHeight;
+    uint32_t                        m_lastWidth;
+    uint32_t                        m_lastHeight;
+    bool                            m_showExistingFrame;
+    uint32_t                        m_frameToShow;
 
     void vp9_init_mbmode_probs(vp9_prob_update_s *pProbSetup);
     vp9_prob weighted_prob(int32_t prob1, int32_t prob2, int32_t factor);
     vp9_prob clip_prob(uint32_t p);
     vp9_prob get_prob(uint32_t num, uint32_t den);
     vp9_prob get_binary_prob(uint32_t n0, uint32_t n1);
-    uint32_t convert_distribution(uint32_t i,
-                            const vp9_tree_index * tree,
-                            uint8_t probs[],
-                            uint32_t branch_ct[][2],
-                            const uint32_t num_events[],
-                            uint32_t tok0_offset);
-    void vp9_tree_probs_from_distribution(const vp9_tree_index* tree,
-                                        uint8_t probs          [ /* n-1 */ ],
-                                        uint32_t branch_ct       [ /* n-1 */ ] [2],
-                                        const uint32_t num_events[ /* n */ ],
-                                        uint32_t tok0_offset);
+    vp9_prob merge_prob(vp9_prob pre_prob, const uint32_t ct[2], const uint8_t* update_factor, uint32_t count_sat);
+    void tree_branch_counts(const vp9_tree_index* tree, uint32_t num_nodes,
+                            const uint32_t num_events[], uint32_t branch_ct[][2]);
     void update_coef_probs(uint8_t dst_coef_probs[VP9_BLOCK_TYPES][VP9_REF_TYPES][VP9_COEF_BANDS][VP9_PREV_COEF_CONTEXTS][ENTROPY_NODES_PART1],
                         uint8_t pre_coef_probs[VP9_BLOCK_TYPES][VP9_REF_TYPES][VP9_COEF_BANDS][VP9_PREV_COEF_CONTEXTS][ENTROPY_NODES_PART1],
                         uint32_t coef_counts[VP9_BLOCK_TYPES][VP9_REF_TYPES][VP9_COEF_BANDS][VP9_PREV_COEF_CONTEXTS][UNCONSTRAINED_NODES+1],
                         uint32_t (*eob_counts)[VP9_REF_TYPES][VP9_COEF_BANDS][VP9_PREV_COEF_CONTEXTS],
-                        int32_t count_sat, int32_t update_factor);
+                        const uint8_t* update_factor);
     void adaptCoefProbs(vp9_prob_update_s *pProbSetup);
-    int32_t update_mode_ct(vp9_prob pre_prob, vp9_prob prob, uint32_t branch_ct[2]);
-    int32_t update_mode_ct2(vp9_prob pre_prob, uint32_t branch_ct[2]);
     void update_mode_probs(int32_t n_modes,
                             const vp9_tree_index *tree, uint32_t *cnt,
                             vp9_prob *pre_probs, vp9_prob *pre_probsB,
-                            vp9_prob *dst_probs, vp9_prob *dst_probsB,
-                            uint32_t tok0_offset);
+                            vp9_prob *dst_probs, vp9_prob *dst_probsB);
     void tx_counts_to_branch_counts_32x32(uint32_t *tx_count_32x32p, uint32_t (*ct_32x32p)[2]);
     void tx_counts_to_branch_counts_16x16(uint32_t *tx_count_16x16p, uint32_t (*ct_16x16p)[2]);
     void tx_counts_to_branch_counts_8x8(uint32_t *tx_count_8x8p, uint32_t (*ct_8x8p)[2]);
     void adaptModeProbs(vp9_prob_update_s *pProbSetup);
     void adaptModeContext(vp9_prob_update_s *pProbSetup);
-    uint32_t adapt_probs(uint32_t i,
-                         const signed char* tree,
-                         vp9_prob this_probs[],
-                         const vp9_prob last_probs[],
-                         const uint32_t num_events[]);
+    void adapt_probs(int32_t n_events,
+                     const vp9_tree_index* tree,
+                     vp9_prob this_probs[],
+                     const vp9_prob last_probs[],
+                     const uint32_t num_events[]);
     void adapt_prob(vp9_prob *dest, vp9_prob prep, uint32_t ct[2]);
     void adaptNmvProbs(vp9_prob_update_s *pProbSetup);
 
 protected:
     void vp9_reader_fill();
-    int32_t vp9_reader_init (uint32_t size);
+    int32_t vp9_reader_init(const uint8_t* pBuffer, uint32_t size);
+    bool vp9_reader_has_error() const;
     int32_t vp9_read_bit();
     int32_t vp9_read(int32_t probability);
     int32_t vp9_read_literal(int32_t bits);
-    uint32_t ParseCompressedVP9();
-    int32_t get_unsigned_bits(uint32_t num_values);
-    uint32_t swGetBitsUnsignedMax( uint32_t maxValue);
     vp9_prob vp9hwdReadProbDiffUpdate(uint8_t oldp);
     int32_t vp9_inv_recenter_nonneg(int32_t v, int32_t m);
     int32_t inv_remap_prob(int32_t v, int32_t m);
-    int32_t merge_index(int32_t v, int32_t n, int32_t modulus);
-    uint32_t BoolDecodeUniform(uint32_t n);
-    uint32_t vp9hwdDecodeSubExp(uint32_t k, uint32_t num_syms);
+    uint32_t vp9hwdDecodeTermSubExp();
     uint32_t vp9hwdDecodeCoeffUpdate(uint8_t probCoeffs[VP9_BLOCK_TYPES][VP9_REF_TYPES][VP9_COEF_BANDS][VP9_PREV_COEF_CONTEXTS][ENTROPY_NODES_PART1]);
     uint32_t vp9hwdDecodeMvUpdate(vp9_prob_update_s *pProbSetup);
     void update_nmv(vp9_prob *const p, const vp9_prob upd_p);
 
+    // Frame parsing
+    static uint32_t ParseSuperframeIndex(const uint8_t* pData, uint32_t size, uint32_t frameSizes[MAX_SUPERFRAME_FRAMES]);
+    bool ParseFrame(const uint8_t* pFrame, uint32_t frameSize);
+    bool ParseUncompressedHeader();
+    bool ParseFrameSyncCode();
+    bool ParseColorConfig();
+    void ParseFrameSize();
+    void ParseRenderSize();
+    bool ParseFrameSizeWithRefs();
+    void ParseLoopFilterParams();
+    void ParseQuantizationParams();
+    int32_t ReadDeltaQ();
+    void ParseSegmentationParams();
+    void ParseTileInfo();
+    void SetupPastIndependence();
+    bool end_of_picture(uint32_t frameSize);
+    void UpdateFramePointers(VkPicIf* currentPicture);
+    void AddBuffertoDispQueue(VkPicIf* pDispPic);
+
 public:
     VulkanVP9Decoder(VkVideoCodecOperationFlagBitsKHR std);
+    virtual ~VulkanVP9Decoder();
+
     void ResetProbs(vp9_prob_update_s *pProbSetup);
     void GetProbs(vp9_prob_update_s *pProbSetup);
     uint32_t UpdateForwardProbability(vp9_prob_update_s *pProbSetup, const unsigned char* pCompressed_Header);
     void UpdateBackwardProbability(vp9_prob_update_s *pProbSetup);
 
-    // TODO: Need to implement these functions.
-    bool                    IsPictureBoundary(int32_t) { return true; };
-    int32_t                 ParseNalUnit() { return NALU_UNKNOWN; };
-    bool                    DecodePicture(VkParserPictureData *) { return false; };
-    void                    InitParser() {}
-    bool                    BeginPicture(VkParserPictureData *) { return false; }
-    void                    CreatePrivateContext() {}
-    void                    FreeContext() {}
+    bool                    ParseByteStream(const VkParserBitstreamPacket* pck, size_t* pParsedBytes) override;
+    bool                    IsPictureBoundary(int32_t) override { return true; };
+    int32_t                 ParseNalUnit() override { return NALU_UNKNOWN; };
+    void                    InitParser() override;
+    bool                    BeginPicture(VkParserPictureData* pnvpd) override;
+    void                    EndOfStream() override;
+    void                    CreatePrivateContext() override {}
+    void                    FreeContext() override {}
+    void                    GetCodecMemoryFootprint(VkParserMemoryFootprint *pFootprint) const override { pFootprint->parserSize += sizeof(*this); }
 };
 
 #endif // _VP9_PROBMANAGER_H_
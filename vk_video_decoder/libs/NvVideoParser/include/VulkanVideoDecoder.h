@@ -49,6 +49,8 @@ typedef struct NvVkPresentationInfo
 } NvVkPresentationInfo;
 
 
+class StartCodeScanner;
+
 //
 // VulkanVideoDecoder is the base class for all decoders
 //
@@ -58,10 +60,13 @@ public:
     enum { MAX_SLICES = 8192 };             // Up to 8K slices per picture
     enum { MAX_DELAY = 32 };                // Maximum frame delay between decode & display
     enum { MAX_QUEUED_PTS = 16};            // Size of PTS queue
+    enum { MIN_PIPELINED_PACKET_SIZE = 128 * 1024 }; // Smaller packets keep the inline start code search
+    enum { MAX_PICTURE_METADATA = 64 };     // SEI messages / metadata OBUs reported per picture
     enum {
         NALU_DISCARD=0, // Discard this nal unit
         NALU_SLICE,     // This NALU contains picture data (keep)
         NALU_UNKNOWN,   // This NALU type is not supported (callback client)
+        NALU_METADATA,  // This NALU contains metadata reported with a picture (keep, not a slice)
     };
     typedef enum {
         NV_NO_ERROR = 0,         // No error detected
@@ -74,6 +79,8 @@ protected:
     uint32_t                         m_264SvcEnabled:1;    // enabled NVCS_H264_SVC
     uint32_t                         m_outOfBandPictureParameters:1; // Enable out of band parameters cb
     uint32_t                         m_initSequenceIsCalled:1;
+    uint32_t                         m_bPictureMetadata:1; // Report the SEI messages / metadata OBUs of each picture
+    uint32_t                         m_bCallbackTimings:1; // Time the client callbacks in m_telemetry
     VkParserVideoDecodeClient *m_pClient;  // Interface to decoder client
     uint32_t m_defaultMinBufferSize;       // Minimum default buffer size that the parser is going to allocate
     uint32_t m_bufferOffsetAlignment;      // Minimum buffer offset alignment of the bitstream data for each frame
@@ -113,6 +120,15 @@ protected:
     int32_t m_lCheckPTS;                        // Run the m_bFilterTimestamps for the first few framew to look for out of order PTS
     NVCodecErrors m_eError;
     SIMD_ISA m_NextStartCode;
+    StartCodeScanner* m_pStartCodeScanner;      // Start code scanning thread, only set in the pipelined parsing mode
+    // Metadata of the current picture, followed by the m_numPendingMetadata
+    // entries received ahead of the next one (prefix SEI after the slices of
+    // the current picture). Their NAL units start at m_pendingMetadataOffset.
+    VkParserMetadata m_metadata[MAX_PICTURE_METADATA];
+    uint32_t m_numMetadata;
+    uint32_t m_numPendingMetadata;
+    int64_t m_pendingMetadataOffset;
+    VkParserTelemetry m_telemetry;
 public:
     VulkanVideoDecoder(VkVideoCodecOperationFlagBitsKHR std);
     virtual ~VulkanVideoDecoder();
@@ -154,21 +170,25 @@ public:
     bool ParseByteStreamNEON(const VkParserBitstreamPacket* pck, size_t *pParsedBytes);
 #endif
     virtual bool GetDisplayMasteringInfo(VkParserDisplayMasteringInfo *) { return false; }
+    virtual bool GetMemoryFootprint(VkParserMemoryFootprint *pFootprint);
+    virtual bool GetTelemetry(VkParserTelemetry *pTelemetry);
 
 protected:
     virtual void CreatePrivateContext() = 0;                   // Implemented by derived classes
     virtual void InitParser() = 0;                             // Initialize codec-specific parser state
     virtual bool IsPictureBoundary(int32_t rbsp_size) = 0;     // Returns true if the current NAL unit belongs to a new picture
-    virtual int32_t  ParseNalUnit() = 0;                       // Must return NALU_DISCARD or NALU_SLICE
+    virtual int32_t  ParseNalUnit() = 0;                       // Must return NALU_DISCARD, NALU_SLICE, NALU_UNKNOWN or NALU_METADATA
     virtual bool BeginPicture(VkParserPictureData *pnvpd) = 0; // Fills in picture data. Return true if picture should be sent to client
     virtual void EndPicture() {}                               // Called after a picture has been decoded
     virtual void EndOfStream() {}                              // Called to reset parser
     virtual void FreeContext() = 0;
+    virtual void GetCodecMemoryFootprint(VkParserMemoryFootprint *pFootprint) const = 0; // Adds the derived class object and what it allocates
 
 protected:
     // Byte stream parsing
+    // bitBfr carries the last bytes scanned, so that a start code split across calls is found
     template<SIMD_ISA T>
-    size_t next_start_code(const uint8_t *pdatain, size_t datasize, bool& found_start_code);
+    static size_t next_start_code(const uint8_t *pdatain, size_t datasize, uint32_t& bitBfr, bool& found_start_code);
     void nal_unit();
     void init_dbits();
     int32_t available_bits() {
@@ -179,6 +199,7 @@ protected:
                                return (int32_t)(m_nalu.end_offset - m_nalu.get_offset) * 8 + (32 - m_nalu.get_bfroffs); }
     int32_t consumed_bits() { assert((m_nalu.get_offset - m_nalu.start_offset - m_nalu.get_emulcnt) < std::numeric_limits<int32_t>::max());
                           return (int32_t)(m_nalu.get_offset - m_nalu.start_offset - m_nalu.get_emulcnt) * 8 - (32 - m_nalu.get_bfroffs); }
+    int64_t consumed_bytes_offset(); // offset in the bitstream buffer of the first byte not consumed (byte aligned)
     uint32_t next_bits(uint32_t n) { return (m_nalu.get_bfr << m_nalu.get_bfroffs) >> (32 - n); } // NOTE: n must be in the [1..25] range
     void skip_bits(uint32_t n);  // advance bitstream position
     uint32_t u(uint32_t n);   // return next n bits, advance bitstream position
@@ -201,6 +222,18 @@ protected:
     bool more_rbsp_data();
     bool resizeBitstreamBuffer(VkDeviceSize nExtrabytes);
     VkDeviceSize swapBitstreamBuffer(VkDeviceSize copyCurrBuffOffset, VkDeviceSize copyCurrBuffSize);
+    // The data of the current picture ends before the metadata NAL units of the next one
+    int64_t GetPictureDataEnd() const { return (m_numPendingMetadata > 0) ? m_pendingMetadataOffset : m_nalu.start_offset; }
+    void StartNextPictureBuffer();
+    // Picture metadata
+    bool AddSeiMetadata(uint32_t nalHeaderBytes, bool suffix);  // Returns true if the SEI NAL unit must be kept
+    bool AddMetadata(const VkParserMetadata& metadata, bool nextPicture);
+    void ResetMetadata() { m_numMetadata = 0; m_numPendingMetadata = 0; m_pendingMetadataOffset = 0; }
+    static VkParserMetadataType GetItuTT35MetadataType(const uint8_t* pData, size_t size);
+    // Client callbacks, timed in m_telemetry
+    int32_t ClientBeginSequence(const VkParserSequenceInfo *pnvsi);
+    bool ClientDecodePicture(VkParserPictureData *pnvpd);
+    void ClientDisplayPicture(VkPicIf *pPicBuf, int64_t llPTS);
 };
 
 void nvParserLog(const char* format, ...);
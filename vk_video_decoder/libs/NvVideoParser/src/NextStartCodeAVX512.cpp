@@ -11,7 +11,7 @@ bool VulkanVideoDecoder::ParseByteStreamAVX512(const VkParserBitstreamPacket* pc
 }
 
 template<>
-size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::AVX512>(const uint8_t *pdatain, size_t datasize, bool& found_start_code)
+size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::AVX512>(const uint8_t *pdatain, size_t datasize, uint32_t& bitBfr, bool& found_start_code)
 {
     size_t i = 0;
     size_t datasize128 = (datasize >> 7) << 7;
@@ -20,7 +20,7 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::AVX512>(const uint8_t *pdat
         const __m512i v1 = _mm512_set1_epi8(1);
         const __m512i v254 = _mm512_set1_epi8(-2);
         __m512i vdata = _mm512_loadu_si512((const void*)pdatain);
-        __m512i vBfr = _mm512_set1_epi16(((m_BitBfr << 8) & 0xFF00) | ((m_BitBfr >> 8) & 0xFF));
+        __m512i vBfr = _mm512_set1_epi16(((bitBfr << 8) & 0xFF00) | ((bitBfr >> 8) & 0xFF));
         __m512i vdata_alignr48b_init = _mm512_alignr_epi32(vdata, vBfr, 12);
         __m512i vdata_prev1 = _mm512_alignr_epi8(vdata, vdata_alignr48b_init, 15);
         __m512i vdata_prev2 = _mm512_alignr_epi8(vdata, vdata_alignr48b_init, 14);
@@ -40,7 +40,7 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::AVX512>(const uint8_t *pdat
                 {
                     const int offset = count_trailing_zeros(resmask);
                     found_start_code = true;
-                    m_BitBfr =  1;
+                    bitBfr =  1;
                     return offset + i + c + 1;
                 }
                 // hotspot begin
@@ -52,10 +52,10 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::AVX512>(const uint8_t *pdat
                 // hotspot end
             }
         } // main processing loop end
-        m_BitBfr = (pdatain[i-2] << 8) | pdatain[i-1];
+        bitBfr = (pdatain[i-2] << 8) | pdatain[i-1];
     }
     // process a tail (rest):
-    uint32_t bfr = m_BitBfr;
+    uint32_t bfr = bitBfr;
     do
     {
         bfr = (bfr << 8) | pdatain[i++];
@@ -63,7 +63,7 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::AVX512>(const uint8_t *pdat
             break;
         }
     } while (i < datasize);
-    m_BitBfr = bfr;
+    bitBfr = bfr;
     found_start_code = ((bfr & 0x00ffffff) == 1);
     return i;
 }
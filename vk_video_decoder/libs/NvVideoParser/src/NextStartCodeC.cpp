@@ -9,9 +9,9 @@ bool VulkanVideoDecoder::ParseByteStreamC(const VkParserBitstreamPacket* pck, si
 }
 
 template<>
-size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::NOSIMD>(const uint8_t *pdatain, size_t datasize, bool& found_start_code)
+size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::NOSIMD>(const uint8_t *pdatain, size_t datasize, uint32_t& bitBfr, bool& found_start_code)
 {
-    uint32_t bfr = m_BitBfr;
+    uint32_t bfr = bitBfr;
     size_t i = 0;
     do
     {
@@ -20,7 +20,7 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::NOSIMD>(const uint8_t *pdat
             break;
         }
     } while (i < datasize);
-    m_BitBfr = bfr;
+    bitBfr = bfr;
     found_start_code = ((bfr & 0x00ffffff) == 1);
     return i;
 }
\ No newline at end of file
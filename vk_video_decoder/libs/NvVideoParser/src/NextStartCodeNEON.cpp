@@ -11,7 +11,7 @@ bool VulkanVideoDecoder::ParseByteStreamNEON(const VkParserBitstreamPacket* pck,
 }
 
 template<>
-size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::NEON>(const uint8_t *pdatain, size_t datasize, bool& found_start_code)
+size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::NEON>(const uint8_t *pdatain, size_t datasize, uint32_t& bitBfr, bool& found_start_code)
 {
     size_t i = 0;
     size_t datasize32 = (datasize >> 5) << 5;
@@ -20,7 +20,7 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::NEON>(const uint8_t *pdatai
         const uint8x16_t v0 = vdupq_n_u8(0);
         const uint8x16_t v1 = vdupq_n_u8(1);
         uint8x16_t vdata = vld1q_u8(pdatain);
-        uint8x16_t vBfr = vreinterpretq_u8_u16(vdupq_n_u16(((m_BitBfr << 8) & 0xFF00) | ((m_BitBfr >> 8) & 0xFF)));
+        uint8x16_t vBfr = vreinterpretq_u8_u16(vdupq_n_u16(((bitBfr << 8) & 0xFF00) | ((bitBfr >> 8) & 0xFF)));
         uint8x16_t vdata_prev1 = vextq_u8(vBfr, vdata, 15);
         uint8x16_t vdata_prev2 = vextq_u8(vBfr, vdata, 14);
         uint8_t idx0n[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
@@ -50,7 +50,7 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::NEON>(const uint8_t *pdatai
                     const uint8_t offset = vget_lane_u8(vpmin_u8(minval, minval), 0);
 #endif
                     found_start_code = true;
-                    m_BitBfr =  1;
+                    bitBfr =  1;
                     return (size_t)offset + i + c + 1;
                 }
                 // hotspot begin
@@ -61,10 +61,10 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::NEON>(const uint8_t *pdatai
                 // hotspot end
             }
         } // main processing loop end
-        m_BitBfr = (pdatain[i-2] << 8) | pdatain[i-1];
+        bitBfr = (pdatain[i-2] << 8) | pdatain[i-1];
     }
     // process a tail (rest):
-    uint32_t bfr = m_BitBfr;
+    uint32_t bfr = bitBfr;
     do
     {
         bfr = (bfr << 8) | pdatain[i++];
@@ -72,7 +72,7 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::NEON>(const uint8_t *pdatai
             break;
         }
     } while (i < datasize);
-    m_BitBfr = bfr;
+    bitBfr = bfr;
     found_start_code = ((bfr & 0x00ffffff) == 1);
     return i;
 }
@@ -11,7 +11,7 @@ bool VulkanVideoDecoder::ParseByteStreamSSSE3(const VkParserBitstreamPacket* pck
 }
 
 template<>
-size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::SSSE3>(const uint8_t *pdatain, size_t datasize, bool& found_start_code)
+size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::SSSE3>(const uint8_t *pdatain, size_t datasize, uint32_t& bitBfr, bool& found_start_code)
 {
     size_t i = 0;
     size_t datasize32 = (datasize >> 5) << 5;
@@ -19,7 +19,7 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::SSSE3>(const uint8_t *pdata
     {
         const __m128i v1 = _mm_set1_epi8(1);
         __m128i vdata = _mm_loadu_si128((const __m128i*)pdatain);
-        __m128i vBfr = _mm_set1_epi16(((m_BitBfr << 8) & 0xFF00) | ((m_BitBfr >> 8) & 0xFF));
+        __m128i vBfr = _mm_set1_epi16(((bitBfr << 8) & 0xFF00) | ((bitBfr >> 8) & 0xFF));
         __m128i vdata_prev1 = _mm_alignr_epi8(vdata, vBfr, 15);
         __m128i vdata_prev2 = _mm_alignr_epi8(vdata, vBfr, 14);
         for ( ; i < datasize32 - 32; i += 32)
@@ -35,7 +35,7 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::SSSE3>(const uint8_t *pdata
                 {
                     const int offset = count_trailing_zeros((uint64_t) (resmask & 0xFFFFFFFF));
                     found_start_code = true;
-                    m_BitBfr =  1;
+                    bitBfr =  1;
                     return offset + i + c + 1;
                 }
                 // hotspot begin
@@ -46,10 +46,10 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::SSSE3>(const uint8_t *pdata
                 // hotspot end
             }
         } // main processing loop end
-        m_BitBfr = (pdatain[i-2] << 8) | pdatain[i-1];
+        bitBfr = (pdatain[i-2] << 8) | pdatain[i-1];
     }
     // process a tail (rest):
-    uint32_t bfr = m_BitBfr;
+    uint32_t bfr = bitBfr;
     do
     {
         bfr = (bfr << 8) | pdatain[i++];
@@ -57,7 +57,7 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::SSSE3>(const uint8_t *pdata
             break;
         }
     } while (i < datasize);
-    m_BitBfr = bfr;
+    bitBfr = bfr;
     found_start_code = ((bfr & 0x00ffffff) == 1);
     return i;
 }
@@ -0,0 +1,197 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <assert.h>
+#include <algorithm>
+#include "StartCodeScanner.h"
+
+StartCodeScanner::StartCodeScanner()
+    : m_thread()
+    , m_mutex()
+    , m_producerCond()
+    , m_consumerCond()
+    , m_pfnNextStartCode()
+    , m_pData()
+    , m_dataSize()
+    , m_bitBfr()
+    , m_busy(false)
+    , m_abort(false)
+    , m_exit(false)
+    , m_scannedBytes()
+    , m_queue(MAX_QUEUED_START_CODES)
+    , m_queueRead()
+    , m_queueCount()
+    , m_batch()
+    , m_batchPos()
+    , m_localScanned()
+{
+    m_batch.reserve(MAX_QUEUED_START_CODES);
+}
+
+StartCodeScanner::~StartCodeScanner()
+{
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_abort = true;
+            m_exit = true;
+        }
+        m_producerCond.notify_one();
+        m_thread.join();
+    }
+}
+
+void StartCodeScanner::Start(PfnNextStartCode pfnNextStartCode, const uint8_t *pData, size_t dataSize, uint32_t bitBfr)
+{
+    // The worker is only created on the first packet large enough to use it.
+    if (!m_thread.joinable()) {
+        m_thread = std::thread(&StartCodeScanner::Run, this);
+    }
+
+    m_batch.clear();
+    m_batchPos = 0;
+    m_localScanned = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        assert(!m_busy);
+        m_pfnNextStartCode = pfnNextStartCode;
+        m_pData = pData;
+        m_dataSize = dataSize;
+        m_bitBfr = bitBfr;
+        m_scannedBytes = 0;
+        m_queueRead = 0;
+        m_queueCount = 0;
+        m_abort = false;
+        m_busy = true;
+    }
+    m_producerCond.notify_one();
+}
+
+size_t StartCodeScanner::Next(size_t offset, size_t datasize, bool& found_start_code)
+{
+    const size_t end = offset + datasize;
+    for (;;) {
+        if (m_batchPos < m_batch.size()) {
+            const size_t startCodeEnd = m_batch[m_batchPos];
+            assert(startCodeEnd > offset);
+            found_start_code = (startCodeEnd <= end);
+            if (!found_start_code) {
+                return datasize;
+            }
+            m_batchPos++;
+            return startCodeEnd - offset;
+        }
+        if (m_localScanned >= end) {
+            // No start code up to the end of the requested range
+            found_start_code = false;
+            return datasize;
+        }
+
+        // Wait for the worker to publish more results
+        m_batch.clear();
+        m_batchPos = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_consumerCond.wait(lock, [this]{ return (m_queueCount > 0) || (m_scannedBytes > m_localScanned); });
+            // Read the scanned size first, all the start codes before it are in the queue
+            m_localScanned = m_scannedBytes;
+            while (m_queueCount > 0) {
+                m_batch.push_back(m_queue[m_queueRead]);
+                m_queueRead = (m_queueRead + 1) % m_queue.size();
+                m_queueCount--;
+            }
+        }
+        m_producerCond.notify_one();
+    }
+}
+
+void StartCodeScanner::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_consumerCond.wait(lock, [this]{ return !m_busy; });
+}
+
+uint32_t StartCodeScanner::Finish()
+{
+    WaitIdle();
+    return m_bitBfr;
+}
+
+void StartCodeScanner::Abort()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_abort = true;
+    }
+    m_producerCond.notify_one();
+    WaitIdle();
+}
+
+void StartCodeScanner::Run()
+{
+    std::vector<size_t> segmentStartCodes;
+    segmentStartCodes.reserve(MAX_QUEUED_START_CODES);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_producerCond.wait(lock, [this]{ return m_exit || m_busy; });
+        if (m_exit) {
+            break;
+        }
+        const PfnNextStartCode pfnNextStartCode = m_pfnNextStartCode;
+        const uint8_t* pData = m_pData;
+        const size_t dataSize = m_dataSize;
+        uint32_t bitBfr = m_bitBfr;
+        size_t pos = 0;
+
+        while ((pos < dataSize) && !m_abort) {
+            lock.unlock();
+            const size_t segmentEnd = std::min<size_t>(dataSize, pos + SEGMENT_SIZE);
+            segmentStartCodes.clear();
+            while (pos < segmentEnd) {
+                bool found_start_code = false;
+                pos += pfnNextStartCode(pData + pos, segmentEnd - pos, bitBfr, found_start_code);
+                if (found_start_code) {
+                    segmentStartCodes.push_back(pos);
+                }
+            }
+            lock.lock();
+
+            // Queue the start codes of the segment, then publish the segment as scanned
+            size_t i = 0;
+            while ((i < segmentStartCodes.size()) && !m_abort) {
+                m_producerCond.wait(lock, [this]{ return m_abort || (m_queueCount < m_queue.size()); });
+                bool queued = false;
+                while ((i < segmentStartCodes.size()) && (m_queueCount < m_queue.size())) {
+                    m_queue[(m_queueRead + m_queueCount) % m_queue.size()] = segmentStartCodes[i++];
+                    m_queueCount++;
+                    queued = true;
+                }
+                if (queued) {
+                    m_consumerCond.notify_one();
+                }
+            }
+            if (!m_abort) {
+                m_scannedBytes = pos;
+                m_consumerCond.notify_one();
+            }
+        }
+
+        m_bitBfr = bitBfr;
+        m_busy = false;
+        m_consumerCond.notify_one();
+    }
+}
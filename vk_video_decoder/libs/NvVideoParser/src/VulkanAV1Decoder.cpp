@@ -217,6 +217,8 @@ bool VulkanAV1Decoder::end_of_picture(uint32_t frameSize)
     m_bSPSChanged = false;
 
     m_pVkPictureData->firstSliceIndex = 0;
+    m_pVkPictureData->pMetadata = (m_numMetadata > 0) ? m_metadata : nullptr;
+    m_pVkPictureData->numMetadata = m_numMetadata;
     memcpy(&m_pVkPictureData->CodecSpecific.av1, &m_PicData, sizeof(m_PicData));
     m_pVkPictureData->intra_pic_flag = (pStd->frame_type == STD_VIDEO_AV1_FRAME_TYPE_KEY);
 
@@ -228,7 +230,7 @@ bool VulkanAV1Decoder::end_of_picture(uint32_t frameSize)
     bool bSkipped = false;
     if (m_pClient != nullptr) {
         // Notify client
-        if (!m_pClient->DecodePicture(m_pVkPictureData)) {
+        if (!ClientDecodePicture(m_pVkPictureData)) {
             bSkipped = true;
             // WARNING: skipped decoding current picture;
         } else {
@@ -238,6 +240,9 @@ bool VulkanAV1Decoder::end_of_picture(uint32_t frameSize)
         // "WARNING: no valid render target for current picture
     }
 
+    // The following frames of the temporal unit get the metadata OBUs that precede them
+    ResetMetadata();
+
     // decode_frame_wrapup
     UpdateFramePointers(m_pCurrPic);
     if (m_PicData.showFrame && !bSkipped) {
@@ -2294,6 +2299,51 @@ bool VulkanAV1Decoder::ParseObuTileGroup(const AV1ObuHeader& hdr)
     return (tg_end == num_tiles - 1);
 }
 
+// Records a metadata OBU (5.8.1), the OBU is in the bitstream buffer at m_nalu.start_offset
+void VulkanAV1Decoder::AddObuMetadata(const uint8_t* pPayload, uint32_t payloadSize)
+{
+    if (!m_bPictureMetadata) {
+        return;
+    }
+
+    uint32_t metadataType = 0, metadataTypeSize = 0;
+    if (!ReadObuSize(pPayload, payloadSize, &metadataType, &metadataTypeSize)) {
+        return;
+    }
+
+    VkParserMetadata metadata = VkParserMetadata();
+    metadata.payloadType = metadataType;
+    assert((m_nalu.start_offset + metadataTypeSize) <= UINT32_MAX);
+    metadata.offset = (uint32_t)m_nalu.start_offset + metadataTypeSize;
+    metadata.size = payloadSize - metadataTypeSize;  // Includes the trailing bits
+    metadata.payloadSize = metadata.size;
+
+    switch (metadataType) {
+    case 1:     // METADATA_TYPE_HDR_CLL
+        metadata.type = VK_PARSER_METADATA_TYPE_CONTENT_LIGHT_LEVEL;
+        break;
+    case 2:     // METADATA_TYPE_HDR_MDCV
+        metadata.type = VK_PARSER_METADATA_TYPE_MASTERING_DISPLAY;
+        break;
+    case 4:     // METADATA_TYPE_ITUT_T35
+        metadata.type = GetItuTT35MetadataType(pPayload + metadataTypeSize, metadata.size);
+        break;
+    case 3:     // METADATA_TYPE_SCALABILITY
+        metadata.type = VK_PARSER_METADATA_TYPE_SCALABILITY;
+        break;
+    case 5:     // METADATA_TYPE_TIMECODE
+        metadata.type = VK_PARSER_METADATA_TYPE_TIMECODE;
+        break;
+    default:
+        // METADATA_TYPE_UNREGISTERED_USER_PRIVATE_6..31, the others are reserved
+        metadata.type = ((metadataType >= 6) && (metadataType <= 31)) ? VK_PARSER_METADATA_TYPE_USER_PRIVATE :
+                                                                         VK_PARSER_METADATA_TYPE_UNKNOWN;
+        break;
+    }
+
+    AddMetadata(metadata, false);
+}
+
 bool IsObuInCurrentOperatingPoint(int  current_operating_point, AV1ObuHeader *hdr) {
     if (current_operating_point == 0) return true;
     if (((current_operating_point >> hdr->temporal_id) & 0x1) &&
@@ -2324,6 +2374,7 @@ bool VulkanAV1Decoder::ParseOneFrame(const uint8_t*const pFrameStart, const int3
             // Error: Truncated frame data
             return false;
         }
+        m_telemetry.nalUnitTypes[hdr.type & 0xf]++;
 
         m_nalu.start_offset += hdr.header_size;
 
@@ -2381,9 +2432,12 @@ bool VulkanAV1Decoder::ParseOneFrame(const uint8_t*const pFrameStart, const int3
 
             break;
         }
+        case AV1_OBU_METADATA:
+            AddObuMetadata(pCurrOBU + hdr.header_size, hdr.payload_size);
+            break;
+
         case AV1_OBU_REDUNDANT_FRAME_HEADER:
         case AV1_OBU_PADDING:
-        case AV1_OBU_METADATA:
         default:
             break;
         }
@@ -2420,6 +2474,7 @@ bool VulkanAV1Decoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_
     }
 
     m_nCallbackEventCount = 0;
+    m_telemetry.bytesParsed += pck->nDataLength;
 
     // Handle discontinuity
     if (pck->bDiscontinuity) {
@@ -2452,7 +2507,9 @@ bool VulkanAV1Decoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_
         if (datasize > 0) {
             m_nalu.start_offset = 0;
             m_nalu.end_offset = frame_size;
+            ResetMetadata();
             memcpy(m_bitstreamData.GetBitstreamPtr(), pdataStart, frame_size);
+            m_telemetry.bytesCopied += frame_size;
             m_llNaluStartLocation = m_llFrameStartLocation = m_llParsedBytes; // TODO: NaluStart and FrameStart are always the same here
             m_llParsedBytes += frame_size;
 
@@ -67,7 +67,12 @@ VulkanH264Decoder::VulkanH264Decoder(VkVideoCodecOperationFlagBitsKHR std)
     m_prefix_nalu_valid(false),
     m_spsme(NULL),
     m_bUseMVC(false),
+    m_CurrFrmBaseViewPic(NULL),
+    m_pMvcData(NULL),
     m_bUseSVC(false),
+    m_pSvcData(NULL),
+    m_ds(NULL),
+    m_dd(NULL),
     m_slice_group_map()
 {
     memset(m_spsmes, 0, sizeof(m_spsmes));
@@ -83,6 +88,10 @@ VulkanH264Decoder::~VulkanH264Decoder()
         m_slice_group_map = nullptr;
     }
 
+    delete m_pSvcData;
+    m_pSvcData = NULL;
+    delete m_pMvcData;
+    m_pMvcData = NULL;
 }
 
 
@@ -97,6 +106,29 @@ void VulkanH264Decoder::FreeContext()
     m_pParserData = NULL;
 }
 
+void VulkanH264Decoder::GetCodecMemoryFootprint(VkParserMemoryFootprint *pFootprint) const
+{
+    pFootprint->parserSize += sizeof(*this) + (m_pParserData ? sizeof(H264ParserData) : 0);
+    if (m_pMvcData) {
+        pFootprint->onDemandSize += sizeof(H264MvcData);
+    }
+    if (m_pSvcData) {
+        pFootprint->onDemandSize += sizeof(H264SvcData);
+    }
+    if (m_slice_group_map) {
+        pFootprint->onDemandSize += MAX_NUM_PPS * sizeof(slice_group_map_s);
+    }
+    for (uint32_t i = 0; i < MAX_NUM_SPS; i++) {
+        pFootprint->parameterSetsSize += (m_spss[i] ? sizeof(seq_parameter_set_s) : 0) +
+                                         (m_spssvcs[i] ? sizeof(seq_parameter_set_s) : 0);
+        pFootprint->onDemandSize += (m_spss[i] ? m_spss[i]->offset_for_ref_frame.capacity() * sizeof(int32_t) : 0) +
+                                    (m_spssvcs[i] ? m_spssvcs[i]->offset_for_ref_frame.capacity() * sizeof(int32_t) : 0);
+    }
+    for (uint32_t i = 0; i < MAX_NUM_PPS; i++) {
+        pFootprint->parameterSetsSize += m_ppss[i] ? sizeof(pic_parameter_set_s) : 0;
+    }
+}
+
 void VulkanH264Decoder::InitParser()
 {
     uint32_t decoder_caps;
@@ -132,12 +164,12 @@ void VulkanH264Decoder::EndOfStream()
             }
         }
     }
-    else
+    else if (m_pSvcData)
     {
         for (int did = 0; did < 8; did++)
         {
-            dependency_state_s *ds = &m_dependency_state[did];
-            dependency_data_s *dd = &m_dependency_data[did];
+            dependency_state_s *ds = &m_pSvcData->dependency_state[did];
+            dependency_data_s *dd = &m_pSvcData->dependency_data[did];
             if (dd->used)
             {
                 flush_dpb_SVC(ds);
@@ -183,18 +215,22 @@ void VulkanH264Decoder::EndOfStream()
     }
 
     // svc
-    for (uint32_t i = 0; i < sizeof (m_layer_data) / sizeof (m_layer_data[0]); i++) {
-        m_layer_data[i] = layer_data_s();
-    }
-
     for (uint32_t i = 0; i < sizeof (m_spssvcs) / sizeof (m_spssvcs[0]); i++) {
         m_spssvcs[i] = nullptr;
     }
 
     memset(&m_slh_prev, 0, sizeof(m_slh_prev));
     memset(&m_prefix_nal_unit_svc, 0, sizeof(m_prefix_nal_unit_svc));
-    memset(&m_dependency_data, 0, sizeof(m_dependency_data));
-    memset(&m_dependency_state, 0, sizeof(m_dependency_state));
+    if (m_pSvcData)
+    {
+        ResetSvcLayerData();
+        for (size_t i = 0; i < ARRAYSIZE(m_pSvcData->dependency_data); i++) {
+            m_pSvcData->dependency_data[i] = dependency_data_s();
+        }
+        memset(&m_pSvcData->dependency_state, 0, sizeof(m_pSvcData->dependency_state));
+    }
+    m_ds = NULL;
+    m_dd = NULL;
 }
 
 
@@ -459,17 +495,22 @@ bool VulkanH264Decoder::init_sequence_svc(const seq_parameter_set_s* sps)
 
 bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
 {
+    if (!m_pSvcData) {
+        nvParserLog("Access unit is empty\n");
+        return false;
+    }
+
     {
-        // Reset m_dependency_data array
-        for (size_t i = 0; i < sizeof(m_dependency_data) / sizeof(m_dependency_data[0]); i++) {
-            m_dependency_data[i] = dependency_data_s();
+        // Reset the dependency_data array
+        for (size_t i = 0; i < ARRAYSIZE(m_pSvcData->dependency_data); i++) {
+            m_pSvcData->dependency_data[i] = dependency_data_s();
         }
     }
 
     // determine target layer
     int32_t DQIdMax = 0;
     for (DQIdMax = 127; DQIdMax >= 0; DQIdMax--) {
-        if (m_layer_data[DQIdMax].available)
+        if (m_pSvcData->layer_data[DQIdMax].available)
             break;
     }
 
@@ -481,42 +522,42 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
     m_iDQIdMax = DQIdMax;
     int dependencyIdMax = DQIdMax >> 4; // dependency_id of target dependency representation
 
-    if (!init_sequence_svc(m_layer_data[DQIdMax].sps))
+    if (!init_sequence_svc(m_pSvcData->layer_data[DQIdMax].sps))
         return false;
 
     // layer and dependency representations required for decoding (G.8.1.1)
     int dqid_next = -1;
-    for (int dqid = DQIdMax; dqid >= 0; dqid = m_layer_data[dqid].MaxRefLayerDQId)
+    for (int dqid = DQIdMax; dqid >= 0; dqid = m_pSvcData->layer_data[dqid].MaxRefLayerDQId)
     {
-        nvParserLog("  DQId = %d (0x%x) max:%d\n", dqid, dqid, m_layer_data[dqid].MaxRefLayerDQId);
+        nvParserLog("  DQId = %d (0x%x) max:%d\n", dqid, dqid, m_pSvcData->layer_data[dqid].MaxRefLayerDQId);
         if (dqid_next >= 0 && !(dqid < dqid_next)) // has to be strictly monotonically decreasing (prevents infinite loop)
         {
             nvParserLog("ref_layer_dq_id > DQId - 1");
             return false;
         }
-        if (!m_layer_data[dqid].available)
+        if (!m_pSvcData->layer_data[dqid].available)
         {
             nvParserLog("invalid ref_layer_dq_id: %d, reference layer representation not available", dqid);
             return false;
         }
 
-        m_dependency_data[dqid >> 4].used = 1;
-        m_layer_data[dqid].used = 1;
-        m_layer_data[dqid].dqid_next = dqid_next;
+        m_pSvcData->dependency_data[dqid >> 4].used = 1;
+        m_pSvcData->layer_data[dqid].used = 1;
+        m_pSvcData->layer_data[dqid].dqid_next = dqid_next;
         dqid_next = dqid;
     }
 
     for (int did = 0; did <= dependencyIdMax; did++)
     {
-        m_dd = &m_dependency_data[did];
+        m_dd = &m_pSvcData->dependency_data[did];
         if (m_dd->used)
         {
-            if (!m_layer_data[16 * did + 0].used) {
+            if (!m_pSvcData->layer_data[16 * did + 0].used) {
                 nvParserLog("quality_id == 0 not used\n");
             }
-            m_dd->sps = m_layer_data[16 * did + 0].sps;
-            m_dd->sps_svc = m_layer_data[16 * did + 0].sps->svc;
-            m_dd->slh = m_layer_data[16 * did + 0].slh;
+            m_dd->sps = m_pSvcData->layer_data[16 * did + 0].sps;
+            m_dd->sps_svc = m_pSvcData->layer_data[16 * did + 0].sps->svc;
+            m_dd->slh = m_pSvcData->layer_data[16 * did + 0].slh;
             m_dd->MaxDpbFrames = derive_MaxDpbFrames(m_dd->sps);
             if (did == dependencyIdMax) {
                 m_dd->MaxDpbFrames = std::min<int32_t>(m_MaxFrameBuffers, m_dd->MaxDpbFrames);
@@ -525,7 +566,7 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
                 nvParserLog("max_num_ref_frames > MaxDpbFrames");
             }
             if (m_dd->slh.IdrPicFlag) {
-                flush_dpb_SVC(&m_dependency_state[did]);
+                flush_dpb_SVC(&m_pSvcData->dependency_state[did]);
             }
         }
     }
@@ -535,8 +576,8 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
 
     for (int did = 0; did <= dependencyIdMax; did++)
     {
-        m_ds = &m_dependency_state[did];
-        m_dd = &m_dependency_data[did];
+        m_ds = &m_pSvcData->dependency_state[did];
+        m_dd = &m_pSvcData->dependency_data[did];
         if (m_dd->used)
         {
             gaps_in_frame_num_SVC();
@@ -549,7 +590,7 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
             for (uint32_t qid = 0; qid < 16; qid++)
             {
                 uint32_t DQId = 16 * did + qid;
-                layer_data_s *ld = &m_layer_data[DQId];
+                layer_data_s *ld = &m_pSvcData->layer_data[DQId];
                 if (!ld->used) { // used layers are always consecutive starting with qid=0 (i.e. no qid gaps)
                     break;
                 }
@@ -598,9 +639,9 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
     uint32_t PicLayer = 0;
     for(uint32_t layer = 0; layer < 128; layer++)
     {
-        TotalSliceCnt += m_layer_data[layer].slice_count;
-        int CurrentSliceCnt = m_layer_data[layer].slice_count;
-        if (!m_layer_data[layer].used) {
+        TotalSliceCnt += m_pSvcData->layer_data[layer].slice_count;
+        int CurrentSliceCnt = m_pSvcData->layer_data[layer].slice_count;
+        if (!m_pSvcData->layer_data[layer].used) {
             continue;
         }
         // slice calculation
@@ -614,11 +655,11 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
         // within a layer starts at 0
         (pnvpd + PicLayer)->firstSliceIndex = firstSlice;
 
-        const seq_parameter_set_s* sps = m_layer_data[layer].sps;
-        const pic_parameter_set_s* pps = m_layer_data[layer].pps;
-        slh = &m_layer_data[layer].slh;
+        const seq_parameter_set_s* sps = m_pSvcData->layer_data[layer].sps;
+        const pic_parameter_set_s* pps = m_pSvcData->layer_data[layer].pps;
+        slh = &m_pSvcData->layer_data[layer].slh;
         h264 = &(pnvpd + PicLayer)->CodecSpecific.h264;
-        svc_dpb_entry_s *dpb_entry = m_dependency_state[layer >> 4].dpb_entry;
+        svc_dpb_entry_s *dpb_entry = m_pSvcData->dependency_state[layer >> 4].dpb_entry;
 
         (pnvpd + PicLayer)->PicWidthInMbs = sps->pic_width_in_mbs_minus1 + 1;
         (pnvpd + PicLayer)->FrameHeightInMbs = (2 - sps->flags.frame_mbs_only_flag) * (sps->pic_height_in_map_units_minus1 + 1);
@@ -764,11 +805,15 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
 
 void VulkanH264Decoder::EndPicture_SVC()
 {
+    if (!m_pSvcData) {
+        return;
+    }
+
     int dependencyIdMax = m_iDQIdMax >> 4; // dependency_id of target dependency representation
     for (int did=0; did<=dependencyIdMax; did++)
     {
-        m_ds = &m_dependency_state[did];
-        m_dd = &m_dependency_data[did];
+        m_ds = &m_pSvcData->dependency_state[did];
+        m_dd = &m_pSvcData->dependency_data[did];
         if (m_dd->used)
         {
             if (m_dd->slh.nal_ref_idc > 0)
@@ -777,12 +822,26 @@ void VulkanH264Decoder::EndPicture_SVC()
         }
     }
     // clear SVC layer data
-    {
-        for (size_t i = 0; i < sizeof(m_layer_data) / sizeof(m_layer_data[0]); i++) {
-            m_layer_data[i] = layer_data_s();
-        }
+    ResetSvcLayerData();
+}
+
+VulkanH264Decoder::H264SvcData *VulkanH264Decoder::GetSvcData()
+{
+    // Most H.264 streams have a single layer, the layer representations are only allocated when parsed
+    if (!m_pSvcData) {
+        m_pSvcData = new H264SvcData();
     }
+    return m_pSvcData;
+}
 
+void VulkanH264Decoder::ResetSvcLayerData()
+{
+    // Only the layers of the access unit have been written (update_layer_info)
+    for (size_t i = 0; i < ARRAYSIZE(m_pSvcData->layer_data); i++) {
+        if (m_pSvcData->layer_data[i].available) {
+            m_pSvcData->layer_data[i] = layer_data_s();
+        }
+    }
 }
 
 // Operation of the output order DPB
@@ -1177,7 +1236,9 @@ int32_t VulkanH264Decoder::ParseNalUnit()
     int nal_ref_idc, nal_unit_type, picture_boundary;
     int retval = NALU_DISCARD;
 
-    picture_boundary = (m_nalu.start_offset == 0);
+    // The first slice of a picture starts the bitstream buffer, unless the SEI
+    // NAL units before it are kept for the picture metadata.
+    picture_boundary = m_bPictureMetadata ? (m_bitstreamData.GetStreamMarkersCount() == 0) : (m_nalu.start_offset == 0);
     f(1, 0);    // forbidden_zero_bit
     nal_ref_idc = u(2);
     nal_unit_type = u(5);
@@ -1289,12 +1350,16 @@ int32_t VulkanH264Decoder::ParseNalUnit()
             }
             bitsUsed = consumed_bits();
             sei_payload(payloadType, payloadSize);
-            // Skip over unknown payloads (NOTE: assumes that emulation prevention bytes are not present)
+            // Skip over unknown payloads (payloadSize and consumed_bits() do not count emulation prevention bytes)
             skip = payloadSize * 8 - (consumed_bits() - bitsUsed);
             if (skip > 0) {
                 skip_bits(skip);
             }
         }
+        // The messages are reported with the picture they precede
+        if (AddSeiMetadata(1, false)) {
+            retval = NALU_METADATA;
+        }
         break;
     case NAL_UNIT_SPS:
         seq_parameter_set_rbsp();
@@ -1519,12 +1584,14 @@ int32_t VulkanH264Decoder::seq_parameter_set_rbsp(SpsNalUnitTarget spsNalUnitTar
     sps->profile_idc = (StdVideoH264ProfileIdc)profile_idc;
     sps->constraint_set_flags = constraint_set_flags;
 
-    sps->flags.constraint_set0_flag = (constraint_set_flags >> 0) & 1;
-    sps->flags.constraint_set1_flag = (constraint_set_flags >> 1) & 1;
-    sps->flags.constraint_set2_flag = (constraint_set_flags >> 2) & 1;
-    sps->flags.constraint_set3_flag = (constraint_set_flags >> 3) & 1;
-    sps->flags.constraint_set4_flag = (constraint_set_flags >> 4) & 1;
-    sps->flags.constraint_set5_flag = (constraint_set_flags >> 5) & 1;
+    // constraint_set0_flag is the first bit of the byte, followed by the
+    // other flags and reserved_zero_2bits.
+    sps->flags.constraint_set0_flag = (constraint_set_flags >> 7) & 1;
+    sps->flags.constraint_set1_flag = (constraint_set_flags >> 6) & 1;
+    sps->flags.constraint_set2_flag = (constraint_set_flags >> 5) & 1;
+    sps->flags.constraint_set3_flag = (constraint_set_flags >> 4) & 1;
+    sps->flags.constraint_set4_flag = (constraint_set_flags >> 3) & 1;
+    sps->flags.constraint_set5_flag = (constraint_set_flags >> 2) & 1;
 
     // Table A-1 Level limits
     sps->level_idc = levelIdcToVulkanLevelIdcEnum(level_idc, sps->flags.constraint_set3_flag);
@@ -1586,9 +1653,11 @@ int32_t VulkanH264Decoder::seq_parameter_set_rbsp(SpsNalUnitTarget spsNalUnitTar
         }
         sps->num_ref_frames_in_pic_order_cnt_cycle = (uint8_t)num_ref_frames_in_pic_order_cnt_cycle;
 
+        sps->offset_for_ref_frame.resize(num_ref_frames_in_pic_order_cnt_cycle);
         for (int i = 0; i < sps->num_ref_frames_in_pic_order_cnt_cycle; i++) {
             sps->offset_for_ref_frame[i] = se();
         }
+        sps->pOffsetForRefFrame = sps->offset_for_ref_frame.empty() ? nullptr : sps->offset_for_ref_frame.data();
     }
     sps->max_num_ref_frames = ue();
     if (sps->max_num_ref_frames > 16) {
@@ -1827,9 +1896,10 @@ bool VulkanH264Decoder::seq_parameter_set_mvc_extension_rbsp(int32_t sps_id)
     u(1); // mvc_vui_parameters_present_flag, should always be 0;
     u(1); // additional_extension2_flag
 
-    m_pParserData->spsmes[m_last_sps_id].release();
-    m_pParserData->spsmes[m_last_sps_id] = spstmp;
-    m_spsmes[m_last_sps_id] = &(m_pParserData->spsmes[m_last_sps_id]);
+    H264MvcData *pMvcData = GetMvcData();
+    pMvcData->spsmes[m_last_sps_id].release();
+    pMvcData->spsmes[m_last_sps_id] = spstmp;
+    m_spsmes[m_last_sps_id] = &(pMvcData->spsmes[m_last_sps_id]);
 
     if (m_outOfBandPictureParameters && m_pClient) {
         assert(sps_id == m_last_sps_id);
@@ -2469,23 +2539,24 @@ bool VulkanH264Decoder::slice_header(slice_header_s *slh, int nal_ref_idc, int n
 void VulkanH264Decoder::update_layer_info(seq_parameter_set_s *sps, pic_parameter_set_s *pps, slice_header_s *slh)
 {  
     int dqid = (slh->nhe.svc.dependency_id << 4) + slh->nhe.svc.quality_id;
-    if (!m_layer_data[dqid].available) // first slice of layer
+    layer_data_s *ld = &GetSvcData()->layer_data[dqid];
+    if (!ld->available) // first slice of layer
     {
-        m_layer_data[dqid].available = true;
-        m_layer_data[dqid].sps = sps;
-        m_layer_data[dqid].pps = pps;
-        m_layer_data[dqid].slh = *slh;
-        m_layer_data[dqid].MaxRefLayerDQId = -1;
+        ld->available = true;
+        ld->sps = sps;
+        ld->pps = pps;
+        ld->slh = *slh;
+        ld->MaxRefLayerDQId = -1;
     }
 
     // keep a slice header with no_inter_layer_pred_flag==0 (if any)
-    if (m_layer_data[dqid].MaxRefLayerDQId < 0 && !slh->nhe.svc.no_inter_layer_pred_flag)
+    if (ld->MaxRefLayerDQId < 0 && !slh->nhe.svc.no_inter_layer_pred_flag)
     {
-        m_layer_data[dqid].slh = *slh;
-        m_layer_data[dqid].MaxRefLayerDQId = (slh->nhe.svc.quality_id == 0) ? slh->ref_layer_dq_id : dqid - 1;
+        ld->slh = *slh;
+        ld->MaxRefLayerDQId = (slh->nhe.svc.quality_id == 0) ? slh->ref_layer_dq_id : dqid - 1;
     }
 
-    m_layer_data[dqid].slice_count++;
+    ld->slice_count++;
     
     m_slh_prev = *slh;
     m_bLayerFirstSlice = 0;
@@ -2825,7 +2896,7 @@ bool VulkanH264Decoder::is_comp_field_pair(dpb_entry_s *dpb_local, slice_header_
 bool VulkanH264Decoder::find_comp_field_pair(slice_header_s *slh, int *icur)
 {
     int VOIdx = get_view_output_index(slh->view_id);
-    VkPicIf *pPicBuf = CurrFrmViewPic[VOIdx];
+    VkPicIf *pPicBuf = GetCurrFrmViewPic(VOIdx);
     int i;
 
     if (pPicBuf)
@@ -2882,7 +2953,7 @@ void VulkanH264Decoder::dpb_picture_start(pic_parameter_set_s *pps, slice_header
         // Reset view indices when we get the base view
         if ((slh->nal_unit_type == 1) || (slh->nal_unit_type == 5))
         {
-            memset(CurrFrmViewPic, 0, sizeof(CurrFrmViewPic));
+            ResetCurrFrmViewPics();
             for (int i = 0; i <= MAX_DPB_SIZE; i++)
             {
                 dpb[i].inter_view_flag = 0; // Reset inter view flags
@@ -2917,7 +2988,7 @@ void VulkanH264Decoder::dpb_picture_start(pic_parameter_set_s *pps, slice_header
         }
         cur->view_id = slh->view_id;
         cur->VOIdx = get_view_output_index(slh->view_id);
-        CurrFrmViewPic[cur->VOIdx] = cur->pPicBuf;
+        SetCurrFrmViewPic(cur->VOIdx, cur->pPicBuf);
         cur->inter_view_flag = m_nhe.mvc.inter_view_flag;
     }
 
@@ -4603,6 +4674,42 @@ int VulkanH264Decoder::get_view_output_index(int view_id)
     return 0;
 }
 
+VulkanH264Decoder::H264MvcData *VulkanH264Decoder::GetMvcData()
+{
+    if (!m_pMvcData) {
+        m_pMvcData = new H264MvcData();
+    }
+    return m_pMvcData;
+}
+
+// The view order index is 0 unless an MVC subset SPS is active (get_view_output_index)
+VkPicIf *VulkanH264Decoder::GetCurrFrmViewPic(int VOIdx) const
+{
+    if (VOIdx == 0) {
+        return m_CurrFrmBaseViewPic;
+    }
+    assert((VOIdx > 0) && (VOIdx < (int)ARRAYSIZE(m_pMvcData->CurrFrmViewPic)));
+    return m_pMvcData ? m_pMvcData->CurrFrmViewPic[VOIdx] : NULL;
+}
+
+void VulkanH264Decoder::SetCurrFrmViewPic(int VOIdx, VkPicIf *pPicBuf)
+{
+    if (VOIdx == 0) {
+        m_CurrFrmBaseViewPic = pPicBuf;
+    } else {
+        assert((VOIdx > 0) && (VOIdx < (int)ARRAYSIZE(m_pMvcData->CurrFrmViewPic)));
+        GetMvcData()->CurrFrmViewPic[VOIdx] = pPicBuf;
+    }
+}
+
+void VulkanH264Decoder::ResetCurrFrmViewPics()
+{
+    m_CurrFrmBaseViewPic = NULL;
+    if (m_pMvcData) {
+        memset(m_pMvcData->CurrFrmViewPic, 0, sizeof(m_pMvcData->CurrFrmViewPic));
+    }
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // SEI payloads (D.1)
@@ -64,6 +64,25 @@ void VulkanH265Decoder::FreeContext()
     m_pParserData = NULL;
 }
 
+void VulkanH265Decoder::GetCodecMemoryFootprint(VkParserMemoryFootprint *pFootprint) const
+{
+    pFootprint->parserSize += sizeof(*this) + (m_pParserData ? sizeof(H265ParserData) : 0);
+    pFootprint->onDemandSize += m_sliceSegments.capacity() * sizeof(VkParserHevcSliceSegment) +
+                                m_entryPointOffsets.capacity() * sizeof(uint32_t);
+    for (uint32_t i = 0; i < MAX_NUM_VPS; i++) {
+        if (m_vpss[i]) {
+            pFootprint->parameterSetsSize += sizeof(hevc_video_param_s) +
+                                             (m_vpss[i]->pExtension ? sizeof(hevc_video_param_ext_s) : 0);
+        }
+    }
+    for (uint32_t i = 0; i < MAX_NUM_SPS; i++) {
+        pFootprint->parameterSetsSize += m_spss[i] ? sizeof(hevc_seq_param_s) : 0;
+    }
+    for (uint32_t i = 0; i < MAX_NUM_PPS; i++) {
+        pFootprint->parameterSetsSize += m_ppss[i] ? sizeof(hevc_pic_param_s) : 0;
+    }
+}
+
 void VulkanH265Decoder::InitParser()
 {
     m_MaxDpbSize = 0;
@@ -212,15 +231,24 @@ bool VulkanH265Decoder::BeginPicture(VkParserPictureData *pnvpd)
         }
     }
 
+    // Slice segments, recorded in the order of the slice stream markers
+    assert(m_sliceSegments.size() >= pnvpd->numSlices);
+    if ((pnvpd->numSlices > 0) && (m_sliceSegments.size() >= pnvpd->numSlices)) {
+        const VkParserHevcSliceSegment& lastSliceSegment = m_sliceSegments[pnvpd->numSlices - 1];
+        hevc->pSliceSegments = m_sliceSegments.data();
+        hevc->numEntryPointOffsets = lastSliceSegment.firstEntryPoint + lastSliceSegment.numEntryPoints;
+        hevc->pEntryPointOffsets = (hevc->numEntryPointOffsets > 0) ? m_entryPointOffsets.data() : nullptr;
+    }
+
     // MV-HEVC related fields
     if (m_nuh_layer_id > 0)
     {
         hevc->mv_hevc_enable = 1;
         hevc->nuh_layer_id = m_nuh_layer_id;
         hevc->default_ref_layers_active_flag = vps->privFlags.default_ref_layers_active_flag;
-        hevc->NumDirectRefLayers = vps->numDirectRefLayers[m_nuh_layer_id];
+        hevc->NumDirectRefLayers = vps->GetExtension().numDirectRefLayers[m_nuh_layer_id];
         hevc->max_one_active_ref_layer_flag = vps->privFlags.max_one_active_ref_layer_flag;
-        hevc->poc_lsb_not_present_flag = vps->poc_lsb_not_present_flag[vps->LayerIdxInVps[m_nuh_layer_id]];
+        hevc->poc_lsb_not_present_flag = vps->GetExtension().poc_lsb_not_present_flag[vps->GetExtension().LayerIdxInVps[m_nuh_layer_id]];
     }
 
     return true;
@@ -301,6 +329,9 @@ int32_t VulkanH265Decoder::ParseNalUnit()
     case NUT_PREFIX_SEI_NUT:
     case NUT_SUFFIX_SEI_NUT:
         sei_payload();
+        if (AddSeiMetadata(2, (nal_unit_type == NUT_SUFFIX_SEI_NUT))) {
+            retval = NALU_METADATA;
+        }
         break;
     default:
         if ((nal_unit_type >= NUT_TRAIL_N && nal_unit_type <= NUT_RASL_R) || (nal_unit_type >= NUT_BLA_W_LP && nal_unit_type <= NUT_CRA_NUT))
@@ -438,20 +469,20 @@ void VulkanH265Decoder::seq_parameter_set_rbsp()
         if (u(1)) { // update_rep_format_flag
             sps->sps_rep_format_idx = u(8);
         } else {
-            sps->sps_rep_format_idx = vps->vps_rep_format_idx[vps->LayerIdxInVps[m_nuh_layer_id]];
+            sps->sps_rep_format_idx = vps->GetExtension().vps_rep_format_idx[vps->GetExtension().LayerIdxInVps[m_nuh_layer_id]];
         }
         if (sps->sps_rep_format_idx > 63) {
             return;
         }
-        sps->chroma_format_idc          = (StdVideoH265ChromaFormatIdc)vps->repFormat[sps->sps_rep_format_idx].chroma_format_vps_idc; // PIERS: Is this cast okay?
-        sps->pic_width_in_luma_samples  = vps->repFormat[sps->sps_rep_format_idx].pic_width_vps_in_luma_samples;
-        sps->pic_height_in_luma_samples = vps->repFormat[sps->sps_rep_format_idx].pic_height_vps_in_luma_samples;
-        sps->conf_win_left_offset       = vps->repFormat[sps->sps_rep_format_idx].conf_win_vps_left_offset;
-        sps->conf_win_right_offset      = vps->repFormat[sps->sps_rep_format_idx].conf_win_vps_right_offset;
-        sps->conf_win_top_offset        = vps->repFormat[sps->sps_rep_format_idx].conf_win_vps_top_offset;
-        sps->conf_win_bottom_offset     = vps->repFormat[sps->sps_rep_format_idx].conf_win_vps_bottom_offset;
-        sps->bit_depth_luma_minus8      = vps->repFormat[sps->sps_rep_format_idx].bit_depth_vps_luma_minus8;
-        sps->bit_depth_chroma_minus8    = vps->repFormat[sps->sps_rep_format_idx].bit_depth_vps_chroma_minus8;
+        sps->chroma_format_idc          = (StdVideoH265ChromaFormatIdc)vps->GetExtension().repFormat[sps->sps_rep_format_idx].chroma_format_vps_idc; // PIERS: Is this cast okay?
+        sps->pic_width_in_luma_samples  = vps->GetExtension().repFormat[sps->sps_rep_format_idx].pic_width_vps_in_luma_samples;
+        sps->pic_height_in_luma_samples = vps->GetExtension().repFormat[sps->sps_rep_format_idx].pic_height_vps_in_luma_samples;
+        sps->conf_win_left_offset       = vps->GetExtension().repFormat[sps->sps_rep_format_idx].conf_win_vps_left_offset;
+        sps->conf_win_right_offset      = vps->GetExtension().repFormat[sps->sps_rep_format_idx].conf_win_vps_right_offset;
+        sps->conf_win_top_offset        = vps->GetExtension().repFormat[sps->sps_rep_format_idx].conf_win_vps_top_offset;
+        sps->conf_win_bottom_offset     = vps->GetExtension().repFormat[sps->sps_rep_format_idx].conf_win_vps_bottom_offset;
+        sps->bit_depth_luma_minus8      = vps->GetExtension().repFormat[sps->sps_rep_format_idx].bit_depth_vps_luma_minus8;
+        sps->bit_depth_chroma_minus8    = vps->GetExtension().repFormat[sps->sps_rep_format_idx].bit_depth_vps_chroma_minus8;
     } else {
         uint8_t chroma_format_idc = (uint8_t)ue();
         sps_error |= (chroma_format_idc > 3);
@@ -525,9 +556,9 @@ void VulkanH265Decoder::seq_parameter_set_rbsp()
             layerIdx++;
         }
         for (int i = 0; i <= sps->sps_max_sub_layers_minus1; i++) {
-            sps->stdDecPicBufMgr.max_dec_pic_buffering_minus1[i] = vps->max_vps_dec_pic_buffering_minus1[targetOptLayerSetIdx][layerIdx][i];
-            sps->stdDecPicBufMgr.max_num_reorder_pics[i]         = vps->max_vps_num_reorder_pics[targetOptLayerSetIdx][i];
-            sps->stdDecPicBufMgr.max_latency_increase_plus1[i]   = vps->max_vps_latency_increase_plus1[targetOptLayerSetIdx][i];
+            sps->stdDecPicBufMgr.max_dec_pic_buffering_minus1[i] = vps->GetExtension().max_vps_dec_pic_buffering_minus1[targetOptLayerSetIdx][layerIdx][i];
+            sps->stdDecPicBufMgr.max_num_reorder_pics[i]         = vps->GetExtension().max_vps_num_reorder_pics[targetOptLayerSetIdx][i];
+            sps->stdDecPicBufMgr.max_latency_increase_plus1[i]   = vps->GetExtension().max_vps_latency_increase_plus1[targetOptLayerSetIdx][i];
             if (sps->stdDecPicBufMgr.max_dec_pic_buffering_minus1[i] >= sps->max_dec_pic_buffering)
             {
                 sps->max_dec_pic_buffering = sps->stdDecPicBufMgr.max_dec_pic_buffering_minus1[i] + 1;
@@ -958,9 +989,7 @@ void VulkanH265Decoder::video_parameter_set_rbsp()
         vps->stdDecPicBufMgr.max_latency_increase_plus1[i]   = ue();
     }
 
-    if (vps->vps_max_sub_layers_minus1 != 0) {
-        vps->pDecPicBufMgr = &vps->stdDecPicBufMgr;
-    }
+    vps->pDecPicBufMgr = &vps->stdDecPicBufMgr;
 
     vps->vps_max_layer_id = u(6);
     vps->vps_num_layer_sets = ue() + 1;
@@ -1040,9 +1069,8 @@ void VulkanH265Decoder::video_parameter_set_rbsp()
                 return;
             }
 
-            if (i > 0) {
-                vps->cprms_present_flag[i] = u(1);
-            }
+            // cprms_present_flag[0] is inferred to be 1.
+            vps->cprms_present_flag[i] = (i > 0) ? u(1) : 1;
 
             hrd_parameters(&pHrdParameters[i], vps->cprms_present_flag[i],
                             vps->vps_max_sub_layers_minus1);
@@ -1088,6 +1116,8 @@ void VulkanH265Decoder::video_parameter_set_rbsp()
 /* Decode video parameter set extension information from the stream. */
 void VulkanH265Decoder::video_parameter_set_rbspExtension(hevc_video_param_s *pVideoParamSet)
 {
+    // The extension tables are only allocated for the multi-layer streams that have them
+    hevc_video_param_ext_s* pExt = pVideoParamSet->CreateExtension();
     uint32_t i, j, k;
 
     if ((pVideoParamSet->vps_max_layers_minus1 > 0) &&
@@ -1102,22 +1132,22 @@ void VulkanH265Decoder::video_parameter_set_rbspExtension(hevc_video_param_s *pV
     //////////////////////////////////////////////////////
     /* Layer and nuh_layer_id info */
     //////////////////////////////////////////////////////
-    pVideoParamSet->numScalabilityTypes = 0;
+    pExt->numScalabilityTypes = 0;
     for (i = 0; i < MAX_NUM_SCALABILITY_TYPES; i++)
     {
-        pVideoParamSet->scalability_mask_flag[i] = u(1);
-        pVideoParamSet->numScalabilityTypes += pVideoParamSet->scalability_mask_flag[i];
+        pExt->scalability_mask_flag[i] = u(1);
+        pExt->numScalabilityTypes += pExt->scalability_mask_flag[i];
     }
 
-    for (i = 0; i < ( pVideoParamSet->numScalabilityTypes - pVideoParamSet->privFlags.splitting_flag); i++)
+    for (i = 0; i < ( pExt->numScalabilityTypes - pVideoParamSet->privFlags.splitting_flag); i++)
     {
-        pVideoParamSet->dimension_id_len[i] = (uint8_t)(u(3) + 1);
+        pExt->dimension_id_len[i] = (uint8_t)(u(3) + 1);
     }
     if (pVideoParamSet->privFlags.splitting_flag)
     {
         /* infer last dimension ID Len */
-        pVideoParamSet->dimension_id_len[pVideoParamSet->numScalabilityTypes - 1]
-          = 5 - xGetDimBitOffset(pVideoParamSet, pVideoParamSet->numScalabilityTypes - 1);
+        pExt->dimension_id_len[pExt->numScalabilityTypes - 1]
+          = 5 - xGetDimBitOffset(pVideoParamSet, pExt->numScalabilityTypes - 1);
     }
 
     pVideoParamSet->privFlags.vps_nuh_layer_id_present_flag = u(1);
@@ -1126,44 +1156,44 @@ void VulkanH265Decoder::video_parameter_set_rbspExtension(hevc_video_param_s *pV
     {
         if (pVideoParamSet->privFlags.vps_nuh_layer_id_present_flag)
         {
-            pVideoParamSet->layer_id_in_nuh[i] = (uint8_t)u(6);
+            pExt->layer_id_in_nuh[i] = (uint8_t)u(6);
         }
         else
         {
-            pVideoParamSet->layer_id_in_nuh[i] = (uint8_t)i;
+            pExt->layer_id_in_nuh[i] = (uint8_t)i;
         }
 
         if (!pVideoParamSet->privFlags.splitting_flag)
         {
-            for (j = 0; j < pVideoParamSet->numScalabilityTypes; j++)
+            for (j = 0; j < pExt->numScalabilityTypes; j++)
             {
-                uint32_t codelength = pVideoParamSet->dimension_id_len[j];
-                pVideoParamSet->dimension_id[i][j] = (uint8_t)u(codelength);
+                uint32_t codelength = pExt->dimension_id_len[j];
+                pExt->dimension_id[i][j] = (uint8_t)u(codelength);
             }
         }
         else
         {
-            for (j = 0; j < pVideoParamSet->numScalabilityTypes; j++)
+            for (j = 0; j < pExt->numScalabilityTypes; j++)
             {
-                pVideoParamSet->dimension_id[i][j] = (pVideoParamSet->layer_id_in_nuh[i]
+                pExt->dimension_id[i][j] = (pExt->layer_id_in_nuh[i]
                 & ( (1 << xGetDimBitOffset(pVideoParamSet,  j + 1 ) ) - 1) ) >> xGetDimBitOffset(pVideoParamSet, j );
             }
         }
     }
     for (i = 1; i <= pVideoParamSet->vps_max_layers_minus1; i++)
     {
-        pVideoParamSet->LayerIdxInVps[pVideoParamSet->layer_id_in_nuh[i]] = i;
+        pExt->LayerIdxInVps[pExt->layer_id_in_nuh[i]] = i;
     }
 
     initNumViews(pVideoParamSet);
 
-    pVideoParamSet->view_id_len = u(4);
-    if (pVideoParamSet->view_id_len > 0)
+    pExt->view_id_len = u(4);
+    if (pExt->view_id_len > 0)
     {
-        for (i = 0; i < pVideoParamSet->numViews; i++)
+        for (i = 0; i < pExt->numViews; i++)
         {
-            uint32_t codelength = pVideoParamSet->view_id_len;
-            pVideoParamSet->view_id_val[i] = u(codelength);
+            uint32_t codelength = pExt->view_id_len;
+            pExt->view_id_val[i] = u(codelength);
         }
     }
 
@@ -1171,36 +1201,36 @@ void VulkanH265Decoder::video_parameter_set_rbspExtension(hevc_video_param_s *pV
     {
         for (j = 0; j < i; j++)
         {
-            pVideoParamSet->direct_dependency_flag[i][j] = u(1);
+            pExt->direct_dependency_flag[i][j] = u(1);
         }
     }
 
     setRefLayers(pVideoParamSet);
 
-    if (pVideoParamSet->numIndependentLayers > 1)
+    if (pExt->numIndependentLayers > 1)
     {
-        pVideoParamSet->num_add_layer_sets = ue();
-        if (pVideoParamSet->num_add_layer_sets > 1023)
+        pExt->num_add_layer_sets = ue();
+        if (pExt->num_add_layer_sets > 1023)
         {
-            nvParserLog("Invalid Invalid vps parameter (num_add_layer_sets=%d)\n", pVideoParamSet->num_add_layer_sets);
+            nvParserLog("Invalid Invalid vps parameter (num_add_layer_sets=%d)\n", pExt->num_add_layer_sets);
             return;
         }
     }
 
-    for (i = 0; i < pVideoParamSet->num_add_layer_sets; i++)
+    for (i = 0; i < pExt->num_add_layer_sets; i++)
     {
-        for (j = 1; j < pVideoParamSet->numIndependentLayers; j++)
+        for (j = 1; j < pExt->numIndependentLayers; j++)
         {
-            uint32_t length = CeilLog2(pVideoParamSet->numLayersInTreePartition[j] + 1);
-            pVideoParamSet->highest_layer_idx_plus1[i][j] = u(length);
+            uint32_t length = CeilLog2(pExt->numLayersInTreePartition[j] + 1);
+            pExt->highest_layer_idx_plus1[i][j] = u(length);
         }
 
         uint32_t layerNum = 0;
         uint32_t lsIdx = pVideoParamSet->vps_num_layer_sets + i;
-        for (uint32_t treeIdx = 1; treeIdx < pVideoParamSet->numIndependentLayers; treeIdx++)
+        for (uint32_t treeIdx = 1; treeIdx < pExt->numIndependentLayers; treeIdx++)
         {
-            for (uint32_t layerCnt = 0; layerCnt < pVideoParamSet->highest_layer_idx_plus1[i][treeIdx]; layerCnt++)
-                pVideoParamSet->layer_set_layer_id_list[lsIdx][layerNum++] = pVideoParamSet->treePartitionLayerIdList[treeIdx][layerCnt];
+            for (uint32_t layerCnt = 0; layerCnt < pExt->highest_layer_idx_plus1[i][treeIdx]; layerCnt++)
+                pVideoParamSet->layer_set_layer_id_list[lsIdx][layerNum++] = pExt->treePartitionLayerIdList[treeIdx][layerCnt];
         }
         pVideoParamSet->num_layers_in_id_list[lsIdx] = layerNum;
     }
@@ -1210,12 +1240,12 @@ void VulkanH265Decoder::video_parameter_set_rbspExtension(hevc_video_param_s *pV
     if (pVideoParamSet->privFlags.vps_sub_layers_max_minus1_present_flag)
     {
         for (i = 0; i <= pVideoParamSet->vps_max_layers_minus1; i++)
-            pVideoParamSet->sub_layers_vps_max_minus1[i] = u(3);
+            pExt->sub_layers_vps_max_minus1[i] = u(3);
     }
     else
     {
         for (i = 0; i <= pVideoParamSet->vps_max_layers_minus1; i++)
-            pVideoParamSet->sub_layers_vps_max_minus1[i] = pVideoParamSet->vps_max_sub_layers_minus1;
+            pExt->sub_layers_vps_max_minus1[i] = pVideoParamSet->vps_max_sub_layers_minus1;
     }
 
     pVideoParamSet->privFlags.max_tid_ref_present_flag = u(1);
@@ -1226,57 +1256,57 @@ void VulkanH265Decoder::video_parameter_set_rbspExtension(hevc_video_param_s *pV
         {
             for (j = i+1; j <= pVideoParamSet->vps_max_layers_minus1; j++)
             {
-                if (pVideoParamSet->direct_dependency_flag[j][i])
-                    pVideoParamSet->max_tid_il_ref_pics_plus1[i][j] = u(3);
+                if (pExt->direct_dependency_flag[j][i])
+                    pExt->max_tid_il_ref_pics_plus1[i][j] = u(3);
             }
         }
     }
 
     pVideoParamSet->privFlags.default_ref_layers_active_flag = u(1);
 
-    pVideoParamSet->vps_num_profile_tier_level_minus1 = ue();
-    if (pVideoParamSet->vps_num_profile_tier_level_minus1 > 63 ||
-        (pVideoParamSet->vps_max_layers_minus1 > 0 && pVideoParamSet->vps_num_profile_tier_level_minus1 == 0))
+    pExt->vps_num_profile_tier_level_minus1 = ue();
+    if (pExt->vps_num_profile_tier_level_minus1 > 63 ||
+        (pVideoParamSet->vps_max_layers_minus1 > 0 && pExt->vps_num_profile_tier_level_minus1 == 0))
     {
-        nvParserLog("Invalid vps parameter (vps_num_profile_tier_level_minus1=%d)\n", pVideoParamSet->vps_num_profile_tier_level_minus1);
+        nvParserLog("Invalid vps parameter (vps_num_profile_tier_level_minus1=%d)\n", pExt->vps_num_profile_tier_level_minus1);
         return;
     }
-    for (i = pVideoParamSet->privFlags.vps_base_layer_internal_flag ? 2 : 1; i <= pVideoParamSet->vps_num_profile_tier_level_minus1; i++)
+    for (i = pVideoParamSet->privFlags.vps_base_layer_internal_flag ? 2 : 1; i <= pExt->vps_num_profile_tier_level_minus1; i++)
     {
-        pVideoParamSet->vps_profile_present_flag[i] = u(1);
-        pVideoParamSet->pProfileTierLevel = profile_tier_level(&pVideoParamSet->stdProfileTierLevel, pVideoParamSet->vps_max_sub_layers_minus1, pVideoParamSet->vps_profile_present_flag[i]);
+        pExt->vps_profile_present_flag[i] = u(1);
+        pVideoParamSet->pProfileTierLevel = profile_tier_level(&pVideoParamSet->stdProfileTierLevel, pVideoParamSet->vps_max_sub_layers_minus1, pExt->vps_profile_present_flag[i]);
     }
 
     /* Operation Points */
-    if (pVideoParamSet->vps_num_layer_sets + pVideoParamSet->num_add_layer_sets > 1)
+    if (pVideoParamSet->vps_num_layer_sets + pExt->num_add_layer_sets > 1)
     {
-        pVideoParamSet->num_add_olss = ue();
-        if (pVideoParamSet->num_add_olss > 1023)
+        pExt->num_add_olss = ue();
+        if (pExt->num_add_olss > 1023)
         {
-            pVideoParamSet->num_add_olss = 0;
+            pExt->num_add_olss = 0;
         }
-        pVideoParamSet->numOutputLayerSets =  pVideoParamSet->vps_num_layer_sets + pVideoParamSet->num_add_layer_sets + pVideoParamSet->num_add_olss;
-        pVideoParamSet->default_output_layer_idc = u(2);
+        pExt->numOutputLayerSets =  pVideoParamSet->vps_num_layer_sets + pExt->num_add_layer_sets + pExt->num_add_olss;
+        pExt->default_output_layer_idc = u(2);
     }
 
-    for (i = 1; i < pVideoParamSet->numOutputLayerSets; i++)
+    for (i = 1; i < pExt->numOutputLayerSets; i++)
     {
-        if (pVideoParamSet->vps_num_layer_sets + pVideoParamSet->num_add_layer_sets > 2
-            && i >= pVideoParamSet->vps_num_layer_sets + pVideoParamSet->num_add_layer_sets)
+        if (pVideoParamSet->vps_num_layer_sets + pExt->num_add_layer_sets > 2
+            && i >= pVideoParamSet->vps_num_layer_sets + pExt->num_add_layer_sets)
         {
-            uint32_t codelength = CeilLog2(pVideoParamSet->vps_num_layer_sets + pVideoParamSet->num_add_layer_sets);
-            pVideoParamSet->layer_set_idx_for_ols_minus1[i] = u(codelength);
+            uint32_t codelength = CeilLog2(pVideoParamSet->vps_num_layer_sets + pExt->num_add_layer_sets);
+            pExt->layer_set_idx_for_ols_minus1[i] = u(codelength);
         }
 
-        if (i > pVideoParamSet->vps_num_layer_sets - 1 || pVideoParamSet->default_output_layer_idc == 2)
+        if (i > pVideoParamSet->vps_num_layer_sets - 1 || pExt->default_output_layer_idc == 2)
         {
             for (j = 0; j < pVideoParamSet->num_layers_in_id_list[olsIdxToLsIdx(pVideoParamSet, i)]; j++)
-                pVideoParamSet->output_layer_flag[i][j] = u(1);
+                pExt->output_layer_flag[i][j] = u(1);
         }
         else
         {
             for (j = 0; j < pVideoParamSet->num_layers_in_id_list[olsIdxToLsIdx(pVideoParamSet, i)]; j++)
-                pVideoParamSet->output_layer_flag[i][j] = inferoutput_layer_flag(pVideoParamSet, i, j);
+                pExt->output_layer_flag[i][j] = inferoutput_layer_flag(pVideoParamSet, i, j);
         }
 
         /* Derive Necessary Layer Flag */
@@ -1285,64 +1315,64 @@ void VulkanH265Decoder::video_parameter_set_rbspExtension(hevc_video_param_s *pV
         /* profile_tier_level_idx[i][j] */
         for (j = 0; j < pVideoParamSet->num_layers_in_id_list[olsIdxToLsIdx(pVideoParamSet, i)]; j++)
         {
-            if (pVideoParamSet->necessaryLayerFlag[i][j] && pVideoParamSet->vps_num_profile_tier_level_minus1 > 0)
+            if (pExt->necessaryLayerFlag[i][j] && pExt->vps_num_profile_tier_level_minus1 > 0)
             {
-                uint32_t codelength = CeilLog2(pVideoParamSet->vps_num_profile_tier_level_minus1 + 1);
-                pVideoParamSet->profile_tier_level_idx[i][j] = u(codelength);
+                uint32_t codelength = CeilLog2(pExt->vps_num_profile_tier_level_minus1 + 1);
+                pExt->profile_tier_level_idx[i][j] = u(codelength);
             }
         }
 
         /* alt_output_layer_flag */
-        if (pVideoParamSet->numOutputLayersInOutputLayerSet[i] == 1
-            && pVideoParamSet->numDirectRefLayers[pVideoParamSet->olsHighestOutputLayerId[i]] > 0)
+        if (pExt->numOutputLayersInOutputLayerSet[i] == 1
+            && pExt->numDirectRefLayers[pExt->olsHighestOutputLayerId[i]] > 0)
             u(1);
     }
 
-    pVideoParamSet->vps_num_rep_formats_minus1 = ue();
-    if (pVideoParamSet->vps_num_rep_formats_minus1 > 15)
+    pExt->vps_num_rep_formats_minus1 = ue();
+    if (pExt->vps_num_rep_formats_minus1 > 15)
     {
-        nvParserLog("Invalid vps parameter (vps_num_rep_formats_minus1=%d)\n", pVideoParamSet->vps_num_rep_formats_minus1);
+        nvParserLog("Invalid vps parameter (vps_num_rep_formats_minus1=%d)\n", pExt->vps_num_rep_formats_minus1);
         return;
     }
 
-    for (i = 0; i <= pVideoParamSet->vps_num_rep_formats_minus1; i++)
+    for (i = 0; i <= pExt->vps_num_rep_formats_minus1; i++)
     {
-        pVideoParamSet->repFormat[i].pic_width_vps_in_luma_samples = u(16);
-        pVideoParamSet->repFormat[i].pic_height_vps_in_luma_samples = u(16);
+        pExt->repFormat[i].pic_width_vps_in_luma_samples = u(16);
+        pExt->repFormat[i].pic_height_vps_in_luma_samples = u(16);
 
-        pVideoParamSet->repFormat[i].chroma_and_bit_depth_vps_present_flag = u(1);
+        pExt->repFormat[i].chroma_and_bit_depth_vps_present_flag = u(1);
 
-        if (pVideoParamSet->repFormat[i].chroma_and_bit_depth_vps_present_flag)
+        if (pExt->repFormat[i].chroma_and_bit_depth_vps_present_flag)
         {
-            pVideoParamSet->repFormat[i].chroma_format_vps_idc = u(2);
+            pExt->repFormat[i].chroma_format_vps_idc = u(2);
 
-            if (pVideoParamSet->repFormat[i].chroma_format_vps_idc == 3)
+            if (pExt->repFormat[i].chroma_format_vps_idc == 3)
             {
-                pVideoParamSet->repFormat[i].chroma_format_vps_idc = u(1);
+                pExt->repFormat[i].chroma_format_vps_idc = u(1);
             }
-            pVideoParamSet->repFormat[i].bit_depth_vps_luma_minus8   = u(4);
-            pVideoParamSet->repFormat[i].bit_depth_vps_chroma_minus8 = u(4);
-            pVideoParamSet->repFormat[i].conformance_window_vps_flag = u(1);
+            pExt->repFormat[i].bit_depth_vps_luma_minus8   = u(4);
+            pExt->repFormat[i].bit_depth_vps_chroma_minus8 = u(4);
+            pExt->repFormat[i].conformance_window_vps_flag = u(1);
 
-            if (pVideoParamSet->repFormat[i].conformance_window_vps_flag)
+            if (pExt->repFormat[i].conformance_window_vps_flag)
             {
-                pVideoParamSet->repFormat[i].conf_win_vps_left_offset   = ue();
-                pVideoParamSet->repFormat[i].conf_win_vps_right_offset  = ue();
-                pVideoParamSet->repFormat[i].conf_win_vps_top_offset    = ue();
-                pVideoParamSet->repFormat[i].conf_win_vps_bottom_offset = ue();
+                pExt->repFormat[i].conf_win_vps_left_offset   = ue();
+                pExt->repFormat[i].conf_win_vps_right_offset  = ue();
+                pExt->repFormat[i].conf_win_vps_top_offset    = ue();
+                pExt->repFormat[i].conf_win_vps_bottom_offset = ue();
             }
         }
     }
 
-    if(pVideoParamSet->vps_num_rep_formats_minus1 > 0)
+    if(pExt->vps_num_rep_formats_minus1 > 0)
     {
         pVideoParamSet->privFlags.rep_format_idx_present_flag = u(1);
         if (pVideoParamSet->privFlags.rep_format_idx_present_flag)
         {
             for (i = pVideoParamSet->privFlags.vps_base_layer_internal_flag ? 1 : 0; i <= pVideoParamSet->vps_max_layers_minus1; i++)
             {
-                uint32_t codelength = CeilLog2(pVideoParamSet->vps_num_rep_formats_minus1 + 1);
-                pVideoParamSet->vps_rep_format_idx[i] = u(codelength);
+                uint32_t codelength = CeilLog2(pExt->vps_num_rep_formats_minus1 + 1);
+                pExt->vps_rep_format_idx[i] = u(codelength);
             }
         }
     }
@@ -1352,41 +1382,41 @@ void VulkanH265Decoder::video_parameter_set_rbspExtension(hevc_video_param_s *pV
 
     for (i = 1; i <= pVideoParamSet->vps_max_layers_minus1; i++)
     {
-        if (pVideoParamSet->numDirectRefLayers[pVideoParamSet->layer_id_in_nuh[i]] == 0)
+        if (pExt->numDirectRefLayers[pExt->layer_id_in_nuh[i]] == 0)
         {
-            pVideoParamSet->poc_lsb_not_present_flag[i] = u(1);
+            pExt->poc_lsb_not_present_flag[i] = u(1);
         }
     }
 
     // dpb_size
-    for (i = 1; i < pVideoParamSet->numOutputLayerSets; i++)
+    for (i = 1; i < pExt->numOutputLayerSets; i++)
     {
         uint32_t currLsIdx = olsIdxToLsIdx(pVideoParamSet, i);
-        pVideoParamSet->sub_layer_flag_info_present_flag[i] = u(1);
+        pExt->sub_layer_flag_info_present_flag[i] = u(1);
 
-        for (j = 0; j <= pVideoParamSet->sub_layers_vps_max_minus1[currLsIdx]; j++)
+        for (j = 0; j <= pExt->sub_layers_vps_max_minus1[currLsIdx]; j++)
         {
-            if (j > 0 && pVideoParamSet->sub_layer_flag_info_present_flag[i])
+            if (j > 0 && pExt->sub_layer_flag_info_present_flag[i])
             {
-                pVideoParamSet->sub_layer_dpb_info_present_flag[i][j] = u(1);
+                pExt->sub_layer_dpb_info_present_flag[i][j] = u(1);
             }
             else if (j == 0)
             {
-                pVideoParamSet->sub_layer_dpb_info_present_flag[i][j] = 1;
+                pExt->sub_layer_dpb_info_present_flag[i][j] = 1;
             }
 
-            if (pVideoParamSet->sub_layer_dpb_info_present_flag[i][j])
+            if (pExt->sub_layer_dpb_info_present_flag[i][j])
             {
                 for (k = 0; k < pVideoParamSet->num_layers_in_id_list[currLsIdx]; k++)
                 {
-                    if (pVideoParamSet->necessaryLayerFlag[i][k] &&
+                    if (pExt->necessaryLayerFlag[i][k] &&
                     (pVideoParamSet->privFlags.vps_base_layer_internal_flag || (pVideoParamSet->layer_set_layer_id_list[currLsIdx][k] != 0) ))
                     {
-                        pVideoParamSet->max_vps_dec_pic_buffering_minus1[i][k][j] = ue();
+                        pExt->max_vps_dec_pic_buffering_minus1[i][k][j] = ue();
                     }
                 }
-                pVideoParamSet->max_vps_num_reorder_pics[i][j] = ue();
-                pVideoParamSet->max_vps_latency_increase_plus1[i][j] = ue();
+                pExt->max_vps_num_reorder_pics[i][j] = ue();
+                pExt->max_vps_latency_increase_plus1[i][j] = ue();
             }
         }
     }
@@ -1397,46 +1427,50 @@ void VulkanH265Decoder::video_parameter_set_rbspExtension(hevc_video_param_s *pV
 
 void VulkanH265Decoder::deriveNecessaryLayerFlags(hevc_video_param_s *pVideoParamSet, uint32_t olsIdx)
 {
+    hevc_video_param_ext_s* pExt = pVideoParamSet->pExtension.get();
+    assert(pExt != nullptr);
     uint32_t lsIdx = olsIdxToLsIdx(pVideoParamSet, olsIdx);
     for (uint32_t lsLayerIdx = 0; lsLayerIdx < pVideoParamSet->num_layers_in_id_list[lsIdx]; lsLayerIdx++)
     {
-        pVideoParamSet->necessaryLayerFlag[olsIdx][lsLayerIdx] = 0;
+        pExt->necessaryLayerFlag[olsIdx][lsLayerIdx] = 0;
     }
     for (uint32_t lsLayerIdx = 0; lsLayerIdx < pVideoParamSet->num_layers_in_id_list[lsIdx]; lsLayerIdx++)
     {
-        if (pVideoParamSet->output_layer_flag[olsIdx][lsLayerIdx])
+        if (pExt->output_layer_flag[olsIdx][lsLayerIdx])
         {
-            pVideoParamSet->necessaryLayerFlag[olsIdx][lsLayerIdx] = 1;
+            pExt->necessaryLayerFlag[olsIdx][lsLayerIdx] = 1;
             uint32_t currLayerId = pVideoParamSet->layer_set_layer_id_list[lsIdx][lsLayerIdx];
             for (uint32_t rLsLayerIdx = 0; rLsLayerIdx < lsLayerIdx; rLsLayerIdx++ )
             {
                 uint32_t refLayerId = pVideoParamSet->layer_set_layer_id_list[lsIdx][rLsLayerIdx];
-                if (pVideoParamSet->DependencyFlag[pVideoParamSet->layer_id_in_nuh[currLayerId]][pVideoParamSet->layer_id_in_nuh[refLayerId]])
+                if (pExt->DependencyFlag[pExt->layer_id_in_nuh[currLayerId]][pExt->layer_id_in_nuh[refLayerId]])
                 {
-                    pVideoParamSet->necessaryLayerFlag[olsIdx][rLsLayerIdx] = 1;
+                    pExt->necessaryLayerFlag[olsIdx][rLsLayerIdx] = 1;
                 }
             }
         }
     }
-    pVideoParamSet->numNecessaryLayers[olsIdx] = 0;
+    pExt->numNecessaryLayers[olsIdx] = 0;
     for (uint32_t lsLayerIdx = 0; lsLayerIdx < pVideoParamSet->num_layers_in_id_list[lsIdx]; lsLayerIdx++)
     {
-        pVideoParamSet->numNecessaryLayers[olsIdx] += pVideoParamSet->necessaryLayerFlag[olsIdx][lsLayerIdx];
+        pExt->numNecessaryLayers[olsIdx] += pExt->necessaryLayerFlag[olsIdx][lsLayerIdx];
     }
 
-    pVideoParamSet->numOutputLayersInOutputLayerSet[olsIdx] = 0;
+    pExt->numOutputLayersInOutputLayerSet[olsIdx] = 0;
     for (uint32_t j = 0; j < pVideoParamSet->num_layers_in_id_list[olsIdxToLsIdx(pVideoParamSet, olsIdx)]; j++)
     {
-        pVideoParamSet->numOutputLayersInOutputLayerSet[olsIdx] += (pVideoParamSet->output_layer_flag[olsIdx][j]);
-        if (pVideoParamSet->output_layer_flag[olsIdx][j])
+        pExt->numOutputLayersInOutputLayerSet[olsIdx] += (pExt->output_layer_flag[olsIdx][j]);
+        if (pExt->output_layer_flag[olsIdx][j])
         {
-            pVideoParamSet->olsHighestOutputLayerId[olsIdx] = pVideoParamSet->layer_set_layer_id_list[olsIdxToLsIdx(pVideoParamSet, olsIdx)][j];
+            pExt->olsHighestOutputLayerId[olsIdx] = pVideoParamSet->layer_set_layer_id_list[olsIdxToLsIdx(pVideoParamSet, olsIdx)][j];
         }
     }
 }
 
 void VulkanH265Decoder::setRefLayers(hevc_video_param_s *pVideoParamSet)
 {
+    hevc_video_param_ext_s* pExt = pVideoParamSet->pExtension.get();
+    assert(pExt != nullptr);
     uint32_t i, j, k, h;
     uint32_t d, r, p;
 
@@ -1445,12 +1479,12 @@ void VulkanH265Decoder::setRefLayers(hevc_video_param_s *pVideoParamSet)
     {
         for (j = 0; j <= pVideoParamSet->vps_max_layers_minus1; j++)
         {
-            pVideoParamSet->DependencyFlag[i][j] = pVideoParamSet->direct_dependency_flag[i][j];
+            pExt->DependencyFlag[i][j] = pExt->direct_dependency_flag[i][j];
             for (k = 0; k < i; k++)
             {
-                if (pVideoParamSet->direct_dependency_flag[i][k] && pVideoParamSet->DependencyFlag[k][j])
+                if (pExt->direct_dependency_flag[i][k] && pExt->DependencyFlag[k][j])
                 {
-                    pVideoParamSet->DependencyFlag[i][j] = 1;
+                    pExt->DependencyFlag[i][j] = 1;
                 }
             }
         }
@@ -1459,80 +1493,82 @@ void VulkanH265Decoder::setRefLayers(hevc_video_param_s *pVideoParamSet)
     //idDirectRefLayer, idRefLayer, idPredictedLayer
     for (i = 0; i <= pVideoParamSet->vps_max_layers_minus1; i++ )
     {
-        uint32_t iNuhLId =  pVideoParamSet->layer_id_in_nuh[i];
+        uint32_t iNuhLId =  pExt->layer_id_in_nuh[i];
         for (j = 0, d = 0, r = 0, p = 0; j <= pVideoParamSet->vps_max_layers_minus1; j++)
         {
-            uint32_t jNuhLid =  pVideoParamSet->layer_id_in_nuh[j];
-            if (pVideoParamSet->direct_dependency_flag[i][j])
+            uint32_t jNuhLid =  pExt->layer_id_in_nuh[j];
+            if (pExt->direct_dependency_flag[i][j])
             {
-                pVideoParamSet->idDirectRefLayer[iNuhLId][d++] = jNuhLid;
+                pExt->idDirectRefLayer[iNuhLId][d++] = jNuhLid;
             }
-            if (pVideoParamSet->DependencyFlag[i][j])
+            if (pExt->DependencyFlag[i][j])
             {
-                pVideoParamSet->idRefLayer[iNuhLId][r++] = jNuhLid;
+                pExt->idRefLayer[iNuhLId][r++] = jNuhLid;
             }
-            if (pVideoParamSet->DependencyFlag[j][i])
+            if (pExt->DependencyFlag[j][i])
             {
-                pVideoParamSet->idPredictedLayer[iNuhLId][p++] = jNuhLid;
+                pExt->idPredictedLayer[iNuhLId][p++] = jNuhLid;
             }
-            pVideoParamSet->numDirectRefLayers[iNuhLId] = d;
-            pVideoParamSet->numRefLayers[iNuhLId] = r;
-            pVideoParamSet->numPredictedLayers[iNuhLId] = p;
+            pExt->numDirectRefLayers[iNuhLId] = d;
+            pExt->numRefLayers[iNuhLId] = r;
+            pExt->numPredictedLayers[iNuhLId] = p;
         }
     }
 
     for (i = 0; i < MAX_NUM_LAYER_IDS; i++)
     {
-        pVideoParamSet->layerIdInListFlag[i] = 0;
+        pExt->layerIdInListFlag[i] = 0;
     }
     for (i = 0, k = 0; i <= pVideoParamSet->vps_max_layers_minus1; i++ )
     {
-        uint32_t iNuhLId = pVideoParamSet->layer_id_in_nuh[i];
-        if (pVideoParamSet->numDirectRefLayers[iNuhLId] == 0)
+        uint32_t iNuhLId = pExt->layer_id_in_nuh[i];
+        if (pExt->numDirectRefLayers[iNuhLId] == 0)
         {
-            pVideoParamSet->treePartitionLayerIdList[k][0] = iNuhLId;
-            for (j = 0, h = 1; j < pVideoParamSet->numPredictedLayers[iNuhLId]; j++)
+            pExt->treePartitionLayerIdList[k][0] = iNuhLId;
+            for (j = 0, h = 1; j < pExt->numPredictedLayers[iNuhLId]; j++)
             {
-                uint32_t predLId = pVideoParamSet->idPredictedLayer[iNuhLId][j];
-                if (!pVideoParamSet->layerIdInListFlag[predLId])
+                uint32_t predLId = pExt->idPredictedLayer[iNuhLId][j];
+                if (!pExt->layerIdInListFlag[predLId])
                 {
-                    pVideoParamSet->treePartitionLayerIdList[k][h++] = predLId;
-                    pVideoParamSet->layerIdInListFlag[predLId] = 1;
+                    pExt->treePartitionLayerIdList[k][h++] = predLId;
+                    pExt->layerIdInListFlag[predLId] = 1;
                 }
             }
-            pVideoParamSet->numLayersInTreePartition[k++] = h;
+            pExt->numLayersInTreePartition[k++] = h;
         }
     }
-    pVideoParamSet->numIndependentLayers = k;
+    pExt->numIndependentLayers = k;
 }
 
 void VulkanH265Decoder::initNumViews(hevc_video_param_s *pVideoParamSet)
 {
+    hevc_video_param_ext_s* pExt = pVideoParamSet->pExtension.get();
+    assert(pExt != nullptr);
     uint32_t NumViews = 1;
     uint32_t ScalabilityId[MAX_NUM_LAYER_IDS][MAX_NUM_SCALABILITY_TYPES];
     memset(ScalabilityId, 0, MAX_NUM_LAYER_IDS*MAX_NUM_SCALABILITY_TYPES*sizeof(uint32_t));
     for (uint32_t i = 0; i <= pVideoParamSet->vps_max_layers_minus1; i++ )
     {
-        uint32_t lId = pVideoParamSet->layer_id_in_nuh[i];
+        uint32_t lId = pExt->layer_id_in_nuh[i];
         for (uint32_t smIdx = 0, j = 0; smIdx < MAX_NUM_SCALABILITY_TYPES; smIdx++)
         {
-            if (pVideoParamSet->scalability_mask_flag[smIdx])
+            if (pExt->scalability_mask_flag[smIdx])
             {
-                ScalabilityId[i][smIdx] = pVideoParamSet->dimension_id[i][j++];
+                ScalabilityId[i][smIdx] = pExt->dimension_id[i][j++];
             }
             else
             {
                 ScalabilityId[i][smIdx] = 0;
             }
         }
-        pVideoParamSet->viewOrderIdx[lId] = ScalabilityId[i][1];
+        pExt->viewOrderIdx[lId] = ScalabilityId[i][1];
         if (i > 0)
         {
             uint32_t newViewFlag = 1;
             for (uint32_t j = 0; j < i; j++)
             {
-                if (pVideoParamSet->viewOrderIdx[lId] ==
-                pVideoParamSet->viewOrderIdx[pVideoParamSet->layer_id_in_nuh[j]])
+                if (pExt->viewOrderIdx[lId] ==
+                pExt->viewOrderIdx[pExt->layer_id_in_nuh[j]])
                 {
                     newViewFlag = 0;
                 }
@@ -1540,18 +1576,22 @@ void VulkanH265Decoder::initNumViews(hevc_video_param_s *pVideoParamSet)
             NumViews += newViewFlag;
         }
     }
-    pVideoParamSet->numViews = NumViews;
+    pExt->numViews = NumViews;
 }
 
 uint32_t VulkanH265Decoder::olsIdxToLsIdx(hevc_video_param_s *pVideoParamSet, uint32_t i)
 {
-    return (i < pVideoParamSet->vps_num_layer_sets + pVideoParamSet->num_add_layer_sets ) ? i : pVideoParamSet->layer_set_idx_for_ols_minus1[i] + 1 ;
+    hevc_video_param_ext_s* pExt = pVideoParamSet->pExtension.get();
+    assert(pExt != nullptr);
+    return (i < pVideoParamSet->vps_num_layer_sets + pExt->num_add_layer_sets ) ? i : pExt->layer_set_idx_for_ols_minus1[i] + 1 ;
 }
 
 uint32_t VulkanH265Decoder::inferoutput_layer_flag(hevc_video_param_s *pVideoParamSet, uint32_t i, uint32_t j)
 {
+    hevc_video_param_ext_s* pExt = pVideoParamSet->pExtension.get();
+    assert(pExt != nullptr);
     uint32_t output_layer_flag = 0;
-    switch ( pVideoParamSet->default_output_layer_idc )
+    switch ( pExt->default_output_layer_idc )
     {
         case 0:
             output_layer_flag = 1;
@@ -1573,8 +1613,10 @@ uint32_t VulkanH265Decoder::inferoutput_layer_flag(hevc_video_param_s *pVideoPar
 
 uint32_t VulkanH265Decoder::xGetDimBitOffset(hevc_video_param_s *pVideoParamSet, uint32_t j)
 {
+    hevc_video_param_ext_s* pExt = pVideoParamSet->pExtension.get();
+    assert(pExt != nullptr);
     uint32_t dimBitOffset = 0;
-    if (pVideoParamSet->privFlags.splitting_flag && j == pVideoParamSet->numScalabilityTypes)
+    if (pVideoParamSet->privFlags.splitting_flag && j == pExt->numScalabilityTypes)
     {
         dimBitOffset = 6;
     }
@@ -1582,7 +1624,7 @@ uint32_t VulkanH265Decoder::xGetDimBitOffset(hevc_video_param_s *pVideoParamSet,
     {
         for (uint32_t dimIdx = 0; dimIdx <= j-1; dimIdx++)
         {
-            dimBitOffset += pVideoParamSet->dimension_id_len[dimIdx];
+            dimBitOffset += pExt->dimension_id_len[dimIdx];
         }
     }
     return dimBitOffset;
@@ -2014,10 +2056,11 @@ void VulkanH265Decoder::vui_parameters(hevc_seq_param_s *sps, int sps_max_sub_la
 }
 
 
-void VulkanH265Decoder::sub_layer_hrd_parameters(StdVideoH265SubLayerHrdParameters* pStdSubLayerHrdParameters,
-        int /*subLayerId*/, int cpb_cnt_minus1, int sub_pic_hrd_params_present_flag)
+void VulkanH265Decoder::sub_layer_hrd_parameters(StdVideoH265SubLayerHrdParameters* pStdSubLayerHrdParametersList,
+        int subLayerId, int cpb_cnt_minus1, int sub_pic_hrd_params_present_flag)
 {
-    int CpbCnt = cpb_cnt_minus1 /*[subLayerId]*/;
+    StdVideoH265SubLayerHrdParameters* pStdSubLayerHrdParameters = &pStdSubLayerHrdParametersList[subLayerId];
+    int CpbCnt = cpb_cnt_minus1;
     for (int i = 0; i <= CpbCnt; i++)
     {
         pStdSubLayerHrdParameters->bit_rate_value_minus1[i] = ue();
@@ -2212,7 +2255,7 @@ bool VulkanH265Decoder::slice_header(int nal_unit_type, int nuh_temporal_id_plus
                 return false;
             }
         }
-        if (((m_nuh_layer_id > 0) && !vps->poc_lsb_not_present_flag[vps->LayerIdxInVps[m_nuh_layer_id]]) || !IdrPicFlag) {
+        if (((m_nuh_layer_id > 0) && !vps->GetExtension().poc_lsb_not_present_flag[vps->GetExtension().LayerIdxInVps[m_nuh_layer_id]]) || !IdrPicFlag) {
             slh->pic_order_cnt_lsb = (uint16_t)u(sps->log2_max_pic_order_cnt_lsb_minus4 + 4);
         }
 
@@ -2289,62 +2332,333 @@ bool VulkanH265Decoder::slice_header(int nal_unit_type, int nuh_temporal_id_plus
                 m_NumPocTotalCurr += UsedByCurrPicLt;
             }
         }
-    }
 
-    if (m_nuh_layer_id > 0 && !vps->privFlags.default_ref_layers_active_flag &&
-          vps->numDirectRefLayers[m_nuh_layer_id] > 0) {
-        slh->inter_layer_pred_enabled_flag = (uint8_t) u(1);
+        if (m_nuh_layer_id > 0 && !vps->privFlags.default_ref_layers_active_flag &&
+              vps->GetExtension().numDirectRefLayers[m_nuh_layer_id] > 0) {
+            slh->inter_layer_pred_enabled_flag = (uint8_t) u(1);
 
-        if (slh->inter_layer_pred_enabled_flag && vps->numDirectRefLayers[m_nuh_layer_id] > 1) {
-            if (!vps->privFlags.max_one_active_ref_layer_flag) {
-                uint32_t codelength = CeilLog2(vps->numDirectRefLayers[m_nuh_layer_id]);
-                slh->num_inter_layer_ref_pics_minus1 = (uint8_t) u(codelength);
+            if (slh->inter_layer_pred_enabled_flag && vps->GetExtension().numDirectRefLayers[m_nuh_layer_id] > 1) {
+                if (!vps->privFlags.max_one_active_ref_layer_flag) {
+                    uint32_t codelength = CeilLog2(vps->GetExtension().numDirectRefLayers[m_nuh_layer_id]);
+                    slh->num_inter_layer_ref_pics_minus1 = (uint8_t) u(codelength);
 
-                getNumActiveRefLayerPics(vps, slh);
+                    getNumActiveRefLayerPics(vps, slh);
 
-                if (slh->numActiveRefLayerPics != vps->numDirectRefLayers[m_nuh_layer_id]) {
-                    for (uint32_t i = 0; i < slh->numActiveRefLayerPics; i++) {
-                        codelength = CeilLog2(vps->numDirectRefLayers[m_nuh_layer_id]);
-                        slh->inter_layer_pred_layer_idc[i] = (uint8_t) u(codelength);
+                    if (slh->numActiveRefLayerPics != vps->GetExtension().numDirectRefLayers[m_nuh_layer_id]) {
+                        for (uint32_t i = 0; i < slh->numActiveRefLayerPics; i++) {
+                            codelength = CeilLog2(vps->GetExtension().numDirectRefLayers[m_nuh_layer_id]);
+                            slh->inter_layer_pred_layer_idc[i] = (uint8_t) u(codelength);
+                        }
                     }
                 }
             }
         }
-    }
 
-    if (m_nuh_layer_id > 0) {
-        getNumActiveRefLayerPics(vps, slh);
-    }
-    if (sps->flags.sample_adaptive_offset_enabled_flag) {
-        u(1 + 1); // slice_sao_luma_flag, slice_sao_chroma_flag
+        if (m_nuh_layer_id > 0) {
+            getNumActiveRefLayerPics(vps, slh);
+        }
+
+        const int ChromaArrayType = sps->flags.separate_colour_plane_flag ? 0 : sps->chroma_format_idc;
+        if (sps->flags.sample_adaptive_offset_enabled_flag) {
+            slh->slice_sao_luma_flag = (uint8_t)u(1);
+            if (ChromaArrayType != 0) {
+                slh->slice_sao_chroma_flag = (uint8_t)u(1);
+            }
+        }
+        if (slh->slice_type == SLICE_TYPE_P || slh->slice_type == SLICE_TYPE_B) {
+            if (u(1)) { // num_ref_idx_active_override_flag
+                uint32_t num_ref_idx_l0_active_minus1 = ue();
+                uint32_t num_ref_idx_l1_active_minus1 = (slh->slice_type == SLICE_TYPE_B) ? ue() : 0;
+                if ((num_ref_idx_l0_active_minus1 > 14) || (num_ref_idx_l1_active_minus1 > 14)) {
+                    nvParserLog("Invalid num_ref_idx_lx_active_minus1 (l0:%d, l1:%d)\n",
+                                num_ref_idx_l0_active_minus1, num_ref_idx_l1_active_minus1);
+                    return false;
+                }
+                slh->num_ref_idx_l0_active_minus1 = (uint8_t)num_ref_idx_l0_active_minus1;
+                slh->num_ref_idx_l1_active_minus1 = (uint8_t)num_ref_idx_l1_active_minus1;
+            } else {
+                slh->num_ref_idx_l0_active_minus1 = pps->num_ref_idx_l0_default_active_minus1;
+                slh->num_ref_idx_l1_active_minus1 = pps->num_ref_idx_l1_default_active_minus1;
+            }
+            if (slh->slice_type != SLICE_TYPE_B) {
+                slh->num_ref_idx_l1_active_minus1 = 0;
+            }
+
+            // NumPicTotalCurr (7-55), the current picture is never a reference without the SCC extension
+            const int NumPicTotalCurr = m_NumPocTotalCurr + slh->numActiveRefLayerPics;
+            if (pps->flags.lists_modification_present_flag && (NumPicTotalCurr > 1)) {
+                // ref_pic_lists_modification()
+                const int v = CeilLog2(NumPicTotalCurr);
+                slh->ref_pic_list_modification_flag_l0 = (uint8_t)u(1);
+                if (slh->ref_pic_list_modification_flag_l0) {
+                    for (uint32_t i = 0; i <= slh->num_ref_idx_l0_active_minus1; i++) {
+                        slh->list_entry_l0[i] = (uint8_t)u(v);
+                    }
+                }
+                if (slh->slice_type == SLICE_TYPE_B) {
+                    slh->ref_pic_list_modification_flag_l1 = (uint8_t)u(1);
+                    if (slh->ref_pic_list_modification_flag_l1) {
+                        for (uint32_t i = 0; i <= slh->num_ref_idx_l1_active_minus1; i++) {
+                            slh->list_entry_l1[i] = (uint8_t)u(v);
+                        }
+                    }
+                }
+            }
+            if (slh->slice_type == SLICE_TYPE_B) {
+                slh->mvd_l1_zero_flag = (uint8_t)u(1);
+            }
+            if (pps->flags.cabac_init_present_flag) {
+                slh->cabac_init_flag = (uint8_t)u(1);
+            }
+            if (slh->slice_temporal_mvp_enabled_flag) {
+                if (slh->slice_type == SLICE_TYPE_B) {
+                    slh->collocated_from_l0_flag = (uint8_t)u(1);
+                }
+                const uint32_t num_ref_idx_active_minus1 = slh->collocated_from_l0_flag ? slh->num_ref_idx_l0_active_minus1 :
+                                                                                          slh->num_ref_idx_l1_active_minus1;
+                if (num_ref_idx_active_minus1 > 0) {
+                    uint32_t collocated_ref_idx = ue();
+                    if (collocated_ref_idx > num_ref_idx_active_minus1) {
+                        nvParserLog("Invalid collocated_ref_idx (%d/%d)\n", collocated_ref_idx, num_ref_idx_active_minus1);
+                        return false;
+                    }
+                    slh->collocated_ref_idx = (uint8_t)collocated_ref_idx;
+                }
+            }
+            if ((pps->flags.weighted_pred_flag && (slh->slice_type == SLICE_TYPE_P)) ||
+                (pps->flags.weighted_bipred_flag && (slh->slice_type == SLICE_TYPE_B))) {
+                slh->weighted_pred_flag = 1;
+                if (!pred_weight_table(slh, ChromaArrayType)) {
+                    return false;
+                }
+            }
+            uint32_t five_minus_max_num_merge_cand = ue();
+            if (five_minus_max_num_merge_cand > 4) {
+                nvParserLog("Invalid five_minus_max_num_merge_cand (%d)\n", five_minus_max_num_merge_cand);
+                return false;
+            }
+            slh->five_minus_max_num_merge_cand = (uint8_t)five_minus_max_num_merge_cand;
+        }
+        int32_t slice_qp_delta = se();
+        int32_t SliceQpY = 26 + pps->init_qp_minus26 + slice_qp_delta;
+        if ((SliceQpY < -6 * (int32_t)sps->bit_depth_luma_minus8) || (SliceQpY > 51)) {
+            nvParserLog("Invalid slice_qp_delta (%d)\n", slice_qp_delta);
+            return false;
+        }
+        slh->slice_qp_delta = (int8_t)slice_qp_delta;
+        if (pps->flags.pps_slice_chroma_qp_offsets_present_flag) {
+            int32_t slice_cb_qp_offset = se();
+            int32_t slice_cr_qp_offset = se();
+            if ((slice_cb_qp_offset < -12) || (slice_cb_qp_offset > 12) ||
+                (slice_cr_qp_offset < -12) || (slice_cr_qp_offset > 12)) {
+                nvParserLog("Invalid slice_crcb_qp_offset (cb:%d,cr:%d)\n", slice_cb_qp_offset, slice_cr_qp_offset);
+                return false;
+            }
+            slh->slice_cb_qp_offset = (int8_t)slice_cb_qp_offset;
+            slh->slice_cr_qp_offset = (int8_t)slice_cr_qp_offset;
+        }
+        if (pps->flags.chroma_qp_offset_list_enabled_flag) {
+            slh->cu_chroma_qp_offset_enabled_flag = (uint8_t)u(1);
+        }
+        if (pps->flags.deblocking_filter_override_enabled_flag) {
+            slh->deblocking_filter_override_flag = (uint8_t)u(1);
+        }
+        slh->slice_deblocking_filter_disabled_flag = pps->flags.pps_deblocking_filter_disabled_flag;
+        slh->slice_beta_offset_div2 = pps->pps_beta_offset_div2;
+        slh->slice_tc_offset_div2 = pps->pps_tc_offset_div2;
+        if (slh->deblocking_filter_override_flag) {
+            slh->slice_deblocking_filter_disabled_flag = (uint8_t)u(1);
+            if (!slh->slice_deblocking_filter_disabled_flag) {
+                int32_t beta_offset_div2 = se();
+                int32_t tc_offset_div2 = se();
+                if ((beta_offset_div2 < -6) || (beta_offset_div2 > 6) || (tc_offset_div2 < -6) || (tc_offset_div2 > 6)) {
+                    nvParserLog("Invalid slice deblocking filter parameters (beta=%d, tc=%d)\n", beta_offset_div2, tc_offset_div2);
+                    return false;
+                }
+                slh->slice_beta_offset_div2 = (int8_t)beta_offset_div2;
+                slh->slice_tc_offset_div2 = (int8_t)tc_offset_div2;
+            }
+        }
+        slh->slice_loop_filter_across_slices_enabled_flag = pps->flags.pps_loop_filter_across_slices_enabled_flag;
+        if (pps->flags.pps_loop_filter_across_slices_enabled_flag &&
+            (slh->slice_sao_luma_flag || slh->slice_sao_chroma_flag || !slh->slice_deblocking_filter_disabled_flag)) {
+            slh->slice_loop_filter_across_slices_enabled_flag = (uint8_t)u(1);
+        }
+    }
+
+    // Entry points of the substreams that follow the first one, kept as offsets
+    // from the start of the slice segment data until the data is located.
+    const uint32_t sliceIndex = m_bitstreamData.GetStreamMarkersCount();
+    const bool recordSliceSegment = (sliceIndex < MAX_SLICES);
+    uint32_t firstEntryPoint = 0;
+    if (recordSliceSegment) {
+        // Drop what was recorded for a slice segment discarded after its header
+        m_sliceSegments.resize(sliceIndex);
+        if (sliceIndex > 0) {
+            firstEntryPoint = m_sliceSegments[sliceIndex - 1].firstEntryPoint + m_sliceSegments[sliceIndex - 1].numEntryPoints;
+        }
+        m_entryPointOffsets.resize(firstEntryPoint);
+    }
+    uint32_t num_entry_point_offsets = 0;
+    uint64_t lastEntryPoint = 0;
+    if (pps->flags.tiles_enabled_flag || pps->flags.entropy_coding_sync_enabled_flag) {
+        num_entry_point_offsets = ue();
+        const uint32_t numTileColumns = pps->num_tile_columns_minus1 + 1;
+        const uint32_t maxEntryPoints = !pps->flags.tiles_enabled_flag ? (PicHeightInCtbsY - 1) :
+                                        !pps->flags.entropy_coding_sync_enabled_flag ? (numTileColumns * (pps->num_tile_rows_minus1 + 1) - 1) :
+                                        (numTileColumns * PicHeightInCtbsY - 1);
+        if (num_entry_point_offsets > maxEntryPoints) {
+            nvParserLog("Invalid num_entry_point_offsets (%d/%d)\n", num_entry_point_offsets, maxEntryPoints);
+            return false;
+        }
+        if (num_entry_point_offsets > 0) {
+            uint32_t offset_len_minus1 = ue();
+            if (offset_len_minus1 > 31) {
+                nvParserLog("Invalid offset_len_minus1 (%d)\n", offset_len_minus1);
+                return false;
+            }
+            for (uint32_t i = 0; i < num_entry_point_offsets; i++) {
+                lastEntryPoint += (uint64_t)u(offset_len_minus1 + 1) + 1; // entry_point_offset_minus1[i]
+                if (recordSliceSegment) {
+                    m_entryPointOffsets.push_back((uint32_t)std::min<uint64_t>(lastEntryPoint, std::numeric_limits<uint32_t>::max()));
+                }
+            }
+        }
     }
-    if (slh->slice_type == SLICE_TYPE_P || slh->slice_type == SLICE_TYPE_B) {
-        if (u(1)) { // num_ref_idx_active_override_flag
-            slh->num_ref_idx_l0_active_minus1 = (uint8_t) ue();
-            if(slh->slice_type == SLICE_TYPE_B)
-                slh->num_ref_idx_l1_active_minus1 = (uint8_t) ue();
-        } else {
-            slh->num_ref_idx_l0_active_minus1 = pps->num_ref_idx_l0_default_active_minus1;
-            slh->num_ref_idx_l1_active_minus1 = pps->num_ref_idx_l1_default_active_minus1;
+    if (pps->flags.slice_segment_header_extension_present_flag) {
+        uint32_t slice_segment_header_extension_length = ue();
+        if (slice_segment_header_extension_length > 256) {
+            nvParserLog("Invalid slice_segment_header_extension_length (%d)\n", slice_segment_header_extension_length);
+            return false;
         }
-        if (slh->slice_type != SLICE_TYPE_B) {
-            slh->num_ref_idx_l1_active_minus1 = 0;
+        for (uint32_t i = 0; i < slice_segment_header_extension_length; i++) {
+            u(8); // slice_segment_header_extension_data_byte
         }
     }
+    u(1); // alignment_bit_equal_to_one
+    byte_alignment();
+
+    const int64_t sliceDataOffset = consumed_bytes_offset();
+    if (sliceDataOffset >= m_nalu.end_offset) {
+        nvParserLog("Slice segment header exceeds the NAL unit\n");
+        return false;
+    }
+
+    if (recordSliceSegment) {
+        const uint32_t sliceDataSize = (uint32_t)(m_nalu.end_offset - sliceDataOffset);
+        if (lastEntryPoint >= sliceDataSize) {
+            nvParserLog("Invalid entry points, the last substream starts at %lld of %d bytes\n",
+                        (long long)lastEntryPoint, sliceDataSize);
+            num_entry_point_offsets = 0;
+            m_entryPointOffsets.resize(firstEntryPoint);
+        }
+        for (uint32_t i = 0; i < num_entry_point_offsets; i++) {
+            m_entryPointOffsets[firstEntryPoint + i] += (uint32_t)sliceDataOffset;
+        }
+
+        VkParserHevcSliceSegment sliceSegment;
+        memset(&sliceSegment, 0, sizeof(sliceSegment));
+        sliceSegment.slice_segment_address = slh->slice_segment_address;
+        sliceSegment.sliceDataOffset = (uint32_t)sliceDataOffset;
+        sliceSegment.sliceDataSize = sliceDataSize;
+        sliceSegment.firstEntryPoint = firstEntryPoint;
+        sliceSegment.numEntryPoints = num_entry_point_offsets;
+        sliceSegment.slice_type = slh->slice_type;
+        sliceSegment.dependent_slice_segment_flag = dependent_slice_segment_flag;
+        sliceSegment.SliceQpY = (int8_t)(26 + pps->init_qp_minus26 + slh->slice_qp_delta);
+        sliceSegment.slice_cb_qp_offset = slh->slice_cb_qp_offset;
+        sliceSegment.slice_cr_qp_offset = slh->slice_cr_qp_offset;
+        sliceSegment.slice_sao_luma_flag = slh->slice_sao_luma_flag;
+        sliceSegment.slice_sao_chroma_flag = slh->slice_sao_chroma_flag;
+        sliceSegment.slice_deblocking_filter_disabled_flag = slh->slice_deblocking_filter_disabled_flag;
+        sliceSegment.slice_loop_filter_across_slices_enabled_flag = slh->slice_loop_filter_across_slices_enabled_flag;
+        sliceSegment.cu_chroma_qp_offset_enabled_flag = slh->cu_chroma_qp_offset_enabled_flag;
+        sliceSegment.cabac_init_flag = slh->cabac_init_flag;
+        sliceSegment.mvd_l1_zero_flag = slh->mvd_l1_zero_flag;
+        sliceSegment.collocated_from_l0_flag = slh->collocated_from_l0_flag;
+        sliceSegment.slice_beta_offset_div2 = slh->slice_beta_offset_div2;
+        sliceSegment.slice_tc_offset_div2 = slh->slice_tc_offset_div2;
+        sliceSegment.MaxNumMergeCand = (uint8_t)(5 - slh->five_minus_max_num_merge_cand);
+        sliceSegment.num_ref_idx_l0_active_minus1 = slh->num_ref_idx_l0_active_minus1;
+        sliceSegment.num_ref_idx_l1_active_minus1 = slh->num_ref_idx_l1_active_minus1;
+        sliceSegment.collocated_ref_idx = slh->collocated_ref_idx;
+        sliceSegment.weighted_pred_flag = slh->weighted_pred_flag;
+        m_sliceSegments.push_back(sliceSegment);
+    }
 
     m_slh = *slh;
     return true;
 }
 
+// 7.3.6.3
+bool VulkanH265Decoder::pred_weight_table(hevc_slice_header_s *slh, int ChromaArrayType)
+{
+    hevc_pred_weight_table_s *pwt = &slh->pwt;
+
+    uint32_t luma_log2_weight_denom = ue();
+    if (luma_log2_weight_denom > 7) {
+        nvParserLog("Invalid luma_log2_weight_denom (%d)\n", luma_log2_weight_denom);
+        return false;
+    }
+    pwt->luma_log2_weight_denom = (uint8_t)luma_log2_weight_denom;
+    if (ChromaArrayType != 0) {
+        int32_t delta_chroma_log2_weight_denom = se();
+        int32_t ChromaLog2WeightDenom = (int32_t)luma_log2_weight_denom + delta_chroma_log2_weight_denom;
+        if ((ChromaLog2WeightDenom < 0) || (ChromaLog2WeightDenom > 7)) {
+            nvParserLog("Invalid delta_chroma_log2_weight_denom (%d)\n", delta_chroma_log2_weight_denom);
+            return false;
+        }
+        pwt->delta_chroma_log2_weight_denom = (int8_t)delta_chroma_log2_weight_denom;
+    }
+
+    // Without the SCC extension a reference picture never is the current
+    // picture, the weight flags are present for all the entries of the lists.
+    const uint32_t numLists = (slh->slice_type == SLICE_TYPE_B) ? 2 : 1;
+    for (uint32_t list = 0; list < numLists; list++) {
+        const uint32_t num_ref_idx_active = 1 + ((list == 0) ? slh->num_ref_idx_l0_active_minus1 : slh->num_ref_idx_l1_active_minus1);
+        for (uint32_t i = 0; i < num_ref_idx_active; i++) {
+            pwt->luma_weight_flags[list] |= u(1) << i;
+        }
+        if (ChromaArrayType != 0) {
+            for (uint32_t i = 0; i < num_ref_idx_active; i++) {
+                pwt->chroma_weight_flags[list] |= u(1) << i;
+            }
+        }
+        for (uint32_t i = 0; i < num_ref_idx_active; i++) {
+            if ((pwt->luma_weight_flags[list] >> i) & 1) {
+                int32_t delta_luma_weight = se();
+                if ((delta_luma_weight < -128) || (delta_luma_weight > 127)) {
+                    nvParserLog("Invalid delta_luma_weight_l%d (%d)\n", list, delta_luma_weight);
+                    return false;
+                }
+                pwt->delta_luma_weight[list][i] = (int8_t)delta_luma_weight;
+                pwt->luma_offset[list][i] = (int16_t)se();
+            }
+            if ((pwt->chroma_weight_flags[list] >> i) & 1) {
+                for (uint32_t j = 0; j < 2; j++) {
+                    int32_t delta_chroma_weight = se();
+                    if ((delta_chroma_weight < -128) || (delta_chroma_weight > 127)) {
+                        nvParserLog("Invalid delta_chroma_weight_l%d (%d)\n", list, delta_chroma_weight);
+                        return false;
+                    }
+                    pwt->delta_chroma_weight[list][i][j] = (int8_t)delta_chroma_weight;
+                    pwt->delta_chroma_offset[list][i][j] = se();
+                }
+            }
+        }
+    }
+    return true;
+}
+
 uint32_t VulkanH265Decoder::getNumRefLayerPics(const hevc_video_param_s* vps, hevc_slice_header_s *pSliceHeader)
 {
     uint32_t numRefLayerPics = 0;
     uint32_t i, j;
-    for (i = 0, j = 0; i < vps->numDirectRefLayers[m_nuh_layer_id]; i++)
+    for (i = 0, j = 0; i < vps->GetExtension().numDirectRefLayers[m_nuh_layer_id]; i++)
     {
-        uint32_t refLayerIdx = vps->LayerIdxInVps[vps->idDirectRefLayer[m_nuh_layer_id][i]];
-        if (vps->sub_layers_vps_max_minus1[refLayerIdx] >= (pSliceHeader->nuh_temporal_id_plus1 -1) &&
-               ((pSliceHeader->nuh_temporal_id_plus1 - 1) == 0 || vps->max_tid_il_ref_pics_plus1[refLayerIdx][vps->LayerIdxInVps[m_nuh_layer_id]]))
+        uint32_t refLayerIdx = vps->GetExtension().LayerIdxInVps[vps->GetExtension().idDirectRefLayer[m_nuh_layer_id][i]];
+        if (vps->GetExtension().sub_layers_vps_max_minus1[refLayerIdx] >= (pSliceHeader->nuh_temporal_id_plus1 -1) &&
+               ((pSliceHeader->nuh_temporal_id_plus1 - 1) == 0 || vps->GetExtension().max_tid_il_ref_pics_plus1[refLayerIdx][vps->GetExtension().LayerIdxInVps[m_nuh_layer_id]]))
         {
             j++;
         }
@@ -2367,7 +2681,7 @@ void VulkanH265Decoder::getNumActiveRefLayerPics(const hevc_video_param_s* vps,
     {
         pSliceHeader->numActiveRefLayerPics = 0;
     }
-    else if (vps->privFlags.max_one_active_ref_layer_flag || (vps->numDirectRefLayers[m_nuh_layer_id] == 1))
+    else if (vps->privFlags.max_one_active_ref_layer_flag || (vps->GetExtension().numDirectRefLayers[m_nuh_layer_id] == 1))
     {
         pSliceHeader->numActiveRefLayerPics = 1;
     }
@@ -3015,9 +3329,9 @@ void VulkanH265Decoder::reference_picture_set(hevc_slice_header_s *slh, int PicO
         for (int i = 0; i < slh->numActiveRefLayerPics; i++)
         {
             unsigned int layerIdRef = slh->inter_layer_pred_layer_idc[i];
-            unsigned int viewIdCur  = vps->view_id_val[m_nuh_layer_id];
-            unsigned int viewIdZero = vps->view_id_val[0];
-            unsigned int viewIdRef  = vps->view_id_val[layerIdRef];
+            unsigned int viewIdCur  = vps->GetExtension().view_id_val[m_nuh_layer_id];
+            unsigned int viewIdZero = vps->GetExtension().view_id_val[0];
+            unsigned int viewIdRef  = vps->GetExtension().view_id_val[layerIdRef];
             int j;
             // there is a picture picX in the DPB that is in the same access unit as the current picture and has nuh_layer_id equal to RefPicLayerId
             for (j = 0; j < 16; j++) {
@@ -3169,7 +3483,7 @@ void VulkanH265Decoder::sei_payload()
             break;
         }
 
-        // Skip over unknown payloads (NOTE: assumes that emulation prevention bytes are not present)
+        // Skip over unknown payloads (payloadSize and consumed_bits() do not count emulation prevention bytes)
         skip = payloadSize * 8 - (consumed_bits() - bitsUsed);
         if (skip > 0)
             skip_bits(skip);
@@ -3188,5 +3502,6 @@ bool VulkanH265Decoder::GetDisplayMasteringInfo(VkParserDisplayMasteringInfo *pd
 }
 
 const char* hevc_video_param_s::m_refClassId = "h265VpsVideoPictureParametersSet";
+hevc_video_param_ext_s hevc_video_param_s::m_noExtension; // Zero initialized, not stored in the binary
 const char* hevc_seq_param_s::m_refClassId   = "h265SpsVideoPictureParametersSet";
 const char* hevc_pic_param_s::m_refClassId   = "h265PpsVideoPictureParametersSet";
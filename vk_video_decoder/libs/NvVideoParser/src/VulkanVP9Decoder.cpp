@@ -14,18 +14,95 @@
 * limitations under the License.
 */
 
+#include <algorithm>
+
 #include "VulkanVideoParserIf.h"
 
 #include "VulkanVP9Decoder.h"
 
+// Table driven probability adaptation: update factor = max_update_factor * count / count_sat
+static const uint8_t vp9_mode_update_factor[MODE_COUNT_SAT + 1] = {
+      0,   6,  12,  19,  25,  32,  38,  44,  51,  57,  64,  70,  76,
+     83,  89,  96, 102, 108, 115, 121, 128,
+};
+
+static const uint8_t vp9_coef_update_factor[COEF_COUNT_SAT + 1] = {
+      0,   4,   9,  14,  18,  23,  28,  32,  37,  42,  46,  51,  56,
+     60,  65,  70,  74,  79,  84,  88,  93,  98, 102, 107, 112,
+};
+
+static const uint8_t vp9_coef_update_factor_after_key[COEF_COUNT_SAT_AFTER_KEY + 1] = {
+      0,   5,  10,  16,  21,  26,  32,  37,  42,  48,  53,  58,  64,
+     69,  74,  80,  85,  90,  96, 101, 106, 112, 117, 122, 128,
+};
+
+static_assert((MVREF_COUNT_SAT == MODE_COUNT_SAT) && (MVREF_MAX_UPDATE_FACTOR == MODE_MAX_UPDATE_FACTOR) &&
+              (MV_COUNT_SAT == MODE_COUNT_SAT) && (MV_MAX_UPDATE_FACTOR == MODE_MAX_UPDATE_FACTOR),
+              "the inter mode and motion vector adaptation use vp9_mode_update_factor");
+static_assert((COEF_COUNT_SAT == COEF_COUNT_SAT_KEY) && (COEF_MAX_UPDATE_FACTOR == COEF_MAX_UPDATE_FACTOR_KEY) &&
+              (COEF_COUNT_SAT == COEF_COUNT_SAT_AFTER_KEY),
+              "the key frame coefficient adaptation uses vp9_coef_update_factor");
+
+// Index of a subexponential coded probability delta, in the order of
+// increasing cost: the 20 values v with (v % 13) == 6 come first (the
+// merge_index() ordering of the VP9 specification), plus one. The last
+// index can't be reached by a conforming stream, it is kept in range.
+static const uint8_t vp9_inv_map_table[MAX_PROB] = {
+      7,  20,  33,  46,  59,  72,  85,  98, 111, 124, 137, 150, 163, 176, 189, 202,
+    215, 228, 241, 254,   1,   2,   3,   4,   5,   6,   8,   9,  10,  11,  12,  13,
+     14,  15,  16,  17,  18,  19,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,
+     31,  32,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,  47,  48,
+     49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  60,  61,  62,  63,  64,  65,
+     66,  67,  68,  69,  70,  71,  73,  74,  75,  76,  77,  78,  79,  80,  81,  82,
+     83,  84,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,  96,  97,  99, 100,
+    101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 112, 113, 114, 115, 116, 117,
+    118, 119, 120, 121, 122, 123, 125, 126, 127, 128, 129, 130, 131, 132, 133, 134,
+    135, 136, 138, 139, 140, 141, 142, 143, 144, 145, 146, 147, 148, 149, 151, 152,
+    153, 154, 155, 156, 157, 158, 159, 160, 161, 162, 164, 165, 166, 167, 168, 169,
+    170, 171, 172, 173, 174, 175, 177, 178, 179, 180, 181, 182, 183, 184, 185, 186,
+    187, 188, 190, 191, 192, 193, 194, 195, 196, 197, 198, 199, 200, 201, 203, 204,
+    205, 206, 207, 208, 209, 210, 211, 212, 213, 214, 216, 217, 218, 219, 220, 221,
+    222, 223, 224, 225, 226, 227, 229, 230, 231, 232, 233, 234, 235, 236, 237, 238,
+    239, 240, 242, 243, 244, 245, 246, 247, 248, 249, 250, 251, 252, 253, 253,
+};
+
+// Number of leading zero bits of a non-zero value
+static inline uint32_t vp9_clz32(uint32_t x)
+{
+    assert(x != 0);
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanReverse(&index, x);
+    return 31 - index;
+#else
+    return __builtin_clz(x);
+#endif
+}
+
 VulkanVP9Decoder::VulkanVP9Decoder(VkVideoCodecOperationFlagBitsKHR std)
     : VulkanVideoDecoder(std)
+    , m_pCurrPic(nullptr)
+    , m_colorRange()
+    , m_renderWidth()
+    , m_renderHeight()
+    , m_lastWidth()
+    , m_lastHeight()
+    , m_showExistingFrame()
+    , m_frameToShow()
 {
     memset(&m_EntropyLast, 0, sizeof(m_EntropyLast));
     memset(&m_PrevCtx, 0, sizeof(m_PrevCtx));
+    memset(&m_EntropyCurr, 0, sizeof(m_EntropyCurr));
+    memset(&m_ProbSetup, 0, sizeof(m_ProbSetup));
+    memset(&m_PicData, 0, sizeof(m_PicData));
+    memset(&m_pBuffers, 0, sizeof(m_pBuffers));
     memset(&reader, 0, sizeof(vp9_reader));
-    m_pCompressedHeader = NULL;
 }
+
+VulkanVP9Decoder::~VulkanVP9Decoder()
+{
+}
+
 void VulkanVP9Decoder::vp9_init_mbmode_probs(vp9_prob_update_s *pProbSetup)
 {
     uint32_t i, j;
@@ -134,27 +211,37 @@ void VulkanVP9Decoder::GetProbs(vp9_prob_update_s *pProbSetup)
 void VulkanVP9Decoder::vp9_reader_fill()
 {
     vp9_reader *r = &reader;
-    uint32_t buffer_end = r->buffer_end;
-    uint32_t buffer = r->buffer;
+    const uint8_t* buffer = r->buffer;
     VP9_BD_VALUE value = r->value;
     int32_t count = r->count;
-    int32_t shift = BD_VALUE_SIZE - 8 - (count + 8);
-    int32_t loop_end = 0;
-    const int32_t bits_left = (int32_t)((buffer_end - buffer)*CHAR_BIT);
-    const int32_t x = shift + CHAR_BIT - bits_left;
-    if (x >= 0) {
-        count += LOTS_OF_BITS;
-        loop_end = x;
-    }
-    if (x < 0 || bits_left)
-    {
-        while (shift >= loop_end)
-        {
-            count += CHAR_BIT;
-            uint8_t temp = m_pCompressedHeader[r->pos++]; //u( 8);
-            value |= (VP9_BD_VALUE)temp << shift;
-            shift -= CHAR_BIT;
-            buffer++;
+    int32_t shift = BD_VALUE_SIZE - CHAR_BIT - (count + CHAR_BIT);
+    const size_t bytes_left = r->buffer_end - buffer;
+
+    if (bytes_left > sizeof(VP9_BD_VALUE)) {
+        // Load a whole big endian word and keep the bytes that fit
+        VP9_BD_VALUE big_endian_value = 0;
+        for (uint32_t i = 0; i < sizeof(VP9_BD_VALUE); i++) {
+            big_endian_value = (big_endian_value << CHAR_BIT) | buffer[i];
+        }
+        const int32_t bits = (shift & ~(CHAR_BIT - 1)) + CHAR_BIT;
+        count += bits;
+        buffer += bits / CHAR_BIT;
+        value |= (big_endian_value >> (BD_VALUE_SIZE - bits)) << (shift & (CHAR_BIT - 1));
+    } else {
+        // Tail of the partition: zeros are shifted in past the end
+        const int32_t bits_left = (int32_t)(bytes_left * CHAR_BIT);
+        const int32_t x = shift + CHAR_BIT - bits_left;
+        int32_t loop_end = 0;
+        if (x >= 0) {
+            count += LOTS_OF_BITS;
+            loop_end = x;
+        }
+        if ((x < 0) || bits_left) {
+            while (shift >= loop_end) {
+                count += CHAR_BIT;
+                value |= (VP9_BD_VALUE)*buffer++ << shift;
+                shift -= CHAR_BIT;
+            }
         }
     }
     r->buffer = buffer;
@@ -162,22 +249,27 @@ void VulkanVP9Decoder::vp9_reader_fill()
     r->count = count;
 }
 
-int32_t VulkanVP9Decoder::vp9_reader_init(uint32_t size)
+int32_t VulkanVP9Decoder::vp9_reader_init(const uint8_t* pBuffer, uint32_t size)
 {
     int32_t marker_bit = 0;
     vp9_reader *r = &reader;
-    r->buffer_end = 0 + size;
-    r->buffer = 0;
+    r->buffer_end = pBuffer + size;
+    r->buffer = pBuffer;
     r->value = 0;
     r->count = -8;
     r->range = 255;
-    r->pos = 0;
 
     vp9_reader_fill();
     marker_bit = vp9_read_bit();
     return marker_bit != 0;
 }
 
+// True once more bits were read than the partition has
+bool VulkanVP9Decoder::vp9_reader_has_error() const
+{
+    return (reader.count > BD_VALUE_SIZE) && (reader.count < LOTS_OF_BITS);
+}
+
 int32_t VulkanVP9Decoder::vp9_read_bit()
 {
     return vp9_read( 128);
@@ -185,34 +277,26 @@ int32_t VulkanVP9Decoder::vp9_read_bit()
 
 int32_t VulkanVP9Decoder::vp9_read(int32_t probability)
 {
-
     vp9_reader *br = &reader;
-    uint32_t bit = 0;
-    VP9_BD_VALUE value;
-    VP9_BD_VALUE bigsplit;
-    int32_t count;
-    uint32_t range;
-    uint32_t split = 1 + (((br->range - 1) * probability) >> 8);
+    int32_t bit = 0;
+    const uint32_t split = (br->range * probability + (256 - probability)) >> CHAR_BIT;
     if (br->count < 0)
         vp9_reader_fill();
-    value = br->value;
-    count = br->count;
-    bigsplit = (VP9_BD_VALUE)split << (BD_VALUE_SIZE - 8);
+    VP9_BD_VALUE value = br->value;
+    const VP9_BD_VALUE bigsplit = (VP9_BD_VALUE)split << (BD_VALUE_SIZE - CHAR_BIT);
 
-    range = split;
+    uint32_t range = split;
     if (value >= bigsplit)
     {
         range = br->range - split;
         value = value - bigsplit;
         bit = 1;
     }
-    register uint32_t shift = vp9dx_bitreader_norm[range];
-    range <<= shift;
-    value <<= shift;
-    count -= shift;
-    br->value = value;
-    br->count = count;
-    br->range = range;
+    // Renormalize the range to [128, 255]
+    const uint32_t shift = vp9_clz32(range) - (32 - CHAR_BIT);
+    br->value = value << shift;
+    br->count -= shift;
+    br->range = range << shift;
     return bit;
 }
 
@@ -234,10 +318,9 @@ uint32_t VulkanVP9Decoder::UpdateForwardProbability(vp9_prob_update_s *pProbSetu
 
     uint32_t tmp, i, j, k;
 
-    m_pCompressedHeader = pCompressed_Header;
     m_PrevCtx = pProbSetup->pProbTab->a;
 
-    if (vp9_reader_init(pProbSetup->offsetToDctParts) != 0)
+    if (vp9_reader_init(pCompressed_Header, pProbSetup->offsetToDctParts) != 0)
     {
         return NOK;
     }
@@ -311,7 +394,7 @@ uint32_t VulkanVP9Decoder::UpdateForwardProbability(vp9_prob_update_s *pProbSetu
         }
     }
 
-    if(!pProbSetup->keyFrame)
+    if (!pProbSetup->keyFrame && !pProbSetup->intraOnly)
     {
         for (i = 0; i < INTER_MODE_CONTEXTS; i++) {
             for (j = 0; j < VP9_INTER_MODES - 1; j++) {
@@ -423,7 +506,7 @@ uint32_t VulkanVP9Decoder::UpdateForwardProbability(vp9_prob_update_s *pProbSetu
             return (tmp);
     }
 
-    return (OK);
+    return vp9_reader_has_error() ? NOK : OK;
 }
 
 void VulkanVP9Decoder::update_nmv( vp9_prob *const p, const vp9_prob upd_p)
@@ -524,71 +607,20 @@ uint32_t  VulkanVP9Decoder::vp9hwdDecodeCoeffUpdate(
     return (OK);
 }
 
-int32_t VulkanVP9Decoder::get_unsigned_bits(uint32_t num_values)
-{
-    int32_t cat = 0;
-    if (num_values <= 1)
-        return 0;
-    num_values--;
-    while(num_values > 0)
-    {
-        cat++;
-        num_values >>= 1;
-    }
-    return cat;
-}
-
-uint32_t VulkanVP9Decoder::BoolDecodeUniform( uint32_t n)
-{
-    int32_t value, v;
-    int32_t l = get_unsigned_bits(n);
-    int32_t m = (1 << l) - n;
-    if (!l) return 0;
-    value = vp9_read_literal( l - 1);
-    if (value >= m) {
-        v = vp9_read_literal( 1);
-        value = (value << 1) - m + v;
-    }
-    return value;
-}
-
-uint32_t VulkanVP9Decoder::vp9hwdDecodeSubExp( uint32_t k, uint32_t num_syms)
+// Subexponential code of a probability delta in [0, 254]
+uint32_t VulkanVP9Decoder::vp9hwdDecodeTermSubExp()
 {
-    uint32_t i=0, mk=0, value=0;
-    while (1) {
-        int32_t b = (i ? k + i - 1 : k);
-        uint32_t a = (1 << b);
-        if (num_syms <= mk + 3 * a) {
-            value = BoolDecodeUniform( num_syms - mk) + mk;
-            break;
-        } else {
-            value = vp9_read_bit();
-            if (value) {
-                i++;
-                mk += a;
-            } else {
-                value = vp9_read_literal( b) + mk;
-                break;
-            }
-        }
-    }
-    return value;
-}
-
-int32_t VulkanVP9Decoder::merge_index(int32_t v, int32_t n, int32_t modulus)
-{
-    int32_t max1 = (n - 1 - modulus / 2) / modulus + 1;
-    if (v < max1) v = v * modulus + modulus / 2;
-    else
-    {
-        int32_t w;
-        v -= max1;
-        w = v;
-        v += (v + modulus - modulus / 2) / modulus;
-        while (v % modulus == modulus / 2 ||
-            w != v - (v + modulus - modulus / 2) / modulus) v++;
-    }
-    return v;
+    if (!vp9_read_bit())
+        return vp9_read_literal( 4);
+    if (!vp9_read_bit())
+        return vp9_read_literal( 4) + 16;
+    if (!vp9_read_bit())
+        return vp9_read_literal( 5) + 32;
+
+    // Uniform code of the 191 remaining values, in 7 or 8 bits
+    const uint32_t m = (1 << 8) - 191;
+    const uint32_t v = vp9_read_literal( 7);
+    return ((v < m) ? v : ((v << 1) - m + vp9_read_bit())) + 64;
 }
 
 int32_t VulkanVP9Decoder::vp9_inv_recenter_nonneg(int32_t v, int32_t m)
@@ -600,19 +632,20 @@ int32_t VulkanVP9Decoder::vp9_inv_recenter_nonneg(int32_t v, int32_t m)
 
 int32_t VulkanVP9Decoder::inv_remap_prob(int32_t v, int32_t m)
 {
-    const int32_t n = 255;
-    v = merge_index(v, n - 1, MODULUS_PARAM);
+    const int32_t n = MAX_PROB;
+    assert((uint32_t)v < sizeof(vp9_inv_map_table));
+    v = vp9_inv_map_table[v];
     m--;
     if ((m << 1) <= n)
-        return 1 + vp9_inv_recenter_nonneg(v + 1, m);
+        return 1 + vp9_inv_recenter_nonneg(v, m);
     else
-        return n - vp9_inv_recenter_nonneg(v + 1, n - 1 - m);
+        return n - vp9_inv_recenter_nonneg(v, n - 1 - m);
 }
 
 vp9_prob VulkanVP9Decoder::vp9hwdReadProbDiffUpdate( uint8_t oldp)
 {
     int32_t p;
-    int32_t delp = vp9hwdDecodeSubExp( 4, 255 );
+    int32_t delp = vp9hwdDecodeTermSubExp();
     p = (vp9_prob)inv_remap_prob(delp, oldp);
     return p;
 }
@@ -641,61 +674,44 @@ vp9_prob VulkanVP9Decoder::get_binary_prob(uint32_t n0, uint32_t n1)
     return get_prob(n0, n0 + n1);
 }
 
-uint32_t VulkanVP9Decoder::convert_distribution(uint32_t i,
-                            const vp9_tree_index * tree,
-                            vp9_prob probs[],
-                            uint32_t branch_ct[][2],
-                            const uint32_t num_events[],
-                            uint32_t tok0_offset)
+// Blends the probability of the previous frame with the one observed in the
+// branch counts, more of the latter as the counts grow up to count_sat.
+vp9_prob VulkanVP9Decoder::merge_prob(vp9_prob pre_prob, const uint32_t ct[2], const uint8_t* update_factor, uint32_t count_sat)
 {
-    uint32_t left, right;
-
-    if (tree[i] <= 0)
-    {
-        left = num_events[-tree[i] - tok0_offset];
-    }
-    else
-    {
-        left = convert_distribution(tree[i], tree, probs, branch_ct, num_events, tok0_offset);
-    }
-    if (tree[i + 1] <= 0)
-    {
-        right = num_events[-tree[i + 1] - tok0_offset];
-    }
-    else
-    {
-        right = convert_distribution(tree[i + 1], tree, probs, branch_ct, num_events, tok0_offset);
-    }
-    probs[i>>1] = get_binary_prob(left, right);
-    branch_ct[i>>1][0] = left;
-    branch_ct[i>>1][1] = right;
-    return left + right;
+    const uint32_t den = ct[0] + ct[1];
+    if (den == 0)
+        return pre_prob;
+    const uint32_t count = std::min(den, count_sat);
+    return weighted_prob(pre_prob, get_binary_prob(ct[0], ct[1]), update_factor[count]);
 }
 
-void VulkanVP9Decoder::vp9_tree_probs_from_distribution(const vp9_tree_index * tree,
-                                        vp9_prob probs          [ /* n-1 */ ],
-                                        uint32_t branch_ct       [ /* n-1 */ ] [2],
-                                        const uint32_t num_events[ /* n */ ],
-                                        uint32_t tok0_offset)
+// Branch counts of the nodes of a tree from the counts of its leaves. The
+// children of a node always come after it in the tree, so a reverse walk
+// of the nodes sees them first.
+void VulkanVP9Decoder::tree_branch_counts(const vp9_tree_index* tree, uint32_t num_nodes,
+                                          const uint32_t num_events[], uint32_t branch_ct[][2])
 {
-    convert_distribution(0, tree, probs, branch_ct, num_events, tok0_offset);
+    uint32_t node_ct[MAX_PROBS];
+
+    assert(num_nodes <= MAX_PROBS);
+    for (int32_t n = (int32_t)num_nodes - 1; n >= 0; n--)
+    {
+        const vp9_tree_index left = tree[2 * n];
+        const vp9_tree_index right = tree[2 * n + 1];
+        assert((left <= 0 || left > 2 * n) && (right <= 0 || right > 2 * n));
+        branch_ct[n][0] = (left <= 0) ? num_events[-left] : node_ct[left >> 1];
+        branch_ct[n][1] = (right <= 0) ? num_events[-right] : node_ct[right >> 1];
+        node_ct[n] = branch_ct[n][0] + branch_ct[n][1];
+    }
 }
 
 void VulkanVP9Decoder::update_coef_probs(uint8_t dst_coef_probs[VP9_BLOCK_TYPES][VP9_REF_TYPES][VP9_COEF_BANDS][VP9_PREV_COEF_CONTEXTS][ENTROPY_NODES_PART1],
                         uint8_t pre_coef_probs[VP9_BLOCK_TYPES][VP9_REF_TYPES][VP9_COEF_BANDS][VP9_PREV_COEF_CONTEXTS][ENTROPY_NODES_PART1],
                         uint32_t coef_counts[VP9_BLOCK_TYPES][VP9_REF_TYPES][VP9_COEF_BANDS][VP9_PREV_COEF_CONTEXTS][UNCONSTRAINED_NODES+1],
                         uint32_t (*eob_counts)[VP9_REF_TYPES][VP9_COEF_BANDS][VP9_PREV_COEF_CONTEXTS],
-                        int32_t count_sat, int32_t update_factor)
+                        const uint8_t* update_factor)
 {
-    int32_t t, i, j, k, l, count;
-    uint32_t branch_ct[VP9_ENTROPY_NODES][2];
-    vp9_prob coef_probs[VP9_ENTROPY_NODES];
-    int32_t factor;
-
-    //int32_t brancharr[VP9_BLOCK_TYPES][VP9_REF_TYPES][36][VP9_PREV_COEF_CONTEXTS] = {0};
-    //int32_t coeffprobarr[VP9_BLOCK_TYPES][VP9_REF_TYPES][VP9_COEF_BANDS][VP9_PREV_COEF_CONTEXTS] = {0};
-    //memset(brancharr, 0, sizeof(int32_t)*VP9_BLOCK_TYPES*VP9_REF_TYPES*VP9_COEF_BANDS*VP9_PREV_COEF_CONTEXTS);
-    //memset(coeffprobarr, 0, sizeof(int32_t)*VP9_BLOCK_TYPES*VP9_REF_TYPES*VP9_COEF_BANDS*VP9_PREV_COEF_CONTEXTS);
+    int32_t i, j, k, l;
 
     for (i = 0; i < VP9_BLOCK_TYPES; ++i)
     {
@@ -707,19 +723,22 @@ void VulkanVP9Decoder::update_coef_probs(uint8_t dst_coef_probs[VP9_BLOCK_TYPES]
                 {
                     if (l >= 3 && k == 0)
                         continue;
-                    vp9_tree_probs_from_distribution(vp9_coefmodel_tree,
-                                                    coef_probs, branch_ct,
-                                                     coef_counts[i][j][k][l], 0);
-                    branch_ct[0][1] = eob_counts[i][j][k][l] - branch_ct[0][0];
-                    coef_probs[0] = get_binary_prob(branch_ct[0][0], branch_ct[0][1]);
-                    //brancharr[i][j][k][l] = branch_ct[0][1];
-                    //coeffprobarr[i][j][k][l] = coef_probs[0];
-                    for (t = 0; t < UNCONSTRAINED_NODES; ++t)
+                    // The branches of vp9_coefmodel_tree: {EOB, more}, {ZERO, ONE or TWO}, {ONE, TWO},
+                    // the EOB branch is counted against the blocks that could have ended there.
+                    const uint32_t* counts = coef_counts[i][j][k][l];
+                    const uint32_t n_eob = counts[DCT_EOB_MODEL_TOKEN];
+                    const uint32_t n0 = counts[ZERO_TOKEN];
+                    const uint32_t n1 = counts[ONE_TOKEN];
+                    const uint32_t n2 = counts[TWO_TOKEN];
+                    const uint32_t branch_ct[UNCONSTRAINED_NODES][2] = {
+                        { n_eob, eob_counts[i][j][k][l] - n_eob },
+                        { n0, n1 + n2 },
+                        { n1, n2 },
+                    };
+                    for (int32_t t = 0; t < UNCONSTRAINED_NODES; ++t)
                     {
-                        count = branch_ct[t][0] + branch_ct[t][1];
-                        count = count > count_sat ? count_sat : count;
-                        factor = (update_factor * count / count_sat);
-                        dst_coef_probs[i][j][k][l][t] = weighted_prob(pre_coef_probs[i][j][k][l][t], coef_probs[t], factor);
+                        dst_coef_probs[i][j][k][l][t] = merge_prob(pre_coef_probs[i][j][k][l][t], branch_ct[t],
+                                                                   update_factor, COEF_COUNT_SAT);
                     }
                 }
             }
@@ -729,81 +748,55 @@ void VulkanVP9Decoder::update_coef_probs(uint8_t dst_coef_probs[VP9_BLOCK_TYPES]
 
 void VulkanVP9Decoder::adaptCoefProbs(vp9_prob_update_s *pProbSetup)
 {
-    int32_t update_factor; /* denominator 256 */
-    int32_t count_sat;
+    const uint8_t* update_factor; /* denominator 256 */
 
-    if(pProbSetup->keyFrame)
+    if (!pProbSetup->keyFrame && pProbSetup->prevIsKeyFrame)
     {
-        update_factor = COEF_MAX_UPDATE_FACTOR_KEY;
-        count_sat = COEF_COUNT_SAT_KEY;
-    }
-    else if (pProbSetup->prevIsKeyFrame)
-    {
-        update_factor = COEF_MAX_UPDATE_FACTOR_AFTER_KEY; // adapt quickly
-        count_sat = COEF_COUNT_SAT_AFTER_KEY;
+        update_factor = vp9_coef_update_factor_after_key; // adapt quickly
     }
     else
     {
-        update_factor = COEF_MAX_UPDATE_FACTOR;
-        count_sat = COEF_COUNT_SAT;
+        update_factor = vp9_coef_update_factor;
     }
 
     update_coef_probs(pProbSetup->pProbTab->a.probCoeffs,
                         m_PrevCtx.probCoeffs,
                         pProbSetup->pCtxCounters->countCoeffs,
                         pProbSetup->pCtxCounters->countEobs[TX_4X4],
-                        count_sat, update_factor);
+                        update_factor);
     update_coef_probs(pProbSetup->pProbTab->a.probCoeffs8x8,
                         m_PrevCtx.probCoeffs8x8,
                         pProbSetup->pCtxCounters->countCoeffs8x8,
                         pProbSetup->pCtxCounters->countEobs[TX_8X8],
-                        count_sat, update_factor);
+                        update_factor);
     update_coef_probs(pProbSetup->pProbTab->a.probCoeffs16x16,
                         m_PrevCtx.probCoeffs16x16,
                         pProbSetup->pCtxCounters->countCoeffs16x16,
                         pProbSetup->pCtxCounters->countEobs[TX_16X16],
-                        count_sat, update_factor);
+                        update_factor);
     update_coef_probs(pProbSetup->pProbTab->a.probCoeffs32x32,
                         m_PrevCtx.probCoeffs32x32,
                         pProbSetup->pCtxCounters->countCoeffs32x32,
                         pProbSetup->pCtxCounters->countEobs[TX_32X32],
-                        count_sat, update_factor);
-}
-
-int32_t VulkanVP9Decoder::update_mode_ct(vp9_prob pre_prob, vp9_prob prob, uint32_t branch_ct[2])
-{
-    int32_t factor, count = branch_ct[0] + branch_ct[1];
-    count = count > MODE_COUNT_SAT ? MODE_COUNT_SAT : count;
-    factor = (MODE_MAX_UPDATE_FACTOR * count / MODE_COUNT_SAT);
-    return weighted_prob(pre_prob, prob, factor);
-}
-
-int32_t VulkanVP9Decoder::update_mode_ct2(vp9_prob pre_prob, uint32_t branch_ct[2])
-{
-    return update_mode_ct(pre_prob, get_binary_prob(branch_ct[0], branch_ct[1]), branch_ct);
+                        update_factor);
 }
 
 void VulkanVP9Decoder::update_mode_probs(int32_t n_modes,
                         const vp9_tree_index *tree, uint32_t *cnt,
                         vp9_prob *pre_probs, vp9_prob *pre_probsB,
-                        vp9_prob *dst_probs, vp9_prob *dst_probsB,
-                        uint32_t tok0_offset)
+                        vp9_prob *dst_probs, vp9_prob *dst_probsB)
 {
-    vp9_prob probs[MAX_PROBS];
     uint32_t branch_ct[MAX_PROBS][2];
-    int32_t t, count, factor;
+    int32_t t;
 
     assert(n_modes - 1 < MAX_PROBS);
-    vp9_tree_probs_from_distribution(tree, probs, branch_ct, cnt, tok0_offset);
+    tree_branch_counts(tree, n_modes - 1, cnt, branch_ct);
     for (t = 0; t < n_modes - 1; ++t)
     {
-        count = branch_ct[t][0] + branch_ct[t][1];
-        count = count > MODE_COUNT_SAT ? MODE_COUNT_SAT : count;
-        factor = (MODE_MAX_UPDATE_FACTOR * count / MODE_COUNT_SAT);
         if (t < 8 || dst_probsB == NULL)
-            dst_probs[t] = weighted_prob(pre_probs[t], probs[t], factor);
+            dst_probs[t] = merge_prob(pre_probs[t], branch_ct[t], vp9_mode_update_factor, MODE_COUNT_SAT);
         else
-            dst_probsB[t-8] = weighted_prob(pre_probsB[t-8], probs[t], factor);
+            dst_probsB[t-8] = merge_prob(pre_probsB[t-8], branch_ct[t], vp9_mode_update_factor, MODE_COUNT_SAT);
     }
 }
 
@@ -837,47 +830,49 @@ void VulkanVP9Decoder::tx_counts_to_branch_counts_8x8(uint32_t *tx_count_8x8p,
 void VulkanVP9Decoder::adaptModeProbs(vp9_prob_update_s *pProbSetup)
 {
     uint32_t i, j;
+    nvdec_vp9AdaptiveEntropyProbs_t *fc = &pProbSetup->pProbTab->a;
+    nvdec_vp9EntropyCounts_t *counts = pProbSetup->pCtxCounters;
 
     for (i = 0; i < INTRA_INTER_CONTEXTS; i++)
-        pProbSetup->pProbTab->a.intra_inter_prob[i] = update_mode_ct2(m_PrevCtx.intra_inter_prob[i], pProbSetup->pCtxCounters->intra_inter_count[i]);
+        fc->intra_inter_prob[i] = merge_prob(m_PrevCtx.intra_inter_prob[i], counts->intra_inter_count[i], vp9_mode_update_factor, MODE_COUNT_SAT);
     for (i = 0; i < COMP_INTER_CONTEXTS; i++)
-        pProbSetup->pProbTab->a.comp_inter_prob[i] = update_mode_ct2(m_PrevCtx.comp_inter_prob[i], pProbSetup->pCtxCounters->comp_inter_count[i]);
+        fc->comp_inter_prob[i] = merge_prob(m_PrevCtx.comp_inter_prob[i], counts->comp_inter_count[i], vp9_mode_update_factor, MODE_COUNT_SAT);
     for (i = 0; i < REF_CONTEXTS; i++)
-        pProbSetup->pProbTab->a.comp_ref_prob[i] = update_mode_ct2(m_PrevCtx.comp_ref_prob[i], pProbSetup->pCtxCounters->comp_ref_count[i]);
+        fc->comp_ref_prob[i] = merge_prob(m_PrevCtx.comp_ref_prob[i], counts->comp_ref_count[i], vp9_mode_update_factor, MODE_COUNT_SAT);
     for (i = 0; i < REF_CONTEXTS; i++)
         for (j = 0; j < 2; j++)
-            pProbSetup->pProbTab->a.single_ref_prob[i][j] = update_mode_ct2(m_PrevCtx.single_ref_prob[i][j], pProbSetup->pCtxCounters->single_ref_count[i][j]);
+            fc->single_ref_prob[i][j] = merge_prob(m_PrevCtx.single_ref_prob[i][j], counts->single_ref_count[i][j], vp9_mode_update_factor, MODE_COUNT_SAT);
 
     for (i = 0; i < BLOCK_SIZE_GROUPS; ++i)
     {
         update_mode_probs(VP9_INTRA_MODES, vp9_intra_mode_tree,
-                            pProbSetup->pCtxCounters->sb_ymode_counts[i],
+                            counts->sb_ymode_counts[i],
                             m_PrevCtx.sb_ymode_prob[i], m_PrevCtx.sb_ymode_probB[i],
-                            pProbSetup->pProbTab->a.sb_ymode_prob[i], pProbSetup->pProbTab->a.sb_ymode_probB[i], 0);
+                            fc->sb_ymode_prob[i], fc->sb_ymode_probB[i]);
     }
     for (i = 0; i < VP9_INTRA_MODES; ++i)
     {
         update_mode_probs(VP9_INTRA_MODES, vp9_intra_mode_tree,
-                            pProbSetup->pCtxCounters->uv_mode_counts[i],
+                            counts->uv_mode_counts[i],
                             m_PrevCtx.uv_mode_prob[i],
                             m_PrevCtx.uv_mode_probB[i],
-                            pProbSetup->pProbTab->a.uv_mode_prob[i],
-                            pProbSetup->pProbTab->a.uv_mode_probB[i], 0);
+                            fc->uv_mode_prob[i],
+                            fc->uv_mode_probB[i]);
     }
     for (i = 0; i < NUM_PARTITION_CONTEXTS; i++)
         update_mode_probs(PARTITION_TYPES, vp9_partition_tree,
-                            pProbSetup->pCtxCounters->partition_counts[i],
+                            counts->partition_counts[i],
                             m_PrevCtx.partition_prob[INTER_FRAME][i], NULL,
-                            pProbSetup->pProbTab->a.partition_prob[INTER_FRAME][i], NULL, 0);
+                            fc->partition_prob[INTER_FRAME][i], NULL);
 
     if (pProbSetup->mcomp_filter_type == SWITCHABLE)
     {
         for (i = 0; i <= VP9_SWITCHABLE_FILTERS; ++i)
         {
             update_mode_probs(VP9_SWITCHABLE_FILTERS, vp9_switchable_interp_tree,
-                                pProbSetup->pCtxCounters->switchable_interp_counts[i],
+                                counts->switchable_interp_counts[i],
                                 m_PrevCtx.switchable_interp_prob[i], NULL,
-                                pProbSetup->pProbTab->a.switchable_interp_prob[i], NULL, 0);
+                                fc->switchable_interp_prob[i], NULL);
         }
     }
 
@@ -888,46 +883,25 @@ void VulkanVP9Decoder::adaptModeProbs(vp9_prob_update_s *pProbSetup)
         uint32_t branch_ct_32x32p[TX_SIZE_MAX_SB - 1][2];
         for (i = 0; i < TX_SIZE_CONTEXTS; ++i)
         {
-            tx_counts_to_branch_counts_8x8(pProbSetup->pCtxCounters->tx8x8_count[i], branch_ct_8x8p);
+            tx_counts_to_branch_counts_8x8(counts->tx8x8_count[i], branch_ct_8x8p);
             for (j = 0; j < TX_SIZE_MAX_SB - 3; ++j)
-            {
-                int32_t factor;
-                int32_t count = branch_ct_8x8p[j][0] + branch_ct_8x8p[j][1];
-                vp9_prob prob = get_binary_prob(branch_ct_8x8p[j][0], branch_ct_8x8p[j][1]);
-                count = count > MODE_COUNT_SAT ? MODE_COUNT_SAT : count;
-                factor = (MODE_MAX_UPDATE_FACTOR * count / MODE_COUNT_SAT);
-                pProbSetup->pProbTab->a.tx8x8_prob[i][j] = weighted_prob(m_PrevCtx.tx8x8_prob[i][j], prob, factor);
-            }
+                fc->tx8x8_prob[i][j] = merge_prob(m_PrevCtx.tx8x8_prob[i][j], branch_ct_8x8p[j], vp9_mode_update_factor, MODE_COUNT_SAT);
         }
         for (i = 0; i < TX_SIZE_CONTEXTS; ++i)
         {
-            tx_counts_to_branch_counts_16x16(pProbSetup->pCtxCounters->tx16x16_count[i], branch_ct_16x16p);
+            tx_counts_to_branch_counts_16x16(counts->tx16x16_count[i], branch_ct_16x16p);
             for (j = 0; j < TX_SIZE_MAX_SB - 2; ++j)
-            {
-                int32_t factor;
-                int32_t count = branch_ct_16x16p[j][0] + branch_ct_16x16p[j][1];
-                vp9_prob prob = get_binary_prob(branch_ct_16x16p[j][0], branch_ct_16x16p[j][1]);
-                count = count > MODE_COUNT_SAT ? MODE_COUNT_SAT : count;
-                factor = (MODE_MAX_UPDATE_FACTOR * count / MODE_COUNT_SAT);
-                pProbSetup->pProbTab->a.tx16x16_prob[i][j] = weighted_prob(m_PrevCtx.tx16x16_prob[i][j], prob, factor);
-            }
+                fc->tx16x16_prob[i][j] = merge_prob(m_PrevCtx.tx16x16_prob[i][j], branch_ct_16x16p[j], vp9_mode_update_factor, MODE_COUNT_SAT);
         }
         for (i = 0; i < TX_SIZE_CONTEXTS; ++i)
         {
-            tx_counts_to_branch_counts_32x32(pProbSetup->pCtxCounters->tx32x32_count[i], branch_ct_32x32p);
+            tx_counts_to_branch_counts_32x32(counts->tx32x32_count[i], branch_ct_32x32p);
             for (j = 0; j < TX_SIZE_MAX_SB - 1; ++j)
-            {
-                int32_t factor;
-                int32_t count = branch_ct_32x32p[j][0] + branch_ct_32x32p[j][1];
-                vp9_prob prob = get_binary_prob(branch_ct_32x32p[j][0], branch_ct_32x32p[j][1]);
-                count = count > MODE_COUNT_SAT ? MODE_COUNT_SAT : count;
-                factor = (MODE_MAX_UPDATE_FACTOR * count / MODE_COUNT_SAT);
-                pProbSetup->pProbTab->a.tx32x32_prob[i][j] = weighted_prob(m_PrevCtx.tx32x32_prob[i][j], prob, factor);
-            }
+                fc->tx32x32_prob[i][j] = merge_prob(m_PrevCtx.tx32x32_prob[i][j], branch_ct_32x32p[j], vp9_mode_update_factor, MODE_COUNT_SAT);
         }
     }
     for (i = 0; i < MBSKIP_CONTEXTS; ++i)
-        pProbSetup->pProbTab->a.mbskip_probs[i] = update_mode_ct2(m_PrevCtx.mbskip_probs[i],pProbSetup->pCtxCounters->mbskip_count[i]);
+        fc->mbskip_probs[i] = merge_prob(m_PrevCtx.mbskip_probs[i], counts->mbskip_count[i], vp9_mode_update_factor, MODE_COUNT_SAT);
 }
 
 void VulkanVP9Decoder::adaptModeContext(vp9_prob_update_s *pProbSetup)
@@ -939,53 +913,30 @@ void VulkanVP9Decoder::adaptModeContext(vp9_prob_update_s *pProbSetup)
     {
         for (i = 0; i < VP9_INTER_MODES - 1; i++)
         {
-            int32_t count = mode_ct[j][i][0] + mode_ct[j][i][1], factor;
-            count = count > MVREF_COUNT_SAT ? MVREF_COUNT_SAT : count;
-            factor = (MVREF_MAX_UPDATE_FACTOR * count / MVREF_COUNT_SAT);
-            pProbSetup->pProbTab->a.inter_mode_prob[j][i] = weighted_prob(m_PrevCtx.inter_mode_prob[j][i],
-                                                                        get_binary_prob(mode_ct[j][i][0], mode_ct[j][i][1]),
-                                                                        factor);
+            pProbSetup->pProbTab->a.inter_mode_prob[j][i] = merge_prob(m_PrevCtx.inter_mode_prob[j][i], mode_ct[j][i],
+                                                                       vp9_mode_update_factor, MVREF_COUNT_SAT);
         }
     }
 }
 
-uint32_t VulkanVP9Decoder::adapt_probs(uint32_t i,
-                            const signed char* tree,
+void VulkanVP9Decoder::adapt_probs(int32_t n_events,
+                            const vp9_tree_index* tree,
                             vp9_prob this_probs[],
                             const vp9_prob last_probs[],
                             const uint32_t num_events[])
 {
-    vp9_prob this_prob;
-    uint32_t weight;
+    uint32_t branch_ct[MAX_PROBS][2];
 
-    const uint32_t left = tree[i] <= 0 ? num_events[-tree[i]] : adapt_probs(tree[i], tree, this_probs, last_probs, num_events);
-    const uint32_t right = tree[i + 1] <= 0 ? num_events[-tree[i + 1]] : adapt_probs(tree[i + 1], tree, this_probs, last_probs, num_events);
-    weight = left + right;
-    if (weight)
-    {
-        this_prob = get_binary_prob(left, right);
-        weight = weight > MV_COUNT_SAT ? MV_COUNT_SAT : weight;
-        this_prob = weighted_prob(last_probs[i >> 1], this_prob, MV_MAX_UPDATE_FACTOR * weight / MV_COUNT_SAT);
-    }
-    else
+    tree_branch_counts(tree, n_events - 1, num_events, branch_ct);
+    for (int32_t t = 0; t < n_events - 1; ++t)
     {
-        this_prob = last_probs[i >> 1];
+        this_probs[t] = merge_prob(last_probs[t], branch_ct[t], vp9_mode_update_factor, MV_COUNT_SAT);
     }
-    this_probs[i >> 1] = this_prob;
-    return left + right;
 }
 
 void VulkanVP9Decoder::adapt_prob(vp9_prob *dest, vp9_prob prep, uint32_t ct[2])
 {
-    const int32_t count = std::min<int32_t>(ct[0] + ct[1], MV_COUNT_SAT);
-    if (count)
-    {
-        const vp9_prob newp = get_binary_prob(ct[0], ct[1]);
-        const int32_t factor = MV_MAX_UPDATE_FACTOR * count / MV_COUNT_SAT;
-        *dest = weighted_prob(prep, newp, factor);
-    }
-    else
-        *dest = prep;
+    *dest = merge_prob(prep, ct, vp9_mode_update_factor, MV_COUNT_SAT);
 }
 
 void VulkanVP9Decoder::adaptNmvProbs(vp9_prob_update_s *pProbSetup)
@@ -993,7 +944,7 @@ void VulkanVP9Decoder::adaptNmvProbs(vp9_prob_update_s *pProbSetup)
     uint32_t usehp = pProbSetup->allow_high_precision_mv;
     uint32_t i, j;
 
-    adapt_probs(0, vp9_mv_joint_tree,
+    adapt_probs(MV_JOINTS, vp9_mv_joint_tree,
                 pProbSetup->pProbTab->a.nmvc.joints,
                 m_PrevCtx.nmvc.joints,
                 pProbSetup->pCtxCounters->nmvcount.joints);
@@ -1002,11 +953,11 @@ void VulkanVP9Decoder::adaptNmvProbs(vp9_prob_update_s *pProbSetup)
         adapt_prob(&pProbSetup->pProbTab->a.nmvc.sign[i],
                     m_PrevCtx.nmvc.sign[i],
                     pProbSetup->pCtxCounters->nmvcount.sign[i]);
-        adapt_probs(0, vp9_mv_class_tree,
+        adapt_probs(MV_CLASSES, vp9_mv_class_tree,
                     pProbSetup->pProbTab->a.nmvc.classes[i],
                     m_PrevCtx.nmvc.classes[i],
                     pProbSetup->pCtxCounters->nmvcount.classes[i]);
-        adapt_probs(0, vp9_mv_class0_tree,
+        adapt_probs(CLASS0_SIZE, vp9_mv_class0_tree,
                     pProbSetup->pProbTab->a.nmvc.class0[i],
                     m_PrevCtx.nmvc.class0[i],
                     pProbSetup->pCtxCounters->nmvcount.class0[i]);
@@ -1018,12 +969,12 @@ void VulkanVP9Decoder::adaptNmvProbs(vp9_prob_update_s *pProbSetup)
         }
         for (j = 0; j < CLASS0_SIZE; ++j)
         {
-        adapt_probs(0, vp9_mv_fp_tree,
+        adapt_probs(4, vp9_mv_fp_tree,
                     pProbSetup->pProbTab->a.nmvc.class0_fp[i][j],
                     m_PrevCtx.nmvc.class0_fp[i][j],
                     pProbSetup->pCtxCounters->nmvcount.class0_fp[i][j]);
         }
-        adapt_probs(0, vp9_mv_fp_tree,
+        adapt_probs(4, vp9_mv_fp_tree,
                     pProbSetup->pProbTab->a.nmvc.fp[i],
                     m_PrevCtx.nmvc.fp[i],
                     pProbSetup->pCtxCounters->nmvcount.fp[i]);
@@ -1061,3 +1012,715 @@ void VulkanVP9Decoder::UpdateBackwardProbability(vp9_prob_update_s *pProbSetup)
     }
     //VP9HwdUpdateRefs
 }
+
+/////////////////////////////////////////////////////////////////////////////////
+// Frame parsing
+
+// initialization
+void VulkanVP9Decoder::InitParser()
+{
+    m_bNoStartCodes = true;
+    m_bEmulBytesPresent = false;
+    m_lastWidth = 0;
+    m_lastHeight = 0;
+    memset(&m_PicData, 0, sizeof(m_PicData));
+    EndOfStream();
+}
+
+// EOS
+void VulkanVP9Decoder::EndOfStream()
+{
+    if (m_pCurrPic) {
+        m_pCurrPic->Release();
+        m_pCurrPic = nullptr;
+    }
+
+    for (int i = 0; i < NUM_REF_FRAMES; i++) {
+        if (m_pBuffers[i].buffer) {
+            m_pBuffers[i].buffer->Release();
+            m_pBuffers[i].buffer = nullptr;
+        }
+    }
+}
+
+// Returns the number of frames in the superframe index at the end of the
+// packet and their sizes, 0 if the packet holds a single frame.
+uint32_t VulkanVP9Decoder::ParseSuperframeIndex(const uint8_t* pData, uint32_t size, uint32_t frameSizes[MAX_SUPERFRAME_FRAMES])
+{
+    if (size == 0) {
+        return 0;
+    }
+
+    const uint8_t marker = pData[size - 1];
+    if ((marker & 0xe0) != 0xc0) {
+        return 0;
+    }
+
+    const uint32_t frames = (marker & 0x7) + 1;
+    const uint32_t mag = ((marker >> 3) & 0x3) + 1;
+    const uint32_t indexSize = 2 + mag * frames;
+    // The index is framed by the marker byte on both ends
+    if ((size < indexSize) || (pData[size - indexSize] != marker)) {
+        return 0;
+    }
+
+    const uint8_t* x = &pData[size - indexSize + 1];
+    uint32_t totalSize = 0;
+    for (uint32_t i = 0; i < frames; i++) {
+        uint32_t thisSize = 0;
+        for (uint32_t j = 0; j < mag; j++) {
+            thisSize |= (uint32_t)(*x++) << (j * 8);
+        }
+        frameSizes[i] = thisSize;
+        totalSize += thisSize;
+    }
+
+    if (totalSize > (size - indexSize)) {
+        // Error: the frame sizes don't fit in the packet
+        return 0;
+    }
+    return frames;
+}
+
+bool VulkanVP9Decoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_t* pParsedBytes)
+{
+    const uint8_t* pData = pck->pByteStream;
+    const uint32_t dataSize = (uint32_t)pck->nDataLength;
+
+    if (pParsedBytes) {
+        *pParsedBytes = 0;
+    }
+
+    if (m_bitstreamData.GetBitstreamPtr() == nullptr) {
+        // make sure we're initialized
+        return false;
+    }
+
+    m_nCallbackEventCount = 0;
+    m_telemetry.bytesParsed += dataSize;
+
+    // Handle discontinuity
+    if (pck->bDiscontinuity) {
+        memset(&m_nalu, 0, sizeof(m_nalu));
+        memset(&m_PTSQueue, 0, sizeof(m_PTSQueue));
+        m_bDiscontinuityReported = true;
+    }
+
+    if (pck->bPTSValid) {
+        m_PTSQueue[m_lPTSPos].bPTSValid = true;
+        m_PTSQueue[m_lPTSPos].llPTS = pck->llPTS;
+        m_PTSQueue[m_lPTSPos].llPTSPos = m_llParsedBytes;
+        m_PTSQueue[m_lPTSPos].bDiscontinuity = m_bDiscontinuityReported;
+        m_bDiscontinuityReported = false;
+        m_lPTSPos = (m_lPTSPos + 1) % MAX_QUEUED_PTS;
+    }
+
+    if (dataSize > 0) {
+        // A packet is a single frame or a superframe: the frames that are
+        // decoded but not shown travel with the next shown one.
+        uint32_t frameSizes[MAX_SUPERFRAME_FRAMES];
+        uint32_t numFrames = ParseSuperframeIndex(pData, dataSize, frameSizes);
+        if (numFrames == 0) {
+            frameSizes[0] = dataSize;
+            numFrames = 1;
+        }
+
+        const int64_t packetStart = m_llParsedBytes;
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < numFrames; i++) {
+            const uint32_t frameSize = frameSizes[i];
+            if (frameSize == 0) {
+                continue;
+            }
+            m_llNaluStartLocation = m_llFrameStartLocation = packetStart + offset;
+            if (!ParseFrame(pData + offset, frameSize)) {
+                m_llParsedBytes = packetStart + dataSize;
+                return false;
+            }
+            offset += frameSize;
+        }
+        m_llParsedBytes = packetStart + dataSize;
+    }
+
+    if (pParsedBytes) {
+        *pParsedBytes = dataSize;
+    }
+
+    // flush if EOS set
+    if (pck->bEOS) {
+        end_of_stream();
+    }
+
+    return true;
+}
+
+bool VulkanVP9Decoder::ParseFrame(const uint8_t* pFrame, uint32_t frameSize)
+{
+    if (frameSize > (uint32_t)m_bitstreamDataLen) {
+        if (!resizeBitstreamBuffer(frameSize - (m_bitstreamDataLen))) {
+            // Error: Failed to resize bitstream buffer
+            return false;
+        }
+    }
+
+    memcpy(m_bitstreamData.GetBitstreamPtr(), pFrame, frameSize);
+    m_telemetry.bytesCopied += frameSize;
+    m_nalu.start_offset = 0;
+    m_nalu.end_offset = frameSize;
+    init_dbits();
+
+    if (!ParseUncompressedHeader()) {
+        return false;
+    }
+
+    if (m_showExistingFrame) {
+        VkPicIf* pDispPic = m_pBuffers[m_frameToShow].buffer;
+        if (pDispPic == nullptr) {
+            // Error: Frame not decoded yet
+            return false;
+        }
+        AddBuffertoDispQueue(pDispPic);
+        display_picture(pDispPic);
+        return true;
+    }
+
+    const uint32_t headerSize = m_PicData.frameTagSize;
+    if ((m_PicData.offsetToDctParts == 0) || (headerSize + m_PicData.offsetToDctParts > frameSize)) {
+        // Error: missing or truncated compressed header
+        return false;
+    }
+
+    // Load the frame context and apply the forward updates of the compressed header
+    m_ProbSetup.pProbTab = &m_EntropyCurr;
+    m_ProbSetup.pCtxCounters = nullptr;
+    m_ProbSetup.offsetToDctParts = m_PicData.offsetToDctParts;
+    GetProbs(&m_ProbSetup);
+    if (UpdateForwardProbability(&m_ProbSetup, pFrame + headerSize) != OK) {
+        // Error: corrupted compressed header
+        return false;
+    }
+
+    return end_of_picture(frameSize);
+}
+
+bool VulkanVP9Decoder::ParseFrameSyncCode()
+{
+    return (u(8) == 0x49) && (u(8) == 0x83) && (u(8) == 0x42);
+}
+
+bool VulkanVP9Decoder::ParseColorConfig()
+{
+    VkParserVp9PictureData* const pic = &m_PicData;
+
+    if (pic->version >= 2) {
+        pic->bit_depth_minus8 = u(1) ? 4 : 2;
+    } else {
+        pic->bit_depth_minus8 = 0;
+    }
+
+    pic->colorSpace = u(3);
+    if (pic->colorSpace != 7) { // CS_RGB
+        m_colorRange = u(1);
+        if ((pic->version == 1) || (pic->version == 3)) {
+            pic->subsamplingX = u(1);
+            pic->subsamplingY = u(1);
+            if (u(1)) {
+                // Error: reserved bit set
+                return false;
+            }
+        } else {
+            pic->subsamplingX = 1;
+            pic->subsamplingY = 1;
+        }
+    } else {
+        m_colorRange = 1;
+        if ((pic->version == 1) || (pic->version == 3)) {
+            pic->subsamplingX = 0;
+            pic->subsamplingY = 0;
+            if (u(1)) {
+                // Error: reserved bit set
+                return false;
+            }
+        } else {
+            // Error: 4:4:4 RGB is not allowed in profiles 0 and 2
+            return false;
+        }
+    }
+    return true;
+}
+
+void VulkanVP9Decoder::ParseFrameSize()
+{
+    m_PicData.width = u(16) + 1;
+    m_PicData.height = u(16) + 1;
+}
+
+void VulkanVP9Decoder::ParseRenderSize()
+{
+    if (u(1)) {
+        m_renderWidth = u(16) + 1;
+        m_renderHeight = u(16) + 1;
+    } else {
+        m_renderWidth = m_PicData.width;
+        m_renderHeight = m_PicData.height;
+    }
+}
+
+bool VulkanVP9Decoder::ParseFrameSizeWithRefs()
+{
+    bool foundRef = false;
+
+    for (uint32_t i = 0; i < ALLOWED_REFS_PER_FRAME; i++) {
+        if (u(1)) {
+            const vp9_ref_frame_s* pRef = &m_pBuffers[m_PicData.activeRefIdx[i]];
+            if (pRef->buffer == nullptr) {
+                // Error: the frame size is taken from a missing reference
+                return false;
+            }
+            m_PicData.width = pRef->width;
+            m_PicData.height = pRef->height;
+            foundRef = true;
+            break;
+        }
+    }
+    if (!foundRef) {
+        ParseFrameSize();
+    }
+    ParseRenderSize();
+    return true;
+}
+
+void VulkanVP9Decoder::ParseLoopFilterParams()
+{
+    VkParserVp9PictureData* const pic = &m_PicData;
+
+    pic->loopFilterLevel = u(6);
+    pic->loopFilterSharpness = u(3);
+    pic->modeRefLfEnabled = u(1);
+    if (pic->modeRefLfEnabled && u(1)) { // mode_ref_delta_update
+        for (uint32_t i = 0; i < MAX_REF_LF_DELTAS; i++) {
+            if (u(1)) {
+                const int32_t value = u(6);
+                pic->mbRefLfDelta[i] = u(1) ? -value : value;
+            }
+        }
+        for (uint32_t i = 0; i < MAX_MODE_LF_DELTAS; i++) {
+            if (u(1)) {
+                const int32_t value = u(6);
+                pic->mbModeLfDelta[i] = u(1) ? -value : value;
+            }
+        }
+    }
+}
+
+int32_t VulkanVP9Decoder::ReadDeltaQ()
+{
+    if (u(1)) {
+        const int32_t value = u(4);
+        return u(1) ? -value : value;
+    }
+    return 0;
+}
+
+void VulkanVP9Decoder::ParseQuantizationParams()
+{
+    VkParserVp9PictureData* const pic = &m_PicData;
+
+    pic->qpYAc = u(8);
+    pic->qpYDc = ReadDeltaQ();
+    pic->qpChDc = ReadDeltaQ();
+    pic->qpChAc = ReadDeltaQ();
+}
+
+static const uint32_t vp9_seg_feature_bits[SEG_LVL_MAX] = { 8, 6, 2, 0 };
+static const bool vp9_seg_feature_signed[SEG_LVL_MAX] = { true, true, false, false };
+
+void VulkanVP9Decoder::ParseSegmentationParams()
+{
+    VkParserVp9PictureData* const pic = &m_PicData;
+
+    pic->segmentMapUpdate = 0;
+    pic->segmentMapTemporalUpdate = 0;
+    pic->segmentEnabled = u(1);
+    if (!pic->segmentEnabled) {
+        return;
+    }
+
+    pic->segmentMapUpdate = u(1);
+    if (pic->segmentMapUpdate) {
+        for (uint32_t i = 0; i < MB_SEG_TREE_PROBS; i++) {
+            pic->mb_segment_tree_probs[i] = u(1) ? u(8) : MAX_PROB;
+        }
+        pic->segmentMapTemporalUpdate = u(1);
+        for (uint32_t i = 0; i < PREDICTION_PROBS; i++) {
+            pic->segment_pred_probs[i] = (pic->segmentMapTemporalUpdate && u(1)) ? u(8) : MAX_PROB;
+        }
+    }
+
+    if (u(1)) { // segmentation_update_data
+        pic->segmentFeatureMode = u(1);
+        for (uint32_t i = 0; i < MAX_MB_SEGMENTS; i++) {
+            for (uint32_t j = 0; j < SEG_LVL_MAX; j++) {
+                int32_t value = 0;
+                pic->segmentFeatureEnable[i][j] = u(1);
+                if (pic->segmentFeatureEnable[i][j]) {
+                    value = vp9_seg_feature_bits[j] ? u(vp9_seg_feature_bits[j]) : 0;
+                    if (vp9_seg_feature_signed[j] && u(1)) {
+                        value = -value;
+                    }
+                }
+                pic->segmentFeatureData[i][j] = (int16_t)value;
+            }
+        }
+    }
+}
+
+void VulkanVP9Decoder::ParseTileInfo()
+{
+    VkParserVp9PictureData* const pic = &m_PicData;
+    const uint32_t miCols = (pic->width + 7) >> 3;
+    const uint32_t sb64Cols = (miCols + 7) >> 3;
+
+    // Tiles are at most 4096 (64 superblocks) and at least 256 pixels wide
+    uint32_t minLog2 = 0;
+    while ((64u << minLog2) < sb64Cols) {
+        minLog2++;
+    }
+    uint32_t maxLog2 = 1;
+    while ((sb64Cols >> maxLog2) >= MIN_TILE_WIDTH_SBS) {
+        maxLog2++;
+    }
+    maxLog2--;
+
+    pic->log2_tile_columns = minLog2;
+    while ((pic->log2_tile_columns < maxLog2) && u(1)) {
+        pic->log2_tile_columns++;
+    }
+
+    pic->log2_tile_rows = u(1);
+    if (pic->log2_tile_rows) {
+        pic->log2_tile_rows += u(1);
+    }
+}
+
+// Resets the state that frames can inherit, for intra and error resilient frames
+void VulkanVP9Decoder::SetupPastIndependence()
+{
+    VkParserVp9PictureData* const pic = &m_PicData;
+    static const int32_t defaultRefLfDeltas[MAX_REF_LF_DELTAS] = { 1, 0, -1, -1 };
+
+    memset(pic->segmentFeatureEnable, 0, sizeof(pic->segmentFeatureEnable));
+    memset(pic->segmentFeatureData, 0, sizeof(pic->segmentFeatureData));
+    pic->segmentFeatureMode = SEGMENT_DELTADATA;
+
+    pic->modeRefLfEnabled = 1;
+    memcpy(pic->mbRefLfDelta, defaultRefLfDeltas, sizeof(defaultRefLfDeltas));
+    memset(pic->mbModeLfDelta, 0, sizeof(pic->mbModeLfDelta));
+
+    // Default probabilities, saved to the frame contexts selected by reset_frame_context
+    m_ProbSetup.pProbTab = &m_EntropyCurr;
+    m_ProbSetup.keyFrame = pic->keyFrame;
+    m_ProbSetup.errorResilient = pic->errorResilient;
+    m_ProbSetup.resetFrameContext = pic->resetFrameContext;
+    m_ProbSetup.frameContextIdx = pic->frameContextIdx;
+    ResetProbs(&m_ProbSetup);
+
+    memset(pic->refFrameSignBias, 0, sizeof(pic->refFrameSignBias));
+    pic->frameContextIdx = 0;
+}
+
+bool VulkanVP9Decoder::ParseUncompressedHeader()
+{
+    VkParserVp9PictureData* const pic = &m_PicData;
+
+    if (u(2) != 2) {
+        // Error: invalid frame marker
+        return false;
+    }
+    pic->version = u(1);
+    pic->version |= u(1) << 1;
+    if ((pic->version == 3) && u(1)) {
+        // Error: reserved bit set
+        return false;
+    }
+
+    m_showExistingFrame = (u(1) != 0);
+    if (m_showExistingFrame) {
+        m_frameToShow = u(3);
+        return true;
+    }
+
+    pic->prevIsKeyFrame = pic->keyFrame;
+    pic->PrevShowFrame = pic->showFrame;
+    pic->keyFrame = (u(1) == 0);
+    pic->showFrame = u(1);
+    pic->errorResilient = u(1);
+    pic->intraOnly = 0;
+    pic->resetFrameContext = 0;
+
+    if (pic->keyFrame) {
+        if (!ParseFrameSyncCode() || !ParseColorConfig()) {
+            return false;
+        }
+        ParseFrameSize();
+        ParseRenderSize();
+        pic->refreshFrameFlags = (1 << NUM_REF_FRAMES) - 1;
+    } else {
+        pic->intraOnly = pic->showFrame ? 0 : u(1);
+        pic->resetFrameContext = pic->errorResilient ? 0 : u(2);
+        if (pic->intraOnly) {
+            if (!ParseFrameSyncCode()) {
+                return false;
+            }
+            if (pic->version > 0) {
+                if (!ParseColorConfig()) {
+                    return false;
+                }
+            } else {
+                pic->bit_depth_minus8 = 0;
+                pic->colorSpace = 1; // CS_BT_601
+                pic->subsamplingX = 1;
+                pic->subsamplingY = 1;
+                m_colorRange = 0;
+            }
+            pic->refreshFrameFlags = u(8);
+            ParseFrameSize();
+            ParseRenderSize();
+        } else {
+            pic->refreshFrameFlags = u(8);
+            for (uint32_t i = 0; i < ALLOWED_REFS_PER_FRAME; i++) {
+                pic->activeRefIdx[i] = u(3);
+                pic->refFrameSignBias[LAST_FRAME + i] = (uint8_t)u(1);
+            }
+            if (!ParseFrameSizeWithRefs()) {
+                return false;
+            }
+            pic->allow_high_precision_mv = u(1);
+            // read_interpolation_filter()
+            static const uint32_t literalToType[4] = { EIGHTTAP_SMOOTH, EIGHTTAP, EIGHTTAP_SHARP, BILINEAR };
+            pic->mcomp_filter_type = u(1) ? (uint32_t)SWITCHABLE : literalToType[u(2)];
+        }
+    }
+
+    if (!pic->errorResilient) {
+        pic->refreshEntropyProbs = u(1);
+        pic->frameParallelDecoding = u(1);
+    } else {
+        pic->refreshEntropyProbs = 0;
+        pic->frameParallelDecoding = 1;
+    }
+    pic->frameContextIdx = u(NUM_FRAME_CONTEXTS_LG2);
+
+    if (pic->keyFrame || pic->intraOnly || pic->errorResilient) {
+        SetupPastIndependence();
+    }
+
+    ParseLoopFilterParams();
+    ParseQuantizationParams();
+    ParseSegmentationParams();
+    ParseTileInfo();
+
+    pic->offsetToDctParts = u(16);
+    byte_alignment();
+    pic->frameTagSize = consumed_bits() / 8;
+
+    // Setup of the probability manager for the compressed header
+    m_ProbSetup.keyFrame = pic->keyFrame;
+    m_ProbSetup.prevIsKeyFrame = pic->prevIsKeyFrame;
+    m_ProbSetup.resolutionChange = (pic->width != m_lastWidth) || (pic->height != m_lastHeight);
+    m_ProbSetup.errorResilient = pic->errorResilient;
+    m_ProbSetup.prevShowFrame = pic->PrevShowFrame;
+    m_ProbSetup.intraOnly = pic->intraOnly;
+    m_ProbSetup.lossless = (pic->qpYAc == 0) && (pic->qpYDc == 0) && (pic->qpChDc == 0) && (pic->qpChAc == 0);
+    m_ProbSetup.allow_high_precision_mv = (char)pic->allow_high_precision_mv;
+    m_ProbSetup.mcomp_filter_type = (char)pic->mcomp_filter_type;
+    m_ProbSetup.FrameParallelDecoding = (unsigned char)pic->frameParallelDecoding;
+    m_ProbSetup.RefreshEntropyProbs = (unsigned char)pic->refreshEntropyProbs;
+    m_ProbSetup.resetFrameContext = pic->resetFrameContext;
+    m_ProbSetup.frameContextIdx = pic->frameContextIdx;
+    m_ProbSetup.allow_comp_inter_inter = !pic->keyFrame && !pic->intraOnly &&
+        ((pic->refFrameSignBias[GOLDEN_FRAME] != pic->refFrameSignBias[LAST_FRAME]) ||
+         (pic->refFrameSignBias[ALTREF_FRAME] != pic->refFrameSignBias[LAST_FRAME]));
+    m_ProbSetup.probsDecoded = 0;
+
+    return true;
+}
+
+void VulkanVP9Decoder::AddBuffertoDispQueue(VkPicIf* pDispPic)
+{
+    int32_t lDisp = 0;
+
+    // Find an entry in m_DispInfo
+    for (int32_t i = 0; i < MAX_DELAY; i++) {
+        if (m_DispInfo[i].pPicBuf == pDispPic) {
+            lDisp = i;
+            break;
+        }
+        if ((m_DispInfo[i].pPicBuf == nullptr)
+            || ((m_DispInfo[lDisp].pPicBuf != nullptr) && (m_DispInfo[i].llPTS - m_DispInfo[lDisp].llPTS < 0))) {
+            lDisp = i;
+        }
+    }
+    m_DispInfo[lDisp].pPicBuf = pDispPic;
+    m_DispInfo[lDisp].bSkipped = false;
+    m_DispInfo[lDisp].bDiscontinuity = false;
+    m_DispInfo[lDisp].lNumFields = 2;
+
+    // Find a PTS in the list
+    unsigned int ndx = m_lPTSPos;
+    m_DispInfo[lDisp].bPTSValid = false;
+    m_DispInfo[lDisp].llPTS = m_llExpectedPTS; // Will be updated later on
+    for (int k = 0; k < MAX_QUEUED_PTS; k++) {
+        if ((m_PTSQueue[ndx].bPTSValid) && (m_PTSQueue[ndx].llPTSPos - m_llFrameStartLocation <= 0)) {
+            m_DispInfo[lDisp].bPTSValid = true;
+            m_DispInfo[lDisp].llPTS = m_PTSQueue[ndx].llPTS;
+            m_DispInfo[lDisp].bDiscontinuity = m_PTSQueue[ndx].bDiscontinuity;
+            m_PTSQueue[ndx].bPTSValid = false;
+        }
+        ndx = (ndx + 1) % MAX_QUEUED_PTS;
+    }
+}
+
+// kick-off decoding
+bool VulkanVP9Decoder::end_of_picture(uint32_t frameSize)
+{
+    *m_pVkPictureData = VkParserPictureData();
+    m_pVkPictureData->numSlices = (1 << m_PicData.log2_tile_columns) * (1 << m_PicData.log2_tile_rows);  // tiles, VP9 doesn't have slices
+
+    m_pVkPictureData->bitstreamDataLen = frameSize;
+    m_pVkPictureData->bitstreamData = m_bitstreamData.GetBitstreamBuffer();
+    m_pVkPictureData->bitstreamDataOffset = 0;
+    m_pVkPictureData->firstSliceIndex = 0;
+
+    memcpy(&m_pVkPictureData->CodecSpecific.vp9, &m_PicData, sizeof(m_PicData));
+    m_pVkPictureData->intra_pic_flag = m_PicData.keyFrame || m_PicData.intraOnly;
+    m_pVkPictureData->ref_pic_flag = (m_PicData.refreshFrameFlags != 0);
+
+    if (!BeginPicture(m_pVkPictureData)) {
+        // Error: BeginPicture failed
+        return false;
+    }
+
+    bool bSkipped = false;
+    if (m_pClient != nullptr) {
+        // Notify client
+        if (!ClientDecodePicture(m_pVkPictureData)) {
+            bSkipped = true;
+            // WARNING: skipped decoding current picture;
+        } else {
+            m_nCallbackEventCount++;
+        }
+    } else {
+        // "WARNING: no valid render target for current picture
+    }
+
+    // The parser has no symbol counts for the backward adaptation, the saved
+    // context has the forward updates only (exact for error resilient and
+    // frame parallel streams). UpdateBackwardProbability() adapts it when the
+    // counts are available.
+    if (m_PicData.refreshEntropyProbs) {
+        memcpy(&m_EntropyLast[m_PicData.frameContextIdx], &m_EntropyCurr, sizeof(m_EntropyCurr));
+    }
+
+    m_lastWidth = m_PicData.width;
+    m_lastHeight = m_PicData.height;
+
+    UpdateFramePointers(m_pCurrPic);
+    if (m_PicData.showFrame && !bSkipped) {
+        AddBuffertoDispQueue(m_pCurrPic);
+        display_picture(m_pCurrPic);
+    }
+    if (m_pCurrPic) {
+        m_pCurrPic->Release();
+        m_pCurrPic = nullptr;
+    }
+
+    return true;
+}
+
+// BeginPicture
+bool VulkanVP9Decoder::BeginPicture(VkParserPictureData* pnvpd)
+{
+    VkParserVp9PictureData* const vp9 = &pnvpd->CodecSpecific.vp9;
+
+    VkParserSequenceInfo nvsi = m_ExtSeqInfo;
+    nvsi.eCodec         = (VkVideoCodecOperationFlagBitsKHR)VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR;
+    nvsi.nChromaFormat  = (vp9->subsamplingX && vp9->subsamplingY) ? 1 : (!vp9->subsamplingX && !vp9->subsamplingY) ? 3 : 2;
+    nvsi.nMaxWidth      = vp9->width;
+    nvsi.nMaxHeight     = vp9->height;
+    nvsi.nCodedWidth    = vp9->width;
+    nvsi.nCodedHeight   = vp9->height;
+    nvsi.nDisplayWidth  = vp9->width;
+    nvsi.nDisplayHeight = vp9->height;
+    nvsi.bProgSeq = true; // VP9 doesnt have interlaced coding.
+
+    nvsi.uBitDepthLumaMinus8 = (uint8_t)vp9->bit_depth_minus8;
+    nvsi.uBitDepthChromaMinus8 = nvsi.uBitDepthLumaMinus8;
+    nvsi.uVideoFullRange = (uint8_t)m_colorRange;
+    nvsi.codecProfile = vp9->version;
+
+    nvsi.lDARWidth = m_renderWidth;
+    nvsi.lDARHeight = m_renderHeight;
+    // nMinNumDecodeSurfaces = dpbsize (8 for vp9) + 1
+    nvsi.nMinNumDecodeSurfaces = NUM_REF_FRAMES + 1;
+
+    nvsi.lVideoFormat = VideoFormatUnspecified;
+
+    if (!init_sequence(&nvsi))
+        return false;
+
+    // Allocate a buffer for the current picture
+    if (m_pCurrPic == nullptr) {
+        m_pClient->AllocPictureBuffer(&m_pCurrPic);
+    }
+
+    pnvpd->PicWidthInMbs    = (nvsi.nCodedWidth + 15) >> 4;
+    pnvpd->FrameHeightInMbs = (nvsi.nCodedHeight + 15) >> 4;
+    pnvpd->pCurrPic         = m_pCurrPic;
+    pnvpd->progressive_frame = 1;
+    pnvpd->chroma_format    = nvsi.nChromaFormat;
+
+    // Referenced frames and the size they are scaled from
+    vp9->scaledWidth = m_renderWidth;
+    vp9->scaledHeight = m_renderHeight;
+    vp9->scalingActive = 0;
+    if (!vp9->keyFrame && !vp9->intraOnly) {
+        vp9->pLastRef = m_pBuffers[vp9->activeRefIdx[0]].buffer;
+        vp9->pGoldenRef = m_pBuffers[vp9->activeRefIdx[1]].buffer;
+        vp9->pAltRef = m_pBuffers[vp9->activeRefIdx[2]].buffer;
+        for (uint32_t i = 0; i < ALLOWED_REFS_PER_FRAME; i++) {
+            const vp9_ref_frame_s* pRef = &m_pBuffers[vp9->activeRefIdx[i]];
+            if ((pRef->width != vp9->width) || (pRef->height != vp9->height)) {
+                vp9->scalingActive = 1;
+            }
+        }
+    } else {
+        vp9->pLastRef = nullptr;
+        vp9->pGoldenRef = nullptr;
+        vp9->pAltRef = nullptr;
+    }
+
+    return true;
+}
+
+void VulkanVP9Decoder::UpdateFramePointers(VkPicIf* currentPicture)
+{
+    uint32_t mask, ref_index = 0;
+
+    for (mask = m_PicData.refreshFrameFlags; mask; mask >>= 1) {
+        if (mask & 1) {
+            if (m_pBuffers[ref_index].buffer) {
+                m_pBuffers[ref_index].buffer->Release();
+            }
+
+            m_pBuffers[ref_index].buffer = currentPicture;
+            m_pBuffers[ref_index].width = m_PicData.width;
+            m_pBuffers[ref_index].height = m_PicData.height;
+
+            if (m_pBuffers[ref_index].buffer) {
+                m_pBuffers[ref_index].buffer->AddRef();
+            }
+        }
+        ++ref_index;
+    }
+}
@@ -15,14 +15,14 @@
 */
 
 #include <stdarg.h>
+#include <chrono>
 #include "vkvideo_parser/VulkanVideoParserIf.h"
 #include "VulkanVideoDecoder.h"
+#include "StartCodeScanner.h"
 #include "nvVulkanVideoUtils.h"
 #include "nvVulkanVideoParser.h"
 #include <algorithm>
-#ifdef ENABLE_VP9_DECODER
-#include <VulkanVP9Decoder.h>
-#endif
+#include "VulkanVP9Decoder.h"
 
 VulkanVideoDecoder::VulkanVideoDecoder(VkVideoCodecOperationFlagBitsKHR std)
     : m_refCount(0)
@@ -30,6 +30,8 @@ VulkanVideoDecoder::VulkanVideoDecoder(VkVideoCodecOperationFlagBitsKHR std)
     , m_264SvcEnabled(false)
     , m_outOfBandPictureParameters(false)
     , m_initSequenceIsCalled(false)
+    , m_bPictureMetadata(false)
+    , m_bCallbackTimings(false)
     , m_pClient()
     , m_defaultMinBufferSize(2 * 1024 * 1024)
     , m_bufferOffsetAlignment(256)
@@ -63,6 +65,12 @@ VulkanVideoDecoder::VulkanVideoDecoder(VkVideoCodecOperationFlagBitsKHR std)
     , m_bDecoderInitFailed()
     , m_lCheckPTS()
     , m_eError(NV_NO_ERROR)
+    , m_pStartCodeScanner()
+    , m_metadata()
+    , m_numMetadata()
+    , m_numPendingMetadata()
+    , m_pendingMetadataOffset()
+    , m_telemetry()
 {
     if (m_264SvcEnabled) {
         m_pVkPictureData = new VkParserPictureData[128];
@@ -74,6 +82,8 @@ VulkanVideoDecoder::VulkanVideoDecoder(VkVideoCodecOperationFlagBitsKHR std)
 
 VulkanVideoDecoder::~VulkanVideoDecoder()
 {
+    delete m_pStartCodeScanner;
+    m_pStartCodeScanner = nullptr;
     if (m_264SvcEnabled)
     {
         delete [] m_pVkPictureData;
@@ -99,6 +109,8 @@ VkResult VulkanVideoDecoder::Initialize(const VkParserInitDecodeParameters *pPar
     m_bufferOffsetAlignment = pParserPictureData->bufferOffsetAlignment;
     m_bufferSizeAlignment   = pParserPictureData->bufferSizeAlignment;
     m_outOfBandPictureParameters = pParserPictureData->outOfBandPictureParameters;
+    m_bPictureMetadata = pParserPictureData->pictureMetadata;
+    m_bCallbackTimings = pParserPictureData->callbackTimings;
     m_lClockRate = (pParserPictureData->referenceClockRate > 0) ? pParserPictureData->referenceClockRate : 10000000; // Use 10Mhz as default clock
     m_lErrorThreshold = pParserPictureData->errorThreshold;
     m_bDiscontinuityReported = false;
@@ -138,9 +150,15 @@ VkResult VulkanVideoDecoder::Initialize(const VkParserInitDecodeParameters *pPar
     m_llNaluStartLocation = 0;
     m_llFrameStartLocation = 0;
     m_lPTSPos = 0;
+    ResetMetadata();
+    memset(&m_telemetry, 0, sizeof(m_telemetry));
+    m_telemetry.maxBufferSize = m_bitstreamDataLen;
     InitParser();
     memset(&m_nalu, 0, sizeof(m_nalu)); // reset nalu again (in case parser used init_dbits during initialization)
     m_NextStartCode = check_simd_support();
+    if (pParserPictureData->pipelinedParsing) {
+        m_pStartCodeScanner = new StartCodeScanner();
+    }
 
     return VK_SUCCESS;
 }
@@ -150,10 +168,81 @@ bool VulkanVideoDecoder::Deinitialize()
 {
     FreeContext();
     m_bitstreamData.ResetBitstreamBuffer();
+    delete m_pStartCodeScanner;
+    m_pStartCodeScanner = nullptr;
+    return true;
+}
+
+
+bool VulkanVideoDecoder::GetMemoryFootprint(VkParserMemoryFootprint *pFootprint)
+{
+    if (pFootprint == nullptr) {
+        return false;
+    }
+    memset(pFootprint, 0, sizeof(*pFootprint));
+    GetCodecMemoryFootprint(pFootprint);
+    if (m_pStartCodeScanner) {
+        pFootprint->onDemandSize += m_pStartCodeScanner->GetMemorySize();
+    }
     return true;
 }
 
 
+bool VulkanVideoDecoder::GetTelemetry(VkParserTelemetry *pTelemetry)
+{
+    if (pTelemetry == nullptr) {
+        return false;
+    }
+    *pTelemetry = m_telemetry;
+    return true;
+}
+
+static void AddCallbackTiming(VkParserCallbackTiming& timing, std::chrono::steady_clock::time_point start)
+{
+    const uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+    timing.count++;
+    timing.totalNs += ns;
+    timing.maxNs = std::max(timing.maxNs, ns);
+}
+
+int32_t VulkanVideoDecoder::ClientBeginSequence(const VkParserSequenceInfo *pnvsi)
+{
+    if (!m_bCallbackTimings) {
+        return m_pClient->BeginSequence(pnvsi);
+    }
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const int32_t maxFrameBuffers = m_pClient->BeginSequence(pnvsi);
+    AddCallbackTiming(m_telemetry.beginSequence, start);
+    return maxFrameBuffers;
+}
+
+bool VulkanVideoDecoder::ClientDecodePicture(VkParserPictureData *pnvpd)
+{
+    m_telemetry.pictures++;
+    m_telemetry.slices += pnvpd->numSlices;
+    m_telemetry.maxSlicesPerPicture = std::max(m_telemetry.maxSlicesPerPicture, pnvpd->numSlices);
+    if (!m_bCallbackTimings) {
+        return m_pClient->DecodePicture(pnvpd);
+    }
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const bool decoded = m_pClient->DecodePicture(pnvpd);
+    AddCallbackTiming(m_telemetry.decodePicture, start);
+    return decoded;
+}
+
+void VulkanVideoDecoder::ClientDisplayPicture(VkPicIf *pPicBuf, int64_t llPTS)
+{
+    if (!m_bCallbackTimings) {
+        m_pClient->DisplayPicture(pPicBuf, llPTS);
+        return;
+    }
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    m_pClient->DisplayPicture(pPicBuf, llPTS);
+    AddCallbackTiming(m_telemetry.displayPicture, start);
+}
+
+
 void VulkanVideoDecoder::init_dbits()
 {
     m_nalu.get_offset = m_nalu.start_offset + ((m_bNoStartCodes) ? 0 : 3);  // Skip over start_code_prefix
@@ -202,6 +291,35 @@ void VulkanVideoDecoder::skip_bits(uint32_t n)
     }
 }
 
+// The bit buffer reads ahead of the current position and consumed_bits() does not count the
+// emulation prevention bytes, so the NAL unit is scanned again up to the current position.
+int64_t VulkanVideoDecoder::consumed_bytes_offset()
+{
+    assert(byte_aligned());
+    const int64_t startCodeBytes = m_bNoStartCodes ? 0 : 3;
+    int64_t offset = m_nalu.start_offset + startCodeBytes;
+    int64_t bytes = (consumed_bits() >> 3) - startCodeBytes;
+    uint32_t zerocnt = 0;
+    while ((bytes > 0) && (offset < m_nalu.end_offset))
+    {
+        VkDeviceSize c = m_bitstreamData[offset++];
+        if (m_bEmulBytesPresent)
+        {
+            if ((zerocnt == 2) && (c == 3))
+            {
+                zerocnt = 0;
+                continue; // emulation_prevention_three_byte
+            }
+            if (c != 0)
+                zerocnt = 0;
+            else
+                zerocnt += (zerocnt < 2);
+        }
+        bytes--;
+    }
+    return offset;
+}
+
 void VulkanVideoDecoder::rbsp_trailing_bits()
 {
     f(1, 1); // rbsp_stop_one_bit
@@ -291,6 +409,8 @@ bool VulkanVideoDecoder::resizeBitstreamBuffer(VkDeviceSize extraBytes)
     }
 
     m_bitstreamDataLen = (VkDeviceSize)retSize;
+    m_telemetry.bufferResizes++;
+    m_telemetry.maxBufferSize = std::max<uint64_t>(m_telemetry.maxBufferSize, m_bitstreamDataLen);
     return true;
 }
 
@@ -312,12 +432,192 @@ VkDeviceSize VulkanVideoDecoder::swapBitstreamBuffer(VkDeviceSize copyCurrBuffOf
         assert(!"Cound't GetBitstreamBuffer()!");
         return false;
     }
+    m_telemetry.bufferSwaps++;
+    m_telemetry.bytesCarriedOver += copyCurrBuffSize;
     // m_bitstreamDataLen = newBufferSize;
     return m_bitstreamData.SetBitstreamBuffer(newBitstreamBuffer);
 }
 
+// Moves the data that follows the current picture (the current NAL unit, and the
+// metadata NAL units received ahead of it) to the start of a new bitstream buffer.
+void VulkanVideoDecoder::StartNextPictureBuffer()
+{
+    const int64_t pictureEnd = GetPictureDataEnd();
+
+    // This swap will copy to the new buffer most of the time.
+    m_bitstreamDataLen = swapBitstreamBuffer(pictureEnd, m_nalu.end_offset - pictureEnd);
+    m_nalu.end_offset -= pictureEnd;
+    m_nalu.start_offset -= pictureEnd;
+    m_bitstreamData.ResetStreamMarkers();
+    m_llNaluStartLocation = m_llParsedBytes - (m_nalu.end_offset - m_nalu.start_offset);
+
+    // The metadata of the current picture has been reported, move the pending one
+    const uint32_t firstPending = m_numMetadata - m_numPendingMetadata;
+    for (uint32_t i = 0; i < m_numPendingMetadata; i++) {
+        m_metadata[i] = m_metadata[firstPending + i];
+        m_metadata[i].offset -= (uint32_t)pictureEnd;
+    }
+    m_numMetadata = m_numPendingMetadata;
+    m_pendingMetadataOffset = (m_numPendingMetadata > 0) ? (m_pendingMetadataOffset - pictureEnd) : 0;
+}
+
+bool VulkanVideoDecoder::AddMetadata(const VkParserMetadata& metadata, bool nextPicture)
+{
+    if (m_numMetadata >= MAX_PICTURE_METADATA) {
+        nvParserVerboseLog("Dropping metadata (payload type %d), more than %d per picture\n",
+                           metadata.payloadType, MAX_PICTURE_METADATA);
+        return false;
+    }
+    if (nextPicture) {
+        if (m_numPendingMetadata == 0) {
+            m_pendingMetadataOffset = m_nalu.start_offset;
+        }
+        m_numPendingMetadata++;
+    }
+    m_metadata[m_numMetadata++] = metadata;
+    return true;
+}
+
+// ITU-T T.35 payloads, starting with itu_t_t35_country_code
+VkParserMetadataType VulkanVideoDecoder::GetItuTT35MetadataType(const uint8_t* pData, size_t size)
+{
+    // United States country code, followed by the terminal provider code
+    if ((size < 6) || (pData[0] != 0xB5)) {
+        return VK_PARSER_METADATA_TYPE_ITU_T_T35;
+    }
+    const uint32_t providerCode = (pData[1] << 8) | pData[2];
+    if (providerCode == 0x003C) {
+        // SMPTE ST 2094-40: provider oriented code 1, application identifier 4
+        const uint32_t providerOrientedCode = (pData[3] << 8) | pData[4];
+        if ((providerOrientedCode == 0x0001) && (pData[5] == 4)) {
+            return VK_PARSER_METADATA_TYPE_HDR10PLUS;
+        }
+    } else if ((providerCode == 0x0031) && (size >= 8)) {
+        // ATSC A/53: user_identifier "GA94", user_data_type_code 3 (cc_data)
+        if ((pData[3] == 'G') && (pData[4] == 'A') && (pData[5] == '9') && (pData[6] == '4') && (pData[7] == 0x03)) {
+            return VK_PARSER_METADATA_TYPE_CLOSED_CAPTIONS;
+        }
+    }
+    return VK_PARSER_METADATA_TYPE_ITU_T_T35;
+}
+
+// Records the messages of the current SEI NAL unit (7.3.2.3 / 7.3.5). The
+// payloads are located in the raw NAL unit, emulation prevention bytes
+// included, so that they can be read back from the bitstream buffer.
+bool VulkanVideoDecoder::AddSeiMetadata(uint32_t nalHeaderBytes, bool suffix)
+{
+    if (!m_bPictureMetadata || m_bNoStartCodes) {
+        return false;
+    }
+    // A suffix SEI follows the slices of its picture, a prefix SEI precedes them.
+    const bool nextPicture = !suffix || (m_numPendingMetadata > 0);
+    if (!nextPicture && (m_bitstreamData.GetStreamMarkersCount() == 0)) {
+        return false;
+    }
+
+    const uint8_t* pData = m_bitstreamData.GetBitstreamPtr();
+    int64_t pos = m_nalu.start_offset + 3 + nalHeaderBytes;
+    int64_t end = m_nalu.end_offset;
+    // Remove the trailing zero bytes and the rbsp_trailing_bits() byte
+    while ((end > pos) && (pData[end - 1] == 0)) {
+        end--;
+    }
+    end = (end > pos) ? (end - 1) : pos;
+
+    uint32_t zeroCount = 0;
+    // Next byte of the RBSP, -1 at the end of the messages
+    auto rbspByte = [&]() -> int32_t {
+        while (pos < end) {
+            const uint8_t c = pData[pos++];
+            if ((zeroCount >= 2) && (c == 0x03)) {
+                zeroCount = 0;  // emulation_prevention_three_byte
+                continue;
+            }
+            zeroCount = (c == 0) ? (zeroCount + 1) : 0;
+            return c;
+        }
+        return -1;
+    };
+
+    bool added = false;
+    while (pos < end) {
+        int32_t c;
+        uint32_t payloadType = 0, payloadSize = 0;
+        while ((c = rbspByte()) == 0xff) {
+            payloadType += 255;
+        }
+        if (c < 0) {
+            break;
+        }
+        payloadType += c;
+        while ((c = rbspByte()) == 0xff) {
+            payloadSize += 255;
+        }
+        if (c < 0) {
+            break;
+        }
+        payloadSize += c;
+        if ((pos < end) && (zeroCount >= 2) && (pData[pos] == 0x03)) {
+            pos++;  // The payload starts after this emulation prevention byte
+            zeroCount = 0;
+        }
+
+        VkParserMetadata metadata = VkParserMetadata();
+        metadata.payloadType = payloadType;
+        metadata.offset = (uint32_t)pos;
+        metadata.payloadSize = payloadSize;
+        metadata.suffix = suffix;
+        metadata.emulationPrevention = 1;
+        metadata.precedingZeros = std::min<uint32_t>(zeroCount, 2);
+
+        // The first payload bytes identify the registered user data
+        uint8_t head[8];
+        uint32_t bytes = 0;
+        while ((bytes < payloadSize) && ((c = rbspByte()) >= 0)) {
+            if (bytes < sizeof(head)) {
+                head[bytes] = (uint8_t)c;
+            }
+            bytes++;
+        }
+        if (bytes < payloadSize) {
+            nvParserLog("ignoring truncated SEI message (%d/%d)\n", payloadSize, bytes);
+            break;
+        }
+        metadata.size = (uint32_t)(pos - metadata.offset);
+
+        switch (payloadType) {
+        case 1:     // pic_timing
+            metadata.type = VK_PARSER_METADATA_TYPE_PICTURE_TIMING;
+            break;
+        case 4:     // user_data_registered_itu_t_t35
+            metadata.type = GetItuTT35MetadataType(head, std::min<size_t>(payloadSize, sizeof(head)));
+            break;
+        case 5:     // user_data_unregistered
+            metadata.type = VK_PARSER_METADATA_TYPE_USER_DATA_UNREGISTERED;
+            break;
+        case 136:   // time_code (H.265 only)
+            metadata.type = (m_standard == VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR) ?
+                                VK_PARSER_METADATA_TYPE_TIMECODE : VK_PARSER_METADATA_TYPE_UNKNOWN;
+            break;
+        case 137:   // mastering_display_colour_volume
+            metadata.type = VK_PARSER_METADATA_TYPE_MASTERING_DISPLAY;
+            break;
+        case 144:   // content_light_level_info
+            metadata.type = VK_PARSER_METADATA_TYPE_CONTENT_LIGHT_LEVEL;
+            break;
+        default:
+            metadata.type = VK_PARSER_METADATA_TYPE_UNKNOWN;
+            break;
+        }
+
+        added = AddMetadata(metadata, nextPicture) || added;
+    }
+    return added;
+}
+
 bool VulkanVideoDecoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_t *pParsedBytes)
 {
+    m_telemetry.bytesParsed += pck->nDataLength;
 #if defined(__x86_64__) || defined (_M_X64)
     if (m_NextStartCode == SIMD_ISA::AVX512)
     {
@@ -357,20 +657,18 @@ void VulkanVideoDecoder::nal_unit()
         init_dbits();
         if (IsPictureBoundary(available_bits() >> 3))
         {
-            if (m_nalu.start_offset > 0)
+            if (GetPictureDataEnd() > 0)
             {
                 end_of_picture();
-
-                // This swap will copy to the new buffer most of the time.
-                m_bitstreamDataLen = swapBitstreamBuffer(m_nalu.start_offset, m_nalu.end_offset - m_nalu.start_offset);
-                m_nalu.end_offset -= m_nalu.start_offset;
-                m_nalu.start_offset = 0;
-                m_bitstreamData.ResetStreamMarkers();
-                m_llNaluStartLocation = m_llParsedBytes - m_nalu.end_offset;
+                StartNextPictureBuffer();
             }
         }
         init_dbits();
+        const uint8_t nalHeader = m_bitstreamData.GetBitstreamPtr()[m_nalu.start_offset + 3];
+        m_telemetry.nalUnitTypes[(m_standard == VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR) ?
+                                 ((nalHeader >> 1) & 0x3f) : (nalHeader & 0x1f)]++;
         nal_type = ParseNalUnit();
+        m_telemetry.emulationPreventionBytes += m_nalu.get_emulcnt;
         switch(nal_type)
         {
         case NALU_SLICE:
@@ -378,11 +676,16 @@ void VulkanVideoDecoder::nal_unit()
             {
                 if (m_bitstreamData.GetStreamMarkersCount() == 0) {
                     m_llFrameStartLocation = m_llNaluStartLocation;
+                    // The metadata received so far belongs to this picture
+                    m_numPendingMetadata = 0;
                 }
                 assert(m_nalu.start_offset < std::numeric_limits<int32_t>::max());
                 m_bitstreamData.AddStreamMarker((uint32_t)m_nalu.start_offset);
             }
             break;
+        case NALU_METADATA:
+            // Keep the NAL unit in the bitstream buffer, the metadata refers to it
+            break;
         //case NALU_DISCARD:
         default:
             if ((nal_type == NALU_UNKNOWN) && (m_pClient))
@@ -424,7 +727,7 @@ int VulkanVideoDecoder::init_sequence(VkParserSequenceInfo *pnvsi)
         {
             uint32_t lNumerator, lDenominator;
             memcpy(&m_PrevSeqInfo, pnvsi, sizeof(VkParserSequenceInfo));
-            m_MaxFrameBuffers = m_pClient->BeginSequence(&m_PrevSeqInfo);
+            m_MaxFrameBuffers = ClientBeginSequence(&m_PrevSeqInfo);
             if (!m_MaxFrameBuffers)
             {
                 m_bDecoderInitFailed = true;
@@ -459,9 +762,11 @@ void VulkanVideoDecoder::end_of_picture()
         m_pVkPictureData->bitstreamDataOffset = 0;
         m_pVkPictureData->firstSliceIndex = 0;
         m_pVkPictureData->bitstreamData = m_bitstreamData.GetBitstreamBuffer();
-        assert((uint64_t)m_nalu.start_offset < (uint64_t)std::numeric_limits<size_t>::max());
-        m_pVkPictureData->bitstreamDataLen = (size_t)m_nalu.start_offset;
+        assert((uint64_t)GetPictureDataEnd() < (uint64_t)std::numeric_limits<size_t>::max());
+        m_pVkPictureData->bitstreamDataLen = (size_t)GetPictureDataEnd();
         m_pVkPictureData->numSlices = m_bitstreamData.GetStreamMarkersCount();
+        m_pVkPictureData->pMetadata = (m_numMetadata > m_numPendingMetadata) ? m_metadata : nullptr;
+        m_pVkPictureData->numMetadata = m_numMetadata - m_numPendingMetadata;
         if(BeginPicture(m_pVkPictureData))
         {
             if ((m_pVkPictureData + m_iTargetLayer)->pCurrPic)
@@ -511,7 +816,7 @@ void VulkanVideoDecoder::end_of_picture()
                 if (m_pClient != NULL)
                 {
                     // Notify client
-                    if (!m_pClient->DecodePicture(m_pVkPictureData))
+                    if (!ClientDecodePicture(m_pVkPictureData))
                     {
                         m_DispInfo[lDisp].bSkipped = true;
                         nvParserLog("WARNING: skipped decoding current picture\n");
@@ -603,7 +908,7 @@ void VulkanVideoDecoder::display_picture(VkPicIf *pPicBuf, bool bEvict)
         }
         if ((m_pClient != NULL) && (!m_DispInfo[lDisp].bSkipped)) {
 
-            m_pClient->DisplayPicture(pPicBuf, llPTS);
+            ClientDisplayPicture(pPicBuf, llPTS);
             m_nCallbackEventCount++;
         }
 
@@ -627,6 +932,7 @@ void VulkanVideoDecoder::end_of_stream()
     memset(&m_PrevSeqInfo, 0, sizeof(m_PrevSeqInfo));
     memset(&m_PTSQueue, 0, sizeof(m_PTSQueue));
     m_bitstreamData.ResetStreamMarkers();
+    ResetMetadata();
     m_BitBfr = (uint32_t)~0;
     m_llParsedBytes = 0;
     m_llNaluStartLocation = 0;
@@ -739,12 +1045,11 @@ VkResult CreateVulkanVideoDecodeParser(VkVideoCodecOperationFlagBitsKHR videoCod
         }
         nvVideoDecodeParser =  VkSharedBaseObj<VulkanAV1Decoder>(new VulkanAV1Decoder(videoCodecOperation));
         break;
-#ifdef ENABLE_VP9_DECODER
     case VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR:
-        // TODO: This will not work and is only here as a placeholder to get the compiler to include and link the class.
+        // There is no VP9 codec std header to check the version of, the
+        // parser reports VkParserVp9PictureData to the client.
         nvVideoDecodeParser =  VkSharedBaseObj<VulkanVP9Decoder>(new VulkanVP9Decoder(videoCodecOperation));
         break;
-#endif
     default:
         nvParserErrorLog("Unsupported codec type!!!\n");
     }
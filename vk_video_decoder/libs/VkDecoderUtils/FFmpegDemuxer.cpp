@@ -15,6 +15,13 @@
 */
 
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "VkDecoderUtils/VideoStreamDemuxer.h"
 
 extern "C" {
@@ -58,7 +65,7 @@ private:
             return -1;
         }
 
-        std::cout << "Media format: " << fmtc->iformat->long_name << " (" << fmtc->iformat->name << ")";
+        std::cout << "Media format: " << fmtc->iformat->long_name << " (" << fmtc->iformat->name << ")" << std::endl;
 
         ck(avformat_find_stream_info(fmtc, NULL));
         videoStream = av_find_best_stream(fmtc, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
@@ -228,12 +235,30 @@ private:
         , colorTransferCharacteristics()
         , colorSpace()
         , chromaLocation()
+        , readAheadPackets()
+        , readAheadThread()
+        , readAheadMutex()
+        , packetReady()
+        , packetFree()
+        , packetPool()
+        , freePackets()
+        , readyPackets()
+        , pCurrentPacket()
+        , readAheadStatus()
+        , stopReadAhead()
+        , readAheadStats()
         {
             fmtc = CreateFormatContext(pFilePath, video_codec_id);
         }
 
     virtual ~FFmpegDemuxer() {
 
+        StopReadAhead();
+        for (AVPacket* pPacket : packetPool) {
+            FreePacket(pPacket);
+        }
+        packetPool.clear();
+
         if (pPkt) {
 #if (LIBAVCODEC_VERSION_MAJOR < 58)
             if (pPkt->data) {
@@ -277,6 +302,7 @@ public:
                            int32_t,
                            int32_t,
                            int32_t,
+                           uint32_t readAheadPackets,
                            VkSharedBaseObj<FFmpegDemuxer>& ffmpegDemuxer)
     {
         enum AVCodecID videoCodecId = AV_CODEC_ID_NONE;
@@ -292,6 +318,9 @@ public:
         VkSharedBaseObj<FFmpegDemuxer> demuxer(new FFmpegDemuxer(pFilePath, videoCodecId));
 
         if (demuxer && (demuxer->Initialize() >= 0)) {
+            if (readAheadPackets > 0) {
+                demuxer->StartReadAhead(readAheadPackets);
+            }
             ffmpegDemuxer = demuxer;
             return VK_SUCCESS;
         }
@@ -456,30 +485,18 @@ public:
             return -1;
         }
 
-        if (pPkt->data) {
-            av_packet_unref(pPkt);
+        if (readAheadPackets > 0) {
+            return PopPacket(ppVideo);
         }
 
-        int e = 0;
-        while ((e = av_read_frame(fmtc, pPkt)) >= 0 && pPkt->stream_index != videoStream) {
-            av_packet_unref(pPkt);
-        }
+        AVPacket* pPacket = nullptr;
+        int e = ReadVideoPacket(&pPacket);
         if (e < 0) {
             return e;
         }
 
-        if (isStreamDemuxer) {
-            if (pktFiltered->data) {
-                av_packet_unref(pktFiltered);
-            }
-            ck(av_bsf_send_packet(bsfc, pPkt));
-            ck(av_bsf_receive_packet(bsfc, pktFiltered));
-            *ppVideo = pktFiltered->data;
-            return pktFiltered->size;
-        } else {
-            *ppVideo = pPkt->data;
-            return pPkt->size;
-        }
+        *ppVideo = pPacket->data;
+        return pPacket->size;
     }
 
     virtual int64_t ReadBitstreamData(const uint8_t**, int64_t) {
@@ -492,7 +509,22 @@ public:
 
     virtual void Rewind()
     {
+        const uint32_t numReadAheadPackets = readAheadPackets;
+        StopReadAhead();
         av_seek_frame(fmtc, videoStream, 0, isStreamDemuxer ? AVSEEK_FLAG_ANY : AVSEEK_FLAG_BYTE);
+        if (numReadAheadPackets > 0) {
+            StartReadAhead(numReadAheadPackets);
+        }
+    }
+
+    virtual bool GetReadAheadStats(ReadAheadStats& stats) const
+    {
+        if (packetPool.empty()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(readAheadMutex);
+        stats = readAheadStats;
+        return true;
     }
 
     virtual void DumpStreamParameters() const {
@@ -600,6 +632,176 @@ public:
     }
 
 private:
+
+    static AVPacket* AllocPacket()
+    {
+#if (LIBAVCODEC_VERSION_MAJOR < 58)
+        AVPacket* pPacket = (AVPacket *)av_malloc(sizeof(AVPacket));
+        av_init_packet(pPacket);
+#else
+        AVPacket* pPacket = av_packet_alloc();
+#endif // (LIBAVCODEC_VERSION_MAJOR < 58)
+        pPacket->data = NULL;
+        pPacket->size = 0;
+        return pPacket;
+    }
+
+    static void FreePacket(AVPacket* pPacket)
+    {
+#if (LIBAVCODEC_VERSION_MAJOR < 58)
+        if (pPacket->data) {
+            av_packet_unref(pPacket);
+        }
+        av_free(pPacket);
+#else // (LIBAVCODEC_VERSION_MAJOR < 58)
+        av_packet_free(&pPacket);
+#endif // (LIBAVCODEC_VERSION_MAJOR < 58)
+    }
+
+    // Reads the next packet of the video stream and runs it through the
+    // bitstream filter, the packet returned is owned by the demuxer and is
+    // valid until the next call.
+    int ReadVideoPacket(AVPacket** ppPacket)
+    {
+        if (pPkt->data) {
+            av_packet_unref(pPkt);
+        }
+
+        int e = 0;
+        while ((e = av_read_frame(fmtc, pPkt)) >= 0 && pPkt->stream_index != videoStream) {
+            av_packet_unref(pPkt);
+        }
+        if (e < 0) {
+            return e;
+        }
+
+        if (isStreamDemuxer) {
+            if (pktFiltered->data) {
+                av_packet_unref(pktFiltered);
+            }
+            ck(av_bsf_send_packet(bsfc, pPkt));
+            ck(av_bsf_receive_packet(bsfc, pktFiltered));
+            *ppPacket = pktFiltered;
+        } else {
+            *ppPacket = pPkt;
+        }
+        return 0;
+    }
+
+    // The read-ahead thread runs ReadVideoPacket() and moves the references
+    // of the packets to the packets of a pool, which go through the ready
+    // queue to the parser thread and come back to the free list on the next
+    // DemuxFrame() call. The pool size bounds the queue.
+    void StartReadAhead(uint32_t numPackets)
+    {
+        while (packetPool.size() < numPackets) {
+            packetPool.push_back(AllocPacket());
+        }
+        freePackets = packetPool;
+        readyPackets.clear();
+        pCurrentPacket = nullptr;
+        readAheadStatus = 0;
+        stopReadAhead = false;
+        readAheadPackets = numPackets;
+        readAheadThread = std::thread(&FFmpegDemuxer::ReadAheadThread, this);
+    }
+
+    void StopReadAhead()
+    {
+        if (!readAheadThread.joinable()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(readAheadMutex);
+            stopReadAhead = true;
+        }
+        packetFree.notify_one();
+        readAheadThread.join();
+
+        for (AVPacket* pPacket : packetPool) {
+            av_packet_unref(pPacket);
+        }
+        readyPackets.clear();
+        freePackets.clear();
+        pCurrentPacket = nullptr;
+        readAheadPackets = 0;
+    }
+
+    void ReadAheadThread()
+    {
+        for (;;) {
+            AVPacket* pPacket = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(readAheadMutex);
+                if (freePackets.empty() && !stopReadAhead) {
+                    readAheadStats.demuxerStalls++;
+                    packetFree.wait(lock, [this] { return stopReadAhead || !freePackets.empty(); });
+                }
+                if (stopReadAhead) {
+                    return;
+                }
+                pPacket = freePackets.back();
+                freePackets.pop_back();
+            }
+
+            AVPacket* pDemuxedPacket = nullptr;
+            const int e = ReadVideoPacket(&pDemuxedPacket);
+            if (e >= 0) {
+                av_packet_move_ref(pPacket, pDemuxedPacket);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(readAheadMutex);
+                if (e < 0) {
+                    freePackets.push_back(pPacket);
+                    readAheadStatus = e;
+                } else {
+                    readyPackets.push_back(pPacket);
+                }
+            }
+            packetReady.notify_one();
+            if (e < 0) {
+                return;
+            }
+        }
+    }
+
+    int64_t PopPacket(const uint8_t **ppVideo)
+    {
+        std::unique_lock<std::mutex> lock(readAheadMutex);
+
+        // The previous packet isn't referenced by the parser anymore.
+        if (pCurrentPacket != nullptr) {
+            av_packet_unref(pCurrentPacket);
+            freePackets.push_back(pCurrentPacket);
+            pCurrentPacket = nullptr;
+            packetFree.notify_one();
+        }
+
+        if (readyPackets.empty() && (readAheadStatus >= 0)) {
+            const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            readAheadStats.parserStalls++;
+            packetReady.wait(lock, [this] { return !readyPackets.empty() || (readAheadStatus < 0); });
+            readAheadStats.parserStallTimeUs += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - startTime).count();
+        }
+
+        if (readyPackets.empty()) {
+            return readAheadStatus;
+        }
+
+        const uint32_t queueDepth = (uint32_t)readyPackets.size();
+        readAheadStats.numPackets++;
+        readAheadStats.queueDepthSum += queueDepth;
+        readAheadStats.maxQueueDepth = std::max(readAheadStats.maxQueueDepth, queueDepth);
+
+        pCurrentPacket = readyPackets.front();
+        readyPackets.pop_front();
+        *ppVideo = pCurrentPacket->data;
+        return pCurrentPacket->size;
+    }
+
     AVFormatContext *fmtc = NULL;
     AVIOContext *avioc = NULL;
     AVPacket *pPkt, *pktFiltered;
@@ -640,6 +842,21 @@ private:
     enum AVColorSpace                  colorSpace;
     enum AVChromaLocation              chromaLocation;
 
+    /**
+     * Read-ahead of the packets on a separate thread.
+     */
+    uint32_t                           readAheadPackets;
+    std::thread                        readAheadThread;
+    mutable std::mutex                 readAheadMutex;
+    std::condition_variable            packetReady;
+    std::condition_variable            packetFree;
+    std::vector<AVPacket*>             packetPool;
+    std::vector<AVPacket*>             freePackets;
+    std::deque<AVPacket*>              readyPackets;
+    AVPacket*                          pCurrentPacket;
+    int                                readAheadStatus;
+    bool                               stopReadAhead;
+    ReadAheadStats                     readAheadStats;
 };
 
 VkResult FFmpegDemuxerCreate(const char *pFilePath,
@@ -648,6 +865,7 @@ VkResult FFmpegDemuxerCreate(const char *pFilePath,
                              int32_t defaultWidth,
                              int32_t defaultHeight,
                              int32_t defaultBitDepth,
+                             uint32_t readAheadPackets,
                              VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer)
 {
     VkSharedBaseObj<FFmpegDemuxer> ffmpegDemuxer;
@@ -657,6 +875,7 @@ VkResult FFmpegDemuxerCreate(const char *pFilePath,
                                             defaultWidth,
                                             defaultHeight,
                                             defaultBitDepth,
+                                            readAheadPackets,
                                             ffmpegDemuxer);
     if (result == VK_SUCCESS) {
         videoStreamDemuxer = ffmpegDemuxer;
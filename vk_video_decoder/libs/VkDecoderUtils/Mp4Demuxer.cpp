@@ -0,0 +1,929 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+#include "mio/mio.hpp"
+#include "VkDecoderUtils/VideoStreamDemuxer.h"
+
+// ISO/IEC 14496-12 (ISO base media file format) demuxer serving the samples of
+// the first H.264, H.265 or AV1 video track directly from the file mapping.
+// The sample tables of the movie box and of all movie fragments are flattened
+// into one array when the file is opened, so that any sample is found by its
+// index and random access only needs a search in the sync sample table.
+class Mp4Demuxer : public VideoStreamDemuxer {
+
+    static constexpr uint32_t FourCC(char a, char b, char c, char d)
+    {
+        return ((uint32_t)(uint8_t)a << 24) | ((uint32_t)(uint8_t)b << 16) |
+               ((uint32_t)(uint8_t)c << 8) | (uint32_t)(uint8_t)d;
+    }
+
+    static uint16_t ReadU16(const uint8_t* p) { return (uint16_t)((p[0] << 8) | p[1]); }
+    static uint32_t ReadU32(const uint8_t* p)
+    {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+    static uint64_t ReadU64(const uint8_t* p) { return ((uint64_t)ReadU32(p) << 32) | ReadU32(p + 4); }
+
+    // A box of the file, the offsets are absolute offsets in the mapping.
+    struct Box {
+        uint32_t type;
+        uint64_t offset;     // start of the box header
+        uint64_t dataOffset; // start of the payload
+        uint64_t end;        // end of the box
+    };
+
+    struct Sample {
+        uint64_t offset;
+        uint32_t size;
+        uint32_t isSync;
+    };
+
+    // Defaults of the fragmented samples, from the trex box of the track.
+    struct TrackExtends {
+        uint32_t defaultSampleSize;
+        uint32_t defaultSampleFlags;
+    };
+
+public:
+    Mp4Demuxer(const char *pFilePath,
+               VkVideoCodecOperationFlagBitsKHR forceParserType,
+               int32_t defaultWidth,
+               int32_t defaultHeight,
+               int32_t defaultBitDepth)
+        : VideoStreamDemuxer()
+        , m_width(defaultWidth)
+        , m_height(defaultHeight)
+        , m_lumaBitDepth(defaultBitDepth)
+        , m_chromaBitDepth(defaultBitDepth)
+        , m_chromaSubsampling(VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR)
+        , m_profileIdc(0)
+        , m_levelIdc(0)
+        , m_forcedCodecType(forceParserType)
+        , m_videoCodecType(VK_VIDEO_CODEC_OPERATION_NONE_KHR)
+        , m_trackId(0)
+        , m_nalLengthSize(0)
+        , m_numFragments(0)
+        , m_inputVideoStreamMmap()
+        , m_pBitstreamData(nullptr)
+        , m_bitstreamDataSize(0)
+        , m_samples()
+        , m_syncSamples()
+        , m_parameterSets()
+        , m_sampleBuffer()
+        , m_currentSample(0)
+        , m_insertParameterSets(true) {
+
+        std::error_code error;
+        m_inputVideoStreamMmap.map(pFilePath, 0, mio::map_entire_file, error);
+        if (error) {
+            fprintf(stderr, "\nERROR: Can't map the input stream file %s\n", pFilePath);
+            return;
+        }
+
+        m_bitstreamDataSize = m_inputVideoStreamMmap.mapped_length();
+        m_pBitstreamData = m_inputVideoStreamMmap.data();
+    }
+
+    int32_t Initialize()
+    {
+        if (m_pBitstreamData == nullptr) {
+            return -1;
+        }
+
+        // The moov box can be anywhere at the top level, the movie fragments
+        // are only meaningful after it.
+        Box box;
+        uint64_t pos = 0;
+        bool hasMovie = false;
+        while (NextBox(pos, m_bitstreamDataSize, box)) {
+            if (box.type == FourCC('m','o','o','v')) {
+                hasMovie = ParseMovie(box);
+                break;
+            }
+            pos = box.end;
+        }
+
+        if (!hasMovie) {
+            fprintf(stderr, "\nERROR: No supported video track in the ISO-BMFF file\n");
+            return -1;
+        }
+
+        pos = 0;
+        while (NextBox(pos, m_bitstreamDataSize, box)) {
+            if (box.type == FourCC('m','o','o','f')) {
+                ParseMovieFragment(box);
+                m_numFragments++;
+            }
+            pos = box.end;
+        }
+
+        if (m_samples.empty()) {
+            fprintf(stderr, "\nERROR: The video track of the ISO-BMFF file has no samples\n");
+            return -1;
+        }
+
+        for (uint32_t i = 0; i < m_samples.size(); i++) {
+            if (m_samples[i].isSync) {
+                m_syncSamples.push_back(i);
+            }
+        }
+
+        // Size the conversion buffer for the largest sample once, so that
+        // demuxing doesn't allocate. Each NAL unit length field becomes a
+        // 4 byte start code, at most one per m_nalLengthSize bytes of sample.
+        if (m_nalLengthSize != 0) {
+            assert((m_nalLengthSize == 1) || (m_nalLengthSize == 2) || (m_nalLengthSize == 4));
+            uint32_t maxSampleSize = 0;
+            for (const Sample& sample : m_samples) {
+                maxSampleSize = std::max(maxSampleSize, sample.size);
+            }
+            const size_t maxStartCodeBytes = (size_t)(maxSampleSize / m_nalLengthSize) * (4 - m_nalLengthSize);
+            m_sampleBuffer.resize(m_parameterSets.size() + (size_t)maxSampleSize + maxStartCodeBytes);
+        }
+
+        return 0;
+    }
+
+    static VkResult Create(const char *pFilePath,
+                           VkVideoCodecOperationFlagBitsKHR codecType,
+                           int32_t defaultWidth,
+                           int32_t defaultHeight,
+                           int32_t defaultBitDepth,
+                           VkSharedBaseObj<Mp4Demuxer>& mp4Demuxer)
+    {
+        VkSharedBaseObj<Mp4Demuxer> demuxer(new Mp4Demuxer(pFilePath, codecType,
+                                                           defaultWidth,
+                                                           defaultHeight,
+                                                           defaultBitDepth));
+
+        if (demuxer && (demuxer->Initialize() >= 0)) {
+            mp4Demuxer = demuxer;
+            return VK_SUCCESS;
+        }
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    virtual ~Mp4Demuxer() {
+        m_inputVideoStreamMmap.unmap();
+    }
+
+    virtual bool IsStreamDemuxerEnabled() const { return true; }
+    virtual bool HasFramePreparser() const { return true; }
+    virtual void Rewind() { SeekToFrame(0); }
+    virtual VkVideoCodecOperationFlagBitsKHR GetVideoCodec() const { return m_videoCodecType; }
+
+    virtual VkVideoComponentBitDepthFlagsKHR GetLumaBitDepth() const
+    {
+        switch (m_lumaBitDepth) {
+        case 8:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
+        case 10:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_10_BIT_KHR;
+        case 12:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_12_BIT_KHR;
+        default:
+            assert(!"Unknown Luma Bit Depth!");
+        }
+        return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+    }
+
+    virtual VkVideoChromaSubsamplingFlagsKHR GetChromaSubsampling() const
+    {
+        return m_chromaSubsampling;
+    }
+
+    virtual VkVideoComponentBitDepthFlagsKHR GetChromaBitDepth() const
+    {
+        switch (m_chromaBitDepth) {
+        case 8:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
+        case 10:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_10_BIT_KHR;
+        case 12:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_12_BIT_KHR;
+        default:
+            assert(!"Unknown Chroma Bit Depth!");
+        }
+        return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+    }
+
+    virtual uint32_t GetProfileIdc() const { return m_profileIdc; }
+
+    virtual int32_t GetWidth() const { return m_width; }
+    virtual int32_t GetHeight() const { return m_height; }
+    virtual int32_t GetBitDepth() const { return m_lumaBitDepth; }
+
+    virtual int64_t DemuxFrame(const uint8_t **ppVideo)
+    {
+        if (m_currentSample >= m_samples.size()) {
+            return -1;
+        }
+
+        const Sample& sample = m_samples[m_currentSample++];
+        const uint8_t* pSample = m_pBitstreamData + sample.offset;
+
+        // AV1 samples are temporal units in the low overhead bitstream
+        // format, which the parser takes as they are.
+        if (m_nalLengthSize == 0) {
+            *ppVideo = pSample;
+            return sample.size;
+        }
+
+        // H.264 and H.265 samples have length prefixed NAL units, replace
+        // the lengths with start codes. The parameter sets of the sample
+        // entry go in front of the first sample after a seek.
+        uint8_t* pDst = m_sampleBuffer.data();
+        if (m_insertParameterSets) {
+            memcpy(pDst, m_parameterSets.data(), m_parameterSets.size());
+            pDst += m_parameterSets.size();
+            m_insertParameterSets = false;
+        }
+
+        uint32_t pos = 0;
+        while ((pos + m_nalLengthSize) <= sample.size) {
+            uint32_t nalSize = 0;
+            for (uint32_t i = 0; i < m_nalLengthSize; i++) {
+                nalSize = (nalSize << 8) | pSample[pos + i];
+            }
+            pos += m_nalLengthSize;
+            if (nalSize > (sample.size - pos)) {
+                fprintf(stderr, "\nWARNING: NAL unit of sample %u exceeds the sample size\n",
+                        m_currentSample - 1);
+                nalSize = sample.size - pos;
+            }
+            pDst[0] = 0;
+            pDst[1] = 0;
+            pDst[2] = 0;
+            pDst[3] = 1;
+            memcpy(pDst + 4, pSample + pos, nalSize);
+            pDst += 4 + nalSize;
+            pos += nalSize;
+        }
+
+        *ppVideo = m_sampleBuffer.data();
+        return pDst - m_sampleBuffer.data();
+    }
+
+    virtual int64_t ReadBitstreamData(const uint8_t**, int64_t)
+    {
+        return -1;
+    }
+
+    virtual int64_t SeekToFrame(int64_t frameIndex)
+    {
+        if (m_syncSamples.empty() || (frameIndex < 0)) {
+            return -1;
+        }
+
+        // The last sync sample at or before the requested one.
+        std::vector<uint32_t>::const_iterator it =
+            std::upper_bound(m_syncSamples.begin(), m_syncSamples.end(), (uint64_t)frameIndex);
+        if (it != m_syncSamples.begin()) {
+            --it;
+        }
+
+        m_currentSample = *it;
+        m_insertParameterSets = true;
+        return m_currentSample;
+    }
+
+    virtual void DumpStreamParameters() const
+    {
+        printf("Container: ISO-BMFF, track %u, %zu samples, %zu sync samples, %u fragments\n",
+               m_trackId, m_samples.size(), m_syncSamples.size(), m_numFragments);
+        printf("Width: %d\n", m_width);
+        printf("Height: %d\n", m_height);
+        printf("BitDepth: %d\n", m_lumaBitDepth);
+        printf("Profile: %u\n", m_profileIdc);
+        printf("Level: %u\n", m_levelIdc);
+    }
+
+private:
+
+    bool NextBox(uint64_t pos, uint64_t end, Box& box) const
+    {
+        if ((pos + 8) > end) {
+            return false;
+        }
+
+        const uint8_t* p = m_pBitstreamData + pos;
+        uint64_t size = ReadU32(p);
+        box.type = ReadU32(p + 4);
+        box.offset = pos;
+        box.dataOffset = pos + 8;
+        if (size == 1) {
+            if ((pos + 16) > end) {
+                return false;
+            }
+            size = ReadU64(p + 8);
+            box.dataOffset = pos + 16;
+        } else if (size == 0) {
+            size = end - pos;
+        }
+        if (box.type == FourCC('u','u','i','d')) {
+            box.dataOffset += 16;
+        }
+
+        if ((size < (box.dataOffset - pos)) || (size > (end - pos))) {
+            fprintf(stderr, "\nWARNING: Truncated or invalid ISO-BMFF box at offset %llu\n",
+                    (unsigned long long)pos);
+            return false;
+        }
+
+        box.end = pos + size;
+        return true;
+    }
+
+    bool FindBox(const Box& parent, uint32_t type, Box& box, uint64_t skip = 0) const
+    {
+        uint64_t pos = parent.dataOffset + skip;
+        while (NextBox(pos, parent.end, box)) {
+            if (box.type == type) {
+                return true;
+            }
+            pos = box.end;
+        }
+        return false;
+    }
+
+    uint64_t BoxDataSize(const Box& box) const { return box.end - box.dataOffset; }
+    const uint8_t* BoxData(const Box& box) const { return m_pBitstreamData + box.dataOffset; }
+
+    bool ParseMovie(const Box& moov)
+    {
+        Box box;
+        uint64_t pos = moov.dataOffset;
+        while (NextBox(pos, moov.end, box)) {
+            if ((box.type == FourCC('t','r','a','k')) && ParseTrack(box)) {
+                break;
+            }
+            pos = box.end;
+        }
+
+        if (m_trackId == 0) {
+            return false;
+        }
+
+        Box mvex, trex;
+        m_trackExtends.defaultSampleSize = 0;
+        m_trackExtends.defaultSampleFlags = 0;
+        if (FindBox(moov, FourCC('m','v','e','x'), mvex)) {
+            pos = mvex.dataOffset;
+            while (NextBox(pos, mvex.end, trex)) {
+                if ((trex.type == FourCC('t','r','e','x')) && (BoxDataSize(trex) >= 24) &&
+                        (ReadU32(BoxData(trex) + 4) == m_trackId)) {
+                    m_trackExtends.defaultSampleSize = ReadU32(BoxData(trex) + 16);
+                    m_trackExtends.defaultSampleFlags = ReadU32(BoxData(trex) + 20);
+                }
+                pos = trex.end;
+            }
+        }
+
+        return true;
+    }
+
+    bool ParseTrack(const Box& trak)
+    {
+        Box tkhd, mdia, hdlr, minf, stbl, stsd;
+        if (!FindBox(trak, FourCC('t','k','h','d'), tkhd) ||
+                !FindBox(trak, FourCC('m','d','i','a'), mdia) ||
+                !FindBox(mdia, FourCC('h','d','l','r'), hdlr) ||
+                !FindBox(mdia, FourCC('m','i','n','f'), minf) ||
+                !FindBox(minf, FourCC('s','t','b','l'), stbl) ||
+                !FindBox(stbl, FourCC('s','t','s','d'), stsd)) {
+            return false;
+        }
+
+        if ((BoxDataSize(hdlr) < 12) || (ReadU32(BoxData(hdlr) + 8) != FourCC('v','i','d','e'))) {
+            return false;
+        }
+
+        // The track_ID follows the creation and modification times, which
+        // are 64 bit with version 1.
+        const uint8_t version = BoxData(tkhd)[0];
+        const uint32_t trackIdOffset = (version == 1) ? 20 : 12;
+        if (BoxDataSize(tkhd) < (trackIdOffset + 4)) {
+            return false;
+        }
+
+        // Only the first sample entry is used, tracks switching between
+        // sample descriptions are not supported.
+        Box sampleEntry;
+        if (!NextBox(stsd.dataOffset + 8, stsd.end, sampleEntry)) {
+            return false;
+        }
+        if (!ParseVisualSampleEntry(sampleEntry)) {
+            return false;
+        }
+
+        m_trackId = ReadU32(BoxData(tkhd) + trackIdOffset);
+        ParseSampleTable(stbl);
+        return true;
+    }
+
+    bool ParseVisualSampleEntry(const Box& entry)
+    {
+        // SampleEntry (8 bytes) and VisualSampleEntry (70 bytes) fields
+        // before the child boxes.
+        if (BoxDataSize(entry) < 78) {
+            return false;
+        }
+
+        VkVideoCodecOperationFlagBitsKHR codecType = VK_VIDEO_CODEC_OPERATION_NONE_KHR;
+        uint32_t configType = 0;
+        switch (entry.type) {
+        case FourCC('a','v','c','1'):
+        case FourCC('a','v','c','3'):
+            codecType = VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR;
+            configType = FourCC('a','v','c','C');
+            break;
+        case FourCC('h','v','c','1'):
+        case FourCC('h','e','v','1'):
+            codecType = VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR;
+            configType = FourCC('h','v','c','C');
+            break;
+        case FourCC('a','v','0','1'):
+            codecType = VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+            configType = FourCC('a','v','1','C');
+            break;
+        default:
+            return false;
+        }
+
+        if ((m_forcedCodecType != VK_VIDEO_CODEC_OPERATION_NONE_KHR) && (m_forcedCodecType != codecType)) {
+            fprintf(stderr, "\nERROR: The video track codec doesn't match the requested codec\n");
+            return false;
+        }
+
+        m_parameterSets.clear();
+        const uint8_t* pEntry = BoxData(entry);
+        const uint16_t width = ReadU16(pEntry + 24);
+        const uint16_t height = ReadU16(pEntry + 26);
+        if ((width != 0) && (height != 0)) {
+            m_width = width;
+            m_height = height;
+        }
+
+        Box config;
+        if (!FindBox(entry, configType, config, 78)) {
+            fprintf(stderr, "\nERROR: The video sample entry has no decoder configuration\n");
+            return false;
+        }
+
+        bool result = false;
+        if (codecType == VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR) {
+            result = ParseAvcConfig(BoxData(config), BoxDataSize(config));
+        } else if (codecType == VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR) {
+            result = ParseHevcConfig(BoxData(config), BoxDataSize(config));
+        } else {
+            result = ParseAv1Config(BoxData(config), BoxDataSize(config));
+        }
+
+        if (result) {
+            m_videoCodecType = codecType;
+        }
+        return result;
+    }
+
+    bool AddParameterSets(const uint8_t*& p, const uint8_t* pEnd, uint32_t count)
+    {
+        static const uint8_t startCode[] = { 0, 0, 0, 1 };
+        for (uint32_t i = 0; i < count; i++) {
+            if ((pEnd - p) < 2) {
+                return false;
+            }
+            const uint16_t size = ReadU16(p);
+            p += 2;
+            if ((pEnd - p) < size) {
+                return false;
+            }
+            m_parameterSets.insert(m_parameterSets.end(), startCode, startCode + sizeof(startCode));
+            m_parameterSets.insert(m_parameterSets.end(), p, p + size);
+            p += size;
+        }
+        return true;
+    }
+
+    // ISO/IEC 14496-15 AVCDecoderConfigurationRecord
+    bool ParseAvcConfig(const uint8_t* p, uint64_t size)
+    {
+        if (size < 7) {
+            return false;
+        }
+        const uint8_t* pEnd = p + size;
+
+        m_profileIdc = p[1];
+        m_levelIdc = p[3];
+        m_nalLengthSize = (p[4] & 0x3) + 1;
+        if (m_nalLengthSize == 3) {
+            fprintf(stderr, "\nERROR: Invalid NAL unit length size of 3 bytes in the decoder configuration\n");
+            return false;
+        }
+        m_lumaBitDepth = m_chromaBitDepth = 8;
+        m_chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR;
+
+        p += 5;
+        const uint32_t numSps = *p++ & 0x1f;
+        if (!AddParameterSets(p, pEnd, numSps) || (p >= pEnd)) {
+            return false;
+        }
+        const uint32_t numPps = *p++;
+        if (!AddParameterSets(p, pEnd, numPps)) {
+            return false;
+        }
+
+        // The chroma format and bit depth are only recorded for the high profiles.
+        if (((m_profileIdc == 100) || (m_profileIdc == 110) ||
+                (m_profileIdc == 122) || (m_profileIdc == 144)) && ((pEnd - p) >= 4)) {
+            m_chromaSubsampling = GetChromaSubsampling(p[0] & 0x3);
+            m_lumaBitDepth = (p[1] & 0x7) + 8;
+            m_chromaBitDepth = (p[2] & 0x7) + 8;
+        }
+        return true;
+    }
+
+    // ISO/IEC 14496-15 HEVCDecoderConfigurationRecord
+    bool ParseHevcConfig(const uint8_t* p, uint64_t size)
+    {
+        if (size < 23) {
+            return false;
+        }
+        const uint8_t* pEnd = p + size;
+
+        m_profileIdc = p[1] & 0x1f;
+        m_levelIdc = p[12];
+        m_chromaSubsampling = GetChromaSubsampling(p[16] & 0x3);
+        m_lumaBitDepth = (p[17] & 0x7) + 8;
+        m_chromaBitDepth = (p[18] & 0x7) + 8;
+        m_nalLengthSize = (p[21] & 0x3) + 1;
+        if (m_nalLengthSize == 3) {
+            fprintf(stderr, "\nERROR: Invalid NAL unit length size of 3 bytes in the decoder configuration\n");
+            return false;
+        }
+
+        const uint32_t numArrays = p[22];
+        p += 23;
+        for (uint32_t i = 0; i < numArrays; i++) {
+            if ((pEnd - p) < 3) {
+                return false;
+            }
+            const uint32_t numNalus = ReadU16(p + 1);
+            p += 3;
+            if (!AddParameterSets(p, pEnd, numNalus)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // AV1 Codec ISO Media File Format Binding, AV1CodecConfigurationRecord.
+    // The sequence header OBUs of the record aren't needed, every sync
+    // sample carries one.
+    bool ParseAv1Config(const uint8_t* p, uint64_t size)
+    {
+        if ((size < 4) || ((p[0] & 0x80) == 0)) {
+            return false;
+        }
+
+        m_profileIdc = p[1] >> 5;
+        m_levelIdc = p[1] & 0x1f;
+        const bool highBitdepth = (p[2] & 0x40) != 0;
+        const bool twelveBit = (p[2] & 0x20) != 0;
+        const bool monochrome = (p[2] & 0x10) != 0;
+        const bool subsamplingX = (p[2] & 0x08) != 0;
+        const bool subsamplingY = (p[2] & 0x04) != 0;
+        m_lumaBitDepth = m_chromaBitDepth = highBitdepth ? (twelveBit ? 12 : 10) : 8;
+        if (monochrome) {
+            m_chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR;
+        } else if (subsamplingX) {
+            m_chromaSubsampling = subsamplingY ? VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR :
+                                                 VK_VIDEO_CHROMA_SUBSAMPLING_422_BIT_KHR;
+        } else {
+            m_chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR;
+        }
+        m_nalLengthSize = 0;
+        return true;
+    }
+
+    static VkVideoChromaSubsamplingFlagsKHR GetChromaSubsampling(uint32_t chromaFormatIdc)
+    {
+        switch (chromaFormatIdc) {
+        case 0:
+            return VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR;
+        case 2:
+            return VK_VIDEO_CHROMA_SUBSAMPLING_422_BIT_KHR;
+        case 3:
+            return VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR;
+        default:
+            return VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR;
+        }
+    }
+
+    bool AddSample(uint64_t offset, uint32_t size, bool isSync)
+    {
+        if ((offset > m_bitstreamDataSize) || (size > (m_bitstreamDataSize - offset))) {
+            fprintf(stderr, "\nWARNING: Sample %zu is outside of the ISO-BMFF file\n", m_samples.size());
+            return false;
+        }
+        const Sample sample = { offset, size, isSync ? 1u : 0u };
+        m_samples.push_back(sample);
+        return true;
+    }
+
+    // Expands the sample to chunk, chunk offset and sample size tables of
+    // the movie box. Fragmented files usually have empty tables here.
+    void ParseSampleTable(const Box& stbl)
+    {
+        Box stsz, stsc, stco, stss;
+        bool compactSizes = false;
+        if (!FindBox(stbl, FourCC('s','t','s','z'), stsz)) {
+            if (!FindBox(stbl, FourCC('s','t','z','2'), stsz)) {
+                return;
+            }
+            compactSizes = true;
+        }
+        bool largeOffsets = false;
+        if (!FindBox(stbl, FourCC('s','t','c','o'), stco)) {
+            if (!FindBox(stbl, FourCC('c','o','6','4'), stco)) {
+                return;
+            }
+            largeOffsets = true;
+        }
+        if (!FindBox(stbl, FourCC('s','t','s','c'), stsc) ||
+                (BoxDataSize(stsz) < 12) || (BoxDataSize(stco) < 8) || (BoxDataSize(stsc) < 8)) {
+            return;
+        }
+
+        const uint8_t* pSizes = BoxData(stsz);
+        const uint32_t constantSize = compactSizes ? 0 : ReadU32(pSizes + 4);
+        const uint32_t fieldSize = compactSizes ? pSizes[7] : 32;
+        const uint32_t sampleCount = ReadU32(pSizes + 8);
+        pSizes += 12;
+        if ((constantSize == 0) &&
+                ((((uint64_t)sampleCount * fieldSize + 7) / 8) > (BoxDataSize(stsz) - 12))) {
+            fprintf(stderr, "\nWARNING: Truncated sample size table\n");
+            return;
+        }
+
+        const uint8_t* pOffsets = BoxData(stco) + 8;
+        const uint32_t chunkCount = std::min<uint64_t>(ReadU32(BoxData(stco) + 4),
+                                        (BoxDataSize(stco) - 8) / (largeOffsets ? 8 : 4));
+        const uint8_t* pChunks = BoxData(stsc) + 8;
+        const uint32_t chunkEntries = std::min<uint64_t>(ReadU32(BoxData(stsc) + 4),
+                                                          (BoxDataSize(stsc) - 8) / 12);
+
+        m_samples.reserve(sampleCount);
+        uint32_t sampleIndex = 0;
+        for (uint32_t entry = 0; (entry < chunkEntries) && (sampleIndex < sampleCount); entry++) {
+            const uint32_t firstChunk = ReadU32(pChunks + entry * 12);
+            const uint32_t samplesPerChunk = ReadU32(pChunks + entry * 12 + 4);
+            const uint32_t lastChunk = ((entry + 1) < chunkEntries) ?
+                                        ReadU32(pChunks + (entry + 1) * 12) : (chunkCount + 1);
+            for (uint32_t chunk = firstChunk; (chunk < lastChunk) && (chunk <= chunkCount); chunk++) {
+                uint64_t offset = largeOffsets ? ReadU64(pOffsets + (chunk - 1) * 8) :
+                                                 ReadU32(pOffsets + (chunk - 1) * 4);
+                for (uint32_t i = 0; (i < samplesPerChunk) && (sampleIndex < sampleCount); i++) {
+                    uint32_t size = constantSize;
+                    if (constantSize == 0) {
+                        switch (fieldSize) {
+                        case 4:
+                            size = (pSizes[sampleIndex / 2] >> ((sampleIndex & 1) ? 0 : 4)) & 0xf;
+                            break;
+                        case 8:
+                            size = pSizes[sampleIndex];
+                            break;
+                        case 16:
+                            size = ReadU16(pSizes + sampleIndex * 2);
+                            break;
+                        default:
+                            size = ReadU32(pSizes + sampleIndex * 4);
+                            break;
+                        }
+                    }
+                    if (!AddSample(offset, size, true)) {
+                        return;
+                    }
+                    offset += size;
+                    sampleIndex++;
+                }
+            }
+        }
+
+        // Without a sync sample table every sample is a sync sample.
+        if (FindBox(stbl, FourCC('s','t','s','s'), stss) && (BoxDataSize(stss) >= 8)) {
+            for (Sample& sample : m_samples) {
+                sample.isSync = 0;
+            }
+            const uint32_t entryCount = std::min<uint64_t>(ReadU32(BoxData(stss) + 4),
+                                                            (BoxDataSize(stss) - 8) / 4);
+            for (uint32_t i = 0; i < entryCount; i++) {
+                const uint32_t sampleNumber = ReadU32(BoxData(stss) + 8 + i * 4);
+                if ((sampleNumber >= 1) && (sampleNumber <= m_samples.size())) {
+                    m_samples[sampleNumber - 1].isSync = 1;
+                }
+            }
+        }
+    }
+
+    void ParseMovieFragment(const Box& moof)
+    {
+        // Without an explicit base offset, the data of the first track
+        // fragment starts at the moof box and each next one follows the data
+        // of the previous one.
+        uint64_t nextBaseOffset = moof.offset;
+        Box traf;
+        uint64_t pos = moof.dataOffset;
+        while (NextBox(pos, moof.end, traf)) {
+            if (traf.type == FourCC('t','r','a','f')) {
+                nextBaseOffset = ParseTrackFragment(moof, traf, nextBaseOffset);
+            }
+            pos = traf.end;
+        }
+    }
+
+    uint64_t ParseTrackFragment(const Box& moof, const Box& traf, uint64_t baseOffset)
+    {
+        Box tfhd;
+        if (!FindBox(traf, FourCC('t','f','h','d'), tfhd) || (BoxDataSize(tfhd) < 8)) {
+            return baseOffset;
+        }
+
+        const uint8_t* p = BoxData(tfhd);
+        const uint8_t* pEnd = p + BoxDataSize(tfhd);
+        const uint32_t flags = ReadU32(p) & 0xffffff;
+        const uint32_t trackId = ReadU32(p + 4);
+        p += 8;
+
+        uint32_t defaultSampleSize = m_trackExtends.defaultSampleSize;
+        uint32_t defaultSampleFlags = m_trackExtends.defaultSampleFlags;
+        const uint32_t numOptionalFields = ((flags & 0x1) ? 2 : 0) + ((flags & 0x2) ? 1 : 0) +
+                                           ((flags & 0x8) ? 1 : 0) + ((flags & 0x10) ? 1 : 0) +
+                                           ((flags & 0x20) ? 1 : 0);
+        if ((pEnd - p) < (numOptionalFields * 4)) {
+            return baseOffset;
+        }
+        if (flags & 0x1) {          // base-data-offset-present
+            baseOffset = ReadU64(p);
+            p += 8;
+        } else if (flags & 0x20000) { // default-base-is-moof
+            baseOffset = moof.offset;
+        }
+        if (flags & 0x2) {          // sample-description-index-present
+            p += 4;
+        }
+        if (flags & 0x8) {          // default-sample-duration-present
+            p += 4;
+        }
+        if (flags & 0x10) {         // default-sample-size-present
+            defaultSampleSize = ReadU32(p);
+            p += 4;
+        }
+        if (flags & 0x20) {         // default-sample-flags-present
+            defaultSampleFlags = ReadU32(p);
+            p += 4;
+        }
+
+        uint64_t dataOffset = baseOffset;
+        Box trun;
+        uint64_t pos = traf.dataOffset;
+        while (NextBox(pos, traf.end, trun)) {
+            pos = trun.end;
+            if ((trun.type != FourCC('t','r','u','n')) || (BoxDataSize(trun) < 8)) {
+                continue;
+            }
+
+            p = BoxData(trun);
+            pEnd = p + BoxDataSize(trun);
+            const uint32_t trunFlags = ReadU32(p) & 0xffffff;
+            const uint32_t sampleCount = ReadU32(p + 4);
+            p += 8;
+            if ((trunFlags & 0x1) && ((pEnd - p) >= 4)) { // data-offset-present
+                dataOffset = baseOffset + (int32_t)ReadU32(p);
+                p += 4;
+            }
+            bool hasFirstSampleFlags = false;
+            uint32_t firstSampleFlags = 0;
+            if ((trunFlags & 0x4) && ((pEnd - p) >= 4)) { // first-sample-flags-present
+                hasFirstSampleFlags = true;
+                firstSampleFlags = ReadU32(p);
+                p += 4;
+            }
+
+            const uint32_t sampleFieldsSize = ((trunFlags & 0x100) ? 4 : 0) + ((trunFlags & 0x200) ? 4 : 0) +
+                                              ((trunFlags & 0x400) ? 4 : 0) + ((trunFlags & 0x800) ? 4 : 0);
+            if ((sampleFieldsSize != 0) && (((uint64_t)(pEnd - p) / sampleFieldsSize) < sampleCount)) {
+                fprintf(stderr, "\nWARNING: Truncated track fragment run\n");
+                break;
+            }
+
+            if (trackId != m_trackId) {
+                continue;
+            }
+
+            m_samples.reserve(m_samples.size() + sampleCount);
+            for (uint32_t i = 0; i < sampleCount; i++) {
+                uint32_t size = defaultSampleSize;
+                uint32_t sampleFlags = ((i == 0) && hasFirstSampleFlags) ? firstSampleFlags : defaultSampleFlags;
+                if (trunFlags & 0x100) {  // sample-duration-present
+                    p += 4;
+                }
+                if (trunFlags & 0x200) {  // sample-size-present
+                    size = ReadU32(p);
+                    p += 4;
+                }
+                if (trunFlags & 0x400) {  // sample-flags-present
+                    sampleFlags = ReadU32(p);
+                    p += 4;
+                }
+                if (trunFlags & 0x800) {  // sample-composition-time-offsets-present
+                    p += 4;
+                }
+                // sample_is_non_sync_sample
+                const bool isSync = ((sampleFlags >> 16) & 0x1) == 0;
+                if (!AddSample(dataOffset, size, isSync)) {
+                    return dataOffset;
+                }
+                dataOffset += size;
+            }
+        }
+        return dataOffset;
+    }
+
+private:
+    int32_t    m_width, m_height, m_lumaBitDepth, m_chromaBitDepth;
+    VkVideoChromaSubsamplingFlagsKHR m_chromaSubsampling;
+    uint32_t   m_profileIdc, m_levelIdc;
+    VkVideoCodecOperationFlagBitsKHR m_forcedCodecType;
+    VkVideoCodecOperationFlagBitsKHR m_videoCodecType;
+    uint32_t   m_trackId;
+    uint32_t   m_nalLengthSize; // 0 for AV1
+    uint32_t   m_numFragments;
+    TrackExtends m_trackExtends;
+    mio::basic_mmap<mio::access_mode::read, uint8_t> m_inputVideoStreamMmap;
+    const uint8_t* m_pBitstreamData;
+    uint64_t       m_bitstreamDataSize;
+    std::vector<Sample>   m_samples;
+    std::vector<uint32_t> m_syncSamples;
+    std::vector<uint8_t>  m_parameterSets; // Annex B VPS/SPS/PPS of the sample entry
+    std::vector<uint8_t>  m_sampleBuffer;
+    uint32_t       m_currentSample;
+    bool           m_insertParameterSets;
+};
+
+bool Mp4DemuxerIsIsoBmffFile(const char *pFilePath)
+{
+    FILE* file = fopen(pFilePath, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    uint8_t header[8];
+    const bool hasHeader = (fread(header, 1, sizeof(header), file) == sizeof(header));
+    fclose(file);
+    if (!hasHeader) {
+        return false;
+    }
+
+    return (memcmp(header + 4, "ftyp", 4) == 0) ||
+           (memcmp(header + 4, "styp", 4) == 0) ||
+           (memcmp(header + 4, "moov", 4) == 0);
+}
+
+VkResult Mp4DemuxerCreate(const char *pFilePath,
+                          VkVideoCodecOperationFlagBitsKHR codecType,
+                          int32_t defaultWidth,
+                          int32_t defaultHeight,
+                          int32_t defaultBitDepth,
+                          VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer)
+{
+    VkSharedBaseObj<Mp4Demuxer> mp4Demuxer;
+    VkResult result = Mp4Demuxer::Create(pFilePath,
+                                         codecType,
+                                         defaultWidth,
+                                         defaultHeight,
+                                         defaultBitDepth,
+                                         mp4Demuxer);
+    if (result == VK_SUCCESS) {
+        videoStreamDemuxer = mp4Demuxer;
+    }
+
+    return result;
+}
@@ -16,14 +16,6 @@
 
 #include "VkDecoderUtils/VideoStreamDemuxer.h"
 
-VkResult FFmpegDemuxerCreate(const char *pFilePath,
-                             VkVideoCodecOperationFlagBitsKHR codecType,
-                             bool requiresStreamDemuxing,
-                             int32_t defaultWidth,
-                             int32_t defaultHeight,
-                             int32_t defaultBitDepth,
-                             VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
-
 VkResult ElementaryStreamCreate(const char *pFilePath,
                                 VkVideoCodecOperationFlagBitsKHR codecType,
                                 int32_t defaultWidth,
@@ -37,8 +29,21 @@ VkResult VideoStreamDemuxer::Create(const char *pFilePath,
                                     int32_t defaultWidth,
                                     int32_t defaultHeight,
                                     int32_t defaultBitDepth,
+                                    uint32_t readAheadPackets,
                                     VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer)
 {
+    // MP4 files are served by the native demuxer, FFmpeg remains the
+    // fallback for the codecs and the containers it doesn't handle.
+    if (Mp4DemuxerIsIsoBmffFile(pFilePath) &&
+            (Mp4DemuxerCreate(pFilePath,
+                              codecType,
+                              defaultWidth,
+                              defaultHeight,
+                              defaultBitDepth,
+                              videoStreamDemuxer) == VK_SUCCESS)) {
+        return VK_SUCCESS;
+    }
+
     if (requiresStreamDemuxing || (codecType == VK_VIDEO_CODEC_OPERATION_NONE_KHR)) {
         return FFmpegDemuxerCreate(pFilePath,
                                    codecType,
@@ -46,6 +51,7 @@ VkResult VideoStreamDemuxer::Create(const char *pFilePath,
                                    defaultWidth,
                                    defaultHeight,
                                    defaultBitDepth,
+                                   readAheadPackets,
                                    videoStreamDemuxer);
     }  else {
         return ElementaryStreamCreate(pFilePath,
@@ -32,8 +32,20 @@ public:
                            int32_t defaultWidth = 1920,
                            int32_t defaultHeight = 1080,
                            int32_t defaultBitDepth = 12,
+                           uint32_t readAheadPackets = 0,
                            VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer = invalidDemuxer);
 
+    // Statistics of the demuxers reading packets ahead of the parser on a
+    // separate thread.
+    struct ReadAheadStats {
+        uint64_t numPackets;        // packets returned by DemuxFrame()
+        uint64_t queueDepthSum;     // sum of the ready packets found by DemuxFrame()
+        uint32_t maxQueueDepth;
+        uint64_t parserStalls;      // DemuxFrame() calls waiting for a packet
+        uint64_t parserStallTimeUs;
+        uint64_t demuxerStalls;     // reads waiting for a free packet of the pool
+    };
+
     virtual int32_t AddRef()
     {
         return ++m_refCount;
@@ -64,6 +76,11 @@ public:
     virtual int64_t DemuxFrame(const uint8_t **ppVideo) = 0;
     virtual int64_t ReadBitstreamData(const uint8_t **ppVideo, int64_t offset) = 0;
     virtual void Rewind() = 0;
+    // Positions the demuxer on the last sync sample at or before frameIndex
+    // and returns its index, or -1 when the stream doesn't support seeking.
+    virtual int64_t SeekToFrame(int64_t /*frameIndex*/) { return -1; }
+    // Returns false when the demuxer doesn't read ahead.
+    virtual bool GetReadAheadStats(ReadAheadStats& /*stats*/) const { return false; }
 
     virtual void DumpStreamParameters() const = 0;
 
@@ -78,9 +95,27 @@ protected:
     std::atomic<int32_t>    m_refCount;
 };
 
+VkResult FFmpegDemuxerCreate(const char *pFilePath,
+                             VkVideoCodecOperationFlagBitsKHR codecType,
+                             bool requiresStreamDemuxing,
+                             int32_t defaultWidth,
+                             int32_t defaultHeight,
+                             int32_t defaultBitDepth,
+                             uint32_t readAheadPackets,
+                             VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
+
 VkResult ElementaryStreamCreate(const char *pFilePath,
                                 VkVideoCodecOperationFlagBitsKHR codecType,
                                 int32_t defaultWidth,
                                 int32_t defaultHeight,
                                 int32_t defaultBitDepth,
                                 VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
+
+VkResult Mp4DemuxerCreate(const char *pFilePath,
+                          VkVideoCodecOperationFlagBitsKHR codecType,
+                          int32_t defaultWidth,
+                          int32_t defaultHeight,
+                          int32_t defaultBitDepth,
+                          VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
+
+bool Mp4DemuxerIsIsoBmffFile(const char *pFilePath);
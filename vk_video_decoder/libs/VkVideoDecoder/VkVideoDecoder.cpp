@@ -19,6 +19,7 @@
 #include <iostream>
 
 #include "VkVideoCore/VulkanVideoCapabilities.h"
+#include "VkCodecUtils/VkVideoTracer.h"
 #include "VkVideoDecoder/VkVideoDecoder.h"
 #include "nvidia_utils/vulkan/ycbcrvkinfo.h"
 
@@ -690,6 +691,7 @@ int VkVideoDecoder::DecodePictureWithParameters(VkParserPerFrameDecodeParameters
     assert((uint32_t)currPicIdx < m_videoFrameBuffer->GetCurrentNumberQueueSlots());
 
     int32_t picNumInDecodeOrder = (int32_t)(uint32_t)m_decodePicCount;
+    VK_VIDEO_TRACE_SCOPE("decode", "DecodePictureWithParameters", picNumInDecodeOrder);
     if (m_dumpDecodeData) {
         std::cout << "currPicIdx: " << currPicIdx << ", currentVideoQueueIndx: " << m_currentVideoQueueIndx << ", decodePicCount: " << m_decodePicCount << std::endl;
     }
@@ -1228,8 +1230,15 @@ int VkVideoDecoder::DecodePictureWithParameters(VkParserPerFrameDecodeParameters
     }
 
     assert(VK_NOT_READY == m_vkDevCtx->GetFenceStatus(*m_vkDevCtx, videoDecodeCompleteFence));
-    VkResult result = m_vkDevCtx->MultiThreadedQueueSubmit(VulkanDeviceContext::DECODE, m_currentVideoQueueIndx,
-                                                           1, &submitInfo, videoDecodeCompleteFence);
+    VkResult result;
+    if (m_queueSchedulerStreamId != VkVideoQueueLoadBalancer::INVALID_STREAM_ID) {
+        // The scheduler picks the least loaded queue and returns it in m_currentVideoQueueIndx.
+        result = m_queueScheduler->QueueSubmit(m_queueSchedulerStreamId, &submitInfo, videoDecodeCompleteFence,
+                                               m_currentVideoQueueIndx);
+    } else {
+        result = m_vkDevCtx->MultiThreadedQueueSubmit(VulkanDeviceContext::DECODE, m_currentVideoQueueIndx,
+                                                      1, &submitInfo, videoDecodeCompleteFence);
+    }
     assert(result == VK_SUCCESS);
     if (result != VK_SUCCESS) {
         return -1;
@@ -1306,7 +1315,8 @@ int VkVideoDecoder::DecodePictureWithParameters(VkParserPerFrameDecodeParameters
         }
     }
 
-    if (m_hwLoadBalancingTimelineSemaphore != VK_NULL_HANDLE) {
+    if ((m_hwLoadBalancingTimelineSemaphore != VK_NULL_HANDLE) &&
+            (m_queueSchedulerStreamId == VkVideoQueueLoadBalancer::INVALID_STREAM_ID)) {
         m_currentVideoQueueIndx++;
         m_currentVideoQueueIndx %= m_vkDevCtx->GetVideoDecodeNumQueues();
     }
@@ -1490,6 +1500,12 @@ void VkVideoDecoder::Deinitialize()
         m_vkDevCtx->MultiThreadedQueueWaitIdle(VulkanDeviceContext::DECODE, m_currentVideoQueueIndx);
     }
 
+    if (m_queueSchedulerStreamId != VkVideoQueueLoadBalancer::INVALID_STREAM_ID) {
+        m_queueScheduler->UnregisterStream(m_queueSchedulerStreamId);
+        m_queueSchedulerStreamId = VkVideoQueueLoadBalancer::INVALID_STREAM_ID;
+        m_queueScheduler = nullptr;
+    }
+
     if (m_hwLoadBalancingTimelineSemaphore != VK_NULL_HANDLE) {
         m_vkDevCtx->DestroySemaphore(*m_vkDevCtx, m_hwLoadBalancingTimelineSemaphore, NULL);
         m_hwLoadBalancingTimelineSemaphore = VK_NULL_HANDLE;
@@ -29,6 +29,7 @@
 #include "vulkan_interfaces.h"
 #include "VkCodecUtils/VulkanVideoReferenceCountedPool.h"
 #include "VkCodecUtils/VulkanDeviceContext.h"
+#include "VkCodecUtils/VulkanVideoQueueScheduler.h"
 #include "VkCodecUtils/Helpers.h"
 #include "VkCodecUtils/VulkanFilterYuvCompute.h"
 #include "VkCodecUtils/VulkanBistreamBufferImpl.h"
@@ -219,6 +220,8 @@ private:
         , m_decodeFramesData(vkDevCtx)
         , m_decodePicCount(0)
         , m_hwLoadBalancingTimelineSemaphore()
+        , m_queueScheduler()
+        , m_queueSchedulerStreamId(VkVideoQueueLoadBalancer::INVALID_STREAM_ID)
         , m_dpbAndOutputCoincide(VK_TRUE)
         , m_videoMaintenance1FeaturesSupported(VK_FALSE)
         , m_enableDecodeComputeFilter((enableDecoderFeatures & ENABLE_POST_PROCESS_FILTER) != 0)
@@ -274,6 +277,13 @@ private:
             VkResult result = m_vkDevCtx->CreateSemaphore(*m_vkDevCtx, &createInfo, NULL, &m_hwLoadBalancingTimelineSemaphore);
             if (result == VK_SUCCESS) {
                 m_currentVideoQueueIndx = 0; // start with index zero
+
+                // Share the queues with the other streams of the device by their load,
+                // instead of rotating through them independently.
+                m_queueScheduler = m_vkDevCtx->GetVideoQueueScheduler(VulkanDeviceContext::DECODE);
+                if (m_queueScheduler != nullptr) {
+                    m_queueSchedulerStreamId = m_queueScheduler->RegisterStream();
+                }
             }
             std::cout << "\t Enabling HW Load Balancing for device with "
                       << m_vkDevCtx->GetVideoDecodeNumQueues() << " queues" << std::endl;
@@ -320,6 +330,8 @@ private:
     uint64_t                                         m_decodePicCount; // Also used for the HW load balancing timeline semaphore
     VkSharedBaseObj<VkParserVideoPictureParameters>  m_currentPictureParameters;
     VkSemaphore m_hwLoadBalancingTimelineSemaphore;
+    VulkanVideoQueueScheduler* m_queueScheduler; // the device's decode queue scheduler, with HW load balancing
+    int32_t     m_queueSchedulerStreamId;
     uint32_t m_dpbAndOutputCoincide : 1;
     uint32_t m_videoMaintenance1FeaturesSupported : 1;
     uint32_t m_enableDecodeComputeFilter : 1;
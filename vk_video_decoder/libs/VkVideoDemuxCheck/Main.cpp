@@ -0,0 +1,120 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "VkVideoDemuxCheck.h"
+
+static void PrintHelp(const char* programName)
+{
+    fprintf(stderr,
+            "Usage: %s -i <file> [options]\n"
+            "Checks that the FFmpeg demuxer returns the same packets with and without the read-ahead\n"
+            "of --demuxReadAhead, to the end of the stream and after rewinds, or checks the stream\n"
+            "parameters and seeks of a demuxer, without a Vulkan device.\n"
+            "The exit code is non-zero if a run fails.\n"
+            "  -i, --input <file>           MP4, MKV or any container FFmpeg reads\n"
+            "      --packets <file>         Expected packet list of the serial demuxer (size and CRC-32)\n"
+            "      --expect <file>          Instead of the read-ahead, check the codec, profile, size, sample\n"
+            "                               count and seeks of the demuxer the decoder picks for the input\n"
+            "                               (the native one for MP4) against the expected ones of the file\n"
+            "      --writePackets <file>    Write the packet list of the serial demuxer, then exit\n"
+            "      --readAhead <n>          Packets of the read-ahead pool, also run with 1 (default 4)\n"
+            "      --parserDelay <us>       Delay per packet of the slow parser runs (default 500)\n"
+            "      --maxErrors <n>          Errors printed per run (default 8)\n"
+            "  -v, --verbose                Also print the read-ahead statistics of each run\n"
+            "  -h, --help                   Print this help\n",
+            programName);
+}
+
+int main(int argc, const char** argv)
+{
+    VkVideoDemuxCheck::Config config;
+    std::string inputFileName;
+    std::string packetsFileName;
+    std::string writePacketsFileName;
+    std::string expectFileName;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1) < argc;
+        if ((arg == "-h") || (arg == "--help")) {
+            PrintHelp(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (((arg == "-i") || (arg == "--input")) && hasValue) {
+            inputFileName = argv[++i];
+        } else if ((arg == "--packets") && hasValue) {
+            packetsFileName = argv[++i];
+        } else if ((arg == "--expect") && hasValue) {
+            expectFileName = argv[++i];
+        } else if ((arg == "--writePackets") && hasValue) {
+            writePacketsFileName = argv[++i];
+        } else if ((arg == "--readAhead") && hasValue) {
+            config.readAheadPackets = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--parserDelay") && hasValue) {
+            config.parserDelayUs = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--maxErrors") && hasValue) {
+            config.maxReportedErrors = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "-v") || (arg == "--verbose")) {
+            config.verbose = true;
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument %s\n", arg.c_str());
+            PrintHelp(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (inputFileName.empty()) {
+        fprintf(stderr, "No input file\n");
+        PrintHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!writePacketsFileName.empty()) {
+        std::vector<VkVideoDemuxCheck::PacketInfo> packets;
+        return (VkVideoDemuxCheck::GetPacketList(inputFileName.c_str(), packets) &&
+                VkVideoDemuxCheck::WritePacketList(writePacketsFileName.c_str(), packets)) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::vector<VkVideoDemuxCheck::PacketInfo> expectedPackets;
+    if (!packetsFileName.empty() && !VkVideoDemuxCheck::ReadPacketList(packetsFileName.c_str(), expectedPackets)) {
+        return EXIT_FAILURE;
+    }
+    VkVideoDemuxCheck::StreamInfo expectedStream;
+    if (!expectFileName.empty() && !VkVideoDemuxCheck::ReadStreamInfo(expectFileName.c_str(), expectedStream)) {
+        return EXIT_FAILURE;
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    VkVideoDemuxCheck check(config);
+    uint32_t numFailed = 0;
+    if (!expectFileName.empty()) {
+        numFailed = check.CheckDemuxer(inputFileName.c_str(), expectedStream, stdout);
+    } else {
+        numFailed = check.CheckReadAhead(inputFileName.c_str(),
+                                         packetsFileName.empty() ? nullptr : &expectedPackets, stdout);
+    }
+    const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%s: %u of %u run(s) failed, %.2f s\n", inputFileName.c_str(), numFailed, check.GetNumRuns(), elapsedSec);
+
+    return (numFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
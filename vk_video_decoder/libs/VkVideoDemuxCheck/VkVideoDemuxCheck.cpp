@@ -0,0 +1,468 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "VkVideoDemuxCheck.h"
+#include "crcgenerator.h"
+
+VkVideoDemuxCheck::VkVideoDemuxCheck(const Config& config)
+: m_config(config)
+, m_numRuns(0)
+, m_numErrors(0)
+, m_runName()
+{
+}
+
+VkResult VkVideoDemuxCheck::CreateFFmpegDemuxer(const char* pFilePath, uint32_t readAheadPackets,
+                                                VkSharedBaseObj<VideoStreamDemuxer>& demuxer)
+{
+    // FFmpeg directly, VideoStreamDemuxer::Create() takes the MP4 files to
+    // the native demuxer, which doesn't read ahead.
+    return FFmpegDemuxerCreate(pFilePath, VK_VIDEO_CODEC_OPERATION_NONE_KHR, true, 1920, 1080, 12,
+                               readAheadPackets, demuxer);
+}
+
+uint32_t VkVideoDemuxCheck::Crc32(const uint8_t* pData, size_t size)
+{
+    uint32_t crc = 0xffffffff;
+    getCRC(&crc, pData, size, Crc32Table);
+    return crc ^ 0xffffffff;
+}
+
+uint32_t VkVideoDemuxCheck::CheckReadAhead(const char* pFilePath, const std::vector<PacketInfo>* pExpectedPackets,
+                                           FILE* fp)
+{
+    uint32_t numFailed = 0;
+    std::vector<Packet> reference;
+
+    // The serial demuxer: its packets are the reference of the read-ahead runs
+    BeginRun("serial");
+    {
+        VkSharedBaseObj<VideoStreamDemuxer> demuxer;
+        if (CreateFFmpegDemuxer(pFilePath, 0, demuxer) != VK_SUCCESS) {
+            ReportError("the FFmpeg demuxer could not open %s", pFilePath);
+            EndRun("", fp);
+            return 1;
+        }
+
+        VideoStreamDemuxer::ReadAheadStats stats;
+        if (demuxer->GetReadAheadStats(stats)) {
+            ReportError("the demuxer reads ahead without --demuxReadAhead");
+        }
+
+        ReadPackets(demuxer, 0, 0, reference);
+        if (reference.empty()) {
+            ReportError("no packet");
+        }
+        if (pExpectedPackets != nullptr) {
+            if (pExpectedPackets->size() != reference.size()) {
+                ReportError("%zu packet(s), %zu expected", reference.size(), pExpectedPackets->size());
+            }
+            for (size_t i = 0; i < std::min(pExpectedPackets->size(), reference.size()); i++) {
+                const PacketInfo& expected = (*pExpectedPackets)[i];
+                if ((expected.size != reference[i].data.size()) || (expected.crc != reference[i].crc)) {
+                    ReportError("packet %zu: %zu bytes with CRC %08x, %u bytes with CRC %08x expected", i,
+                                reference[i].data.size(), reference[i].crc, expected.size, expected.crc);
+                }
+            }
+        }
+
+        // The rewinds of the serial demuxer
+        demuxer->Rewind();
+        std::vector<Packet> packets;
+        ReadPackets(demuxer, 0, 0, packets);
+        ComparePackets("rewind at the end", reference, packets);
+        packets.clear();
+        demuxer->Rewind();
+        ReadPackets(demuxer, (uint32_t)(reference.size() / 2), 0, packets);
+        packets.clear();
+        demuxer->Rewind();
+        ReadPackets(demuxer, 0, 0, packets);
+        ComparePackets("rewind in the middle", reference, packets);
+    }
+    char details[128];
+    snprintf(details, sizeof(details), "%zu packet(s)", reference.size());
+    numFailed += EndRun(details, fp) ? 0 : 1;
+    if (reference.empty()) {
+        return numFailed;
+    }
+
+    // The read-ahead runs, with a pool of one packet and the configured one,
+    // with a fast and a slow parser
+    const uint32_t poolSizes[2] = { 1, m_config.readAheadPackets };
+    for (uint32_t p = 0; p < 2; p++) {
+        if ((p > 0) && (poolSizes[p] <= poolSizes[0])) {
+            break;
+        }
+        for (uint32_t slow = 0; slow < 2; slow++) {
+            const uint32_t delayUs = slow ? m_config.parserDelayUs : 0;
+            char name[64];
+            snprintf(name, sizeof(name), "read-ahead %u, parser delay %u us", poolSizes[p], delayUs);
+            BeginRun(name);
+
+            VkSharedBaseObj<VideoStreamDemuxer> demuxer;
+            if (CreateFFmpegDemuxer(pFilePath, poolSizes[p], demuxer) != VK_SUCCESS) {
+                ReportError("the FFmpeg demuxer could not open %s", pFilePath);
+                numFailed += EndRun("", fp) ? 0 : 1;
+                continue;
+            }
+
+            const uint64_t numPackets = RunPasses(demuxer, delayUs, reference);
+
+            VideoStreamDemuxer::ReadAheadStats stats;
+            memset(&stats, 0, sizeof(stats));
+            details[0] = '\0';
+            if (!demuxer->GetReadAheadStats(stats)) {
+                ReportError("no read-ahead statistics");
+            } else {
+                // The statistics are kept over the rewinds.
+                if (stats.numPackets != numPackets) {
+                    ReportError("%llu packet(s) in the statistics, %llu returned",
+                                (unsigned long long)stats.numPackets, (unsigned long long)numPackets);
+                }
+                if (stats.maxQueueDepth > poolSizes[p]) {
+                    ReportError("queue depth %u with a pool of %u", stats.maxQueueDepth, poolSizes[p]);
+                }
+                if (m_config.verbose) {
+                    snprintf(details, sizeof(details),
+                             "average queue depth %.2f, max %u, %llu parser stall(s), %llu demuxer stall(s)",
+                             (stats.numPackets > 0) ? ((double)stats.queueDepthSum / stats.numPackets) : 0.0,
+                             stats.maxQueueDepth, (unsigned long long)stats.parserStalls,
+                             (unsigned long long)stats.demuxerStalls);
+                }
+            }
+            numFailed += EndRun(details, fp) ? 0 : 1;
+        }
+    }
+
+    return numFailed;
+}
+
+uint64_t VkVideoDemuxCheck::RunPasses(VkSharedBaseObj<VideoStreamDemuxer>& demuxer, uint32_t delayUs,
+                                      const std::vector<Packet>& reference)
+{
+    uint64_t numPackets = 0;
+    std::vector<Packet> packets;
+
+    ReadPackets(demuxer, 0, delayUs, packets);
+    ComparePackets("first pass", reference, packets);
+    numPackets += packets.size();
+
+    // At the end of the stream, the demux thread is done.
+    packets.clear();
+    demuxer->Rewind();
+    ReadPackets(demuxer, 0, delayUs, packets);
+    ComparePackets("rewind at the end", reference, packets);
+    numPackets += packets.size();
+
+    // In the middle, the demux thread still has packets queued or is waiting
+    // for a free one.
+    packets.clear();
+    demuxer->Rewind();
+    ReadPackets(demuxer, (uint32_t)(reference.size() / 2), delayUs, packets);
+    numPackets += packets.size();
+    packets.clear();
+    demuxer->Rewind();
+    ReadPackets(demuxer, 0, delayUs, packets);
+    ComparePackets("rewind in the middle", reference, packets);
+    numPackets += packets.size();
+
+    return numPackets;
+}
+
+void VkVideoDemuxCheck::ReadPackets(VkSharedBaseObj<VideoStreamDemuxer>& demuxer, uint32_t maxPackets,
+                                    uint32_t delayUs, std::vector<Packet>& packets)
+{
+    while ((maxPackets == 0) || (packets.size() < maxPackets)) {
+        const uint8_t* pData = nullptr;
+        const int64_t size = demuxer->DemuxFrame(&pData);
+        if (size <= 0) {
+            // The end of the stream stays the end.
+            for (uint32_t i = 0; i < 2; i++) {
+                const int64_t nextSize = demuxer->DemuxFrame(&pData);
+                if (nextSize > 0) {
+                    ReportError("a packet of %lld bytes after the end of the stream", (long long)nextSize);
+                }
+            }
+            return;
+        }
+
+        Packet packet;
+        packet.data.assign(pData, pData + size);
+        packet.crc = Crc32(pData, (size_t)size);
+        packets.push_back(packet);
+
+        if (delayUs > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(delayUs));
+        }
+    }
+}
+
+void VkVideoDemuxCheck::ComparePackets(const char* pass, const std::vector<Packet>& expected,
+                                       const std::vector<Packet>& packets)
+{
+    if (packets.size() != expected.size()) {
+        ReportError("%s: %zu packet(s), %zu expected", pass, packets.size(), expected.size());
+    }
+    for (size_t i = 0; i < std::min(packets.size(), expected.size()); i++) {
+        if (packets[i].data != expected[i].data) {
+            ReportError("%s: packet %zu: %zu bytes with CRC %08x, %zu bytes with CRC %08x expected", pass, i,
+                        packets[i].data.size(), packets[i].crc, expected[i].data.size(), expected[i].crc);
+        }
+    }
+}
+
+static const char* CodecName(VkVideoCodecOperationFlagBitsKHR codec)
+{
+    switch ((uint32_t)codec) {
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR: return "h264";
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR: return "h265";
+    case VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR:  return "av1";
+    default:                                           return "none";
+    }
+}
+
+uint32_t VkVideoDemuxCheck::CheckDemuxer(const char* pFilePath, const StreamInfo& expected, FILE* fp)
+{
+    uint32_t numFailed = 0;
+    std::vector<Packet> reference;
+
+    VkSharedBaseObj<VideoStreamDemuxer> demuxer;
+    BeginRun("stream parameters");
+    if (VideoStreamDemuxer::Create(pFilePath, VK_VIDEO_CODEC_OPERATION_NONE_KHR, true, 1920, 1080, 12, 0,
+                                   demuxer) != VK_SUCCESS) {
+        ReportError("no demuxer could open %s", pFilePath);
+        EndRun("", fp);
+        return 1;
+    }
+
+    if (demuxer->GetVideoCodec() != expected.codec) {
+        ReportError("codec %s, %s expected", CodecName(demuxer->GetVideoCodec()), CodecName(expected.codec));
+    }
+    if (demuxer->GetProfileIdc() != expected.profileIdc) {
+        ReportError("profile %u, %u expected", demuxer->GetProfileIdc(), expected.profileIdc);
+    }
+    if ((demuxer->GetWidth() != expected.width) || (demuxer->GetHeight() != expected.height)) {
+        ReportError("%dx%d, %dx%d expected", demuxer->GetWidth(), demuxer->GetHeight(), expected.width, expected.height);
+    }
+    if (demuxer->GetBitDepth() != expected.bitDepth) {
+        ReportError("bit depth %d, %d expected", demuxer->GetBitDepth(), expected.bitDepth);
+    }
+    ReadPackets(demuxer, 0, 0, reference);
+    if (reference.size() != expected.numSamples) {
+        ReportError("%zu sample(s), %u expected", reference.size(), expected.numSamples);
+    }
+    char details[128];
+    snprintf(details, sizeof(details), "%s profile %u, %dx%d, %zu sample(s)", CodecName(demuxer->GetVideoCodec()),
+             demuxer->GetProfileIdc(), demuxer->GetWidth(), demuxer->GetHeight(), reference.size());
+    numFailed += EndRun(details, fp) ? 0 : 1;
+
+    // Each seek reads to the end of the stream, the next one seeks from there.
+    for (size_t i = 0; i < expected.seekFrames.size(); i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "seek to frame %lld", (long long)expected.seekFrames[i]);
+        BeginRun(name);
+
+        const int64_t syncSample = demuxer->SeekToFrame(expected.seekFrames[i]);
+        if (syncSample != expected.seekResults[i]) {
+            ReportError("sync sample %lld, %lld expected", (long long)syncSample, (long long)expected.seekResults[i]);
+        }
+
+        if ((syncSample >= 0) && ((size_t)syncSample < reference.size())) {
+            std::vector<Packet> packets;
+            ReadPackets(demuxer, 0, 0, packets);
+            const size_t numPackets = reference.size() - (size_t)syncSample;
+            if (packets.size() != numPackets) {
+                ReportError("%zu packet(s) after the seek, %zu expected", packets.size(), numPackets);
+            }
+            for (size_t j = 0; j < std::min(packets.size(), numPackets); j++) {
+                const Packet& expectedPacket = reference[(size_t)syncSample + j];
+                // The parameter sets go in front of the first sample.
+                const bool match = (j > 0) ? (packets[j].data == expectedPacket.data) :
+                                   ((packets[j].data.size() >= expectedPacket.data.size()) &&
+                                    std::equal(expectedPacket.data.begin(), expectedPacket.data.end(),
+                                               packets[j].data.end() - expectedPacket.data.size()));
+                if (!match) {
+                    ReportError("sample %lld: %zu bytes with CRC %08x, not the sample of the first pass",
+                                (long long)(syncSample + j), packets[j].data.size(), packets[j].crc);
+                }
+            }
+        }
+        numFailed += EndRun("", fp) ? 0 : 1;
+    }
+
+    return numFailed;
+}
+
+bool VkVideoDemuxCheck::GetPacketList(const char* pFilePath, std::vector<PacketInfo>& packets)
+{
+    VkSharedBaseObj<VideoStreamDemuxer> demuxer;
+    if (CreateFFmpegDemuxer(pFilePath, 0, demuxer) != VK_SUCCESS) {
+        fprintf(stderr, "The FFmpeg demuxer could not open %s\n", pFilePath);
+        return false;
+    }
+
+    packets.clear();
+    const uint8_t* pData = nullptr;
+    int64_t size = 0;
+    while ((size = demuxer->DemuxFrame(&pData)) > 0) {
+        PacketInfo packet;
+        packet.size = (uint32_t)size;
+        packet.crc = Crc32(pData, (size_t)size);
+        packets.push_back(packet);
+    }
+    return true;
+}
+
+bool VkVideoDemuxCheck::ReadPacketList(const char* pFileName, std::vector<PacketInfo>& packets)
+{
+    FILE* file = fopen(pFileName, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "Failed to open the packet list %s\n", pFileName);
+        return false;
+    }
+
+    packets.clear();
+    char line[256];
+    uint32_t lineNumber = 0;
+    bool success = true;
+    while (success && (fgets(line, sizeof(line), file) != nullptr)) {
+        lineNumber++;
+        if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\r')) {
+            continue;
+        }
+        PacketInfo packet;
+        if (sscanf(line, "%u %x", &packet.size, &packet.crc) != 2) {
+            fprintf(stderr, "%s:%u: invalid packet line\n", pFileName, lineNumber);
+            success = false;
+        }
+        packets.push_back(packet);
+    }
+    fclose(file);
+    return success;
+}
+
+bool VkVideoDemuxCheck::ReadStreamInfo(const char* pFileName, StreamInfo& info)
+{
+    FILE* file = fopen(pFileName, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "Failed to open the stream parameters %s\n", pFileName);
+        return false;
+    }
+
+    info = StreamInfo();
+    char line[256];
+    uint32_t lineNumber = 0;
+    bool success = true;
+    while (success && (fgets(line, sizeof(line), file) != nullptr)) {
+        lineNumber++;
+        if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\r')) {
+            continue;
+        }
+        char key[32];
+        char value[32];
+        long long seekResult = 0;
+        const int numFields = sscanf(line, "%31s %31s %lld", key, value, &seekResult);
+        if (numFields < 2) {
+            success = false;
+        } else if (strcmp(key, "codec") == 0) {
+            if (strcmp(value, "h264") == 0) {
+                info.codec = VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR;
+            } else if (strcmp(value, "h265") == 0) {
+                info.codec = VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR;
+            } else if (strcmp(value, "av1") == 0) {
+                info.codec = VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+            } else {
+                success = false;
+            }
+        } else if (strcmp(key, "profile") == 0) {
+            info.profileIdc = (uint32_t)atoi(value);
+        } else if (strcmp(key, "width") == 0) {
+            info.width = atoi(value);
+        } else if (strcmp(key, "height") == 0) {
+            info.height = atoi(value);
+        } else if (strcmp(key, "bitDepth") == 0) {
+            info.bitDepth = atoi(value);
+        } else if (strcmp(key, "samples") == 0) {
+            info.numSamples = (uint32_t)atoi(value);
+        } else if ((strcmp(key, "seek") == 0) && (numFields == 3)) {
+            info.seekFrames.push_back(atoll(value));
+            info.seekResults.push_back(seekResult);
+        } else {
+            success = false;
+        }
+        if (!success) {
+            fprintf(stderr, "%s:%u: invalid stream parameter line\n", pFileName, lineNumber);
+        }
+    }
+    fclose(file);
+    return success;
+}
+
+bool VkVideoDemuxCheck::WritePacketList(const char* pFileName, const std::vector<PacketInfo>& packets)
+{
+    FILE* file = fopen(pFileName, "w");
+    if (file == nullptr) {
+        fprintf(stderr, "Failed to open the packet list %s\n", pFileName);
+        return false;
+    }
+
+    fprintf(file, "# size crc32 of each packet of the video track, with the Annex B start codes\n");
+    for (size_t i = 0; i < packets.size(); i++) {
+        fprintf(file, "%u %08x\n", packets[i].size, packets[i].crc);
+    }
+    const bool success = (ferror(file) == 0);
+    fclose(file);
+    return success;
+}
+
+void VkVideoDemuxCheck::BeginRun(const char* name)
+{
+    snprintf(m_runName, sizeof(m_runName), "%s", name);
+    m_numErrors = 0;
+    m_numRuns++;
+}
+
+bool VkVideoDemuxCheck::EndRun(const char* details, FILE* fp)
+{
+    fprintf(fp, "%-40s %s%s%s\n", m_runName, (m_numErrors == 0) ? "ok" : "FAILED",
+            (details[0] != '\0') ? ", " : "", details);
+    if (m_numErrors > m_config.maxReportedErrors) {
+        fprintf(stderr, "%s: %u more error(s)\n", m_runName, m_numErrors - m_config.maxReportedErrors);
+    }
+    return (m_numErrors == 0);
+}
+
+void VkVideoDemuxCheck::ReportError(const char* format, ...)
+{
+    m_numErrors++;
+    if (m_numErrors > m_config.maxReportedErrors) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%s: ", m_runName);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
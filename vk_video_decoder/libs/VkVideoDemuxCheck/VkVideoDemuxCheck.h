@@ -0,0 +1,157 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEODEMUXCHECK_VKVIDEODEMUXCHECK_H_
+#define _VKVIDEODEMUXCHECK_VKVIDEODEMUXCHECK_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "VkDecoderUtils/VideoStreamDemuxer.h"
+
+// Checks the packets the demuxers return for a container file, without a
+// Vulkan device or a decoder.
+//
+// The FFmpeg demuxer reading ahead on its demux thread (--demuxReadAhead of
+// the decoder) has to return the packets of the serial FFmpeg demuxer, in the
+// same order and with the same sizes and contents: to the end of the stream,
+// where DemuxFrame() has to keep reporting the end, after a Rewind() at the
+// end of the stream, and after a Rewind() in the middle of the stream, with
+// packets still queued. The read-ahead runs with a pool of one packet, where
+// the demux thread waits for each DemuxFrame() call, and with the configured
+// pool, each with a fast parser and with a slow one that lets the queue fill
+// up. The serial demuxer runs the same rewinds.
+//
+// With an expected packet list, the packets of the serial demuxer are also
+// compared with it.
+//
+// The demuxer VideoStreamDemuxer::Create() picks for a file, the native one
+// for the MP4 files, is checked against the expected stream parameters:
+// codec, profile, size and bit depth, the number of samples, and the sync
+// sample each SeekToFrame() lands on. The packets after a seek have to be
+// the ones of the first pass from that sample on, the first one with the
+// parameter sets in front.
+class VkVideoDemuxCheck {
+
+public:
+
+    struct Config {
+        uint32_t readAheadPackets;      // pool of the read-ahead runs, also run with a pool of 1
+        uint32_t parserDelayUs;         // per packet, of the slow parser runs
+        uint32_t maxReportedErrors;     // per run, the following ones are only counted
+        bool     verbose;               // also print the read-ahead statistics of each run
+
+        Config()
+        : readAheadPackets(4)
+        , parserDelayUs(500)
+        , maxReportedErrors(8)
+        , verbose(false)
+        { }
+    };
+
+    // The size and the CRC-32 of a packet, the way the expected packet lists
+    // store them.
+    struct PacketInfo {
+        uint32_t size;
+        uint32_t crc;
+    };
+
+    // The expected parameters of a stream and of its seeks.
+    struct StreamInfo {
+        VkVideoCodecOperationFlagBitsKHR codec;
+        uint32_t profileIdc;
+        int32_t  width;
+        int32_t  height;
+        int32_t  bitDepth;
+        uint32_t numSamples;
+        std::vector<int64_t> seekFrames;    // the frames requested from SeekToFrame()
+        std::vector<int64_t> seekResults;   // and the sync samples it has to return
+
+        StreamInfo()
+        : codec(VK_VIDEO_CODEC_OPERATION_NONE_KHR)
+        , profileIdc(0)
+        , width(0)
+        , height(0)
+        , bitDepth(8)
+        , numSamples(0)
+        , seekFrames()
+        , seekResults()
+        { }
+    };
+
+    explicit VkVideoDemuxCheck(const Config& config);
+
+    // Runs the read-ahead checks of the file with one line per run, and
+    // compares the serial packets with pExpectedPackets, if not nullptr.
+    // Returns the number of runs that failed.
+    uint32_t CheckReadAhead(const char* pFilePath, const std::vector<PacketInfo>* pExpectedPackets, FILE* fp = stdout);
+
+    // Checks the demuxer VideoStreamDemuxer::Create() picks for the file
+    // against expected, with one line per run. Returns the number of runs
+    // that failed.
+    uint32_t CheckDemuxer(const char* pFilePath, const StreamInfo& expected, FILE* fp = stdout);
+
+    uint32_t GetNumRuns() const { return m_numRuns; }
+
+    // Reads the expected stream parameters: "codec h264|h265|av1",
+    // "profile <idc>", "width <w>", "height <h>", "bitDepth <n>",
+    // "samples <n>" and "seek <frame> <sync sample>" lines, and '#' comment
+    // lines.
+    static bool ReadStreamInfo(const char* pFileName, StreamInfo& info);
+
+    // Reads and writes the expected packet lists: one "<size> <crc32>" line
+    // per packet, in decimal and hexadecimal, and '#' comment lines.
+    static bool ReadPacketList(const char* pFileName, std::vector<PacketInfo>& packets);
+    static bool WritePacketList(const char* pFileName, const std::vector<PacketInfo>& packets);
+
+    // The packets of the serial FFmpeg demuxer, for WritePacketList().
+    static bool GetPacketList(const char* pFilePath, std::vector<PacketInfo>& packets);
+
+private:
+
+    struct Packet {
+        std::vector<uint8_t> data;
+        uint32_t             crc;
+    };
+
+    static VkResult CreateFFmpegDemuxer(const char* pFilePath, uint32_t readAheadPackets,
+                                        VkSharedBaseObj<VideoStreamDemuxer>& demuxer);
+    static uint32_t Crc32(const uint8_t* pData, size_t size);
+
+    // Reads maxPackets packets, or to the end of the stream if 0. At the end
+    // of the stream, checks that DemuxFrame() keeps returning the end.
+    void ReadPackets(VkSharedBaseObj<VideoStreamDemuxer>& demuxer, uint32_t maxPackets, uint32_t delayUs,
+                     std::vector<Packet>& packets);
+    void ComparePackets(const char* pass, const std::vector<Packet>& expected, const std::vector<Packet>& packets);
+
+    // Reads the whole stream, then again after a Rewind() at the end and
+    // after a Rewind() in the middle, and compares each pass with reference.
+    // Returns the number of packets read.
+    uint64_t RunPasses(VkSharedBaseObj<VideoStreamDemuxer>& demuxer, uint32_t delayUs,
+                       const std::vector<Packet>& reference);
+
+    void BeginRun(const char* name);
+    // Prints the result line of the run, returns false if it failed.
+    bool EndRun(const char* details, FILE* fp);
+    void ReportError(const char* format, ...);
+
+    Config      m_config;
+    uint32_t    m_numRuns;
+    uint32_t    m_numErrors;        // of the current run
+    char        m_runName[128];
+};
+
+#endif /* _VKVIDEODEMUXCHECK_VKVIDEODEMUXCHECK_H_ */
@@ -0,0 +1,43 @@
+#!/bin/bash
+# Copyright 2024 NVIDIA Corporation.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Runs the read-ahead check of vk-video-demux-check on every file of this
+# directory that has a <file>.packets list, and compares the packets of the
+# serial FFmpeg demuxer with the list. Every file with a <file>.expected
+# description is checked with the demuxer the decoder picks for it.
+#
+# Usage: check_demuxers.sh <vk-video-demux-check>
+
+check=${1:-vk-video-demux-check}
+testdata=$(dirname "$0")
+failed=0
+
+for expected in "$testdata"/*.packets; do
+    file=${expected%.packets}
+    if ! "$check" -i "$file" --packets "$expected" > /dev/null; then
+        echo "FAILED: $file"
+        failed=1
+    fi
+done
+
+for expected in "$testdata"/*.expected; do
+    file=${expected%.expected}
+    if ! "$check" -i "$file" --expect "$expected" > /dev/null; then
+        echo "FAILED: $file"
+        failed=1
+    fi
+done
+
+exit $failed
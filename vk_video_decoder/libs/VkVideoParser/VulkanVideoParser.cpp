@@ -32,6 +32,7 @@
 #include "NvVideoParser/nvVulkanVideoUtils.h"
 #include "vkvideo_parser/PictureBufferBase.h"
 #include "VkVideoCore/VkVideoCoreProfile.h"
+#include "VkCodecUtils/VkVideoTracer.h"
 #include "vkvideo_parser/StdVideoPictureParametersSet.h"
 
 #include "vkvideo_parser/VulkanVideoParser.h"
@@ -584,6 +585,11 @@ public:
                                     size_t* pParsedBytes,
                                     bool doPartialParsing = false);
 
+    virtual bool GetTelemetry(VkParserTelemetry* pTelemetry)
+    {
+        return m_vkParser && m_vkParser->GetTelemetry(pTelemetry);
+    }
+
     // Interface to allow decoder to communicate with the client implementing
     // INvVideoDecoderClient
 
@@ -635,7 +641,9 @@ protected:
         uint32_t bufferOffsetAlignment,
         uint32_t bufferSizeAlignment,
         bool outOfBandPictureParameters,
-        uint32_t errorThreshold);
+        uint32_t errorThreshold,
+        bool pipelinedParsing,
+        bool callbackTimings);
 
     VulkanVideoParser(VkVideoCodecOperationFlagBitsKHR codecType,
         uint32_t maxNumDecodeSurfaces, uint32_t maxNumDpbSurfaces,
@@ -916,7 +924,9 @@ VkResult VulkanVideoParser::Initialize(
     uint32_t bufferOffsetAlignment,
     uint32_t bufferSizeAlignment,
     bool outOfBandPictureParameters,
-    uint32_t errorThreshold)
+    uint32_t errorThreshold,
+    bool pipelinedParsing,
+    bool callbackTimings)
 {
     Deinitialize();
 
@@ -939,6 +949,8 @@ VkResult VulkanVideoParser::Initialize(
     nvdp.referenceClockRate = m_clockRate;
     nvdp.errorThreshold = errorThreshold;
     nvdp.outOfBandPictureParameters = outOfBandPictureParameters;
+    nvdp.pipelinedParsing = pipelinedParsing;
+    nvdp.callbackTimings = callbackTimings;
 
     static const VkExtensionProperties h264StdExtensionVersion = { VK_STD_VULKAN_VIDEO_CODEC_H264_DECODE_EXTENSION_NAME, VK_STD_VULKAN_VIDEO_CODEC_H264_DECODE_SPEC_VERSION };
     static const VkExtensionProperties h265StdExtensionVersion = { VK_STD_VULKAN_VIDEO_CODEC_H265_DECODE_EXTENSION_NAME, VK_STD_VULKAN_VIDEO_CODEC_H265_DECODE_SPEC_VERSION };
@@ -987,6 +999,7 @@ VkResult VulkanVideoParser::ParseVideoData(VkParserSourceDataPacket* pPacket,
     pkt.bPTSValid = !!(pPacket->flags & VK_PARSER_PKT_TIMESTAMP);
     pkt.llPTS = pPacket->timestamp;
     pkt.bPartialParsing = doPartialParsing;
+    VK_VIDEO_TRACE_SCOPE("decode", "ParseByteStream", -1);
     if (m_vkParser->ParseByteStream(&pkt, pParsedBytes)) {
         result = VK_SUCCESS;
     } else {
@@ -2342,6 +2355,8 @@ VkResult IVulkanVideoParser::Create(
     uint32_t bufferSizeAlignment,
     uint64_t clockRate,
     uint32_t errorThreshold,
+    bool pipelinedParsing,
+    bool callbackTimings,
     VkSharedBaseObj<IVulkanVideoParser>& vulkanVideoParser)
 {
     if (!decoderHandler || !videoFrameBufferCb) {
@@ -2362,7 +2377,9 @@ VkResult IVulkanVideoParser::Create(
                                                           bufferOffsetAlignment,
                                                           bufferSizeAlignment,
                                                           outOfBandPictureParameters,
-                                                          errorThreshold);
+                                                          errorThreshold,
+                                                          pipelinedParsing,
+                                                          callbackTimings);
 
         if (result != VK_SUCCESS) {
             return result;
@@ -2387,6 +2404,8 @@ VkResult vulkanCreateVideoParser(
             uint32_t bufferOffsetAlignment,
             uint32_t bufferSizeAlignment,
             uint64_t clockRate,
+            bool pipelinedParsing,
+            bool callbackTimings,
             VkSharedBaseObj<IVulkanVideoParser>& vulkanVideoParser)
 {
     if (videoCodecOperation == VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR) {
@@ -2418,5 +2437,7 @@ VkResult vulkanCreateVideoParser(
                                       bufferSizeAlignment,
                                       clockRate,
                                       0, // errorThreshold
+                                      pipelinedParsing,
+                                      callbackTimings,
                                       vulkanVideoParser);
 }
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "VkVideoQueueSimulator.h"
+
+static void PrintHelp(const char* programName)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "Drives the video queue load balancer with simulated queues and streams, without a Vulkan\n"
+            "device, and checks every queue choice. The exit code is non-zero if a check fails.\n"
+            "  -q, --queues <n>             Queues, 1 to 16 (default 2)\n"
+            "  -s, --streams <n>            Streams, 1 to 64 (default 4)\n"
+            "      --slack <n>              Affinity slack of the balancer, in cost units (default 1)\n"
+            "      --ticks <n>              Simulated time (default 1000000)\n"
+            "      --inFlight <n>           Outstanding submissions per stream (default 4)\n"
+            "      --intervals <t,...>      Ticks between the frames of each stream, 0: as soon as it can,\n"
+            "                               the last one repeats (default 0)\n"
+            "      --churn <n>              A stream restarts every n ticks, 0: never (default 0)\n"
+            "      --weights <w,...>        Weight and frame cost of each stream, the last one repeats (default 1)\n"
+            "      --queueTicks <t,...>     Ticks per cost unit of each queue, the last one repeats (default 10)\n"
+            "      --minFairness <n>        Fail below n percent of Jain's index of the weighted throughputs\n"
+            "      --sweep                  Run a set of queue, stream, weight and slack configurations\n"
+            "                               around the given one, with one line per configuration\n"
+            "      --maxErrors <n>          Errors printed per configuration (default 8)\n"
+            "  -v, --verbose                Print every queue choice\n"
+            "  -h, --help                   Print this help\n",
+            programName);
+}
+
+// Fills values from a comma separated list, repeating the last one.
+static bool ParseList(const char* arg, uint32_t* values, uint32_t maxValues, long minValue)
+{
+    uint32_t count = 0;
+    const char* p = arg;
+    while ((*p != '\0') && (count < maxValues)) {
+        char* end = nullptr;
+        const long value = std::strtol(p, &end, 10);
+        if ((end == p) || (value < minValue)) {
+            return false;
+        }
+        values[count++] = (uint32_t)value;
+        p = (*end == ',') ? (end + 1) : end;
+    }
+    if (count == 0) {
+        return false;
+    }
+    for (uint32_t i = count; i < maxValues; i++) {
+        values[i] = values[count - 1];
+    }
+    return true;
+}
+
+static bool RunConfig(const VkVideoQueueSimulator::Config& config, bool summaryOnly)
+{
+    VkVideoQueueSimulator simulator(config);
+
+    const bool success = simulator.Run();
+    if (summaryOnly) {
+        simulator.PrintSummary(stdout);
+    } else {
+        simulator.PrintReport(stdout);
+    }
+
+    return success;
+}
+
+// The saturated streams of equal weight on queues of the same speed must
+// share the queues evenly, the other configurations only get their choices
+// checked.
+static void AddSweepConfigs(const VkVideoQueueSimulator::Config& base, std::vector<VkVideoQueueSimulator::Config>& configs)
+{
+    static const uint32_t numQueues[] = { 1, 2, 3, 4 };
+    static const uint32_t numStreams[] = { 1, 3, 4, 8 };
+    static const uint32_t affinitySlacks[] = { 0, 1, 4 };
+    static const uint32_t mixedWeights[] = { 1, 2, 4, 1 };
+    static const uint32_t mixedQueueTicks[] = { 10, 20, 10, 15 };
+
+    for (uint32_t q = 0; q < sizeof(numQueues) / sizeof(numQueues[0]); q++) {
+        for (uint32_t s = 0; s < sizeof(numStreams) / sizeof(numStreams[0]); s++) {
+            for (uint32_t a = 0; a < sizeof(affinitySlacks) / sizeof(affinitySlacks[0]); a++) {
+                for (uint32_t variant = 0; variant < 4; variant++) {
+                    VkVideoQueueSimulator::Config config = base;
+                    config.numQueues = numQueues[q];
+                    config.numStreams = numStreams[s];
+                    config.affinitySlack = affinitySlacks[a];
+                    config.minFairness = 0;
+                    for (uint32_t i = 0; i < VkVideoQueueSimulator::MAX_STREAMS; i++) {
+                        config.weights[i] = (variant & 1) ? mixedWeights[i % 4] : 1;
+                    }
+                    for (uint32_t i = 0; i < VkVideoQueueSimulator::MAX_QUEUES; i++) {
+                        config.queueTicks[i] = (variant & 2) ? mixedQueueTicks[i % 4] : 10;
+                    }
+                    if ((variant == 0) && ((config.numStreams % config.numQueues) == 0)) {
+                        config.minFairness = 95;
+                    }
+                    configs.push_back(config);
+                }
+            }
+        }
+    }
+
+    // Paced streams that don't fill the queues, busy streams next to paced
+    // ones, which get more than their share of the work, and streams that
+    // restart with work still outstanding.
+    VkVideoQueueSimulator::Config config = base;
+    config.numQueues = 3;
+    config.numStreams = 8;
+    config.minFairness = 0;
+    for (uint32_t i = 0; i < VkVideoQueueSimulator::MAX_STREAMS; i++) {
+        config.weights[i] = mixedWeights[i % 4];
+        config.frameIntervals[i] = 100;
+    }
+    configs.push_back(config);
+    for (uint32_t i = 0; i < VkVideoQueueSimulator::MAX_STREAMS; i++) {
+        config.frameIntervals[i] = (i % 3) ? 60 : 0;
+    }
+    configs.push_back(config);
+    config.numQueues = 2;
+    config.numStreams = 3;
+    configs.push_back(config);
+    config.churnInterval = 997;
+    configs.push_back(config);
+    config.numQueues = 3;
+    config.numStreams = 8;
+    for (uint32_t i = 0; i < VkVideoQueueSimulator::MAX_STREAMS; i++) {
+        config.frameIntervals[i] = 0;
+    }
+    configs.push_back(config);
+    for (uint32_t i = 0; i < VkVideoQueueSimulator::MAX_STREAMS; i++) {
+        config.frameIntervals[i] = 40;
+    }
+    config.churnInterval = 101;
+    configs.push_back(config);
+}
+
+int main(int argc, const char** argv)
+{
+    VkVideoQueueSimulator::Config config;
+    bool sweep = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1) < argc;
+        if ((arg == "-h") || (arg == "--help")) {
+            PrintHelp(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (((arg == "-q") || (arg == "--queues")) && hasValue) {
+            config.numQueues = (uint32_t)std::min(std::max(std::atoi(argv[++i]), 1), (int)VkVideoQueueSimulator::MAX_QUEUES);
+        } else if (((arg == "-s") || (arg == "--streams")) && hasValue) {
+            config.numStreams = (uint32_t)std::min(std::max(std::atoi(argv[++i]), 1), (int)VkVideoQueueSimulator::MAX_STREAMS);
+        } else if ((arg == "--slack") && hasValue) {
+            config.affinitySlack = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--ticks") && hasValue) {
+            config.numTicks = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if ((arg == "--inFlight") && hasValue) {
+            config.maxInFlight = (uint32_t)std::min(std::max(std::atoi(argv[++i]), 1), 64);
+        } else if ((arg == "--intervals") && hasValue) {
+            if (!ParseList(argv[++i], config.frameIntervals, VkVideoQueueSimulator::MAX_STREAMS, 0)) {
+                fprintf(stderr, "Invalid frame intervals %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if ((arg == "--churn") && hasValue) {
+            config.churnInterval = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--weights") && hasValue) {
+            if (!ParseList(argv[++i], config.weights, VkVideoQueueSimulator::MAX_STREAMS, 1)) {
+                fprintf(stderr, "Invalid weights %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if ((arg == "--queueTicks") && hasValue) {
+            if (!ParseList(argv[++i], config.queueTicks, VkVideoQueueSimulator::MAX_QUEUES, 1)) {
+                fprintf(stderr, "Invalid queue ticks %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if ((arg == "--minFairness") && hasValue) {
+            config.minFairness = (uint32_t)std::min(std::max(std::atoi(argv[++i]), 0), 100);
+        } else if (arg == "--sweep") {
+            sweep = true;
+        } else if ((arg == "--maxErrors") && hasValue) {
+            config.maxReportedErrors = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "-v") || (arg == "--verbose")) {
+            config.verbose = true;
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument %s\n", arg.c_str());
+            PrintHelp(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<VkVideoQueueSimulator::Config> configs;
+    if (sweep) {
+        AddSweepConfigs(config, configs);
+    } else {
+        configs.push_back(config);
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t numFailed = 0;
+    for (size_t i = 0; i < configs.size(); i++) {
+        if (!RunConfig(configs[i], sweep)) {
+            numFailed++;
+        }
+    }
+    const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (configs.size() > 1) {
+        printf("%u of %u configuration(s) failed, %.2f s\n", numFailed, (uint32_t)configs.size(), elapsedSec);
+    }
+
+    return (numFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
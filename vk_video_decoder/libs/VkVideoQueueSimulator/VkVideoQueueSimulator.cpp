@@ -0,0 +1,417 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <stdarg.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "VkVideoQueueSimulator.h"
+
+static const char* const s_choiceNames[] = { "affinity", "fairness", "least loaded" };
+
+VkVideoQueueSimulator::VkVideoQueueSimulator(const Config& config)
+    : m_config(config)
+    , m_loadBalancer()
+    , m_queues()
+    , m_streams()
+    , m_streamIdLoads()
+    , m_nextChurnStream(0)
+    , m_stats()
+{
+    m_config.numQueues = std::min<uint32_t>(std::max<uint32_t>(m_config.numQueues, 1), MAX_QUEUES);
+    m_config.numStreams = std::min<uint32_t>(std::max<uint32_t>(m_config.numStreams, 1), MAX_STREAMS);
+    m_config.maxInFlight = std::max<uint32_t>(m_config.maxInFlight, 1);
+    for (uint32_t i = 0; i < MAX_STREAMS; i++) {
+        m_config.weights[i] = std::max<uint32_t>(m_config.weights[i], 1);
+    }
+    for (uint32_t i = 0; i < MAX_QUEUES; i++) {
+        m_config.queueTicks[i] = std::max<uint32_t>(m_config.queueTicks[i], 1);
+    }
+}
+
+void VkVideoQueueSimulator::ReportError(uint64_t tick, const char* format, ...)
+{
+    if (m_stats.numErrors++ >= m_config.maxReportedErrors) {
+        return;
+    }
+
+    fprintf(stderr, "%u queue(s), %u stream(s): tick %llu: ", m_config.numQueues, m_config.numStreams,
+            (unsigned long long)tick);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+}
+
+// Completes the submissions whose time is up and retires them from the
+// balancer, as VulkanVideoQueueScheduler does with the semaphore values.
+void VkVideoQueueSimulator::RunQueues(uint64_t tick)
+{
+    for (uint32_t queueIndex = 0; queueIndex < m_config.numQueues; queueIndex++) {
+        SimQueue& queue = m_queues[queueIndex];
+        while (!queue.pending.empty() && (queue.busyUntil <= tick)) {
+
+            const SimSubmission submission = queue.pending.front();
+            queue.pending.pop_front();
+            queue.completedValue = submission.value;
+            assert(queue.load >= submission.cost);
+            queue.load -= submission.cost;
+            m_stats.queueCost[queueIndex] += submission.cost;
+
+            SimStream& stream = m_streams[submission.stream];
+            assert(stream.inFlight > 0);
+            stream.inFlight--;
+            assert(m_streamIdLoads[submission.streamId] >= submission.cost);
+            m_streamIdLoads[submission.streamId] -= submission.cost;
+            StreamStats& streamStats = m_stats.streams[submission.stream];
+            streamStats.completedCost += submission.cost;
+            const uint64_t latency = queue.busyUntil - submission.submitTick;
+            streamStats.totalLatency += latency;
+            streamStats.maxLatency = std::max(streamStats.maxLatency, latency);
+
+            // The next submission starts right after this one.
+            if (!queue.pending.empty()) {
+                const uint64_t duration = (uint64_t)queue.pending.front().cost * m_config.queueTicks[queueIndex];
+                queue.busyUntil += duration;
+                m_stats.busyTicks[queueIndex] += duration;
+            }
+        }
+
+        m_loadBalancer.Complete(queueIndex, queue.completedValue);
+    }
+}
+
+void VkVideoQueueSimulator::CheckAccounting(uint64_t tick)
+{
+    uint32_t totalLoad = 0;
+    for (uint32_t queueIndex = 0; queueIndex < m_config.numQueues; queueIndex++) {
+        const SimQueue& queue = m_queues[queueIndex];
+        totalLoad += queue.load;
+        if ((m_loadBalancer.GetQueueLoad(queueIndex) != queue.load) ||
+                (m_loadBalancer.GetQueuePendingCount(queueIndex) != queue.pending.size()) ||
+                (m_loadBalancer.GetQueueCompletedValue(queueIndex) != queue.completedValue)) {
+            ReportError(tick, "queue %u has a load of %u in %u submission(s) up to %llu, instead of %u in %u up to %llu",
+                        queueIndex, m_loadBalancer.GetQueueLoad(queueIndex), m_loadBalancer.GetQueuePendingCount(queueIndex),
+                        (unsigned long long)m_loadBalancer.GetQueueCompletedValue(queueIndex), queue.load,
+                        (uint32_t)queue.pending.size(), (unsigned long long)queue.completedValue);
+        }
+    }
+    if (m_loadBalancer.GetTotalLoad() != totalLoad) {
+        ReportError(tick, "total load of %u instead of %u", m_loadBalancer.GetTotalLoad(), totalLoad);
+    }
+    for (size_t streamId = 0; streamId < m_streamIdLoads.size(); streamId++) {
+        if (m_loadBalancer.GetStreamLoad((int32_t)streamId) != m_streamIdLoads[streamId]) {
+            ReportError(tick, "stream id %u has a load of %u instead of %u", (uint32_t)streamId,
+                        m_loadBalancer.GetStreamLoad((int32_t)streamId), m_streamIdLoads[streamId]);
+        }
+    }
+    for (uint32_t i = 0; i < m_config.numStreams; i++) {
+        const SimStream& stream = m_streams[i];
+        if (m_loadBalancer.GetStreamQueue(stream.streamId) != stream.lastQueue) {
+            ReportError(tick, "stream %u is attached to queue %d instead of queue %d", i,
+                        m_loadBalancer.GetStreamQueue(stream.streamId), stream.lastQueue);
+        }
+    }
+}
+
+void VkVideoQueueSimulator::CheckChoice(uint32_t streamIndex, int32_t queueIndex, uint64_t tick)
+{
+    const SimStream& stream = m_streams[streamIndex];
+
+    if ((queueIndex < 0) || ((uint32_t)queueIndex >= m_config.numQueues)) {
+        ReportError(tick, "stream %u got the invalid queue %d", streamIndex, queueIndex);
+        return;
+    }
+
+    uint32_t minLoad = m_queues[0].load;
+    uint32_t totalLoad = 0;
+    for (uint32_t i = 0; i < m_config.numQueues; i++) {
+        minLoad = std::min(minLoad, m_queues[i].load);
+        totalLoad += m_queues[i].load;
+    }
+
+    // The weights of the streams with outstanding work, and of this one.
+    uint32_t busyWeight = 0;
+    for (uint32_t i = 0; i < m_config.numStreams; i++) {
+        if ((m_streamIdLoads[m_streams[i].streamId] > 0) || (i == streamIndex)) {
+            busyWeight += m_config.weights[i];
+        }
+    }
+    const uint32_t streamLoad = m_streamIdLoads[stream.streamId];
+    const bool overShare = ((uint64_t)streamLoad * busyWeight) > ((uint64_t)totalLoad * m_config.weights[streamIndex]);
+
+    ChoiceType choice = CHOICE_LEAST_LOADED;
+    if ((stream.lastQueue >= 0) && (m_queues[stream.lastQueue].load <= (minLoad + m_config.affinitySlack))) {
+        choice = CHOICE_AFFINITY;
+    } else if ((stream.lastQueue >= 0) && overShare) {
+        choice = CHOICE_FAIRNESS;
+    }
+    m_stats.numChoices[choice]++;
+
+    if (m_config.verbose) {
+        printf("%8llu stream %2u (load %3u of %4u, weight %u) -> queue %2d (%s), loads", (unsigned long long)tick,
+               streamIndex, streamLoad, totalLoad, m_config.weights[streamIndex], queueIndex, s_choiceNames[choice]);
+        for (uint32_t i = 0; i < m_config.numQueues; i++) {
+            printf(" %u", m_queues[i].load);
+        }
+        printf("\n");
+    }
+
+    if (choice != CHOICE_LEAST_LOADED) {
+        if (queueIndex != stream.lastQueue) {
+            ReportError(tick, "stream %u moved from queue %d (load %u) to queue %d (load %u), %s",
+                        streamIndex, stream.lastQueue, m_queues[stream.lastQueue].load, queueIndex, m_queues[queueIndex].load,
+                        (choice == CHOICE_AFFINITY) ? "within the affinity slack" : "with more than its share of the work");
+        }
+        return;
+    }
+
+    if (m_queues[queueIndex].load != minLoad) {
+        ReportError(tick, "stream %u got queue %d with a load of %u, the least loaded has %u%s", streamIndex, queueIndex,
+                    m_queues[queueIndex].load, minLoad, (queueIndex == stream.lastQueue) ? ", within its share of the work" : "");
+        return;
+    }
+
+    // The least loaded queue with the fewest streams attached to it.
+    uint32_t numAttached[MAX_QUEUES] = {};
+    for (uint32_t i = 0; i < m_config.numStreams; i++) {
+        if (m_streams[i].lastQueue >= 0) {
+            numAttached[m_streams[i].lastQueue]++;
+        }
+    }
+    for (uint32_t i = 0; i < m_config.numQueues; i++) {
+        if ((m_queues[i].load == minLoad) && (numAttached[i] < numAttached[queueIndex])) {
+            ReportError(tick, "stream %u got queue %d with %u stream(s) attached, queue %u has %u with the same load",
+                        streamIndex, queueIndex, numAttached[queueIndex], i, numAttached[i]);
+            return;
+        }
+    }
+}
+
+void VkVideoQueueSimulator::SubmitFrame(uint32_t streamIndex, uint64_t tick)
+{
+    SimStream& stream = m_streams[streamIndex];
+    const uint32_t cost = m_config.weights[streamIndex];
+
+    const int32_t queueIndex = m_loadBalancer.SelectQueue(stream.streamId);
+    CheckChoice(streamIndex, queueIndex, tick);
+    if ((queueIndex < 0) || ((uint32_t)queueIndex >= m_config.numQueues)) {
+        return;
+    }
+
+    const uint64_t value = m_loadBalancer.Submit(stream.streamId, (uint32_t)queueIndex, cost);
+
+    SimQueue& queue = m_queues[queueIndex];
+    const uint64_t expectedValue = queue.pending.empty() ? (queue.completedValue + 1) : (queue.pending.back().value + 1);
+    if (value != expectedValue) {
+        ReportError(tick, "queue %d signals %llu instead of %llu", queueIndex, (unsigned long long)value,
+                    (unsigned long long)expectedValue);
+    }
+
+    SimSubmission submission;
+    submission.value = value;
+    submission.stream = streamIndex;
+    submission.streamId = stream.streamId;
+    submission.cost = cost;
+    submission.submitTick = tick;
+    if (queue.pending.empty()) {
+        const uint64_t duration = (uint64_t)cost * m_config.queueTicks[queueIndex];
+        queue.busyUntil = tick + duration;
+        m_stats.busyTicks[queueIndex] += duration;
+    }
+    queue.pending.push_back(submission);
+    queue.load += cost;
+    m_streamIdLoads[stream.streamId] += cost;
+
+    StreamStats& streamStats = m_stats.streams[streamIndex];
+    if ((stream.lastQueue >= 0) && (stream.lastQueue != queueIndex)) {
+        streamStats.numMigrations++;
+    }
+    streamStats.numSubmissions++;
+    m_stats.numSubmissions++;
+
+    stream.lastQueue = queueIndex;
+    stream.inFlight++;
+}
+
+// Returns false if the id still has outstanding work.
+bool VkVideoQueueSimulator::AddStreamId(int32_t streamId)
+{
+    assert(streamId >= 0);
+    if ((size_t)streamId >= m_streamIdLoads.size()) {
+        m_streamIdLoads.resize(streamId + 1, 0);
+    }
+    return (m_streamIdLoads[streamId] == 0);
+}
+
+// The stream goes away with its submissions still outstanding, as a decoder
+// that is destroyed, and a new one takes its place.
+void VkVideoQueueSimulator::RestartStream(uint32_t streamIndex)
+{
+    SimStream& stream = m_streams[streamIndex];
+    m_loadBalancer.UnregisterStream(stream.streamId);
+    if (m_loadBalancer.IsValidStream(stream.streamId)) {
+        ReportError(0, "stream %u is still valid after it was unregistered", streamIndex);
+    }
+
+    stream.streamId = m_loadBalancer.RegisterStream(m_config.weights[streamIndex]);
+    if (!AddStreamId(stream.streamId)) {
+        ReportError(0, "stream %u got the id %d, which still has outstanding work", streamIndex, stream.streamId);
+    }
+    for (uint32_t i = 0; i < m_config.numStreams; i++) {
+        if ((i != streamIndex) && (m_streams[i].streamId == stream.streamId)) {
+            ReportError(0, "stream %u got the id %d of stream %u", streamIndex, stream.streamId, i);
+        }
+    }
+    stream.lastQueue = -1;
+    m_stats.numRestarts++;
+}
+
+bool VkVideoQueueSimulator::Run()
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_loadBalancer.Reset(m_config.numQueues, m_config.affinitySlack);
+    m_queues.assign(m_config.numQueues, SimQueue());
+    for (uint32_t queueIndex = 0; queueIndex < m_config.numQueues; queueIndex++) {
+        m_queues[queueIndex].completedValue = 0;
+        m_queues[queueIndex].busyUntil = 0;
+        m_queues[queueIndex].load = 0;
+    }
+    m_streams.assign(m_config.numStreams, SimStream());
+    m_streamIdLoads.clear();
+    for (uint32_t i = 0; i < m_config.numStreams; i++) {
+        SimStream& stream = m_streams[i];
+        stream.streamId = m_loadBalancer.RegisterStream(m_config.weights[i]);
+        AddStreamId(stream.streamId);
+        stream.lastQueue = -1;
+        stream.inFlight = 0;
+        // The paced streams start at different times.
+        stream.nextFrameTick = ((uint64_t)m_config.frameIntervals[i] * i) / m_config.numStreams;
+    }
+    m_nextChurnStream = 0;
+
+    for (uint64_t tick = 0; tick < m_config.numTicks; tick++) {
+
+        if ((m_config.churnInterval > 0) && (tick > 0) && ((tick % m_config.churnInterval) == 0)) {
+            RestartStream(m_nextChurnStream);
+            m_nextChurnStream = (m_nextChurnStream + 1) % m_config.numStreams;
+        }
+
+        RunQueues(tick);
+
+        // The first stream to submit rotates, so none of them always gets the least loaded queue first.
+        for (uint32_t n = 0; n < m_config.numStreams; n++) {
+            const uint32_t streamIndex = (uint32_t)((tick + n) % m_config.numStreams);
+            SimStream& stream = m_streams[streamIndex];
+            while ((stream.inFlight < m_config.maxInFlight) && (stream.nextFrameTick <= tick)) {
+                SubmitFrame(streamIndex, tick);
+                if (m_config.frameIntervals[streamIndex] > 0) {
+                    stream.nextFrameTick += m_config.frameIntervals[streamIndex];
+                }
+            }
+        }
+
+        CheckAccounting(tick);
+    }
+
+    // Jain's index of the throughput per weight unit: 1.0 when every stream
+    // gets exactly its weighted share, 1 / n when one stream gets everything.
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    for (uint32_t i = 0; i < m_config.numStreams; i++) {
+        const double throughput = (double)m_stats.streams[i].completedCost / m_config.weights[i];
+        sum += throughput;
+        sumSquares += throughput * throughput;
+    }
+    m_stats.fairness = (sumSquares > 0.0) ? ((sum * sum) / (m_config.numStreams * sumSquares)) : 1.0;
+    if ((m_config.minFairness > 0) && ((m_stats.fairness * 100.0) < m_config.minFairness)) {
+        ReportError(m_config.numTicks, "the fairness index of the streams is %.3f, below %.2f", m_stats.fairness,
+                    m_config.minFairness / 100.0);
+    }
+
+    m_stats.elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return (m_stats.numErrors == 0);
+}
+
+void VkVideoQueueSimulator::PrintSummary(FILE* fp) const
+{
+    uint32_t minWeight = m_config.weights[0];
+    uint32_t maxWeight = m_config.weights[0];
+    for (uint32_t i = 1; i < m_config.numStreams; i++) {
+        minWeight = std::min(minWeight, m_config.weights[i]);
+        maxWeight = std::max(maxWeight, m_config.weights[i]);
+    }
+    uint32_t maxFrameInterval = 0;
+    for (uint32_t i = 0; i < m_config.numStreams; i++) {
+        maxFrameInterval = std::max(maxFrameInterval, m_config.frameIntervals[i]);
+    }
+    uint32_t minQueueTicks = m_config.queueTicks[0];
+    uint32_t maxQueueTicks = m_config.queueTicks[0];
+    for (uint32_t i = 1; i < m_config.numQueues; i++) {
+        minQueueTicks = std::min(minQueueTicks, m_config.queueTicks[i]);
+        maxQueueTicks = std::max(maxQueueTicks, m_config.queueTicks[i]);
+    }
+    uint64_t numMigrations = 0;
+    for (uint32_t i = 0; i < m_config.numStreams; i++) {
+        numMigrations += m_stats.streams[i].numMigrations;
+    }
+
+    fprintf(fp, "%2u queue(s) of %u-%u ticks, %2u stream(s) of weight %u-%u, slack %u, in flight %u, interval up to %4u, churn %5u: "
+                "%llu submission(s), %.1f%% moved, fairness %.3f, %llu error(s)\n",
+            m_config.numQueues, minQueueTicks, maxQueueTicks, m_config.numStreams, minWeight, maxWeight,
+            m_config.affinitySlack, m_config.maxInFlight, maxFrameInterval, m_config.churnInterval,
+            (unsigned long long)m_stats.numSubmissions,
+            (m_stats.numSubmissions > 0) ? (100.0 * numMigrations / m_stats.numSubmissions) : 0.0,
+            m_stats.fairness, (unsigned long long)m_stats.numErrors);
+}
+
+void VkVideoQueueSimulator::PrintReport(FILE* fp) const
+{
+    PrintSummary(fp);
+    fprintf(fp, "  Choices: %llu affinity, %llu fairness, %llu least loaded; %llu restart(s), %.2f M submissions/s\n",
+            (unsigned long long)m_stats.numChoices[CHOICE_AFFINITY], (unsigned long long)m_stats.numChoices[CHOICE_FAIRNESS],
+            (unsigned long long)m_stats.numChoices[CHOICE_LEAST_LOADED], (unsigned long long)m_stats.numRestarts,
+            (m_stats.elapsedSec > 0.0) ? (m_stats.numSubmissions / m_stats.elapsedSec / 1e6) : 0.0);
+
+    for (uint32_t queueIndex = 0; queueIndex < m_config.numQueues; queueIndex++) {
+        fprintf(fp, "  Queue %2u: %u tick(s) per cost unit, %5.1f%% busy, %llu cost unit(s) done\n", queueIndex,
+                m_config.queueTicks[queueIndex], 100.0 * std::min(m_stats.busyTicks[queueIndex], m_config.numTicks) / m_config.numTicks,
+                (unsigned long long)m_stats.queueCost[queueIndex]);
+    }
+
+    uint64_t totalCost = 0;
+    uint32_t totalWeight = 0;
+    for (uint32_t i = 0; i < m_config.numStreams; i++) {
+        totalCost += m_stats.streams[i].completedCost;
+        totalWeight += m_config.weights[i];
+    }
+    for (uint32_t i = 0; i < m_config.numStreams; i++) {
+        const StreamStats& streamStats = m_stats.streams[i];
+        const uint64_t numCompleted = streamStats.completedCost / m_config.weights[i];
+        fprintf(fp, "  Stream %2u: weight %u, interval %u, %llu submission(s), %llu move(s), %5.1f%% of the work for a %5.1f%% share, "
+                    "latency mean %.0f max %llu tick(s)\n",
+                i, m_config.weights[i], m_config.frameIntervals[i], (unsigned long long)streamStats.numSubmissions,
+                (unsigned long long)streamStats.numMigrations,
+                (totalCost > 0) ? (100.0 * streamStats.completedCost / totalCost) : 0.0, 100.0 * m_config.weights[i] / totalWeight,
+                (numCompleted > 0) ? ((double)streamStats.totalLatency / numCompleted) : 0.0,
+                (unsigned long long)streamStats.maxLatency);
+    }
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEOQUEUESIMULATOR_VKVIDEOQUEUESIMULATOR_H_
+#define _VKVIDEOQUEUESIMULATOR_VKVIDEOQUEUESIMULATOR_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+#include <vector>
+#include "VkCodecUtils/VkVideoQueueLoadBalancer.h"
+
+// Drives VkVideoQueueLoadBalancer the way VulkanVideoQueueScheduler does,
+// without a Vulkan device: the completed values of the queues are retired
+// before each queue choice, and each submission is recorded with the value
+// its queue's timeline semaphore would be signaled with. Each simulated queue
+// runs its submissions one after the other, for the cost of the submission
+// times the queue's ticks per cost unit, and its completed value advances
+// when a submission is done.
+//
+// Each stream keeps up to maxInFlight submissions outstanding, like the
+// decoder with its decode frame buffers, and submits a frame of its weight
+// in cost every frameIntervals[stream] ticks, or as soon as it can. With
+// churnInterval, one stream at a time unregisters with its work still
+// outstanding and registers again.
+//
+// Every queue choice is checked against the policy:
+// - least loaded: a stream that moves goes to a least loaded queue, the one
+//   with the fewest attached streams among them;
+// - affinity: a stream stays on its queue while that queue is within the
+//   affinity slack of the least loaded one;
+// - fairness: a stream with more than its weighted share of the outstanding
+//   work doesn't move, and one within its share doesn't stay on a queue that
+//   is loaded beyond the slack.
+// The loads the balancer reports, also of the streams that are gone, are
+// checked against the simulator's own accounting of the outstanding
+// submissions. The report has the throughput of each stream relative to its
+// weighted share and the utilization of each queue.
+class VkVideoQueueSimulator {
+
+public:
+
+    enum { MAX_QUEUES = 16 };
+    enum { MAX_STREAMS = 64 };
+
+    struct Config {
+        uint32_t numQueues;
+        uint32_t numStreams;
+        uint32_t affinitySlack;
+        uint64_t numTicks;              // of the simulated time
+        uint32_t maxInFlight;           // submissions per stream
+        uint32_t churnInterval;         // ticks between two stream restarts, 0: none
+        uint32_t weights[MAX_STREAMS];  // the cost of a frame is the weight of the stream
+        uint32_t frameIntervals[MAX_STREAMS]; // ticks between the frames of each stream, 0: as soon as it can
+        uint32_t queueTicks[MAX_QUEUES];// ticks per cost unit of each queue
+        uint32_t minFairness;           // in percent of Jain's index of the weighted throughputs, 0: not checked
+        uint32_t maxReportedErrors;     // the following ones are only counted
+        bool     verbose;               // print every queue choice
+
+        Config()
+        : numQueues(2)
+        , numStreams(4)
+        , affinitySlack(1)
+        , numTicks(1000000)
+        , maxInFlight(4)
+        , churnInterval(0)
+        , minFairness(0)
+        , maxReportedErrors(8)
+        , verbose(false)
+        {
+            for (uint32_t i = 0; i < MAX_STREAMS; i++) {
+                weights[i] = 1;
+                frameIntervals[i] = 0;
+            }
+            for (uint32_t i = 0; i < MAX_QUEUES; i++) {
+                queueTicks[i] = 10;
+            }
+        }
+    };
+
+    struct StreamStats {
+        uint64_t numSubmissions;
+        uint64_t completedCost;
+        uint64_t numMigrations;         // queue changes between two submissions
+        uint64_t totalLatency;          // ticks from the submission to the completion
+        uint64_t maxLatency;
+    };
+
+    struct Stats {
+        uint64_t numSubmissions;
+        uint64_t numChoices[3];         // by ChoiceType
+        uint64_t numRestarts;
+        uint64_t numErrors;
+        uint64_t busyTicks[MAX_QUEUES];
+        uint64_t queueCost[MAX_QUEUES]; // completed on each queue
+        StreamStats streams[MAX_STREAMS];
+        double   fairness;              // Jain's index of the throughput / weight of the streams
+        double   elapsedSec;
+    };
+
+    explicit VkVideoQueueSimulator(const Config& config);
+
+    // Returns false if a check failed.
+    bool Run();
+
+    const Stats& GetStats() const { return m_stats; }
+    // One line per configuration, for the sweeps.
+    void PrintSummary(FILE* fp = stdout) const;
+    void PrintReport(FILE* fp = stdout) const;
+
+private:
+
+    enum ChoiceType {
+        CHOICE_AFFINITY = 0,            // stays on its queue, within the slack
+        CHOICE_FAIRNESS = 1,            // stays on a busier queue, over its share
+        CHOICE_LEAST_LOADED = 2,        // a least loaded queue
+    };
+
+    struct SimSubmission {
+        uint64_t value;                 // of the queue's timeline semaphore
+        uint32_t stream;
+        int32_t  streamId;              // of the balancer when it was submitted
+        uint32_t cost;
+        uint64_t submitTick;
+    };
+
+    struct SimQueue {
+        std::deque<SimSubmission> pending;
+        uint64_t completedValue;
+        uint64_t busyUntil;             // the tick the front submission completes at
+        uint32_t load;
+    };
+
+    struct SimStream {
+        int32_t  streamId;              // of the balancer
+        int32_t  lastQueue;
+        uint32_t inFlight;
+        uint64_t nextFrameTick;
+    };
+
+    void RunQueues(uint64_t tick);
+    void SubmitFrame(uint32_t stream, uint64_t tick);
+    bool AddStreamId(int32_t streamId);
+    void RestartStream(uint32_t stream);
+    void CheckChoice(uint32_t stream, int32_t queueIndex, uint64_t tick);
+    void CheckAccounting(uint64_t tick);
+    void ReportError(uint64_t tick, const char* format, ...);
+
+    Config                     m_config;
+    VkVideoQueueLoadBalancer   m_loadBalancer;
+    std::vector<SimQueue>      m_queues;
+    std::vector<SimStream>     m_streams;
+    std::vector<uint32_t>      m_streamIdLoads;   // outstanding cost of each balancer stream id, also the unregistered ones
+    uint32_t                   m_nextChurnStream;
+    Stats                      m_stats;
+};
+
+#endif /* _VKVIDEOQUEUESIMULATOR_VKVIDEOQUEUESIMULATOR_H_ */
@@ -0,0 +1,531 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "VkDecoderUtils/VideoStreamDemuxer.h"
+#include "VkVideoStreamAnalyzer/VkVideoStreamAnalyzer.h"
+#include "VkVideoStreamAnalyzer/VkStreamSegmentParser.h"
+
+extern VkResult ElementaryStreamCreate(const char *pFilePath,
+                                       VkVideoCodecOperationFlagBitsKHR codecType,
+                                       int32_t defaultWidth,
+                                       int32_t defaultHeight,
+                                       int32_t defaultBitDepth,
+                                       VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
+
+static void PrintHelp(const char* programName)
+{
+    fprintf(stderr,
+            "Usage: %s -i <elementary stream> [options]\n"
+            "Parses a compressed video stream on the CPU and writes one record per picture.\n"
+            "  -i, --input <file>      H.264/H.265 Annex B stream, AV1 as IVF or low-overhead OBU stream, or VP9 as IVF\n"
+            "  -c, --codec <name>      h264 | h265 | av1 | vp9 (default: from the file extension or the IVF header)\n"
+            "  -o, --output <file>     Output file (default: stdout)\n"
+            "      --csv               Write CSV instead of JSON Lines\n"
+            "      --chunkSize <bytes> H.26x bytes passed to the parser per call (default 2 MiB)\n"
+            "      --pipelined         Search the H.26x start codes on a separate thread\n"
+            "      --metadata          Report the SEI messages / AV1 metadata OBUs of each picture\n"
+            "      --slices            Write a record per H.265 slice segment, with its QP and entry points (JSON Lines)\n"
+            "      --threads <n>       Parse closed-GOP segments of the stream on n threads (default 1)\n"
+            "      --segmentSize <b>   Minimum segment size (default: stream size / (4 * threads), at least 1 MiB)\n"
+            "      --verify            With --threads, also parse serially and compare the records\n"
+            "      --expect <file>     Compare the records with a file written by an earlier run with the same options\n"
+            "      --noSummary         Do not print the throughput summary to stderr\n"
+            "      --telemetry         Add the parser counters and callback timings to the summary\n"
+            "  -h, --help              Print this help\n",
+            programName);
+}
+
+static void PrintTelemetry(const VkParserTelemetry& telemetry)
+{
+    const double mbParsed = telemetry.bytesParsed / (1024.0 * 1024.0);
+    fprintf(stderr, "\tparser input %llu bytes, %llu start code(s) (%.1f per MB), %llu emulation prevention byte(s) in the headers\n",
+            (unsigned long long)telemetry.bytesParsed, (unsigned long long)telemetry.startCodes,
+            (mbParsed > 0.0) ? (telemetry.startCodes / mbParsed) : 0.0,
+            (unsigned long long)telemetry.emulationPreventionBytes);
+    fprintf(stderr, "\tparser bitstream buffers: %llu bytes copied, %llu bytes carried over by %u swap(s), %u resize(s), max %llu bytes\n",
+            (unsigned long long)telemetry.bytesCopied, (unsigned long long)telemetry.bytesCarriedOver,
+            telemetry.bufferSwaps, telemetry.bufferResizes, (unsigned long long)telemetry.maxBufferSize);
+    if (telemetry.pictures > 0) {
+        fprintf(stderr, "\tparser pictures %llu, %.2f slice(s)/tile(s) per picture (max %u)\n",
+                (unsigned long long)telemetry.pictures, (double)telemetry.slices / telemetry.pictures,
+                telemetry.maxSlicesPerPicture);
+    }
+    std::string unitTypes;
+    for (uint32_t i = 0; i < 64; i++) {
+        if (telemetry.nalUnitTypes[i] > 0) {
+            unitTypes += " " + std::to_string(i) + ":" + std::to_string(telemetry.nalUnitTypes[i]);
+        }
+    }
+    if (!unitTypes.empty()) {
+        fprintf(stderr, "\tparser NAL unit / OBU types:%s\n", unitTypes.c_str());
+    }
+    const struct {
+        const char* name;
+        const VkParserCallbackTiming& timing;
+    } callbacks[] = {
+        { "BeginSequence", telemetry.beginSequence },
+        { "DecodePicture", telemetry.decodePicture },
+        { "DisplayPicture", telemetry.displayPicture },
+    };
+    for (const auto& callback : callbacks) {
+        if (callback.timing.count > 0) {
+            fprintf(stderr, "\tcallback %s: %llu call(s), avg %.2f us, max %.2f us\n", callback.name,
+                    (unsigned long long)callback.timing.count,
+                    callback.timing.totalNs / 1000.0 / callback.timing.count, callback.timing.maxNs / 1000.0);
+        }
+    }
+}
+
+// Reads a line without its end of line characters, false at the end of the file.
+static bool ReadLine(FILE* fp, std::string& line)
+{
+    line.clear();
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), fp) != nullptr) {
+        line += buffer;
+        if (line.back() == '\n') {
+            break;
+        }
+    }
+    while (!line.empty() && ((line.back() == '\n') || (line.back() == '\r'))) {
+        line.pop_back();
+    }
+    return !line.empty() || !feof(fp);
+}
+
+// Compares the records written to recordFile with the lines of the file
+// expectedFileName and reports the first difference.
+static bool CompareRecords(FILE* recordFile, const char* expectedFileName)
+{
+    FILE* expectedFile = fopen(expectedFileName, "r");
+    if (expectedFile == nullptr) {
+        fprintf(stderr, "Can't open the expected records %s\n", expectedFileName);
+        return false;
+    }
+
+    rewind(recordFile);
+    std::string record, expected;
+    uint32_t lineNum = 0;
+    bool match = true;
+    while (true) {
+        const bool hasRecord = ReadLine(recordFile, record);
+        const bool hasExpected = ReadLine(expectedFile, expected);
+        if (!hasRecord && !hasExpected) {
+            break;
+        }
+        lineNum++;
+        if ((hasRecord != hasExpected) || (record != expected)) {
+            fprintf(stderr, "Line %u differs from %s\n\texpected: %s\n\tparsed:   %s\n", lineNum, expectedFileName,
+                    hasExpected ? expected.c_str() : "(end of file)", hasRecord ? record.c_str() : "(end of records)");
+            match = false;
+            break;
+        }
+    }
+    fclose(expectedFile);
+
+    if (match) {
+        fprintf(stderr, "The %u record(s) match %s\n", lineNum, expectedFileName);
+    }
+    return match;
+}
+
+static VkVideoCodecOperationFlagBitsKHR GetCodecFromName(const std::string& name)
+{
+    if ((name == "h264") || (name == "264") || (name == "avc") || (name == "h.264")) {
+        return VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR;
+    } else if ((name == "h265") || (name == "265") || (name == "hevc") || (name == "h.265")) {
+        return VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR;
+    } else if ((name == "av1") || (name == "ivf") || (name == "obu")) {
+        return VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+    } else if (name == "vp9") {
+        return VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR;
+    }
+    return VK_VIDEO_CODEC_OPERATION_NONE_KHR;
+}
+
+static uint32_t ReadLe32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Splits an IVF file into temporal units, one per frame.
+static void GetIvfTemporalUnits(const uint8_t* pData, int64_t size, std::vector<VkStreamPacket>& temporalUnits)
+{
+    const uint32_t ivfFileHeaderSize = 32, ivfFrameHeaderSize = 12;
+    if (size < ivfFileHeaderSize) {
+        return;
+    }
+
+    int64_t offset = pData[6] | (pData[7] << 8);
+    while ((offset + ivfFrameHeaderSize) <= size) {
+        const uint32_t frameSize = ReadLe32(pData + offset);
+        offset += ivfFrameHeaderSize;
+        if ((offset + frameSize) > size) {
+            fprintf(stderr, "Truncated IVF frame at offset %lld\n", (long long)offset);
+            break;
+        }
+        VkStreamPacket temporalUnit = { offset, frameSize, true };
+        temporalUnits.push_back(temporalUnit);
+        offset += frameSize;
+    }
+}
+
+// Splits a low-overhead (Section 5) OBU stream into temporal units at the
+// temporal delimiter OBUs.
+static VkResult GetObuTemporalUnits(const uint8_t* pData, int64_t size, std::vector<VkStreamPacket>& temporalUnits)
+{
+    const uint32_t obuTemporalDelimiter = 2;
+
+    int64_t offset = 0;
+    int64_t temporalUnitStart = 0;
+    while (offset < size) {
+        const uint8_t obuHeader = pData[offset];
+        const uint32_t obuType = (obuHeader >> 3) & 0xF;
+        const bool hasExtension = (obuHeader >> 2) & 1;
+        const bool hasSizeField = (obuHeader >> 1) & 1;
+        if (!hasSizeField) {
+            fprintf(stderr, "OBU without obu_size at offset %lld: Annex B streams are not supported\n", (long long)offset);
+            return VK_ERROR_FORMAT_NOT_SUPPORTED;
+        }
+
+        if ((obuType == obuTemporalDelimiter) && (offset > temporalUnitStart)) {
+            VkStreamPacket temporalUnit = { temporalUnitStart, (size_t)(offset - temporalUnitStart), true };
+            temporalUnits.push_back(temporalUnit);
+            temporalUnitStart = offset;
+        }
+
+        int64_t pos = offset + 1 + (hasExtension ? 1 : 0);
+        uint64_t obuSize = 0;
+        for (uint32_t i = 0; (i < 8) && (pos < size); i++) {
+            const uint8_t byte = pData[pos++];
+            obuSize |= (uint64_t)(byte & 0x7f) << (i * 7);
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        offset = pos + (int64_t)obuSize;
+    }
+
+    if (size > temporalUnitStart) {
+        VkStreamPacket temporalUnit = { temporalUnitStart, (size_t)(size - temporalUnitStart), true };
+        temporalUnits.push_back(temporalUnit);
+    }
+
+    return VK_SUCCESS;
+}
+
+// Feeds AV1 temporal units or VP9 frames (superframes) to the parser, one per call.
+static VkResult ParseTemporalUnits(VkVideoStreamAnalyzer* pAnalyzer, const uint8_t* pData,
+                                   const std::vector<VkStreamPacket>& temporalUnits)
+{
+    for (size_t i = 0; i < temporalUnits.size(); i++) {
+        VkResult result = pAnalyzer->ParseData(pData + temporalUnits[i].offset, temporalUnits[i].size, true, false);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
+
+    return pAnalyzer->ParseData(nullptr, 0, true, true);
+}
+
+// Feeds an Annex B byte stream in fixed size chunks, the parser finds the start codes.
+static VkResult ParseAnnexB(VkVideoStreamAnalyzer* pAnalyzer, const uint8_t* pData, int64_t size, int64_t chunkSize)
+{
+    int64_t offset = 0;
+    do {
+        const int64_t bytes = std::min<int64_t>(chunkSize, size - offset);
+        const bool endOfStream = (offset + bytes) >= size;
+        VkResult result = pAnalyzer->ParseData(pData + offset, (size_t)bytes, false, endOfStream);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        offset += bytes;
+    } while (offset < size);
+
+    return VK_SUCCESS;
+}
+
+// Parses the whole stream with a single parser.
+static VkResult ParseSerial(VkVideoCodecOperationFlagBitsKHR codec, const uint8_t* pData, int64_t size,
+                            int64_t chunkSize, const std::vector<VkStreamPacket>& temporalUnits,
+                            const VkVideoStreamAnalyzer::ParserOptions& parserOptions, VkStreamAnalyzerWriter* pWriter,
+                            VkVideoStreamAnalyzer::Stats& stats)
+{
+    VkSharedBaseObj<VkVideoStreamAnalyzer> analyzer;
+    VkResult result = VkVideoStreamAnalyzer::Create(codec, pWriter, parserOptions, analyzer);
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "Can't create the stream analyzer, error %d\n", result);
+        return result;
+    }
+
+    if ((codec == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) || (codec == VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR)) {
+        result = ParseTemporalUnits(analyzer.Get(), pData, temporalUnits);
+    } else {
+        result = ParseAnnexB(analyzer.Get(), pData, size, chunkSize);
+    }
+
+    stats = analyzer->GetStats();
+    return result;
+}
+
+int main(int argc, const char** argv)
+{
+    std::string inputFileName;
+    std::string outputFileName;
+    std::string codecName;
+    std::string expectFileName;
+    VkStreamAnalyzerWriter::Format format = VkStreamAnalyzerWriter::FORMAT_JSON_LINES;
+    int64_t chunkSize = 2 * 1024 * 1024;
+    bool printSummary = true;
+    bool printTelemetry = false;
+    VkVideoStreamAnalyzer::ParserOptions parserOptions = VkVideoStreamAnalyzer::ParserOptions();
+    uint32_t numThreads = 1;
+    int64_t minSegmentSize = 0;
+    bool verify = false;
+    bool sliceRecords = false;
+
+    for (int32_t i = 1; i < argc; i++) {
+        const std::string arg(argv[i]);
+        const bool hasValue = (i + 1) < argc;
+        if ((arg == "-h") || (arg == "--help")) {
+            PrintHelp(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (((arg == "-i") || (arg == "--input")) && hasValue) {
+            inputFileName = argv[++i];
+        } else if (((arg == "-o") || (arg == "--output")) && hasValue) {
+            outputFileName = argv[++i];
+        } else if (((arg == "-c") || (arg == "--codec")) && hasValue) {
+            codecName = argv[++i];
+        } else if (arg == "--csv") {
+            format = VkStreamAnalyzerWriter::FORMAT_CSV;
+        } else if (arg == "--jsonl") {
+            format = VkStreamAnalyzerWriter::FORMAT_JSON_LINES;
+        } else if ((arg == "--chunkSize") && hasValue) {
+            chunkSize = std::max<int64_t>(std::atoll(argv[++i]), 4096);
+        } else if (arg == "--pipelined") {
+            parserOptions.pipelinedParsing = true;
+        } else if (arg == "--metadata") {
+            parserOptions.pictureMetadata = true;
+        } else if (arg == "--slices") {
+            sliceRecords = true;
+        } else if ((arg == "--threads") && hasValue) {
+            numThreads = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--segmentSize") && hasValue) {
+            minSegmentSize = std::max<int64_t>(std::atoll(argv[++i]), 0);
+        } else if (arg == "--verify") {
+            verify = true;
+        } else if ((arg == "--expect") && hasValue) {
+            expectFileName = argv[++i];
+        } else if (arg == "--noSummary") {
+            printSummary = false;
+        } else if (arg == "--telemetry") {
+            printTelemetry = true;
+            parserOptions.callbackTimings = true;
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument %s\n", arg.c_str());
+            PrintHelp(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (inputFileName.empty()) {
+        PrintHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (codecName.empty()) {
+        const size_t dot = inputFileName.find_last_of('.');
+        if (dot != std::string::npos) {
+            codecName = inputFileName.substr(dot + 1);
+        }
+    }
+
+    VkVideoCodecOperationFlagBitsKHR codec = GetCodecFromName(codecName);
+    if (codec == VK_VIDEO_CODEC_OPERATION_NONE_KHR) {
+        fprintf(stderr, "Unknown codec \"%s\", use --codec\n", codecName.c_str());
+        return EXIT_FAILURE;
+    }
+
+    FILE* inputFile = fopen(inputFileName.c_str(), "rb");
+    if (inputFile == nullptr) {
+        fprintf(stderr, "Can't open the input file %s\n", inputFileName.c_str());
+        return EXIT_FAILURE;
+    }
+    fclose(inputFile);
+
+    VkSharedBaseObj<VideoStreamDemuxer> demuxer;
+    VkResult result = ElementaryStreamCreate(inputFileName.c_str(), codec, 1920, 1080, 8, demuxer);
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "Can't map the input file %s\n", inputFileName.c_str());
+        return EXIT_FAILURE;
+    }
+
+    const uint8_t* pData = nullptr;
+    const int64_t size = demuxer->ReadBitstreamData(&pData, 0);
+    if ((pData == nullptr) || (size <= 0)) {
+        fprintf(stderr, "The input file %s is empty\n", inputFileName.c_str());
+        return EXIT_FAILURE;
+    }
+
+    // An .ivf file without --codec is AV1 unless its header says VP9
+    if (codecName == "ivf") {
+        const uint32_t ivfFourccOffset = 8;
+        if ((size >= 12) && (memcmp(pData, "DKIF", 4) == 0) && (memcmp(pData + ivfFourccOffset, "VP90", 4) == 0)) {
+            codec = VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR;
+        }
+    }
+
+    // With --expect, the records are read back from the output file.
+    FILE* outputFile = stdout;
+    if (!outputFileName.empty()) {
+        outputFile = fopen(outputFileName.c_str(), expectFileName.empty() ? "w" : "w+");
+    } else if (!expectFileName.empty()) {
+        outputFile = tmpfile();
+    }
+    if (outputFile == nullptr) {
+        fprintf(stderr, "Can't open the output file %s\n", outputFileName.c_str());
+        return EXIT_FAILURE;
+    }
+    // The records are small and frequent, keep the writes off the parsing path.
+    static char outputBuffer[1024 * 1024];
+    setvbuf(outputFile, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+    std::vector<VkStreamPacket> temporalUnits;
+    if (codec == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+        if ((size >= 4) && (memcmp(pData, "DKIF", 4) == 0)) {
+            GetIvfTemporalUnits(pData, size, temporalUnits);
+        } else if (GetObuTemporalUnits(pData, size, temporalUnits) != VK_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+    } else if (codec == VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR) {
+        if ((size < 4) || (memcmp(pData, "DKIF", 4) != 0)) {
+            fprintf(stderr, "VP9 is only supported in IVF files\n");
+            return EXIT_FAILURE;
+        }
+        GetIvfTemporalUnits(pData, size, temporalUnits);
+    }
+
+    VkStreamAnalyzerWriter writer(outputFile, format, sliceRecords);
+    VkVideoStreamAnalyzer::Stats stats;
+    memset(&stats, 0, sizeof(stats));
+    size_t numSegments = 1;
+
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    VkStreamAnalyzerRecordBuffer segmentRecords;
+    if (numThreads > 1) {
+        // A few segments per thread, so that the threads stay busy until the end.
+        if (minSegmentSize == 0) {
+            minSegmentSize = std::max<int64_t>(size / (4 * numThreads), 1024 * 1024);
+        }
+        std::vector<VkStreamSegment> segments;
+        if (codec == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+            VkStreamSegmentParser::SplitAv1(pData, temporalUnits, minSegmentSize, segments);
+        } else if (codec == VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR) {
+            VkStreamSegmentParser::SplitVp9(pData, temporalUnits, minSegmentSize, segments);
+        } else {
+            VkStreamSegmentParser::SplitAnnexB(codec, pData, size, minSegmentSize, chunkSize, segments);
+        }
+        numSegments = segments.size();
+        result = VkStreamSegmentParser::Parse(codec, pData, segments, numThreads, parserOptions,
+                                              verify ? &segmentRecords : &writer, stats);
+    } else {
+        result = ParseSerial(codec, pData, size, chunkSize, temporalUnits, parserOptions, &writer, stats);
+    }
+
+    const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+
+    if ((numThreads > 1) && verify && (result == VK_SUCCESS)) {
+        VkStreamAnalyzerRecordBuffer serialRecords;
+        VkVideoStreamAnalyzer::Stats serialStats;
+        result = ParseSerial(codec, pData, size, chunkSize, temporalUnits, parserOptions, &serialRecords, serialStats);
+        std::string difference;
+        if ((result == VK_SUCCESS) && !segmentRecords.Compare(serialRecords, difference)) {
+            fprintf(stderr, "Verification failed: the segment-parallel parse has %s\n", difference.c_str());
+            result = VK_ERROR_UNKNOWN;
+        } else if (result == VK_SUCCESS) {
+            fprintf(stderr, "Verification passed: %u segment(s), %llu picture(s) identical to the serial parse\n",
+                    (uint32_t)numSegments, (unsigned long long)segmentRecords.GetNumFrames());
+        }
+        segmentRecords.Replay(&writer);
+    }
+    fflush(outputFile);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "Parsing of %s failed, error %d\n", inputFileName.c_str(), result);
+    } else if (!expectFileName.empty() && !CompareRecords(outputFile, expectFileName.c_str())) {
+        result = VK_ERROR_UNKNOWN;
+    }
+
+    if (printSummary) {
+        const double elapsedSec = std::chrono::duration<double>(endTime - startTime).count();
+        const double framesPerSec = (elapsedSec > 0.0) ? (stats.numFrames / elapsedSec) : 0.0;
+        const double streamFrameRate = (stats.frameRateDenominator != 0) ?
+                ((double)stats.frameRateNumerator / stats.frameRateDenominator) : 0.0;
+
+        fprintf(stderr, "%s: %s, %llu bytes, %u sequence(s), %u parameter set update(s)\n",
+                inputFileName.c_str(), VkStreamAnalyzerWriter::GetCodecName(codec), (unsigned long long)size,
+                stats.numSequences, stats.numParameterSetUpdates);
+        fprintf(stderr, "\tpictures %llu (key %llu, intra %llu, inter %llu), displayed %llu\n",
+                (unsigned long long)stats.numFrames, (unsigned long long)stats.numKeyFrames,
+                (unsigned long long)stats.numIntraFrames, (unsigned long long)stats.numInterFrames,
+                (unsigned long long)stats.numDisplayedFrames);
+        if (stats.numFrames > 0) {
+            fprintf(stderr, "\tpicture size avg %llu bytes, max %llu bytes\n",
+                    (unsigned long long)(stats.totalFrameBytes / stats.numFrames),
+                    (unsigned long long)stats.maxFrameBytes);
+        }
+        if (parserOptions.pictureMetadata) {
+            fprintf(stderr, "\tmetadata %llu message(s), %llu payload bytes\n",
+                    (unsigned long long)stats.numMetadata, (unsigned long long)stats.totalMetadataBytes);
+        }
+        if (stats.numSliceSegments > 0) {
+            fprintf(stderr, "\tslice segments %llu, QP avg %.1f (min %d, max %d), %llu entry point(s)\n",
+                    (unsigned long long)stats.numSliceSegments, (double)stats.totalSliceQp / stats.numSliceSegments,
+                    stats.minSliceQp, stats.maxSliceQp, (unsigned long long)stats.numEntryPoints);
+        }
+        if (numThreads > 1) {
+            fprintf(stderr, "\t%u segment(s) parsed on %u thread(s)\n", (uint32_t)numSegments, numThreads);
+        }
+        fprintf(stderr, "\tparser footprint %llu bytes, %llu bytes allocated on first use, %llu bytes of parameter sets\n",
+                (unsigned long long)stats.parserFootprint.parserSize,
+                (unsigned long long)stats.parserFootprint.onDemandSize,
+                (unsigned long long)stats.parserFootprint.parameterSetsSize);
+        if (printTelemetry) {
+            PrintTelemetry(stats.parserTelemetry);
+        }
+        fprintf(stderr, "\tparsed in %.3f sec: %.1f pictures/sec, %.1f MB/sec",
+                elapsedSec, framesPerSec, (elapsedSec > 0.0) ? (size / elapsedSec / (1024.0 * 1024.0)) : 0.0);
+        if (streamFrameRate > 0.0) {
+            fprintf(stderr, ", %.1fx real-time at %.3f fps", framesPerSec / streamFrameRate, streamFrameRate);
+        }
+        fprintf(stderr, "\n");
+    }
+
+    if (outputFile != stdout) {
+        fclose(outputFile);
+    }
+
+    return (result == VK_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,644 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string.h>
+#include <thread>
+
+#include "VkVideoStreamAnalyzer/VkStreamSegmentParser.h"
+
+namespace {
+
+// Reads the RBSP of a NAL unit, skipping the emulation prevention bytes.
+class NalBitReader {
+public:
+    NalBitReader(const uint8_t* pData, size_t size)
+        : m_pData(pData), m_size(size), m_pos(0), m_zeroCount(0), m_byte(0), m_bitsLeft(0) { }
+
+    bool ReadBits(uint32_t numBits, uint32_t& value)
+    {
+        value = 0;
+        for (uint32_t i = 0; i < numBits; i++) {
+            if (m_bitsLeft == 0) {
+                if (m_pos >= m_size) {
+                    return false;
+                }
+                m_byte = m_pData[m_pos++];
+                if ((m_zeroCount >= 2) && (m_byte == 3)) {
+                    if (m_pos >= m_size) {
+                        return false;
+                    }
+                    m_byte = m_pData[m_pos++];
+                    m_zeroCount = 0;
+                }
+                m_zeroCount = (m_byte == 0) ? (m_zeroCount + 1) : 0;
+                m_bitsLeft = 8;
+            }
+            m_bitsLeft--;
+            value = (value << 1) | ((m_byte >> m_bitsLeft) & 1);
+        }
+        return true;
+    }
+
+    bool SkipBits(uint32_t numBits)
+    {
+        uint32_t value;
+        while (numBits > 0) {
+            const uint32_t bits = std::min<uint32_t>(numBits, 32);
+            if (!ReadBits(bits, value)) {
+                return false;
+            }
+            numBits -= bits;
+        }
+        return true;
+    }
+
+    bool ReadUe(uint32_t& value)
+    {
+        uint32_t leadingZeros = 0, bit = 0;
+        while (ReadBits(1, bit) && (bit == 0)) {
+            if (++leadingZeros > 31) {
+                return false;
+            }
+        }
+        if (bit == 0) {
+            return false;
+        }
+        uint32_t suffix = 0;
+        if (!ReadBits(leadingZeros, suffix)) {
+            return false;
+        }
+        value = (1u << leadingZeros) - 1 + suffix;
+        return true;
+    }
+
+private:
+    const uint8_t* m_pData;
+    size_t         m_size;
+    size_t         m_pos;
+    uint32_t       m_zeroCount;
+    uint32_t       m_byte;
+    uint32_t       m_bitsLeft;
+};
+
+enum { PARAMETER_SET_VPS = 0, PARAMETER_SET_SPS, PARAMETER_SET_PPS };
+
+// Identifies a parameter set NAL unit, ordered so that the VPS come first and
+// the PPS last, which is the order they must be parsed in.
+bool GetParameterSetKey(bool isH265, const uint8_t* pNal, size_t nalSize, uint32_t& key)
+{
+    uint32_t type = 0, id = 0;
+    if (isH265) {
+        const uint32_t nalUnitType = (pNal[0] >> 1) & 0x3f;
+        NalBitReader reader(pNal + 2, nalSize - 2);
+        if (nalUnitType == 32) {
+            type = PARAMETER_SET_VPS;
+            if (!reader.ReadBits(4, id)) {
+                return false;
+            }
+        } else if (nalUnitType == 33) {
+            type = PARAMETER_SET_SPS;
+            uint32_t maxSubLayersMinus1 = 0;
+            if (!reader.SkipBits(4) || !reader.ReadBits(3, maxSubLayersMinus1) || !reader.SkipBits(1)) {
+                return false;
+            }
+            // profile_tier_level(1, sps_max_sub_layers_minus1)
+            uint32_t subLayerFlags = 0;
+            if (!reader.SkipBits(88 + 8) ||
+                    ((maxSubLayersMinus1 > 0) && !reader.ReadBits(2 * maxSubLayersMinus1, subLayerFlags)) ||
+                    ((maxSubLayersMinus1 > 0) && !reader.SkipBits(2 * (8 - maxSubLayersMinus1)))) {
+                return false;
+            }
+            for (uint32_t i = 0; i < maxSubLayersMinus1; i++) {
+                const uint32_t flags = subLayerFlags >> (2 * (maxSubLayersMinus1 - 1 - i));
+                if (((flags & 2) && !reader.SkipBits(88)) || ((flags & 1) && !reader.SkipBits(8))) {
+                    return false;
+                }
+            }
+            if (!reader.ReadUe(id)) {
+                return false;
+            }
+        } else if (nalUnitType == 34) {
+            type = PARAMETER_SET_PPS;
+            if (!reader.ReadUe(id)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    } else {
+        const uint32_t nalUnitType = pNal[0] & 0x1f;
+        NalBitReader reader(pNal + 1, nalSize - 1);
+        if (nalUnitType == 7) {
+            type = PARAMETER_SET_SPS;
+            if (!reader.SkipBits(24) || !reader.ReadUe(id)) {
+                return false;
+            }
+        } else if (nalUnitType == 8) {
+            type = PARAMETER_SET_PPS;
+            if (!reader.ReadUe(id)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    key = (type << 16) | (id & 0xffff);
+    return true;
+}
+
+// Returns the offset of the next 00.00.01 start code at or after pos, or size.
+int64_t FindStartCode(const uint8_t* pData, int64_t pos, int64_t size)
+{
+    while ((pos + 3) <= size) {
+        const uint8_t* pOne = (const uint8_t*)memchr(pData + pos + 2, 1, (size_t)(size - pos - 2));
+        if (pOne == nullptr) {
+            break;
+        }
+        const int64_t i = pOne - pData;
+        if ((pData[i - 1] == 0) && (pData[i - 2] == 0)) {
+            return i - 2;
+        }
+        pos = i - 1;
+    }
+    return size;
+}
+
+void AddAnnexBSegment(int64_t begin, int64_t end, int64_t chunkSize,
+                      std::vector<uint8_t>& parameterSets, uint32_t numParameterSets,
+                      std::vector<VkStreamSegment>& segments)
+{
+    segments.push_back(VkStreamSegment());
+    VkStreamSegment& segment = segments.back();
+    segment.parameterSets.swap(parameterSets);
+    segment.numParameterSets = numParameterSets;
+    segment.size = end - begin;
+    for (int64_t offset = begin; offset < end; offset += chunkSize) {
+        VkStreamPacket packet;
+        packet.offset = offset;
+        packet.size = (size_t)std::min<int64_t>(chunkSize, end - offset);
+        packet.endOfPicture = false;
+        segment.packets.push_back(packet);
+    }
+}
+
+// Returns the number of bytes of a leb128() value, 0 if it is truncated.
+uint32_t ReadLeb128(const uint8_t* pData, size_t size, uint64_t& value)
+{
+    value = 0;
+    for (uint32_t i = 0; (i < 8) && (i < size); i++) {
+        value |= (uint64_t)(pData[i] & 0x7f) << (i * 7);
+        if (!(pData[i] & 0x80)) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// A temporal unit is a closed-GOP random access point if it carries a
+// sequence header and its first frame is a shown key frame, which refreshes
+// all the reference slots.
+bool IsAv1RandomAccessPoint(const uint8_t* pData, size_t size)
+{
+    const uint32_t obuSequenceHeader = 1, obuFrameHeader = 3, obuFrame = 6;
+
+    bool hasSequenceHeader = false;
+    bool reducedStillPictureHeader = false;
+    size_t offset = 0;
+    while (offset < size) {
+        const uint8_t obuHeader = pData[offset];
+        const uint32_t obuType = (obuHeader >> 3) & 0xF;
+        const bool hasExtension = (obuHeader >> 2) & 1;
+        const bool hasSizeField = (obuHeader >> 1) & 1;
+        size_t pos = offset + 1 + (hasExtension ? 1 : 0);
+        uint64_t obuSize = size - std::min<size_t>(pos, size);
+        if (hasSizeField) {
+            const uint32_t lebSize = (pos < size) ? ReadLeb128(pData + pos, size - pos, obuSize) : 0;
+            if (lebSize == 0) {
+                return false;
+            }
+            pos += lebSize;
+        }
+        if ((pos >= size) || (obuSize > (size - pos))) {
+            return false;
+        }
+
+        if (obuType == obuSequenceHeader) {
+            // seq_profile (3), still_picture (1), reduced_still_picture_header (1)
+            hasSequenceHeader = true;
+            reducedStillPictureHeader = (pData[pos] >> 3) & 1;
+        } else if ((obuType == obuFrameHeader) || (obuType == obuFrame)) {
+            if (!hasSequenceHeader) {
+                return false;
+            }
+            if (reducedStillPictureHeader) {
+                return true;    // Always a shown key frame
+            }
+            // show_existing_frame (1), frame_type (2), show_frame (1)
+            const uint8_t bits = pData[pos];
+            const bool showExistingFrame = (bits >> 7) & 1;
+            const uint32_t frameType = (bits >> 5) & 3;
+            const bool showFrame = (bits >> 4) & 1;
+            return !showExistingFrame && (frameType == 0) && showFrame;
+        }
+        offset = pos + (size_t)obuSize;
+    }
+    return false;
+}
+
+// A VP9 frame or superframe that starts with a key frame: it resets the
+// probability contexts and refreshes all the reference slots.
+bool IsVp9RandomAccessPoint(const uint8_t* pData, size_t size)
+{
+    if (size < 1) {
+        return false;
+    }
+    // frame_marker (2), profile_low_bit (1), profile_high_bit (1),
+    // reserved_zero (1, profile 3), show_existing_frame (1), frame_type (1)
+    const uint8_t bits = pData[0];
+    if ((bits >> 6) != 2) {
+        return false;
+    }
+    const uint32_t profile = ((bits >> 5) & 1) | (((bits >> 4) & 1) << 1);
+    const uint32_t pos = (profile == 3) ? 2 : 3;
+    const bool showExistingFrame = (bits >> pos) & 1;
+    const uint32_t frameType = (bits >> (pos - 1)) & 1;
+    return !showExistingFrame && (frameType == 0);
+}
+
+void AddAv1Segment(const std::vector<VkStreamPacket>& temporalUnits, size_t begin, size_t end,
+                   std::vector<VkStreamSegment>& segments)
+{
+    segments.push_back(VkStreamSegment());
+    VkStreamSegment& segment = segments.back();
+    segment.numParameterSets = 0;
+    segment.packets.assign(temporalUnits.begin() + begin, temporalUnits.begin() + end);
+    segment.size = 0;
+    for (size_t i = begin; i < end; i++) {
+        segment.size += temporalUnits[i].size;
+    }
+}
+
+bool IsSameFrameRecord(const VkStreamAnalyzerFrameRecord& a, const VkStreamAnalyzerFrameRecord& b)
+{
+    return (a.decodeIndex == b.decodeIndex) && (a.sequenceIndex == b.sequenceIndex) &&
+           (a.frameType == b.frameType) && (a.isReference == b.isReference) && (a.isShown == b.isShown) &&
+           (a.isFieldPicture == b.isFieldPicture) && (a.sizeInBytes == b.sizeInBytes) &&
+           (a.numSlices == b.numSlices) && (a.qp == b.qp) && (a.orderCount == b.orderCount) &&
+           (a.numReferences == b.numReferences) && (a.numParameterSetUpdates == b.numParameterSetUpdates) &&
+           (a.width == b.width) && (a.height == b.height) && (a.numMetadata == b.numMetadata) &&
+           (a.metadataBytes == b.metadataBytes) && (a.metadataTypes == b.metadataTypes) &&
+           (a.numSliceRecords == b.numSliceRecords) && (a.numEntryPoints == b.numEntryPoints) &&
+           (a.minSliceQp == b.minSliceQp) && (a.maxSliceQp == b.maxSliceQp) &&
+           ((a.numSliceRecords == 0) ||
+            !memcmp(a.pSlices, b.pSlices, a.numSliceRecords * sizeof(VkStreamAnalyzerSliceRecord))) &&
+           ((a.numEntryPoints == 0) || !memcmp(a.pEntryPoints, b.pEntryPoints, a.numEntryPoints * sizeof(uint32_t)));
+}
+
+VkResult ParseSegment(VkVideoCodecOperationFlagBitsKHR codec, const uint8_t* pData,
+                      const VkStreamSegment& segment, const VkVideoStreamAnalyzer::ParserOptions& parserOptions,
+                      VkStreamAnalyzerWriter* pWriter, VkVideoStreamAnalyzer::Stats& stats)
+{
+    VkSharedBaseObj<VkVideoStreamAnalyzer> analyzer;
+    VkResult result = VkVideoStreamAnalyzer::Create(codec, pWriter, parserOptions, analyzer);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    if (!segment.parameterSets.empty()) {
+        result = analyzer->ParseData(segment.parameterSets.data(), segment.parameterSets.size(), false, false);
+    }
+    for (size_t i = 0; (i < segment.packets.size()) && (result == VK_SUCCESS); i++) {
+        const VkStreamPacket& packet = segment.packets[i];
+        result = analyzer->ParseData(pData + packet.offset, packet.size, packet.endOfPicture, false);
+    }
+    if (result == VK_SUCCESS) {
+        result = analyzer->ParseData(nullptr, 0, true, true);
+    }
+
+    stats = analyzer->GetStats();
+    return result;
+}
+
+} // namespace
+
+void VkStreamAnalyzerRecordBuffer::WriteSequence(uint32_t, const VkParserSequenceInfo* pSeqInfo)
+{
+    m_sequences.push_back(*pSeqInfo);
+    m_sequenceFramePos.push_back(m_frames.size());
+}
+
+void VkStreamAnalyzerRecordBuffer::WriteFrame(const VkStreamAnalyzerFrameRecord& record)
+{
+    m_frameSlicePos.push_back(std::make_pair(m_slices.size(), m_entryPoints.size()));
+    m_slices.insert(m_slices.end(), record.pSlices, record.pSlices + record.numSliceRecords);
+    m_entryPoints.insert(m_entryPoints.end(), record.pEntryPoints, record.pEntryPoints + record.numEntryPoints);
+    m_frames.push_back(record);
+    m_frames.back().pSlices = nullptr;
+    m_frames.back().pEntryPoints = nullptr;
+}
+
+VkStreamAnalyzerFrameRecord VkStreamAnalyzerRecordBuffer::GetFrame(size_t frame) const
+{
+    VkStreamAnalyzerFrameRecord record = m_frames[frame];
+    if (record.numSliceRecords > 0) {
+        record.pSlices = &m_slices[m_frameSlicePos[frame].first];
+    }
+    if (record.numEntryPoints > 0) {
+        record.pEntryPoints = &m_entryPoints[m_frameSlicePos[frame].second];
+    }
+    return record;
+}
+
+void VkStreamAnalyzerRecordBuffer::Replay(VkStreamAnalyzerWriter* pWriter) const
+{
+    size_t frame = 0;
+    for (size_t seq = 0; seq <= m_sequences.size(); seq++) {
+        const size_t frameEnd = (seq < m_sequences.size()) ? m_sequenceFramePos[seq] : m_frames.size();
+        for (; frame < frameEnd; frame++) {
+            pWriter->WriteFrame(GetFrame(frame));
+        }
+        if (seq < m_sequences.size()) {
+            pWriter->WriteSequence((uint32_t)seq, &m_sequences[seq]);
+        }
+    }
+}
+
+bool VkStreamAnalyzerRecordBuffer::Compare(const VkStreamAnalyzerRecordBuffer& other, std::string& difference) const
+{
+    char message[256];
+    if ((m_sequences.size() != other.m_sequences.size()) || (m_frames.size() != other.m_frames.size())) {
+        snprintf(message, sizeof(message), "%u sequence(s) and %u picture(s) instead of %u and %u",
+                 (uint32_t)m_sequences.size(), (uint32_t)m_frames.size(),
+                 (uint32_t)other.m_sequences.size(), (uint32_t)other.m_frames.size());
+        difference = message;
+        return false;
+    }
+    for (size_t seq = 0; seq < m_sequences.size(); seq++) {
+        if ((m_sequenceFramePos[seq] != other.m_sequenceFramePos[seq]) ||
+                memcmp(&m_sequences[seq], &other.m_sequences[seq], sizeof(VkParserSequenceInfo))) {
+            snprintf(message, sizeof(message), "sequence %u differs", (uint32_t)seq);
+            difference = message;
+            return false;
+        }
+    }
+    for (size_t frame = 0; frame < m_frames.size(); frame++) {
+        if (!IsSameFrameRecord(GetFrame(frame), other.GetFrame(frame))) {
+            snprintf(message, sizeof(message), "picture %u differs", (uint32_t)frame);
+            difference = message;
+            return false;
+        }
+    }
+    return true;
+}
+
+void VkStreamSegmentParser::SplitAnnexB(VkVideoCodecOperationFlagBitsKHR codec, const uint8_t* pData, int64_t size,
+                                        int64_t minSegmentSize, int64_t chunkSize,
+                                        std::vector<VkStreamSegment>& segments)
+{
+    struct NalRange {
+        int64_t offset;
+        int64_t size;
+    };
+
+    const bool isH265 = (codec == VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR);
+    const uint32_t nalHeaderSize = isH265 ? 2 : 1;
+
+    segments.clear();
+
+    // Latest NAL unit of every parameter set, and the ones of the access unit being scanned,
+    // which only become active for the segments starting after it.
+    std::map<uint32_t, NalRange> parameterSets;
+    std::vector<std::pair<uint32_t, NalRange>> accessUnitParameterSets;
+    uint32_t accessUnitParameterSetTypes = 0;
+    int64_t accessUnitStart = -1;   // First NAL unit after the last VCL NAL unit
+
+    std::vector<uint8_t> segmentParameterSets;
+    uint32_t segmentNumParameterSets = 0;
+    int64_t segmentStart = 0;
+
+    int64_t startCode = FindStartCode(pData, 0, size);
+    while (startCode < size) {
+        const int64_t nalStart = startCode + 3;
+        const int64_t nextStartCode = FindStartCode(pData, nalStart, size);
+        int64_t nalEnd = nextStartCode;
+        while ((nalEnd > nalStart) && (pData[nalEnd - 1] == 0)) {
+            nalEnd--;   // trailing_zero_8bits
+        }
+        if ((nalEnd - nalStart) <= nalHeaderSize) {
+            startCode = nextStartCode;
+            continue;
+        }
+
+        const uint8_t* pNal = pData + nalStart;
+        const uint32_t nalUnitType = isH265 ? ((pNal[0] >> 1) & 0x3f) : (pNal[0] & 0x1f);
+        const bool isVcl = isH265 ? (nalUnitType < 32) : ((nalUnitType >= 1) && (nalUnitType <= 5));
+        if (isVcl) {
+            // first_mb_in_slice == 0, first_slice_segment_in_pic_flag == 1
+            const bool firstSlice = (pNal[nalHeaderSize] & 0x80) != 0;
+            const bool isIdr = isH265 ? (((nalUnitType == 19) || (nalUnitType == 20)) && ((pNal[0] & 1) == 0) && ((pNal[1] >> 3) == 0)) :
+                                        (nalUnitType == 5);
+            const uint32_t requiredTypes = isH265 ? ((1 << PARAMETER_SET_VPS) | (1 << PARAMETER_SET_SPS) | (1 << PARAMETER_SET_PPS)) :
+                                                    ((1 << PARAMETER_SET_SPS) | (1 << PARAMETER_SET_PPS));
+            if (isIdr && firstSlice && ((accessUnitParameterSetTypes & requiredTypes) == requiredTypes)) {
+                const int64_t cut = (accessUnitStart >= 0) ? accessUnitStart : startCode;
+                if ((cut - segmentStart) >= minSegmentSize) {
+                    AddAnnexBSegment(segmentStart, cut, chunkSize, segmentParameterSets, segmentNumParameterSets, segments);
+                    segmentStart = cut;
+                    // Seed the parameter sets active before the access unit, it updates them itself.
+                    segmentParameterSets.clear();
+                    segmentNumParameterSets = (uint32_t)parameterSets.size();
+                    for (std::map<uint32_t, NalRange>::const_iterator it = parameterSets.begin(); it != parameterSets.end(); ++it) {
+                        static const uint8_t startCodePrefix[] = { 0, 0, 0, 1 };
+                        segmentParameterSets.insert(segmentParameterSets.end(), startCodePrefix, startCodePrefix + sizeof(startCodePrefix));
+                        segmentParameterSets.insert(segmentParameterSets.end(), pData + it->second.offset,
+                                                    pData + it->second.offset + it->second.size);
+                    }
+                }
+            }
+            for (size_t i = 0; i < accessUnitParameterSets.size(); i++) {
+                parameterSets[accessUnitParameterSets[i].first] = accessUnitParameterSets[i].second;
+            }
+            accessUnitParameterSets.clear();
+            accessUnitParameterSetTypes = 0;
+            accessUnitStart = -1;
+        } else {
+            const bool startsAccessUnit = isH265 ?
+                    (((nalUnitType >= 32) && (nalUnitType <= 35)) || (nalUnitType == 39) ||
+                     ((nalUnitType >= 41) && (nalUnitType <= 44)) || ((nalUnitType >= 48) && (nalUnitType <= 55))) :
+                    ((nalUnitType >= 6) && (nalUnitType <= 9)) || ((nalUnitType >= 14) && (nalUnitType <= 18));
+            if (startsAccessUnit && (accessUnitStart < 0)) {
+                accessUnitStart = startCode;
+            }
+            uint32_t key = 0;
+            if (GetParameterSetKey(isH265, pNal, (size_t)(nalEnd - nalStart), key)) {
+                NalRange range = { nalStart, nalEnd - nalStart };
+                accessUnitParameterSets.push_back(std::make_pair(key, range));
+                accessUnitParameterSetTypes |= 1 << (key >> 16);
+            }
+        }
+        startCode = nextStartCode;
+    }
+
+    if ((size > segmentStart) || segments.empty()) {
+        AddAnnexBSegment(segmentStart, size, chunkSize, segmentParameterSets, segmentNumParameterSets, segments);
+    }
+}
+
+void VkStreamSegmentParser::SplitAv1(const uint8_t* pData, const std::vector<VkStreamPacket>& temporalUnits,
+                                     int64_t minSegmentSize, std::vector<VkStreamSegment>& segments)
+{
+    segments.clear();
+
+    size_t segmentStart = 0;
+    int64_t segmentSize = 0;
+    for (size_t i = 0; i < temporalUnits.size(); i++) {
+        if ((segmentSize >= minSegmentSize) && (i > segmentStart) &&
+                IsAv1RandomAccessPoint(pData + temporalUnits[i].offset, temporalUnits[i].size)) {
+            AddAv1Segment(temporalUnits, segmentStart, i, segments);
+            segmentStart = i;
+            segmentSize = 0;
+        }
+        segmentSize += temporalUnits[i].size;
+    }
+    AddAv1Segment(temporalUnits, segmentStart, temporalUnits.size(), segments);
+}
+
+void VkStreamSegmentParser::SplitVp9(const uint8_t* pData, const std::vector<VkStreamPacket>& frames,
+                                     int64_t minSegmentSize, std::vector<VkStreamSegment>& segments)
+{
+    segments.clear();
+
+    size_t segmentStart = 0;
+    int64_t segmentSize = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        if ((segmentSize >= minSegmentSize) && (i > segmentStart) &&
+                IsVp9RandomAccessPoint(pData + frames[i].offset, frames[i].size)) {
+            AddAv1Segment(frames, segmentStart, i, segments);
+            segmentStart = i;
+            segmentSize = 0;
+        }
+        segmentSize += frames[i].size;
+    }
+    AddAv1Segment(frames, segmentStart, frames.size(), segments);
+}
+
+VkResult VkStreamSegmentParser::Parse(VkVideoCodecOperationFlagBitsKHR codec, const uint8_t* pData,
+                                      const std::vector<VkStreamSegment>& segments, uint32_t numThreads,
+                                      const VkVideoStreamAnalyzer::ParserOptions& parserOptions, VkStreamAnalyzerWriter* pWriter,
+                                      VkVideoStreamAnalyzer::Stats& stats)
+{
+    const size_t numSegments = segments.size();
+    std::vector<VkStreamAnalyzerRecordBuffer> records(numSegments);
+    std::vector<VkVideoStreamAnalyzer::Stats> segmentStats(numSegments);
+    std::vector<VkResult> results(numSegments, VK_SUCCESS);
+
+    // The segments are handed out in stream order, the first ones are merged first.
+    std::atomic<size_t> nextSegment(0);
+    std::vector<std::thread> threads;
+    numThreads = std::max<uint32_t>(1, std::min<uint32_t>(numThreads, (uint32_t)numSegments));
+    for (uint32_t t = 0; t < numThreads; t++) {
+        threads.push_back(std::thread([&]() {
+            for (size_t i = nextSegment++; i < numSegments; i = nextSegment++) {
+                memset(&segmentStats[i], 0, sizeof(segmentStats[i]));
+                results[i] = ParseSegment(codec, pData, segments[i], parserOptions, &records[i], segmentStats[i]);
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    // Merge the records: renumber the pictures and the sequences, and skip the
+    // sequence record that starts a segment when the sequence did not change.
+    memset(&stats, 0, sizeof(stats));
+    uint64_t decodeIndex = 0;
+    uint32_t numSequences = 0;
+    const VkParserSequenceInfo* pPrevSequence = nullptr;
+    for (size_t i = 0; i < numSegments; i++) {
+        if (results[i] != VK_SUCCESS) {
+            fprintf(stderr, "Stream analyzer: parsing of segment %u failed, error %d\n", (uint32_t)i, results[i]);
+            return results[i];
+        }
+
+        const VkStreamAnalyzerRecordBuffer& segmentRecords = records[i];
+        std::vector<uint32_t> sequenceIndices(segmentRecords.m_sequences.size());
+        size_t frame = 0;
+        for (size_t seq = 0; seq <= segmentRecords.m_sequences.size(); seq++) {
+            const size_t frameEnd = (seq < segmentRecords.m_sequences.size()) ?
+                    segmentRecords.m_sequenceFramePos[seq] : segmentRecords.m_frames.size();
+            for (; frame < frameEnd; frame++) {
+                VkStreamAnalyzerFrameRecord record = segmentRecords.GetFrame(frame);
+                record.decodeIndex = decodeIndex++;
+                record.sequenceIndex = (record.sequenceIndex < sequenceIndices.size()) ?
+                        sequenceIndices[record.sequenceIndex] : ((numSequences > 0) ? (numSequences - 1) : 0);
+                if (pWriter) {
+                    pWriter->WriteFrame(record);
+                }
+            }
+            if (seq == segmentRecords.m_sequences.size()) {
+                break;
+            }
+            const VkParserSequenceInfo* pSequence = &segmentRecords.m_sequences[seq];
+            if ((seq == 0) && (pPrevSequence != nullptr) &&
+                    !memcmp(pSequence, pPrevSequence, sizeof(VkParserSequenceInfo))) {
+                sequenceIndices[seq] = numSequences - 1;
+            } else {
+                if (pWriter) {
+                    pWriter->WriteSequence(numSequences, pSequence);
+                }
+                sequenceIndices[seq] = numSequences++;
+            }
+            pPrevSequence = pSequence;
+        }
+
+        const VkVideoStreamAnalyzer::Stats& s = segmentStats[i];
+        stats.numFrames += s.numFrames;
+        stats.numKeyFrames += s.numKeyFrames;
+        stats.numIntraFrames += s.numIntraFrames;
+        stats.numInterFrames += s.numInterFrames;
+        stats.numDisplayedFrames += s.numDisplayedFrames;
+        stats.totalFrameBytes += s.totalFrameBytes;
+        stats.maxFrameBytes = std::max(stats.maxFrameBytes, s.maxFrameBytes);
+        // The seeded parameter sets are not part of the stream.
+        stats.numParameterSetUpdates += s.numParameterSetUpdates - std::min(s.numParameterSetUpdates, segments[i].numParameterSets);
+        stats.numBitstreamBuffers = std::max(stats.numBitstreamBuffers, s.numBitstreamBuffers);
+        stats.numMetadata += s.numMetadata;
+        stats.totalMetadataBytes += s.totalMetadataBytes;
+        if (s.numSliceSegments > 0) {
+            stats.minSliceQp = (stats.numSliceSegments == 0) ? s.minSliceQp : std::min(stats.minSliceQp, s.minSliceQp);
+            stats.maxSliceQp = (stats.numSliceSegments == 0) ? s.maxSliceQp : std::max(stats.maxSliceQp, s.maxSliceQp);
+        }
+        stats.numSliceSegments += s.numSliceSegments;
+        stats.numEntryPoints += s.numEntryPoints;
+        stats.totalSliceQp += s.totalSliceQp;
+        // Per parser instance
+        stats.parserFootprint.parserSize = std::max(stats.parserFootprint.parserSize, s.parserFootprint.parserSize);
+        stats.parserFootprint.onDemandSize = std::max(stats.parserFootprint.onDemandSize, s.parserFootprint.onDemandSize);
+        stats.parserFootprint.parameterSetsSize = std::max(stats.parserFootprint.parameterSetsSize,
+                                                           s.parserFootprint.parameterSetsSize);
+        VkParserAddTelemetry(&stats.parserTelemetry, &s.parserTelemetry);
+        if (s.frameRateDenominator != 0) {
+            stats.frameRateNumerator = s.frameRateNumerator;
+            stats.frameRateDenominator = s.frameRateDenominator;
+        }
+    }
+    stats.numSequences = numSequences;
+
+    return VK_SUCCESS;
+}
@@ -0,0 +1,118 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _VKSTREAMSEGMENTPARSER_H_
+#define _VKSTREAMSEGMENTPARSER_H_
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "VkVideoStreamAnalyzer/VkVideoStreamAnalyzer.h"
+
+// A range of the input passed to one VkVideoStreamAnalyzer::ParseData() call.
+struct VkStreamPacket {
+    int64_t offset;
+    size_t  size;
+    bool    endOfPicture;
+};
+
+// A part of the stream that starts at a closed-GOP random access point: an
+// H.264/H.265 IDR access unit carrying its SPS and PPS (and VPS), or an AV1
+// temporal unit with a sequence header and a shown key frame. The other
+// parameter sets active at that point are seeded ahead of the first packet.
+// A VP9 segment starts with a key frame and has no parameter sets.
+struct VkStreamSegment {
+    std::vector<uint8_t>        parameterSets;      // Annex B NAL units, parsed before the packets
+    uint32_t                    numParameterSets;
+    std::vector<VkStreamPacket> packets;
+    int64_t                     size;               // Bytes of the input covered by the packets
+};
+
+// Keeps the analyzer records in memory, for merging and comparing them.
+class VkStreamAnalyzerRecordBuffer : public VkStreamAnalyzerWriter {
+
+public:
+
+    VkStreamAnalyzerRecordBuffer()
+        : VkStreamAnalyzerWriter(nullptr, FORMAT_JSON_LINES)
+        , m_sequences()
+        , m_sequenceFramePos()
+        , m_frames()
+        , m_frameSlicePos()
+        , m_slices()
+        , m_entryPoints() { }
+
+    virtual void WriteSequence(uint32_t sequenceIndex, const VkParserSequenceInfo* pSeqInfo);
+    virtual void WriteFrame(const VkStreamAnalyzerFrameRecord& record);
+
+    // Writes the records, in the order they were received, to another writer.
+    void Replay(VkStreamAnalyzerWriter* pWriter) const;
+
+    // Returns false and describes the first difference if the records differ.
+    bool Compare(const VkStreamAnalyzerRecordBuffer& other, std::string& difference) const;
+
+    size_t GetNumFrames() const { return m_frames.size(); }
+
+    // The frame record, pointing to the slice records kept with it.
+    VkStreamAnalyzerFrameRecord GetFrame(size_t frame) const;
+
+private:
+    friend class VkStreamSegmentParser;
+
+    std::vector<VkParserSequenceInfo>        m_sequences;
+    std::vector<size_t>                      m_sequenceFramePos;   // Frames received before each sequence
+    std::vector<VkStreamAnalyzerFrameRecord> m_frames;
+    std::vector<std::pair<size_t, size_t>>   m_frameSlicePos;      // First slice record and entry point of each frame
+    std::vector<VkStreamAnalyzerSliceRecord> m_slices;
+    std::vector<uint32_t>                    m_entryPoints;
+};
+
+// Segment-parallel parsing of a single elementary stream: the stream is cut
+// at closed-GOP random access points, every segment is parsed by its own
+// VkVideoStreamAnalyzer on a pool of threads, and the records are merged back
+// into the decode order of the whole stream. The merged records are the same
+// as the ones of a serial parse: the decode and sequence indices are
+// renumbered, and a segment does not repeat the sequence record of the
+// previous one when its sequence is unchanged.
+class VkStreamSegmentParser {
+
+public:
+
+    // Cuts an H.264/H.265 Annex B stream into segments of at least
+    // minSegmentSize bytes, fed to the parser in chunkSize packets.
+    static void SplitAnnexB(VkVideoCodecOperationFlagBitsKHR codec, const uint8_t* pData, int64_t size,
+                            int64_t minSegmentSize, int64_t chunkSize,
+                            std::vector<VkStreamSegment>& segments);
+
+    // Cuts a list of AV1 temporal units into segments of at least minSegmentSize bytes.
+    static void SplitAv1(const uint8_t* pData, const std::vector<VkStreamPacket>& temporalUnits,
+                         int64_t minSegmentSize, std::vector<VkStreamSegment>& segments);
+
+    // Cuts a list of VP9 frames (IVF frames, superframes included) at key frames.
+    static void SplitVp9(const uint8_t* pData, const std::vector<VkStreamPacket>& frames,
+                         int64_t minSegmentSize, std::vector<VkStreamSegment>& segments);
+
+    // Parses the segments on numThreads threads and writes the merged records
+    // to pWriter. stats receives the totals of all the segments.
+    static VkResult Parse(VkVideoCodecOperationFlagBitsKHR codec, const uint8_t* pData,
+                          const std::vector<VkStreamSegment>& segments, uint32_t numThreads,
+                          const VkVideoStreamAnalyzer::ParserOptions& parserOptions, VkStreamAnalyzerWriter* pWriter,
+                          VkVideoStreamAnalyzer::Stats& stats);
+};
+
+#endif /* _VKSTREAMSEGMENTPARSER_H_ */
@@ -0,0 +1,703 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <algorithm>
+#include <string.h>
+#include <stdarg.h>
+
+#include "VkVideoStreamAnalyzer/VkVideoStreamAnalyzer.h"
+#include "vkvideo_parser/StdVideoPictureParametersSet.h"
+#include "NvVideoParser/nvVulkanVideoParser.h"
+#include "NvVideoParser/nvVulkanVideoUtils.h"
+
+// Same default as the decoder: the parser grows the buffer on demand.
+static const VkDeviceSize defaultMinBufferSize = 2 * 1024 * 1024;
+static const VkDeviceSize bitstreamBufferAlignment = 256;
+static const uint32_t maxBitstreamBuffers = 8;
+
+static void nvParserLog(const char* format, ...)
+{
+    va_list argptr;
+    va_start(argptr, format);
+    vfprintf(stderr, format, argptr);
+    va_end(argptr);
+}
+
+const char* VkStreamAnalyzerWriter::GetCodecName(VkVideoCodecOperationFlagBitsKHR codec)
+{
+    switch ((uint32_t)codec) {
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR:
+        return "h264";
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR:
+        return "h265";
+    case VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR:
+        return "av1";
+    case VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR:
+        return "vp9";
+    default:
+        break;
+    }
+    return "unknown";
+}
+
+const char* VkStreamAnalyzerWriter::GetFrameTypeName(VkStreamAnalyzerFrameRecord::FrameType frameType)
+{
+    switch (frameType) {
+    case VkStreamAnalyzerFrameRecord::FRAME_TYPE_KEY:
+        return "key";
+    case VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTRA:
+        return "intra";
+    case VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTER:
+        return "inter";
+    case VkStreamAnalyzerFrameRecord::FRAME_TYPE_SWITCH:
+        return "switch";
+    default:
+        break;
+    }
+    return "unknown";
+}
+
+const char* VkStreamAnalyzerWriter::GetMetadataTypeName(VkParserMetadataType type)
+{
+    switch (type) {
+    case VK_PARSER_METADATA_TYPE_PICTURE_TIMING:
+        return "picTiming";
+    case VK_PARSER_METADATA_TYPE_TIMECODE:
+        return "timecode";
+    case VK_PARSER_METADATA_TYPE_MASTERING_DISPLAY:
+        return "masteringDisplay";
+    case VK_PARSER_METADATA_TYPE_CONTENT_LIGHT_LEVEL:
+        return "contentLightLevel";
+    case VK_PARSER_METADATA_TYPE_HDR10PLUS:
+        return "hdr10plus";
+    case VK_PARSER_METADATA_TYPE_CLOSED_CAPTIONS:
+        return "closedCaptions";
+    case VK_PARSER_METADATA_TYPE_ITU_T_T35:
+        return "t35";
+    case VK_PARSER_METADATA_TYPE_USER_DATA_UNREGISTERED:
+        return "userDataUnregistered";
+    case VK_PARSER_METADATA_TYPE_SCALABILITY:
+        return "scalability";
+    case VK_PARSER_METADATA_TYPE_USER_PRIVATE:
+        return "userPrivate";
+    default:
+        break;
+    }
+    return "unknown";
+}
+
+static const char* GetSliceTypeName(uint32_t sliceType)
+{
+    static const char* sliceTypeNames[] = { "B", "P", "I" };
+    return (sliceType < 3) ? sliceTypeNames[sliceType] : "unknown";
+}
+
+// Writes the names of the metadata types set in the mask, separated by sep.
+static void WriteMetadataTypes(FILE* fp, uint32_t metadataTypes, const char* sep, const char* quote)
+{
+    const char* prefix = "";
+    for (uint32_t type = 0; type < 32; type++) {
+        if (metadataTypes & (1u << type)) {
+            fprintf(fp, "%s%s%s%s", prefix, quote,
+                    VkStreamAnalyzerWriter::GetMetadataTypeName((VkParserMetadataType)type), quote);
+            prefix = sep;
+        }
+    }
+}
+
+void VkStreamAnalyzerWriter::WriteSequence(uint32_t sequenceIndex, const VkParserSequenceInfo* pSeqInfo)
+{
+    // CSV output only carries the per-frame table, the sequence index column links the two.
+    if (m_format != FORMAT_JSON_LINES) {
+        return;
+    }
+
+    fprintf(m_fp, "{\"record\":\"sequence\",\"seq\":%u,\"codec\":\"%s\",\"codedWidth\":%d,\"codedHeight\":%d,"
+                  "\"displayWidth\":%d,\"displayHeight\":%d,\"chromaFormat\":%u,\"lumaBitDepth\":%u,\"chromaBitDepth\":%u,"
+                  "\"frameRateNum\":%u,\"frameRateDen\":%u,\"profile\":%u,\"minDecodeSurfaces\":%d,\"minDpbSlots\":%d}\n",
+            sequenceIndex, GetCodecName(pSeqInfo->eCodec), pSeqInfo->nCodedWidth, pSeqInfo->nCodedHeight,
+            pSeqInfo->nDisplayWidth, pSeqInfo->nDisplayHeight, pSeqInfo->nChromaFormat,
+            pSeqInfo->uBitDepthLumaMinus8 + 8, pSeqInfo->uBitDepthChromaMinus8 + 8,
+            NV_FRAME_RATE_NUM(pSeqInfo->frameRate), NV_FRAME_RATE_DEN(pSeqInfo->frameRate),
+            pSeqInfo->codecProfile, pSeqInfo->nMinNumDecodeSurfaces, pSeqInfo->nMinNumDpbSlots);
+}
+
+void VkStreamAnalyzerWriter::WriteFrame(const VkStreamAnalyzerFrameRecord& record)
+{
+    if (m_format == FORMAT_CSV) {
+        if (!m_headerWritten) {
+            fprintf(m_fp, "decode_index,seq,type,ref,shown,field,size,slices,qp,order,num_refs,param_set_updates,width,height,"
+                          "metadata,metadata_bytes,metadata_types,entry_points,slice_qp_min,slice_qp_max\n");
+            m_headerWritten = true;
+        }
+        fprintf(m_fp, "%llu,%u,%s,%u,%u,%u,%u,%u,%d,%d,%u,%u,%d,%d,%u,%u,",
+                (unsigned long long)record.decodeIndex, record.sequenceIndex,
+                GetFrameTypeName(record.frameType), record.isReference, record.isShown, record.isFieldPicture,
+                record.sizeInBytes, record.numSlices, record.qp, record.orderCount,
+                record.numReferences, record.numParameterSetUpdates, record.width, record.height,
+                record.numMetadata, record.metadataBytes);
+        WriteMetadataTypes(m_fp, record.metadataTypes, "|", "");
+        if (record.numSliceRecords > 0) {
+            fprintf(m_fp, ",%u,%d,%d\n", record.numEntryPoints, record.minSliceQp, record.maxSliceQp);
+        } else {
+            fprintf(m_fp, ",,,\n");
+        }
+    } else {
+        fprintf(m_fp, "{\"record\":\"frame\",\"n\":%llu,\"seq\":%u,\"type\":\"%s\",\"ref\":%u,\"shown\":%u,\"field\":%u,"
+                      "\"size\":%u,\"slices\":%u,\"qp\":%d,\"order\":%d,\"numRefs\":%u,\"paramSetUpdates\":%u,"
+                      "\"width\":%d,\"height\":%d",
+                (unsigned long long)record.decodeIndex, record.sequenceIndex,
+                GetFrameTypeName(record.frameType), record.isReference, record.isShown, record.isFieldPicture,
+                record.sizeInBytes, record.numSlices, record.qp, record.orderCount,
+                record.numReferences, record.numParameterSetUpdates, record.width, record.height);
+        if (record.numMetadata > 0) {
+            fprintf(m_fp, ",\"metadata\":%u,\"metadataBytes\":%u,\"metadataTypes\":[",
+                    record.numMetadata, record.metadataBytes);
+            WriteMetadataTypes(m_fp, record.metadataTypes, ",", "\"");
+            fprintf(m_fp, "]");
+        }
+        if (record.numSliceRecords > 0) {
+            fprintf(m_fp, ",\"entryPoints\":%u,\"sliceQpMin\":%d,\"sliceQpMax\":%d",
+                    record.numEntryPoints, record.minSliceQp, record.maxSliceQp);
+        }
+        fprintf(m_fp, "}\n");
+        if (m_sliceRecords) {
+            const uint32_t* pEntryPoints = record.pEntryPoints;
+            for (uint32_t i = 0; i < record.numSliceRecords; i++) {
+                const VkStreamAnalyzerSliceRecord& slice = record.pSlices[i];
+                fprintf(m_fp, "{\"record\":\"slice\",\"n\":%llu,\"slice\":%u,\"address\":%u,\"type\":\"%s\",\"dependent\":%u,"
+                              "\"qp\":%d,\"dataOffset\":%u,\"dataSize\":%u,\"entryPoints\":[",
+                        (unsigned long long)record.decodeIndex, i, slice.address, GetSliceTypeName(slice.sliceType),
+                        slice.isDependent, slice.qp, slice.dataOffset, slice.dataSize);
+                for (uint32_t j = 0; j < slice.numEntryPoints; j++) {
+                    fprintf(m_fp, (j == 0) ? "%u" : ",%u", pEntryPoints[j]);
+                }
+                fprintf(m_fp, "]}\n");
+                pEntryPoints += slice.numEntryPoints;
+            }
+        }
+    }
+}
+
+VkResult VkVideoStreamAnalyzer::Create(VkVideoCodecOperationFlagBitsKHR codec,
+                                       VkStreamAnalyzerWriter* pWriter,
+                                       const ParserOptions& parserOptions,
+                                       VkSharedBaseObj<VkVideoStreamAnalyzer>& streamAnalyzer)
+{
+    VkSharedBaseObj<VkVideoStreamAnalyzer> analyzer(new VkVideoStreamAnalyzer(codec, pWriter));
+    if (!analyzer) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    VkResult result = analyzer->Initialize(parserOptions);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    streamAnalyzer = analyzer;
+    return VK_SUCCESS;
+}
+
+VkVideoStreamAnalyzer::VkVideoStreamAnalyzer(VkVideoCodecOperationFlagBitsKHR codec, VkStreamAnalyzerWriter* pWriter)
+    : m_refCount(0)
+    , m_codec(codec)
+    , m_pWriter(pWriter)
+    , m_parser()
+    , m_bitstreamBuffers()
+    , m_displayWidth(0)
+    , m_displayHeight(0)
+    , m_displayOrder(0)
+    , m_sliceRecords()
+    , m_entryPoints()
+    , m_stats()
+{
+    for (uint32_t picIdx = 0; picIdx < MAX_PICTURES; picIdx++) {
+        m_pictures[picIdx].m_picIdx = picIdx;
+    }
+    for (uint32_t i = 0; i < 3; i++) {
+        m_activeParameterSets[i] = nullptr;
+        m_activeParameterSetsUpdateCount[i] = 0;
+    }
+}
+
+VkVideoStreamAnalyzer::~VkVideoStreamAnalyzer()
+{
+    // The parser calls back into this object, release it first.
+    m_parser = nullptr;
+    m_bitstreamBuffers.clear();
+}
+
+VkResult VkVideoStreamAnalyzer::Initialize(const ParserOptions& parserOptions)
+{
+    static const VkExtensionProperties h264StdExtensionVersion = { VK_STD_VULKAN_VIDEO_CODEC_H264_DECODE_EXTENSION_NAME, VK_STD_VULKAN_VIDEO_CODEC_H264_DECODE_SPEC_VERSION };
+    static const VkExtensionProperties h265StdExtensionVersion = { VK_STD_VULKAN_VIDEO_CODEC_H265_DECODE_EXTENSION_NAME, VK_STD_VULKAN_VIDEO_CODEC_H265_DECODE_SPEC_VERSION };
+    static const VkExtensionProperties av1StdExtensionVersion = { VK_STD_VULKAN_VIDEO_CODEC_AV1_DECODE_EXTENSION_NAME, VK_STD_VULKAN_VIDEO_CODEC_AV1_DECODE_SPEC_VERSION };
+
+    const VkExtensionProperties* pStdExtensionVersion = NULL;
+    if (m_codec == VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR) {
+        pStdExtensionVersion = &h264StdExtensionVersion;
+    } else if (m_codec == VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR) {
+        pStdExtensionVersion = &h265StdExtensionVersion;
+    } else if (m_codec == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+        pStdExtensionVersion = &av1StdExtensionVersion;
+    } else if (m_codec == VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR) {
+        pStdExtensionVersion = NULL; // VP9 has no codec std header
+    } else {
+        fprintf(stderr, "Stream analyzer: unsupported codec 0x%x\n", m_codec);
+        return VK_ERROR_VIDEO_PROFILE_CODEC_NOT_SUPPORTED_KHR;
+    }
+
+    VkParserInitDecodeParameters nvdp;
+    memset(&nvdp, 0, sizeof(nvdp));
+    nvdp.interfaceVersion = NV_VULKAN_VIDEO_PARSER_API_VERSION;
+    nvdp.pClient = this;
+    nvdp.defaultMinBufferSize = (uint32_t)defaultMinBufferSize;
+    nvdp.bufferOffsetAlignment = (uint32_t)bitstreamBufferAlignment;
+    nvdp.bufferSizeAlignment = (uint32_t)bitstreamBufferAlignment;
+    nvdp.referenceClockRate = 0;
+    nvdp.errorThreshold = 0;
+    // The parameter sets are reported through UpdatePictureParameters(), which
+    // is where the analyzer detects parameter set changes.
+    nvdp.outOfBandPictureParameters = true;
+    nvdp.pipelinedParsing = parserOptions.pipelinedParsing;
+    nvdp.pictureMetadata = parserOptions.pictureMetadata;
+    nvdp.callbackTimings = parserOptions.callbackTimings;
+
+    return CreateVulkanVideoDecodeParser(m_codec, pStdExtensionVersion, &nvParserLog, 0, &nvdp, m_parser);
+}
+
+VkResult VkVideoStreamAnalyzer::ParseData(const uint8_t* pData, size_t size, bool endOfPicture, bool endOfStream)
+{
+    if (!m_parser) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    // The parser releases its parameter sets at the end of the stream, take its footprint before
+    if (endOfStream) {
+        if (size > 0) {
+            VkResult result = ParseData(pData, size, endOfPicture, false);
+            if (result != VK_SUCCESS) {
+                return result;
+            }
+            pData = nullptr;
+            size = 0;
+        }
+        m_parser->GetMemoryFootprint(&m_stats.parserFootprint);
+    }
+
+    VkParserBitstreamPacket pkt;
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.pByteStream = pData;
+    pkt.nDataLength = size;
+    pkt.bEOS = endOfStream;
+    pkt.bEOP = endOfPicture;
+
+    size_t parsedBytes = 0;
+    if (!m_parser->ParseByteStream(&pkt, &parsedBytes)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (endOfStream) {
+        m_parser->GetTelemetry(&m_stats.parserTelemetry);
+    }
+
+    return VK_SUCCESS;
+}
+
+int32_t VkVideoStreamAnalyzer::BeginSequence(const VkParserSequenceInfo* pnvsi)
+{
+    m_displayWidth = pnvsi->nDisplayWidth;
+    m_displayHeight = pnvsi->nDisplayHeight;
+    m_stats.frameRateNumerator = NV_FRAME_RATE_NUM(pnvsi->frameRate);
+    m_stats.frameRateDenominator = NV_FRAME_RATE_DEN(pnvsi->frameRate);
+
+    if (m_pWriter) {
+        m_pWriter->WriteSequence(m_stats.numSequences, pnvsi);
+    }
+    m_stats.numSequences++;
+
+    if (pnvsi->nMinNumDecodeSurfaces > MAX_PICTURES) {
+        fprintf(stderr, "Stream analyzer: the stream requires %d decode surfaces, only %d are supported\n",
+                pnvsi->nMinNumDecodeSurfaces, MAX_PICTURES);
+        return 0;
+    }
+
+    return MAX_PICTURES;
+}
+
+bool VkVideoStreamAnalyzer::AllocPictureBuffer(VkPicIf** ppPicBuf)
+{
+    *ppPicBuf = nullptr;
+
+    for (uint32_t picIdx = 0; picIdx < MAX_PICTURES; picIdx++) {
+        if (m_pictures[picIdx].IsAvailable()) {
+            m_pictures[picIdx].Reset();
+            m_pictures[picIdx].AddRef();
+            m_pictures[picIdx].m_picIdx = picIdx;
+            m_pictures[picIdx].m_displayOrder = (uint32_t)-1;
+            m_pictures[picIdx].m_decodeOrder = m_stats.numFrames;
+            *ppPicBuf = &m_pictures[picIdx];
+            return true;
+        }
+    }
+
+    fprintf(stderr, "Stream analyzer: out of picture buffers\n");
+    return false;
+}
+
+void VkVideoStreamAnalyzer::FillCodecSpecificRecord(const VkParserPictureData* pd, VkStreamAnalyzerFrameRecord& record) const
+{
+    switch ((uint32_t)m_codec) {
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR:
+    {
+        const VkParserH264PictureData* h264 = &pd->CodecSpecific.h264;
+        const StdVideoH264PictureParameterSet* pStdPps = h264->pStdPps ? h264->pStdPps->GetStdH264Pps() : nullptr;
+        record.qp = pStdPps ? (26 + pStdPps->pic_init_qp_minus26) : 0;
+        record.orderCount = pd->picture_order_count;
+        for (uint32_t i = 0; i < 16; i++) {
+            if (h264->dpb[i].used_for_reference) {
+                record.numReferences++;
+            }
+        }
+        // The parser does not report nal_unit_type, an intra picture with
+        // an empty DPB is where decoding can start.
+        if (pd->intra_pic_flag) {
+            record.frameType = (record.numReferences == 0) ? VkStreamAnalyzerFrameRecord::FRAME_TYPE_KEY :
+                                                             VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTRA;
+        }
+    }
+        break;
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR:
+    {
+        const VkParserHevcPictureData* hevc = &pd->CodecSpecific.hevc;
+        const StdVideoH265PictureParameterSet* pStdPps = hevc->pStdPps ? hevc->pStdPps->GetStdH265Pps() : nullptr;
+        record.qp = pStdPps ? (26 + pStdPps->init_qp_minus26) : 0;
+        record.orderCount = hevc->CurrPicOrderCntVal;
+        record.numReferences = (uint32_t)hevc->NumPocTotalCurr;
+        if (hevc->IrapPicFlag) {
+            record.frameType = VkStreamAnalyzerFrameRecord::FRAME_TYPE_KEY;
+        } else if (pd->intra_pic_flag) {
+            record.frameType = VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTRA;
+        }
+    }
+        break;
+    case VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR:
+    {
+        const VkParserAv1PictureData* av1 = &pd->CodecSpecific.av1;
+        record.qp = av1->quantization.base_q_idx;
+        record.orderCount = av1->std_info.OrderHint;
+        record.isShown = av1->showFrame;
+        record.isReference = (av1->std_info.refresh_frame_flags != 0);
+        record.width = av1->upscaled_width;
+        record.height = av1->frame_height;
+        switch (av1->std_info.frame_type) {
+        case STD_VIDEO_AV1_FRAME_TYPE_KEY:
+            record.frameType = VkStreamAnalyzerFrameRecord::FRAME_TYPE_KEY;
+            break;
+        case STD_VIDEO_AV1_FRAME_TYPE_INTRA_ONLY:
+            record.frameType = VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTRA;
+            break;
+        case STD_VIDEO_AV1_FRAME_TYPE_SWITCH:
+            record.frameType = VkStreamAnalyzerFrameRecord::FRAME_TYPE_SWITCH;
+            break;
+        default:
+            record.frameType = VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTER;
+            break;
+        }
+        if ((record.frameType == VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTER) ||
+                (record.frameType == VkStreamAnalyzerFrameRecord::FRAME_TYPE_SWITCH)) {
+            // Count the distinct reference slots used by the 7 reference frame names.
+            uint32_t usedSlots = 0;
+            for (uint32_t i = 0; i < STD_VIDEO_AV1_REFS_PER_FRAME; i++) {
+                usedSlots |= 1 << av1->ref_frame_idx[i];
+            }
+            for (; usedSlots != 0; usedSlots &= (usedSlots - 1)) {
+                record.numReferences++;
+            }
+        }
+    }
+        break;
+    case VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR:
+    {
+        const VkParserVp9PictureData* vp9 = &pd->CodecSpecific.vp9;
+        record.qp = vp9->qpYAc;
+        record.isShown = vp9->showFrame;
+        record.isReference = (vp9->refreshFrameFlags != 0);
+        record.width = vp9->width;
+        record.height = vp9->height;
+        if (vp9->keyFrame) {
+            record.frameType = VkStreamAnalyzerFrameRecord::FRAME_TYPE_KEY;
+        } else if (vp9->intraOnly) {
+            record.frameType = VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTRA;
+        } else {
+            record.frameType = VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTER;
+            // Count the distinct reference slots used by LAST, GOLDEN and ALTREF.
+            uint32_t usedSlots = 0;
+            for (uint32_t i = 0; i < 3; i++) {
+                usedSlots |= 1 << vp9->activeRefIdx[i];
+            }
+            for (; usedSlots != 0; usedSlots &= (usedSlots - 1)) {
+                record.numReferences++;
+            }
+        }
+    }
+        break;
+    default:
+        break;
+    }
+}
+
+// Reads the metadata payloads in place, from the bitstream buffer of the picture.
+void VkVideoStreamAnalyzer::FillMetadataRecord(const VkParserPictureData* pd, VkStreamAnalyzerFrameRecord& record) const
+{
+    if ((pd->numMetadata == 0) || !pd->bitstreamData) {
+        return;
+    }
+
+    VkDeviceSize maxSize = 0;
+    const uint8_t* pBitstream = pd->bitstreamData->GetReadOnlyDataPtr(0, maxSize);
+    for (uint32_t i = 0; i < pd->numMetadata; i++) {
+        const VkParserMetadata& metadata = pd->pMetadata[i];
+        if ((pBitstream == nullptr) || ((VkDeviceSize)metadata.offset + metadata.size > maxSize)) {
+            fprintf(stderr, "Stream analyzer: metadata %u of picture %llu is out of the bitstream buffer\n",
+                    i, (unsigned long long)record.decodeIndex);
+            continue;
+        }
+
+        VkParserMetadataReader reader(pBitstream, metadata);
+        uint8_t payload[256];
+        uint32_t payloadBytes = 0;
+        for (size_t bytes; (bytes = reader.Read(payload, sizeof(payload))) > 0; ) {
+            payloadBytes += (uint32_t)bytes;
+        }
+        if (payloadBytes != metadata.payloadSize) {
+            fprintf(stderr, "Stream analyzer: metadata %u of picture %llu has %u payload bytes, %u expected\n",
+                    i, (unsigned long long)record.decodeIndex, payloadBytes, metadata.payloadSize);
+        }
+
+        record.numMetadata++;
+        record.metadataBytes += payloadBytes;
+        record.metadataTypes |= 1u << metadata.type;
+    }
+}
+
+// Turns the H.265 slice segments of the picture into slice records, with the
+// entry points relative to the slice data.
+void VkVideoStreamAnalyzer::FillSliceRecords(const VkParserPictureData* pd, VkStreamAnalyzerFrameRecord& record)
+{
+    m_sliceRecords.clear();
+    m_entryPoints.clear();
+    if (m_codec != VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR) {
+        return;
+    }
+    const VkParserHevcPictureData* hevc = &pd->CodecSpecific.hevc;
+    if (hevc->pSliceSegments == nullptr) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < pd->numSlices; i++) {
+        const VkParserHevcSliceSegment& sliceSegment = hevc->pSliceSegments[i];
+        if (((uint64_t)sliceSegment.firstEntryPoint + sliceSegment.numEntryPoints) > hevc->numEntryPointOffsets) {
+            fprintf(stderr, "Stream analyzer: slice segment %u of picture %llu has entry points out of the list\n",
+                    i, (unsigned long long)record.decodeIndex);
+            continue;
+        }
+        VkStreamAnalyzerSliceRecord slice;
+        slice.address = sliceSegment.slice_segment_address;
+        slice.dataOffset = sliceSegment.sliceDataOffset - (uint32_t)pd->bitstreamDataOffset;
+        slice.dataSize = sliceSegment.sliceDataSize;
+        slice.numEntryPoints = sliceSegment.numEntryPoints;
+        slice.qp = sliceSegment.SliceQpY;
+        slice.sliceType = sliceSegment.slice_type;
+        slice.isDependent = sliceSegment.dependent_slice_segment_flag;
+        for (uint32_t j = 0; j < sliceSegment.numEntryPoints; j++) {
+            m_entryPoints.push_back(hevc->pEntryPointOffsets[sliceSegment.firstEntryPoint + j] - sliceSegment.sliceDataOffset);
+        }
+
+        record.minSliceQp = m_sliceRecords.empty() ? slice.qp : std::min(record.minSliceQp, slice.qp);
+        record.maxSliceQp = m_sliceRecords.empty() ? slice.qp : std::max(record.maxSliceQp, slice.qp);
+        record.numEntryPoints += slice.numEntryPoints;
+        m_stats.totalSliceQp += slice.qp;
+        m_sliceRecords.push_back(slice);
+    }
+
+    record.numSliceRecords = (uint32_t)m_sliceRecords.size();
+    record.pSlices = m_sliceRecords.empty() ? nullptr : m_sliceRecords.data();
+    record.pEntryPoints = m_entryPoints.empty() ? nullptr : m_entryPoints.data();
+    if (record.numSliceRecords > 0) {
+        m_stats.minSliceQp = (m_stats.numSliceSegments == 0) ? record.minSliceQp : std::min(m_stats.minSliceQp, record.minSliceQp);
+        m_stats.maxSliceQp = (m_stats.numSliceSegments == 0) ? record.maxSliceQp : std::max(m_stats.maxSliceQp, record.maxSliceQp);
+    }
+    m_stats.numSliceSegments += record.numSliceRecords;
+    m_stats.numEntryPoints += record.numEntryPoints;
+}
+
+bool VkVideoStreamAnalyzer::DecodePicture(VkParserPictureData* pd)
+{
+    VkStreamAnalyzerFrameRecord record;
+    memset(&record, 0, sizeof(record));
+
+    record.decodeIndex = m_stats.numFrames;
+    record.sequenceIndex = (m_stats.numSequences > 0) ? (m_stats.numSequences - 1) : 0;
+    record.frameType = pd->intra_pic_flag ? VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTRA :
+                                            VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTER;
+    record.isReference = pd->ref_pic_flag;
+    record.isShown = 1;
+    record.isFieldPicture = pd->field_pic_flag;
+    record.sizeInBytes = (uint32_t)pd->bitstreamDataLen;
+    record.numSlices = pd->numSlices;
+    record.width = m_displayWidth;
+    record.height = m_displayHeight;
+
+    FillCodecSpecificRecord(pd, record);
+    FillMetadataRecord(pd, record);
+    FillSliceRecords(pd, record);
+
+    switch ((uint32_t)m_codec) {
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR:
+        record.numParameterSetUpdates = UpdateActiveParameterSets(nullptr,
+                                                                  pd->CodecSpecific.h264.pStdSps,
+                                                                  pd->CodecSpecific.h264.pStdPps);
+        break;
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR:
+        record.numParameterSetUpdates = UpdateActiveParameterSets(pd->CodecSpecific.hevc.pStdVps,
+                                                                  pd->CodecSpecific.hevc.pStdSps,
+                                                                  pd->CodecSpecific.hevc.pStdPps);
+        break;
+    case VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR:
+        record.numParameterSetUpdates = UpdateActiveParameterSets(nullptr, pd->CodecSpecific.av1.pStdSps, nullptr);
+        break;
+    default:
+        break;
+    }
+
+    m_stats.numFrames++;
+    m_stats.totalFrameBytes += record.sizeInBytes;
+    m_stats.maxFrameBytes = std::max<uint64_t>(m_stats.maxFrameBytes, record.sizeInBytes);
+    m_stats.numMetadata += record.numMetadata;
+    m_stats.totalMetadataBytes += record.metadataBytes;
+    switch (record.frameType) {
+    case VkStreamAnalyzerFrameRecord::FRAME_TYPE_KEY:
+        m_stats.numKeyFrames++;
+        break;
+    case VkStreamAnalyzerFrameRecord::FRAME_TYPE_INTRA:
+        m_stats.numIntraFrames++;
+        break;
+    default:
+        m_stats.numInterFrames++;
+        break;
+    }
+
+    if (m_pWriter) {
+        m_pWriter->WriteFrame(record);
+    }
+
+    return true;
+}
+
+uint32_t VkVideoStreamAnalyzer::UpdateActiveParameterSets(const StdVideoPictureParametersSet* pStdVps,
+                                                         const StdVideoPictureParametersSet* pStdSps,
+                                                         const StdVideoPictureParametersSet* pStdPps)
+{
+    const StdVideoPictureParametersSet* parameterSets[3] = { pStdVps, pStdSps, pStdPps };
+
+    uint32_t numUpdates = 0;
+    for (uint32_t i = 0; i < 3; i++) {
+        if (parameterSets[i] == nullptr) {
+            continue;
+        }
+        const uint32_t updateCount = parameterSets[i]->GetUpdateSequenceCount();
+        if ((parameterSets[i] != m_activeParameterSets[i]) || (updateCount != m_activeParameterSetsUpdateCount[i])) {
+            m_activeParameterSets[i] = parameterSets[i];
+            m_activeParameterSetsUpdateCount[i] = updateCount;
+            numUpdates++;
+        }
+    }
+    return numUpdates;
+}
+
+bool VkVideoStreamAnalyzer::UpdatePictureParameters(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersObject,
+                                                    VkSharedBaseObj<VkVideoRefCountBase>& client)
+{
+    // No device side parameter objects: leave the client object empty.
+    (void)client;
+    if (pictureParametersObject) {
+        m_stats.numParameterSetUpdates++;
+    }
+    return true;
+}
+
+bool VkVideoStreamAnalyzer::DisplayPicture(VkPicIf* pPicBuf, int64_t llPTS)
+{
+    vkPicBuffBase* pPicture = static_cast<vkPicBuffBase*>(pPicBuf);
+    if (pPicture != nullptr) {
+        pPicture->m_displayOrder = m_displayOrder++;
+        pPicture->m_timestamp = llPTS;
+    }
+    m_stats.numDisplayedFrames++;
+    return true;
+}
+
+VkDeviceSize VkVideoStreamAnalyzer::GetBitstreamBuffer(VkDeviceSize size,
+                                                       VkDeviceSize minBitstreamBufferOffsetAlignment,
+                                                       VkDeviceSize minBitstreamBufferSizeAlignment,
+                                                       const uint8_t* pInitializeBufferMemory,
+                                                       VkDeviceSize initializeBufferMemorySize,
+                                                       VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer)
+{
+    assert(initializeBufferMemorySize <= size);
+
+    // Reuse a buffer that is no longer referenced by the parser.
+    for (size_t i = 0; i < m_bitstreamBuffers.size(); i++) {
+        VkSharedBaseObj<VulkanBitstreamBufferHost>& hostBuffer = m_bitstreamBuffers[i];
+        if ((hostBuffer->GetRefCount() == 1) && (hostBuffer->GetMaxSize() >= size)) {
+            if (initializeBufferMemorySize) {
+                hostBuffer->CopyDataFromBuffer(pInitializeBufferMemory, 0, 0, initializeBufferMemorySize);
+            }
+            hostBuffer->ResetStreamMarkers();
+            bitstreamBuffer = hostBuffer;
+            return hostBuffer->GetMaxSize();
+        }
+    }
+
+    VkSharedBaseObj<VulkanBitstreamBufferHost> newBuffer;
+    VkResult result = VulkanBitstreamBufferHost::Create(std::max<VkDeviceSize>(size, defaultMinBufferSize),
+                                                        minBitstreamBufferOffsetAlignment,
+                                                        minBitstreamBufferSizeAlignment,
+                                                        pInitializeBufferMemory, initializeBufferMemorySize,
+                                                        newBuffer);
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "Stream analyzer: could not allocate a bitstream buffer of %llu bytes\n",
+                (unsigned long long)size);
+        return 0;
+    }
+
+    if (m_bitstreamBuffers.size() < maxBitstreamBuffers) {
+        m_bitstreamBuffers.push_back(newBuffer);
+        m_stats.numBitstreamBuffers = (uint32_t)m_bitstreamBuffers.size();
+    } else {
+        // All pooled buffers are too small or still in use; replace a free
+        // undersized one so that the pool follows the stream's frame sizes.
+        for (size_t i = 0; i < m_bitstreamBuffers.size(); i++) {
+            if (m_bitstreamBuffers[i]->GetRefCount() == 1) {
+                m_bitstreamBuffers[i] = newBuffer;
+                break;
+            }
+        }
+    }
+
+    bitstreamBuffer = newBuffer;
+    return newBuffer->GetMaxSize();
+}
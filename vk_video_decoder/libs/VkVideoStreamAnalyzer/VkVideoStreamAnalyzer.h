@@ -0,0 +1,234 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _VKVIDEOSTREAMANALYZER_H_
+#define _VKVIDEOSTREAMANALYZER_H_
+
+#include <assert.h>
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "vulkan_interfaces.h"
+#include "vkvideo_parser/VulkanVideoParserIf.h"
+#include "vkvideo_parser/PictureBufferBase.h"
+#include "VkCodecUtils/VulkanBitstreamBufferHost.h"
+
+// Per-slice-segment record of an H.265 picture.
+struct VkStreamAnalyzerSliceRecord {
+    uint32_t  address;            // slice_segment_address
+    uint32_t  dataOffset;         // Offset of the slice segment data in the picture
+    uint32_t  dataSize;           // Bytes of slice segment data, emulation prevention bytes included
+    uint32_t  numEntryPoints;     // Substreams after the first one
+    int32_t   qp;                 // SliceQpY
+    uint32_t  sliceType;          // 0 = B, 1 = P, 2 = I
+    uint32_t  isDependent;        // dependent_slice_segment_flag
+};
+
+// Per-picture record reported by the analyzer, in decode order.
+struct VkStreamAnalyzerFrameRecord {
+    enum FrameType {
+        FRAME_TYPE_KEY = 0,     // IDR / IRAP / AV1 and VP9 key frame: random access point
+        FRAME_TYPE_INTRA,       // intra coded, but not a random access point
+        FRAME_TYPE_INTER,
+        FRAME_TYPE_SWITCH,      // AV1 S-frame
+    };
+
+    uint64_t  decodeIndex;
+    uint32_t  sequenceIndex;      // incremented on each BeginSequence() call
+    FrameType frameType;
+    uint32_t  isReference : 1;
+    uint32_t  isShown : 1;        // AV1/VP9: show_frame, always set for H.26x
+    uint32_t  isFieldPicture : 1;
+    uint32_t  sizeInBytes;
+    uint32_t  numSlices;          // H.26x slices, AV1/VP9 tiles
+    int32_t   qp;                 // H.26x picture init QP, AV1/VP9 base_q_idx
+    int32_t   orderCount;         // H.26x POC, AV1 OrderHint
+    uint32_t  numReferences;      // active reference pictures (H.264: DPB frames used for reference)
+    uint32_t  numParameterSetUpdates; // active VPS/SPS/PPS or AV1 sequence header replaced since the previous picture
+    uint32_t  numMetadata;        // SEI messages / AV1 metadata OBUs of the picture
+    uint32_t  metadataBytes;      // Payload bytes, without emulation prevention bytes
+    uint32_t  metadataTypes;      // Bit mask of the VkParserMetadataType of the messages
+    int32_t   width;
+    int32_t   height;
+    // H.265 slice segments. The arrays are only valid during WriteFrame(), the
+    // entry points are the substream offsets from the start of the slice data.
+    uint32_t  numSliceRecords;
+    uint32_t  numEntryPoints;
+    int32_t   minSliceQp;
+    int32_t   maxSliceQp;
+    const VkStreamAnalyzerSliceRecord* pSlices;
+    const uint32_t* pEntryPoints;
+};
+
+// Writes the frame and sequence records either as JSON Lines (one JSON object
+// per line) or as CSV (frame records only, preceded by a header line). With
+// sliceRecords, the JSON frame records are followed by one record per H.265
+// slice segment.
+class VkStreamAnalyzerWriter {
+
+public:
+
+    enum Format {
+        FORMAT_JSON_LINES = 0,
+        FORMAT_CSV,
+    };
+
+    VkStreamAnalyzerWriter(FILE* fp, Format format, bool sliceRecords = false)
+        : m_fp(fp)
+        , m_format(format)
+        , m_sliceRecords(sliceRecords)
+        , m_headerWritten(false) { }
+
+    virtual ~VkStreamAnalyzerWriter() { }
+
+    virtual void WriteSequence(uint32_t sequenceIndex, const VkParserSequenceInfo* pSeqInfo);
+    virtual void WriteFrame(const VkStreamAnalyzerFrameRecord& record);
+
+    static const char* GetCodecName(VkVideoCodecOperationFlagBitsKHR codec);
+    static const char* GetFrameTypeName(VkStreamAnalyzerFrameRecord::FrameType frameType);
+    static const char* GetMetadataTypeName(VkParserMetadataType type);
+
+private:
+    FILE*    m_fp;
+    Format   m_format;
+    bool     m_sliceRecords;
+    bool     m_headerWritten;
+};
+
+// Implements the parser client callbacks without a Vulkan device: picture
+// buffers are plain reference-counted indices and bitstream buffers live in
+// system memory. Every picture handed to DecodePicture() is turned into a
+// VkStreamAnalyzerFrameRecord and streamed to the writer.
+class VkVideoStreamAnalyzer : public VkVideoRefCountBase, public VkParserVideoDecodeClient {
+
+public:
+
+    enum { MAX_PICTURES = 32 };
+
+    struct Stats {
+        uint64_t numFrames;
+        uint64_t numKeyFrames;
+        uint64_t numIntraFrames;
+        uint64_t numInterFrames;
+        uint64_t numDisplayedFrames;
+        uint64_t totalFrameBytes;
+        uint64_t maxFrameBytes;
+        uint32_t numSequences;
+        uint32_t numParameterSetUpdates;
+        uint32_t numBitstreamBuffers;
+        uint32_t frameRateNumerator;
+        uint32_t frameRateDenominator;
+        uint64_t numMetadata;
+        uint64_t totalMetadataBytes;
+        uint64_t numSliceSegments;      // H.265
+        uint64_t numEntryPoints;
+        int64_t  totalSliceQp;
+        int32_t  minSliceQp;
+        int32_t  maxSliceQp;
+        VkParserMemoryFootprint parserFootprint;    // Taken before the end of the stream
+        VkParserTelemetry parserTelemetry;          // Taken at the end of the stream
+    };
+
+    // Parser modes, see VkParserInitDecodeParameters
+    struct ParserOptions {
+        bool pipelinedParsing;
+        bool pictureMetadata;
+        bool callbackTimings;
+    };
+
+    static VkResult Create(VkVideoCodecOperationFlagBitsKHR codec,
+                           VkStreamAnalyzerWriter* pWriter,
+                           const ParserOptions& parserOptions,
+                           VkSharedBaseObj<VkVideoStreamAnalyzer>& streamAnalyzer);
+
+    virtual int32_t AddRef()
+    {
+        return ++m_refCount;
+    }
+
+    virtual int32_t Release()
+    {
+        uint32_t ret = --m_refCount;
+        // Destroy the analyzer if ref-count reaches zero
+        if (ret == 0) {
+            delete this;
+        }
+        return ret;
+    }
+
+    // Feed a chunk of the elementary stream. For AV1, pData must contain
+    // exactly one temporal unit, for VP9 one frame or superframe. Set endOfStream on the last call to flush
+    // the pictures pending in the parser.
+    VkResult ParseData(const uint8_t* pData, size_t size, bool endOfPicture, bool endOfStream);
+
+    const Stats& GetStats() const { return m_stats; }
+
+    // VkParserVideoDecodeClient
+    virtual int32_t BeginSequence(const VkParserSequenceInfo* pnvsi);
+    virtual bool AllocPictureBuffer(VkPicIf** ppPicBuf);
+    virtual bool DecodePicture(VkParserPictureData* pParserPictureData);
+    virtual bool UpdatePictureParameters(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersObject,
+                                         VkSharedBaseObj<VkVideoRefCountBase>& client);
+    virtual bool DisplayPicture(VkPicIf* pPicBuf, int64_t llPTS);
+    virtual void UnhandledNALU(const uint8_t*, size_t) { }
+    virtual VkDeviceSize GetBitstreamBuffer(VkDeviceSize size,
+                                            VkDeviceSize minBitstreamBufferOffsetAlignment,
+                                            VkDeviceSize minBitstreamBufferSizeAlignment,
+                                            const uint8_t* pInitializeBufferMemory,
+                                            VkDeviceSize initializeBufferMemorySize,
+                                            VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer);
+
+private:
+
+    class AnalyzerPicture : public vkPicBuffBase { };
+
+    VkVideoStreamAnalyzer(VkVideoCodecOperationFlagBitsKHR codec, VkStreamAnalyzerWriter* pWriter);
+
+    virtual ~VkVideoStreamAnalyzer();
+
+    VkResult Initialize(const ParserOptions& parserOptions);
+
+    void FillCodecSpecificRecord(const VkParserPictureData* pd, VkStreamAnalyzerFrameRecord& record) const;
+    void FillMetadataRecord(const VkParserPictureData* pd, VkStreamAnalyzerFrameRecord& record) const;
+    void FillSliceRecords(const VkParserPictureData* pd, VkStreamAnalyzerFrameRecord& record);
+
+    uint32_t UpdateActiveParameterSets(const StdVideoPictureParametersSet* pStdVps,
+                                       const StdVideoPictureParametersSet* pStdSps,
+                                       const StdVideoPictureParametersSet* pStdPps);
+
+private:
+    std::atomic<int32_t>                 m_refCount;
+    const VkVideoCodecOperationFlagBitsKHR m_codec;
+    VkStreamAnalyzerWriter*              m_pWriter;
+    VkSharedBaseObj<VulkanVideoDecodeParser> m_parser;
+    AnalyzerPicture                      m_pictures[MAX_PICTURES];
+    std::vector<VkSharedBaseObj<VulkanBitstreamBufferHost>> m_bitstreamBuffers;
+    int32_t                              m_displayWidth;
+    int32_t                              m_displayHeight;
+    // Parameter sets referenced by the previous picture. The parser reports
+    // parameter sets ahead of the picture that precedes them in the stream,
+    // so changes are detected per picture rather than per callback.
+    const StdVideoPictureParametersSet*  m_activeParameterSets[3];
+    uint32_t                             m_activeParameterSetsUpdateCount[3];
+    uint32_t                             m_displayOrder;
+    std::vector<VkStreamAnalyzerSliceRecord> m_sliceRecords;   // Of the current picture
+    std::vector<uint32_t>                m_entryPoints;
+    Stats                                m_stats;
+};
+
+#endif /* _VKVIDEOSTREAMANALYZER_H_ */
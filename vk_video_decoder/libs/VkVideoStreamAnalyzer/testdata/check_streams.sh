@@ -0,0 +1,39 @@
+#!/bin/bash
+# Copyright 2024 NVIDIA Corporation.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Parses every stream of this directory that has a <stream>.jsonl file with
+# vk-video-stream-analyzer and compares the records with it. The H.265 tile
+# and WPP streams are checked with their --slices records (slice segment
+# addresses, QPs and entry point offsets), the other ones with --metadata.
+#
+# Usage: check_streams.sh <vk-video-stream-analyzer>
+
+analyzer=${1:-vk-video-stream-analyzer}
+testdata=$(dirname "$0")
+failed=0
+
+for expected in "$testdata"/*.jsonl; do
+    stream=${expected%.jsonl}
+    case "$stream" in
+        */h265_tiles.265 | */h265_wpp.265) options=--slices ;;
+        *) options=--metadata ;;
+    esac
+    if ! "$analyzer" -i "$stream" $options --noSummary --expect "$expected" > /dev/null; then
+        echo "FAILED: $stream"
+        failed=1
+    fi
+done
+
+exit $failed
@@ -47,6 +47,13 @@ public:
     virtual int64_t  GetNumberOfFrames() = 0;
     virtual VkResult EncodeNextFrame(int64_t& frameNumEncoded) = 0;
     virtual VkResult GetBitstream() = 0;
+
+    // Runtime reconfiguration, applied from the next frame to be encoded. Bitrates are
+    // in bits/sec and the CPB size in bits, a value of 0 keeps the current setting.
+    virtual VkResult SetRateControl(uint32_t averageBitrate, uint32_t maxBitrate, uint32_t cpbSize) = 0;
+    virtual VkResult SetFrameRate(uint32_t frameRateNumerator, uint32_t frameRateDenominator) = 0;
+    virtual VkResult SetQualityLevel(uint32_t qualityLevel) = 0;
+    virtual VkResult RequestIdrFrame() = 0;
 };
 
 
@@ -19,6 +19,22 @@
 #include "VkVideoEncoder/VkEncoderConfigH265.h"
 #include "VkVideoEncoder/VkEncoderConfigAV1.h"
 
+// Parses a comma separated list of unsigned integers, returns the number of values or 0 on error
+static uint32_t ParseUintList(const char* pStr, uint32_t* pValues, uint32_t maxValues)
+{
+    uint32_t count = 0;
+    while (*pStr != '\0') {
+        char* pEnd = nullptr;
+        const unsigned long value = strtoul(pStr, &pEnd, 10);
+        if ((pEnd == pStr) || (count >= maxValues) || ((*pEnd != ',') && (*pEnd != '\0'))) {
+            return 0;
+        }
+        pValues[count++] = (uint32_t)value;
+        pStr = (*pEnd == ',') ? pEnd + 1 : pEnd;
+    }
+    return count;
+}
+
 void printHelp(VkVideoCodecOperationFlagBitsKHR codec)
 {
     fprintf(stderr,
@@ -36,6 +52,15 @@ void printHelp(VkVideoCodecOperationFlagBitsKHR codec)
     --inputLumaPlanePitch           <integer> : Pitch for Luma plane \n\
     --inputBpp                      <integer> : Bits per pixel, default 8 \n\
     --msbShift                      <integer> : Shift the input plane pixels to the left when bpp > 8, default: 16 - inputBpp  \n\
+    --inputFormat                   <string>  : yuv (default), or packed RGB converted to 4:2:0 of inputBpp bits: rgba, bgra, rgb, bgr, rgb10a2, bgr10a2\n\
+    --inputColorMatrix              <string>  : bt601, bt709 (default) or bt2020, the RGB input conversion matrix signaled in the VUI\n\
+    --inputFullRange                Convert the RGB input to full range YCbCr instead of the limited (video) range\n\
+    --syntheticInput                Encode generated frames of inputWidth x inputHeight instead of an input file, for numFrames frames\n\
+    --syntheticNoiseBits            <integer> : Random bits added to each luma sample of the generated frames [0, 8], default 4\n\
+    --syntheticMotion               <integer> : Pixels per frame of the panning and the scrolling text of the generated frames, default 4\n\
+    --syntheticTextDensity          <integer> : Percent of the lines of the generated frames with text [0, 100], default 30\n\
+    --syntheticSceneChangeInterval  <integer> : Frames per scene of the generated frames, default 0: a single scene\n\
+    --syntheticSeed                 <integer> : Seed of the generated content, default 1\n\
     --startFrame                    <integer> : Start Frame Number to be Encoded \n\
     --numFrames                     <integer> : End Frame Number to be Encoded \n\
     --encodeOffsetX                 <integer> : Encoded offset X \n\
@@ -48,12 +73,20 @@ void printHelp(VkVideoCodecOperationFlagBitsKHR codec)
     --maxQp                         <integer> : Maximum QP value in the range [0, 51] \n\
     --qpMap                         <string>  : selct quantization map type : deltaQpMap or emaphasisMap \n\
     --qpMapFileName                 <string>  : quantization map file name \n\
+    --qpMapGenerate                 Generate the quantization map of each frame from the input content instead of a file\n\
+    --qpMapStrength                 <float>   : Activity masking strength of the generated map, in QP per doubling of the variance, default 1.0\n\
+    --qpMapStaticDeltaQp            <integer> : Delta QP of the regions unchanged since the previous frame, default -2, 0: disabled\n\
+    --qpMapMaxDeltaQp               <integer> : Maximum absolute delta QP of the generated map, default 8\n\
+    --qpMapRoi                      <x,y,w,h,deltaQp> : Region of interest of the generated map in luma samples, up to 8\n\
     --gopFrameCount                 <integer> : Number of frame in the GOP, default 16\n\
     --idrPeriod                     <integer> : Number of frame between 2 IDR frame, default 60\n\
     --consecutiveBFrameCount        <integer> : Number of consecutive B frame count in a GOP \n\
-    --temporalLayerCount            <integer> : Count of temporal layer \n\
+    --temporalLayerCount            <integer> : Count of temporal layers [1, 4], with the dyadic pattern of that count \n\
+    --temporalLayerPattern          <string>  : Temporal layer of each frame of the pattern, e.g. 0,2,1,2 \n\
+    --temporalLayerBitrates         <string>  : Percentage of the bitrate of each temporal layer, e.g. 40,20,40 \n\
     --lastFrameType                 <integer> : Last frame type \n\
     --closedGop                     Close the Gop, default open\n\
+    --intraRefreshPeriod            <integer> : Refresh the picture with a wave of intra slices over this many P-frames instead of periodic I/IDR frames (H.264/H.265), 0: disabled (default)\n\
     --qualityLevel                  <integer> : Select quality level \n\
     --tuningMode                    <integer> or <string> : Select tuning mode \n\
                                         default(0), hq(1), lowlatency(2), ultralowlatency(3), lossless(4) \n\
@@ -67,6 +100,14 @@ void printHelp(VkVideoCodecOperationFlagBitsKHR codec)
     --deviceID                      <hexadec> : deviceID to be used, \n\
     --deviceUuid                    <string>  : deviceUuid to be used \n\
     --testOutOfOrderRecording      Testing only: enable testing for out-of-order-recording\n\
+    --verifyHrd                     Verify the encoded frame sizes against the HRD/CPB buffer model\n\
+    --verifyParameterSets           Compare the parameter sets written on the CPU with the ones of the implementation\n\
+    --lookahead                     <integer> : Input frames analyzed ahead of the encoded frame to find the scene cuts, 0: disabled (default)\n\
+    --sceneCutThreshold             <integer> : Scene cut sensitivity of the lookahead [1, 100], 0: no IDR at the cuts, default 40\n\
+    --lookaheadThreads              <integer> : Lookahead worker threads, 0: up to 4 (default)\n\
+    --lookaheadAdaptiveQp           Offset the P/B-frame QPs by the lookahead motion complexity when RC is disabled\n\
+    --traceFile                     <string>  : Record per-stage latency spans and write them in the Chrome trace JSON format\n\
+    --shaderCacheDir                <string>  : Directory for the persistent SPIR-V and pipeline cache of the compute filters\n\
     --undershoot_pct                <integer> : Configure undershoot percent used in aom AV1 rate controller\n\
     --overshoot_pct                 <integer> : Configure overshoot percent used in aom AV1 rate controller\n");
 
@@ -257,6 +298,65 @@ int EncoderConfig::ParseArguments(int argc, char *argv[])
                 fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
                 return -1;
             }
+        } else if (args[i] == "--inputFormat") {
+            if (++i >= argc) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+            if (args[i] != "yuv") {
+                input.rgbFormat = VkEncoderRgbConverter::GetRgbFormat(args[i].c_str());
+                if (input.rgbFormat == VkEncoderRgbConverter::RGB_FORMAT_NONE) {
+                    fprintf(stderr, "Invalid inputFormat: %s\nValid string values are yuv, rgba, bgra, rgb, bgr, rgb10a2, bgr10a2\n",
+                            args[i].c_str());
+                    return -1;
+                }
+            }
+        } else if (args[i] == "--inputColorMatrix") {
+            if (++i >= argc) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+            if (args[i] == "bt601") {
+                input.rgbColorStandard = YcbcrBtStandardBt601Ebu;
+            } else if (args[i] == "bt709") {
+                input.rgbColorStandard = YcbcrBtStandardBt709;
+            } else if (args[i] == "bt2020") {
+                input.rgbColorStandard = YcbcrBtStandardBt2020;
+            } else {
+                fprintf(stderr, "Invalid inputColorMatrix: %s\nValid string values are bt601, bt709, bt2020\n", args[i].c_str());
+                return -1;
+            }
+        } else if (args[i] == "--inputFullRange") {
+            input.rgbFullRange = true;
+        } else if (args[i] == "--syntheticInput") {
+            syntheticInput = true;
+        } else if (args[i] == "--syntheticNoiseBits") {
+            if ((++i >= argc) || (sscanf(args[i].c_str(), "%u", &syntheticSource.noiseBits) != 1) ||
+                    (syntheticSource.noiseBits > VkEncoderSyntheticSource::MAX_NOISE_BITS)) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+        } else if (args[i] == "--syntheticMotion") {
+            if ((++i >= argc) || (sscanf(args[i].c_str(), "%u", &syntheticSource.motion) != 1)) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+        } else if (args[i] == "--syntheticTextDensity") {
+            if ((++i >= argc) || (sscanf(args[i].c_str(), "%u", &syntheticSource.textDensity) != 1) ||
+                    (syntheticSource.textDensity > 100)) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+        } else if (args[i] == "--syntheticSceneChangeInterval") {
+            if ((++i >= argc) || (sscanf(args[i].c_str(), "%u", &syntheticSource.sceneChangeInterval) != 1)) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+        } else if (args[i] == "--syntheticSeed") {
+            if ((++i >= argc) || (sscanf(args[i].c_str(), "%u", &syntheticSource.seed) != 1)) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
         } else if (args[i] == "--startFrame") {
             if (++i >= argc || sscanf(args[i].c_str(), "%u", &startFrame) != 1) {
                 fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
@@ -348,7 +448,7 @@ int EncoderConfig::ParseArguments(int argc, char *argv[])
                 fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
                 return -1;
             }
-            if (temporalLayerCount != 1 && temporalLayerCount != 3) {
+            if ((temporalLayerCount < 1) || (temporalLayerCount > VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS)) {
                 fprintf(stderr, "Invalid temporal layer count\n");
                 return -1;
             }
@@ -356,6 +456,43 @@ int EncoderConfig::ParseArguments(int argc, char *argv[])
             if (verbose) {
                 printf("Selected temporalLayerCount: %d\n", temporalLayerCount);
             }
+        } else if (args[i] == "--temporalLayerPattern") {
+            uint32_t values[VkVideoTemporalLayers::MAX_PATTERN_LENGTH];
+            uint8_t pattern[VkVideoTemporalLayers::MAX_PATTERN_LENGTH];
+            uint32_t patternLength = 0;
+            if (++i >= argc || (patternLength = ParseUintList(args[i].c_str(), values, VkVideoTemporalLayers::MAX_PATTERN_LENGTH)) == 0) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+            for (uint32_t p = 0; p < patternLength; p++) {
+                pattern[p] = (uint8_t)std::min<uint32_t>(values[p], 255);
+            }
+            if (!gopStructure.SetTemporalPattern(pattern, patternLength)) {
+                fprintf(stderr, "Invalid temporal layer pattern: it must start with layer 0 and use all the layers up to its highest one, "
+                                "below %d\n", VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS);
+                return -1;
+            }
+            if (verbose) {
+                printf("Selected temporalLayerPattern: %s\n", args[i].c_str());
+            }
+        } else if (args[i] == "--temporalLayerBitrates") {
+            if (++i >= argc || ParseUintList(args[i].c_str(), temporalLayerBitratePercent, VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS) == 0) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+            if (verbose) {
+                printf("Selected temporalLayerBitrates: %s\n", args[i].c_str());
+            }
+        } else if (args[i] == "--intraRefreshPeriod") {
+            uint32_t intraRefreshPeriod = 0;
+            if (++i >= argc || sscanf(args[i].c_str(), "%u", &intraRefreshPeriod) != 1) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+            gopStructure.SetIntraRefreshPeriod(intraRefreshPeriod);
+            if (verbose) {
+                printf("Selected intraRefreshPeriod: %u\n", intraRefreshPeriod);
+            }
         } else if (args[i] == "--lastFrameType") {
             VkVideoGopStructure::FrameType lastFrameType = VkVideoGopStructure::FRAME_TYPE_P;
             std::string frameTypeName = args[i + 1];
@@ -487,10 +624,71 @@ int EncoderConfig::ParseArguments(int argc, char *argv[])
                 return (int)fileSize;
             }
             enableQpMap = true;
+        } else if (args[i] == "--qpMapGenerate") {
+            qpMapGenerate = true;
+            enableQpMap = true;
+        } else if (args[i] == "--qpMapStrength") {
+            if ((++i >= argc) || (sscanf(args[i].c_str(), "%f", &qpMapStrength) != 1) || (qpMapStrength < 0.0f)) {
+                fprintf(stderr, "Invalid paramter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+        } else if (args[i] == "--qpMapStaticDeltaQp") {
+            if ((++i >= argc) || (sscanf(args[i].c_str(), "%d", &qpMapStaticDeltaQp) != 1)) {
+                fprintf(stderr, "Invalid paramter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+        } else if (args[i] == "--qpMapMaxDeltaQp") {
+            if ((++i >= argc) || (sscanf(args[i].c_str(), "%u", &qpMapMaxDeltaQp) != 1) || (qpMapMaxDeltaQp > 51)) {
+                fprintf(stderr, "Invalid paramter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+        } else if (args[i] == "--qpMapRoi") {
+            VkEncoderQpMapGenerator::Roi roi = {};
+            if ((++i >= argc) || (qpMapRoiCount >= VkEncoderQpMapGenerator::MAX_ROI_REGIONS) ||
+                    (sscanf(args[i].c_str(), "%u,%u,%u,%u,%d", &roi.x, &roi.y, &roi.width, &roi.height, &roi.deltaQp) != 5) ||
+                    (roi.width == 0) || (roi.height == 0)) {
+                fprintf(stderr, "Invalid paramter for %s, the regions are x,y,width,height,deltaQp, up to %d of them\n",
+                        args[i - 1].c_str(), VkEncoderQpMapGenerator::MAX_ROI_REGIONS);
+                return -1;
+            }
+            qpMapRois[qpMapRoiCount++] = roi;
         } else if (args[i] == "--testOutOfOrderRecording") {
             // Testing only - don't use this feature for production!
             fprintf(stdout, "Warning: %s should only be used for testing!\n", args[i].c_str());
             enableOutOfOrderRecording = true;
+        } else if (args[i] == "--verifyHrd") {
+            verifyHrd = true;
+        } else if (args[i] == "--verifyParameterSets") {
+            verifyParameterSets = true;
+        } else if (args[i] == "--lookahead") {
+            if (++i >= argc || sscanf(args[i].c_str(), "%u", &lookaheadDepth) != 1) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+        } else if (args[i] == "--sceneCutThreshold") {
+            if (++i >= argc || sscanf(args[i].c_str(), "%u", &sceneCutThreshold) != 1 || (sceneCutThreshold > 100)) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+        } else if (args[i] == "--lookaheadThreads") {
+            if (++i >= argc || sscanf(args[i].c_str(), "%u", &lookaheadThreads) != 1) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+        } else if (args[i] == "--lookaheadAdaptiveQp") {
+            lookaheadAdaptiveQp = true;
+        } else if (args[i] == "--traceFile") {
+            if (++i >= argc) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+            traceFileName = args[i];
+        } else if (args[i] == "--shaderCacheDir") {
+            if (++i >= argc) {
+                fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
+                return -1;
+            }
+            shaderCacheDir = args[i];
         } else if (args[i] == "--undershoot_pct") {
             if (++i >= argc || sscanf(args[i].c_str(), "%u", &undershoot_pct) != 1) {
                 fprintf(stderr, "invalid parameter for %s\n", args[i - 1].c_str());
@@ -507,7 +705,20 @@ int EncoderConfig::ParseArguments(int argc, char *argv[])
         }
     }
 
-    if (!inputFileHandler.HasFileName()) {
+    if (syntheticInput) {
+        if (inputFileHandler.HasFileName()) {
+            fprintf(stderr, "The input can't be both read from a file and generated.\n");
+            return -1;
+        }
+        if (input.rgbFormat != VkEncoderRgbConverter::RGB_FORMAT_NONE) {
+            fprintf(stderr, "The generated input is YUV, it can't have an RGB inputFormat.\n");
+            return -1;
+        }
+        if (numFrames == 0) {
+            fprintf(stderr, "The number of generated frames was not specified\n");
+            return -1;
+        }
+    } else if (!inputFileHandler.HasFileName()) {
         fprintf(stderr, "An input file was not specified\n");
         return -1;
     }
@@ -567,12 +778,95 @@ int EncoderConfig::ParseArguments(int argc, char *argv[])
 
     codecBlockAlignment = H264MbSizeAlignment; // H264
 
-    if (enableQpMap && !qpMapFileHandler.HasFileName()) {
+    if (enableQpMap && !qpMapFileHandler.HasFileName() && !qpMapGenerate) {
         fprintf(stderr, "No qpMap file was provided.");
         return -1;
     }
 
-    frameCount = inputFileHandler.GetFrameCount(input.width, input.height, input.bpp, input.chromaSubsampling);
+    if (qpMapGenerate && qpMapFileHandler.HasFileName()) {
+        fprintf(stderr, "The qpMap can't be both read from a file and generated.\n");
+        return -1;
+    }
+
+    if (gopStructure.GetTemporalLayerCount() > 1) {
+        // The layers are a low delay P structure, the frames only reference the past
+        if (gopStructure.GetConsecutiveBFrameCount() > 0) {
+            fprintf(stderr, "The temporal layers can't be used with B-frames\n");
+            return -1;
+        }
+        uint32_t percentSum = 0, percentCount = 0;
+        for (uint32_t layer = 0; layer < VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS; layer++) {
+            percentSum += temporalLayerBitratePercent[layer];
+            if (temporalLayerBitratePercent[layer] != 0) {
+                percentCount = layer + 1;
+            }
+        }
+        if ((percentSum != 0) && ((percentSum != 100) || (percentCount != gopStructure.GetTemporalLayerCount()))) {
+            fprintf(stderr, "The temporal layer bitrates must give the percentage of each of the %d layers and add up to 100\n",
+                    gopStructure.GetTemporalLayerCount());
+            return -1;
+        }
+    }
+
+    if (gopStructure.GetIntraRefreshPeriod() > 0) {
+        if (codec == VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR) {
+            fprintf(stderr, "The intra refresh is only supported with H.264 and H.265\n");
+            return -1;
+        }
+        if (gopStructure.GetTemporalLayerCount() > 1) {
+            fprintf(stderr, "The intra refresh requires a single temporal layer\n");
+            return -1;
+        }
+    }
+
+    if (input.rgbFormat != VkEncoderRgbConverter::RGB_FORMAT_NONE) {
+        // The lookahead and the QP map generator analyze the luma of the input file
+        if ((lookaheadDepth > 0) || qpMapGenerate) {
+            fprintf(stderr, "The lookahead and the generated qpMap need a YUV input file.\n");
+            return -1;
+        }
+
+        // Signal the matrix and range of the conversion
+        static const struct {
+            YcbcrBtStandard standard;
+            uint8_t         colourPrimaries;
+            uint8_t         transferCharacteristics;
+            uint8_t         matrixCoefficients;
+        } colorDescriptions[] = {
+            { YcbcrBtStandardBt709,    1,  1, 1 },
+            { YcbcrBtStandardBt601Ebu, 6,  6, 6 },  // SMPTE 170M, the BT.601 matrix
+            { YcbcrBtStandardBt2020,   9, 14, 9 },  // non-constant luminance
+        };
+        for (uint32_t d = 0; d < sizeof(colorDescriptions) / sizeof(colorDescriptions[0]); d++) {
+            if (colorDescriptions[d].standard == input.rgbColorStandard) {
+                video_signal_type_present_flag = 1;
+                video_format = 5; // unspecified video format
+                video_full_range_flag = input.rgbFullRange ? 1 : 0;
+                color_description_present_flag = 1;
+                colour_primaries = colorDescriptions[d].colourPrimaries;
+                transfer_characteristics = colorDescriptions[d].transferCharacteristics;
+                matrix_coefficients = colorDescriptions[d].matrixCoefficients;
+            }
+        }
+
+        frameCount = inputFileHandler.GetFrameCount(input.GetRgbFrameSize());
+    } else if (syntheticInput) {
+        // The lookahead and the QP map generator read the input file, and the
+        // frames are generated as NV12 or P010.
+        if ((lookaheadDepth > 0) || qpMapGenerate) {
+            fprintf(stderr, "The lookahead and the generated qpMap need an input file.\n");
+            return -1;
+        }
+        if ((input.chromaSubsampling != VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR) ||
+                ((input.bpp != 8) && (input.bpp != 10))) {
+            fprintf(stderr, "The generated input is 4:2:0 of 8 or 10 bits.\n");
+            return -1;
+        }
+
+        frameCount = numFrames;
+    } else {
+        frameCount = inputFileHandler.GetFrameCount(input.width, input.height, input.bpp, input.chromaSubsampling);
+    }
 
     if (numFrames == 0 || numFrames > frameCount) {
         std::cout << "numFrames " << numFrames
@@ -732,3 +1026,92 @@ bool EncoderConfig::InitRateControl()
 
     return true;
 }
+
+bool EncoderConfig::UpdateRateControl(uint32_t averageBitrate, uint32_t maxBitrate, uint32_t cpbSize)
+{
+    uint32_t currentMaxBitrate = 0, currentCpbSize = 0, currentInitialDelay = 0;
+    if (!GetHrdBufferParameters(currentMaxBitrate, currentCpbSize, currentInitialDelay)) {
+        return false;
+    }
+
+    const uint32_t levelBitRate = GetLevelBitrateLimit();
+
+    if (averageBitrate == 0) {
+        averageBitrate = totalBitrate;
+    }
+
+    if (maxBitrate == 0) {
+        // Keep the peak rate, but never below the new average bitrate
+        maxBitrate = std::max(currentMaxBitrate, averageBitrate);
+    }
+
+    maxBitrate = std::min(maxBitrate, levelBitRate);
+
+    // avg bitrate must not be higher than max bitrate,
+    averageBitrate = std::min(averageBitrate, maxBitrate);
+
+    if (rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_CBR_BIT_KHR) {
+        maxBitrate = averageBitrate;
+    }
+
+    if (averageBitrate == 0) {
+        return false;
+    }
+
+    if (cpbSize == 0) {
+        cpbSize = currentCpbSize;
+    }
+
+    // Keep the same relative initial CPB fullness
+    uint32_t initialDelay = (currentCpbSize != 0) ?
+                                (uint32_t)(((uint64_t)currentInitialDelay * cpbSize) / currentCpbSize) :
+                                (cpbSize - cpbSize / 10);
+    initialDelay = std::min(initialDelay, cpbSize);
+
+    totalBitrate = averageBitrate;
+
+    if (!SetHrdBufferParameters(maxBitrate, cpbSize, initialDelay)) {
+        return false;
+    }
+
+    InitRateControlLayers();
+    return true;
+}
+
+void EncoderConfig::InitRateControlLayers()
+{
+    // Default share of the bitrate of each layer, for 1 to 4 layers
+    static const uint32_t defaultLayerPercent[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS][VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS] = {
+        { 100,  0,  0,  0 },
+        {  60, 40,  0,  0 },
+        {  40, 20, 40,  0 },
+        {  35, 15, 20, 30 },
+    };
+
+    const VkVideoTemporalLayers& temporalLayers = gopStructure.GetTemporalLayers();
+    const uint32_t layerCount = temporalLayers.GetTemporalLayerCount();
+    const uint32_t patternLength = temporalLayers.GetTemporalPatternLength();
+    const bool customPercent = (temporalLayerBitratePercent[0] != 0);
+    const uint32_t maxBitrate = hrdBitrate ? hrdBitrate : totalBitrate;
+
+    if (verbose) {
+        std::cout << "Initializing RC. totalBitrate: " << totalBitrate << ", hrdBitrate: " << hrdBitrate << ". Initializing layers" << std::endl;
+    }
+
+    for (uint32_t i = 0; i < layerCount; i++) {
+        const uint32_t percent = customPercent ? temporalLayerBitratePercent[i] : defaultLayerPercent[layerCount - 1][i];
+        const uint32_t layerFrameCount = temporalLayers.GetLayerFrameCount(i);
+        layerConfigs[i].averageBitrate = (uint32_t)(((uint64_t)totalBitrate * percent) / 100);
+        layerConfigs[i].maxBitrate = (uint32_t)(((uint64_t)maxBitrate * percent) / 100);
+        // With the dyadic pattern of 3 layers, 1/4 framerate in base layer, 1/2 framerate in layer 1
+        // and the full framerate in layer 2
+        layerConfigs[i].frameRateDecimator = (int)((patternLength + layerFrameCount / 2) / layerFrameCount);
+        layerConfigs[i].frameRateNumerator = frameRateNumerator * layerFrameCount;
+        layerConfigs[i].frameRateDenominator = frameRateDenominator * patternLength;
+        if (verbose) {
+            std::cout << "Configured layer " << i << " <avgBitrate: " << layerConfigs[i].averageBitrate
+                << ", maxBitrate: " << layerConfigs[i].maxBitrate << ", decimator: " << layerConfigs[i].frameRateDecimator
+                << ">" << std::endl;
+        }
+    }
+}
@@ -19,7 +19,10 @@
 
 #include <assert.h>
 #include <string.h>
+#include <algorithm>
 #include <atomic>
+#include <string>
+#include <vector>
 #include "mio/mio.hpp"
 #include "vk_video/vulkan_video_codecs_common.h"
 #include "vk_video/vulkan_video_codec_h264std.h"
@@ -29,6 +32,9 @@
 #include "VkCodecUtils/VkVideoRefCountBase.h"
 #include "VkVideoEncoder/VkVideoEncoderDef.h"
 #include "VkVideoEncoder/VkVideoGopStructure.h"
+#include "VkVideoEncoder/VkEncoderQpMapGenerator.h"
+#include "VkVideoEncoder/VkEncoderRgbConverter.h"
+#include "VkVideoEncoder/VkEncoderSyntheticSource.h"
 #include "VkVideoCore/VkVideoCoreProfile.h"
 #include "VkVideoCore/VulkanVideoCapabilities.h"
 #include "VkCodecUtils/VulkanFilterYuvCompute.h"
@@ -100,6 +106,9 @@ struct EncoderInputImageParameters
     , planeLayouts{}
     , fullImageSize(0)
     , vkFormat(VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM)
+    , rgbFormat(VkEncoderRgbConverter::RGB_FORMAT_NONE)
+    , rgbColorStandard(YcbcrBtStandardBt709)
+    , rgbFullRange(false)
     {}
 
 public:
@@ -112,6 +121,17 @@ public:
     VkSubresourceLayout planeLayouts[3];
     uint64_t fullImageSize;
     VkFormat vkFormat;
+    // Packed RGB input, converted on the CPU to the 4:2:0 YCbCr of bpp bits
+    VkEncoderRgbConverter::RgbFormat rgbFormat;
+    YcbcrBtStandard rgbColorStandard;
+    bool rgbFullRange;
+
+    // The size of a frame of the packed RGB input, a single plane.
+    uint64_t GetRgbFrameSize() const
+    {
+        const uint64_t rowSize = (uint64_t)width * VkEncoderRgbConverter::GetBytesPerPixel(rgbFormat);
+        return std::max<uint64_t>(planeLayouts[0].rowPitch, rowSize) * height;
+    }
 
     bool VerifyInputs()
     {
@@ -120,6 +140,25 @@ public:
             return false;
         }
 
+        if (rgbFormat != VkEncoderRgbConverter::RGB_FORMAT_NONE) {
+            if ((chromaSubsampling != VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR) || ((bpp != 8) && (bpp != 10))) {
+                fprintf(stderr, "The RGB input is only converted to 4:2:0 with 8 or 10 bpp, not %d bpp!", bpp);
+                return false;
+            }
+
+            planeLayouts[0].rowPitch = std::max<VkDeviceSize>(planeLayouts[0].rowPitch,
+                                                              (VkDeviceSize)width * VkEncoderRgbConverter::GetBytesPerPixel(rgbFormat));
+            planeLayouts[0].offset = 0;
+            planeLayouts[0].size = planeLayouts[0].rowPitch * height;
+            fullImageSize = GetRgbFrameSize();
+
+            // The format of the converted frames, as the staging images hold them
+            vkFormat = VkVideoCoreProfile::CodecGetVkFormat(chromaSubsampling,
+                                                            GetComponentBitDepthFlagBits(bpp),
+                                                            true);
+            return (vkFormat != VK_FORMAT_UNDEFINED);
+        }
+
         uint32_t bytesPerPixel = (bpp + 7) / 8;
         if ((bytesPerPixel < 1) || (bytesPerPixel > 2)) {
             fprintf(stderr, "Invalid input bpp (%d) parameter!", bpp);
@@ -270,6 +309,28 @@ public:
         return m_memMapedFile.data() + offset;
     }
 
+    // The start of the first numFrames frames, found in a single pass over the
+    // Y4M frame headers. Unlike GetMappedPtr(), the returned table can be used
+    // from any thread, since it does not touch the file handle.
+    std::vector<const uint8_t*> GetMappedFramePtrs(uint64_t frameSize, uint64_t numFrames)
+    {
+        assert(m_memMapedFile.is_mapped());
+        std::vector<const uint8_t*> frames;
+        const uint64_t mappedLength = (uint64_t)m_memMapedFile.mapped_length();
+        uint64_t offset = m_Y4MHeaderOffset;
+        for (uint64_t frame_i = 0; frame_i < numFrames; frame_i++) {
+            if (m_Y4MHeaderOffset) {
+                offset += skipY4MFrameHeader(offset);
+            }
+            if (mappedLength < (offset + frameSize)) {
+                break;
+            }
+            frames.push_back(m_memMapedFile.data() + offset);
+            offset += frameSize;
+        }
+        return frames;
+    }
+
     bool parseY4M (uint32_t *width, uint32_t *height, uint32_t *fps_n, uint32_t *fps_d)
     {
         size_t i, j, s;
@@ -410,6 +471,13 @@ beach:
         return 0;
     }
 
+    uint32_t GetFrameCount(uint64_t frameSize) {
+        if (frameSize)
+            return (uint32_t)(GetFileSize() / frameSize);
+
+        return 0;
+    }
+
 private:
     size_t OpenFile()
     {
@@ -644,9 +712,12 @@ private:
 
 struct LayerConfig {
     public:
-        uint32_t averageBitrate; // kbits/sec
-        uint32_t maxBitrate;     // kbits/sec
+        uint32_t averageBitrate; // kbits/sec, of this layer only
+        uint32_t maxBitrate;     // kbits/sec, of this layer only
         int frameRateDecimator;
+        // Frame rate of the layer and all the layers below it
+        uint32_t frameRateNumerator;
+        uint32_t frameRateDenominator;
 };
 
 struct EncoderConfig : public VkVideoRefCountBase {
@@ -697,7 +768,9 @@ public:
     VkVideoEncodeRateControlModeFlagBitsKHR rateControlMode;
     uint32_t totalBitrate;    // kbits/sec
     uint32_t maxTotalBitrate; // kbits/sec
-    LayerConfig layerConfigs[3];
+    LayerConfig layerConfigs[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
+    // Share of the bitrate of each temporal layer in percent, all zero for the defaults
+    uint32_t temporalLayerBitratePercent[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
     uint32_t hrdBitrate;
     uint32_t frameRateNumerator;
     uint32_t frameRateDenominator;
@@ -707,7 +780,13 @@ public:
     ConstQpSettings constQp;
 
     uint32_t enableQpMap : 1;
+    uint32_t qpMapGenerate : 1;             // Generate the QP map from the input content instead of a file
     QpMapMode qpMapMode;
+    float    qpMapStrength;                 // Activity masking strength of the generated QP map, 0: disabled
+    int32_t  qpMapStaticDeltaQp;            // Delta QP of the static texels of the generated QP map, 0: disabled
+    uint32_t qpMapMaxDeltaQp;               // Maximum absolute delta QP of the generated QP map
+    uint32_t qpMapRoiCount;
+    VkEncoderQpMapGenerator::Roi qpMapRois[VkEncoderQpMapGenerator::MAX_ROI_REGIONS];
 
     VkVideoGopStructure gopStructure;
     int8_t dpbCount;
@@ -739,8 +818,11 @@ public:
     uint8_t  chroma_sample_loc_type;
 
     EncoderInputFileHandler inputFileHandler;
+    VkEncoderSyntheticSource::Config syntheticSource;   // The content generated in place of the input file
     EncoderOutputFileHandler outputFileHandler;
     EncoderQpMapFileHandler qpMapFileHandler;
+    std::string traceFileName;              // Chrome trace JSON output of the per-stage latency spans
+    std::string shaderCacheDir;             // Persistent SPIR-V and pipeline cache of the compute filters
 
     VulkanFilterYuvCompute::FilterType filterType;
 
@@ -756,6 +838,14 @@ public:
     uint32_t selectVideoWithComputeQueue : 1;
     uint32_t enablePreprocessComputeFilter : 1;
     uint32_t enableOutOfOrderRecording : 1; // Testing only - don't use for production!
+    uint32_t verifyHrd : 1;                 // Run the CPB (leaky bucket) verifier on the encoded frame sizes
+    uint32_t verifyParameterSets : 1;       // Compare the parameter sets written on the CPU with the implementation's
+    uint32_t lookaheadAdaptiveQp : 1;       // Offset the P/B QPs by the lookahead complexity when RC is disabled
+    uint32_t syntheticInput : 1;            // Generate the input frames instead of reading an input file
+
+    uint32_t lookaheadDepth;                // Input frames analyzed ahead of the encoded frame, 0: no lookahead
+    uint32_t sceneCutThreshold;             // 0: no scene cut IDRs, 1..100: higher values detect more cuts
+    uint32_t lookaheadThreads;              // 0: up to 4, depending on the CPU
 
     int undershoot_pct;
     int overshoot_pct;
@@ -792,7 +882,9 @@ public:
     , quantizationMapCapabilities()
     , rateControlMode(VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DEFAULT_KHR)
     , totalBitrate()
+    , maxTotalBitrate()
     , layerConfigs()
+    , temporalLayerBitratePercent()
     , hrdBitrate(totalBitrate)
     , frameRateNumerator()
     , frameRateDenominator()
@@ -800,7 +892,13 @@ public:
     , maxQp(-1)
     , constQp()
     , enableQpMap(false)
+    , qpMapGenerate(false)
     , qpMapMode(DELTA_QP_MAP)
+    , qpMapStrength(1.0f)
+    , qpMapStaticDeltaQp(VkEncoderQpMapGenerator::DEFAULT_STATIC_DELTA_QP)
+    , qpMapMaxDeltaQp(VkEncoderQpMapGenerator::DEFAULT_MAX_DELTA_QP)
+    , qpMapRoiCount(0)
+    , qpMapRois()
     , gopStructure(DEFAULT_GOP_FRAME_COUNT,
                    DEFAULT_GOP_IDR_PERIOD,
                    DEFAULT_CONSECUTIVE_B_FRAME_COUNT,
@@ -832,6 +930,7 @@ public:
     , max_dec_frame_buffering()
     , chroma_sample_loc_type()
     , inputFileHandler()
+    , syntheticSource()
     , filterType(VulkanFilterYuvCompute::YCBCRCOPY)
     , validate(false)
     , validateVerbose(false)
@@ -845,6 +944,13 @@ public:
     , selectVideoWithComputeQueue(false)
     , enablePreprocessComputeFilter(false)
     , enableOutOfOrderRecording(false)
+    , verifyHrd(false)
+    , verifyParameterSets(false)
+    , lookaheadAdaptiveQp(false)
+    , syntheticInput(false)
+    , lookaheadDepth(0)
+    , sceneCutThreshold(40)
+    , lookaheadThreads(0)
     , undershoot_pct(50)
     , overshoot_pct(50)
     { }
@@ -954,6 +1060,28 @@ public:
     virtual bool InitRateControl();
 
     virtual uint8_t GetMaxBFrameCount() { return 0;}
+
+    // Splits totalBitrate and the HRD bitrate between the temporal layers, after InitRateControl()
+    // and on each runtime rate control change.
+    void InitRateControlLayers();
+
+    // The HRD bitrate (bits/sec), CPB size and initial CPB delay (bits) after InitRateControl()
+    virtual bool GetHrdBufferParameters(uint32_t& bitRate, uint32_t& cpbSize, uint32_t& initialDelay) { return false; }
+
+    // Replaces the values returned by GetHrdBufferParameters() on a runtime rate control change
+    virtual bool SetHrdBufferParameters(uint32_t bitRate, uint32_t cpbSize, uint32_t initialDelay) { return false; }
+
+    // The highest bitrate (bits/sec) the level selected by InitRateControl() allows
+    virtual uint32_t GetLevelBitrateLimit() { return 120000000u; }
+
+    // The range of the delta QP map values (the delta qindex for AV1) after InitDeviceCapabilities()
+    virtual bool GetQuantizationMapDeltaRange(int32_t& minDelta, int32_t& maxDelta) { return false; }
+
+    // Runtime rate control change after InitRateControl(), a value of 0 keeps the current one.
+    // The bitrates are constrained the way InitRateControl() does it, against the level
+    // selected at initialization: the level and the HRD parameters of the SPS / sequence
+    // header keep their initial values.
+    bool UpdateRateControl(uint32_t averageBitrate, uint32_t maxBitrate, uint32_t cpbSize);
 };
 
 // Create codec configuration for H.264 encoder
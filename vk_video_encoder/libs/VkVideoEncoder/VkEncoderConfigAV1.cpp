@@ -164,9 +164,33 @@ int EncoderConfigAV1::DoParseArguments(int argc, char* argv[])
     return 0;
 }
 
-bool EncoderConfigAV1::InitSequenceHeader(StdVideoAV1SequenceHeader *seqHdr)
+bool EncoderConfigAV1::InitSequenceHeader(StdVideoAV1SequenceHeader *seqHdr, StdVideoAV1ColorConfig* pColorConfig)
 {
     memset(seqHdr, 0, sizeof(StdVideoAV1SequenceHeader));
+    memset(pColorConfig, 0, sizeof(StdVideoAV1ColorConfig));
+
+    // The session parameters carry the color_config() and seq_profile of the
+    // encoder configuration, as the sequence header written on the CPU does.
+    // They used to be created without a color config and with seq_profile 0,
+    // leaving them to the implementation, which a sequence header written on
+    // the CPU can't match, and which disagreed with the session's profile for
+    // the High and Professional profiles.
+    pColorConfig->BitDepth = encodeBitDepthLuma;
+    pColorConfig->flags.mono_chrome = (encodeChromaSubsampling == VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR) ? 1 : 0;
+    pColorConfig->subsampling_x = (encodeChromaSubsampling != VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR) ? 1 : 0;
+    pColorConfig->subsampling_y = ((encodeChromaSubsampling == VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR) ||
+                                   (encodeChromaSubsampling == VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR)) ? 1 : 0;
+    pColorConfig->flags.color_range = video_full_range_flag;
+    pColorConfig->flags.color_description_present_flag = color_description_present_flag;
+    pColorConfig->color_primaries = color_description_present_flag ? (StdVideoAV1ColorPrimaries)colour_primaries :
+                                                                     STD_VIDEO_AV1_COLOR_PRIMARIES_UNSPECIFIED;
+    pColorConfig->transfer_characteristics = color_description_present_flag ? (StdVideoAV1TransferCharacteristics)transfer_characteristics :
+                                                                              STD_VIDEO_AV1_TRANSFER_CHARACTERISTICS_UNSPECIFIED;
+    pColorConfig->matrix_coefficients = color_description_present_flag ? (StdVideoAV1MatrixCoefficients)matrix_coefficients :
+                                                                         STD_VIDEO_AV1_MATRIX_COEFFICIENTS_UNSPECIFIED;
+    pColorConfig->chroma_sample_position = STD_VIDEO_AV1_CHROMA_SAMPLE_POSITION_UNKNOWN;
+    seqHdr->pColorConfig = pColorConfig;
+    seqHdr->seq_profile = profile;
 
     seqHdr->max_frame_width_minus_1 = (uint16_t)(encodeWidth - 1);
     seqHdr->max_frame_height_minus_1 = (uint16_t)(encodeHeight - 1);
@@ -183,6 +207,32 @@ bool EncoderConfigAV1::InitSequenceHeader(StdVideoAV1SequenceHeader *seqHdr)
     return true;
 }
 
+uint32_t EncoderConfigAV1::InitOperatingPoints(StdVideoEncodeAV1OperatingPointInfo* pOperatingPoints, uint32_t maxOperatingPoints)
+{
+    const uint32_t temporalLayerCount = gopStructure.GetTemporalLayerCount();
+    assert(temporalLayerCount <= maxOperatingPoints);
+
+    memset(pOperatingPoints, 0, sizeof(StdVideoEncodeAV1OperatingPointInfo) * maxOperatingPoints);
+
+    if (temporalLayerCount == 1) {
+        // operating_point_idc 0: a single operating point with all the OBUs
+        pOperatingPoints[0].seq_level_idx = (uint8_t)level;
+        pOperatingPoints[0].seq_tier = tier;
+        return 1;
+    }
+
+    // Operating point 0 is the full frame rate, the following ones drop the highest temporal layer
+    // of the previous one. The spatial layer 0 is bit 8 of operating_point_idc.
+    for (uint32_t op = 0; op < temporalLayerCount; op++) {
+        const uint32_t temporalLayerMask = (1U << (temporalLayerCount - op)) - 1;
+        pOperatingPoints[op].operating_point_idc = (uint16_t)((1U << 8) | temporalLayerMask);
+        pOperatingPoints[op].seq_level_idx = (uint8_t)level;
+        pOperatingPoints[op].seq_tier = tier;
+    }
+
+    return temporalLayerCount;
+}
+
 VkResult EncoderConfigAV1::InitDeviceCapabilities(const VulkanDeviceContext* vkDevCtx)
 {
     VkResult result = VulkanVideoCapabilities::GetVideoEncodeCapabilities<VkVideoEncodeAV1CapabilitiesKHR, VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_CAPABILITIES_KHR,
@@ -382,38 +432,6 @@ bool EncoderConfigAV1::InitRateControl()
     maxQIndex.predictiveQIndex   = maxq;
     maxQIndex.bipredictiveQIndex = maxq;
 
-    float layerRatio[3] = {
-        0.4,
-        0.2,
-        0.4,
-    };
-    // LIBAOM uses cumulative bitrates
-    if (rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR) {
-        layerRatio[1] = 0.6;
-        layerRatio[2] = 1.0;
-    }
-    if(gopStructure.GetTemporalLayerCount() == 1) {
-        layerRatio[0] = 1.0;
-    }
-
-    if (verbose) {
-        std::cout << "Initializing RC. totalBitrate: " << totalBitrate << ", hrdBitrate: " << hrdBitrate << ". Initializing layers" << std::endl;
-    }
-    int highest_layer = gopStructure.GetTemporalLayerCount() - 1;
-    for(int i = 0; i < gopStructure.GetTemporalLayerCount(); i++) {
-        layerConfigs[i].averageBitrate = totalBitrate * layerRatio[i];
-        layerConfigs[i].maxBitrate = maxTotalBitrate * layerRatio[i];
-        // 1/4 framerate in base layer
-        // 1/2 framerate in layer 1
-        // full framerate in layer 2
-        layerConfigs[i].frameRateDecimator = pow(2, highest_layer-i);
-        if (verbose) {
-            std::cout << "Configured layer " << i << " <avgBitrate: " << layerConfigs[i].averageBitrate
-                << ", maxBitrate: " << layerConfigs[i].maxBitrate << ", decimator: " << layerConfigs[i].frameRateDecimator
-                << ">" << std::endl;
-        }
-    }
-
     return true;
 }
 
@@ -425,8 +443,8 @@ bool EncoderConfigAV1::GetRateControlParameters(VkVideoEncodeRateControlInfoKHR*
     for (int i = 0; i < gopStructure.GetTemporalLayerCount(); i++) {
         pRcLayerInfo[i].averageBitrate = layerConfigs[i].averageBitrate;
         pRcLayerInfo[i].maxBitrate = layerConfigs[i].maxBitrate;
-        pRcLayerInfo[i].frameRateNumerator = frameRateNumerator;
-        pRcLayerInfo[i].frameRateDenominator = frameRateDenominator * layerConfigs[i].frameRateDecimator;
+        pRcLayerInfo[i].frameRateNumerator = layerConfigs[i].frameRateNumerator;
+        pRcLayerInfo[i].frameRateDenominator = layerConfigs[i].frameRateDenominator;
     }
 
     if (rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DEFAULT_KHR) {
@@ -447,7 +465,8 @@ bool EncoderConfigAV1::GetRateControlParameters(VkVideoEncodeRateControlInfoKHR*
     }
 
     if (gopStructure.GetTemporalLayerCount() > 1) {
-        pRcInfoAV1->flags = VK_VIDEO_ENCODE_AV1_RATE_CONTROL_TEMPORAL_LAYER_PATTERN_DYADIC_BIT_KHR;
+        pRcInfoAV1->flags = gopStructure.GetTemporalLayers().IsDyadicPattern() ?
+                                VK_VIDEO_ENCODE_AV1_RATE_CONTROL_TEMPORAL_LAYER_PATTERN_DYADIC_BIT_KHR : 0;
     } else {
         pRcInfoAV1->flags = VK_VIDEO_ENCODE_AV1_RATE_CONTROL_REGULAR_GOP_BIT_KHR;
     }
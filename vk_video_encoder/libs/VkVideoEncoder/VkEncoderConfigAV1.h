@@ -119,12 +119,43 @@ struct EncoderConfigAV1 : public EncoderConfig {
 
     virtual uint8_t GetMaxBFrameCount() override { return  static_cast<uint8_t>(av1EncodeCapabilities.maxBidirectionalCompoundReferenceCount); }
 
+    virtual bool GetHrdBufferParameters(uint32_t& bitRate, uint32_t& cpbSize, uint32_t& initialDelay) override
+    {
+        bitRate = hrdBitrate ? hrdBitrate : totalBitrate;
+        cpbSize = vbvBufferSize;
+        initialDelay = vbvInitialDelay;
+        return (bitRate != 0) && (cpbSize != 0);
+    }
+
+    virtual bool SetHrdBufferParameters(uint32_t bitRate, uint32_t cpbSize, uint32_t initialDelay) override
+    {
+        hrdBitrate = bitRate;
+        maxTotalBitrate = bitRate;
+        vbvBufferSize = cpbSize;
+        vbvInitialDelay = initialDelay;
+        return (bitRate != 0) && (cpbSize != 0);
+    }
+
+    virtual uint32_t GetLevelBitrateLimit() override { return std::min(GetLevelBitrate(), 120000000u); }
+
+    virtual bool GetQuantizationMapDeltaRange(int32_t& minDelta, int32_t& maxDelta) override
+    {
+        minDelta = av1QuantizationMapCapabilities.minQIndexDelta;
+        maxDelta = av1QuantizationMapCapabilities.maxQIndexDelta;
+        return minDelta < maxDelta;
+    }
+
     bool GetRateControlParameters(VkVideoEncodeRateControlInfoKHR* rcInfo,
                                   VkVideoEncodeRateControlLayerInfoKHR* rcLayerInfo,
                                   VkVideoEncodeAV1RateControlInfoKHR* rcInfoAV1,
                                   VkVideoEncodeAV1RateControlLayerInfoKHR* rcLayerInfoAV1);
 
-    bool InitSequenceHeader(StdVideoAV1SequenceHeader* seqHeader);
+    // pColorConfig is set as the color_config() of the sequence header
+    bool InitSequenceHeader(StdVideoAV1SequenceHeader* seqHeader, StdVideoAV1ColorConfig* pColorConfig);
+
+    // One operating point per temporal layer, from all the layers down to the base layer only.
+    // Returns the number of operating points.
+    uint32_t InitOperatingPoints(StdVideoEncodeAV1OperatingPointInfo* pOperatingPoints, uint32_t maxOperatingPoints);
 
     virtual EncoderConfigAV1* GetEncoderConfigAV1() override {
         return this;
@@ -251,7 +251,19 @@ bool EncoderConfigH264::InitSpsPpsParameters(StdVideoH264SequenceParameterSet *s
         sps->max_num_ref_frames = std::min(sps->max_num_ref_frames, (uint8_t)dpbCount);
     }
 
-    if (gopStructure.GetConsecutiveBFrameCount() > 0) {
+    if (gopStructure.GetIntraRefreshPeriod() > 0) {
+        // Predict only from the previous picture, so the pictures after a
+        // completed refresh wave never reference a picture from before it.
+        pps->num_ref_idx_l0_default_active_minus1 = 0;
+        sps->max_num_ref_frames = 1;
+    }
+
+    if (gopStructure.GetTemporalLayerCount() > 1) {
+        // Dropping the higher temporal layers leaves gaps in frame_num, and a custom pattern
+        // may have consecutive non-reference frames, which POC type 2 does not allow.
+        sps->flags.gaps_in_frame_num_value_allowed_flag = true;
+        sps->pic_order_cnt_type = STD_VIDEO_H264_POC_TYPE_0;
+    } else if (gopStructure.GetConsecutiveBFrameCount() > 0) {
         sps->pic_order_cnt_type = STD_VIDEO_H264_POC_TYPE_0;
     } else {
         sps->pic_order_cnt_type = STD_VIDEO_H264_POC_TYPE_2;
@@ -381,6 +393,19 @@ VkResult EncoderConfigH264::InitDeviceCapabilities(const VulkanDeviceContext* vk
 int8_t EncoderConfigH264::InitDpbCount()
 {
     dpbCount = (gopStructure.GetConsecutiveBFrameCount() > 0) ? gopStructure.GetConsecutiveBFrameCount() : 1;
+    if (gopStructure.GetTemporalLayerCount() > 1) {
+        // The sliding window drops the oldest reference first, so all the
+        // references of a temporal pattern must fit for the next layer 0
+        // frame to still find the previous one.
+        const VkVideoTemporalLayers& temporalLayers = gopStructure.GetTemporalLayers();
+        int32_t numPatternReferences = 0;
+        for (uint32_t i = 0; i < temporalLayers.GetTemporalPatternLength(); i++) {
+            if (temporalLayers.CanBeReferenced(i)) {
+                numPatternReferences++;
+            }
+        }
+        dpbCount = (int8_t)std::max<int32_t>(dpbCount, numPatternReferences - 1);
+    }
     // spsInfo->level represents the smallest level that we require for the
     // given stream. This level constrains the maximum size (in terms of
     // number of frames) that the DPB can have. levelDpbSize is this maximum
@@ -398,7 +423,10 @@ int8_t EncoderConfigH264::InitDpbCount()
     uint8_t dpbSize = (uint8_t)((dpbCount < 1) ? levelDpbSize : (uint8_t)(std::min((uint8_t)dpbCount, levelDpbSize)) + 1);
 
     dpbCount = dpbSize;
-    return dpbSize;
+    // One more slot than max_num_ref_frames: the current reference picture
+    // is reconstructed to a slot of its own, while the sliding window still
+    // holds the picture it is about to drop and that it may reference.
+    return (int8_t)(dpbSize + 1);
 }
 
 bool EncoderConfigH264::InitRateControl()
@@ -479,20 +507,22 @@ bool EncoderConfigH264::GetRateControlParameters(VkVideoEncodeRateControlInfoKHR
                                                  VkVideoEncodeH264RateControlInfoKHR *pRateControlInfoH264,
                                                  VkVideoEncodeH264RateControlLayerInfoKHR *pRateControlLayerInfoH264)
 {
-    pRateControlLayersInfo->frameRateNumerator = frameRateNumerator;
-    pRateControlLayersInfo->frameRateDenominator = frameRateDenominator;
-
     pRateControlInfo->rateControlMode = rateControlMode;
 
-    if (pRateControlInfo->rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR) {
-        pRateControlLayerInfoH264->minQp = pRateControlLayerInfoH264->maxQp = minQp;
-    } else {
-        pRateControlLayerInfoH264->minQp = minQp;
-        pRateControlLayerInfoH264->maxQp = maxQp;
-    }
+    // One rate control layer per temporal layer
+    for (uint32_t i = 0; i < gopStructure.GetTemporalLayerCount(); i++) {
+        pRateControlLayersInfo[i].frameRateNumerator = layerConfigs[i].frameRateNumerator;
+        pRateControlLayersInfo[i].frameRateDenominator = layerConfigs[i].frameRateDenominator;
+        pRateControlLayersInfo[i].averageBitrate = layerConfigs[i].averageBitrate;
+        pRateControlLayersInfo[i].maxBitrate = layerConfigs[i].maxBitrate;
 
-    pRateControlLayersInfo->averageBitrate = totalBitrate;
-    pRateControlLayersInfo->maxBitrate = hrdBitrate;
+        if (pRateControlInfo->rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR) {
+            pRateControlLayerInfoH264[i].minQp = pRateControlLayerInfoH264[i].maxQp = minQp;
+        } else {
+            pRateControlLayerInfoH264[i].minQp = minQp;
+            pRateControlLayerInfoH264[i].maxQp = maxQp;
+        }
+    }
 
     if (totalBitrate > 0 || hrdBitrate > 0) {
        pRateControlInfo->virtualBufferSizeInMs = (uint32_t)(vbvBufferSize * 1000ull / (hrdBitrate ? hrdBitrate : totalBitrate));
@@ -500,9 +530,17 @@ bool EncoderConfigH264::GetRateControlParameters(VkVideoEncodeRateControlInfoKHR
     }
 
     pRateControlInfoH264->consecutiveBFrameCount = gopStructure.GetConsecutiveBFrameCount();
+    if ((gopStructure.GetTemporalLayerCount() > 1) && gopStructure.GetTemporalLayers().IsDyadicPattern()) {
+        pRateControlInfoH264->flags |= VK_VIDEO_ENCODE_H264_RATE_CONTROL_TEMPORAL_LAYER_PATTERN_DYADIC_BIT_KHR;
+    }
 
     pRateControlInfoH264->gopFrameCount = (gopStructure.GetGopFrameCount() > 0) ? gopStructure.GetGopFrameCount() : (uint32_t)GOP_LENGTH_DEFAULT;
     pRateControlInfoH264->idrPeriod = (gopStructure.GetIdrPeriod() > 0) ? gopStructure.GetIdrPeriod() : (uint32_t)IDR_PERIOD_DEFAULT;
+    if (gopStructure.GetIntraRefreshPeriod() > 0) {
+        // No I-frames: the rate control must not reserve bits for them
+        pRateControlInfoH264->gopFrameCount = UINT32_MAX;
+        pRateControlInfoH264->idrPeriod = UINT32_MAX;
+    }
 
     return true;
 }
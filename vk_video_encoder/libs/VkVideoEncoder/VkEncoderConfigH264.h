@@ -187,6 +187,34 @@ struct EncoderConfigH264 : public EncoderConfig {
 
     virtual uint8_t GetMaxBFrameCount() { return static_cast<uint8_t>(h264EncodeCapabilities.maxBPictureL0ReferenceCount); }
 
+    virtual bool GetHrdBufferParameters(uint32_t& bitRate, uint32_t& cpbSize, uint32_t& initialDelay)
+    {
+        bitRate = hrdBitrate ? hrdBitrate : totalBitrate;
+        cpbSize = vbvBufferSize;
+        initialDelay = vbvInitialDelay;
+        return (bitRate != 0) && (cpbSize != 0);
+    }
+
+    virtual bool SetHrdBufferParameters(uint32_t bitRate, uint32_t cpbSize, uint32_t initialDelay)
+    {
+        hrdBitrate = bitRate;
+        vbvBufferSize = cpbSize;
+        vbvInitialDelay = initialDelay;
+        return (bitRate != 0) && (cpbSize != 0);
+    }
+
+    virtual uint32_t GetLevelBitrateLimit()
+    {
+        return std::min((uint32_t)levelLimits[levelIdc].maxBR * 800u, uint32_t(120000000));
+    }
+
+    virtual bool GetQuantizationMapDeltaRange(int32_t& minDelta, int32_t& maxDelta)
+    {
+        minDelta = h264QuantizationMapCapabilities.minQpDelta;
+        maxDelta = h264QuantizationMapCapabilities.maxQpDelta;
+        return minDelta < maxDelta;
+    }
+
     bool GetRateControlParameters(VkVideoEncodeRateControlInfoKHR *rcInfo,
                                   VkVideoEncodeRateControlLayerInfoKHR *pRcLayerInfo,
                                   VkVideoEncodeH264RateControlInfoKHR *rcInfoH264,
@@ -476,6 +476,15 @@ bool EncoderConfigH265::InitRateControl()
     return true;
 }
 
+uint32_t EncoderConfigH265::GetLevelBitrateLimit()
+{
+    const uint32_t level = GetLevelTier().general_level_idc;
+    if (level >= levelLimitsTblSize) {
+        return 120000000u;
+    }
+    return std::min(levelLimits[level].maxBitRateMainTier * 800u, 120000000u);
+}
+
 bool EncoderConfigH265::GetRateControlParameters(VkVideoEncodeRateControlInfoKHR *rcInfo,
                                                  VkVideoEncodeRateControlLayerInfoKHR *pRcLayerInfo,
                                                  VkVideoEncodeH265RateControlInfoKHR *rcInfoH265,
@@ -487,10 +496,13 @@ bool EncoderConfigH265::GetRateControlParameters(VkVideoEncodeRateControlInfoKHR
         rcInfo->rateControlMode = rateControlMode;
     }
 
-    pRcLayerInfo->frameRateNumerator = frameRateNumerator;
-    pRcLayerInfo->frameRateDenominator = frameRateDenominator;
-    pRcLayerInfo->averageBitrate = totalBitrate;
-    pRcLayerInfo->maxBitrate = hrdBitrate;
+    // One rate control layer per sub-layer
+    for (uint32_t i = 0; i < gopStructure.GetTemporalLayerCount(); i++) {
+        pRcLayerInfo[i].frameRateNumerator = layerConfigs[i].frameRateNumerator;
+        pRcLayerInfo[i].frameRateDenominator = layerConfigs[i].frameRateDenominator;
+        pRcLayerInfo[i].averageBitrate = layerConfigs[i].averageBitrate;
+        pRcLayerInfo[i].maxBitrate = layerConfigs[i].maxBitrate;
+    }
 
     if ((totalBitrate > 0) || (hrdBitrate > 0)) {
         rcInfo->virtualBufferSizeInMs = (uint32_t)(vbvBufferSize * 1000ull / (hrdBitrate ? hrdBitrate : totalBitrate));
@@ -498,15 +510,25 @@ bool EncoderConfigH265::GetRateControlParameters(VkVideoEncodeRateControlInfoKHR
     }
 
     rcInfoH265->consecutiveBFrameCount = gopStructure.GetConsecutiveBFrameCount();
+    if ((gopStructure.GetTemporalLayerCount() > 1) && gopStructure.GetTemporalLayers().IsDyadicPattern()) {
+        rcInfoH265->flags |= VK_VIDEO_ENCODE_H265_RATE_CONTROL_TEMPORAL_SUB_LAYER_PATTERN_DYADIC_BIT_KHR;
+    }
 
     rcInfoH265->gopFrameCount = (gopStructure.GetGopFrameCount() > 0) ? gopStructure.GetGopFrameCount() : uint32_t(DEFAULT_GOP_FRAME_COUNT);
     rcInfoH265->idrPeriod = (gopStructure.GetIdrPeriod() > 0) ? gopStructure.GetIdrPeriod() : uint32_t(DEFAULT_GOP_IDR_PERIOD);
+    if (gopStructure.GetIntraRefreshPeriod() > 0) {
+        // No I-frames: the rate control must not reserve bits for them
+        rcInfoH265->gopFrameCount = UINT32_MAX;
+        rcInfoH265->idrPeriod = UINT32_MAX;
+    }
 
-    if (rcInfo->rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR) {
-        rcLayerInfoH265->minQp = rcLayerInfoH265->maxQp = minQp;
-    } else {
-        rcLayerInfoH265->minQp = minQp;
-        rcLayerInfoH265->maxQp = maxQp;
+    for (uint32_t i = 0; i < gopStructure.GetTemporalLayerCount(); i++) {
+        if (rcInfo->rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR) {
+            rcLayerInfoH265[i].minQp = rcLayerInfoH265[i].maxQp = minQp;
+        } else {
+            rcLayerInfoH265[i].minQp = minQp;
+            rcLayerInfoH265[i].maxQp = maxQp;
+        }
     }
 
     return true;
@@ -516,8 +538,9 @@ bool EncoderConfigH265::InitParamameters(VpsH265 *vpsInfo, SpsH265 *spsInfo,
                                          StdVideoH265PictureParameterSet *pps,
                                          StdVideoH265SequenceParameterSetVui* vui)
 {
+    // One sub-layer per temporal layer
     uint32_t maxSubLayersMinus1 = (gopStructure.GetTemporalLayerCount() > 0) ? (gopStructure.GetTemporalLayerCount() - 1) : 0;
-    assert(maxSubLayersMinus1 == 0);
+    assert(maxSubLayersMinus1 < STD_VIDEO_H265_SUBLAYERS_LIST_SIZE);
 
     for (uint32_t i = 0; i <= maxSubLayersMinus1; i++) {
         spsInfo->decPicBufMgr.max_latency_increase_plus1[i] = 0;
@@ -593,7 +616,7 @@ bool EncoderConfigH265::InitParamameters(VpsH265 *vpsInfo, SpsH265 *spsInfo,
     }
 
     spsInfo->sps.sps_video_parameter_set_id = vpsId;
-    spsInfo->sps.sps_max_sub_layers_minus1  = 0;
+    spsInfo->sps.sps_max_sub_layers_minus1  = (uint8_t)maxSubLayersMinus1;
     spsInfo->sps.sps_seq_parameter_set_id   = spsId;
     spsInfo->sps.bit_depth_luma_minus8      = (uint8_t)(encodeBitDepthLuma - 8);
     spsInfo->sps.bit_depth_chroma_minus8    = (uint8_t)(encodeBitDepthChroma - 8);
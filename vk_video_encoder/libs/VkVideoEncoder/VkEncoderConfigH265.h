@@ -161,6 +161,31 @@ struct EncoderConfigH265 : public EncoderConfig {
 
     virtual uint8_t GetMaxBFrameCount() { return  static_cast<uint8_t>(h265EncodeCapabilities.maxBPictureL0ReferenceCount); }
 
+    virtual bool GetHrdBufferParameters(uint32_t& bitRate, uint32_t& cpbSize, uint32_t& initialDelay)
+    {
+        bitRate = hrdBitrate ? hrdBitrate : totalBitrate;
+        cpbSize = vbvBufferSize;
+        initialDelay = vbvInitialDelay;
+        return (bitRate != 0) && (cpbSize != 0);
+    }
+
+    virtual bool SetHrdBufferParameters(uint32_t bitRate, uint32_t cpbSize, uint32_t initialDelay)
+    {
+        hrdBitrate = bitRate;
+        vbvBufferSize = cpbSize;
+        vbvInitialDelay = initialDelay;
+        return (bitRate != 0) && (cpbSize != 0);
+    }
+
+    virtual uint32_t GetLevelBitrateLimit();
+
+    virtual bool GetQuantizationMapDeltaRange(int32_t& minDelta, int32_t& maxDelta)
+    {
+        minDelta = h265QuantizationMapCapabilities.minQpDelta;
+        maxDelta = h265QuantizationMapCapabilities.maxQpDelta;
+        return minDelta < maxDelta;
+    }
+
     bool GetRateControlParameters(VkVideoEncodeRateControlInfoKHR *rcInfo,
                                   VkVideoEncodeRateControlLayerInfoKHR *pRcLayerInfo,
                                   VkVideoEncodeH265RateControlInfoKHR *rcInfoH265,
@@ -140,7 +140,7 @@ void VkEncDpbAV1::DpbDeinit()
     m_lastLastRefNameInUse = STD_VIDEO_AV1_REFERENCE_NAME_INVALID;
 
     m_lastKeyFrameTimeStamp = 0;
-    m_temporal_pattern_length_ = 0;
+    m_maxReferenceDistance = 0;
 }
 
 void VkEncDpbAV1::DpbDestroy()
@@ -195,7 +195,9 @@ int32_t VkEncDpbAV1::DpbSequenceStart(const VkSharedBaseObj<EncoderConfigAV1>& e
     m_lastLastRefNameInUse = (numBFrames == 0) ? STD_VIDEO_AV1_REFERENCE_NAME_GOLDEN_FRAME :
                                                  STD_VIDEO_AV1_REFERENCE_NAME_LAST3_FRAME;
 
-    m_temporal_pattern_length_ = encoderConfig->gopStructure.GetTemporalPatternLength();
+    // The previous layer 0 frame, or the previous anchor across the B-frames.
+    m_maxReferenceDistance = std::max<uint32_t>(encoderConfig->gopStructure.GetTemporalPatternLength(),
+                                                (uint32_t)numBFrames + 1U);
 
     return 0;
 }
@@ -809,9 +811,9 @@ void VkEncDpbAV1::SetupReferenceFrameGroups(
     int32_t refFramePocListL1[STD_VIDEO_AV1_NUM_REF_FRAMES];
 
     for (int dpbId = 0; dpbId < m_maxDpbSize; dpbId++) {
-        if (GetRefCount(dpbId) != 0 && VkVideoTemporalLayers::CanReference(gopPos.temporalIdx, m_DPB[dpbId].temporal_idx)) {
+        if (GetRefCount(dpbId) != 0 && VkVideoTemporalLayers::CanReference(gopPos.temporalLayer, m_DPB[dpbId].temporal_layer)) {
             if (m_DPB[dpbId].picOrderCntVal < curPicOrderCntVal) {
-                if (curPicOrderCntVal - m_DPB[dpbId].picOrderCntVal > m_temporal_pattern_length_) {
+                if (curPicOrderCntVal - m_DPB[dpbId].picOrderCntVal > m_maxReferenceDistance) {
                     // Don't reference pics that are too old
                     continue;
                 }
@@ -819,7 +821,10 @@ void VkEncDpbAV1::SetupReferenceFrameGroups(
                 refFramePocListL0[numRefFramesL0] = m_DPB[dpbId].picOrderCntVal;
                 numRefFramesL0++;
             } else {
+#if !defined(VK_VIDEO_GOP_SIMULATOR)
+                // The simulator runs B-frame sequences on purpose.
                 assert(!"Unexpected frame order in test");
+#endif
                 refFrameDpbIdListL1[numRefFramesL1] = dpbId;
                 refFramePocListL1[numRefFramesL1] = m_DPB[dpbId].picOrderCntVal;
                 numRefFramesL1++;
@@ -905,6 +910,19 @@ void VkEncDpbAV1::SetupReferenceFrameGroups(
             m_refNamesInGroup1[numRef] = ref - STD_VIDEO_AV1_REFERENCE_NAME_LAST_FRAME;
             numRef++;
         }
+
+        // With B frames, the previous anchor is held by ALTREF, outside of the
+        // group1 names.  Fall back to a single reference to the closest past picture.
+        if ((numRef == 0) && (numRefFramesL0 > 0) && (m_numRefFramesL0 > 0) && (m_maxSingleReferenceCount > 0)) {
+            for (int32_t ref = STD_VIDEO_AV1_REFERENCE_NAME_LAST_FRAME; ref <= STD_VIDEO_AV1_REFERENCE_NAME_ALTREF_FRAME; ref++) {
+                if (((m_singleReferenceNameMask & (1 << (ref - STD_VIDEO_AV1_REFERENCE_NAME_LAST_FRAME))) != 0) &&
+                    (m_refName2DpbIdx[ref - STD_VIDEO_AV1_REFERENCE_NAME_LAST_FRAME] == refFrameDpbIdListL0[0])) {
+                    m_refNamesInGroup1[numRef] = ref - STD_VIDEO_AV1_REFERENCE_NAME_LAST_FRAME;
+                    numRef++;
+                    break;
+                }
+            }
+        }
         m_numRefFramesInGroup1 = numRef;
 
         // Group 2
@@ -221,7 +221,10 @@ private:
     {
         assert(dpbId < m_maxDpbSize);
         assert(m_DPB[dpbId].refCount > 0);
+#if !defined(VK_VIDEO_GOP_SIMULATOR)
+        // The simulator runs without picture resources.
         assert(m_DPB[dpbId].dpbImageView != nullptr);
+#endif
         if (m_DPB[dpbId].refCount > 0) {
             m_DPB[dpbId].refCount--;
             // release the dpbImageView since it is not needed anymore
@@ -272,7 +275,7 @@ private:
     StdVideoAV1ReferenceName m_lastLastRefNameInUse;
 
     uint64_t        m_lastKeyFrameTimeStamp;
-    uint32_t        m_temporal_pattern_length_;
+    uint32_t        m_maxReferenceDistance;     // in POC, a temporal pattern or a B-frame run
 
 };
 
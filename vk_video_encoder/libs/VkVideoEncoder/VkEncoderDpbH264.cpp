@@ -28,6 +28,7 @@
 #include <stdint.h>
 
 #include "VkEncoderDpbH264.h"
+#include "VkVideoEncoder/VkVideoTemporalLayers.h"
 
 #define VK_DPB_DBG_PRINT(expr) printf expr
 
@@ -213,6 +214,7 @@ int8_t VkEncDpbH264::DpbPictureStart(const PicInfoH264 *pPicInfo,
         pCurDPBEntry->picInfo.frame_num = pPicInfo->frame_num;
         pCurDPBEntry->timeStamp = pPicInfo->timeStamp;
         pCurDPBEntry->frame_is_corrupted = false;
+        pCurDPBEntry->temporalLayer = pPicInfo->temporalLayer;
         if (pPicInfo->flags.IdrPicFlag) {
             m_lastIDRTimeStamp = pPicInfo->timeStamp;
         }
@@ -267,16 +269,20 @@ int8_t VkEncDpbH264::DpbPictureEnd(const PicInfoH264 *pPicInfo,
     if (pPicInfo->flags.is_reference) { // reference picture
         // C.4.5.1
         if (pCurDPBEntry->state == DPB_EMPTY) {
-            while (IsDpbFull()) {
+            // The picture can't be reconstructed to the slot of one of its
+            // references, even of the one its sliding window just dropped.
+            int32_t numBumps = 0;
+            while (IsDpbFull() || ((GetFreeDpbSlot(ref) < 0) && (numBumps < MAX_DPB_SLOTS))) {
                 DpbBumping(true);
+                numBumps++;
             }
 
             // find an empty DPB entry, copy current to it
-            for (m_currDpbIdx = 0; m_currDpbIdx < MAX_DPB_SLOTS; m_currDpbIdx++) {
-                if (m_DPB[m_currDpbIdx].state == DPB_EMPTY)
-                    break;
+            m_currDpbIdx = GetFreeDpbSlot(ref);
+            if (m_currDpbIdx < 0) {
+                m_currDpbIdx = GetFreeDpbSlot(nullptr);
             }
-            if (m_currDpbIdx >= MAX_DPB_SLOTS) {
+            if ((m_currDpbIdx < 0) || (m_currDpbIdx >= MAX_DPB_SLOTS)) {
                 VK_DPB_DBG_PRINT(("could not allocate a frame buffer\n"));
                 exit(1);
             }
@@ -312,7 +318,7 @@ int8_t VkEncDpbH264::DpbPictureEnd(const PicInfoH264 *pPicInfo,
             }
         } else {
             while (1) {
-                if (IsDpbFull()) {
+                if (IsDpbFull() || (GetFreeDpbSlot(ref) < 0)) {
                     int32_t i = 0;
                     // does current have the lowest value of PicOrderCnt?
                     for (; i < MAX_DPB_SLOTS; i++) {
@@ -350,10 +356,8 @@ int8_t VkEncDpbH264::DpbPictureEnd(const PicInfoH264 *pPicInfo,
                         break;  // exit while (1)
                     }
                 } else {
-                    for (m_currDpbIdx = 0; m_currDpbIdx < MAX_DPB_SLOTS; m_currDpbIdx++) {
-                        if (m_DPB[m_currDpbIdx].state == DPB_EMPTY) break;
-                    }
-                    if (m_currDpbIdx >= MAX_DPB_SLOTS) {
+                    m_currDpbIdx = GetFreeDpbSlot(ref);
+                    if ((m_currDpbIdx < 0) || (m_currDpbIdx >= MAX_DPB_SLOTS)) {
                         VK_DPB_DBG_PRINT(("could not allocate a frame buffer\n"));
                         exit(1);
                     }
@@ -401,9 +405,7 @@ void VkEncDpbH264::FillFrameNumGaps(const PicInfoH264 *pPicInfo, const StdVideoH
 
         // (7-10)
         uint32_t unusedShortTermFrameNum = (m_PrevRefFrameNum + 1) % maxFrameNum;
-        while (unusedShortTermFrameNum != picSave.frame_num) {
-            VK_DPB_DBG_PRINT(("gaps_in_frame_num: %d ", unusedShortTermFrameNum));
-
+        while (unusedShortTermFrameNum != pPicInfo->frame_num) {
             if (!sps->flags.gaps_in_frame_num_value_allowed_flag) {
                 VK_DPB_DBG_PRINT(("%s (error)::gap in frame_num not allowed\n", __FUNCTION__));
                 break;
@@ -416,6 +418,22 @@ void VkEncDpbH264::FillFrameNumGaps(const PicInfoH264 *pPicInfo, const StdVideoH
             picSave.flags.adaptive_ref_pic_marking_mode_flag = 0;
 
             // TODO: what else
+            if (sps->pic_order_cnt_type != STD_VIDEO_H264_POC_TYPE_0) CalculatePOC(&picSave, sps);
+            CalculatePicNum(&picSave,sps);
+
+            // The sliding window marks the oldest reference as unused before the
+            // gap frame is stored, so that bumping never drops a reference (C.4.2)
+            SlidingWindowMemoryManagememt(&picSave, sps);
+            for (int32_t i = 0; i < MAX_DPB_SLOTS; i++) {
+                if ((!(m_DPB[i].state & DPB_TOP) ||
+                        (!m_DPB[i].top_needed_for_output && m_DPB[i].top_field_marking == MARKING_UNUSED)) &&
+                        (!(m_DPB[i].state & DPB_BOTTOM) ||
+                         (!m_DPB[i].bottom_needed_for_output && m_DPB[i].bottom_field_marking == MARKING_UNUSED))) {
+                    m_DPB[i].state = DPB_EMPTY;  // empty
+                    ReleaseFrame(m_DPB[i].dpbImageView);
+                }
+            }
+
             // DPB handling (C.4.2)
             while (IsDpbFull()) DpbBumping(true);
             for (m_currDpbIdx = 0; m_currDpbIdx < MAX_DPB_SLOTS; m_currDpbIdx++) {
@@ -426,12 +444,8 @@ void VkEncDpbH264::FillFrameNumGaps(const PicInfoH264 *pPicInfo, const StdVideoH
             if (m_currDpbIdx >= MAX_DPB_SLOTS) VK_DPB_DBG_PRINT(("%s (error)::could not allocate a frame buffer\n", __FUNCTION__));
             // initialize DPB frame buffer
             DpbEntryH264 *pCurDPBEntry = &m_DPB[m_currDpbIdx];
-            pCurDPBEntry->picInfo.frame_num = pPicInfo->frame_num;
+            pCurDPBEntry->picInfo.frame_num = picSave.frame_num;
             pCurDPBEntry->complementary_field_pair = false;
-            if (sps->pic_order_cnt_type != STD_VIDEO_H264_POC_TYPE_0) CalculatePOC(&picSave, sps);
-            CalculatePicNum(&picSave,sps);
-
-            SlidingWindowMemoryManagememt(&picSave, sps);
 
             pCurDPBEntry->top_field_marking = pCurDPBEntry->bottom_field_marking = MARKING_SHORT;
             pCurDPBEntry->reference_picture = true;
@@ -440,17 +454,6 @@ void VkEncDpbH264::FillFrameNumGaps(const PicInfoH264 *pPicInfo, const StdVideoH
             // C.4.2
             pCurDPBEntry->top_needed_for_output = pCurDPBEntry->bottom_needed_for_output = false;
             pCurDPBEntry->state = DPB_FRAME;  // frame
-            // this differs from the standard
-            // empty frame buffers marked as "not needed for output" and "unused for reference"
-            for (int32_t i = 0; i < MAX_DPB_SLOTS; i++) {
-                if ((!(m_DPB[i].state & DPB_TOP) ||
-                        (!m_DPB[i].top_needed_for_output && m_DPB[i].top_field_marking == MARKING_UNUSED)) &&
-                        (!(m_DPB[i].state & DPB_BOTTOM) ||
-                         (!m_DPB[i].bottom_needed_for_output && m_DPB[i].bottom_field_marking == MARKING_UNUSED))) {
-                    m_DPB[i].state = DPB_EMPTY;  // empty
-                    ReleaseFrame(m_DPB[i].dpbImageView);
-                }
-            }
 
             // 7.4.3
             m_PrevRefFrameNum = pPicInfo->frame_num;  // TODO: only if previous picture was a reference picture?
@@ -477,6 +480,54 @@ bool VkEncDpbH264::IsDpbFull()
     return dpb_fullness >= m_max_dpb_size;
 }
 
+static bool IsInReferenceLists(const StdVideoEncodeH264ReferenceListsInfo *ref, int32_t dpbIdx)
+{
+    if (ref == nullptr) {
+        return false;
+    }
+
+    for (uint32_t i = 0; (i <= ref->num_ref_idx_l0_active_minus1) && (i < STD_VIDEO_H264_MAX_NUM_LIST_REF); i++) {
+        if (ref->RefPicList0[i] == dpbIdx) {
+            return true;
+        }
+    }
+    for (uint32_t i = 0; (i <= ref->num_ref_idx_l1_active_minus1) && (i < STD_VIDEO_H264_MAX_NUM_LIST_REF); i++) {
+        if (ref->RefPicList1[i] == dpbIdx) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int32_t VkEncDpbH264::GetFreeDpbSlot(const StdVideoEncodeH264ReferenceListsInfo *ref) const
+{
+    for (int32_t i = 0; i < MAX_DPB_SLOTS; i++) {
+        if ((m_DPB[i].state == DPB_EMPTY) && !IsInReferenceLists(ref, i)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int8_t VkEncDpbH264::GetNonReferenceSetupSlot(const StdVideoEncodeH264ReferenceListsInfo *ref) const
+{
+    for (int32_t i = 0; i < m_max_dpb_size; i++) {
+        if ((m_DPB[i].state == DPB_EMPTY) && !IsInReferenceLists(ref, i)) {
+            return (int8_t)i;
+        }
+    }
+    for (int32_t i = 0; i < m_max_dpb_size; i++) {
+        if ((m_DPB[i].top_field_marking == MARKING_UNUSED) && (m_DPB[i].bottom_field_marking == MARKING_UNUSED) &&
+                !IsInReferenceLists(ref, i)) {
+            return (int8_t)i;
+        }
+    }
+
+    return -1;
+}
+
 bool VkEncDpbH264::IsDpbEmpty()
 {
     int32_t dpb_fullness, i;
@@ -1260,7 +1311,7 @@ int32_t VkEncDpbH264::SortListDescending(RefPicListEntry *RefPicListX, const Std
                 continue;
             }
 
-            if ((m_DPB[i].frame_is_corrupted == true) && (bSkipCorruptFrames == true)) {
+            if (bSkipCorruptFrames && IsSkippedReference(i)) {
                 continue;
             }
 
@@ -1294,7 +1345,7 @@ int32_t VkEncDpbH264::SortListAscending(RefPicListEntry *RefPicListX, const StdV
                 continue;
             }
 
-            if ((m_DPB[i].frame_is_corrupted == true) && (bSkipCorruptFrames == true)) {
+            if (bSkipCorruptFrames && IsSkippedReference(i)) {
                 continue;
             }
 
@@ -1682,7 +1733,7 @@ bool VkEncDpbH264::NeedToReorder()
 {
     for (int32_t i = 0; i < MAX_DPB_SLOTS; i++) {
         if ((m_DPB[i].top_field_marking != 0) || (m_DPB[i].bottom_field_marking != 0)) {
-            if (m_DPB[i].frame_is_corrupted) {
+            if (IsSkippedReference(i)) {
                 return true;
             }
         }
@@ -1690,6 +1741,15 @@ bool VkEncDpbH264::NeedToReorder()
 
     return false;
 }
+
+bool VkEncDpbH264::IsSkippedReference(int32_t dpbIdx) const
+{
+    if (m_DPB[dpbIdx].frame_is_corrupted) {
+        return true;
+    }
+
+    return !VkVideoTemporalLayers::CanReference(m_DPB[m_currDpbIdx].temporalLayer, m_DPB[dpbIdx].temporalLayer);
+}
 void VkEncDpbH264::FillStdReferenceInfo(uint8_t dpbIdx, StdVideoEncodeH264ReferenceInfo* pStdReferenceInfo)
 {
     assert(dpbIdx < MAX_DPB_SLOTS);
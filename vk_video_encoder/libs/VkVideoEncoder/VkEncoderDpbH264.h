@@ -59,12 +59,16 @@ struct DpbEntryH264 {
 
     uint64_t timeStamp;
     uint64_t refFrameTimeStamp;
+
+    // Temporal layer of the frame, only referenced by the frames it can be referenced from
+    uint32_t temporalLayer;
 };
 
 struct PicInfoH264 : public StdVideoEncodeH264PictureInfo {
     uint32_t field_pic_flag : 1;
     uint32_t bottom_field_flag : 1;
     uint64_t timeStamp;
+    uint32_t temporalLayer;
 };
 
 typedef bool (*ptrFuncDpbSort)(const DpbEntryH264 *, StdVideoH264PocType, int32_t *);
@@ -146,14 +150,26 @@ public:
 
     int32_t GetValidEntries(DpbEntryH264 entries[MAX_DPB_SLOTS]);
     uint32_t GetUsedFbSlotsMask();
+    // Returns true if the active reference list contains corrupted pictures or pictures
+    // the temporal layer of the current picture can't reference.
     bool NeedToReorder();
     void FillStdReferenceInfo(uint8_t dpbIdx, StdVideoEncodeH264ReferenceInfo* pStdReferenceInfo);
+    // The slot a non-reference picture that DpbPictureEnd() didn't store is
+    // reconstructed to: an empty slot or one of a picture no longer used for
+    // reference, outside of the reference lists ref. -1 if there is none.
+    int8_t GetNonReferenceSetupSlot(const StdVideoEncodeH264ReferenceListsInfo *ref) const;
 
 private:
     void DpbInit();
+    // The corrupted pictures and the pictures of the temporal layers the current picture
+    // can't reference are left out of the reference lists with bSkipCorruptFrames.
+    bool IsSkippedReference(int32_t dpbIdx) const;
     void DpbDeinit();
     void FillFrameNumGaps(const PicInfoH264 *pPicInfo, const StdVideoH264SequenceParameterSet *sps);
     bool IsDpbFull();
+    // The first empty slot that is not in the active reference lists of ref,
+    // -1 if there is none.
+    int32_t GetFreeDpbSlot(const StdVideoEncodeH264ReferenceListsInfo *ref) const;
     bool IsDpbEmpty();
     void DpbBumping(bool alwaysbump);
     void DecodedRefPicMarking(const PicInfoH264 *pPicInfo,
@@ -40,6 +40,9 @@ VkEncDpbH265::VkEncDpbH265()
     , m_lastIDRTimeStamp(0)
     , m_picOrderCntCRA(0)
     , m_refreshPending(false)
+    , m_picOrderCntRecoveryPoint(0)
+    , m_recoveryPointPending(false)
+    , m_temporalUnmarkDpbIndex(-1)
     , m_longTermFlags(0)
     , m_useMultipleRefs()
 {
@@ -63,6 +66,8 @@ bool VkEncDpbH265::DpbSequenceStart(int32_t dpbSize, bool useMultipleReferences)
     // The device supports use of multiple references when encoding a frame,
     // so make use of that ability.
     m_useMultipleRefs = useMultipleReferences;
+    m_temporalUnmarkDpbIndex = -1;
+    m_recoveryPointPending = false;
 
     return true;
 }
@@ -153,15 +158,9 @@ int8_t VkEncDpbH265::DpbPictureStart(uint64_t frameId, const StdVideoEncodeH265P
 
 void VkEncDpbH265::DpbPictureEnd(VkSharedBaseObj<VulkanVideoImagePoolNode>& dpbImageView, uint32_t numTemporalLayers, bool isReference) {
 
-    // For temporal SVC , we unmark the ref frames in Dpb having same temporal id as the current frame
-    if (numTemporalLayers > 1) {
-        for (int32_t i = 0; i < m_dpbSize; i++) {
-            if ((m_stDpb[i].state == 1) && (m_stDpb[i].marking != 0) &&
-                    (m_stDpb[i].temporalId == m_stDpb[m_curDpbIndex].temporalId)) {
-                m_stDpb[i].marking = 0;
-            }
-        }
-    }
+    // For temporal SVC , we unmark the ref frames in Dpb having same temporal id as the current frame.
+    // This is done before the next picture, the current one still references them.
+    m_temporalUnmarkDpbIndex = (numTemporalLayers > 1) ? m_curDpbIndex : -1;
 
     m_stDpb[m_curDpbIndex].dpbImageView = dpbImageView;
     m_stDpb[m_curDpbIndex].state = 1;
@@ -827,12 +826,38 @@ void VkEncDpbH265::InitializeShortTermRPSPFrame(int32_t numPocLtCurr,
 }
 
 void VkEncDpbH265::ReferencePictureMarking(int32_t curPOC, StdVideoH265PictureType picType,
-                                           bool longTermRefPicsPresentFlag) {
+                                           bool longTermRefPicsPresentFlag, bool recoveryPoint) {
+    if (m_temporalUnmarkDpbIndex >= 0) {
+        for (int32_t i = 0; i < m_dpbSize; i++) {
+            if ((i != m_temporalUnmarkDpbIndex) && (m_stDpb[i].state == 1) && (m_stDpb[i].marking != 0) &&
+                    (m_stDpb[i].temporalId == m_stDpb[m_temporalUnmarkDpbIndex].temporalId)) {
+                m_stDpb[i].marking = 0;
+            }
+        }
+        m_temporalUnmarkDpbIndex = -1;
+    }
+
     if (picType == STD_VIDEO_H265_PICTURE_TYPE_IDR) {
         for (int32_t i = 0; i < m_dpbSize; i++)
             m_stDpb[i].marking = 0;
+        m_recoveryPointPending = false;
 
     } else {
+        // Intra refresh: the pictures after a recovery point don't reference
+        // the pictures before it, a decoder starting there doesn't have them.
+        if (m_recoveryPointPending && (curPOC > m_picOrderCntRecoveryPoint)) {
+            for (int32_t i = 0; i < m_dpbSize; i++) {
+                if (m_stDpb[i].picOrderCntVal < (uint32_t)m_picOrderCntRecoveryPoint)
+                    m_stDpb[i].marking = 0;
+            }
+            m_recoveryPointPending = false;
+        }
+
+        if (recoveryPoint) {
+            m_recoveryPointPending = true;
+            m_picOrderCntRecoveryPoint = curPOC;
+        }
+
         // TL pictures can't use LD pictures as reference
         if ((m_refreshPending == true) && (curPOC > m_picOrderCntCRA)) { // CRA reference marking pending
             for (int32_t i = 0; i < m_dpbSize; i++) {
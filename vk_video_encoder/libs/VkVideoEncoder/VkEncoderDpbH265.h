@@ -60,8 +60,10 @@ public:
 
     bool DpbSequenceStart(int32_t dpbSize, bool useMultipleReferences);
 
+    // recoveryPoint: the first picture of an intra refresh wave, the
+    // references before it are unmarked with the next picture.
     void ReferencePictureMarking(int32_t curPOC, StdVideoH265PictureType picType,
-                                 bool longTermRefPicsPresentFlag);
+                                 bool longTermRefPicsPresentFlag, bool recoveryPoint = false);
     void InitializeRPS(const StdVideoH265ShortTermRefPicSet *pSpsShortTermRps,
                        uint8_t spsNumShortTermRefPicSets,
                        StdVideoEncodeH265PictureInfo *pPicInfo,
@@ -118,6 +120,11 @@ private:
     uint64_t                       m_lastIDRTimeStamp;
     int32_t                        m_picOrderCntCRA;
     bool                           m_refreshPending;
+    int32_t                        m_picOrderCntRecoveryPoint;
+    bool                           m_recoveryPointPending;
+    // The picture whose temporal layer's older references are unmarked
+    // before the next picture, -1 if none.
+    int8_t                         m_temporalUnmarkDpbIndex;
     uint32_t                       m_longTermFlags;
     bool                           m_useMultipleRefs;
 };
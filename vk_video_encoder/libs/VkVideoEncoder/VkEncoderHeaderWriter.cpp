@@ -0,0 +1,1284 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "VkVideoEncoder/VkEncoderHeaderWriter.h"
+
+void VkEncoderBitWriter::PutBits(uint32_t value, uint32_t numBits)
+{
+    assert(numBits <= 32);
+    while (numBits > 0) {
+        const uint32_t bits = (numBits < (8 - m_cacheBits)) ? numBits : (8 - m_cacheBits);
+        numBits -= bits;
+        m_cache = (m_cache << bits) | ((value >> numBits) & ((1u << bits) - 1));
+        m_cacheBits += bits;
+        if (m_cacheBits == 8) {
+            m_data.push_back((uint8_t)m_cache);
+            m_cache = 0;
+            m_cacheBits = 0;
+        }
+    }
+}
+
+void VkEncoderBitWriter::PutUe(uint32_t value)
+{
+    // 2 * numBits + 1 bit code of value + 1, written in two parts for values up to 2^32 - 2.
+    const uint64_t codeNum = (uint64_t)value + 1;
+    uint32_t numBits = 0;
+    while ((codeNum >> (numBits + 1)) != 0) {
+        numBits++;
+    }
+    PutBits(0, numBits);
+    PutBits(1, 1);
+    PutBits((uint32_t)(codeNum & ((1ull << numBits) - 1)), numBits);
+}
+
+void VkEncoderBitWriter::PutSe(int32_t value)
+{
+    PutUe((value > 0) ? (2 * (uint32_t)value - 1) : (uint32_t)(-2 * (int64_t)value));
+}
+
+void VkEncoderBitWriter::PutUvlc(uint32_t value)
+{
+    const uint64_t codeNum = (uint64_t)value + 1;
+    uint32_t leadingZeros = 0;
+    while ((codeNum >> (leadingZeros + 1)) != 0) {
+        leadingZeros++;
+    }
+    PutBits(0, leadingZeros);
+    PutBits(1, 1);
+    PutBits((uint32_t)(codeNum & ((1ull << leadingZeros) - 1)), leadingZeros);
+}
+
+void VkEncoderBitWriter::PutTrailingBits()
+{
+    PutBits(1, 1);
+    PutAlignmentBits();
+}
+
+void VkEncoderBitWriter::PutAlignmentBits(bool oneBits)
+{
+    if (m_cacheBits != 0) {
+        const uint32_t numBits = 8 - m_cacheBits;
+        PutBits(oneBits ? ((1u << numBits) - 1) : 0, numBits);
+    }
+}
+
+void VkEncoderBitWriter::PutBytes(const uint8_t* pData, size_t size)
+{
+    if (IsByteAligned()) {
+        m_data.insert(m_data.end(), pData, pData + size);
+        return;
+    }
+    for (size_t i = 0; i < size; i++) {
+        PutBits(pData[i], 8);
+    }
+}
+
+uint32_t VkEncoderHeaderWriter::GetH264LevelIdc(StdVideoH264LevelIdc level)
+{
+    static const uint8_t levelIdc[] = { 10, 11, 12, 13, 20, 21, 22, 30, 31, 32, 40, 41, 42, 50, 51, 52, 60, 61, 62 };
+    return ((uint32_t)level < (sizeof(levelIdc) / sizeof(levelIdc[0]))) ? levelIdc[level] : 0;
+}
+
+uint32_t VkEncoderHeaderWriter::GetH265LevelIdc(StdVideoH265LevelIdc level)
+{
+    static const uint8_t levelIdc[] = { 30, 60, 63, 90, 93, 120, 123, 150, 153, 156, 180, 183, 186 };
+    return ((uint32_t)level < (sizeof(levelIdc) / sizeof(levelIdc[0]))) ? levelIdc[level] : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// H.264
+
+void VkEncoderHeaderWriter::WriteH264ScalingList(const uint8_t* pList, uint32_t size, bool useDefault,
+                                                 VkEncoderBitWriter& bs)
+{
+    // A delta_scale of -8 at the first position selects the default list.
+    if (useDefault) {
+        bs.PutSe(-8);
+        return;
+    }
+
+    int32_t lastScale = 8;
+    for (uint32_t j = 0; j < size; j++) {
+        int32_t deltaScale = (int32_t)pList[j] - lastScale;
+        if (deltaScale > 127) {
+            deltaScale -= 256;
+        } else if (deltaScale < -128) {
+            deltaScale += 256;
+        }
+        bs.PutSe(deltaScale);
+        lastScale = pList[j];
+    }
+}
+
+void VkEncoderHeaderWriter::WriteH264HrdParameters(const StdVideoH264HrdParameters* pHrd, VkEncoderBitWriter& bs)
+{
+    bs.PutUe(pHrd->cpb_cnt_minus1);
+    bs.PutBits(pHrd->bit_rate_scale, 4);
+    bs.PutBits(pHrd->cpb_size_scale, 4);
+    for (uint32_t i = 0; (i <= pHrd->cpb_cnt_minus1) && (i < STD_VIDEO_H264_CPB_CNT_LIST_SIZE); i++) {
+        bs.PutUe(pHrd->bit_rate_value_minus1[i]);
+        bs.PutUe(pHrd->cpb_size_value_minus1[i]);
+        bs.PutFlag(pHrd->cbr_flag[i] != 0);
+    }
+    bs.PutBits(pHrd->initial_cpb_removal_delay_length_minus1, 5);
+    bs.PutBits(pHrd->cpb_removal_delay_length_minus1, 5);
+    bs.PutBits(pHrd->dpb_output_delay_length_minus1, 5);
+    bs.PutBits(pHrd->time_offset_length, 5);
+}
+
+void VkEncoderHeaderWriter::WriteH264Vui(const StdVideoH264SequenceParameterSetVui* pVui, VkEncoderBitWriter& bs)
+{
+    const StdVideoH264SpsVuiFlags& flags = pVui->flags;
+
+    bs.PutFlag(flags.aspect_ratio_info_present_flag);
+    if (flags.aspect_ratio_info_present_flag) {
+        bs.PutBits(pVui->aspect_ratio_idc, 8);
+        if (pVui->aspect_ratio_idc == STD_VIDEO_H264_ASPECT_RATIO_IDC_EXTENDED_SAR) {
+            bs.PutBits(pVui->sar_width, 16);
+            bs.PutBits(pVui->sar_height, 16);
+        }
+    }
+    bs.PutFlag(flags.overscan_info_present_flag);
+    if (flags.overscan_info_present_flag) {
+        bs.PutFlag(flags.overscan_appropriate_flag);
+    }
+    bs.PutFlag(flags.video_signal_type_present_flag);
+    if (flags.video_signal_type_present_flag) {
+        bs.PutBits(pVui->video_format, 3);
+        bs.PutFlag(flags.video_full_range_flag);
+        bs.PutFlag(flags.color_description_present_flag);
+        if (flags.color_description_present_flag) {
+            bs.PutBits(pVui->colour_primaries, 8);
+            bs.PutBits(pVui->transfer_characteristics, 8);
+            bs.PutBits(pVui->matrix_coefficients, 8);
+        }
+    }
+    bs.PutFlag(flags.chroma_loc_info_present_flag);
+    if (flags.chroma_loc_info_present_flag) {
+        bs.PutUe(pVui->chroma_sample_loc_type_top_field);
+        bs.PutUe(pVui->chroma_sample_loc_type_bottom_field);
+    }
+    bs.PutFlag(flags.timing_info_present_flag);
+    if (flags.timing_info_present_flag) {
+        bs.PutBits(pVui->num_units_in_tick, 32);
+        bs.PutBits(pVui->time_scale, 32);
+        bs.PutFlag(flags.fixed_frame_rate_flag);
+    }
+    const bool nalHrd = flags.nal_hrd_parameters_present_flag && (pVui->pHrdParameters != nullptr);
+    const bool vclHrd = flags.vcl_hrd_parameters_present_flag && (pVui->pHrdParameters != nullptr);
+    bs.PutFlag(nalHrd);
+    if (nalHrd) {
+        WriteH264HrdParameters(pVui->pHrdParameters, bs);
+    }
+    bs.PutFlag(vclHrd);
+    if (vclHrd) {
+        WriteH264HrdParameters(pVui->pHrdParameters, bs);
+    }
+    if (nalHrd || vclHrd) {
+        bs.PutFlag(false);  // low_delay_hrd_flag
+    }
+    bs.PutFlag(false);      // pic_struct_present_flag
+    bs.PutFlag(flags.bitstream_restriction_flag);
+    if (flags.bitstream_restriction_flag) {
+        // The Std VUI only carries the reorder and buffering limits, the other
+        // fields take their inferred values.
+        bs.PutFlag(true);   // motion_vectors_over_pic_boundaries_flag
+        bs.PutUe(2);        // max_bytes_per_pic_denom
+        bs.PutUe(1);        // max_bits_per_mb_denom
+        bs.PutUe(16);       // log2_max_mv_length_horizontal
+        bs.PutUe(16);       // log2_max_mv_length_vertical
+        bs.PutUe(pVui->max_num_reorder_frames);
+        bs.PutUe(pVui->max_dec_frame_buffering);
+    }
+}
+
+bool VkEncoderHeaderWriter::WriteH264Sps(const StdVideoH264SequenceParameterSet* pSps, VkEncoderBitWriter& bs,
+                                         bool trailingBits)
+{
+    assert(pSps != nullptr);
+    const StdVideoH264SpsFlags& flags = pSps->flags;
+
+    bs.PutBits(pSps->profile_idc, 8);
+    bs.PutFlag(flags.constraint_set0_flag);
+    bs.PutFlag(flags.constraint_set1_flag);
+    bs.PutFlag(flags.constraint_set2_flag);
+    bs.PutFlag(flags.constraint_set3_flag);
+    bs.PutFlag(flags.constraint_set4_flag);
+    bs.PutFlag(flags.constraint_set5_flag);
+    bs.PutBits(0, 2);   // reserved_zero_2bits
+    bs.PutBits(GetH264LevelIdc(pSps->level_idc), 8);
+    bs.PutUe(pSps->seq_parameter_set_id);
+
+    switch ((uint32_t)pSps->profile_idc) {
+    case 100: case 110: case 122: case 244: case 44: case 83:
+    case 86: case 118: case 128: case 138: case 139: case 134: case 135:
+        bs.PutUe(pSps->chroma_format_idc);
+        if (pSps->chroma_format_idc == STD_VIDEO_H264_CHROMA_FORMAT_IDC_444) {
+            bs.PutFlag(flags.separate_colour_plane_flag);
+        }
+        bs.PutUe(pSps->bit_depth_luma_minus8);
+        bs.PutUe(pSps->bit_depth_chroma_minus8);
+        bs.PutFlag(flags.qpprime_y_zero_transform_bypass_flag);
+        bs.PutFlag(flags.seq_scaling_matrix_present_flag && (pSps->pScalingLists != nullptr));
+        if (flags.seq_scaling_matrix_present_flag && (pSps->pScalingLists != nullptr)) {
+            const StdVideoH264ScalingLists* pLists = pSps->pScalingLists;
+            const uint32_t numLists = (pSps->chroma_format_idc != STD_VIDEO_H264_CHROMA_FORMAT_IDC_444) ? 8 : 12;
+            for (uint32_t i = 0; i < numLists; i++) {
+                const bool present = (pLists->scaling_list_present_mask >> i) & 1;
+                bs.PutFlag(present);
+                if (!present) {
+                    continue;
+                }
+                const bool useDefault = (pLists->use_default_scaling_matrix_mask >> i) & 1;
+                if (i < STD_VIDEO_H264_SCALING_LIST_4X4_NUM_LISTS) {
+                    WriteH264ScalingList(pLists->ScalingList4x4[i], STD_VIDEO_H264_SCALING_LIST_4X4_NUM_ELEMENTS, useDefault, bs);
+                } else {
+                    WriteH264ScalingList(pLists->ScalingList8x8[i - STD_VIDEO_H264_SCALING_LIST_4X4_NUM_LISTS],
+                                         STD_VIDEO_H264_SCALING_LIST_8X8_NUM_ELEMENTS, useDefault, bs);
+                }
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    bs.PutUe(pSps->log2_max_frame_num_minus4);
+    bs.PutUe(pSps->pic_order_cnt_type);
+    if (pSps->pic_order_cnt_type == STD_VIDEO_H264_POC_TYPE_0) {
+        bs.PutUe(pSps->log2_max_pic_order_cnt_lsb_minus4);
+    } else if (pSps->pic_order_cnt_type == STD_VIDEO_H264_POC_TYPE_1) {
+        bs.PutFlag(flags.delta_pic_order_always_zero_flag);
+        bs.PutSe(pSps->offset_for_non_ref_pic);
+        bs.PutSe(pSps->offset_for_top_to_bottom_field);
+        const uint32_t numRefFrames = (pSps->pOffsetForRefFrame != nullptr) ? pSps->num_ref_frames_in_pic_order_cnt_cycle : 0;
+        bs.PutUe(numRefFrames);
+        for (uint32_t i = 0; i < numRefFrames; i++) {
+            bs.PutSe(pSps->pOffsetForRefFrame[i]);
+        }
+    }
+    bs.PutUe(pSps->max_num_ref_frames);
+    bs.PutFlag(flags.gaps_in_frame_num_value_allowed_flag);
+    bs.PutUe(pSps->pic_width_in_mbs_minus1);
+    bs.PutUe(pSps->pic_height_in_map_units_minus1);
+    bs.PutFlag(flags.frame_mbs_only_flag);
+    if (!flags.frame_mbs_only_flag) {
+        bs.PutFlag(flags.mb_adaptive_frame_field_flag);
+    }
+    bs.PutFlag(flags.direct_8x8_inference_flag);
+    bs.PutFlag(flags.frame_cropping_flag);
+    if (flags.frame_cropping_flag) {
+        bs.PutUe(pSps->frame_crop_left_offset);
+        bs.PutUe(pSps->frame_crop_right_offset);
+        bs.PutUe(pSps->frame_crop_top_offset);
+        bs.PutUe(pSps->frame_crop_bottom_offset);
+    }
+    const bool vui = flags.vui_parameters_present_flag && (pSps->pSequenceParameterSetVui != nullptr);
+    bs.PutFlag(vui);
+    if (vui) {
+        WriteH264Vui(pSps->pSequenceParameterSetVui, bs);
+    }
+
+    if (trailingBits) {
+        bs.PutTrailingBits();
+    }
+    return true;
+}
+
+bool VkEncoderHeaderWriter::WriteH264Pps(const StdVideoH264SequenceParameterSet* pSps,
+                                         const StdVideoH264PictureParameterSet* pPps, VkEncoderBitWriter& bs)
+{
+    assert(pPps != nullptr);
+    const StdVideoH264PpsFlags& flags = pPps->flags;
+
+    bs.PutUe(pPps->pic_parameter_set_id);
+    bs.PutUe(pPps->seq_parameter_set_id);
+    bs.PutFlag(flags.entropy_coding_mode_flag);
+    bs.PutFlag(flags.bottom_field_pic_order_in_frame_present_flag);
+    bs.PutUe(0);        // num_slice_groups_minus1
+    bs.PutUe(pPps->num_ref_idx_l0_default_active_minus1);
+    bs.PutUe(pPps->num_ref_idx_l1_default_active_minus1);
+    bs.PutFlag(flags.weighted_pred_flag);
+    bs.PutBits(pPps->weighted_bipred_idc, 2);
+    bs.PutSe(pPps->pic_init_qp_minus26);
+    bs.PutSe(pPps->pic_init_qs_minus26);
+    bs.PutSe(pPps->chroma_qp_index_offset);
+    bs.PutFlag(flags.deblocking_filter_control_present_flag);
+    bs.PutFlag(flags.constrained_intra_pred_flag);
+    bs.PutFlag(flags.redundant_pic_cnt_present_flag);
+
+    const bool scalingMatrix = flags.pic_scaling_matrix_present_flag && (pPps->pScalingLists != nullptr);
+    if (flags.transform_8x8_mode_flag || scalingMatrix ||
+        (pPps->second_chroma_qp_index_offset != pPps->chroma_qp_index_offset)) {
+
+        bs.PutFlag(flags.transform_8x8_mode_flag);
+        bs.PutFlag(scalingMatrix);
+        if (scalingMatrix) {
+            const StdVideoH264ScalingLists* pLists = pPps->pScalingLists;
+            const bool chroma444 = (pSps != nullptr) && (pSps->chroma_format_idc == STD_VIDEO_H264_CHROMA_FORMAT_IDC_444);
+            const uint32_t numLists = 6 + (flags.transform_8x8_mode_flag ? (chroma444 ? 6 : 2) : 0);
+            for (uint32_t i = 0; i < numLists; i++) {
+                const bool present = (pLists->scaling_list_present_mask >> i) & 1;
+                bs.PutFlag(present);
+                if (!present) {
+                    continue;
+                }
+                const bool useDefault = (pLists->use_default_scaling_matrix_mask >> i) & 1;
+                if (i < STD_VIDEO_H264_SCALING_LIST_4X4_NUM_LISTS) {
+                    WriteH264ScalingList(pLists->ScalingList4x4[i], STD_VIDEO_H264_SCALING_LIST_4X4_NUM_ELEMENTS, useDefault, bs);
+                } else {
+                    WriteH264ScalingList(pLists->ScalingList8x8[i - STD_VIDEO_H264_SCALING_LIST_4X4_NUM_LISTS],
+                                         STD_VIDEO_H264_SCALING_LIST_8X8_NUM_ELEMENTS, useDefault, bs);
+                }
+            }
+        }
+        bs.PutSe(pPps->second_chroma_qp_index_offset);
+    }
+
+    bs.PutTrailingBits();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// H.265
+
+void VkEncoderHeaderWriter::WriteH265ProfileTierLevel(const StdVideoH265ProfileTierLevel* pPtl,
+                                                      uint32_t maxSubLayersMinus1, VkEncoderBitWriter& bs)
+{
+    const uint32_t profileIdc = (pPtl->general_profile_idc != STD_VIDEO_H265_PROFILE_IDC_INVALID) ?
+                                    (uint32_t)pPtl->general_profile_idc : (uint32_t)STD_VIDEO_H265_PROFILE_IDC_MAIN;
+    uint32_t compatibilityFlags = (1u << (31 - profileIdc));
+    if (profileIdc == STD_VIDEO_H265_PROFILE_IDC_MAIN) {
+        // A Main profile stream also conforms to Main 10.
+        compatibilityFlags |= (1u << (31 - STD_VIDEO_H265_PROFILE_IDC_MAIN_10));
+    }
+
+    bs.PutBits(0, 2);   // general_profile_space
+    bs.PutFlag(pPtl->flags.general_tier_flag);
+    bs.PutBits(profileIdc, 5);
+    bs.PutBits(compatibilityFlags, 32);
+    bs.PutFlag(pPtl->flags.general_progressive_source_flag);
+    bs.PutFlag(pPtl->flags.general_interlaced_source_flag);
+    bs.PutFlag(pPtl->flags.general_non_packed_constraint_flag);
+    bs.PutFlag(pPtl->flags.general_frame_only_constraint_flag);
+    bs.PutBits(0, 32);  // general_reserved_zero_43bits + general_inbld_flag
+    bs.PutBits(0, 12);
+    bs.PutBits(GetH265LevelIdc(pPtl->general_level_idc), 8);
+
+    for (uint32_t i = 0; i < maxSubLayersMinus1; i++) {
+        bs.PutFlag(false);  // sub_layer_profile_present_flag
+        bs.PutFlag(false);  // sub_layer_level_present_flag
+    }
+    if (maxSubLayersMinus1 > 0) {
+        for (uint32_t i = maxSubLayersMinus1; i < 8; i++) {
+            bs.PutBits(0, 2);   // reserved_zero_2bits
+        }
+    }
+}
+
+void VkEncoderHeaderWriter::WriteH265SubLayerOrdering(const StdVideoH265DecPicBufMgr* pDpbMgr,
+                                                      bool subLayerOrderingInfoPresent,
+                                                      uint32_t maxSubLayersMinus1, VkEncoderBitWriter& bs)
+{
+    bs.PutFlag(subLayerOrderingInfoPresent);
+    for (uint32_t i = (subLayerOrderingInfoPresent ? 0 : maxSubLayersMinus1); i <= maxSubLayersMinus1; i++) {
+        bs.PutUe((pDpbMgr != nullptr) ? pDpbMgr->max_dec_pic_buffering_minus1[i] : 0);
+        bs.PutUe((pDpbMgr != nullptr) ? pDpbMgr->max_num_reorder_pics[i] : 0);
+        bs.PutUe((pDpbMgr != nullptr) ? pDpbMgr->max_latency_increase_plus1[i] : 0);
+    }
+}
+
+void VkEncoderHeaderWriter::WriteH265HrdParameters(const StdVideoH265HrdParameters* pHrd, bool commonInfPresent,
+                                                   uint32_t maxSubLayersMinus1, VkEncoderBitWriter& bs)
+{
+    const StdVideoH265HrdFlags& flags = pHrd->flags;
+    const bool nalHrd = flags.nal_hrd_parameters_present_flag && (pHrd->pSubLayerHrdParametersNal != nullptr);
+    const bool vclHrd = flags.vcl_hrd_parameters_present_flag && (pHrd->pSubLayerHrdParametersVcl != nullptr);
+    bool subPicHrdParams = false;
+
+    if (commonInfPresent) {
+        bs.PutFlag(nalHrd);
+        bs.PutFlag(vclHrd);
+        if (nalHrd || vclHrd) {
+            subPicHrdParams = flags.sub_pic_hrd_params_present_flag;
+            bs.PutFlag(subPicHrdParams);
+            if (subPicHrdParams) {
+                bs.PutBits(pHrd->tick_divisor_minus2, 8);
+                bs.PutBits(pHrd->du_cpb_removal_delay_increment_length_minus1, 5);
+                bs.PutFlag(flags.sub_pic_cpb_params_in_pic_timing_sei_flag);
+                bs.PutBits(pHrd->dpb_output_delay_du_length_minus1, 5);
+            }
+            bs.PutBits(pHrd->bit_rate_scale, 4);
+            bs.PutBits(pHrd->cpb_size_scale, 4);
+            if (subPicHrdParams) {
+                bs.PutBits(pHrd->cpb_size_du_scale, 4);
+            }
+            bs.PutBits(pHrd->initial_cpb_removal_delay_length_minus1, 5);
+            bs.PutBits(pHrd->au_cpb_removal_delay_length_minus1, 5);
+            bs.PutBits(pHrd->dpb_output_delay_length_minus1, 5);
+        }
+    }
+
+    for (uint32_t i = 0; i <= maxSubLayersMinus1; i++) {
+        const bool fixedPicRateGeneral = (flags.fixed_pic_rate_general_flag >> i) & 1;
+        bool fixedPicRateWithinCvs = true;
+        bool lowDelayHrd = false;
+        bs.PutFlag(fixedPicRateGeneral);
+        if (!fixedPicRateGeneral) {
+            fixedPicRateWithinCvs = (flags.fixed_pic_rate_within_cvs_flag >> i) & 1;
+            bs.PutFlag(fixedPicRateWithinCvs);
+        }
+        if (fixedPicRateWithinCvs) {
+            bs.PutUe(pHrd->elemental_duration_in_tc_minus1[i]);
+        } else {
+            lowDelayHrd = (flags.low_delay_hrd_flag >> i) & 1;
+            bs.PutFlag(lowDelayHrd);
+        }
+        // cpb_cnt_minus1 isn't sent for a low delay sub-layer, it is inferred
+        // to be 0.
+        const uint32_t cpbCntMinus1 = lowDelayHrd ? 0 : pHrd->cpb_cnt_minus1[i];
+        if (!lowDelayHrd) {
+            bs.PutUe(cpbCntMinus1);
+        }
+        for (uint32_t nalVcl = 0; nalVcl < 2; nalVcl++) {
+            if (!(nalVcl ? vclHrd : nalHrd)) {
+                continue;
+            }
+            const StdVideoH265SubLayerHrdParameters* pSubLayer =
+                    &(nalVcl ? pHrd->pSubLayerHrdParametersVcl : pHrd->pSubLayerHrdParametersNal)[i];
+            for (uint32_t j = 0; (j <= cpbCntMinus1) && (j < STD_VIDEO_H265_CPB_CNT_LIST_SIZE); j++) {
+                bs.PutUe(pSubLayer->bit_rate_value_minus1[j]);
+                bs.PutUe(pSubLayer->cpb_size_value_minus1[j]);
+                if (subPicHrdParams) {
+                    bs.PutUe(pSubLayer->cpb_size_du_value_minus1[j]);
+                    bs.PutUe(pSubLayer->bit_rate_du_value_minus1[j]);
+                }
+                bs.PutFlag((pSubLayer->cbr_flag >> j) & 1);
+            }
+        }
+    }
+}
+
+void VkEncoderHeaderWriter::WriteH265ScalingListData(const StdVideoH265ScalingLists* pScalingLists, VkEncoderBitWriter& bs)
+{
+    // Every list is sent explicitly (scaling_list_pred_mode_flag = 1), in the
+    // coefficient order of the Std structure.
+    for (uint32_t sizeId = 0; sizeId < 4; sizeId++) {
+        for (uint32_t matrixId = 0; matrixId < 6; matrixId += (sizeId == 3) ? 3 : 1) {
+            const uint8_t* pList = nullptr;
+            uint32_t coefNum = 64;
+            int32_t nextCoef = 8;
+            switch (sizeId) {
+            case 0:
+                pList = pScalingLists->ScalingList4x4[matrixId];
+                coefNum = 16;
+                break;
+            case 1:
+                pList = pScalingLists->ScalingList8x8[matrixId];
+                break;
+            case 2:
+                pList = pScalingLists->ScalingList16x16[matrixId];
+                nextCoef = pScalingLists->ScalingListDCCoef16x16[matrixId];
+                break;
+            default:
+                pList = pScalingLists->ScalingList32x32[matrixId / 3];
+                nextCoef = pScalingLists->ScalingListDCCoef32x32[matrixId / 3];
+                break;
+            }
+
+            bs.PutFlag(true);   // scaling_list_pred_mode_flag
+            if (sizeId > 1) {
+                bs.PutSe(nextCoef - 8); // scaling_list_dc_coef_minus8
+            }
+            for (uint32_t i = 0; i < coefNum; i++) {
+                int32_t delta = (int32_t)pList[i] - nextCoef;
+                if (delta > 127) {
+                    delta -= 256;
+                } else if (delta < -128) {
+                    delta += 256;
+                }
+                bs.PutSe(delta);
+                nextCoef = pList[i];
+            }
+        }
+    }
+}
+
+void VkEncoderHeaderWriter::WriteH265ShortTermRefPicSet(const StdVideoH265ShortTermRefPicSet* pStRps, uint32_t stRpsIdx,
+                                                        uint32_t numShortTermRefPicSets, VkEncoderBitWriter& bs)
+{
+    const StdVideoH265ShortTermRefPicSet* pRps = &pStRps[stRpsIdx];
+
+    bool interRefPicSetPrediction = false;
+    if (stRpsIdx != 0) {
+        interRefPicSetPrediction = pRps->flags.inter_ref_pic_set_prediction_flag;
+        bs.PutFlag(interRefPicSetPrediction);
+    }
+
+    if (interRefPicSetPrediction) {
+        uint32_t deltaIdxMinus1 = 0;
+        if (stRpsIdx == numShortTermRefPicSets) {
+            deltaIdxMinus1 = pRps->delta_idx_minus1;
+            bs.PutUe(deltaIdxMinus1);
+        }
+        // The reference RPS is one of the SPS sets, which have the numbers of
+        // negative and positive pictures filled in.
+        const uint32_t refRpsIdx = stRpsIdx - (deltaIdxMinus1 + 1);
+        const uint32_t numDeltaPocs = pStRps[refRpsIdx].num_negative_pics + pStRps[refRpsIdx].num_positive_pics;
+        bs.PutFlag(pRps->flags.delta_rps_sign);
+        bs.PutUe(pRps->abs_delta_rps_minus1);
+        for (uint32_t j = 0; j <= numDeltaPocs; j++) {
+            const bool usedByCurrPic = (pRps->used_by_curr_pic_flag >> j) & 1;
+            bs.PutFlag(usedByCurrPic);
+            if (!usedByCurrPic) {
+                bs.PutFlag((pRps->use_delta_flag >> j) & 1);
+            }
+        }
+        return;
+    }
+
+    bs.PutUe(pRps->num_negative_pics);
+    bs.PutUe(pRps->num_positive_pics);
+    for (uint32_t i = 0; i < pRps->num_negative_pics; i++) {
+        bs.PutUe(pRps->delta_poc_s0_minus1[i]);
+        bs.PutFlag((pRps->used_by_curr_pic_s0_flag >> i) & 1);
+    }
+    for (uint32_t i = 0; i < pRps->num_positive_pics; i++) {
+        bs.PutUe(pRps->delta_poc_s1_minus1[i]);
+        bs.PutFlag((pRps->used_by_curr_pic_s1_flag >> i) & 1);
+    }
+}
+
+void VkEncoderHeaderWriter::WriteH265Vui(const StdVideoH265SequenceParameterSetVui* pVui, uint32_t maxSubLayersMinus1,
+                                         VkEncoderBitWriter& bs)
+{
+    const StdVideoH265SpsVuiFlags& flags = pVui->flags;
+
+    bs.PutFlag(flags.aspect_ratio_info_present_flag);
+    if (flags.aspect_ratio_info_present_flag) {
+        bs.PutBits(pVui->aspect_ratio_idc, 8);
+        if (pVui->aspect_ratio_idc == STD_VIDEO_H265_ASPECT_RATIO_IDC_EXTENDED_SAR) {
+            bs.PutBits(pVui->sar_width, 16);
+            bs.PutBits(pVui->sar_height, 16);
+        }
+    }
+    bs.PutFlag(flags.overscan_info_present_flag);
+    if (flags.overscan_info_present_flag) {
+        bs.PutFlag(flags.overscan_appropriate_flag);
+    }
+    bs.PutFlag(flags.video_signal_type_present_flag);
+    if (flags.video_signal_type_present_flag) {
+        bs.PutBits(pVui->video_format, 3);
+        bs.PutFlag(flags.video_full_range_flag);
+        bs.PutFlag(flags.colour_description_present_flag);
+        if (flags.colour_description_present_flag) {
+            bs.PutBits(pVui->colour_primaries, 8);
+            bs.PutBits(pVui->transfer_characteristics, 8);
+            bs.PutBits(pVui->matrix_coeffs, 8);
+        }
+    }
+    bs.PutFlag(flags.chroma_loc_info_present_flag);
+    if (flags.chroma_loc_info_present_flag) {
+        bs.PutUe(pVui->chroma_sample_loc_type_top_field);
+        bs.PutUe(pVui->chroma_sample_loc_type_bottom_field);
+    }
+    bs.PutFlag(flags.neutral_chroma_indication_flag);
+    bs.PutFlag(flags.field_seq_flag);
+    bs.PutFlag(flags.frame_field_info_present_flag);
+    bs.PutFlag(flags.default_display_window_flag);
+    if (flags.default_display_window_flag) {
+        bs.PutUe(pVui->def_disp_win_left_offset);
+        bs.PutUe(pVui->def_disp_win_right_offset);
+        bs.PutUe(pVui->def_disp_win_top_offset);
+        bs.PutUe(pVui->def_disp_win_bottom_offset);
+    }
+    bs.PutFlag(flags.vui_timing_info_present_flag);
+    if (flags.vui_timing_info_present_flag) {
+        bs.PutBits(pVui->vui_num_units_in_tick, 32);
+        bs.PutBits(pVui->vui_time_scale, 32);
+        bs.PutFlag(flags.vui_poc_proportional_to_timing_flag);
+        if (flags.vui_poc_proportional_to_timing_flag) {
+            bs.PutUe(pVui->vui_num_ticks_poc_diff_one_minus1);
+        }
+        const bool hrd = flags.vui_hrd_parameters_present_flag && (pVui->pHrdParameters != nullptr);
+        bs.PutFlag(hrd);
+        if (hrd) {
+            WriteH265HrdParameters(pVui->pHrdParameters, true, maxSubLayersMinus1, bs);
+        }
+    }
+    bs.PutFlag(flags.bitstream_restriction_flag);
+    if (flags.bitstream_restriction_flag) {
+        bs.PutFlag(flags.tiles_fixed_structure_flag);
+        bs.PutFlag(flags.motion_vectors_over_pic_boundaries_flag);
+        bs.PutFlag(flags.restricted_ref_pic_lists_flag);
+        bs.PutUe(pVui->min_spatial_segmentation_idc);
+        bs.PutUe(pVui->max_bytes_per_pic_denom);
+        bs.PutUe(pVui->max_bits_per_min_cu_denom);
+        bs.PutUe(pVui->log2_max_mv_length_horizontal);
+        bs.PutUe(pVui->log2_max_mv_length_vertical);
+    }
+}
+
+bool VkEncoderHeaderWriter::WriteH265Vps(const StdVideoH265VideoParameterSet* pVps, VkEncoderBitWriter& bs)
+{
+    assert(pVps != nullptr);
+    if (pVps->pProfileTierLevel == nullptr) {
+        return false;
+    }
+    const uint32_t maxSubLayersMinus1 = pVps->vps_max_sub_layers_minus1;
+
+    bs.PutBits(pVps->vps_video_parameter_set_id, 4);
+    bs.PutFlag(true);       // vps_base_layer_internal_flag
+    bs.PutFlag(true);       // vps_base_layer_available_flag
+    bs.PutBits(0, 6);       // vps_max_layers_minus1
+    bs.PutBits(maxSubLayersMinus1, 3);
+    bs.PutFlag(pVps->flags.vps_temporal_id_nesting_flag);
+    bs.PutBits(0xffff, 16); // vps_reserved_0xffff_16bits
+    WriteH265ProfileTierLevel(pVps->pProfileTierLevel, maxSubLayersMinus1, bs);
+    WriteH265SubLayerOrdering(pVps->pDecPicBufMgr, pVps->flags.vps_sub_layer_ordering_info_present_flag,
+                              maxSubLayersMinus1, bs);
+    bs.PutBits(0, 6);       // vps_max_layer_id
+    bs.PutUe(0);            // vps_num_layer_sets_minus1
+    bs.PutFlag(pVps->flags.vps_timing_info_present_flag);
+    if (pVps->flags.vps_timing_info_present_flag) {
+        bs.PutBits(pVps->vps_num_units_in_tick, 32);
+        bs.PutBits(pVps->vps_time_scale, 32);
+        bs.PutFlag(pVps->flags.vps_poc_proportional_to_timing_flag);
+        if (pVps->flags.vps_poc_proportional_to_timing_flag) {
+            bs.PutUe(pVps->vps_num_ticks_poc_diff_one_minus1);
+        }
+        const bool hrd = (pVps->pHrdParameters != nullptr) &&
+                         (pVps->pHrdParameters->flags.nal_hrd_parameters_present_flag ||
+                          pVps->pHrdParameters->flags.vcl_hrd_parameters_present_flag);
+        bs.PutUe(hrd ? 1 : 0);  // vps_num_hrd_parameters
+        if (hrd) {
+            bs.PutUe(0);        // hrd_layer_set_idx[0], cprms_present_flag[0] is inferred
+            WriteH265HrdParameters(pVps->pHrdParameters, true, maxSubLayersMinus1, bs);
+        }
+    }
+    bs.PutFlag(false);      // vps_extension_flag
+
+    bs.PutTrailingBits();
+    return true;
+}
+
+bool VkEncoderHeaderWriter::WriteH265Sps(const StdVideoH265SequenceParameterSet* pSps, VkEncoderBitWriter& bs)
+{
+    assert(pSps != nullptr);
+    if ((pSps->pProfileTierLevel == nullptr) ||
+        ((pSps->num_short_term_ref_pic_sets > 0) && (pSps->pShortTermRefPicSet == nullptr))) {
+        return false;
+    }
+    const StdVideoH265SpsFlags& flags = pSps->flags;
+    const uint32_t maxSubLayersMinus1 = pSps->sps_max_sub_layers_minus1;
+
+    bs.PutBits(pSps->sps_video_parameter_set_id, 4);
+    bs.PutBits(maxSubLayersMinus1, 3);
+    bs.PutFlag(flags.sps_temporal_id_nesting_flag);
+    WriteH265ProfileTierLevel(pSps->pProfileTierLevel, maxSubLayersMinus1, bs);
+    bs.PutUe(pSps->sps_seq_parameter_set_id);
+    bs.PutUe(pSps->chroma_format_idc);
+    if (pSps->chroma_format_idc == STD_VIDEO_H265_CHROMA_FORMAT_IDC_444) {
+        bs.PutFlag(flags.separate_colour_plane_flag);
+    }
+    bs.PutUe(pSps->pic_width_in_luma_samples);
+    bs.PutUe(pSps->pic_height_in_luma_samples);
+    bs.PutFlag(flags.conformance_window_flag);
+    if (flags.conformance_window_flag) {
+        bs.PutUe(pSps->conf_win_left_offset);
+        bs.PutUe(pSps->conf_win_right_offset);
+        bs.PutUe(pSps->conf_win_top_offset);
+        bs.PutUe(pSps->conf_win_bottom_offset);
+    }
+    bs.PutUe(pSps->bit_depth_luma_minus8);
+    bs.PutUe(pSps->bit_depth_chroma_minus8);
+    bs.PutUe(pSps->log2_max_pic_order_cnt_lsb_minus4);
+    WriteH265SubLayerOrdering(pSps->pDecPicBufMgr, flags.sps_sub_layer_ordering_info_present_flag,
+                              maxSubLayersMinus1, bs);
+    bs.PutUe(pSps->log2_min_luma_coding_block_size_minus3);
+    bs.PutUe(pSps->log2_diff_max_min_luma_coding_block_size);
+    bs.PutUe(pSps->log2_min_luma_transform_block_size_minus2);
+    bs.PutUe(pSps->log2_diff_max_min_luma_transform_block_size);
+    bs.PutUe(pSps->max_transform_hierarchy_depth_inter);
+    bs.PutUe(pSps->max_transform_hierarchy_depth_intra);
+    bs.PutFlag(flags.scaling_list_enabled_flag);
+    if (flags.scaling_list_enabled_flag) {
+        const bool scalingListData = flags.sps_scaling_list_data_present_flag && (pSps->pScalingLists != nullptr);
+        bs.PutFlag(scalingListData);
+        if (scalingListData) {
+            WriteH265ScalingListData(pSps->pScalingLists, bs);
+        }
+    }
+    bs.PutFlag(flags.amp_enabled_flag);
+    bs.PutFlag(flags.sample_adaptive_offset_enabled_flag);
+    bs.PutFlag(flags.pcm_enabled_flag);
+    if (flags.pcm_enabled_flag) {
+        bs.PutBits(pSps->pcm_sample_bit_depth_luma_minus1, 4);
+        bs.PutBits(pSps->pcm_sample_bit_depth_chroma_minus1, 4);
+        bs.PutUe(pSps->log2_min_pcm_luma_coding_block_size_minus3);
+        bs.PutUe(pSps->log2_diff_max_min_pcm_luma_coding_block_size);
+        bs.PutFlag(flags.pcm_loop_filter_disabled_flag);
+    }
+    bs.PutUe(pSps->num_short_term_ref_pic_sets);
+    for (uint32_t i = 0; i < pSps->num_short_term_ref_pic_sets; i++) {
+        WriteH265ShortTermRefPicSet(pSps->pShortTermRefPicSet, i, pSps->num_short_term_ref_pic_sets, bs);
+    }
+    const bool longTermRefPics = flags.long_term_ref_pics_present_flag;
+    bs.PutFlag(longTermRefPics);
+    if (longTermRefPics) {
+        const uint32_t numLongTermRefPics = (pSps->pLongTermRefPicsSps != nullptr) ? pSps->num_long_term_ref_pics_sps : 0;
+        bs.PutUe(numLongTermRefPics);
+        for (uint32_t i = 0; i < numLongTermRefPics; i++) {
+            bs.PutBits(pSps->pLongTermRefPicsSps->lt_ref_pic_poc_lsb_sps[i], pSps->log2_max_pic_order_cnt_lsb_minus4 + 4);
+            bs.PutFlag((pSps->pLongTermRefPicsSps->used_by_curr_pic_lt_sps_flag >> i) & 1);
+        }
+    }
+    bs.PutFlag(flags.sps_temporal_mvp_enabled_flag);
+    bs.PutFlag(flags.strong_intra_smoothing_enabled_flag);
+    const bool vui = flags.vui_parameters_present_flag && (pSps->pSequenceParameterSetVui != nullptr);
+    bs.PutFlag(vui);
+    if (vui) {
+        WriteH265Vui(pSps->pSequenceParameterSetVui, maxSubLayersMinus1, bs);
+    }
+
+    const bool sccExtension = flags.sps_scc_extension_flag;
+    bs.PutFlag(flags.sps_extension_present_flag);
+    if (flags.sps_extension_present_flag) {
+        bs.PutFlag(flags.sps_range_extension_flag);
+        bs.PutFlag(false);  // sps_multilayer_extension_flag
+        bs.PutFlag(false);  // sps_3d_extension_flag
+        bs.PutFlag(sccExtension);
+        bs.PutBits(0, 4);   // sps_extension_4bits
+        if (flags.sps_range_extension_flag) {
+            bs.PutFlag(flags.transform_skip_rotation_enabled_flag);
+            bs.PutFlag(flags.transform_skip_context_enabled_flag);
+            bs.PutFlag(flags.implicit_rdpcm_enabled_flag);
+            bs.PutFlag(flags.explicit_rdpcm_enabled_flag);
+            bs.PutFlag(flags.extended_precision_processing_flag);
+            bs.PutFlag(flags.intra_smoothing_disabled_flag);
+            bs.PutFlag(flags.high_precision_offsets_enabled_flag);
+            bs.PutFlag(flags.persistent_rice_adaptation_enabled_flag);
+            bs.PutFlag(flags.cabac_bypass_alignment_enabled_flag);
+        }
+        if (sccExtension) {
+            bs.PutFlag(flags.sps_curr_pic_ref_enabled_flag);
+            bs.PutFlag(flags.palette_mode_enabled_flag);
+            if (flags.palette_mode_enabled_flag) {
+                bs.PutUe(pSps->palette_max_size);
+                bs.PutUe(pSps->delta_palette_max_predictor_size);
+                const bool initializers = flags.sps_palette_predictor_initializers_present_flag &&
+                                          (pSps->pPredictorPaletteEntries != nullptr);
+                bs.PutFlag(initializers);
+                if (initializers) {
+                    bs.PutUe(pSps->sps_num_palette_predictor_initializers_minus1);
+                    const uint32_t numComps = (pSps->chroma_format_idc == STD_VIDEO_H265_CHROMA_FORMAT_IDC_MONOCHROME) ? 1 : 3;
+                    for (uint32_t comp = 0; comp < numComps; comp++) {
+                        const uint32_t bitDepth = 8 + ((comp == 0) ? pSps->bit_depth_luma_minus8 : pSps->bit_depth_chroma_minus8);
+                        for (uint32_t i = 0; i <= pSps->sps_num_palette_predictor_initializers_minus1; i++) {
+                            bs.PutBits(pSps->pPredictorPaletteEntries->PredictorPaletteEntries[comp][i], bitDepth);
+                        }
+                    }
+                }
+            }
+            bs.PutBits(pSps->motion_vector_resolution_control_idc, 2);
+            bs.PutFlag(flags.intra_boundary_filtering_disabled_flag);
+        }
+    }
+
+    bs.PutTrailingBits();
+    return true;
+}
+
+bool VkEncoderHeaderWriter::WriteH265Pps(const StdVideoH265PictureParameterSet* pPps, VkEncoderBitWriter& bs)
+{
+    assert(pPps != nullptr);
+    const StdVideoH265PpsFlags& flags = pPps->flags;
+
+    bs.PutUe(pPps->pps_pic_parameter_set_id);
+    bs.PutUe(pPps->pps_seq_parameter_set_id);
+    bs.PutFlag(flags.dependent_slice_segments_enabled_flag);
+    bs.PutFlag(flags.output_flag_present_flag);
+    bs.PutBits(pPps->num_extra_slice_header_bits, 3);
+    bs.PutFlag(flags.sign_data_hiding_enabled_flag);
+    bs.PutFlag(flags.cabac_init_present_flag);
+    bs.PutUe(pPps->num_ref_idx_l0_default_active_minus1);
+    bs.PutUe(pPps->num_ref_idx_l1_default_active_minus1);
+    bs.PutSe(pPps->init_qp_minus26);
+    bs.PutFlag(flags.constrained_intra_pred_flag);
+    bs.PutFlag(flags.transform_skip_enabled_flag);
+    bs.PutFlag(flags.cu_qp_delta_enabled_flag);
+    if (flags.cu_qp_delta_enabled_flag) {
+        bs.PutUe(pPps->diff_cu_qp_delta_depth);
+    }
+    bs.PutSe(pPps->pps_cb_qp_offset);
+    bs.PutSe(pPps->pps_cr_qp_offset);
+    bs.PutFlag(flags.pps_slice_chroma_qp_offsets_present_flag);
+    bs.PutFlag(flags.weighted_pred_flag);
+    bs.PutFlag(flags.weighted_bipred_flag);
+    bs.PutFlag(flags.transquant_bypass_enabled_flag);
+    bs.PutFlag(flags.tiles_enabled_flag);
+    bs.PutFlag(flags.entropy_coding_sync_enabled_flag);
+    if (flags.tiles_enabled_flag) {
+        bs.PutUe(pPps->num_tile_columns_minus1);
+        bs.PutUe(pPps->num_tile_rows_minus1);
+        bs.PutFlag(flags.uniform_spacing_flag);
+        if (!flags.uniform_spacing_flag) {
+            for (uint32_t i = 0; i < pPps->num_tile_columns_minus1; i++) {
+                bs.PutUe(pPps->column_width_minus1[i]);
+            }
+            for (uint32_t i = 0; i < pPps->num_tile_rows_minus1; i++) {
+                bs.PutUe(pPps->row_height_minus1[i]);
+            }
+        }
+        bs.PutFlag(flags.loop_filter_across_tiles_enabled_flag);
+    }
+    bs.PutFlag(flags.pps_loop_filter_across_slices_enabled_flag);
+    bs.PutFlag(flags.deblocking_filter_control_present_flag);
+    if (flags.deblocking_filter_control_present_flag) {
+        bs.PutFlag(flags.deblocking_filter_override_enabled_flag);
+        bs.PutFlag(flags.pps_deblocking_filter_disabled_flag);
+        if (!flags.pps_deblocking_filter_disabled_flag) {
+            bs.PutSe(pPps->pps_beta_offset_div2);
+            bs.PutSe(pPps->pps_tc_offset_div2);
+        }
+    }
+    const bool scalingListData = flags.pps_scaling_list_data_present_flag && (pPps->pScalingLists != nullptr);
+    bs.PutFlag(scalingListData);
+    if (scalingListData) {
+        WriteH265ScalingListData(pPps->pScalingLists, bs);
+    }
+    bs.PutFlag(flags.lists_modification_present_flag);
+    bs.PutUe(pPps->log2_parallel_merge_level_minus2);
+    bs.PutFlag(flags.slice_segment_header_extension_present_flag);
+
+    const bool rangeExtension = flags.pps_range_extension_flag;
+    const bool sccExtension = flags.pps_curr_pic_ref_enabled_flag ||
+                              flags.residual_adaptive_colour_transform_enabled_flag ||
+                              flags.pps_palette_predictor_initializers_present_flag;
+    bs.PutFlag(flags.pps_extension_present_flag || rangeExtension || sccExtension);
+    if (flags.pps_extension_present_flag || rangeExtension || sccExtension) {
+        bs.PutFlag(rangeExtension);
+        bs.PutFlag(false);  // pps_multilayer_extension_flag
+        bs.PutFlag(false);  // pps_3d_extension_flag
+        bs.PutFlag(sccExtension);
+        bs.PutBits(0, 4);   // pps_extension_4bits
+        if (rangeExtension) {
+            if (flags.transform_skip_enabled_flag) {
+                bs.PutUe(pPps->log2_max_transform_skip_block_size_minus2);
+            }
+            bs.PutFlag(flags.cross_component_prediction_enabled_flag);
+            bs.PutFlag(flags.chroma_qp_offset_list_enabled_flag);
+            if (flags.chroma_qp_offset_list_enabled_flag) {
+                bs.PutUe(pPps->diff_cu_chroma_qp_offset_depth);
+                bs.PutUe(pPps->chroma_qp_offset_list_len_minus1);
+                for (uint32_t i = 0; i <= pPps->chroma_qp_offset_list_len_minus1; i++) {
+                    bs.PutSe(pPps->cb_qp_offset_list[i]);
+                    bs.PutSe(pPps->cr_qp_offset_list[i]);
+                }
+            }
+            bs.PutUe(pPps->log2_sao_offset_scale_luma);
+            bs.PutUe(pPps->log2_sao_offset_scale_chroma);
+        }
+        if (sccExtension) {
+            bs.PutFlag(flags.pps_curr_pic_ref_enabled_flag);
+            bs.PutFlag(flags.residual_adaptive_colour_transform_enabled_flag);
+            if (flags.residual_adaptive_colour_transform_enabled_flag) {
+                bs.PutFlag(flags.pps_slice_act_qp_offsets_present_flag);
+                bs.PutSe(pPps->pps_act_y_qp_offset_plus5 - 5);
+                bs.PutSe(pPps->pps_act_cb_qp_offset_plus5 - 5);
+                bs.PutSe(pPps->pps_act_cr_qp_offset_plus3 - 3);
+            }
+            const bool initializers = flags.pps_palette_predictor_initializers_present_flag &&
+                                      (pPps->pPredictorPaletteEntries != nullptr);
+            bs.PutFlag(initializers);
+            if (initializers) {
+                bs.PutUe(pPps->pps_num_palette_predictor_initializers);
+                if (pPps->pps_num_palette_predictor_initializers > 0) {
+                    bs.PutFlag(flags.monochrome_palette_flag);
+                    bs.PutUe(pPps->luma_bit_depth_entry_minus8);
+                    if (!flags.monochrome_palette_flag) {
+                        bs.PutUe(pPps->chroma_bit_depth_entry_minus8);
+                    }
+                    const uint32_t numComps = flags.monochrome_palette_flag ? 1 : 3;
+                    for (uint32_t comp = 0; comp < numComps; comp++) {
+                        const uint32_t bitDepth = 8 + ((comp == 0) ? pPps->luma_bit_depth_entry_minus8 : pPps->chroma_bit_depth_entry_minus8);
+                        for (uint32_t i = 0; i < pPps->pps_num_palette_predictor_initializers; i++) {
+                            bs.PutBits(pPps->pPredictorPaletteEntries->PredictorPaletteEntries[comp][i], bitDepth);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    bs.PutTrailingBits();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// AV1
+
+bool VkEncoderHeaderWriter::WriteAv1SequenceHeader(const StdVideoAV1SequenceHeader* pSeqHdr,
+                                                   const StdVideoEncodeAV1DecoderModelInfo* pDecoderModelInfo,
+                                                   uint32_t operatingPointCount,
+                                                   const StdVideoEncodeAV1OperatingPointInfo* pOperatingPoints,
+                                                   VkEncoderBitWriter& bs)
+{
+    assert(pSeqHdr != nullptr);
+    const StdVideoAV1SequenceHeaderFlags& flags = pSeqHdr->flags;
+    if ((pSeqHdr->pColorConfig == nullptr) || (operatingPointCount > 32) ||
+        ((operatingPointCount > 0) && (pOperatingPoints == nullptr))) {
+        return false;
+    }
+    const StdVideoAV1ColorConfig& colorConfig = *pSeqHdr->pColorConfig;
+
+    bs.PutBits(pSeqHdr->seq_profile, 3);
+    bs.PutFlag(flags.still_picture);
+    bs.PutFlag(flags.reduced_still_picture_header);
+    if (flags.reduced_still_picture_header) {
+        bs.PutBits((operatingPointCount > 0) ? pOperatingPoints[0].seq_level_idx : 31, 5);
+    } else {
+        const bool timingInfo = flags.timing_info_present_flag && (pSeqHdr->pTimingInfo != nullptr);
+        const bool decoderModelInfo = timingInfo && (pDecoderModelInfo != nullptr);
+        bs.PutFlag(timingInfo);
+        if (timingInfo) {
+            const StdVideoAV1TimingInfo* pTimingInfo = pSeqHdr->pTimingInfo;
+            bs.PutBits(pTimingInfo->num_units_in_display_tick, 32);
+            bs.PutBits(pTimingInfo->time_scale, 32);
+            bs.PutFlag(pTimingInfo->flags.equal_picture_interval);
+            if (pTimingInfo->flags.equal_picture_interval) {
+                bs.PutUvlc(pTimingInfo->num_ticks_per_picture_minus_1);
+            }
+            bs.PutFlag(decoderModelInfo);
+            if (decoderModelInfo) {
+                bs.PutBits(pDecoderModelInfo->buffer_delay_length_minus_1, 5);
+                bs.PutBits(pDecoderModelInfo->num_units_in_decoding_tick, 32);
+                bs.PutBits(pDecoderModelInfo->buffer_removal_time_length_minus_1, 5);
+                bs.PutBits(pDecoderModelInfo->frame_presentation_time_length_minus_1, 5);
+            }
+        }
+        bs.PutFlag(flags.initial_display_delay_present_flag);
+
+        const uint32_t numOperatingPoints = (operatingPointCount > 0) ? operatingPointCount : 1;
+        bs.PutBits(numOperatingPoints - 1, 5);
+        for (uint32_t i = 0; i < numOperatingPoints; i++) {
+            StdVideoEncodeAV1OperatingPointInfo operatingPoint;
+            if (operatingPointCount > 0) {
+                operatingPoint = pOperatingPoints[i];
+            } else {
+                memset(&operatingPoint, 0, sizeof(operatingPoint));
+                operatingPoint.seq_level_idx = 31;
+            }
+            bs.PutBits(operatingPoint.operating_point_idc, 12);
+            bs.PutBits(operatingPoint.seq_level_idx, 5);
+            if (operatingPoint.seq_level_idx > 7) {
+                bs.PutBits(operatingPoint.seq_tier, 1);
+            }
+            if (decoderModelInfo) {
+                bs.PutFlag(operatingPoint.flags.decoder_model_present_for_this_op);
+                if (operatingPoint.flags.decoder_model_present_for_this_op) {
+                    const uint32_t n = pDecoderModelInfo->buffer_delay_length_minus_1 + 1;
+                    bs.PutBits(operatingPoint.decoder_buffer_delay, n);
+                    bs.PutBits(operatingPoint.encoder_buffer_delay, n);
+                    bs.PutFlag(operatingPoint.flags.low_delay_mode_flag);
+                }
+            }
+            if (flags.initial_display_delay_present_flag) {
+                bs.PutFlag(operatingPoint.flags.initial_display_delay_present_for_this_op);
+                if (operatingPoint.flags.initial_display_delay_present_for_this_op) {
+                    bs.PutBits(operatingPoint.initial_display_delay_minus_1, 4);
+                }
+            }
+        }
+    }
+
+    bs.PutBits(pSeqHdr->frame_width_bits_minus_1, 4);
+    bs.PutBits(pSeqHdr->frame_height_bits_minus_1, 4);
+    bs.PutBits(pSeqHdr->max_frame_width_minus_1, pSeqHdr->frame_width_bits_minus_1 + 1);
+    bs.PutBits(pSeqHdr->max_frame_height_minus_1, pSeqHdr->frame_height_bits_minus_1 + 1);
+    if (!flags.reduced_still_picture_header) {
+        bs.PutFlag(flags.frame_id_numbers_present_flag);
+        if (flags.frame_id_numbers_present_flag) {
+            bs.PutBits(pSeqHdr->delta_frame_id_length_minus_2, 4);
+            bs.PutBits(pSeqHdr->additional_frame_id_length_minus_1, 3);
+        }
+    }
+    bs.PutFlag(flags.use_128x128_superblock);
+    bs.PutFlag(flags.enable_filter_intra);
+    bs.PutFlag(flags.enable_intra_edge_filter);
+    if (!flags.reduced_still_picture_header) {
+        bs.PutFlag(flags.enable_interintra_compound);
+        bs.PutFlag(flags.enable_masked_compound);
+        bs.PutFlag(flags.enable_warped_motion);
+        bs.PutFlag(flags.enable_dual_filter);
+        bs.PutFlag(flags.enable_order_hint);
+        if (flags.enable_order_hint) {
+            bs.PutFlag(flags.enable_jnt_comp);
+            bs.PutFlag(flags.enable_ref_frame_mvs);
+        }
+        const bool chooseScreenContentTools = (pSeqHdr->seq_force_screen_content_tools == STD_VIDEO_AV1_SELECT_SCREEN_CONTENT_TOOLS);
+        bs.PutFlag(chooseScreenContentTools);  // seq_choose_screen_content_tools
+        if (!chooseScreenContentTools) {
+            bs.PutFlag(pSeqHdr->seq_force_screen_content_tools != 0);
+        }
+        if (pSeqHdr->seq_force_screen_content_tools > 0) {
+            const bool chooseIntegerMv = (pSeqHdr->seq_force_integer_mv == STD_VIDEO_AV1_SELECT_INTEGER_MV);
+            bs.PutFlag(chooseIntegerMv);       // seq_choose_integer_mv
+            if (!chooseIntegerMv) {
+                bs.PutFlag(pSeqHdr->seq_force_integer_mv != 0);
+            }
+        }
+        if (flags.enable_order_hint) {
+            bs.PutBits(pSeqHdr->order_hint_bits_minus_1, 3);
+        }
+    }
+    bs.PutFlag(flags.enable_superres);
+    bs.PutFlag(flags.enable_cdef);
+    bs.PutFlag(flags.enable_restoration);
+
+    // color_config()
+    const bool highBitDepth = (colorConfig.BitDepth > 8);
+    bs.PutFlag(highBitDepth);
+    if ((pSeqHdr->seq_profile == STD_VIDEO_AV1_PROFILE_PROFESSIONAL) && highBitDepth) {
+        bs.PutFlag(colorConfig.BitDepth == 12);
+    }
+    if (pSeqHdr->seq_profile != STD_VIDEO_AV1_PROFILE_HIGH) {
+        bs.PutFlag(colorConfig.flags.mono_chrome);
+    }
+    bs.PutFlag(colorConfig.flags.color_description_present_flag);
+    if (colorConfig.flags.color_description_present_flag) {
+        bs.PutBits(colorConfig.color_primaries, 8);
+        bs.PutBits(colorConfig.transfer_characteristics, 8);
+        bs.PutBits(colorConfig.matrix_coefficients, 8);
+    }
+    if (colorConfig.flags.mono_chrome) {
+        bs.PutFlag(colorConfig.flags.color_range);
+    } else {
+        const bool srgb = colorConfig.flags.color_description_present_flag &&
+                          (colorConfig.color_primaries == STD_VIDEO_AV1_COLOR_PRIMARIES_BT_709) &&
+                          (colorConfig.transfer_characteristics == STD_VIDEO_AV1_TRANSFER_CHARACTERISTICS_SRGB) &&
+                          (colorConfig.matrix_coefficients == STD_VIDEO_AV1_MATRIX_COEFFICIENTS_IDENTITY);
+        if (!srgb) {
+            bs.PutFlag(colorConfig.flags.color_range);
+            if ((pSeqHdr->seq_profile == STD_VIDEO_AV1_PROFILE_PROFESSIONAL) && (colorConfig.BitDepth == 12)) {
+                bs.PutBits(colorConfig.subsampling_x, 1);
+                if (colorConfig.subsampling_x) {
+                    bs.PutBits(colorConfig.subsampling_y, 1);
+                }
+            }
+            const bool subsampled420 = (pSeqHdr->seq_profile == STD_VIDEO_AV1_PROFILE_MAIN) ||
+                                       ((pSeqHdr->seq_profile == STD_VIDEO_AV1_PROFILE_PROFESSIONAL) &&
+                                        (colorConfig.BitDepth == 12) && colorConfig.subsampling_x && colorConfig.subsampling_y);
+            if (subsampled420) {
+                bs.PutBits(colorConfig.chroma_sample_position, 2);
+            }
+        }
+        bs.PutFlag(colorConfig.flags.separate_uv_delta_q);
+    }
+    bs.PutFlag(flags.film_grain_params_present);
+
+    bs.PutTrailingBits();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// NAL unit and OBU framing
+
+uint32_t VkEncoderHeaderWriter::AppendNalUnit(const uint8_t* pNalUnit, size_t headerSize, size_t size,
+                                              std::vector<uint8_t>& out)
+{
+    static const uint8_t startCode[] = { 0x00, 0x00, 0x00, 0x01 };
+    out.insert(out.end(), startCode, startCode + sizeof(startCode));
+    out.insert(out.end(), pNalUnit, pNalUnit + headerSize);
+
+    // An emulation_prevention_three_byte follows any two zero bytes that
+    // would otherwise be followed by a byte of 0x03 or less.
+    uint32_t numEmulationPreventionBytes = 0;
+    uint32_t zeroCount = 0;
+    for (size_t i = headerSize; i < size; i++) {
+        const uint8_t byte = pNalUnit[i];
+        if ((zeroCount >= 2) && (byte <= 0x03)) {
+            out.push_back(0x03);
+            numEmulationPreventionBytes++;
+            zeroCount = 0;
+        }
+        out.push_back(byte);
+        zeroCount = (byte == 0x00) ? (zeroCount + 1) : 0;
+    }
+    // A NAL unit can not end with a zero byte (cabac_zero_words).
+    if ((size > headerSize) && (pNalUnit[size - 1] == 0x00)) {
+        out.push_back(0x03);
+        numEmulationPreventionBytes++;
+    }
+    return numEmulationPreventionBytes;
+}
+
+uint32_t VkEncoderHeaderWriter::AppendH264NalUnit(uint32_t nalRefIdc, uint32_t nalUnitType,
+                                                  const uint8_t* pRbsp, size_t rbspSize, std::vector<uint8_t>& out)
+{
+    std::vector<uint8_t> nalUnit(1 + rbspSize);
+    nalUnit[0] = (uint8_t)(((nalRefIdc & 0x3) << 5) | (nalUnitType & 0x1f));
+    if (rbspSize > 0) {
+        memcpy(&nalUnit[1], pRbsp, rbspSize);
+    }
+    return AppendNalUnit(nalUnit.data(), 1, nalUnit.size(), out);
+}
+
+uint32_t VkEncoderHeaderWriter::AppendH265NalUnit(uint32_t nalUnitType, uint32_t temporalId,
+                                                  const uint8_t* pRbsp, size_t rbspSize, std::vector<uint8_t>& out)
+{
+    std::vector<uint8_t> nalUnit(2 + rbspSize);
+    nalUnit[0] = (uint8_t)((nalUnitType & 0x3f) << 1);   // forbidden_zero_bit, nuh_layer_id = 0
+    nalUnit[1] = (uint8_t)((temporalId + 1) & 0x7);      // nuh_temporal_id_plus1
+    if (rbspSize > 0) {
+        memcpy(&nalUnit[2], pRbsp, rbspSize);
+    }
+    return AppendNalUnit(nalUnit.data(), 2, nalUnit.size(), out);
+}
+
+void VkEncoderHeaderWriter::AppendLeb128(uint64_t value, std::vector<uint8_t>& out, uint32_t minBytes)
+{
+    uint32_t numBytes = 0;
+    do {
+        uint8_t byte = (uint8_t)(value & 0x7f);
+        value >>= 7;
+        numBytes++;
+        if ((value != 0) || (numBytes < minBytes)) {
+            byte |= 0x80;
+        }
+        out.push_back(byte);
+    } while ((value != 0) || (numBytes < minBytes));
+}
+
+void VkEncoderHeaderWriter::AppendObu(uint32_t obuType, const uint8_t* pPayload, size_t payloadSize,
+                                      std::vector<uint8_t>& out, bool extension,
+                                      uint32_t temporalId, uint32_t spatialId)
+{
+    out.push_back((uint8_t)(((obuType & 0xf) << 3) | (extension ? 0x4 : 0) | 0x2));  // obu_has_size_field
+    if (extension) {
+        out.push_back((uint8_t)(((temporalId & 0x7) << 5) | ((spatialId & 0x3) << 3)));
+    }
+    AppendLeb128(payloadSize, out);
+    if (payloadSize > 0) {
+        out.insert(out.end(), pPayload, pPayload + payloadSize);
+    }
+}
+
+bool VkEncoderHeaderWriter::AppendH264ParameterSets(const StdVideoH264SequenceParameterSet* pSps,
+                                                    const StdVideoH264PictureParameterSet* pPps,
+                                                    std::vector<uint8_t>& out)
+{
+    VkEncoderBitWriter bs;
+    if (pSps != nullptr) {
+        if (!WriteH264Sps(pSps, bs)) {
+            return false;
+        }
+        AppendH264NalUnit(3, H264_NAL_SPS, bs.GetData().data(), bs.GetData().size(), out);
+        bs.Reset();
+    }
+    if (pPps != nullptr) {
+        if (!WriteH264Pps(pSps, pPps, bs)) {
+            return false;
+        }
+        AppendH264NalUnit(3, H264_NAL_PPS, bs.GetData().data(), bs.GetData().size(), out);
+    }
+    return true;
+}
+
+bool VkEncoderHeaderWriter::AppendH265ParameterSets(const StdVideoH265VideoParameterSet* pVps,
+                                                    const StdVideoH265SequenceParameterSet* pSps,
+                                                    const StdVideoH265PictureParameterSet* pPps,
+                                                    std::vector<uint8_t>& out)
+{
+    VkEncoderBitWriter bs;
+    if (pVps != nullptr) {
+        if (!WriteH265Vps(pVps, bs)) {
+            return false;
+        }
+        AppendH265NalUnit(H265_NAL_VPS, 0, bs.GetData().data(), bs.GetData().size(), out);
+        bs.Reset();
+    }
+    if (pSps != nullptr) {
+        if (!WriteH265Sps(pSps, bs)) {
+            return false;
+        }
+        AppendH265NalUnit(H265_NAL_SPS, 0, bs.GetData().data(), bs.GetData().size(), out);
+        bs.Reset();
+    }
+    if (pPps != nullptr) {
+        if (!WriteH265Pps(pPps, bs)) {
+            return false;
+        }
+        AppendH265NalUnit(H265_NAL_PPS, 0, bs.GetData().data(), bs.GetData().size(), out);
+    }
+    return true;
+}
+
+bool VkEncoderHeaderWriter::AppendAv1SequenceHeader(const StdVideoAV1SequenceHeader* pSeqHdr,
+                                                    const StdVideoEncodeAV1DecoderModelInfo* pDecoderModelInfo,
+                                                    uint32_t operatingPointCount,
+                                                    const StdVideoEncodeAV1OperatingPointInfo* pOperatingPoints,
+                                                    std::vector<uint8_t>& out)
+{
+    VkEncoderBitWriter bs;
+    if (!WriteAv1SequenceHeader(pSeqHdr, pDecoderModelInfo, operatingPointCount, pOperatingPoints, bs)) {
+        return false;
+    }
+    AppendObu(AV1_OBU_SEQUENCE_HEADER, bs.GetData().data(), bs.GetData().size(), out);
+    return true;
+}
+
+void VkEncoderHeaderWriter::WriteSeiRbsp(uint32_t payloadType, VkEncoderBitWriter& payload, VkEncoderBitWriter& bs)
+{
+    if (!payload.IsByteAligned()) {
+        payload.PutTrailingBits(); // payload_bit_equal_to_one + payload_bit_equal_to_zero
+    }
+    assert(payload.GetData().size() < 255);
+    bs.PutBits(payloadType, 8);
+    bs.PutBits((uint32_t)payload.GetData().size(), 8);
+    bs.PutBytes(payload.GetData().data(), payload.GetData().size());
+    bs.PutTrailingBits();
+}
+
+void VkEncoderHeaderWriter::AppendH264RecoveryPointSei(uint32_t recoveryFrameCount, bool exactMatch,
+                                                       std::vector<uint8_t>& out)
+{
+    VkEncoderBitWriter payload;
+    payload.PutUe(recoveryFrameCount);  // recovery_frame_cnt
+    payload.PutFlag(exactMatch);        // exact_match_flag
+    payload.PutFlag(false);             // broken_link_flag
+    payload.PutBits(0, 2);              // changing_slice_group_idc
+
+    VkEncoderBitWriter bs;
+    WriteSeiRbsp(SEI_RECOVERY_POINT, payload, bs);
+    AppendH264NalUnit(0, H264_NAL_SEI, bs.GetData().data(), bs.GetData().size(), out);
+}
+
+void VkEncoderHeaderWriter::AppendH265RecoveryPointSei(int32_t recoveryPocCount, bool exactMatch,
+                                                       std::vector<uint8_t>& out)
+{
+    VkEncoderBitWriter payload;
+    payload.PutSe(recoveryPocCount);    // recovery_poc_cnt
+    payload.PutFlag(exactMatch);        // exact_match_flag
+    payload.PutFlag(false);             // broken_link_flag
+
+    VkEncoderBitWriter bs;
+    WriteSeiRbsp(SEI_RECOVERY_POINT, payload, bs);
+    AppendH265NalUnit(H265_NAL_PREFIX_SEI, 0, bs.GetData().data(), bs.GetData().size(), out);
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEOENCODER_VKENCODERHEADERWRITER_H_
+#define _VKVIDEOENCODER_VKENCODERHEADERWRITER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "vk_video/vulkan_video_codecs_common.h"
+#include "vk_video/vulkan_video_codec_h264std.h"
+#include "vk_video/vulkan_video_codec_h265std.h"
+#include "vk_video/vulkan_video_codec_av1std.h"
+#include "vk_video/vulkan_video_codec_av1std_encode.h"
+
+// Writes the bits of an H.264/H.265 RBSP or of an AV1 OBU payload, most
+// significant bit first. The emulation prevention and the NAL unit / OBU
+// framing are added by VkEncoderHeaderWriter.
+class VkEncoderBitWriter {
+
+public:
+
+    VkEncoderBitWriter()
+        : m_data()
+        , m_cache(0)
+        , m_cacheBits(0) { }
+
+    void PutBits(uint32_t value, uint32_t numBits);
+    void PutFlag(bool flag) { PutBits(flag ? 1 : 0, 1); }
+    void PutUe(uint32_t value);         // ue(v)
+    void PutSe(int32_t value);          // se(v)
+    void PutUvlc(uint32_t value);       // AV1 uvlc()
+
+    // rbsp_trailing_bits() / AV1 trailing_bits(): a one bit, then zero bits up to the byte boundary.
+    void PutTrailingBits();
+    // Pads with zero bits (AV1 byte_alignment()) or one bits (cabac_alignment_one_bit) up to the byte boundary.
+    void PutAlignmentBits(bool oneBits = false);
+    void PutBytes(const uint8_t* pData, size_t size);
+
+    bool IsByteAligned() const { return (m_cacheBits == 0); }
+    size_t GetBitCount() const { return (m_data.size() * 8) + m_cacheBits; }
+
+    // The written bytes. Only complete once the writer is byte aligned.
+    const std::vector<uint8_t>& GetData() const { return m_data; }
+
+    void Reset()
+    {
+        m_data.clear();
+        m_cache = 0;
+        m_cacheBits = 0;
+    }
+
+private:
+    std::vector<uint8_t> m_data;
+    uint32_t             m_cache;
+    uint32_t             m_cacheBits;
+};
+
+// CPU writer of the parameter sets / sequence header described by the
+// Vulkan Video Std structures the encoder fills in: H.264 SPS/PPS, H.265
+// VPS/SPS/PPS and the AV1 sequence header OBU. The RBSP writers only write
+// the syntax; Append*() adds the Annex B start code, NAL unit header and
+// emulation prevention bytes, or the OBU header and leb128 size.
+class VkEncoderHeaderWriter {
+
+public:
+
+    enum { H264_NAL_SEI = 6, H264_NAL_SPS = 7, H264_NAL_PPS = 8 };
+    enum { H265_NAL_VPS = 32, H265_NAL_SPS = 33, H265_NAL_PPS = 34, H265_NAL_PREFIX_SEI = 39 };
+    enum { SEI_RECOVERY_POINT = 6 };
+    enum { AV1_OBU_SEQUENCE_HEADER = 1 };
+
+    // H.264 seq_parameter_set_data() + rbsp_trailing_bits().
+    static bool WriteH264Sps(const StdVideoH264SequenceParameterSet* pSps, VkEncoderBitWriter& bs,
+                             bool trailingBits = true);
+    // pSps provides chroma_format_idc for the PPS scaling lists.
+    static bool WriteH264Pps(const StdVideoH264SequenceParameterSet* pSps,
+                             const StdVideoH264PictureParameterSet* pPps, VkEncoderBitWriter& bs);
+
+    static bool WriteH265Vps(const StdVideoH265VideoParameterSet* pVps, VkEncoderBitWriter& bs);
+    static bool WriteH265Sps(const StdVideoH265SequenceParameterSet* pSps, VkEncoderBitWriter& bs);
+    static bool WriteH265Pps(const StdVideoH265PictureParameterSet* pPps, VkEncoderBitWriter& bs);
+
+    // Without operating points, a single operating point of all the layers is
+    // written, with seq_level_idx 31 (no level constraints). pDecoderModelInfo
+    // is only used with timing info.
+    static bool WriteAv1SequenceHeader(const StdVideoAV1SequenceHeader* pSeqHdr,
+                                       const StdVideoEncodeAV1DecoderModelInfo* pDecoderModelInfo,
+                                       uint32_t operatingPointCount,
+                                       const StdVideoEncodeAV1OperatingPointInfo* pOperatingPoints,
+                                       VkEncoderBitWriter& bs);
+
+    // Appends a start code, the H.264 (1 byte) or H.265 (2 bytes) NAL unit
+    // header and the RBSP with emulation prevention. Returns the number of
+    // emulation prevention bytes inserted.
+    static uint32_t AppendH264NalUnit(uint32_t nalRefIdc, uint32_t nalUnitType,
+                                      const uint8_t* pRbsp, size_t rbspSize, std::vector<uint8_t>& out);
+    static uint32_t AppendH265NalUnit(uint32_t nalUnitType, uint32_t temporalId,
+                                      const uint8_t* pRbsp, size_t rbspSize, std::vector<uint8_t>& out);
+    // Appends a start code and a NAL unit whose header is part of pNalUnit.
+    static uint32_t AppendNalUnit(const uint8_t* pNalUnit, size_t headerSize, size_t size,
+                                  std::vector<uint8_t>& out);
+
+    // Appends an OBU header with obu_has_size_field, the leb128 size and the payload.
+    static void AppendObu(uint32_t obuType, const uint8_t* pPayload, size_t payloadSize,
+                          std::vector<uint8_t>& out, bool extension = false,
+                          uint32_t temporalId = 0, uint32_t spatialId = 0);
+    static void AppendLeb128(uint64_t value, std::vector<uint8_t>& out, uint32_t minBytes = 0);
+
+    // Annex B SPS + PPS / VPS + SPS + PPS, and the AV1 sequence header OBU.
+    static bool AppendH264ParameterSets(const StdVideoH264SequenceParameterSet* pSps,
+                                        const StdVideoH264PictureParameterSet* pPps,
+                                        std::vector<uint8_t>& out);
+    static bool AppendH265ParameterSets(const StdVideoH265VideoParameterSet* pVps,
+                                        const StdVideoH265SequenceParameterSet* pSps,
+                                        const StdVideoH265PictureParameterSet* pPps,
+                                        std::vector<uint8_t>& out);
+    static bool AppendAv1SequenceHeader(const StdVideoAV1SequenceHeader* pSeqHdr,
+                                        const StdVideoEncodeAV1DecoderModelInfo* pDecoderModelInfo,
+                                        uint32_t operatingPointCount,
+                                        const StdVideoEncodeAV1OperatingPointInfo* pOperatingPoints,
+                                        std::vector<uint8_t>& out);
+
+    // Annex B SEI NAL unit with a single recovery point message. The decoding
+    // starting at this picture is correct (exactMatch) or acceptable from the
+    // picture recoveryCount frames / POCs later.
+    static void AppendH264RecoveryPointSei(uint32_t recoveryFrameCount, bool exactMatch,
+                                           std::vector<uint8_t>& out);
+    static void AppendH265RecoveryPointSei(int32_t recoveryPocCount, bool exactMatch,
+                                           std::vector<uint8_t>& out);
+
+    // level_idc / general_level_idc of the Std level enums.
+    static uint32_t GetH264LevelIdc(StdVideoH264LevelIdc level);
+    static uint32_t GetH265LevelIdc(StdVideoH265LevelIdc level);
+
+private:
+    static void WriteH264ScalingList(const uint8_t* pList, uint32_t size, bool useDefault, VkEncoderBitWriter& bs);
+    static void WriteH264HrdParameters(const StdVideoH264HrdParameters* pHrd, VkEncoderBitWriter& bs);
+    static void WriteH264Vui(const StdVideoH264SequenceParameterSetVui* pVui, VkEncoderBitWriter& bs);
+
+    static void WriteH265ProfileTierLevel(const StdVideoH265ProfileTierLevel* pPtl, uint32_t maxSubLayersMinus1,
+                                          VkEncoderBitWriter& bs);
+    static void WriteH265SubLayerOrdering(const StdVideoH265DecPicBufMgr* pDpbMgr, bool subLayerOrderingInfoPresent,
+                                          uint32_t maxSubLayersMinus1, VkEncoderBitWriter& bs);
+    static void WriteH265HrdParameters(const StdVideoH265HrdParameters* pHrd, bool commonInfPresent,
+                                       uint32_t maxSubLayersMinus1, VkEncoderBitWriter& bs);
+    static void WriteH265ScalingListData(const StdVideoH265ScalingLists* pScalingLists, VkEncoderBitWriter& bs);
+    static void WriteH265ShortTermRefPicSet(const StdVideoH265ShortTermRefPicSet* pStRps, uint32_t stRpsIdx,
+                                            uint32_t numShortTermRefPicSets, VkEncoderBitWriter& bs);
+    static void WriteH265Vui(const StdVideoH265SequenceParameterSetVui* pVui, uint32_t maxSubLayersMinus1,
+                             VkEncoderBitWriter& bs);
+
+    // sei_message() with a single byte payloadType and payloadSize, then rbsp_trailing_bits().
+    static void WriteSeiRbsp(uint32_t payloadType, VkEncoderBitWriter& payload, VkEncoderBitWriter& bs);
+};
+
+#endif /* _VKVIDEOENCODER_VKENCODERHEADERWRITER_H_ */
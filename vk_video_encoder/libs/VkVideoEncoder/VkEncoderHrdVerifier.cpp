@@ -0,0 +1,207 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "VkVideoEncoder/VkEncoderHrdVerifier.h"
+
+VkEncoderHrdVerifier::VkEncoderHrdVerifier()
+    : m_bitRate(0)
+    , m_cpbSize(0)
+    , m_initialDelay(0)
+    , m_frameInterval(0.0)
+    , m_fullness(0.0)
+    , m_stats()
+    , m_enabled(false)
+    , m_isCbr(false)
+    , m_verbose(false)
+{
+}
+
+bool VkEncoderHrdVerifier::Configure(uint32_t bitRate, uint32_t cpbSize, uint32_t initialDelay,
+                                     uint32_t frameRateNumerator, uint32_t frameRateDenominator,
+                                     bool isCbr, bool verbose)
+{
+    m_enabled = false;
+
+    if ((bitRate == 0) || (cpbSize == 0) ||
+            (frameRateNumerator == 0) || (frameRateDenominator == 0)) {
+        fprintf(stderr, "HRD verifier: invalid parameters bitrate %u, cpb size %u, frame rate %u/%u\n",
+                bitRate, cpbSize, frameRateNumerator, frameRateDenominator);
+        return false;
+    }
+
+    m_bitRate = bitRate;
+    m_cpbSize = cpbSize;
+    m_initialDelay = (initialDelay == 0 || initialDelay > cpbSize) ? cpbSize : initialDelay;
+    m_frameInterval = (double)frameRateDenominator / (double)frameRateNumerator;
+    m_isCbr = isCbr;
+    m_verbose = verbose;
+
+    // The first access unit is removed once initialDelay bits have arrived.
+    m_fullness = (double)m_initialDelay;
+
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_stats.minFullnessBits = (double)m_cpbSize;
+
+    m_enabled = true;
+    return true;
+}
+
+void VkEncoderHrdVerifier::UpdateRate(const RateUpdate& rateUpdate)
+{
+    if (!m_enabled || (rateUpdate.bitRate == 0)) {
+        return;
+    }
+
+    if ((rateUpdate.bitRate != m_bitRate) || (rateUpdate.cpbSize != 0 && rateUpdate.cpbSize != m_cpbSize)) {
+        if (m_verbose) {
+            fprintf(stderr, "HRD verifier: rate update after access unit %llu, bitrate %u -> %u bits/s, cpb size %u -> %u bits\n",
+                    (unsigned long long)m_stats.numAccessUnits, m_bitRate, rateUpdate.bitRate,
+                    m_cpbSize, rateUpdate.cpbSize ? rateUpdate.cpbSize : m_cpbSize);
+        }
+        m_stats.numRateUpdates++;
+    }
+
+    m_bitRate = rateUpdate.bitRate;
+    if (rateUpdate.cpbSize != 0) {
+        m_cpbSize = rateUpdate.cpbSize;
+        if (m_initialDelay > m_cpbSize) {
+            m_initialDelay = m_cpbSize;
+        }
+        if (m_fullness > (double)m_cpbSize) {
+            m_fullness = (double)m_cpbSize;
+        }
+    }
+    if ((rateUpdate.frameRateNumerator != 0) && (rateUpdate.frameRateDenominator != 0)) {
+        m_frameInterval = (double)rateUpdate.frameRateDenominator / (double)rateUpdate.frameRateNumerator;
+    }
+}
+
+uint32_t VkEncoderHrdVerifier::GetInitialCpbRemovalDelay() const
+{
+    if (m_bitRate == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)m_initialDelay * 90000ULL) / m_bitRate);
+}
+
+void VkEncoderHrdVerifier::VerifyAccessUnit(uint64_t accessUnitNum, size_t accessUnitSizeInBytes)
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    const uint64_t accessUnitBits = (uint64_t)accessUnitSizeInBytes * 8;
+
+    m_stats.numAccessUnits++;
+    m_stats.totalBits += accessUnitBits;
+    m_stats.durationSec += m_frameInterval;
+    if (accessUnitBits > m_stats.maxAccessUnitBits) {
+        m_stats.maxAccessUnitBits = accessUnitBits;
+        m_stats.maxAccessUnitNum = accessUnitNum;
+    }
+
+    // Bits arrive in order at a constant rate, so at removal time the oldest
+    // bit in the CPB is the first bit of this access unit.
+    const double cpbDelaySec = m_fullness / m_bitRate;
+    if (cpbDelaySec > m_stats.maxCpbDelaySec) {
+        m_stats.maxCpbDelaySec = cpbDelaySec;
+    }
+
+    if (m_fullness > m_stats.maxFullnessBits) {
+        m_stats.maxFullnessBits = m_fullness;
+    }
+
+    // Instantaneous removal at the nominal removal time.
+    if ((double)accessUnitBits > m_fullness) {
+        if (m_stats.numUnderflows == 0) {
+            m_stats.firstUnderflowAccessUnitNum = accessUnitNum;
+        }
+        m_stats.numUnderflows++;
+        if (m_verbose) {
+            fprintf(stderr, "HRD verifier: CPB underflow at access unit %llu, size %llu bits, fullness %.0f bits\n",
+                    (unsigned long long)accessUnitNum, (unsigned long long)accessUnitBits, m_fullness);
+        }
+        // The decoder has to wait for the remaining bits of the access unit.
+        m_fullness = 0.0;
+    } else {
+        m_fullness -= (double)accessUnitBits;
+    }
+
+    if (m_fullness < m_stats.minFullnessBits) {
+        m_stats.minFullnessBits = m_fullness;
+    }
+
+    // Arrival until the next removal time.
+    m_fullness += m_bitRate * m_frameInterval;
+    if (m_fullness > (double)m_cpbSize) {
+        if (m_isCbr) {
+            if (m_stats.numOverflows == 0) {
+                m_stats.firstOverflowAccessUnitNum = accessUnitNum;
+            }
+            m_stats.numOverflows++;
+            if (m_verbose) {
+                fprintf(stderr, "HRD verifier: CPB overflow after access unit %llu, fullness %.0f bits, cpb size %u bits\n",
+                        (unsigned long long)accessUnitNum, m_fullness, m_cpbSize);
+            }
+        }
+        // For VBR the arrival simply stops while the CPB is full.
+        m_fullness = (double)m_cpbSize;
+    }
+}
+
+double VkEncoderHrdVerifier::GetWorstCaseLatencySec() const
+{
+    return m_stats.maxCpbDelaySec + m_frameInterval;
+}
+
+void VkEncoderHrdVerifier::PrintReport(FILE* fp) const
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    const double actualBitRate = (m_stats.durationSec > 0.0) ? (m_stats.totalBits / m_stats.durationSec) : 0.0;
+
+    fprintf(fp, "HRD verifier (%s): bitrate %u bits/s, cpb size %u bits (%.1f ms), initial delay %u bits (%.1f ms, %u @90kHz)\n",
+            m_isCbr ? "CBR" : "VBR", m_bitRate, m_cpbSize, 1000.0 * m_cpbSize / m_bitRate,
+            m_initialDelay, 1000.0 * m_initialDelay / m_bitRate, GetInitialCpbRemovalDelay());
+    fprintf(fp, "\taccess units %llu, actual bitrate %.0f bits/s, largest access unit %llu bits (#%llu)\n",
+            (unsigned long long)m_stats.numAccessUnits, actualBitRate,
+            (unsigned long long)m_stats.maxAccessUnitBits, (unsigned long long)m_stats.maxAccessUnitNum);
+    fprintf(fp, "\tcpb fullness min %.0f bits, max %.0f bits\n",
+            m_stats.minFullnessBits, m_stats.maxFullnessBits);
+    fprintf(fp, "\tworst-case cpb delay %.2f ms, implied end-to-end latency %.2f ms\n",
+            1000.0 * m_stats.maxCpbDelaySec, 1000.0 * GetWorstCaseLatencySec());
+    if (m_stats.numRateUpdates > 0) {
+        fprintf(fp, "\t%u rate update(s), the parameters above are the last ones\n", m_stats.numRateUpdates);
+    }
+
+    if (m_stats.numUnderflows > 0) {
+        fprintf(fp, "\tFAIL: %u cpb underflow(s), first at access unit %llu\n",
+                m_stats.numUnderflows, (unsigned long long)m_stats.firstUnderflowAccessUnitNum);
+    }
+
+    if (m_stats.numOverflows > 0) {
+        fprintf(fp, "\tFAIL: %u cpb overflow(s), first at access unit %llu\n",
+                m_stats.numOverflows, (unsigned long long)m_stats.firstOverflowAccessUnitNum);
+    }
+
+    if ((m_stats.numUnderflows == 0) && (m_stats.numOverflows == 0)) {
+        fprintf(fp, "\tPASS: the stream conforms to the cpb buffer model\n");
+    }
+}
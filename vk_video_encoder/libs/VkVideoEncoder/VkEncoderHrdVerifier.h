@@ -0,0 +1,107 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEOENCODER_VKENCODERHRDVERIFIER_H_
+#define _VKVIDEOENCODER_VKENCODERHRDVERIFIER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// CPU-side leaky bucket model of the decoder's coded picture buffer (CPB).
+// The encoder feeds the size of every access unit in decode order and the
+// verifier simulates the bits arriving at the HRD bitrate and being removed
+// at the nominal frame interval (H.264/H.265 Annex C, AV1 decoder model with
+// a constant picture interval).
+//
+// Reports buffer underflow (an access unit not fully arrived at its removal
+// time) and, for CBR, overflow (arriving bits exceeding the CPB size). For VBR
+// the arrival pauses while the buffer is full, which is not a violation.
+class VkEncoderHrdVerifier {
+
+public:
+
+    struct Stats {
+        uint64_t numAccessUnits;
+        uint64_t totalBits;
+        uint64_t maxAccessUnitBits;
+        uint64_t maxAccessUnitNum;
+        uint32_t numUnderflows;
+        uint32_t numOverflows;
+        uint64_t firstUnderflowAccessUnitNum;
+        uint64_t firstOverflowAccessUnitNum;
+        double   minFullnessBits;       // CPB fullness right after an access unit removal
+        double   maxFullnessBits;       // CPB fullness right before an access unit removal
+        double   maxCpbDelaySec;        // worst-case time a bit spends in the CPB
+        double   durationSec;           // sum of the frame intervals of the access units
+        uint32_t numRateUpdates;
+    };
+
+    // A rate control change of the encoder, applied in decode order from the
+    // access unit that carries it. A zero bitRate means no change.
+    struct RateUpdate {
+        uint32_t bitRate;               // bits/sec
+        uint32_t cpbSize;               // bits
+        uint32_t frameRateNumerator;
+        uint32_t frameRateDenominator;
+    };
+
+    VkEncoderHrdVerifier();
+
+    // bitRate in bits/sec, cpbSize and initialDelay in bits.
+    bool Configure(uint32_t bitRate, uint32_t cpbSize, uint32_t initialDelay,
+                   uint32_t frameRateNumerator, uint32_t frameRateDenominator,
+                   bool isCbr, bool verbose = false);
+
+    bool IsEnabled() const { return m_enabled; }
+
+    // Switches to a new bitrate, CPB size and frame interval without
+    // restarting the model: the current fullness and the statistics are kept,
+    // the fullness is clipped to a smaller CPB.
+    void UpdateRate(const RateUpdate& rateUpdate);
+
+    // Account for one access unit (all headers and VCL data of one picture,
+    // or one temporal unit for AV1) in decode order.
+    void VerifyAccessUnit(uint64_t accessUnitNum, size_t accessUnitSizeInBytes);
+
+    // The buffering period SEI initial_cpb_removal_delay, in 90 kHz units.
+    uint32_t GetInitialCpbRemovalDelay() const;
+
+    // The picture timing SEI cpb_removal_delay of the next access unit, in
+    // clock ticks of num_units_in_tick / time_scale (two ticks per frame).
+    uint32_t GetCpbRemovalDelay() const { return (uint32_t)(m_stats.numAccessUnits * 2); }
+
+    const Stats& GetStats() const { return m_stats; }
+
+    // Implied end-to-end latency: the worst case CPB delay of any access unit
+    // (this includes the initial start-up delay) plus one frame interval.
+    double GetWorstCaseLatencySec() const;
+
+    void PrintReport(FILE* fp = stdout) const;
+
+private:
+    uint32_t m_bitRate;
+    uint32_t m_cpbSize;
+    uint32_t m_initialDelay;
+    double   m_frameInterval;
+    double   m_fullness;
+    Stats    m_stats;
+    uint32_t m_enabled : 1;
+    uint32_t m_isCbr : 1;
+    uint32_t m_verbose : 1;
+};
+
+#endif /* _VKVIDEOENCODER_VKENCODERHRDVERIFIER_H_ */
@@ -0,0 +1,461 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "VkVideoEncoder/VkEncoderLookahead.h"
+#include "VkVideoEncoder/VkEncoderPixelOps.h"
+
+// SSE2 is part of the x86-64 baseline and NEON of AArch64, so neither needs
+// per-file compiler flags or a runtime CPU check.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define VK_LOOKAHEAD_USE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define VK_LOOKAHEAD_USE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Averages BLOCK_SIZE rows of 8-bit samples over numBlocks blocks of
+// BLOCK_SIZE x BLOCK_SIZE, one thumbnail sample per block.
+static void DownscaleBlockRow(const uint8_t* pSrc, size_t pitch, uint32_t numBlocks, uint8_t* pDst)
+{
+    static_assert(VkEncoderLookahead::BLOCK_SIZE == 8, "The SIMD paths average 8x8 blocks");
+    const uint32_t round = (VkEncoderLookahead::BLOCK_SIZE * VkEncoderLookahead::BLOCK_SIZE) / 2;
+    uint32_t block = 0;
+#if defined(VK_LOOKAHEAD_USE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; (block + 2) <= numBlocks; block += 2) {
+        // Two blocks per load, _mm_sad_epu8 sums each 8-byte half
+        __m128i acc = _mm_setzero_si128();
+        for (uint32_t row = 0; row < VkEncoderLookahead::BLOCK_SIZE; row++) {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(pSrc + (row * pitch) + (block * 8)));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+        }
+        pDst[block]     = (uint8_t)((_mm_cvtsi128_si32(acc) + round) >> 6);
+        pDst[block + 1] = (uint8_t)((_mm_extract_epi16(acc, 4) + round) >> 6);
+    }
+#elif defined(VK_LOOKAHEAD_USE_NEON)
+    for (; (block + 2) <= numBlocks; block += 2) {
+        uint16x8_t acc = vdupq_n_u16(0);
+        for (uint32_t row = 0; row < VkEncoderLookahead::BLOCK_SIZE; row++) {
+            acc = vpadalq_u8(acc, vld1q_u8(pSrc + (row * pitch) + (block * 8)));
+        }
+        const uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(acc));
+        pDst[block]     = (uint8_t)((vgetq_lane_u64(sums, 0) + round) >> 6);
+        pDst[block + 1] = (uint8_t)((vgetq_lane_u64(sums, 1) + round) >> 6);
+    }
+#endif
+    for (; block < numBlocks; block++) {
+        uint32_t sum = 0;
+        for (uint32_t row = 0; row < VkEncoderLookahead::BLOCK_SIZE; row++) {
+            const uint8_t* pRow = pSrc + (row * pitch) + (block * VkEncoderLookahead::BLOCK_SIZE);
+            for (uint32_t x = 0; x < VkEncoderLookahead::BLOCK_SIZE; x++) {
+                sum += pRow[x];
+            }
+        }
+        pDst[block] = (uint8_t)((sum + round) >> 6);
+    }
+}
+
+VkEncoderLookahead::VkEncoderLookahead()
+    : m_config()
+    , m_frameSource()
+    , m_thumbnailWidth(0)
+    , m_thumbnailHeight(0)
+    , m_slots()
+    , m_workers()
+    , m_mutex()
+    , m_jobCondition()
+    , m_readyCondition()
+    , m_jobs()
+    , m_nextSubmit(0)
+    , m_nextCompare(0)
+    , m_nextDecide(0)
+    , m_lastSceneCut(uint64_t(-1))
+    , m_stats()
+    , m_enabled(false)
+    , m_exit(false)
+    , m_verbose(false)
+{
+}
+
+VkEncoderLookahead::~VkEncoderLookahead()
+{
+    Stop();
+}
+
+bool VkEncoderLookahead::Configure(const Config& config, const FrameSource& frameSource, bool verbose)
+{
+    Stop();
+    m_enabled = false;
+
+    if ((config.depth == 0) || (config.numFrames == 0) || !frameSource) {
+        return false;
+    }
+
+    if ((config.width < (2 * BLOCK_SIZE)) || (config.height < (2 * BLOCK_SIZE)) ||
+            (config.bytesPerSample < 1) || (config.bytesPerSample > 2) ||
+            (config.lumaPitch < (config.width * config.bytesPerSample))) {
+        fprintf(stderr, "Lookahead: unsupported input %ux%u, %u byte(s) per sample, pitch %u\n",
+                config.width, config.height, config.bytesPerSample, config.lumaPitch);
+        return false;
+    }
+
+    m_config = config;
+    // A frame is decided once MOTION_WINDOW frames after it are analyzed
+    m_config.depth = std::max<uint32_t>(config.depth, MOTION_WINDOW + 1);
+    m_frameSource = frameSource;
+    m_verbose = verbose;
+    m_thumbnailWidth = config.width / BLOCK_SIZE;
+    m_thumbnailHeight = config.height / BLOCK_SIZE;
+
+    // The slots hold the window of the frame being encoded: the frames of its
+    // local motion average behind it and the depth frames ahead of it.
+    m_slots.assign(m_config.depth + MOTION_WINDOW + 2, Slot());
+    for (size_t i = 0; i < m_slots.size(); i++) {
+        m_slots[i].thumbnail.resize((size_t)m_thumbnailWidth * m_thumbnailHeight);
+    }
+
+    m_jobs.clear();
+    m_nextSubmit = 0;
+    m_nextCompare = 0;
+    m_nextDecide = 0;
+    m_lastSceneCut = uint64_t(-1);
+    m_stats = Stats();
+    m_exit = false;
+
+    if (m_config.numThreads == 0) {
+        m_config.numThreads = std::min(std::max(std::thread::hardware_concurrency(), 1U), 4U);
+    }
+    for (uint32_t i = 0; i < m_config.numThreads; i++) {
+        m_workers.push_back(std::thread(&VkEncoderLookahead::WorkerThread, this));
+    }
+
+    if (m_verbose) {
+        printf("Lookahead: depth %u, %u thread(s), %ux%u thumbnails, scene cut threshold %u\n",
+               m_config.depth, m_config.numThreads, m_thumbnailWidth, m_thumbnailHeight,
+               m_config.sceneCutThreshold);
+    }
+
+    m_enabled = true;
+    return true;
+}
+
+void VkEncoderLookahead::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_jobCondition.notify_all();
+
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        if (m_workers[i].joinable()) {
+            m_workers[i].join();
+        }
+    }
+    m_workers.clear();
+}
+
+void VkEncoderLookahead::WorkerThread()
+{
+    std::vector<uint8_t> rowBuffer((m_config.bytesPerSample > 1) ?
+                                   ((size_t)BLOCK_SIZE * BLOCK_SIZE * m_thumbnailWidth) : 0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_jobCondition.wait(lock, [this] { return m_exit || !m_jobs.empty(); });
+        if (m_exit) {
+            break;
+        }
+
+        Slot& slot = GetSlot(m_jobs.front());
+        m_jobs.pop_front();
+        lock.unlock();
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        AnalyzeFrame(slot, rowBuffer);
+        const uint64_t timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        slot.ready = true;
+        m_stats.numFrames++;
+        m_stats.workerTimeNs += timeNs;
+        m_readyCondition.notify_all();
+    }
+}
+
+void VkEncoderLookahead::AnalyzeFrame(Slot& slot, std::vector<uint8_t>& rowBuffer) const
+{
+    uint8_t* pThumbnail = slot.thumbnail.data();
+    const size_t numSamples = slot.thumbnail.size();
+
+    const uint8_t* pLuma = m_frameSource(slot.frameNum);
+    if (pLuma == nullptr) {
+        fprintf(stderr, "Lookahead: no input data for frame %llu\n", (unsigned long long)slot.frameNum);
+        memset(pThumbnail, 0, numSamples);
+    } else {
+        const uint32_t rowWidth = m_thumbnailWidth * BLOCK_SIZE;
+        for (uint32_t by = 0; by < m_thumbnailHeight; by++) {
+            const uint8_t* pRows = pLuma + ((size_t)by * BLOCK_SIZE * m_config.lumaPitch);
+            size_t pitch = m_config.lumaPitch;
+            if (m_config.bytesPerSample > 1) {
+                for (uint32_t row = 0; row < BLOCK_SIZE; row++) {
+                    VkEncoderPixelOps::ConvertRowTo8Bit((const uint16_t*)(pRows + (row * pitch)), rowWidth, m_config.sampleShift,
+                                     rowBuffer.data() + (row * rowWidth));
+                }
+                pRows = rowBuffer.data();
+                pitch = rowWidth;
+            }
+            DownscaleBlockRow(pRows, pitch, m_thumbnailWidth, pThumbnail + ((size_t)by * m_thumbnailWidth));
+        }
+    }
+
+    memset(slot.histogram, 0, sizeof(slot.histogram));
+    for (size_t i = 0; i < numSamples; i++) {
+        slot.histogram[pThumbnail[i] / (256 / NUM_HISTOGRAM_BINS)]++;
+    }
+
+    uint64_t sum = 0, sumSquares = 0;
+    VkEncoderPixelOps::SumAndSquares(pThumbnail, numSamples, sum, sumSquares);
+    const double mean = (double)sum / numSamples;
+    slot.stats.mean = (float)mean;
+    slot.stats.variance = (float)(((double)sumSquares / numSamples) - (mean * mean));
+
+    uint64_t gradients = 0;
+    for (uint32_t by = 0; by < m_thumbnailHeight; by++) {
+        const uint8_t* pRow = pThumbnail + ((size_t)by * m_thumbnailWidth);
+        gradients += VkEncoderPixelOps::SumAbsDiff(pRow, pRow + 1, m_thumbnailWidth - 1);
+        if ((by + 1) < m_thumbnailHeight) {
+            gradients += VkEncoderPixelOps::SumAbsDiff(pRow, pRow + m_thumbnailWidth, m_thumbnailWidth);
+        }
+    }
+    slot.stats.activity = (float)((double)gradients / numSamples);
+}
+
+float VkEncoderLookahead::GetThumbnailSad(const Slot& slot0, const Slot& slot1) const
+{
+    assert(slot0.thumbnail.size() == slot1.thumbnail.size());
+    const size_t numSamples = slot0.thumbnail.size();
+    return (float)((double)VkEncoderPixelOps::SumAbsDiff(slot0.thumbnail.data(), slot1.thumbnail.data(), numSamples) / numSamples);
+}
+
+void VkEncoderLookahead::CompareFrames(Slot& slot, const Slot& prevSlot) const
+{
+    assert(slot.ready && prevSlot.ready);
+    assert((prevSlot.frameNum + 1) == slot.frameNum);
+
+    slot.stats.sad = GetThumbnailSad(slot, prevSlot);
+
+    uint32_t histogramDiff = 0;
+    for (uint32_t bin = 0; bin < NUM_HISTOGRAM_BINS; bin++) {
+        histogramDiff += (slot.histogram[bin] > prevSlot.histogram[bin]) ?
+                         (slot.histogram[bin] - prevSlot.histogram[bin]) : (prevSlot.histogram[bin] - slot.histogram[bin]);
+    }
+    slot.stats.histogramDelta = (float)histogramDiff / (2.0f * slot.thumbnail.size());
+}
+
+void VkEncoderLookahead::DecideSceneCut(uint64_t frameNum, uint64_t lastFrameNum)
+{
+    FrameStats& stats = GetSlot(frameNum).stats;
+    if ((frameNum == 0) || (m_config.sceneCutThreshold == 0)) {
+        return;
+    }
+
+    // Higher thresholds accept a smaller jump over the local motion: at the
+    // default of 40 the frame must differ from its predecessor 4x more than
+    // the frames on the calmer side of it, 1.5x more than the ones on the
+    // other side, and by at least 8 levels on average.
+    const float threshold = (float)std::min(m_config.sceneCutThreshold, 100U);
+    const float motionRatio = 1.0f + ((100.0f - threshold) / 20.0f);
+    const float minSad = 2.0f + ((100.0f - threshold) / 10.0f);
+
+    if (stats.sad < minSad) {
+        return;
+    }
+
+    // The frame after a flash differs from it as much as the flash from the
+    // frame before, but continues the same scene.
+    const Slot& prevSlot = GetSlot(frameNum - 1);
+    assert(prevSlot.frameNum == (frameNum - 1));
+    if (prevSlot.stats.flash) {
+        return;
+    }
+
+    if (frameNum < lastFrameNum) {
+        const Slot& nextSlot = GetSlot(frameNum + 1);
+        assert(nextSlot.frameNum == (frameNum + 1));
+        if ((2.0f * GetThumbnailSad(nextSlot, prevSlot)) < stats.sad) {
+            stats.flash = true;
+            m_stats.numFlashes++;
+            return;
+        }
+    }
+
+    // The motion before and after the candidate, apart: a cut may end a fade
+    // or a still shot and start a fast one, or the other way round.
+    float motionSum[2] = { 0.0f, 0.0f };
+    uint32_t motionCount[2] = { 0, 0 };
+    float histogramSum = 0.0f;
+    const uint64_t firstMotionFrame = (frameNum > MOTION_WINDOW) ? (frameNum - MOTION_WINDOW) : 1;
+    const uint64_t lastMotionFrame = std::min<uint64_t>(frameNum + MOTION_WINDOW, lastFrameNum);
+    for (uint64_t i = firstMotionFrame; i <= lastMotionFrame; i++) {
+        if (i != frameNum) {
+            assert(GetSlot(i).frameNum == i);
+            const uint32_t side = (i < frameNum) ? 0 : 1;
+            motionSum[side] += GetSlot(i).stats.sad;
+            motionCount[side]++;
+            histogramSum += GetSlot(i).stats.histogramDelta;
+        }
+    }
+    if ((motionCount[0] + motionCount[1]) == 0) {
+        return;
+    }
+    float motion[2];
+    for (uint32_t side = 0; side < 2; side++) {
+        const uint32_t other = side ^ 1;
+        motion[side] = (motionCount[side] > 0) ? (motionSum[side] / motionCount[side]) :
+                                                 (motionSum[other] / motionCount[other]);
+    }
+    const float lowMotion = std::min(motion[0], motion[1]);
+    const float highMotion = std::max(motion[0], motion[1]);
+    const float localMotion = (motionSum[0] + motionSum[1]) / (motionCount[0] + motionCount[1]);
+    const float localHistogramDelta = histogramSum / (motionCount[0] + motionCount[1]);
+
+    // Cuts between shots of similar brightness keep the histogram: they need a larger SAD.
+    const bool motionCut = (stats.sad >= (motionRatio * lowMotion)) &&
+                           (stats.sad >= ((1.0f + (motionRatio / 8.0f)) * highMotion)) &&
+                           ((stats.histogramDelta >= 0.15f) || (stats.sad >= (2.0f * minSad)));
+    // In fast motion the SAD jump is smaller, but the histogram still changes at once.
+    const bool histogramCut = (stats.sad >= (0.5f * motionRatio * localMotion)) &&
+                              (stats.histogramDelta >= 0.25f) &&
+                              (stats.histogramDelta >= (motionRatio * std::max(localHistogramDelta, 0.02f)));
+    if (!motionCut && !histogramCut) {
+        return; // fast motion or a fade, not a cut
+    }
+
+    if ((m_lastSceneCut + 1) == frameNum) {
+        return; // the second frame of a cut spread over two frames
+    }
+
+    stats.sceneCut = true;
+    m_lastSceneCut = frameNum;
+    m_stats.numSceneCuts++;
+
+    if (m_verbose) {
+        printf("Lookahead: scene cut at frame %llu (sad %.1f, local motion %.1f, histogram delta %.2f, local %.2f)\n",
+               (unsigned long long)frameNum, stats.sad, localMotion, stats.histogramDelta, localHistogramDelta);
+    }
+}
+
+const VkEncoderLookahead::FrameStats& VkEncoderLookahead::GetFrameStats(uint64_t frameNum, uint32_t& framesToSceneCut)
+{
+    assert(m_enabled);
+    assert(frameNum < m_config.numFrames);
+    assert(frameNum <= m_nextDecide);
+
+    const uint64_t lastFrameNum = std::min<uint64_t>(frameNum + m_config.depth, m_config.numFrames - 1);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // Queue the frames entering the window. Their slots held frames that
+    // have left it, which the workers are done with.
+    if (m_nextSubmit <= lastFrameNum) {
+        for (; m_nextSubmit <= lastFrameNum; m_nextSubmit++) {
+            Slot& slot = GetSlot(m_nextSubmit);
+            assert((slot.frameNum == uint64_t(-1)) || slot.ready);
+            slot.frameNum = m_nextSubmit;
+            slot.ready = false;
+            slot.stats = FrameStats();
+            m_jobs.push_back(m_nextSubmit);
+        }
+        m_jobCondition.notify_all();
+    }
+
+    // The comparisons with the previous frame run in input order, on this thread.
+    for (; m_nextCompare <= lastFrameNum; m_nextCompare++) {
+        Slot& slot = GetSlot(m_nextCompare);
+        if (!slot.ready) {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            m_readyCondition.wait(lock, [&slot] { return slot.ready; });
+            m_stats.waitTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::steady_clock::now() - start).count();
+        }
+        if (m_nextCompare > 0) {
+            lock.unlock();
+            CompareFrames(slot, GetSlot(m_nextCompare - 1));
+            lock.lock();
+        }
+    }
+    lock.unlock();
+
+    // A frame is decided once the local motion window after it is known.
+    for (; m_nextDecide <= lastFrameNum; m_nextDecide++) {
+        if (((m_nextDecide + MOTION_WINDOW) > lastFrameNum) && ((lastFrameNum + 1) < m_config.numFrames)) {
+            break;
+        }
+        DecideSceneCut(m_nextDecide, lastFrameNum);
+    }
+    assert(frameNum < m_nextDecide);
+
+    framesToSceneCut = uint32_t(-1);
+    for (uint64_t i = frameNum; i < m_nextDecide; i++) {
+        if (GetSlot(i).stats.sceneCut) {
+            framesToSceneCut = (uint32_t)(i - frameNum);
+            break;
+        }
+    }
+
+    // The complexity is relative to the rest of the shot in the lookahead,
+    // without the flashes and the frames right after them.
+    FrameStats& stats = GetSlot(frameNum).stats;
+    float windowSad = 0.0f;
+    uint32_t windowCount = 0;
+    for (uint64_t i = std::max<uint64_t>(frameNum, 1); i < m_nextDecide; i++) {
+        const FrameStats& windowStats = GetSlot(i).stats;
+        if (windowStats.sceneCut && (i > frameNum)) {
+            break;
+        }
+        if (!windowStats.flash && !GetSlot(i - 1).stats.flash) {
+            windowSad += windowStats.sad;
+            windowCount++;
+        }
+    }
+    if ((frameNum > 0) && !stats.sceneCut && (windowCount > 0)) {
+        const float minSad = 0.5f;
+        stats.complexity = std::max(stats.sad, minSad) / std::max(windowSad / windowCount, minSad);
+    }
+
+    return stats;
+}
+
+void VkEncoderLookahead::PrintReport(FILE* fp) const
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    const double framesPerSecond = (m_stats.workerTimeNs > 0) ?
+                                   (1e9 * m_stats.numFrames / m_stats.workerTimeNs) : 0.0;
+    fprintf(fp, "Lookahead: depth %u, %u thread(s), %llu frame(s) analyzed at %.1f frames/s per thread\n",
+            m_config.depth, m_config.numThreads, (unsigned long long)m_stats.numFrames, framesPerSecond);
+    fprintf(fp, "\t%u scene cut(s), %u flash(es) ignored, encoder thread waited %.2f ms for the analysis\n",
+            m_stats.numSceneCuts, m_stats.numFlashes, m_stats.waitTimeNs / 1e6);
+}
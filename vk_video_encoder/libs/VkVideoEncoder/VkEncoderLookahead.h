@@ -0,0 +1,165 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEOENCODER_VKENCODERLOOKAHEAD_H_
+#define _VKVIDEOENCODER_VKENCODERLOOKAHEAD_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// CPU lookahead over the encoder input. Worker threads reduce each of the
+// next depth input frames to a thumbnail of its 8x8 luma block averages. The
+// encoder thread compares consecutive thumbnails (SAD and histogram) to find
+// the scene cuts, where the GOP structure starts a new IDR sequence, and
+// derives a per-frame temporal complexity hint for the rate control.
+class VkEncoderLookahead {
+
+public:
+
+    enum { BLOCK_SIZE = 8 };            // thumbnail downscale factor
+    enum { NUM_HISTOGRAM_BINS = 64 };
+    enum { MOTION_WINDOW = 4 };         // frames on each side of a cut candidate used for the local motion
+    enum { DEFAULT_SCENE_CUT_THRESHOLD = 40 };
+
+    // Returns the first luma sample of the input frame frameNum (input order).
+    // It is called concurrently by the worker threads and the returned data
+    // must stay valid while the lookahead runs.
+    typedef std::function<const uint8_t*(uint64_t frameNum)> FrameSource;
+
+    struct Config {
+        uint32_t width;
+        uint32_t height;
+        uint32_t lumaPitch;             // in bytes
+        uint32_t bytesPerSample;        // 1, or 2 for the 16-bit containers of the high bit depth inputs
+        uint32_t sampleShift;           // right shift of the 16-bit samples down to 8 bits
+        uint64_t numFrames;
+        uint32_t depth;                 // frames analyzed ahead of the frame being encoded
+        uint32_t sceneCutThreshold;     // 0: no scene cut detection, 1..100: higher values detect more cuts
+        uint32_t numThreads;            // 0: up to 4, depending on the CPU
+
+        Config()
+        : width(0)
+        , height(0)
+        , lumaPitch(0)
+        , bytesPerSample(1)
+        , sampleShift(0)
+        , numFrames(0)
+        , depth(0)
+        , sceneCutThreshold(DEFAULT_SCENE_CUT_THRESHOLD)
+        , numThreads(0) {}
+    };
+
+    // Thumbnail statistics, in 8-bit sample units.
+    struct FrameStats {
+        float    sad;                   // mean absolute difference to the previous frame
+        float    histogramDelta;        // half the L1 distance of the histograms to the previous frame, 0..1
+        float    mean;
+        float    variance;
+        float    activity;              // mean absolute horizontal + vertical gradient
+        float    complexity;            // sad relative to the lookahead window average, 1.0: average
+        uint32_t sceneCut : 1;
+        uint32_t flash : 1;             // differs from both neighbours, which are alike: not a cut
+
+        FrameStats()
+        : sad(0.0f)
+        , histogramDelta(0.0f)
+        , mean(0.0f)
+        , variance(0.0f)
+        , activity(0.0f)
+        , complexity(1.0f)
+        , sceneCut(false)
+        , flash(false) {}
+    };
+
+    struct Stats {
+        uint64_t numFrames;             // frames analyzed by the workers
+        uint32_t numSceneCuts;
+        uint32_t numFlashes;
+        uint64_t workerTimeNs;          // accumulated over all the workers
+        uint64_t waitTimeNs;            // encoder thread waiting for the workers
+    };
+
+    VkEncoderLookahead();
+    ~VkEncoderLookahead();
+
+    bool Configure(const Config& config, const FrameSource& frameSource, bool verbose = false);
+    bool IsEnabled() const { return m_enabled; }
+    uint32_t GetDepth() const { return m_config.depth; }
+
+    // Analyzes the frames up to frameNum + depth and returns the statistics
+    // of frameNum. framesToSceneCut is the distance, in input order, to the
+    // next scene cut in the lookahead: 0 if frameNum is a cut, uint32_t(-1)
+    // if there is none. Call it for every frame, in input order, from a
+    // single thread.
+    const FrameStats& GetFrameStats(uint64_t frameNum, uint32_t& framesToSceneCut);
+
+    // Joins the worker threads.
+    void Stop();
+
+    const Stats& GetStats() const { return m_stats; }
+    void PrintReport(FILE* fp = stdout) const;
+
+private:
+
+    struct Slot {
+        uint64_t             frameNum;  // the frame held in the slot, uint64_t(-1) if none
+        bool                 ready;     // the worker has written the thumbnail
+        std::vector<uint8_t> thumbnail;
+        uint32_t             histogram[NUM_HISTOGRAM_BINS];
+        FrameStats           stats;
+
+        Slot()
+        : frameNum(uint64_t(-1))
+        , ready(false)
+        , thumbnail()
+        , histogram()
+        , stats() {}
+    };
+
+    Slot& GetSlot(uint64_t frameNum) { return m_slots[frameNum % m_slots.size()]; }
+    void WorkerThread();
+    void AnalyzeFrame(Slot& slot, std::vector<uint8_t>& rowBuffer) const;
+    void CompareFrames(Slot& slot, const Slot& prevSlot) const;
+    void DecideSceneCut(uint64_t frameNum, uint64_t lastFrameNum);
+    float GetThumbnailSad(const Slot& slot0, const Slot& slot1) const;
+
+    Config                   m_config;
+    FrameSource              m_frameSource;
+    uint32_t                 m_thumbnailWidth;
+    uint32_t                 m_thumbnailHeight;
+    std::vector<Slot>        m_slots;
+    std::vector<std::thread> m_workers;
+    std::mutex               m_mutex;
+    std::condition_variable  m_jobCondition;    // a frame was queued, or the lookahead stops
+    std::condition_variable  m_readyCondition;  // a worker finished a frame
+    std::deque<uint64_t>     m_jobs;
+    uint64_t                 m_nextSubmit;      // next frame to queue to the workers
+    uint64_t                 m_nextCompare;     // next frame to compare to its predecessor
+    uint64_t                 m_nextDecide;      // next frame to take the scene cut decision for
+    uint64_t                 m_lastSceneCut;
+    Stats                    m_stats;
+    bool                     m_enabled;
+    bool                     m_exit;
+    bool                     m_verbose;
+};
+
+#endif /* _VKVIDEOENCODER_VKENCODERLOOKAHEAD_H_ */
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include "VkVideoEncoder/VkEncoderPixelOps.h"
+
+// SSE2 is part of the x86-64 baseline and NEON of AArch64, so neither needs
+// per-file compiler flags or a runtime CPU check.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define VK_PIXEL_OPS_USE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define VK_PIXEL_OPS_USE_NEON 1
+#include <arm_neon.h>
+#endif
+
+uint64_t VkEncoderPixelOps::SumAbsDiff(const uint8_t* pA, const uint8_t* pB, size_t size)
+{
+    uint64_t sum = 0;
+    size_t i = 0;
+#if defined(VK_PIXEL_OPS_USE_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for (; (i + 16) <= size; i += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i*)(pA + i));
+        const __m128i b = _mm_loadu_si128((const __m128i*)(pB + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(a, b));
+    }
+    sum = (uint64_t)_mm_cvtsi128_si32(acc) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#elif defined(VK_PIXEL_OPS_USE_NEON)
+    while ((i + 16) <= size) {
+        // 16-bit lanes hold up to 128 iterations of two absolute differences
+        uint16x8_t acc = vdupq_n_u16(0);
+        for (uint32_t n = 0; (n < 128) && ((i + 16) <= size); n++, i += 16) {
+            acc = vpadalq_u8(acc, vabdq_u8(vld1q_u8(pA + i), vld1q_u8(pB + i)));
+        }
+        const uint64x2_t acc64 = vpaddlq_u32(vpaddlq_u16(acc));
+        sum += vgetq_lane_u64(acc64, 0) + vgetq_lane_u64(acc64, 1);
+    }
+#endif
+    for (; i < size; i++) {
+        sum += (pA[i] > pB[i]) ? (pA[i] - pB[i]) : (pB[i] - pA[i]);
+    }
+    return sum;
+}
+
+void VkEncoderPixelOps::SumAndSquares(const uint8_t* pData, size_t size, uint64_t& sum, uint64_t& sumSquares)
+{
+    size_t i = 0;
+#if defined(VK_PIXEL_OPS_USE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    while ((i + 16) <= size) {
+        // The 32-bit lanes hold up to 4096 iterations of two squares
+        __m128i accSum = _mm_setzero_si128();
+        __m128i accSquares = _mm_setzero_si128();
+        for (uint32_t n = 0; (n < 4096) && ((i + 16) <= size); n++, i += 16) {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(pData + i));
+            const __m128i lo = _mm_unpacklo_epi8(v, zero);
+            const __m128i hi = _mm_unpackhi_epi8(v, zero);
+            accSum = _mm_add_epi64(accSum, _mm_sad_epu8(v, zero));
+            accSquares = _mm_add_epi32(accSquares, _mm_madd_epi16(lo, lo));
+            accSquares = _mm_add_epi32(accSquares, _mm_madd_epi16(hi, hi));
+        }
+        sum += (uint64_t)_mm_cvtsi128_si32(accSum) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(accSum, 8));
+        uint32_t squares[4];
+        _mm_storeu_si128((__m128i*)squares, accSquares);
+        sumSquares += (uint64_t)squares[0] + squares[1] + squares[2] + squares[3];
+    }
+#elif defined(VK_PIXEL_OPS_USE_NEON)
+    while ((i + 16) <= size) {
+        uint16x8_t accSum = vdupq_n_u16(0);
+        uint32x4_t accSquares = vdupq_n_u32(0);
+        for (uint32_t n = 0; (n < 128) && ((i + 16) <= size); n++, i += 16) {
+            const uint8x16_t v = vld1q_u8(pData + i);
+            const uint16x8_t lo = vmull_u8(vget_low_u8(v), vget_low_u8(v));
+            const uint16x8_t hi = vmull_u8(vget_high_u8(v), vget_high_u8(v));
+            accSum = vpadalq_u8(accSum, v);
+            accSquares = vpadalq_u16(accSquares, lo);
+            accSquares = vpadalq_u16(accSquares, hi);
+        }
+        const uint64x2_t sum64 = vpaddlq_u32(vpaddlq_u16(accSum));
+        const uint64x2_t squares64 = vpaddlq_u32(accSquares);
+        sum += vgetq_lane_u64(sum64, 0) + vgetq_lane_u64(sum64, 1);
+        sumSquares += vgetq_lane_u64(squares64, 0) + vgetq_lane_u64(squares64, 1);
+    }
+#endif
+    for (; i < size; i++) {
+        sum += pData[i];
+        sumSquares += (uint32_t)pData[i] * pData[i];
+    }
+}
+
+void VkEncoderPixelOps::ConvertRowTo8Bit(const uint16_t* pSrc, uint32_t width, uint32_t shift, uint8_t* pDst)
+{
+    uint32_t x = 0;
+#if defined(VK_PIXEL_OPS_USE_SSE2)
+    const __m128i shiftCount = _mm_cvtsi32_si128((int)shift);
+    for (; (x + 16) <= width; x += 16) {
+        const __m128i lo = _mm_srl_epi16(_mm_loadu_si128((const __m128i*)(pSrc + x)), shiftCount);
+        const __m128i hi = _mm_srl_epi16(_mm_loadu_si128((const __m128i*)(pSrc + x + 8)), shiftCount);
+        _mm_storeu_si128((__m128i*)(pDst + x), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(VK_PIXEL_OPS_USE_NEON)
+    const int16x8_t shiftCount = vdupq_n_s16(-(int16_t)shift);
+    for (; (x + 8) <= width; x += 8) {
+        vst1_u8(pDst + x, vqmovn_u16(vshlq_u16(vld1q_u16(pSrc + x), shiftCount)));
+    }
+#endif
+    for (; x < width; x++) {
+        pDst[x] = (uint8_t)std::min<uint32_t>(pSrc[x] >> shift, 255U);
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEOENCODER_VKENCODERPIXELOPS_H_
+#define _VKVIDEOENCODER_VKENCODERPIXELOPS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// SIMD (SSE2 / NEON) sample statistics shared by the CPU analysis of the
+// encoder input: the lookahead and the QP map generator.
+class VkEncoderPixelOps {
+
+public:
+
+    // Sum of |pA[i] - pB[i]|.
+    static uint64_t SumAbsDiff(const uint8_t* pA, const uint8_t* pB, size_t size);
+
+    // Sum and sum of the squares of pData[i], added to sum and sumSquares.
+    static void SumAndSquares(const uint8_t* pData, size_t size, uint64_t& sum, uint64_t& sumSquares);
+
+    // Reduces the 16-bit container samples of the high bit depth inputs to 8 bits.
+    static void ConvertRowTo8Bit(const uint16_t* pSrc, uint32_t width, uint32_t shift, uint8_t* pDst);
+};
+
+#endif /* _VKVIDEOENCODER_VKENCODERPIXELOPS_H_ */
@@ -0,0 +1,610 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include "VkVideoEncoder/VkEncoderQpMapGenerator.h"
+#include "VkVideoEncoder/VkEncoderPixelOps.h"
+
+VkEncoderQpMapGenerator::VkEncoderQpMapGenerator()
+    : m_config()
+    , m_analyzedWidth(0)
+    , m_analyzedHeight(0)
+    , m_numBands(0)
+    , m_texelStats()
+    , m_workers()
+    , m_mutex()
+    , m_jobCondition()
+    , m_doneCondition()
+    , m_nextBand(0)
+    , m_pendingBands(0)
+    , m_pLuma(nullptr)
+    , m_pPrevLuma(nullptr)
+    , m_stats()
+    , m_enabled(false)
+    , m_exit(false)
+    , m_verbose(false)
+{
+}
+
+VkEncoderQpMapGenerator::~VkEncoderQpMapGenerator()
+{
+    Stop();
+}
+
+bool VkEncoderQpMapGenerator::Configure(const Config& config, bool verbose)
+{
+    Stop();
+    m_enabled = false;
+
+    if ((config.width == 0) || (config.height == 0) ||
+            (config.bytesPerSample < 1) || (config.bytesPerSample > 2) ||
+            (config.lumaPitch < (config.width * config.bytesPerSample))) {
+        fprintf(stderr, "QpMapGenerator: unsupported input %ux%u, %u byte(s) per sample, pitch %u\n",
+                config.width, config.height, config.bytesPerSample, config.lumaPitch);
+        return false;
+    }
+
+    if ((config.mapWidth == 0) || (config.mapHeight == 0) ||
+            (config.texelWidth == 0) || (config.texelHeight == 0)) {
+        fprintf(stderr, "QpMapGenerator: unsupported map %ux%u of %ux%u texels\n",
+                config.mapWidth, config.mapHeight, config.texelWidth, config.texelHeight);
+        return false;
+    }
+
+    const bool validTexelSize = (config.mapType == DELTA_QP_MAP) ?
+                                    ((config.bytesPerTexel == 1) || (config.bytesPerTexel == 2) || (config.bytesPerTexel == 4)) :
+                                    ((config.bytesPerTexel == 1) || (config.bytesPerTexel == 2));
+    if (!validTexelSize || (config.minDeltaQp > 0) || (config.maxDeltaQp < 0) ||
+            (config.minDeltaQp == config.maxDeltaQp) || (config.qpScale < 1) || (config.numRois > MAX_ROI_REGIONS)) {
+        fprintf(stderr, "QpMapGenerator: unsupported %u byte(s) texels, delta QP range [%d, %d] or %u ROI(s)\n",
+                config.bytesPerTexel, config.minDeltaQp, config.maxDeltaQp, config.numRois);
+        return false;
+    }
+
+    m_config = config;
+    m_verbose = verbose;
+    m_analyzedWidth  = std::min(config.mapWidth,  (config.width  + config.texelWidth  - 1) / config.texelWidth);
+    m_analyzedHeight = std::min(config.mapHeight, (config.height + config.texelHeight - 1) / config.texelHeight);
+    m_numBands = (m_analyzedHeight + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+    m_texelStats.assign((size_t)m_analyzedWidth * m_analyzedHeight, TexelStats());
+    m_nextBand = m_numBands;
+    m_pendingBands = 0;
+    m_stats = Stats();
+    m_exit = false;
+
+    if (m_config.numThreads == 0) {
+        m_config.numThreads = std::min(std::max(std::thread::hardware_concurrency(), 1U), 4U);
+    }
+    m_config.numThreads = std::min(m_config.numThreads, std::max(m_numBands, 1U));
+    for (uint32_t i = 0; i < m_config.numThreads; i++) {
+        m_workers.push_back(std::thread(&VkEncoderQpMapGenerator::WorkerThread, this));
+    }
+
+    if (m_verbose) {
+        printf("QpMapGenerator: %s map %ux%u of %ux%u texels, %u thread(s), activity strength %.2f, "
+               "static delta QP %d, %u ROI(s), delta QP range [%d, %d]\n",
+               (m_config.mapType == DELTA_QP_MAP) ? "delta QP" : "emphasis",
+               m_config.mapWidth, m_config.mapHeight, m_config.texelWidth, m_config.texelHeight,
+               m_config.numThreads, m_config.activityStrength, m_config.staticDeltaQp, m_config.numRois,
+               m_config.minDeltaQp, m_config.maxDeltaQp);
+    }
+
+    m_enabled = true;
+    return true;
+}
+
+void VkEncoderQpMapGenerator::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_jobCondition.notify_all();
+
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        if (m_workers[i].joinable()) {
+            m_workers[i].join();
+        }
+    }
+    m_workers.clear();
+}
+
+void VkEncoderQpMapGenerator::WorkerThread()
+{
+    std::vector<uint8_t> rowBuffer((m_config.bytesPerSample > 1) ? (2 * (size_t)m_config.width) : 0);
+    std::vector<uint64_t> accumulators(3 * (size_t)m_analyzedWidth);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_jobCondition.wait(lock, [this] { return m_exit || (m_nextBand < m_numBands); });
+        if (m_exit) {
+            break;
+        }
+
+        const uint32_t band = m_nextBand++;
+        lock.unlock();
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        AnalyzeBand(band, rowBuffer, accumulators);
+        const uint64_t timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        m_stats.workerTimeNs += timeNs;
+        assert(m_pendingBands > 0);
+        if (--m_pendingBands == 0) {
+            m_doneCondition.notify_all();
+        }
+    }
+}
+
+void VkEncoderQpMapGenerator::AnalyzeBand(uint32_t band, std::vector<uint8_t>& rowBuffer,
+                                          std::vector<uint64_t>& accumulators)
+{
+    const uint32_t width = m_config.width;
+    const bool analyzeStatic = (m_pPrevLuma != nullptr) && (m_config.staticDeltaQp != 0);
+    uint64_t* pSums = accumulators.data();
+    uint64_t* pSquares = pSums + m_analyzedWidth;
+    uint64_t* pSads = pSquares + m_analyzedWidth;
+
+    const uint32_t lastTexelRow = std::min((band + 1) * ROWS_PER_BAND, m_analyzedHeight);
+    for (uint32_t ty = band * ROWS_PER_BAND; ty < lastTexelRow; ty++) {
+
+        memset(pSums, 0, accumulators.size() * sizeof(uint64_t));
+
+        const uint32_t y0 = ty * m_config.texelHeight;
+        const uint32_t y1 = std::min(y0 + m_config.texelHeight, m_config.height);
+        for (uint32_t y = y0; y < y1; y++) {
+
+            const uint8_t* pRow = m_pLuma + ((size_t)y * m_config.lumaPitch);
+            const uint8_t* pPrevRow = analyzeStatic ? (m_pPrevLuma + ((size_t)y * m_config.lumaPitch)) : nullptr;
+            if (m_config.bytesPerSample > 1) {
+                VkEncoderPixelOps::ConvertRowTo8Bit((const uint16_t*)pRow, width, m_config.sampleShift, rowBuffer.data());
+                pRow = rowBuffer.data();
+                if (pPrevRow != nullptr) {
+                    VkEncoderPixelOps::ConvertRowTo8Bit((const uint16_t*)pPrevRow, width, m_config.sampleShift,
+                                                        rowBuffer.data() + width);
+                    pPrevRow = rowBuffer.data() + width;
+                }
+            }
+
+            for (uint32_t tx = 0; tx < m_analyzedWidth; tx++) {
+                const uint32_t x0 = tx * m_config.texelWidth;
+                const uint32_t numSamples = std::min(m_config.texelWidth, width - x0);
+                VkEncoderPixelOps::SumAndSquares(pRow + x0, numSamples, pSums[tx], pSquares[tx]);
+                if (pPrevRow != nullptr) {
+                    pSads[tx] += VkEncoderPixelOps::SumAbsDiff(pRow + x0, pPrevRow + x0, numSamples);
+                }
+            }
+        }
+
+        for (uint32_t tx = 0; tx < m_analyzedWidth; tx++) {
+            const uint32_t x0 = tx * m_config.texelWidth;
+            const double numSamples = (double)std::min(m_config.texelWidth, width - x0) * (y1 - y0);
+            const double mean = (double)pSums[tx] / numSamples;
+            const double variance = std::max(((double)pSquares[tx] / numSamples) - (mean * mean), 0.0);
+
+            // Each texel row belongs to a single band, read once all the bands are done
+            TexelStats& stats = m_texelStats[((size_t)ty * m_analyzedWidth) + tx];
+            stats.logVariance = (float)log2(variance + 1.0);
+            stats.isStatic = analyzeStatic && (((double)pSads[tx] / numSamples) < m_config.staticThreshold);
+        }
+    }
+}
+
+int32_t VkEncoderQpMapGenerator::GetRoiDeltaQp(uint32_t tx, uint32_t ty) const
+{
+    // A texel takes the delta QP of the last ROI overlapping it
+    const uint32_t x0 = tx * m_config.texelWidth;
+    const uint32_t y0 = ty * m_config.texelHeight;
+    const uint32_t x1 = x0 + m_config.texelWidth;
+    const uint32_t y1 = y0 + m_config.texelHeight;
+
+    int32_t deltaQp = 0;
+    for (uint32_t i = 0; i < m_config.numRois; i++) {
+        const Roi& roi = m_config.rois[i];
+        if ((x0 < (roi.x + roi.width)) && (roi.x < x1) && (y0 < (roi.y + roi.height)) && (roi.y < y1)) {
+            deltaQp = roi.deltaQp;
+        }
+    }
+    return deltaQp;
+}
+
+void VkEncoderQpMapGenerator::WriteTexel(uint8_t* pTexel, int32_t deltaQp) const
+{
+    if (m_config.mapType == DELTA_QP_MAP) {
+        if (m_config.bytesPerTexel == 1) {
+            *(int8_t*)pTexel = (int8_t)deltaQp;
+        } else if (m_config.bytesPerTexel == 2) {
+            const int16_t value = (int16_t)deltaQp;
+            memcpy(pTexel, &value, sizeof(value));
+        } else {
+            memcpy(pTexel, &deltaQp, sizeof(deltaQp));
+        }
+        return;
+    }
+
+    // Emphasis: 1.0 for the lowest delta QP, 0.5 for no change and 0.0 for the highest
+    const int32_t range = std::max(-m_config.minDeltaQp, m_config.maxDeltaQp);
+    const float emphasis = std::min(std::max(0.5f - ((float)deltaQp / (2.0f * range)), 0.0f), 1.0f);
+    if (m_config.bytesPerTexel == 1) {
+        *pTexel = (uint8_t)lroundf(emphasis * 255.0f);
+    } else {
+        const uint16_t value = (uint16_t)lroundf(emphasis * 65535.0f);
+        memcpy(pTexel, &value, sizeof(value));
+    }
+}
+
+bool VkEncoderQpMapGenerator::Generate(const uint8_t* pLuma, const uint8_t* pPrevLuma, uint8_t* pMap, size_t mapPitch)
+{
+    if (!m_enabled || (pLuma == nullptr) || (pMap == nullptr)) {
+        return false;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_pLuma = pLuma;
+        m_pPrevLuma = pPrevLuma;
+        m_pendingBands = m_numBands;
+        m_nextBand = 0;
+        m_jobCondition.notify_all();
+        m_doneCondition.wait(lock, [this] { return (m_pendingBands == 0); });
+        m_pLuma = nullptr;
+        m_pPrevLuma = nullptr;
+    }
+
+    // Activity relative to the frame, so the masking doesn't shift the average QP much
+    double sumLogVariance = 0.0;
+    for (size_t i = 0; i < m_texelStats.size(); i++) {
+        sumLogVariance += m_texelStats[i].logVariance;
+    }
+    const float meanLogVariance = m_texelStats.empty() ? 0.0f : (float)(sumLogVariance / m_texelStats.size());
+
+    for (uint32_t ty = 0; ty < m_config.mapHeight; ty++) {
+        uint8_t* pRow = pMap + (ty * mapPitch);
+        for (uint32_t tx = 0; tx < m_config.mapWidth; tx++) {
+
+            float deltaQp = 0.0f;
+            if ((tx < m_analyzedWidth) && (ty < m_analyzedHeight)) {
+                const TexelStats& stats = m_texelStats[((size_t)ty * m_analyzedWidth) + tx];
+                deltaQp = m_config.activityStrength * (stats.logVariance - meanLogVariance);
+                if (stats.isStatic) {
+                    deltaQp += (float)m_config.staticDeltaQp;
+                    m_stats.numStaticTexels++;
+                }
+            }
+            deltaQp += (float)GetRoiDeltaQp(tx, ty);
+
+            const int32_t scaledDeltaQp = std::min(std::max((int32_t)lroundf(deltaQp * m_config.qpScale),
+                                                            m_config.minDeltaQp),
+                                                   m_config.maxDeltaQp);
+            WriteTexel(pRow + ((size_t)tx * m_config.bytesPerTexel), scaledDeltaQp);
+            m_stats.sumDeltaQp += scaledDeltaQp;
+        }
+    }
+
+    m_stats.numTexels += (uint64_t)m_config.mapWidth * m_config.mapHeight;
+    m_stats.numFrames++;
+
+    return true;
+}
+
+void VkEncoderQpMapGenerator::PrintReport(FILE* fp) const
+{
+    if (m_stats.numFrames == 0) {
+        return;
+    }
+
+    const double numTexels = (double)m_stats.numTexels;
+    fprintf(fp, "QpMapGenerator: %llu frame(s), %.1f%% static texels, average delta QP %.2f, %.3f ms/frame of worker time\n",
+            (unsigned long long)m_stats.numFrames, (100.0 * m_stats.numStaticTexels) / numTexels,
+            (double)m_stats.sumDeltaQp / numTexels,
+            ((double)m_stats.workerTimeNs / 1000000.0) / m_stats.numFrames);
+}
+
+// Reads back a texel written by WriteTexel(): the delta QP, or the emphasis
+// in the units of the texel format.
+static int32_t ReadTexel(const uint8_t* pTexel, VkEncoderQpMapGenerator::MapType mapType, uint32_t bytesPerTexel)
+{
+    if (bytesPerTexel == 1) {
+        return (mapType == VkEncoderQpMapGenerator::DELTA_QP_MAP) ? *(const int8_t*)pTexel : *pTexel;
+    }
+    if (bytesPerTexel == 2) {
+        int16_t value16 = 0;
+        uint16_t valueU16 = 0;
+        memcpy(&value16, pTexel, sizeof(value16));
+        memcpy(&valueU16, pTexel, sizeof(valueU16));
+        return (mapType == VkEncoderQpMapGenerator::DELTA_QP_MAP) ? value16 : valueU16;
+    }
+    int32_t value = 0;
+    memcpy(&value, pTexel, sizeof(value));
+    return value;
+}
+
+// The synthetic luma of the self check: flat on the left of busyX and noisy
+// on its right. The 16-bit samples get random bits below sampleShift, which
+// the generator must drop.
+static void FillCheckFrame(std::vector<uint8_t>& luma, uint32_t width, uint32_t height, uint32_t pitch,
+                           uint32_t bytesPerSample, uint32_t sampleShift, uint32_t busyX, uint32_t& random)
+{
+    luma.assign((size_t)pitch * height, 0);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            random = (random * 1664525U) + 1013904223U;
+            const uint32_t value = (x < busyX) ? 100 : (40 + ((random >> 16) % 121));
+            if (bytesPerSample == 1) {
+                luma[((size_t)y * pitch) + x] = (uint8_t)value;
+            } else {
+                const uint16_t sample = (uint16_t)((value << sampleShift) | ((random >> 8) & ((1U << sampleShift) - 1)));
+                memcpy(&luma[((size_t)y * pitch) + (2 * x)], &sample, sizeof(sample));
+            }
+        }
+    }
+}
+
+// Configures a generator with config and returns the texels of the map of
+// pLuma, read back from a map with a padded pitch.
+static bool GenerateCheckMap(const VkEncoderQpMapGenerator::Config& config, const uint8_t* pLuma,
+                             const uint8_t* pPrevLuma, std::vector<int32_t>& texels, uint64_t* pNumStaticTexels)
+{
+    VkEncoderQpMapGenerator generator;
+    if (!generator.Configure(config, false)) {
+        return false;
+    }
+
+    const size_t mapPitch = ((size_t)config.mapWidth * config.bytesPerTexel) + 5;
+    std::vector<uint8_t> map(mapPitch * config.mapHeight, 0xcd);
+    if (!generator.Generate(pLuma, pPrevLuma, map.data(), mapPitch)) {
+        return false;
+    }
+
+    texels.resize((size_t)config.mapWidth * config.mapHeight);
+    for (uint32_t ty = 0; ty < config.mapHeight; ty++) {
+        for (uint32_t tx = 0; tx < config.mapWidth; tx++) {
+            texels[((size_t)ty * config.mapWidth) + tx] =
+                ReadTexel(&map[(ty * mapPitch) + ((size_t)tx * config.bytesPerTexel)], config.mapType, config.bytesPerTexel);
+        }
+        // The padding past the texels of the row
+        for (size_t i = (size_t)config.mapWidth * config.bytesPerTexel; i < mapPitch; i++) {
+            if (map[(ty * mapPitch) + i] != 0xcd) {
+                return false;
+            }
+        }
+    }
+    if (pNumStaticTexels != nullptr) {
+        *pNumStaticTexels = generator.GetStats().numStaticTexels;
+    }
+    return true;
+}
+
+bool VkEncoderQpMapGenerator::SelfCheck(bool verbose)
+{
+    // The second size leaves partial texels at the right and bottom edges,
+    // and both maps have a column and a row more than the frame covers.
+    static const uint32_t sizes[][2] = { { 256, 128 }, { 250, 70 } };
+    static const uint32_t texelSize = 16;
+    static const uint32_t busyX = 128;
+    // Changed in the previous frame: the samples left of changedX and below
+    // changedY, on texel boundaries.
+    static const uint32_t changedX = 96;
+    static const uint32_t changedY = 64;
+    static const Roi rois[] = {
+        { 16, 16, 64, 32, -4 },
+        { 72, 40, 40, 40,  3 },         // partially covers texels, and overlaps the first ROI
+        { 240, 0, 40, 16, -1 },         // extends past the frame
+    };
+
+    uint32_t numChecks = 0;
+    uint32_t numFailures = 0;
+    uint32_t random = 0x13579bdf;
+
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (uint32_t bytesPerSample = 1; bytesPerSample <= 2; bytesPerSample++) {
+            const uint32_t width = sizes[s][0];
+            const uint32_t height = sizes[s][1];
+            const uint32_t sampleShift = (bytesPerSample > 1) ? 2 : 0;
+            const uint32_t pitch = (width * bytesPerSample) + 24;
+            const uint32_t analyzedWidth = (width + texelSize - 1) / texelSize;
+            const uint32_t analyzedHeight = (height + texelSize - 1) / texelSize;
+
+            std::vector<uint8_t> luma;
+            FillCheckFrame(luma, width, height, pitch, bytesPerSample, sampleShift, busyX, random);
+            // The same 8-bit samples, with other bits below the shift, except
+            // in the changed corner
+            std::vector<uint8_t> prevLuma;
+            FillCheckFrame(prevLuma, width, height, pitch, bytesPerSample, sampleShift, busyX, random);
+            for (uint32_t y = 0; y < height; y++) {
+                for (uint32_t x = 0; x < width; x++) {
+                    const size_t offset = ((size_t)y * pitch) + ((size_t)x * bytesPerSample);
+                    if (bytesPerSample == 1) {
+                        prevLuma[offset] = (uint8_t)(luma[offset] + (((x < changedX) && (y >= changedY)) ? 5 : 0));
+                    } else {
+                        uint16_t sample = 0;
+                        uint16_t prevSample = 0;
+                        memcpy(&sample, &luma[offset], sizeof(sample));
+                        memcpy(&prevSample, &prevLuma[offset], sizeof(prevSample));
+                        prevSample = (uint16_t)(((sample >> sampleShift) + (((x < changedX) && (y >= changedY)) ? 5 : 0)) << sampleShift) |
+                                     (prevSample & ((1U << sampleShift) - 1));
+                        memcpy(&prevLuma[offset], &prevSample, sizeof(prevSample));
+                    }
+                }
+            }
+
+            Config base;
+            base.width = width;
+            base.height = height;
+            base.lumaPitch = pitch;
+            base.bytesPerSample = bytesPerSample;
+            base.sampleShift = sampleShift;
+            base.mapWidth = analyzedWidth + 1;
+            base.mapHeight = analyzedHeight + 1;
+            base.texelWidth = texelSize;
+            base.texelHeight = texelSize;
+            base.activityStrength = 0.0f;
+            base.staticDeltaQp = 0;
+            base.numThreads = 1;
+
+            char description[128];
+            std::vector<int32_t> texels;
+            std::vector<int32_t> threadedTexels;
+
+            for (uint32_t check = 0; check < 4; check++) {
+                Config config = base;
+                const uint8_t* pPrevLuma = nullptr;
+                const char* name = "";
+                switch (check) {
+                case 0:
+                    name = "activity masking";
+                    config.activityStrength = 1.0f;
+                    break;
+                case 1:
+                    name = "regions of interest";
+                    config.numRois = sizeof(rois) / sizeof(rois[0]);
+                    memcpy(config.rois, rois, sizeof(rois));
+                    break;
+                case 2:
+                    name = "static regions";
+                    config.staticDeltaQp = -2;
+                    pPrevLuma = prevLuma.data();
+                    break;
+                default:
+                    name = "clamping";
+                    config.activityStrength = 8.0f;
+                    config.qpScale = 4;
+                    config.minDeltaQp = -6;
+                    config.maxDeltaQp = 5;
+                    config.numRois = 1;
+                    config.rois[0].x = 0;
+                    config.rois[0].y = 0;
+                    config.rois[0].width = busyX;
+                    config.rois[0].height = base.mapHeight * texelSize;   // also the row past the frame
+                    config.rois[0].deltaQp = -100;
+                    break;
+                }
+
+                // The clamping is checked in every texel format, the other
+                // checks with the signed bytes.
+                const uint32_t numFormats = (check == 3) ? 5 : 1;
+                for (uint32_t format = 0; format < numFormats; format++) {
+                    static const uint32_t bytesPerTexel[] = { 1, 2, 4, 1, 2 };
+                    config.mapType = (format < 3) ? DELTA_QP_MAP : EMPHASIS_MAP;
+                    config.bytesPerTexel = bytesPerTexel[format];
+                    const int32_t maxEmphasis = (config.bytesPerTexel == 1) ? 255 : 65535;
+
+                    bool success = true;
+                    uint32_t numWrong = 0;
+                    uint64_t numStaticTexels = 0;
+                    Config threadedConfig = config;
+                    threadedConfig.numThreads = 3;
+                    success = GenerateCheckMap(config, luma.data(), pPrevLuma, texels, &numStaticTexels) &&
+                              GenerateCheckMap(threadedConfig, luma.data(), pPrevLuma, threadedTexels, nullptr) &&
+                              (texels == threadedTexels);
+
+                    uint32_t expectedStaticTexels = 0;
+                    for (uint32_t ty = 0; success && (ty < config.mapHeight); ty++) {
+                        for (uint32_t tx = 0; tx < config.mapWidth; tx++) {
+                            const int32_t value = texels[((size_t)ty * config.mapWidth) + tx];
+                            const bool analyzed = (tx < analyzedWidth) && (ty < analyzedHeight);
+                            const bool busy = (tx * texelSize) >= busyX;
+                            bool match = true;
+                            if (check == 0) {
+                                // Busier than the frame average: higher QP
+                                match = !analyzed ? (value == 0) : (busy ? (value > 0) : (value < 0));
+                            } else if (check == 1) {
+                                // The last ROI with a sample in the texel
+                                int32_t expected = 0;
+                                for (uint32_t i = 0; i < config.numRois; i++) {
+                                    for (uint32_t y = ty * texelSize; y < ((ty + 1) * texelSize); y++) {
+                                        for (uint32_t x = tx * texelSize; x < ((tx + 1) * texelSize); x++) {
+                                            if ((x >= rois[i].x) && (x < (rois[i].x + rois[i].width)) &&
+                                                    (y >= rois[i].y) && (y < (rois[i].y + rois[i].height))) {
+                                                expected = rois[i].deltaQp;
+                                            }
+                                        }
+                                    }
+                                }
+                                match = (value == expected);
+                            } else if (check == 2) {
+                                const bool changed = ((tx * texelSize) < changedX) && ((ty * texelSize) >= changedY);
+                                const bool isStatic = analyzed && !changed;
+                                expectedStaticTexels += isStatic ? 1 : 0;
+                                match = (value == (isStatic ? config.staticDeltaQp : 0));
+                            } else {
+                                // Flat texels under the ROI at the lowest delta QP,
+                                // busy ones at the highest, never outside the range
+                                int32_t expected = 0;
+                                if (!analyzed) {
+                                    expected = busy ? 0 : config.minDeltaQp;
+                                } else {
+                                    expected = busy ? config.maxDeltaQp : config.minDeltaQp;
+                                }
+                                if (config.mapType == EMPHASIS_MAP) {
+                                    const int32_t range = std::max(-config.minDeltaQp, config.maxDeltaQp);
+                                    const float emphasis = 0.5f - ((float)expected / (2.0f * range));
+                                    expected = (int32_t)lroundf(emphasis * maxEmphasis);
+                                    match = (value >= 0) && (value <= maxEmphasis);
+                                }
+                                match = match && (value == expected);
+                            }
+                            numWrong += match ? 0 : 1;
+                        }
+                    }
+                    if ((check == 2) && (numStaticTexels != expectedStaticTexels)) {
+                        numWrong++;
+                    }
+                    success = success && (numWrong == 0);
+
+                    snprintf(description, sizeof(description), "%s, %ux%u %u-bit, %s %u byte(s)", name, width, height,
+                             (bytesPerSample > 1) ? 16 : 8, (config.mapType == DELTA_QP_MAP) ? "delta QP" : "emphasis",
+                             config.bytesPerTexel);
+                    if (!success || verbose) {
+                        fprintf(success ? stdout : stderr, "QpMapGenerator: %s %s, %u wrong texel(s)\n",
+                                success ? "passed" : "FAILED", description, numWrong);
+                    }
+                    numFailures += success ? 0 : 1;
+                    numChecks++;
+                }
+
+                // No previous frame, or no static delta: no static texels
+                if (check == 2) {
+                    bool success = GenerateCheckMap(config, luma.data(), nullptr, texels, nullptr);
+                    for (size_t i = 0; success && (i < texels.size()); i++) {
+                        success = (texels[i] == 0);
+                    }
+                    config.staticDeltaQp = 0;
+                    success = success && GenerateCheckMap(config, luma.data(), prevLuma.data(), texels, nullptr);
+                    for (size_t i = 0; success && (i < texels.size()); i++) {
+                        success = (texels[i] == 0);
+                    }
+                    if (!success || verbose) {
+                        fprintf(success ? stdout : stderr, "QpMapGenerator: %s no static region without a previous frame or delta, %ux%u %u-bit\n",
+                                success ? "passed" : "FAILED", width, height, (bytesPerSample > 1) ? 16 : 8);
+                    }
+                    numFailures += success ? 0 : 1;
+                    numChecks++;
+                }
+            }
+        }
+    }
+
+    printf("QpMapGenerator: self check of %u configuration(s), %u failure(s)\n", numChecks, numFailures);
+
+    return (numFailures == 0);
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEOENCODER_VKENCODERQPMAPGENERATOR_H_
+#define _VKVIDEOENCODER_VKENCODERQPMAPGENERATOR_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Generates the delta QP or emphasis map of an input frame on the CPU, one
+// value per map texel of texelWidth x texelHeight luma samples:
+//  - Activity masking: the texels busier than the frame average get a higher
+//    QP, where the artifacts are masked, and the flat ones a lower QP.
+//  - Static regions: the texels that didn't change since the previous frame
+//    get a lower QP, as they are referenced by the next frames.
+//  - Regions of interest: caller-supplied rectangles with their own delta QP.
+// Worker threads compute the per-texel statistics; the map itself is written
+// by the calling thread, directly into the mapped QP map image.
+class VkEncoderQpMapGenerator {
+
+public:
+
+    enum MapType { DELTA_QP_MAP, EMPHASIS_MAP };
+    enum { MAX_ROI_REGIONS = 8 };
+    enum { DEFAULT_MAX_DELTA_QP = 8 };
+    enum { DEFAULT_STATIC_DELTA_QP = -2 };
+
+    struct Roi {
+        uint32_t x;                     // in luma samples
+        uint32_t y;
+        uint32_t width;
+        uint32_t height;
+        int32_t  deltaQp;               // < 0: better quality
+    };
+
+    struct Config {
+        uint32_t width;                 // of the analyzed luma
+        uint32_t height;
+        uint32_t lumaPitch;             // in bytes
+        uint32_t bytesPerSample;        // 1, or 2 for 16-bit luma, shifted to 8 bits before the statistics
+        uint32_t sampleShift;           // right shift of the 16-bit samples down to 8 bits
+        uint32_t mapWidth;              // in texels, can cover more than the analyzed luma
+        uint32_t mapHeight;
+        uint32_t texelWidth;            // luma samples per map texel
+        uint32_t texelHeight;
+        MapType  mapType;
+        uint32_t bytesPerTexel;         // signed integer deltas: 1, 2 or 4, UNORM emphasis: 1 or 2
+        float    activityStrength;      // QP steps per doubling of the texel variance, 0: no activity masking
+        int32_t  staticDeltaQp;         // added to the static texels, 0: no static region detection
+        float    staticThreshold;       // mean absolute difference to the previous frame of a static texel
+        int32_t  qpScale;               // codec QP units per QP step: 1 for H.264/H.265, 4 for the AV1 qindex
+        int32_t  minDeltaQp;            // in codec QP units, from the quantization map capabilities
+        int32_t  maxDeltaQp;
+        uint32_t numThreads;            // band workers, 0: up to 4 depending on the CPU, at most one per band
+        uint32_t numRois;
+        Roi      rois[MAX_ROI_REGIONS];
+
+        Config()
+        : width(0)
+        , height(0)
+        , lumaPitch(0)
+        , bytesPerSample(1)
+        , sampleShift(0)
+        , mapWidth(0)
+        , mapHeight(0)
+        , texelWidth(16)
+        , texelHeight(16)
+        , mapType(DELTA_QP_MAP)
+        , bytesPerTexel(1)
+        , activityStrength(1.0f)
+        , staticDeltaQp(DEFAULT_STATIC_DELTA_QP)
+        , staticThreshold(1.0f)
+        , qpScale(1)
+        , minDeltaQp(-DEFAULT_MAX_DELTA_QP)
+        , maxDeltaQp(DEFAULT_MAX_DELTA_QP)
+        , numThreads(0)
+        , numRois(0)
+        , rois() {}
+    };
+
+    struct Stats {
+        uint64_t numFrames;
+        uint64_t numTexels;
+        uint64_t numStaticTexels;
+        int64_t  sumDeltaQp;            // in codec QP units
+        uint64_t workerTimeNs;          // texel statistics of all the bands, not the map writing
+    };
+
+    VkEncoderQpMapGenerator();
+    ~VkEncoderQpMapGenerator();
+
+    bool Configure(const Config& config, bool verbose = false);
+    bool IsEnabled() const { return m_enabled; }
+    const Config& GetConfig() const { return m_config; }
+
+    // Writes the map of the frame pLuma to pMap, with mapPitch bytes between
+    // the texel rows. pPrevLuma is the previous input frame, nullptr if none.
+    bool Generate(const uint8_t* pLuma, const uint8_t* pPrevLuma, uint8_t* pMap, size_t mapPitch);
+
+    // Joins the band workers, Configure() starts new ones.
+    void Stop();
+
+    const Stats& GetStats() const { return m_stats; }
+    void PrintReport(FILE* fp = stdout) const;
+
+    // Generates the maps of synthetic frames, flat on the left and noisy on
+    // the right, 8 and 16-bit, with partial edge texels and a map wider than
+    // the frame, and checks the ROI deltas (the last overlapping ROI wins),
+    // the static region delta against a previous frame changed in one corner,
+    // the direction of the activity masking, the clamping to an asymmetric
+    // range in every texel format, and that several workers write the same
+    // map as one. Returns false if a texel differs from the expected value.
+    static bool SelfCheck(bool verbose = false);
+
+private:
+
+    // Texel rows of the analyzed luma handled by a worker at a time.
+    enum { ROWS_PER_BAND = 2 };
+
+    struct TexelStats {
+        float    logVariance;           // log2(variance + 1), in 8-bit sample units
+        uint32_t isStatic : 1;
+    };
+
+    void WorkerThread();
+    void AnalyzeBand(uint32_t band, std::vector<uint8_t>& rowBuffer, std::vector<uint64_t>& accumulators);
+    int32_t GetRoiDeltaQp(uint32_t tx, uint32_t ty) const;
+    void WriteTexel(uint8_t* pTexel, int32_t deltaQp) const;
+
+    Config                   m_config;
+    uint32_t                 m_analyzedWidth;   // texels fully or partially covered by the analyzed luma
+    uint32_t                 m_analyzedHeight;
+    uint32_t                 m_numBands;
+    std::vector<TexelStats>  m_texelStats;
+    std::vector<std::thread> m_workers;
+    std::mutex               m_mutex;
+    std::condition_variable  m_jobCondition;    // a frame was queued, or the generator stops
+    std::condition_variable  m_doneCondition;   // the workers finished the last band
+    uint32_t                 m_nextBand;
+    uint32_t                 m_pendingBands;
+    const uint8_t*           m_pLuma;
+    const uint8_t*           m_pPrevLuma;
+    Stats                    m_stats;
+    bool                     m_enabled;
+    bool                     m_exit;
+    bool                     m_verbose;
+};
+
+#endif /* _VKVIDEOENCODER_VKENCODERQPMAPGENERATOR_H_ */
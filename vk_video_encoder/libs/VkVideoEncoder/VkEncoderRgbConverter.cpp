@@ -0,0 +1,790 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include "VkVideoEncoder/VkEncoderRgbConverter.h"
+
+// Same selection as VkEncoderPixelOps: SSE2 and NEON are part of the x86-64
+// and AArch64 baselines.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define VK_RGB_CONVERTER_USE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define VK_RGB_CONVERTER_USE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+struct RgbFormatInfo {
+    const char* name;
+    uint32_t    bytesPerPixel;
+    uint32_t    componentBits;
+    uint32_t    shifts[3];          // of R, G and B in the little endian pixel
+};
+
+const RgbFormatInfo rgbFormatInfos[VkEncoderRgbConverter::RGB_FORMAT_COUNT] = {
+    { "none",    0, 0,  {  0,  0,  0 } },
+    { "rgba",    4, 8,  {  0,  8, 16 } },
+    { "bgra",    4, 8,  { 16,  8,  0 } },
+    { "rgb",     3, 8,  {  0,  8, 16 } },
+    { "bgr",     3, 8,  { 16,  8,  0 } },
+    { "rgb10a2", 4, 10, {  0, 10, 20 } },
+    { "bgr10a2", 4, 10, { 20, 10,  0 } },
+};
+
+inline void ReadPixel(const uint8_t* pPixel, const RgbFormatInfo& info, int32_t rgb[3])
+{
+    uint32_t value = (uint32_t)pPixel[0] | ((uint32_t)pPixel[1] << 8) | ((uint32_t)pPixel[2] << 16);
+    if (info.bytesPerPixel == 4) {
+        value |= ((uint32_t)pPixel[3] << 24);
+    }
+    const uint32_t mask = (1U << info.componentBits) - 1;
+    for (uint32_t i = 0; i < 3; i++) {
+        rgb[i] = (int32_t)((value >> info.shifts[i]) & mask);
+    }
+}
+
+inline uint32_t ReadSample(const uint8_t* pRow, size_t index, uint32_t bytesPerSample)
+{
+    if (bytesPerSample == 1) {
+        return pRow[index];
+    }
+    uint16_t value;
+    memcpy(&value, pRow + (2 * index), sizeof(value));
+    return value;
+}
+
+inline void WriteSample(uint8_t* pRow, size_t index, uint32_t bytesPerSample, uint32_t value)
+{
+    if (bytesPerSample == 1) {
+        pRow[index] = (uint8_t)value;
+    } else {
+        const uint16_t value16 = (uint16_t)value;
+        memcpy(pRow + (2 * index), &value16, sizeof(value16));
+    }
+}
+
+} // namespace
+
+VkEncoderRgbConverter::RgbFormat VkEncoderRgbConverter::GetRgbFormat(const char* name)
+{
+    for (uint32_t i = RGB_FORMAT_NONE + 1; i < RGB_FORMAT_COUNT; i++) {
+        if (strcmp(name, rgbFormatInfos[i].name) == 0) {
+            return (RgbFormat)i;
+        }
+    }
+    return RGB_FORMAT_NONE;
+}
+
+const char* VkEncoderRgbConverter::GetRgbFormatName(RgbFormat rgbFormat)
+{
+    return (rgbFormat < RGB_FORMAT_COUNT) ? rgbFormatInfos[rgbFormat].name : "unknown";
+}
+
+const char* VkEncoderRgbConverter::GetOutputFormatName(OutputFormat outputFormat)
+{
+    switch (outputFormat) {
+    case OUTPUT_NV12:
+        return "nv12";
+    case OUTPUT_P010:
+        return "p010";
+    case OUTPUT_I420:
+        return "i420";
+    case OUTPUT_I420_10BIT:
+        return "i420-10bit";
+    default:
+        break;
+    }
+    return "unknown";
+}
+
+uint32_t VkEncoderRgbConverter::GetBytesPerPixel(RgbFormat rgbFormat)
+{
+    return (rgbFormat < RGB_FORMAT_COUNT) ? rgbFormatInfos[rgbFormat].bytesPerPixel : 0;
+}
+
+uint32_t VkEncoderRgbConverter::GetComponentBits(RgbFormat rgbFormat)
+{
+    return (rgbFormat < RGB_FORMAT_COUNT) ? rgbFormatInfos[rgbFormat].componentBits : 0;
+}
+
+void VkEncoderRgbConverter::RowBuffers::Allocate(uint32_t width)
+{
+    // The SIMD loops read whole vectors past the last column, and the pair
+    // sums up to 16 samples of each row at a time.
+    const size_t size = ((width + 1 + 15) & ~(size_t)15) + 16;
+    for (uint32_t row = 0; row < 2; row++) {
+        for (uint32_t i = 0; i < 3; i++) {
+            rgb[row][i].assign(size, 0);
+        }
+    }
+    for (uint32_t i = 0; i < 3; i++) {
+        chromaSums[i].assign(size, 0);
+        out[i].assign(size, 0);
+    }
+}
+
+VkEncoderRgbConverter::VkEncoderRgbConverter()
+    : m_config()
+    , m_transform()
+    , m_yCoefs()
+    , m_cbCoefs()
+    , m_crCoefs()
+    , m_chromaWidth(0)
+    , m_chromaHeight(0)
+    , m_numBands(0)
+    , m_buffers()
+    , m_workers()
+    , m_mutex()
+    , m_jobCondition()
+    , m_doneCondition()
+    , m_nextBand(0)
+    , m_pendingBands(0)
+    , m_pSrc(nullptr)
+    , m_srcPitch(0)
+    , m_pDstPlanes()
+    , m_dstPitches()
+    , m_stats()
+    , m_enabled(false)
+    , m_exit(false)
+    , m_verbose(false)
+{
+}
+
+VkEncoderRgbConverter::~VkEncoderRgbConverter()
+{
+    Stop();
+}
+
+void VkEncoderRgbConverter::GetTransform(const Config& config, Transform& transform)
+{
+    const YcbcrPrimariesConstants primaries = GetYcbcrPrimariesConstants(config.colorStandard);
+    const YcbcrRangeConstants range = GetYcbcrRangeConstants(YcbcrLevelsDigital);
+    transform.kb = primaries.kb;
+    transform.kr = primaries.kr;
+    transform.cbMax = range.cbMax;
+    transform.crMax = range.crMax;
+
+    // BT.601/709/2020 quantization: limited range Y in [16, 235] and CbCr in
+    // [16, 240], scaled by 2^(n - 8), full range over all the code values.
+    const uint32_t bitDepth = GetOutputBitDepth(config.outputFormat);
+    const double scale = (double)(1U << (bitDepth - 8));
+    transform.maxValue = (1U << bitDepth) - 1;
+    if (config.fullRange) {
+        transform.yRange = (double)transform.maxValue;
+        transform.cRange = (double)transform.maxValue;
+        transform.yOffset = 0.0;
+    } else {
+        transform.yRange = 219.0 * scale;
+        transform.cRange = 224.0 * scale;
+        transform.yOffset = 16.0 * scale;
+    }
+    transform.cOffset = 128.0 * scale;
+    transform.inputMax = (double)((1U << GetComponentBits(config.rgbFormat)) - 1);
+}
+
+void VkEncoderRgbConverter::GetFixedPointCoefs(const float matrixRow[3], double range, double offset,
+                                               double inputScale, uint32_t maxValue, uint32_t msbShift,
+                                               FixedPointCoefs& fixedPoint)
+{
+    // Output code values per input code value, with as many fractional bits
+    // as the 16-bit coefficients allow.
+    double coefs[3];
+    double maxCoef = 0.0;
+    for (uint32_t i = 0; i < 3; i++) {
+        coefs[i] = range * matrixRow[i] * inputScale;
+        maxCoef = std::max(maxCoef, fabs(coefs[i]));
+    }
+
+    uint32_t shift = 15;
+    while ((shift > 0) && ((maxCoef * (double)(1U << shift)) > 32767.0)) {
+        shift--;
+    }
+
+    for (uint32_t i = 0; i < 3; i++) {
+        fixedPoint.c[i] = (int16_t)lround(coefs[i] * (double)(1U << shift));
+    }
+    fixedPoint.bias = (int32_t)lround(offset * (double)(1U << shift)) + ((shift > 0) ? (1 << (shift - 1)) : 0);
+    fixedPoint.shift = shift;
+    fixedPoint.maxValue = (int16_t)maxValue;
+    fixedPoint.msbShift = msbShift;
+}
+
+bool VkEncoderRgbConverter::Configure(const Config& config, bool verbose)
+{
+    Stop();
+    m_enabled = false;
+
+    if ((config.width == 0) || (config.height == 0) ||
+            (config.rgbFormat <= RGB_FORMAT_NONE) || (config.rgbFormat >= RGB_FORMAT_COUNT) ||
+            (config.outputFormat >= OUTPUT_FORMAT_COUNT)) {
+        fprintf(stderr, "RgbConverter: unsupported conversion of %ux%u from %s to %s\n",
+                config.width, config.height, GetRgbFormatName(config.rgbFormat),
+                GetOutputFormatName(config.outputFormat));
+        return false;
+    }
+
+    if ((config.colorStandard != YcbcrBtStandardBt709) && (config.colorStandard != YcbcrBtStandardBt601Ebu) &&
+            (config.colorStandard != YcbcrBtStandardBt601Smtpe) && (config.colorStandard != YcbcrBtStandardBt2020)) {
+        fprintf(stderr, "RgbConverter: unsupported color standard %d\n", config.colorStandard);
+        return false;
+    }
+
+    m_config = config;
+    m_verbose = verbose;
+    GetTransform(m_config, m_transform);
+
+    float matrix[9];
+    YcbcrBtMatrix btMatrix(m_transform.kb, m_transform.kr, m_transform.cbMax, m_transform.crMax);
+    btMatrix.GetRgbToYcbcrMatrix(matrix, 9);
+
+    const uint32_t msbShift = (m_config.outputFormat == OUTPUT_P010) ? 6 : 0;
+    // The chroma is computed from the sums of 2x2 samples.
+    GetFixedPointCoefs(&matrix[0], m_transform.yRange, m_transform.yOffset, 1.0 / m_transform.inputMax,
+                       m_transform.maxValue, msbShift, m_yCoefs);
+    GetFixedPointCoefs(&matrix[3], m_transform.cRange, m_transform.cOffset, 0.25 / m_transform.inputMax,
+                       m_transform.maxValue, msbShift, m_cbCoefs);
+    GetFixedPointCoefs(&matrix[6], m_transform.cRange, m_transform.cOffset, 0.25 / m_transform.inputMax,
+                       m_transform.maxValue, msbShift, m_crCoefs);
+
+    m_chromaWidth  = (m_config.width  + 1) / 2;
+    m_chromaHeight = (m_config.height + 1) / 2;
+    m_numBands = (m_config.height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+    m_nextBand = m_numBands;
+    m_pendingBands = 0;
+    m_stats = Stats();
+    m_exit = false;
+
+    if (m_config.numThreads == 0) {
+        m_config.numThreads = std::min(std::max(std::thread::hardware_concurrency(), 1U), 4U);
+    }
+    m_config.numThreads = std::min(m_config.numThreads, m_numBands);
+    if (m_config.numThreads > 1) {
+        for (uint32_t i = 0; i < m_config.numThreads; i++) {
+            m_workers.push_back(std::thread(&VkEncoderRgbConverter::WorkerThread, this));
+        }
+    } else {
+        m_buffers.Allocate(m_config.width);
+    }
+
+    if (m_verbose) {
+        printf("RgbConverter: %ux%u %s to %s, %s %s range, %u thread(s), "
+               "fixed point Y (%d, %d, %d) >> %u, Cb (%d, %d, %d) >> %u, Cr (%d, %d, %d) >> %u\n",
+               m_config.width, m_config.height, GetRgbFormatName(m_config.rgbFormat),
+               GetOutputFormatName(m_config.outputFormat),
+               (m_config.colorStandard == YcbcrBtStandardBt709) ? "BT.709" :
+               (m_config.colorStandard == YcbcrBtStandardBt2020) ? "BT.2020" : "BT.601",
+               m_config.fullRange ? "full" : "limited", m_config.numThreads,
+               m_yCoefs.c[0], m_yCoefs.c[1], m_yCoefs.c[2], m_yCoefs.shift,
+               m_cbCoefs.c[0], m_cbCoefs.c[1], m_cbCoefs.c[2], m_cbCoefs.shift,
+               m_crCoefs.c[0], m_crCoefs.c[1], m_crCoefs.c[2], m_crCoefs.shift);
+    }
+
+    m_enabled = true;
+    return true;
+}
+
+void VkEncoderRgbConverter::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_jobCondition.notify_all();
+
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        if (m_workers[i].joinable()) {
+            m_workers[i].join();
+        }
+    }
+    m_workers.clear();
+}
+
+void VkEncoderRgbConverter::WorkerThread()
+{
+    RowBuffers buffers;
+    buffers.Allocate(m_config.width);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_jobCondition.wait(lock, [this] { return m_exit || (m_nextBand < m_numBands); });
+        if (m_exit) {
+            break;
+        }
+
+        const uint32_t band = m_nextBand++;
+        lock.unlock();
+
+        ConvertBand(band, buffers);
+
+        lock.lock();
+        assert(m_pendingBands > 0);
+        if (--m_pendingBands == 0) {
+            m_doneCondition.notify_all();
+        }
+    }
+}
+
+void VkEncoderRgbConverter::ComputeSamples(const int16_t* pA, const int16_t* pB, const int16_t* pC,
+                                           const FixedPointCoefs& coefs, uint32_t count, int16_t* pOut)
+{
+    uint32_t i = 0;
+#if defined(VK_RGB_CONVERTER_USE_SSE2)
+    // (a, b) pairs times (c0, c1), plus (c, 0) pairs times (c2, 0), in 32 bits
+    const __m128i coefs01 = _mm_set1_epi32((int32_t)((uint32_t)(uint16_t)coefs.c[0] |
+                                                     ((uint32_t)(uint16_t)coefs.c[1] << 16)));
+    const __m128i coefs2 = _mm_set1_epi32((int32_t)(uint32_t)(uint16_t)coefs.c[2]);
+    const __m128i bias = _mm_set1_epi32(coefs.bias);
+    const __m128i shift = _mm_cvtsi32_si128((int32_t)coefs.shift);
+    const __m128i msbShift = _mm_cvtsi32_si128((int32_t)coefs.msbShift);
+    const __m128i maxValue = _mm_set1_epi16(coefs.maxValue);
+    const __m128i zero = _mm_setzero_si128();
+    for (; (i + 8) <= count; i += 8) {
+        const __m128i a = _mm_loadu_si128((const __m128i*)(pA + i));
+        const __m128i b = _mm_loadu_si128((const __m128i*)(pB + i));
+        const __m128i c = _mm_loadu_si128((const __m128i*)(pC + i));
+        __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), coefs01),
+                                   _mm_madd_epi16(_mm_unpacklo_epi16(c, zero), coefs2));
+        __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), coefs01),
+                                   _mm_madd_epi16(_mm_unpackhi_epi16(c, zero), coefs2));
+        lo = _mm_sra_epi32(_mm_add_epi32(lo, bias), shift);
+        hi = _mm_sra_epi32(_mm_add_epi32(hi, bias), shift);
+        __m128i value = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(lo, hi), zero), maxValue);
+        value = _mm_sll_epi16(value, msbShift);
+        _mm_storeu_si128((__m128i*)(pOut + i), value);
+    }
+#elif defined(VK_RGB_CONVERTER_USE_NEON)
+    const int32x4_t bias = vdupq_n_s32(coefs.bias);
+    const int32x4_t shift = vdupq_n_s32(-(int32_t)coefs.shift);
+    const int16x8_t msbShift = vdupq_n_s16((int16_t)coefs.msbShift);
+    const int16x8_t maxValue = vdupq_n_s16(coefs.maxValue);
+    const int16x8_t zero = vdupq_n_s16(0);
+    for (; (i + 8) <= count; i += 8) {
+        const int16x8_t a = vld1q_s16(pA + i);
+        const int16x8_t b = vld1q_s16(pB + i);
+        const int16x8_t c = vld1q_s16(pC + i);
+        int32x4_t lo = vmlal_n_s16(bias, vget_low_s16(a), coefs.c[0]);
+        int32x4_t hi = vmlal_n_s16(bias, vget_high_s16(a), coefs.c[0]);
+        lo = vmlal_n_s16(lo, vget_low_s16(b), coefs.c[1]);
+        hi = vmlal_n_s16(hi, vget_high_s16(b), coefs.c[1]);
+        lo = vmlal_n_s16(lo, vget_low_s16(c), coefs.c[2]);
+        hi = vmlal_n_s16(hi, vget_high_s16(c), coefs.c[2]);
+        int16x8_t value = vcombine_s16(vqmovn_s32(vshlq_s32(lo, shift)), vqmovn_s32(vshlq_s32(hi, shift)));
+        value = vminq_s16(vmaxq_s16(value, zero), maxValue);
+        vst1q_s16(pOut + i, vshlq_s16(value, msbShift));
+    }
+#endif
+    for (; i < count; i++) {
+        int32_t value = (coefs.c[0] * pA[i]) + (coefs.c[1] * pB[i]) + (coefs.c[2] * pC[i]) + coefs.bias;
+        value = std::min(std::max(value >> coefs.shift, 0), (int32_t)coefs.maxValue);
+        pOut[i] = (int16_t)(uint16_t)(value << coefs.msbShift);
+    }
+}
+
+void VkEncoderRgbConverter::SumPairs(const int16_t* pRow0, const int16_t* pRow1, uint32_t count, int16_t* pSums)
+{
+    uint32_t i = 0;
+#if defined(VK_RGB_CONVERTER_USE_SSE2)
+    const __m128i ones = _mm_set1_epi16(1);
+    for (; (i + 8) <= count; i += 8) {
+        const __m128i lo = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(pRow0 + (2 * i))),
+                                         _mm_loadu_si128((const __m128i*)(pRow1 + (2 * i))));
+        const __m128i hi = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(pRow0 + (2 * i) + 8)),
+                                         _mm_loadu_si128((const __m128i*)(pRow1 + (2 * i) + 8)));
+        _mm_storeu_si128((__m128i*)(pSums + i),
+                         _mm_packs_epi32(_mm_madd_epi16(lo, ones), _mm_madd_epi16(hi, ones)));
+    }
+#elif defined(VK_RGB_CONVERTER_USE_NEON)
+    for (; (i + 8) <= count; i += 8) {
+        const int16x8_t lo = vaddq_s16(vld1q_s16(pRow0 + (2 * i)), vld1q_s16(pRow1 + (2 * i)));
+        const int16x8_t hi = vaddq_s16(vld1q_s16(pRow0 + (2 * i) + 8), vld1q_s16(pRow1 + (2 * i) + 8));
+        vst1q_s16(pSums + i, vcombine_s16(vmovn_s32(vpaddlq_s16(lo)), vmovn_s32(vpaddlq_s16(hi))));
+    }
+#endif
+    for (; i < count; i++) {
+        pSums[i] = (int16_t)(pRow0[2 * i] + pRow0[(2 * i) + 1] + pRow1[2 * i] + pRow1[(2 * i) + 1]);
+    }
+}
+
+void VkEncoderRgbConverter::UnpackRow(const uint8_t* pSrc, std::vector<int16_t>* rgb) const
+{
+    const RgbFormatInfo& info = rgbFormatInfos[m_config.rgbFormat];
+    int16_t* pR = rgb[0].data();
+    int16_t* pG = rgb[1].data();
+    int16_t* pB = rgb[2].data();
+
+    uint32_t x = 0;
+#if defined(VK_RGB_CONVERTER_USE_SSE2)
+    if (info.bytesPerPixel == 4) {
+        const __m128i mask = _mm_set1_epi32((1 << info.componentBits) - 1);
+        const __m128i shifts[3] = { _mm_cvtsi32_si128((int32_t)info.shifts[0]),
+                                    _mm_cvtsi32_si128((int32_t)info.shifts[1]),
+                                    _mm_cvtsi32_si128((int32_t)info.shifts[2]) };
+        int16_t* pDst[3] = { pR, pG, pB };
+        for (; (x + 8) <= m_config.width; x += 8) {
+            const __m128i lo = _mm_loadu_si128((const __m128i*)(pSrc + (4 * x)));
+            const __m128i hi = _mm_loadu_si128((const __m128i*)(pSrc + (4 * x) + 16));
+            for (uint32_t i = 0; i < 3; i++) {
+                _mm_storeu_si128((__m128i*)(pDst[i] + x),
+                                 _mm_packs_epi32(_mm_and_si128(_mm_srl_epi32(lo, shifts[i]), mask),
+                                                 _mm_and_si128(_mm_srl_epi32(hi, shifts[i]), mask)));
+            }
+        }
+    }
+#endif
+    for (; x < m_config.width; x++) {
+        int32_t pixel[3];
+        ReadPixel(pSrc + ((size_t)x * info.bytesPerPixel), info, pixel);
+        pR[x] = (int16_t)pixel[0];
+        pG[x] = (int16_t)pixel[1];
+        pB[x] = (int16_t)pixel[2];
+    }
+
+    // The last column is repeated for the chroma of the odd widths.
+    pR[m_config.width] = pR[m_config.width - 1];
+    pG[m_config.width] = pG[m_config.width - 1];
+    pB[m_config.width] = pB[m_config.width - 1];
+}
+
+void VkEncoderRgbConverter::StoreRow(const int16_t* pValues, uint32_t count, uint8_t* pDst) const
+{
+    if (GetOutputBitDepth(m_config.outputFormat) > 8) {
+        // Already in their 16-bit containers
+        memcpy(pDst, pValues, count * sizeof(int16_t));
+        return;
+    }
+
+    uint32_t i = 0;
+#if defined(VK_RGB_CONVERTER_USE_SSE2)
+    for (; (i + 16) <= count; i += 16) {
+        _mm_storeu_si128((__m128i*)(pDst + i), _mm_packus_epi16(_mm_loadu_si128((const __m128i*)(pValues + i)),
+                                                                 _mm_loadu_si128((const __m128i*)(pValues + i + 8))));
+    }
+#elif defined(VK_RGB_CONVERTER_USE_NEON)
+    for (; (i + 8) <= count; i += 8) {
+        vst1_u8(pDst + i, vqmovun_s16(vld1q_s16(pValues + i)));
+    }
+#endif
+    for (; i < count; i++) {
+        pDst[i] = (uint8_t)pValues[i];
+    }
+}
+
+void VkEncoderRgbConverter::StoreInterleavedRow(const int16_t* pCb, const int16_t* pCr, uint32_t count,
+                                                uint8_t* pDst) const
+{
+    const bool highBitDepth = (GetOutputBitDepth(m_config.outputFormat) > 8);
+
+    uint32_t i = 0;
+#if defined(VK_RGB_CONVERTER_USE_SSE2)
+    for (; (i + 8) <= count; i += 8) {
+        const __m128i cb = _mm_loadu_si128((const __m128i*)(pCb + i));
+        const __m128i cr = _mm_loadu_si128((const __m128i*)(pCr + i));
+        if (highBitDepth) {
+            _mm_storeu_si128((__m128i*)(pDst + (4 * i)), _mm_unpacklo_epi16(cb, cr));
+            _mm_storeu_si128((__m128i*)(pDst + (4 * i) + 16), _mm_unpackhi_epi16(cb, cr));
+        } else {
+            const __m128i packed = _mm_packus_epi16(cb, cr);
+            _mm_storeu_si128((__m128i*)(pDst + (2 * i)), _mm_unpacklo_epi8(packed, _mm_srli_si128(packed, 8)));
+        }
+    }
+#elif defined(VK_RGB_CONVERTER_USE_NEON)
+    for (; (i + 8) <= count; i += 8) {
+        if (highBitDepth) {
+            int16x8x2_t cbCr;
+            cbCr.val[0] = vld1q_s16(pCb + i);
+            cbCr.val[1] = vld1q_s16(pCr + i);
+            vst2q_s16((int16_t*)(pDst + (4 * i)), cbCr);
+        } else {
+            uint8x8x2_t cbCr;
+            cbCr.val[0] = vqmovun_s16(vld1q_s16(pCb + i));
+            cbCr.val[1] = vqmovun_s16(vld1q_s16(pCr + i));
+            vst2_u8(pDst + (2 * i), cbCr);
+        }
+    }
+#endif
+    const uint32_t bytesPerSample = highBitDepth ? 2 : 1;
+    for (; i < count; i++) {
+        WriteSample(pDst, 2 * i, bytesPerSample, (uint16_t)pCb[i]);
+        WriteSample(pDst, (2 * i) + 1, bytesPerSample, (uint16_t)pCr[i]);
+    }
+}
+
+void VkEncoderRgbConverter::ConvertBand(uint32_t band, RowBuffers& buffers)
+{
+    const uint32_t firstRow = band * ROWS_PER_BAND;
+    const uint32_t endRow = std::min(firstRow + ROWS_PER_BAND, m_config.height);
+    const uint32_t width = m_config.width;
+
+    for (uint32_t y = firstRow; y < endRow; y += 2) {
+        // The last row is repeated for the chroma of the odd heights.
+        const uint32_t numRows = std::min(endRow - y, 2U);
+        for (uint32_t row = 0; row < numRows; row++) {
+            UnpackRow(m_pSrc + ((y + row) * m_srcPitch), buffers.rgb[row]);
+            ComputeSamples(buffers.rgb[row][0].data(), buffers.rgb[row][1].data(), buffers.rgb[row][2].data(),
+                           m_yCoefs, width, buffers.out[0].data());
+            StoreRow(buffers.out[0].data(), width, m_pDstPlanes[0] + ((y + row) * m_dstPitches[0]));
+        }
+
+        const std::vector<int16_t>* pRow1 = buffers.rgb[numRows - 1];
+        for (uint32_t i = 0; i < 3; i++) {
+            SumPairs(buffers.rgb[0][i].data(), pRow1[i].data(), m_chromaWidth, buffers.chromaSums[i].data());
+        }
+        const int16_t* pSumR = buffers.chromaSums[0].data();
+        const int16_t* pSumG = buffers.chromaSums[1].data();
+        const int16_t* pSumB = buffers.chromaSums[2].data();
+        ComputeSamples(pSumR, pSumG, pSumB, m_cbCoefs, m_chromaWidth, buffers.out[1].data());
+        ComputeSamples(pSumR, pSumG, pSumB, m_crCoefs, m_chromaWidth, buffers.out[2].data());
+
+        const uint32_t chromaRow = y / 2;
+        if (GetOutputNumPlanes(m_config.outputFormat) == 2) {
+            StoreInterleavedRow(buffers.out[1].data(), buffers.out[2].data(), m_chromaWidth,
+                                m_pDstPlanes[1] + (chromaRow * m_dstPitches[1]));
+        } else {
+            StoreRow(buffers.out[1].data(), m_chromaWidth, m_pDstPlanes[1] + (chromaRow * m_dstPitches[1]));
+            StoreRow(buffers.out[2].data(), m_chromaWidth, m_pDstPlanes[2] + (chromaRow * m_dstPitches[2]));
+        }
+    }
+}
+
+bool VkEncoderRgbConverter::Convert(const uint8_t* pSrc, size_t srcPitch,
+                                    uint8_t* const pDstPlanes[3], const size_t dstPitches[3])
+{
+    const uint32_t numPlanes = GetOutputNumPlanes(m_config.outputFormat);
+    if (!m_enabled || (pSrc == nullptr) || (pDstPlanes[0] == nullptr) || (pDstPlanes[1] == nullptr) ||
+            ((numPlanes > 2) && (pDstPlanes[2] == nullptr)) ||
+            (srcPitch < ((size_t)m_config.width * GetBytesPerPixel(m_config.rgbFormat)))) {
+        return false;
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    m_pSrc = pSrc;
+    m_srcPitch = srcPitch;
+    for (uint32_t i = 0; i < 3; i++) {
+        m_pDstPlanes[i] = (i < numPlanes) ? pDstPlanes[i] : nullptr;
+        m_dstPitches[i] = (i < numPlanes) ? dstPitches[i] : 0;
+    }
+
+    if (m_workers.empty()) {
+        for (uint32_t band = 0; band < m_numBands; band++) {
+            ConvertBand(band, m_buffers);
+        }
+    } else {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_pendingBands = m_numBands;
+        m_nextBand = 0;
+        m_jobCondition.notify_all();
+        m_doneCondition.wait(lock, [this] { return (m_pendingBands == 0); });
+    }
+    m_pSrc = nullptr;
+
+    m_stats.numFrames++;
+    m_stats.convertTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool VkEncoderRgbConverter::ConvertReference(const uint8_t* pSrc, size_t srcPitch,
+                                             uint8_t* const pDstPlanes[3], const size_t dstPitches[3]) const
+{
+    if (!m_enabled || (pSrc == nullptr)) {
+        return false;
+    }
+
+    const RgbFormatInfo& info = rgbFormatInfos[m_config.rgbFormat];
+    const YcbcrBtMatrix btMatrix(m_transform.kb, m_transform.kr, m_transform.cbMax, m_transform.crMax);
+    const uint32_t bytesPerSample = (GetOutputBitDepth(m_config.outputFormat) > 8) ? 2 : 1;
+    const uint32_t msbShift = m_yCoefs.msbShift;
+    const bool interleaved = (GetOutputNumPlanes(m_config.outputFormat) == 2);
+
+    for (uint32_t cy = 0; cy < m_chromaHeight; cy++) {
+        for (uint32_t cx = 0; cx < m_chromaWidth; cx++) {
+            float average[3] = { 0.0f, 0.0f, 0.0f };
+            for (uint32_t j = 0; j < 2; j++) {
+                const uint32_t y = std::min((2 * cy) + j, m_config.height - 1);
+                for (uint32_t i = 0; i < 2; i++) {
+                    const uint32_t x = std::min((2 * cx) + i, m_config.width - 1);
+                    int32_t pixel[3];
+                    ReadPixel(pSrc + (y * srcPitch) + ((size_t)x * info.bytesPerPixel), info, pixel);
+                    float rgb[3];
+                    for (uint32_t c = 0; c < 3; c++) {
+                        rgb[c] = (float)(pixel[c] / m_transform.inputMax);
+                        average[c] += 0.25f * rgb[c];
+                    }
+
+                    // Luma of each of the pixels of the 2x2 block
+                    if ((((2 * cy) + j) == y) && (((2 * cx) + i) == x)) {
+                        float ycbcr[3];
+                        btMatrix.ConvertRgbToYcbcr(ycbcr, rgb);
+                        const double value = floor(m_transform.yOffset + (m_transform.yRange * ycbcr[0]) + 0.5);
+                        const uint32_t sample = (uint32_t)std::min(std::max(value, 0.0), (double)m_transform.maxValue);
+                        WriteSample(pDstPlanes[0] + (y * dstPitches[0]), x, bytesPerSample, sample << msbShift);
+                    }
+                }
+            }
+
+            float ycbcr[3];
+            btMatrix.ConvertRgbToYcbcr(ycbcr, average);
+            uint32_t chroma[2];
+            for (uint32_t c = 0; c < 2; c++) {
+                const double value = floor(m_transform.cOffset + (m_transform.cRange * ycbcr[1 + c]) + 0.5);
+                chroma[c] = (uint32_t)std::min(std::max(value, 0.0), (double)m_transform.maxValue) << msbShift;
+            }
+            if (interleaved) {
+                uint8_t* pRow = pDstPlanes[1] + (cy * dstPitches[1]);
+                WriteSample(pRow, 2 * cx, bytesPerSample, chroma[0]);
+                WriteSample(pRow, (2 * cx) + 1, bytesPerSample, chroma[1]);
+            } else {
+                WriteSample(pDstPlanes[1] + (cy * dstPitches[1]), cx, bytesPerSample, chroma[0]);
+                WriteSample(pDstPlanes[2] + (cy * dstPitches[2]), cx, bytesPerSample, chroma[1]);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool VkEncoderRgbConverter::SelfCheck(bool verbose)
+{
+    static const uint32_t sizes[][2] = { { 64, 32 }, { 67, 37 }, { 133, 70 } };
+    static const YcbcrBtStandard standards[] = { YcbcrBtStandardBt601Ebu, YcbcrBtStandardBt709, YcbcrBtStandardBt2020 };
+
+    uint32_t numConfigs = 0;
+    uint32_t numFailures = 0;
+    uint32_t maxDiff = 0;
+    uint64_t numSamples = 0;
+    uint64_t numDiffSamples = 0;
+    uint32_t random = 0x12345678;
+
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const uint32_t width = sizes[s][0];
+        const uint32_t height = sizes[s][1];
+        for (uint32_t f = RGB_FORMAT_NONE + 1; f < RGB_FORMAT_COUNT; f++) {
+            const size_t srcPitch = ((size_t)width * GetBytesPerPixel((RgbFormat)f)) + 12;
+            std::vector<uint8_t> src(srcPitch * height);
+            for (size_t i = 0; i < src.size(); i++) {
+                random = (random * 1664525U) + 1013904223U;
+                src[i] = (uint8_t)(random >> 24);
+            }
+            // Black and white rows for the clamping
+            memset(&src[0], 0x00, srcPitch);
+            memset(&src[srcPitch], 0xff, srcPitch);
+
+            for (uint32_t o = 0; o < OUTPUT_FORMAT_COUNT; o++) {
+                for (uint32_t b = 0; b < sizeof(standards) / sizeof(standards[0]); b++) {
+                    for (uint32_t r = 0; r < 2; r++) {
+                        Config config;
+                        config.width = width;
+                        config.height = height;
+                        config.rgbFormat = (RgbFormat)f;
+                        config.outputFormat = (OutputFormat)o;
+                        config.colorStandard = standards[b];
+                        config.fullRange = (r != 0);
+
+                        const uint32_t bytesPerSample = (GetOutputBitDepth(config.outputFormat) > 8) ? 2 : 1;
+                        const uint32_t numPlanes = GetOutputNumPlanes(config.outputFormat);
+                        const uint32_t chromaWidth = (width + 1) / 2;
+                        const uint32_t chromaHeight = (height + 1) / 2;
+                        const size_t pitches[3] = { (size_t)width * bytesPerSample,
+                                                    (size_t)chromaWidth * bytesPerSample * ((numPlanes == 2) ? 2 : 1),
+                                                    (size_t)chromaWidth * bytesPerSample };
+                        const size_t planeSizes[3] = { pitches[0] * height, pitches[1] * chromaHeight,
+                                                       (numPlanes > 2) ? (pitches[2] * chromaHeight) : 0 };
+
+                        // With the calling thread, with worker threads, and the reference
+                        std::vector<uint8_t> planes[3][3];
+                        bool success = true;
+                        for (uint32_t run = 0; run < 3; run++) {
+                            uint8_t* pPlanes[3];
+                            for (uint32_t p = 0; p < 3; p++) {
+                                planes[run][p].assign(planeSizes[p] + 1, 0xcd);
+                                pPlanes[p] = planes[run][p].data();
+                            }
+                            VkEncoderRgbConverter converter;
+                            config.numThreads = (run == 1) ? 3 : 1;
+                            success = success && converter.Configure(config, false);
+                            if (run < 2) {
+                                success = success && converter.Convert(src.data(), srcPitch, pPlanes, pitches);
+                            } else {
+                                success = success && converter.ConvertReference(src.data(), srcPitch, pPlanes, pitches);
+                            }
+                        }
+
+                        for (uint32_t p = 0; p < numPlanes; p++) {
+                            success = success && (planes[0][p] == planes[1][p]);
+                        }
+
+                        const uint32_t msbShift = (config.outputFormat == OUTPUT_P010) ? 6 : 0;
+                        uint32_t configMaxDiff = 0;
+                        for (uint32_t p = 0; p < numPlanes; p++) {
+                            const size_t numPlaneSamples = planeSizes[p] / bytesPerSample;
+                            for (size_t i = 0; i < numPlaneSamples; i++) {
+                                const uint32_t value = ReadSample(planes[0][p].data(), i, bytesPerSample) >> msbShift;
+                                const uint32_t reference = ReadSample(planes[2][p].data(), i, bytesPerSample) >> msbShift;
+                                const uint32_t diff = (value > reference) ? (value - reference) : (reference - value);
+                                configMaxDiff = std::max(configMaxDiff, diff);
+                                numDiffSamples += (diff != 0) ? 1 : 0;
+                            }
+                            numSamples += numPlaneSamples;
+                            // The guard byte past the plane
+                            success = success && (planes[0][p][planeSizes[p]] == 0xcd);
+                        }
+
+                        success = success && (configMaxDiff <= 1);
+                        if (!success || verbose) {
+                            fprintf(success ? stdout : stderr,
+                                    "RgbConverter: %s %ux%u %s to %s, %s %s range, max difference %u\n",
+                                    success ? "passed" : "FAILED", width, height, GetRgbFormatName(config.rgbFormat),
+                                    GetOutputFormatName(config.outputFormat),
+                                    (config.colorStandard == YcbcrBtStandardBt709) ? "BT.709" :
+                                    (config.colorStandard == YcbcrBtStandardBt2020) ? "BT.2020" : "BT.601",
+                                    config.fullRange ? "full" : "limited", configMaxDiff);
+                        }
+                        maxDiff = std::max(maxDiff, configMaxDiff);
+                        numFailures += success ? 0 : 1;
+                        numConfigs++;
+                    }
+                }
+            }
+        }
+    }
+
+    printf("RgbConverter: self check of %u configuration(s), %u failure(s), max difference %u, "
+           "%llu of %llu samples differ from the reference\n",
+           numConfigs, numFailures, maxDiff, (unsigned long long)numDiffSamples, (unsigned long long)numSamples);
+
+    return (numFailures == 0);
+}
+
+void VkEncoderRgbConverter::PrintReport(FILE* fp) const
+{
+    if (m_stats.numFrames == 0) {
+        return;
+    }
+
+    const double msPerFrame = ((double)m_stats.convertTimeNs / 1e6) / (double)m_stats.numFrames;
+    const double pixelsPerFrame = (double)m_config.width * m_config.height;
+    fprintf(fp, "RgbConverter: %llu frame(s) %s to %s, %u thread(s), %.3f ms per frame, %.1f Mpixel/s\n",
+            (unsigned long long)m_stats.numFrames, GetRgbFormatName(m_config.rgbFormat),
+            GetOutputFormatName(m_config.outputFormat), m_config.numThreads, msPerFrame,
+            (msPerFrame > 0.0) ? (pixelsPerFrame / (msPerFrame * 1e3)) : 0.0);
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEOENCODER_VKENCODERRGBCONVERTER_H_
+#define _VKVIDEOENCODER_VKENCODERRGBCONVERTER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "nvidia_utils/vulkan/ycbcr_utils.h"
+
+// Converts packed RGB input frames to 4:2:0 YCbCr on the CPU, for the inputs
+// the encoder can't read as YUV. The coefficients come from YcbcrBtMatrix and
+// are applied in fixed point by SIMD (SSE2 / NEON) kernels:
+//  - The luma of every pixel, and the chroma of the 2x2 average of the RGB
+//    samples, with the last column or row repeated for the odd sizes.
+//  - BT.601, BT.709 or BT.2020 matrices, in full or limited (video) range.
+//  - 8-bit NV12 and I420, and 10-bit P010 (MSB aligned) and I420 (LSB
+//    aligned) outputs.
+// The results are within one code value of the floating point reference,
+// ConvertReference(), which SelfCheck() verifies. The frame is split in
+// bands of rows that the worker threads convert in parallel.
+class VkEncoderRgbConverter {
+
+public:
+
+    enum RgbFormat {
+        RGB_FORMAT_NONE = 0,
+        RGB_FORMAT_RGBA8,               // R, G, B, A bytes
+        RGB_FORMAT_BGRA8,               // B, G, R, A bytes
+        RGB_FORMAT_RGB8,                // R, G, B bytes
+        RGB_FORMAT_BGR8,                // B, G, R bytes
+        RGB_FORMAT_RGB10A2,             // 32-bit words with R in bits 0-9, G 10-19, B 20-29 (A2B10G10R10)
+        RGB_FORMAT_BGR10A2,             // 32-bit words with B in bits 0-9, G 10-19, R 20-29 (A2R10G10B10)
+        RGB_FORMAT_COUNT
+    };
+
+    enum OutputFormat {
+        OUTPUT_NV12 = 0,                // 8-bit Y plane and interleaved CbCr plane
+        OUTPUT_P010,                    // 16-bit NV12 with the 10-bit samples in the MSBs
+        OUTPUT_I420,                    // 8-bit Y, Cb and Cr planes
+        OUTPUT_I420_10BIT,              // 16-bit I420 with the 10-bit samples in the LSBs
+        OUTPUT_FORMAT_COUNT
+    };
+
+    struct Config {
+        uint32_t        width;
+        uint32_t        height;
+        RgbFormat       rgbFormat;
+        OutputFormat    outputFormat;
+        YcbcrBtStandard colorStandard;  // YcbcrBtStandardBt601Ebu for BT.601
+        bool            fullRange;      // otherwise the limited (video) range
+        uint32_t        numThreads;     // 0: up to 4, depending on the CPU, 1: the calling thread only
+
+        Config()
+        : width(0)
+        , height(0)
+        , rgbFormat(RGB_FORMAT_NONE)
+        , outputFormat(OUTPUT_NV12)
+        , colorStandard(YcbcrBtStandardBt709)
+        , fullRange(false)
+        , numThreads(0) {}
+    };
+
+    struct Stats {
+        uint64_t numFrames;
+        uint64_t convertTimeNs;         // of the calls to Convert()
+    };
+
+    // Returns RGB_FORMAT_NONE if the name isn't one of rgba, bgra, rgb, bgr, rgb10a2 or bgr10a2.
+    static RgbFormat GetRgbFormat(const char* name);
+    static const char* GetRgbFormatName(RgbFormat rgbFormat);
+    static const char* GetOutputFormatName(OutputFormat outputFormat);
+    static uint32_t GetBytesPerPixel(RgbFormat rgbFormat);
+    static uint32_t GetComponentBits(RgbFormat rgbFormat);
+
+    static uint32_t GetOutputBitDepth(OutputFormat outputFormat)
+    {
+        return ((outputFormat == OUTPUT_P010) || (outputFormat == OUTPUT_I420_10BIT)) ? 10 : 8;
+    }
+
+    static uint32_t GetOutputNumPlanes(OutputFormat outputFormat)
+    {
+        return ((outputFormat == OUTPUT_NV12) || (outputFormat == OUTPUT_P010)) ? 2 : 3;
+    }
+
+    // Converts random frames of all the formats, matrices and ranges with the
+    // SIMD kernels, on one and several threads, and compares them with the
+    // floating point reference. Returns false if a sample differs by more
+    // than one code value or the threaded results differ.
+    static bool SelfCheck(bool verbose = false);
+
+    VkEncoderRgbConverter();
+    ~VkEncoderRgbConverter();
+
+    bool Configure(const Config& config, bool verbose = false);
+    bool IsEnabled() const { return m_enabled; }
+    const Config& GetConfig() const { return m_config; }
+
+    // Converts the frame pSrc, srcPitch bytes per row, to the Y and chroma
+    // planes pDstPlanes[] (two for NV12 and P010, three for I420) with
+    // dstPitches[] bytes per row.
+    bool Convert(const uint8_t* pSrc, size_t srcPitch, uint8_t* const pDstPlanes[3], const size_t dstPitches[3]);
+
+    // The same conversion in floating point, one sample at a time.
+    bool ConvertReference(const uint8_t* pSrc, size_t srcPitch,
+                          uint8_t* const pDstPlanes[3], const size_t dstPitches[3]) const;
+
+    // Joins the worker threads.
+    void Stop();
+
+    const Stats& GetStats() const { return m_stats; }
+    void PrintReport(FILE* fp = stdout) const;
+
+private:
+
+    // Rows converted by a worker at a time, even for the chroma subsampling.
+    enum { ROWS_PER_BAND = 16 };
+
+    // out = clamp((c[0] * a + c[1] * b + c[2] * c + bias) >> shift, 0, maxValue) << msbShift
+    struct FixedPointCoefs {
+        int16_t  c[3];
+        int32_t  bias;
+        uint32_t shift;
+        int16_t  maxValue;
+        uint32_t msbShift;
+    };
+
+    // The rows of a band, as 16-bit samples.
+    struct RowBuffers {
+        std::vector<int16_t> rgb[2][3];     // two rows of R, G and B, with the last column repeated
+        std::vector<int16_t> chromaSums[3]; // 2x2 sums of R, G and B
+        std::vector<int16_t> out[3];        // Y, Cb and Cr before the store
+
+        void Allocate(uint32_t width);
+    };
+
+    struct Transform {
+        float    kb;                    // of YcbcrBtMatrix
+        float    kr;
+        float    cbMax;
+        float    crMax;
+        double   yRange;                // output code values per unit of Y, Cb and Cr
+        double   cRange;
+        double   yOffset;
+        double   cOffset;
+        double   inputMax;              // of the RGB components
+        uint32_t maxValue;              // of the output samples
+    };
+
+    static void GetTransform(const Config& config, Transform& transform);
+    static void GetFixedPointCoefs(const float matrixRow[3], double range, double offset,
+                                   double inputScale, uint32_t maxValue, uint32_t msbShift,
+                                   FixedPointCoefs& fixedPoint);
+
+    void WorkerThread();
+    void ConvertBand(uint32_t band, RowBuffers& buffers);
+    void UnpackRow(const uint8_t* pSrc, std::vector<int16_t>* rgb) const;
+    void StoreRow(const int16_t* pValues, uint32_t count, uint8_t* pDst) const;
+    void StoreInterleavedRow(const int16_t* pCb, const int16_t* pCr, uint32_t count, uint8_t* pDst) const;
+
+    static void ComputeSamples(const int16_t* pA, const int16_t* pB, const int16_t* pC,
+                               const FixedPointCoefs& coefs, uint32_t count, int16_t* pOut);
+    static void SumPairs(const int16_t* pRow0, const int16_t* pRow1, uint32_t count, int16_t* pSums);
+
+    Config                   m_config;
+    Transform                m_transform;
+    FixedPointCoefs          m_yCoefs;
+    FixedPointCoefs          m_cbCoefs;
+    FixedPointCoefs          m_crCoefs;
+    uint32_t                 m_chromaWidth;
+    uint32_t                 m_chromaHeight;
+    uint32_t                 m_numBands;
+    RowBuffers               m_buffers;         // of the calling thread, without workers
+    std::vector<std::thread> m_workers;
+    std::mutex               m_mutex;
+    std::condition_variable  m_jobCondition;    // a frame was queued, or the converter stops
+    std::condition_variable  m_doneCondition;   // the workers finished the last band
+    uint32_t                 m_nextBand;
+    uint32_t                 m_pendingBands;
+    const uint8_t*           m_pSrc;
+    size_t                   m_srcPitch;
+    uint8_t*                 m_pDstPlanes[3];
+    size_t                   m_dstPitches[3];
+    Stats                    m_stats;
+    bool                     m_enabled;
+    bool                     m_exit;
+    bool                     m_verbose;
+};
+
+#endif /* _VKVIDEOENCODER_VKENCODERRGBCONVERTER_H_ */
@@ -0,0 +1,646 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "VkVideoEncoder/VkEncoderSyntheticSource.h"
+
+// Same selection as VkEncoderPixelOps: SSE2 and NEON are part of the x86-64
+// and AArch64 baselines.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define VK_SYNTHETIC_SOURCE_USE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define VK_SYNTHETIC_SOURCE_USE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+inline uint32_t Hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+inline uint32_t Hash(uint32_t a, uint64_t b)
+{
+    return Hash(a ^ Hash((uint32_t)b + 0x9e3779b9U) ^ Hash((uint32_t)(b >> 32) + 0x7f4a7c15U));
+}
+
+inline int64_t FloorDiv(int64_t a, int64_t b)
+{
+    return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+}
+
+// The xorshift32 generators of a row: 8 lanes, in two independent vectors
+// for a shorter dependency chain, give the 32 random bytes of a block of
+// pixels, lane k for the bytes 4k to 4k+3.
+enum { NOISE_LANES = 8 };
+enum { BLOCK_SIZE = 4 * NOISE_LANES };
+
+inline void InitNoiseState(uint32_t seed, uint32_t state[NOISE_LANES])
+{
+    for (uint32_t lane = 0; lane < NOISE_LANES; lane++) {
+        state[lane] = Hash(seed + lane) | 1;
+    }
+}
+
+// Segments of the text-like glyphs in their 8x16 cells: top, middle and
+// bottom bars, then the upper and lower left and right strokes.
+const struct {
+    uint32_t firstRow;
+    uint32_t lastRow;
+    uint8_t  columns;
+} glyphSegments[] = {
+    {  2,  3, 0x7e },
+    {  7,  8, 0x7e },
+    { 12, 13, 0x7e },
+    {  2,  8, 0x06 },
+    {  2,  8, 0x60 },
+    {  7, 13, 0x06 },
+    {  7, 13, 0x60 },
+};
+
+#if defined(VK_SYNTHETIC_SOURCE_USE_SSE2)
+inline __m128i NextRandom(__m128i random)
+{
+    random = _mm_xor_si128(random, _mm_slli_epi32(random, 13));
+    random = _mm_xor_si128(random, _mm_srli_epi32(random, 17));
+    return _mm_xor_si128(random, _mm_slli_epi32(random, 5));
+}
+
+// 16 samples from the 16-bit phases lo and hi, the mask and the random bytes.
+inline __m128i GenerateSamples(__m128i lo, __m128i hi, __m128i base, __m128i mask,
+                               __m128i random, __m128i noiseMask, __m128i noiseHalf)
+{
+    const __m128i triangleLo = _mm_srli_epi16(_mm_xor_si128(lo, _mm_srai_epi16(lo, 15)), 8);
+    const __m128i triangleHi = _mm_srli_epi16(_mm_xor_si128(hi, _mm_srai_epi16(hi, 15)), 8);
+    const __m128i value = _mm_adds_epu8(_mm_adds_epu8(_mm_packus_epi16(triangleLo, triangleHi), base), mask);
+    return _mm_subs_epu8(_mm_adds_epu8(value, _mm_and_si128(random, noiseMask)), noiseHalf);
+}
+
+inline void StoreSamples(__m128i value, uint32_t count, uint8_t* pOut)
+{
+    if (count >= 16) {
+        _mm_storeu_si128((__m128i*)pOut, value);
+    } else {
+        uint8_t last[16];
+        _mm_storeu_si128((__m128i*)last, value);
+        memcpy(pOut, last, count);
+    }
+}
+#elif defined(VK_SYNTHETIC_SOURCE_USE_NEON)
+inline uint32x4_t NextRandom(uint32x4_t random)
+{
+    random = veorq_u32(random, vshlq_n_u32(random, 13));
+    random = veorq_u32(random, vshrq_n_u32(random, 17));
+    return veorq_u32(random, vshlq_n_u32(random, 5));
+}
+
+inline uint8x16_t GenerateSamples(int16x8_t lo, int16x8_t hi, uint8x16_t base, uint8x16_t mask,
+                                  uint32x4_t random, uint8x16_t noiseMask, uint8x16_t noiseHalf)
+{
+    const uint16x8_t triangleLo = vshrq_n_u16(vreinterpretq_u16_s16(veorq_s16(lo, vshrq_n_s16(lo, 15))), 8);
+    const uint16x8_t triangleHi = vshrq_n_u16(vreinterpretq_u16_s16(veorq_s16(hi, vshrq_n_s16(hi, 15))), 8);
+    const uint8x16_t value = vqaddq_u8(vqaddq_u8(vcombine_u8(vmovn_u16(triangleLo), vmovn_u16(triangleHi)), base), mask);
+    return vqsubq_u8(vqaddq_u8(value, vandq_u8(vreinterpretq_u8_u32(random), noiseMask)), noiseHalf);
+}
+
+inline void StoreSamples(uint8x16_t value, uint32_t count, uint8_t* pOut)
+{
+    if (count >= 16) {
+        vst1q_u8(pOut, value);
+    } else {
+        uint8_t last[16];
+        vst1q_u8(last, value);
+        memcpy(pOut, last, count);
+    }
+}
+#endif
+
+} // namespace
+
+const char* VkEncoderSyntheticSource::GetOutputFormatName(OutputFormat outputFormat)
+{
+    switch (outputFormat) {
+    case OUTPUT_NV12:
+        return "nv12";
+    case OUTPUT_P010:
+        return "p010";
+    case OUTPUT_I420:
+        return "i420";
+    default:
+        break;
+    }
+    return "unknown";
+}
+
+void VkEncoderSyntheticSource::RowBuffers::Allocate(uint32_t width)
+{
+    // The text mask holds whole glyph cells around the scrolled row, and the
+    // kernels read it by blocks of 32 bytes.
+    textLine = UINT32_MAX;
+    subCell = 0;
+    cells.assign((width / GLYPH_WIDTH) + 2, NUM_GLYPHS);
+    mask.assign((size_t)width + GLYPH_WIDTH + BLOCK_SIZE, 0);
+    for (uint32_t i = 0; i < 3; i++) {
+        samples[i].assign((size_t)width + 16, 0);
+    }
+}
+
+VkEncoderSyntheticSource::VkEncoderSyntheticSource()
+    : m_config()
+    , m_chromaWidth(0)
+    , m_numBands(0)
+    , m_scene()
+    , m_frameNum(0)
+    , m_buffers()
+    , m_workers()
+    , m_mutex()
+    , m_jobCondition()
+    , m_doneCondition()
+    , m_nextBand(0)
+    , m_pendingBands(0)
+    , m_pDstPlanes()
+    , m_dstPitches()
+    , m_stats()
+    , m_enabled(false)
+    , m_exit(false)
+    , m_verbose(false)
+{
+}
+
+VkEncoderSyntheticSource::~VkEncoderSyntheticSource()
+{
+    Stop();
+}
+
+bool VkEncoderSyntheticSource::Configure(const Config& config, bool verbose)
+{
+    Stop();
+    m_enabled = false;
+
+    if ((config.width == 0) || (config.height == 0) || (config.outputFormat >= OUTPUT_FORMAT_COUNT) ||
+            (config.noiseBits > MAX_NOISE_BITS) || (config.textDensity > 100)) {
+        fprintf(stderr, "SyntheticSource: unsupported %ux%u %s frames with %u noise bits and %u%% text lines\n",
+                config.width, config.height, GetOutputFormatName(config.outputFormat),
+                config.noiseBits, config.textDensity);
+        return false;
+    }
+
+    m_config = config;
+    m_verbose = verbose;
+    m_chromaWidth = (m_config.width + 1) / 2;
+    m_numBands = (m_config.height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+    m_nextBand = m_numBands;
+    m_pendingBands = 0;
+    m_stats = Stats();
+    m_exit = false;
+    SetScene(0);
+
+    if (m_config.numThreads == 0) {
+        m_config.numThreads = std::min(std::max(std::thread::hardware_concurrency(), 1U), 4U);
+    }
+    m_config.numThreads = std::min(m_config.numThreads, m_numBands);
+    if (m_config.numThreads > 1) {
+        for (uint32_t i = 0; i < m_config.numThreads; i++) {
+            m_workers.push_back(std::thread(&VkEncoderSyntheticSource::WorkerThread, this));
+        }
+    } else {
+        m_buffers.Allocate(m_config.width);
+    }
+
+    if (m_verbose) {
+        printf("SyntheticSource: %ux%u %s, %u noise bit(s), motion %u pixel(s) per frame, %u%% text lines, "
+               "scene change every %u frame(s), seed %u, %u thread(s)\n",
+               m_config.width, m_config.height, GetOutputFormatName(m_config.outputFormat), m_config.noiseBits,
+               m_config.motion, m_config.textDensity, m_config.sceneChangeInterval, m_config.seed,
+               m_config.numThreads);
+    }
+
+    m_enabled = true;
+    return true;
+}
+
+bool VkEncoderSyntheticSource::IsSceneChange(uint64_t frameNum) const
+{
+    return (m_config.sceneChangeInterval > 0) && (frameNum > 0) && ((frameNum % m_config.sceneChangeInterval) == 0);
+}
+
+void VkEncoderSyntheticSource::SetScene(uint64_t sceneIndex)
+{
+    m_scene.index = sceneIndex;
+    const uint32_t sceneHash = Hash(m_config.seed, sceneIndex);
+
+    // Gradient periods of 512 to 2730 phase steps for the luma, longer for the chroma
+    for (uint32_t i = 0; i < 3; i++) {
+        const uint32_t h = Hash(sceneHash + i);
+        const uint32_t minSlope = (i == 0) ? 24 : 8;
+        const uint32_t slopeRange = (i == 0) ? 104 : 48;
+        m_scene.slopes[i][0] = (uint16_t)(minSlope + (h % slopeRange));
+        m_scene.slopes[i][1] = (uint16_t)(minSlope + ((h >> 8) % slopeRange));
+        m_scene.bases[i] = (i == 0) ? (uint8_t)(16 + ((h >> 16) % 64)) : (uint8_t)(48 + ((h >> 16) % 33));
+    }
+
+    m_scene.textSeed = Hash(sceneHash + 3);
+    for (uint32_t g = 0; g < NUM_GLYPHS; g++) {
+        uint32_t segments = Hash(m_scene.textSeed, g) & 0x7f;
+        if ((segments & (segments - 1)) == 0) {
+            segments |= 0x09;   // at least two strokes
+        }
+        for (uint32_t row = 0; row < LINE_HEIGHT; row++) {
+            uint8_t columns = 0;
+            for (uint32_t s = 0; s < sizeof(glyphSegments) / sizeof(glyphSegments[0]); s++) {
+                if ((segments & (1U << s)) && (row >= glyphSegments[s].firstRow) && (row <= glyphSegments[s].lastRow)) {
+                    columns |= glyphSegments[s].columns;
+                }
+            }
+            for (uint32_t x = 0; x < GLYPH_WIDTH; x++) {
+                m_scene.glyphs[g][row][x] = (columns & (1U << x)) ? 0xff : 0x00;
+            }
+        }
+    }
+}
+
+bool VkEncoderSyntheticSource::SetTextLine(uint32_t line, RowBuffers& buffers) const
+{
+    const uint32_t lineSeed = Hash(m_scene.textSeed, line);
+    if ((lineSeed % 100) >= m_config.textDensity) {
+        buffers.textLine = UINT32_MAX;
+        return false;
+    }
+
+    // The odd lines scroll to the left, the even ones to the right
+    const int64_t scroll = (int64_t)(m_frameNum * m_config.motion);
+    const int64_t offset = (line & 1) ? scroll : -scroll;
+    const int64_t firstCell = FloorDiv(offset, GLYPH_WIDTH);
+    buffers.subCell = (uint32_t)(offset - (firstCell * GLYPH_WIDTH));
+
+    const uint32_t numCells = (m_config.width + buffers.subCell + GLYPH_WIDTH - 1) / GLYPH_WIDTH;
+    for (uint32_t c = 0; c < numCells; c++) {
+        const uint32_t h = Hash(lineSeed, (uint64_t)(firstCell + c));
+        buffers.cells[c] = ((h & 7) == 0) ? (uint8_t)NUM_GLYPHS : (uint8_t)((h >> 3) % NUM_GLYPHS);
+    }
+    buffers.textLine = line;
+    return true;
+}
+
+const uint8_t* VkEncoderSyntheticSource::GetTextMask(uint32_t y, RowBuffers& buffers) const
+{
+    const uint32_t line = y / LINE_HEIGHT;
+    if ((buffers.textLine != line) && !SetTextLine(line, buffers)) {
+        return nullptr;
+    }
+
+    static const uint8_t space[GLYPH_WIDTH] = { 0 };
+    const uint32_t row = y % LINE_HEIGHT;
+    const uint32_t numCells = (m_config.width + buffers.subCell + GLYPH_WIDTH - 1) / GLYPH_WIDTH;
+    for (uint32_t c = 0; c < numCells; c++) {
+        const uint8_t glyph = buffers.cells[c];
+        memcpy(&buffers.mask[(size_t)c * GLYPH_WIDTH], (glyph < NUM_GLYPHS) ? m_scene.glyphs[glyph][row] : space,
+               GLYPH_WIDTH);
+    }
+    return buffers.mask.data() + buffers.subCell;
+}
+
+void VkEncoderSyntheticSource::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_jobCondition.notify_all();
+
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        if (m_workers[i].joinable()) {
+            m_workers[i].join();
+        }
+    }
+    m_workers.clear();
+}
+
+void VkEncoderSyntheticSource::WorkerThread()
+{
+    RowBuffers buffers;
+    buffers.Allocate(m_config.width);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_jobCondition.wait(lock, [this] { return m_exit || (m_nextBand < m_numBands); });
+        if (m_exit) {
+            break;
+        }
+
+        const uint32_t band = m_nextBand++;
+        lock.unlock();
+
+        GenerateBand(band, buffers);
+
+        lock.lock();
+        assert(m_pendingBands > 0);
+        if (--m_pendingBands == 0) {
+            m_doneCondition.notify_all();
+        }
+    }
+}
+
+void VkEncoderSyntheticSource::GenerateRow(const RowParams& params, uint32_t count, uint8_t* pOut)
+{
+    uint32_t state[NOISE_LANES];
+    InitNoiseState(params.noiseSeed, state);
+
+#if defined(VK_SYNTHETIC_SOURCE_USE_SSE2)
+    const uint16_t s = params.step;
+    __m128i phase = _mm_setr_epi16((int16_t)(uint16_t)(params.start),
+                                   (int16_t)(uint16_t)(params.start + s),
+                                   (int16_t)(uint16_t)(params.start + (2 * s)),
+                                   (int16_t)(uint16_t)(params.start + (3 * s)),
+                                   (int16_t)(uint16_t)(params.start + (4 * s)),
+                                   (int16_t)(uint16_t)(params.start + (5 * s)),
+                                   (int16_t)(uint16_t)(params.start + (6 * s)),
+                                   (int16_t)(uint16_t)(params.start + (7 * s)));
+    const __m128i step8 = _mm_set1_epi16((int16_t)(uint16_t)(8 * s));
+    const __m128i base = _mm_set1_epi8((char)params.base);
+    const __m128i maskValue = _mm_set1_epi8((char)params.maskValue);
+    const __m128i noiseMask = _mm_set1_epi8((char)params.noiseMask);
+    const __m128i noiseHalf = _mm_set1_epi8((char)(params.noiseMask >> 1));
+    __m128i random0 = _mm_loadu_si128((const __m128i*)&state[0]);
+    __m128i random1 = _mm_loadu_si128((const __m128i*)&state[4]);
+    __m128i mask0 = _mm_setzero_si128();
+    __m128i mask1 = _mm_setzero_si128();
+    for (uint32_t i = 0; i < count; i += BLOCK_SIZE) {
+        const __m128i phase1 = _mm_add_epi16(phase, step8);
+        const __m128i phase2 = _mm_add_epi16(phase1, step8);
+        const __m128i phase3 = _mm_add_epi16(phase2, step8);
+        random0 = NextRandom(random0);
+        random1 = NextRandom(random1);
+        if (params.pMask != nullptr) {
+            mask0 = _mm_and_si128(_mm_loadu_si128((const __m128i*)(params.pMask + i)), maskValue);
+            mask1 = _mm_and_si128(_mm_loadu_si128((const __m128i*)(params.pMask + i + 16)), maskValue);
+        }
+
+        StoreSamples(GenerateSamples(phase, phase1, base, mask0, random0, noiseMask, noiseHalf), count - i, pOut + i);
+        if ((i + 16) < count) {
+            StoreSamples(GenerateSamples(phase2, phase3, base, mask1, random1, noiseMask, noiseHalf),
+                         count - i - 16, pOut + i + 16);
+        }
+        phase = _mm_add_epi16(phase3, step8);
+    }
+#elif defined(VK_SYNTHETIC_SOURCE_USE_NEON)
+    uint16_t initialPhase[8];
+    for (uint32_t k = 0; k < 8; k++) {
+        initialPhase[k] = (uint16_t)(params.start + (k * params.step));
+    }
+    int16x8_t phase = vreinterpretq_s16_u16(vld1q_u16(initialPhase));
+    const int16x8_t step8 = vdupq_n_s16((int16_t)(uint16_t)(8 * params.step));
+    const uint8x16_t base = vdupq_n_u8(params.base);
+    const uint8x16_t maskValue = vdupq_n_u8(params.maskValue);
+    const uint8x16_t noiseMask = vdupq_n_u8(params.noiseMask);
+    const uint8x16_t noiseHalf = vdupq_n_u8((uint8_t)(params.noiseMask >> 1));
+    uint32x4_t random0 = vld1q_u32(&state[0]);
+    uint32x4_t random1 = vld1q_u32(&state[4]);
+    uint8x16_t mask0 = vdupq_n_u8(0);
+    uint8x16_t mask1 = vdupq_n_u8(0);
+    for (uint32_t i = 0; i < count; i += BLOCK_SIZE) {
+        const int16x8_t phase1 = vaddq_s16(phase, step8);
+        const int16x8_t phase2 = vaddq_s16(phase1, step8);
+        const int16x8_t phase3 = vaddq_s16(phase2, step8);
+        random0 = NextRandom(random0);
+        random1 = NextRandom(random1);
+        if (params.pMask != nullptr) {
+            mask0 = vandq_u8(vld1q_u8(params.pMask + i), maskValue);
+            mask1 = vandq_u8(vld1q_u8(params.pMask + i + 16), maskValue);
+        }
+
+        StoreSamples(GenerateSamples(phase, phase1, base, mask0, random0, noiseMask, noiseHalf), count - i, pOut + i);
+        if ((i + 16) < count) {
+            StoreSamples(GenerateSamples(phase2, phase3, base, mask1, random1, noiseMask, noiseHalf),
+                         count - i - 16, pOut + i + 16);
+        }
+        phase = vaddq_s16(phase3, step8);
+    }
+#else
+    const uint32_t noiseHalf = params.noiseMask >> 1;
+    for (uint32_t i = 0; i < count; i += BLOCK_SIZE) {
+        for (uint32_t lane = 0; lane < NOISE_LANES; lane++) {
+            state[lane] ^= state[lane] << 13;
+            state[lane] ^= state[lane] >> 17;
+            state[lane] ^= state[lane] << 5;
+        }
+        for (uint32_t j = 0; (j < BLOCK_SIZE) && ((i + j) < count); j++) {
+            const int16_t phase = (int16_t)(uint16_t)(params.start + ((i + j) * params.step));
+            uint32_t value = std::min((uint32_t)((uint16_t)(phase ^ (phase >> 15)) >> 8) + params.base, 255U);
+            if (params.pMask != nullptr) {
+                value = std::min(value + (params.pMask[i + j] & params.maskValue), 255U);
+            }
+            value = std::min(value + ((state[j / 4] >> (8 * (j % 4))) & params.noiseMask), 255U);
+            pOut[i + j] = (uint8_t)((value > noiseHalf) ? (value - noiseHalf) : 0);
+        }
+    }
+#endif
+}
+
+void VkEncoderSyntheticSource::StoreLumaRow(const uint8_t* pSamples, uint8_t* pDst) const
+{
+    // The P010 samples: the 8 generated bits, extended to 10 bits in the MSBs
+    uint32_t i = 0;
+#if defined(VK_SYNTHETIC_SOURCE_USE_SSE2)
+    const __m128i mask = _mm_set1_epi16((int16_t)0xffc0);
+    for (; (i + 16) <= m_config.width; i += 16) {
+        const __m128i value = _mm_loadu_si128((const __m128i*)(pSamples + i));
+        _mm_storeu_si128((__m128i*)(pDst + (2 * i)), _mm_and_si128(_mm_unpacklo_epi8(value, value), mask));
+        _mm_storeu_si128((__m128i*)(pDst + (2 * i) + 16), _mm_and_si128(_mm_unpackhi_epi8(value, value), mask));
+    }
+#elif defined(VK_SYNTHETIC_SOURCE_USE_NEON)
+    const uint16x8_t mask = vdupq_n_u16(0xffc0);
+    for (; (i + 8) <= m_config.width; i += 8) {
+        const uint8x8_t value = vld1_u8(pSamples + i);
+        vst1q_u16((uint16_t*)(pDst + (2 * i)), vandq_u16(vorrq_u16(vshll_n_u8(value, 8), vmovl_u8(value)), mask));
+    }
+#endif
+    for (; i < m_config.width; i++) {
+        const uint16_t value = (uint16_t)(((pSamples[i] << 8) | pSamples[i]) & 0xffc0);
+        memcpy(pDst + (2 * i), &value, sizeof(value));
+    }
+}
+
+void VkEncoderSyntheticSource::StoreChromaRow(const uint8_t* pCb, const uint8_t* pCr,
+                                              uint8_t* pDstCb, uint8_t* pDstCr) const
+{
+    if (m_config.outputFormat == OUTPUT_I420) {
+        memcpy(pDstCb, pCb, m_chromaWidth);
+        memcpy(pDstCr, pCr, m_chromaWidth);
+        return;
+    }
+
+    const bool p010 = (m_config.outputFormat == OUTPUT_P010);
+    uint32_t i = 0;
+#if defined(VK_SYNTHETIC_SOURCE_USE_SSE2)
+    const __m128i mask = _mm_set1_epi16((int16_t)0xffc0);
+    for (; (i + 16) <= m_chromaWidth; i += 16) {
+        const __m128i cb = _mm_loadu_si128((const __m128i*)(pCb + i));
+        const __m128i cr = _mm_loadu_si128((const __m128i*)(pCr + i));
+        if (p010) {
+            const __m128i cbLo = _mm_and_si128(_mm_unpacklo_epi8(cb, cb), mask);
+            const __m128i cbHi = _mm_and_si128(_mm_unpackhi_epi8(cb, cb), mask);
+            const __m128i crLo = _mm_and_si128(_mm_unpacklo_epi8(cr, cr), mask);
+            const __m128i crHi = _mm_and_si128(_mm_unpackhi_epi8(cr, cr), mask);
+            _mm_storeu_si128((__m128i*)(pDstCb + (4 * i)),      _mm_unpacklo_epi16(cbLo, crLo));
+            _mm_storeu_si128((__m128i*)(pDstCb + (4 * i) + 16), _mm_unpackhi_epi16(cbLo, crLo));
+            _mm_storeu_si128((__m128i*)(pDstCb + (4 * i) + 32), _mm_unpacklo_epi16(cbHi, crHi));
+            _mm_storeu_si128((__m128i*)(pDstCb + (4 * i) + 48), _mm_unpackhi_epi16(cbHi, crHi));
+        } else {
+            _mm_storeu_si128((__m128i*)(pDstCb + (2 * i)),      _mm_unpacklo_epi8(cb, cr));
+            _mm_storeu_si128((__m128i*)(pDstCb + (2 * i) + 16), _mm_unpackhi_epi8(cb, cr));
+        }
+    }
+#elif defined(VK_SYNTHETIC_SOURCE_USE_NEON)
+    const uint16x8_t mask = vdupq_n_u16(0xffc0);
+    for (; (i + 8) <= m_chromaWidth; i += 8) {
+        const uint8x8_t cb = vld1_u8(pCb + i);
+        const uint8x8_t cr = vld1_u8(pCr + i);
+        if (p010) {
+            uint16x8x2_t cbCr;
+            cbCr.val[0] = vandq_u16(vorrq_u16(vshll_n_u8(cb, 8), vmovl_u8(cb)), mask);
+            cbCr.val[1] = vandq_u16(vorrq_u16(vshll_n_u8(cr, 8), vmovl_u8(cr)), mask);
+            vst2q_u16((uint16_t*)(pDstCb + (4 * i)), cbCr);
+        } else {
+            uint8x8x2_t cbCr;
+            cbCr.val[0] = cb;
+            cbCr.val[1] = cr;
+            vst2_u8(pDstCb + (2 * i), cbCr);
+        }
+    }
+#endif
+    for (; i < m_chromaWidth; i++) {
+        if (p010) {
+            const uint16_t cbCr[2] = { (uint16_t)(((pCb[i] << 8) | pCb[i]) & 0xffc0),
+                                       (uint16_t)(((pCr[i] << 8) | pCr[i]) & 0xffc0) };
+            memcpy(pDstCb + (4 * i), cbCr, sizeof(cbCr));
+        } else {
+            pDstCb[2 * i] = pCb[i];
+            pDstCb[(2 * i) + 1] = pCr[i];
+        }
+    }
+}
+
+void VkEncoderSyntheticSource::GenerateBand(uint32_t band, RowBuffers& buffers)
+{
+    const uint32_t firstRow = band * ROWS_PER_BAND;
+    const uint32_t endRow = std::min(firstRow + ROWS_PER_BAND, m_config.height);
+    const uint32_t frameSeed = Hash(m_config.seed, m_frameNum);
+    // The gradients pan diagonally, the chroma by half as many samples
+    const uint32_t panX = (uint32_t)(m_frameNum * m_config.motion);
+    const uint32_t panY = panX / 2;
+    const bool highBitDepth = (m_config.outputFormat == OUTPUT_P010);
+
+    // The text cells of the previous band are from another frame
+    buffers.textLine = UINT32_MAX;
+
+    RowParams params;
+    params.maskValue = 96;
+    for (uint32_t y = firstRow; y < endRow; y++) {
+        params.start = (uint16_t)((panX * m_scene.slopes[0][0]) + ((y + panY) * m_scene.slopes[0][1]));
+        params.step = m_scene.slopes[0][0];
+        params.base = m_scene.bases[0];
+        params.pMask = GetTextMask(y, buffers);
+        params.noiseMask = (uint8_t)((1U << m_config.noiseBits) - 1);
+        params.noiseSeed = Hash(frameSeed, (uint64_t)y << 2);
+
+        uint8_t* pDstY = m_pDstPlanes[0] + (y * m_dstPitches[0]);
+        if (highBitDepth) {
+            GenerateRow(params, m_config.width, buffers.samples[0].data());
+            StoreLumaRow(buffers.samples[0].data(), pDstY);
+        } else {
+            GenerateRow(params, m_config.width, pDstY);
+        }
+
+        if ((y & 1) == 0) {
+            const uint32_t chromaRow = y / 2;
+            for (uint32_t i = 1; i < 3; i++) {
+                params.start = (uint16_t)(((panX / 2) * m_scene.slopes[i][0]) +
+                                          ((chromaRow + (panY / 2)) * m_scene.slopes[i][1]));
+                params.step = m_scene.slopes[i][0];
+                params.base = m_scene.bases[i];
+                params.pMask = nullptr;
+                params.noiseMask = (uint8_t)((1U << (m_config.noiseBits / 2)) - 1);
+                params.noiseSeed = Hash(frameSeed, ((uint64_t)chromaRow << 2) | i);
+                GenerateRow(params, m_chromaWidth, buffers.samples[i].data());
+            }
+            StoreChromaRow(buffers.samples[1].data(), buffers.samples[2].data(),
+                           m_pDstPlanes[1] + (chromaRow * m_dstPitches[1]),
+                           (m_pDstPlanes[2] != nullptr) ? (m_pDstPlanes[2] + (chromaRow * m_dstPitches[2])) : nullptr);
+        }
+    }
+}
+
+bool VkEncoderSyntheticSource::Generate(uint64_t frameNum, uint8_t* const pDstPlanes[3], const size_t dstPitches[3])
+{
+    const uint32_t numPlanes = (m_config.outputFormat == OUTPUT_I420) ? 3 : 2;
+    if (!m_enabled || (pDstPlanes[0] == nullptr) || (pDstPlanes[1] == nullptr) ||
+            ((numPlanes > 2) && (pDstPlanes[2] == nullptr))) {
+        return false;
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const uint64_t sceneIndex = (m_config.sceneChangeInterval > 0) ? (frameNum / m_config.sceneChangeInterval) : 0;
+    if (sceneIndex != m_scene.index) {
+        SetScene(sceneIndex);
+    }
+    m_frameNum = frameNum;
+    for (uint32_t i = 0; i < 3; i++) {
+        m_pDstPlanes[i] = (i < numPlanes) ? pDstPlanes[i] : nullptr;
+        m_dstPitches[i] = (i < numPlanes) ? dstPitches[i] : 0;
+    }
+
+    if (m_workers.empty()) {
+        for (uint32_t band = 0; band < m_numBands; band++) {
+            GenerateBand(band, m_buffers);
+        }
+    } else {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_pendingBands = m_numBands;
+        m_nextBand = 0;
+        m_jobCondition.notify_all();
+        m_doneCondition.wait(lock, [this] { return (m_pendingBands == 0); });
+    }
+
+    m_stats.numFrames++;
+    m_stats.generateTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void VkEncoderSyntheticSource::PrintReport(FILE* fp) const
+{
+    if (m_stats.numFrames == 0) {
+        return;
+    }
+
+    const double msPerFrame = ((double)m_stats.generateTimeNs / 1e6) / (double)m_stats.numFrames;
+    fprintf(fp, "SyntheticSource: %llu frame(s) %ux%u %s, %u thread(s), %.3f ms per frame, %.1f frames/s\n",
+            (unsigned long long)m_stats.numFrames, m_config.width, m_config.height,
+            GetOutputFormatName(m_config.outputFormat), m_config.numThreads, msPerFrame,
+            (msPerFrame > 0.0) ? (1e3 / msPerFrame) : 0.0);
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEOENCODER_VKENCODERSYNTHETICSOURCE_H_
+#define _VKVIDEOENCODER_VKENCODERSYNTHETICSOURCE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Generates moving synthetic 4:2:0 input frames on the CPU, directly into the
+// staging images, to benchmark the encoder without an input file:
+//  - Luma and chroma gradients, panning by `motion` pixels per frame.
+//  - Lines of text-like glyphs with sharp edges, scrolling horizontally in
+//    alternate directions, on textDensity percent of the 16-row lines.
+//  - Noise of noiseBits random bits per luma sample and half as many per
+//    chroma sample, which sets the entropy the encoder has to spend bits on.
+//  - A new scene every sceneChangeInterval frames: other gradients, glyphs
+//    and text lines.
+// A row only depends on the seed, the frame number and the row index, so the
+// frames are the same for any number of threads. The rows are generated by
+// SIMD (SSE2 / NEON) kernels, in bands of rows on worker threads.
+class VkEncoderSyntheticSource {
+
+public:
+
+    enum OutputFormat {
+        OUTPUT_NV12 = 0,                // 8-bit Y plane and interleaved CbCr plane
+        OUTPUT_P010,                    // 16-bit NV12 with the 10-bit samples in the MSBs
+        OUTPUT_I420,                    // 8-bit Y, Cb and Cr planes
+        OUTPUT_FORMAT_COUNT
+    };
+
+    enum { MAX_NOISE_BITS = 8 };
+
+    struct Config {
+        uint32_t     width;
+        uint32_t     height;
+        OutputFormat outputFormat;
+        uint32_t     noiseBits;             // random bits added to each sample, 0: no noise
+        uint32_t     motion;                // pixels per frame of the panning and the scrolling
+        uint32_t     textDensity;           // percent of the lines with text
+        uint32_t     sceneChangeInterval;   // frames per scene, 0: a single scene
+        uint32_t     seed;
+        uint32_t     numThreads;            // 0: up to 4, depending on the CPU, 1: the calling thread only
+
+        Config()
+        : width(0)
+        , height(0)
+        , outputFormat(OUTPUT_NV12)
+        , noiseBits(4)
+        , motion(4)
+        , textDensity(30)
+        , sceneChangeInterval(0)
+        , seed(1)
+        , numThreads(0) {}
+    };
+
+    struct Stats {
+        uint64_t numFrames;
+        uint64_t generateTimeNs;        // of the calls to Generate()
+    };
+
+    static const char* GetOutputFormatName(OutputFormat outputFormat);
+
+    VkEncoderSyntheticSource();
+    ~VkEncoderSyntheticSource();
+
+    bool Configure(const Config& config, bool verbose = false);
+    bool IsEnabled() const { return m_enabled; }
+    const Config& GetConfig() const { return m_config; }
+
+    // True for the first frame of each scene but the first one.
+    bool IsSceneChange(uint64_t frameNum) const;
+
+    // Writes the frame frameNum to the Y and chroma planes pDstPlanes[] (two
+    // for NV12 and P010, three for I420) with dstPitches[] bytes per row.
+    bool Generate(uint64_t frameNum, uint8_t* const pDstPlanes[3], const size_t dstPitches[3]);
+
+    // Joins the worker threads.
+    void Stop();
+
+    const Stats& GetStats() const { return m_stats; }
+    void PrintReport(FILE* fp = stdout) const;
+
+private:
+
+    // Rows generated by a worker at a time, even for the chroma subsampling.
+    enum { ROWS_PER_BAND = 16 };
+    enum { GLYPH_WIDTH = 8 };
+    enum { LINE_HEIGHT = 16 };
+    enum { NUM_GLYPHS = 64 };
+
+    // A gradient row: the triangle wave of the 16-bit phase start + x * step,
+    // from base to base + 127.
+    struct RowParams {
+        uint16_t       start;
+        uint16_t       step;
+        uint8_t        base;
+        const uint8_t* pMask;           // the text mask, nullptr if none
+        uint8_t        maskValue;       // added where the mask is set
+        uint8_t        noiseMask;
+        uint32_t       noiseSeed;
+    };
+
+    struct Scene {
+        uint64_t index;
+        uint16_t slopes[3][2];          // x and y phase steps of the Y, Cb and Cr gradients
+        uint8_t  bases[3];
+        uint32_t textSeed;
+        uint8_t  glyphs[NUM_GLYPHS][LINE_HEIGHT][GLYPH_WIDTH];   // 0xff where the glyph is drawn
+    };
+
+    struct RowBuffers {
+        uint32_t             textLine;      // of the cells, UINT32_MAX if none
+        uint32_t             subCell;       // scrolling offset in the first cell
+        std::vector<uint8_t> cells;         // glyph per cell of the text line, NUM_GLYPHS for a space
+        std::vector<uint8_t> mask;
+        std::vector<uint8_t> samples[3];    // Y, Cb and Cr before the store
+
+        void Allocate(uint32_t width);
+    };
+
+    void SetScene(uint64_t sceneIndex);
+    bool SetTextLine(uint32_t line, RowBuffers& buffers) const;
+    const uint8_t* GetTextMask(uint32_t y, RowBuffers& buffers) const;
+    void WorkerThread();
+    void GenerateBand(uint32_t band, RowBuffers& buffers);
+    void StoreLumaRow(const uint8_t* pSamples, uint8_t* pDst) const;
+    void StoreChromaRow(const uint8_t* pCb, const uint8_t* pCr, uint8_t* pDstCb, uint8_t* pDstCr) const;
+
+    static void GenerateRow(const RowParams& params, uint32_t count, uint8_t* pOut);
+
+    Config                   m_config;
+    uint32_t                 m_chromaWidth;
+    uint32_t                 m_numBands;
+    Scene                    m_scene;
+    uint64_t                 m_frameNum;        // being generated
+    RowBuffers               m_buffers;         // of the calling thread, without workers
+    std::vector<std::thread> m_workers;
+    std::mutex               m_mutex;
+    std::condition_variable  m_jobCondition;    // a frame was queued, or the source stops
+    std::condition_variable  m_doneCondition;   // the workers finished the last band
+    uint32_t                 m_nextBand;
+    uint32_t                 m_pendingBands;
+    uint8_t*                 m_pDstPlanes[3];
+    size_t                   m_dstPitches[3];
+    Stats                    m_stats;
+    bool                     m_enabled;
+    bool                     m_exit;
+    bool                     m_verbose;
+};
+
+#endif /* _VKVIDEOENCODER_VKENCODERSYNTHETICSOURCE_H_ */
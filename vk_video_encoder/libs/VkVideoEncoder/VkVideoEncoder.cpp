@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <cmath>
 #include <functional>
 #include <vector>
 #include "VkVideoEncoder/VkVideoEncoder.h"
@@ -24,6 +25,8 @@
 #include "VkVideoEncoder/VkEncoderConfigH265.h"
 #include "VkVideoEncoder/VkEncoderConfigAV1.h"
 #include "VkCodecUtils/YCbCrConvUtilsCpu.h"
+#include "VkCodecUtils/VkVideoTracer.h"
+#include "VkCodecUtils/VulkanShaderCache.h"
 #include "VkVideoCore/DecodeFrameBufferIf.h"
 
 static size_t getFormatTexelSize(VkFormat format)
@@ -67,9 +70,11 @@ const uint8_t* VkVideoEncoder::setPlaneOffset(const uint8_t* pFrameData, size_t
     return buf;
 }
 
-VkResult VkVideoEncoder::LoadNextQpMapFrameFromFile(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo)
+// Loads the qpMap of the frame from the qpMap file, or generates it from the input frame
+VkResult VkVideoEncoder::LoadNextQpMapFrame(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo)
 {
-    if ((m_encoderConfig->enableQpMap == VK_FALSE) || (!m_encoderConfig->qpMapFileHandler.HandleIsValid()))  {
+    if ((m_encoderConfig->enableQpMap == VK_FALSE) ||
+            (!m_encoderConfig->qpMapFileHandler.HandleIsValid() && !m_qpMapGenerator.IsEnabled()))  {
         return VK_SUCCESS;
     }
 
@@ -103,6 +108,28 @@ VkResult VkVideoEncoder::LoadNextQpMapFrameFromFile(VkSharedBaseObj<VkVideoEncod
         uint8_t* writeQpMapImagePtr = srcQpMapImageDeviceMemory->GetDataPtr(qpMapImageOffset, qpMapMaxSize);
         assert(writeQpMapImagePtr != nullptr);
 
+        const VkSubresourceLayout* dstQpMapSubresourceLayout = dstQpMapImageResource->GetSubresourceLayout();
+
+        if (m_qpMapGenerator.IsEnabled()) {
+            const uint64_t frameNum = encodeFrameInfo->frameInputOrderNum;
+            const uint64_t lumaOffset = m_encoderConfig->input.planeLayouts[0].offset;
+            const uint8_t* pLuma = m_encoderConfig->inputFileHandler.GetMappedPtr(m_encoderConfig->input.fullImageSize, frameNum);
+            const uint8_t* pPrevLuma = (frameNum > 0) ?
+                    m_encoderConfig->inputFileHandler.GetMappedPtr(m_encoderConfig->input.fullImageSize, frameNum - 1) : nullptr;
+            if (pLuma == nullptr) {
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+
+            VK_VIDEO_TRACE_SCOPE("encode", "GenerateQpMap", frameNum);
+            if (!m_qpMapGenerator.Generate(pLuma + lumaOffset,
+                                           (pPrevLuma != nullptr) ? (pPrevLuma + lumaOffset) : nullptr,
+                                           writeQpMapImagePtr + dstQpMapSubresourceLayout[0].offset,
+                                           (size_t)dstQpMapSubresourceLayout[0].rowPitch)) {
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+            return VK_SUCCESS;
+        }
+
         size_t formatSize = getFormatTexelSize(m_imageQpMapFormat);
         uint32_t inputQpMapWidth = (m_encoderConfig->input.width + m_qpMapTexelSize.width - 1) / m_qpMapTexelSize.width;
         uint32_t qpMapWidth = (m_encoderConfig->encodeWidth + m_qpMapTexelSize.width - 1) / m_qpMapTexelSize.width;
@@ -110,8 +137,6 @@ VkResult VkVideoEncoder::LoadNextQpMapFrameFromFile(VkSharedBaseObj<VkVideoEncod
         uint64_t qpMapFileOffset = qpMapWidth * qpMapHeight * encodeFrameInfo->frameInputOrderNum * formatSize;
         const uint8_t* pQpMapData = m_encoderConfig->qpMapFileHandler.GetMappedPtr(qpMapFileOffset);
 
-        const VkSubresourceLayout* dstQpMapSubresourceLayout = dstQpMapImageResource->GetSubresourceLayout();
-
         for (uint32_t j = 0; j < qpMapHeight; j++) {
             memcpy(writeQpMapImagePtr + (dstQpMapSubresourceLayout[0].offset + j * dstQpMapSubresourceLayout[0].rowPitch),
                    pQpMapData + j * inputQpMapWidth * formatSize, qpMapWidth * formatSize);
@@ -124,18 +149,20 @@ VkResult VkVideoEncoder::LoadNextQpMapFrameFromFile(VkSharedBaseObj<VkVideoEncod
 // 1. Load current input frame from file
 // 2. Convert yuv image to nv12 (TODO: switch to Vulkan compute next, instead of using the CPU for that)
 // 3. Copy the nv12 input linear image to the optimal input image
-// 4. Load qp map from file
+// 4. Load qp map from file, or generate it from the input frame
 // 5. Copy linear image to the optimal image
 VkResult VkVideoEncoder::LoadNextFrame(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo)
 {
     assert(encodeFrameInfo);
 
     encodeFrameInfo->frameInputOrderNum = m_inputFrameNum++;
+    VK_VIDEO_TRACE_SCOPE("encode", "LoadNextFrame", encodeFrameInfo->frameInputOrderNum);
     encodeFrameInfo->lastFrame = !(encodeFrameInfo->frameInputOrderNum < (m_encoderConfig->numFrames - 1));
 
-    if ((m_encoderConfig->enableQpMap == VK_TRUE) && m_encoderConfig->qpMapFileHandler.HandleIsValid()) {
+    if ((m_encoderConfig->enableQpMap == VK_TRUE) &&
+            (m_encoderConfig->qpMapFileHandler.HandleIsValid() || m_qpMapGenerator.IsEnabled())) {
 
-        VkResult result = LoadNextQpMapFrameFromFile(encodeFrameInfo);
+        VkResult result = LoadNextQpMapFrame(encodeFrameInfo);
         if (result != VK_SUCCESS) {
             return result;
         }
@@ -164,12 +191,38 @@ VkResult VkVideoEncoder::LoadNextFrame(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
     uint8_t* writeImagePtr = srcImageDeviceMemory->GetDataPtr(imageOffset, maxSize);
     assert(writeImagePtr != nullptr);
 
-    const uint8_t* pInputFrameData = m_encoderConfig->inputFileHandler.GetMappedPtr(m_encoderConfig->input.fullImageSize, encodeFrameInfo->frameInputOrderNum);
+    const uint8_t* pInputFrameData = m_syntheticSource.IsEnabled() ? nullptr :
+            m_encoderConfig->inputFileHandler.GetMappedPtr(m_encoderConfig->input.fullImageSize, encodeFrameInfo->frameInputOrderNum);
 
     const VkSubresourceLayout* dstSubresourceLayout = dstImageResource->GetSubresourceLayout();
 
     int yCbCrConvResult = 0;
-    if (m_encoderConfig->input.bpp == 8) {
+    if (m_syntheticSource.IsEnabled()) {
+
+        // Generate the current frame as NV12 or P010, straight into the staging image
+        VK_VIDEO_TRACE_SCOPE("encode", "GenerateSyntheticInput", encodeFrameInfo->frameInputOrderNum);
+        uint8_t* const pDstPlanes[3] = { writeImagePtr + dstSubresourceLayout[0].offset,
+                                         writeImagePtr + dstSubresourceLayout[1].offset,
+                                         nullptr };
+        const size_t dstPitches[3] = { (size_t)dstSubresourceLayout[0].rowPitch,
+                                       (size_t)dstSubresourceLayout[1].rowPitch,
+                                       0 };
+        yCbCrConvResult = m_syntheticSource.Generate(encodeFrameInfo->frameInputOrderNum, pDstPlanes, dstPitches) ? 0 : -1;
+
+    } else if (m_rgbConverter.IsEnabled()) {
+
+        // Convert the current packed RGB frame to NV12 or P010
+        VK_VIDEO_TRACE_SCOPE("encode", "ConvertRgbInput", encodeFrameInfo->frameInputOrderNum);
+        uint8_t* const pDstPlanes[3] = { writeImagePtr + dstSubresourceLayout[0].offset,
+                                         writeImagePtr + dstSubresourceLayout[1].offset,
+                                         nullptr };
+        const size_t dstPitches[3] = { (size_t)dstSubresourceLayout[0].rowPitch,
+                                       (size_t)dstSubresourceLayout[1].rowPitch,
+                                       0 };
+        yCbCrConvResult = m_rgbConverter.Convert(pInputFrameData, (size_t)m_encoderConfig->input.planeLayouts[0].rowPitch,
+                                                 pDstPlanes, dstPitches) ? 0 : -1;
+
+    } else if (m_encoderConfig->input.bpp == 8) {
 
         // Load current 8-bit frame from file and convert to NV12
         yCbCrConvResult = YCbCrConvUtilsCpu<uint8_t>::I420ToNV12(
@@ -293,8 +346,35 @@ VkResult VkVideoEncoder::StageInputFrameQpMap(VkSharedBaseObj<VkVideoEncodeFrame
 
 VkResult VkVideoEncoder::EncodeFrameCommon(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo)
 {
+    // Apply the runtime configuration changes before the codec decides the picture type
+    VkResult result = ApplyReconfiguration(encodeFrameInfo);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
     encodeFrameInfo->constQp = m_encoderConfig->constQp;
 
+    if (m_lookahead.IsEnabled()) {
+        uint32_t framesToSceneCut = uint32_t(-1);
+        const VkEncoderLookahead::FrameStats& stats = m_lookahead.GetFrameStats(encodeFrameInfo->frameInputOrderNum,
+                                                                                framesToSceneCut);
+        m_gopState.framesToSceneCut = framesToSceneCut;
+        encodeFrameInfo->lookaheadComplexity = stats.complexity;
+
+        if (m_encoderConfig->lookaheadAdaptiveQp &&
+                (m_rateControlInfo.rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR)) {
+            // About 6 QP steps double the quantizer step size. Spend fewer bits
+            // on the frames with more motion than the rest of their shot, where
+            // the artifacts are masked, and more bits on the quieter frames.
+            const bool isAv1 = (m_encoderConfig->codec == VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR);
+            const int32_t maxQp = isAv1 ? 255 : 51;
+            int32_t deltaQp = (int32_t)std::lround(2.4f * std::log2(std::max(stats.complexity, 0.01f)));
+            deltaQp = std::min(std::max(deltaQp, -4), 4) * (isAv1 ? 4 : 1);
+            encodeFrameInfo->constQp.qpInterP = (uint32_t)std::min(std::max((int32_t)encodeFrameInfo->constQp.qpInterP + deltaQp, 0), maxQp);
+            encodeFrameInfo->constQp.qpInterB = (uint32_t)std::min(std::max((int32_t)encodeFrameInfo->constQp.qpInterB + deltaQp, 0), maxQp);
+        }
+    }
+
     // and encode the input frame with the encoder next
     return EncodeFrame(encodeFrameInfo);
 }
@@ -302,6 +382,7 @@ VkResult VkVideoEncoder::EncodeFrameCommon(VkSharedBaseObj<VkVideoEncodeFrameInf
 VkResult VkVideoEncoder::StageInputFrame(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo)
 {
     assert(encodeFrameInfo);
+    VK_VIDEO_TRACE_SCOPE("encode", "StageInputFrame", encodeFrameInfo->frameInputOrderNum);
 
     if (encodeFrameInfo->srcEncodeImageResource == nullptr) {
 
@@ -416,6 +497,7 @@ VkResult VkVideoEncoder::SubmitStagedInputFrame(VkSharedBaseObj<VkVideoEncodeFra
 {
     assert(encodeFrameInfo);
     assert(encodeFrameInfo->inputCmdBuffer != nullptr);
+    VK_VIDEO_TRACE_SCOPE("encode", "SubmitStagedInputFrame", encodeFrameInfo->frameInputOrderNum);
 
     const VkCommandBuffer* pCmdBuf = encodeFrameInfo->inputCmdBuffer->GetCommandBuffer();
     VkSemaphore frameCompleteSemaphore = encodeFrameInfo->inputCmdBuffer->GetSemaphore();
@@ -482,6 +564,7 @@ VkResult VkVideoEncoder::AssembleBitstreamData(VkSharedBaseObj<VkVideoEncodeFram
 
     assert(encodeFrameInfo->outputBitstreamBuffer != nullptr);
     assert(encodeFrameInfo->encodeCmdBuffer != nullptr);
+    VK_VIDEO_TRACE_SCOPE("encode", "AssembleBitstreamData", encodeFrameInfo->frameInputOrderNum);
 
     if(encodeFrameInfo->bitstreamHeaderBufferSize > 0) {
         size_t nonVcl = fwrite(encodeFrameInfo->bitstreamHeaderBuffer + encodeFrameInfo->bitstreamHeaderOffset,
@@ -543,6 +626,10 @@ VkResult VkVideoEncoder::AssembleBitstreamData(VkSharedBaseObj<VkVideoEncodeFram
     size_t vcl = fwrite(data + encodeResult.bitstreamStartOffset, 1, encodeResult.bitstreamSize,
                         m_encoderConfig->outputFileHandler.GetFileHandle());
 
+    m_hrdVerifier.UpdateRate(encodeFrameInfo->hrdRateUpdate);
+    m_hrdVerifier.VerifyAccessUnit(encodeFrameInfo->frameEncodeEncodeOrderNum,
+                                   encodeFrameInfo->bitstreamHeaderBufferSize + encodeResult.bitstreamSize);
+
     if (m_encoderConfig->verboseFrameStruct) {
         std::cout << "       == Output VCL data " << (vcl ? "SUCCESS" : "FAIL") << " with size: " << encodeResult.bitstreamSize
                   << " and offset: " << encodeResult.bitstreamStartOffset
@@ -615,6 +702,10 @@ VkResult VkVideoEncoder::InitEncoder(VkSharedBaseObj<EncoderConfig>& encoderConf
         if (m_encoderConfig->verboseFrameStruct) {
             m_encoderConfig->gopStructure.DumpFramesGopStructure(0, maxFramesToDump);
         }
+
+        if (m_encoderConfig->gopStructure.GetIntraRefreshPeriod() > 0) {
+            m_encoderConfig->gopStructure.PrintIntraRefreshReport(m_encoderConfig->numFrames);
+        }
     }
 
     if (m_encoderConfig->enableOutOfOrderRecording) {
@@ -640,6 +731,89 @@ VkResult VkVideoEncoder::InitEncoder(VkSharedBaseObj<EncoderConfig>& encoderConf
     m_maxDpbPicturesCount = encoderConfig->InitDpbCount();
 
     encoderConfig->InitRateControl();
+    encoderConfig->InitRateControlLayers();
+
+    if (!encoderConfig->traceFileName.empty()) {
+        VkVideoTracer::Enable(true);
+        VK_VIDEO_TRACE_THREAD_NAME("encoder");
+    }
+
+    if (!encoderConfig->shaderCacheDir.empty()) {
+        VulkanShaderCache::SetCacheDirectory(encoderConfig->shaderCacheDir.c_str());
+    }
+
+    if (encoderConfig->verifyHrd) {
+        uint32_t hrdBitRate = 0, cpbSize = 0, initialCpbDelay = 0;
+        if (encoderConfig->GetHrdBufferParameters(hrdBitRate, cpbSize, initialCpbDelay)) {
+            m_hrdVerifier.Configure(hrdBitRate, cpbSize, initialCpbDelay,
+                                    encoderConfig->frameRateNumerator, encoderConfig->frameRateDenominator,
+                                    (encoderConfig->rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_CBR_BIT_KHR),
+                                    encoderConfig->verbose);
+        } else {
+            fprintf(stderr, "\nInitEncoder Warning: HRD parameters are not available, the HRD verifier is disabled.\n");
+        }
+    }
+
+    if (encoderConfig->input.rgbFormat != VkEncoderRgbConverter::RGB_FORMAT_NONE) {
+        VkEncoderRgbConverter::Config rgbConfig;
+        rgbConfig.width  = std::min(encoderConfig->encodeWidth,  encoderConfig->input.width);
+        rgbConfig.height = std::min(encoderConfig->encodeHeight, encoderConfig->input.height);
+        rgbConfig.rgbFormat = encoderConfig->input.rgbFormat;
+        rgbConfig.outputFormat = (encoderConfig->input.bpp > 8) ? VkEncoderRgbConverter::OUTPUT_P010 :
+                                                                  VkEncoderRgbConverter::OUTPUT_NV12;
+        rgbConfig.colorStandard = encoderConfig->input.rgbColorStandard;
+        rgbConfig.fullRange = encoderConfig->input.rgbFullRange;
+
+        if (!m_rgbConverter.Configure(rgbConfig, encoderConfig->verbose)) {
+            fprintf(stderr, "\nInitEncoder Error: the RGB input converter can't be configured.\n");
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    if (encoderConfig->syntheticInput) {
+        VkEncoderSyntheticSource::Config syntheticConfig = encoderConfig->syntheticSource;
+        syntheticConfig.width  = std::min(encoderConfig->encodeWidth,  encoderConfig->input.width);
+        syntheticConfig.height = std::min(encoderConfig->encodeHeight, encoderConfig->input.height);
+        syntheticConfig.outputFormat = (encoderConfig->input.bpp > 8) ? VkEncoderSyntheticSource::OUTPUT_P010 :
+                                                                        VkEncoderSyntheticSource::OUTPUT_NV12;
+
+        if (!m_syntheticSource.Configure(syntheticConfig, encoderConfig->verbose)) {
+            fprintf(stderr, "\nInitEncoder Error: the synthetic input source can't be configured.\n");
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    if (encoderConfig->lookaheadDepth > 0) {
+        // The GOP structure closes the B-frames ahead of a scene cut, so the
+        // cut must be known before the first of them is encoded.
+        const uint32_t minDepth = VkEncoderLookahead::MOTION_WINDOW +
+                                  encoderConfig->gopStructure.GetConsecutiveBFrameCount() + 1;
+        VkEncoderLookahead::Config lookaheadConfig;
+        lookaheadConfig.width  = std::min(encoderConfig->encodeWidth,  encoderConfig->input.width);
+        lookaheadConfig.height = std::min(encoderConfig->encodeHeight, encoderConfig->input.height);
+        lookaheadConfig.lumaPitch = (uint32_t)encoderConfig->input.planeLayouts[0].rowPitch;
+        lookaheadConfig.bytesPerSample = (encoderConfig->input.bpp + 7) / 8;
+        if (lookaheadConfig.bytesPerSample > 1) {
+            const int32_t shiftBits = (encoderConfig->input.msbShift >= 0) ? encoderConfig->input.msbShift :
+                                                                             (16 - encoderConfig->input.bpp);
+            lookaheadConfig.sampleShift = 8 - shiftBits;
+        }
+        lookaheadConfig.depth = std::max(encoderConfig->lookaheadDepth, minDepth);
+        lookaheadConfig.sceneCutThreshold = encoderConfig->sceneCutThreshold;
+        lookaheadConfig.numThreads = encoderConfig->lookaheadThreads;
+
+        m_lookaheadFrames = encoderConfig->inputFileHandler.GetMappedFramePtrs(encoderConfig->input.fullImageSize,
+                                                                               encoderConfig->numFrames);
+        lookaheadConfig.numFrames = m_lookaheadFrames.size();
+
+        const uint64_t lumaOffset = encoderConfig->input.planeLayouts[0].offset;
+        if ((lookaheadConfig.numFrames == 0) ||
+                !m_lookahead.Configure(lookaheadConfig,
+                                       [this, lumaOffset](uint64_t frameNum) { return m_lookaheadFrames[frameNum] + lumaOffset; },
+                                       encoderConfig->verbose)) {
+            fprintf(stderr, "\nInitEncoder Warning: the lookahead can't be configured, scene cut detection is disabled.\n");
+        }
+    }
 
     VkFormat supportedDpbFormats[8];
     VkFormat supportedInFormats[8];
@@ -685,6 +859,47 @@ VkResult VkVideoEncoder::InitEncoder(VkSharedBaseObj<EncoderConfig>& encoderConf
         m_imageQpMapFormat = supportedQpMapFormats[0];
         m_qpMapTexelSize = supportedQpMapTexelSize[0];
         m_qpMapTiling = supportedQpMapTiling[0];
+
+        if (encoderConfig->qpMapGenerate) {
+            VkEncoderQpMapGenerator::Config qpMapConfig;
+            qpMapConfig.width  = std::min(encoderConfig->encodeWidth,  encoderConfig->input.width);
+            qpMapConfig.height = std::min(encoderConfig->encodeHeight, encoderConfig->input.height);
+            qpMapConfig.lumaPitch = (uint32_t)encoderConfig->input.planeLayouts[0].rowPitch;
+            qpMapConfig.bytesPerSample = (encoderConfig->input.bpp + 7) / 8;
+            if (qpMapConfig.bytesPerSample > 1) {
+                const int32_t shiftBits = (encoderConfig->input.msbShift >= 0) ? encoderConfig->input.msbShift :
+                                                                                 (16 - encoderConfig->input.bpp);
+                qpMapConfig.sampleShift = 8 - shiftBits;
+            }
+            qpMapConfig.texelWidth  = m_qpMapTexelSize.width;
+            qpMapConfig.texelHeight = m_qpMapTexelSize.height;
+            qpMapConfig.mapWidth  = (encoderConfig->encodeWidth  + m_qpMapTexelSize.width  - 1) / m_qpMapTexelSize.width;
+            qpMapConfig.mapHeight = (encoderConfig->encodeHeight + m_qpMapTexelSize.height - 1) / m_qpMapTexelSize.height;
+            qpMapConfig.mapType = (encoderConfig->qpMapMode == EncoderConfig::DELTA_QP_MAP) ? VkEncoderQpMapGenerator::DELTA_QP_MAP :
+                                                                                              VkEncoderQpMapGenerator::EMPHASIS_MAP;
+            qpMapConfig.bytesPerTexel = (uint32_t)getFormatTexelSize(m_imageQpMapFormat);
+            qpMapConfig.activityStrength = encoderConfig->qpMapStrength;
+            qpMapConfig.staticDeltaQp = encoderConfig->qpMapStaticDeltaQp;
+            // The AV1 maps hold delta qindex values, about 4 per H.264 / H.265 QP step
+            qpMapConfig.qpScale = (encoderConfig->codec == VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR) ? 4 : 1;
+            qpMapConfig.minDeltaQp = -(int32_t)encoderConfig->qpMapMaxDeltaQp * qpMapConfig.qpScale;
+            qpMapConfig.maxDeltaQp =  (int32_t)encoderConfig->qpMapMaxDeltaQp * qpMapConfig.qpScale;
+            int32_t minDelta = 0, maxDelta = 0;
+            if (encoderConfig->GetQuantizationMapDeltaRange(minDelta, maxDelta)) {
+                qpMapConfig.minDeltaQp = std::max(qpMapConfig.minDeltaQp, minDelta);
+                qpMapConfig.maxDeltaQp = std::min(qpMapConfig.maxDeltaQp, maxDelta);
+            }
+            qpMapConfig.numThreads = encoderConfig->lookaheadThreads;
+            qpMapConfig.numRois = encoderConfig->qpMapRoiCount;
+            for (uint32_t i = 0; i < encoderConfig->qpMapRoiCount; i++) {
+                qpMapConfig.rois[i] = encoderConfig->qpMapRois[i];
+            }
+
+            if (!m_qpMapGenerator.Configure(qpMapConfig, encoderConfig->verbose)) {
+                fprintf(stderr, "\nInitEncoder Error: the qpMap generator can't be configured.\n");
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+        }
     }
 
     m_maxCodedExtent = { encoderConfig->encodeMaxWidth, encoderConfig->encodeMaxHeight }; // max coded size
@@ -1332,6 +1547,245 @@ void VkVideoEncoder::ProcessQpMap(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encod
     vk::ChainNextVkStruct(encodeFrameInfo->encodeInfo, encodeFrameInfo->quantizationMapInfo);
 }
 
+VkResult VkVideoEncoder::SetRateControl(uint32_t averageBitrate, uint32_t maxBitrate, uint32_t cpbSize)
+{
+    if ((maxBitrate != 0) && (averageBitrate > maxBitrate)) {
+        fprintf(stderr, "SetRateControl: the average bitrate %u is higher than the max bitrate %u\n",
+                averageBitrate, maxBitrate);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    std::lock_guard<std::mutex> lock(m_reconfigureMutex);
+    m_reconfigureRequest.flags |= RECONFIGURE_RATE_CONTROL;
+    m_reconfigureRequest.averageBitrate = averageBitrate;
+    m_reconfigureRequest.maxBitrate = maxBitrate;
+    m_reconfigureRequest.cpbSize = cpbSize;
+
+    return VK_SUCCESS;
+}
+
+VkResult VkVideoEncoder::SetFrameRate(uint32_t frameRateNumerator, uint32_t frameRateDenominator)
+{
+    if ((frameRateNumerator == 0) || (frameRateDenominator == 0)) {
+        fprintf(stderr, "SetFrameRate: invalid frame rate %u/%u\n", frameRateNumerator, frameRateDenominator);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    std::lock_guard<std::mutex> lock(m_reconfigureMutex);
+    m_reconfigureRequest.flags |= RECONFIGURE_FRAME_RATE;
+    m_reconfigureRequest.frameRateNumerator = frameRateNumerator;
+    m_reconfigureRequest.frameRateDenominator = frameRateDenominator;
+
+    return VK_SUCCESS;
+}
+
+VkResult VkVideoEncoder::SetQualityLevel(uint32_t qualityLevel)
+{
+    if (qualityLevel >= m_encoderConfig->videoEncodeCapabilities.maxQualityLevels) {
+        fprintf(stderr, "SetQualityLevel: quality level %u is not supported, the maximum is %u\n",
+                qualityLevel, m_encoderConfig->videoEncodeCapabilities.maxQualityLevels - 1);
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    std::lock_guard<std::mutex> lock(m_reconfigureMutex);
+    m_reconfigureRequest.flags |= RECONFIGURE_QUALITY_LEVEL;
+    m_reconfigureRequest.qualityLevel = qualityLevel;
+
+    return VK_SUCCESS;
+}
+
+VkResult VkVideoEncoder::RequestIdrFrame()
+{
+    std::lock_guard<std::mutex> lock(m_reconfigureMutex);
+    m_reconfigureRequest.flags |= RECONFIGURE_IDR;
+
+    return VK_SUCCESS;
+}
+
+VkResult VkVideoEncoder::ApplyReconfiguration(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo)
+{
+    ReconfigureRequest request;
+    {
+        std::lock_guard<std::mutex> lock(m_reconfigureMutex);
+        request = m_reconfigureRequest;
+        m_reconfigureRequest = ReconfigureRequest();
+    }
+
+    if (request.flags == 0) {
+        return VK_SUCCESS;
+    }
+
+    bool updateRateControl = false;
+
+    if ((request.flags & RECONFIGURE_FRAME_RATE) != 0) {
+        m_encoderConfig->frameRateNumerator = request.frameRateNumerator;
+        m_encoderConfig->frameRateDenominator = request.frameRateDenominator;
+        updateRateControl = true;
+    }
+
+    if ((request.flags & RECONFIGURE_RATE_CONTROL) != 0) {
+        if (m_encoderConfig->UpdateRateControl(request.averageBitrate, request.maxBitrate, request.cpbSize)) {
+            updateRateControl = true;
+        } else {
+            fprintf(stderr, "\nApplyReconfiguration Warning: the rate control can't be changed at frame %llu.\n",
+                    (unsigned long long)encodeFrameInfo->frameInputOrderNum);
+        }
+    }
+
+    if (((request.flags & RECONFIGURE_QUALITY_LEVEL) != 0) &&
+            (request.qualityLevel != m_encoderConfig->qualityLevel)) {
+
+        m_encoderConfig->qualityLevel = request.qualityLevel;
+
+        // The session parameters must match the quality level they are used with
+        VkResult result = InitVideoSessionParameters();
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "\nApplyReconfiguration Error: Failed to create the session parameters for quality level %u.\n",
+                    request.qualityLevel);
+            return result;
+        }
+
+        m_sendQualityLevelCmd = true;
+        // The implementation may have adjusted its rate control state to the previous quality level
+        updateRateControl = true;
+    }
+
+    if (updateRateControl) {
+
+        VkResult result = LoadRateControlParameters();
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+
+        m_sendRateControlCmd = true;
+
+        if (m_hrdVerifier.IsEnabled()) {
+            uint32_t hrdBitRate = 0, cpbSize = 0, initialCpbDelay = 0;
+            if (m_encoderConfig->GetHrdBufferParameters(hrdBitRate, cpbSize, initialCpbDelay)) {
+                encodeFrameInfo->hrdRateUpdate.bitRate = hrdBitRate;
+                encodeFrameInfo->hrdRateUpdate.cpbSize = cpbSize;
+                encodeFrameInfo->hrdRateUpdate.frameRateNumerator = m_encoderConfig->frameRateNumerator;
+                encodeFrameInfo->hrdRateUpdate.frameRateDenominator = m_encoderConfig->frameRateDenominator;
+            }
+        }
+
+        if (m_encoderConfig->verbose) {
+            std::cout << "Reconfigured at frame " << encodeFrameInfo->frameInputOrderNum
+                      << ": average bitrate " << m_encoderConfig->totalBitrate
+                      << ", frame rate " << m_encoderConfig->frameRateNumerator << "/" << m_encoderConfig->frameRateDenominator
+                      << ", quality level " << m_encoderConfig->qualityLevel << std::endl;
+        }
+    }
+
+    if (m_sendQualityLevelCmd || m_sendRateControlCmd) {
+        m_sendControlCmd = true;
+    }
+
+    if ((request.flags & RECONFIGURE_IDR) != 0) {
+        m_gopState.idrRequested = true;
+    }
+
+    return VK_SUCCESS;
+}
+
+VkResult VkVideoEncoder::CreateVideoSessionParameters(VkVideoSessionParametersCreateInfoKHR* pCreateInfo)
+{
+    VkVideoEncodeQualityLevelInfoKHR qualityLevelInfo = { VK_STRUCTURE_TYPE_VIDEO_ENCODE_QUALITY_LEVEL_INFO_KHR };
+    qualityLevelInfo.qualityLevel = m_encoderConfig->qualityLevel;
+
+    VkBaseOutStructure* pStruct = (VkBaseOutStructure*)pCreateInfo;
+    while (pStruct->pNext != nullptr) {
+        pStruct = pStruct->pNext;
+    }
+    pStruct->pNext = (VkBaseOutStructure*)&qualityLevelInfo;
+
+    VkVideoSessionParametersKHR sessionParameters;
+    VkResult result = m_vkDevCtx->CreateVideoSessionParametersKHR(*m_vkDevCtx,
+                                                                  pCreateInfo,
+                                                                  nullptr,
+                                                                  &sessionParameters);
+    pStruct->pNext = nullptr;
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "\nEncodeFrame Error: Failed to get create video session parameters.\n");
+        return result;
+    }
+
+    result = VulkanVideoSessionParameters::Create(m_vkDevCtx, m_videoSession,
+                                                  sessionParameters, m_videoSessionParameters);
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "\nEncodeFrame Error: Failed to get create video session object.\n");
+        return result;
+    }
+
+    // The implementation overrides may differ with the new session parameters
+    m_parameterSetsHeader.clear();
+
+    return VK_SUCCESS;
+}
+
+VkResult VkVideoEncoder::SetCachedParameterSetsHeader(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo,
+                                                      const VkVideoEncodeSessionParametersGetInfoKHR& getInfo,
+                                                      void* pCodecFeedbackInfo,
+                                                      const std::function<bool(std::vector<uint8_t>& header)>& writeHeader)
+{
+    if (m_parameterSetsHeader.empty()) {
+
+        VkVideoEncodeSessionParametersFeedbackInfoKHR feedbackInfo = {
+            VK_STRUCTURE_TYPE_VIDEO_ENCODE_SESSION_PARAMETERS_FEEDBACK_INFO_KHR,
+            pCodecFeedbackInfo,
+        };
+
+        // Without a data pointer, only the size and the overrides feedback are returned
+        size_t driverHeaderSize = 0;
+        VkResult result = m_vkDevCtx->GetEncodedVideoSessionParametersKHR(*m_vkDevCtx, &getInfo, &feedbackInfo,
+                                                                          &driverHeaderSize, nullptr);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+
+        std::vector<uint8_t> header;
+        const bool cpuHeader = (feedbackInfo.hasOverrides == VK_FALSE) && writeHeader(header);
+        bool useDriverHeader = !cpuHeader;
+
+        if (useDriverHeader || m_encoderConfig->verifyParameterSets) {
+            std::vector<uint8_t> driverHeader(driverHeaderSize);
+            result = m_vkDevCtx->GetEncodedVideoSessionParametersKHR(*m_vkDevCtx, &getInfo, &feedbackInfo,
+                                                                     &driverHeaderSize, driverHeader.data());
+            if (result != VK_SUCCESS) {
+                return result;
+            }
+            driverHeader.resize(driverHeaderSize);
+
+            if (cpuHeader && (header != driverHeader)) {
+                fprintf(stderr, "\nWarning: the parameter sets written on the CPU (%zu bytes) differ from the implementation's "
+                                "(%zu bytes), the implementation's are used.\n", header.size(), driverHeader.size());
+                useDriverHeader = true;
+            }
+            if (useDriverHeader) {
+                header.swap(driverHeader);
+            }
+        }
+
+        if (header.empty() || (header.size() > sizeof(encodeFrameInfo->bitstreamHeaderBuffer))) {
+            fprintf(stderr, "\nEncodeFrame Error: Invalid parameter sets size %zu.\n", header.size());
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+
+        if (m_encoderConfig->verbose) {
+            std::cout << "Parameter sets: " << header.size() << " bytes, from the "
+                      << (useDriverHeader ? "implementation" : "CPU writer")
+                      << (feedbackInfo.hasOverrides ? " (overridden Std parameters)" : "") << std::endl;
+        }
+
+        m_parameterSetsHeader.swap(header);
+    }
+
+    memcpy(encodeFrameInfo->bitstreamHeaderBuffer, m_parameterSetsHeader.data(), m_parameterSetsHeader.size());
+    encodeFrameInfo->bitstreamHeaderBufferSize = m_parameterSetsHeader.size();
+
+    return VK_SUCCESS;
+}
+
 VkResult VkVideoEncoder::HandleCtrlCmd(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo)
 {
     m_sendControlCmd = false;
@@ -1380,8 +1834,11 @@ VkResult VkVideoEncoder::HandleCtrlCmd(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
         }
 
         encodeFrameInfo->rateControlInfo.pLayers = encodeFrameInfo->rateControlLayersInfo;
-        encodeFrameInfo->rateControlInfo.layerCount = 3;
-        m_beginRateControlInfo = encodeFrameInfo->rateControlInfo;
+        // The layers are only used by the CBR and VBR modes
+        const bool useLayers = ((m_rateControlInfo.rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_CBR_BIT_KHR) ||
+                                (m_rateControlInfo.rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_VBR_BIT_KHR));
+        assert(m_rateControlLayerCount <= ARRAYSIZE(m_rateControlLayersInfo));
+        encodeFrameInfo->rateControlInfo.layerCount = useLayers ? m_rateControlLayerCount : 0;
 
         if (pNext != nullptr) {
             if (encodeFrameInfo->rateControlInfo.pNext == nullptr) {
@@ -1398,6 +1855,77 @@ VkResult VkVideoEncoder::HandleCtrlCmd(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
     return VK_SUCCESS;
 }
 
+void VkVideoEncoder::RateControlState::Save(const VkBaseInStructure* pControlCmdChain)
+{
+    const VkVideoEncodeRateControlInfoKHR* pRateControlInfo = nullptr;
+    const VkBaseInStructure* pCodecRateControlInfo = nullptr;
+
+    for (const VkBaseInStructure* pStruct = pControlCmdChain; pStruct != nullptr; pStruct = pStruct->pNext) {
+        switch (pStruct->sType) {
+        case VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_INFO_KHR:
+            pRateControlInfo = (const VkVideoEncodeRateControlInfoKHR*)pStruct;
+            break;
+        case VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_INFO_KHR:
+        case VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_INFO_KHR:
+        case VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_INFO_KHR:
+            pCodecRateControlInfo = pStruct;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (pRateControlInfo == nullptr) {
+        return;
+    }
+
+    rateControlInfo = *pRateControlInfo;
+    rateControlInfo.pNext = nullptr;
+    rateControlInfo.layerCount = std::min(pRateControlInfo->layerCount, (uint32_t)ARRAYSIZE(rateControlLayersInfo));
+    rateControlInfo.pLayers = (rateControlInfo.layerCount > 0) ? rateControlLayersInfo : nullptr;
+
+    for (uint32_t layerIndx = 0; layerIndx < rateControlInfo.layerCount; layerIndx++) {
+        rateControlLayersInfo[layerIndx] = pRateControlInfo->pLayers[layerIndx];
+        const VkBaseInStructure* pCodecLayer = (const VkBaseInStructure*)rateControlLayersInfo[layerIndx].pNext;
+        rateControlLayersInfo[layerIndx].pNext = nullptr;
+        if (pCodecLayer == nullptr) {
+            continue;
+        }
+        switch (pCodecLayer->sType) {
+        case VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_LAYER_INFO_KHR:
+            codecRateControlLayersInfo[layerIndx].h264 = *(const VkVideoEncodeH264RateControlLayerInfoKHR*)pCodecLayer;
+            break;
+        case VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_LAYER_INFO_KHR:
+            codecRateControlLayersInfo[layerIndx].h265 = *(const VkVideoEncodeH265RateControlLayerInfoKHR*)pCodecLayer;
+            break;
+        case VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_LAYER_INFO_KHR:
+            codecRateControlLayersInfo[layerIndx].av1 = *(const VkVideoEncodeAV1RateControlLayerInfoKHR*)pCodecLayer;
+            break;
+        default:
+            continue;
+        }
+        // All the codec layer structures start with sType and pNext
+        codecRateControlLayersInfo[layerIndx].h264.pNext = nullptr;
+        rateControlLayersInfo[layerIndx].pNext = &codecRateControlLayersInfo[layerIndx];
+    }
+
+    if (pCodecRateControlInfo != nullptr) {
+        switch (pCodecRateControlInfo->sType) {
+        case VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_INFO_KHR:
+            codecRateControlInfo.h264 = *(const VkVideoEncodeH264RateControlInfoKHR*)pCodecRateControlInfo;
+            break;
+        case VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_INFO_KHR:
+            codecRateControlInfo.h265 = *(const VkVideoEncodeH265RateControlInfoKHR*)pCodecRateControlInfo;
+            break;
+        default:
+            codecRateControlInfo.av1 = *(const VkVideoEncodeAV1RateControlInfoKHR*)pCodecRateControlInfo;
+            break;
+        }
+        codecRateControlInfo.h264.pNext = nullptr;
+        rateControlInfo.pNext = &codecRateControlInfo;
+    }
+}
+
 VkResult VkVideoEncoder::RecordVideoCodingCmd(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo,
                                               uint32_t frameIdx, uint32_t ofTotalFrames)
 {
@@ -1452,12 +1980,12 @@ VkResult VkVideoEncoder::RecordVideoCodingCmd(VkSharedBaseObj<VkVideoEncodeFrame
     const uint32_t numQuerySamples = 1;
     vkDevCtx->CmdResetQueryPool(cmdBuf, queryPool, querySlotId, numQuerySamples);
 
-    if (encodeFrameInfo->controlCmd != VkVideoCodingControlFlagsKHR())
-    {
-        m_beginRateControlInfo = {VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_INFO_KHR, NULL};
+    if ((encodeFrameInfo->controlCmd & VK_VIDEO_CODING_CONTROL_RESET_BIT_KHR) != 0) {
+        // The session is reset to the default rate control state within this scope
+        m_beginRateControlState.Reset();
     }
 
-    encodeBeginInfo.pNext = &m_beginRateControlInfo;
+    encodeBeginInfo.pNext = &m_beginRateControlState.rateControlInfo;
 
     vkDevCtx->CmdBeginVideoCodingKHR(cmdBuf, &encodeBeginInfo);
 
@@ -1468,8 +1996,9 @@ VkResult VkVideoEncoder::RecordVideoCodingCmd(VkSharedBaseObj<VkVideoEncodeFrame
                                                           encodeFrameInfo->controlCmd};
         vkDevCtx->CmdControlVideoCodingKHR(cmdBuf, &renderControlInfo);
 
-        m_beginRateControlInfo = *(VkVideoEncodeRateControlInfoKHR*)encodeFrameInfo->pControlCmdChain;
-        ((VkBaseInStructure*)(m_beginRateControlInfo.pNext))->pNext = NULL;
+        if ((encodeFrameInfo->controlCmd & VK_VIDEO_CODING_CONTROL_ENCODE_RATE_CONTROL_BIT_KHR) != 0) {
+            m_beginRateControlState.Save(encodeFrameInfo->pControlCmdChain);
+        }
     }
 
     if (m_videoMaintenance1FeaturesSupported)
@@ -1522,6 +2051,7 @@ VkResult VkVideoEncoder::SubmitVideoCodingCmds(VkSharedBaseObj<VkVideoEncodeFram
 
     assert(encodeFrameInfo);
     assert(encodeFrameInfo->encodeCmdBuffer != nullptr);
+    VK_VIDEO_TRACE_SCOPE("encode", "SubmitVideoCodingCmds", encodeFrameInfo->frameInputOrderNum);
 
     // If we are processing the input staging, wait for it's semaphore
     // to be done before processing the input frame with the encoder.
@@ -1696,6 +2226,32 @@ int32_t VkVideoEncoder::DeinitEncoder()
 
     m_vkDevCtx->MultiThreadedQueueWaitIdle(VulkanDeviceContext::ENCODE, 0);
 
+    m_hrdVerifier.PrintReport();
+
+    if (m_lookahead.IsEnabled()) {
+        m_lookahead.PrintReport();
+        m_lookahead.Stop();
+    }
+
+    if (m_qpMapGenerator.IsEnabled()) {
+        m_qpMapGenerator.PrintReport();
+        m_qpMapGenerator.Stop();
+    }
+
+    if (m_rgbConverter.IsEnabled()) {
+        m_rgbConverter.PrintReport();
+        m_rgbConverter.Stop();
+    }
+
+    if (m_syntheticSource.IsEnabled()) {
+        m_syntheticSource.PrintReport();
+        m_syntheticSource.Stop();
+    }
+
+    if (m_encoderConfig && !m_encoderConfig->traceFileName.empty()) {
+        VkVideoTracer::WriteChromeTrace(m_encoderConfig->traceFileName.c_str());
+    }
+
     m_linearInputImagePool = nullptr;
     m_inputImagePool       = nullptr;
     m_dpbImagePool         = nullptr;
@@ -1715,6 +2271,7 @@ int32_t VkVideoEncoder::DeinitEncoder()
 void VkVideoEncoder::ConsumerThread()
 {
    std::cout << "ConsumerThread is stating now.\n" << std::endl;
+   VK_VIDEO_TRACE_THREAD_NAME("encoder consumer");
    do {
        VkSharedBaseObj<VkVideoEncodeFrameInfo> encodeFrameInfo;
        bool success = m_encoderThreadQueue.WaitAndPop(encodeFrameInfo);
@@ -1722,6 +2279,7 @@ void VkVideoEncoder::ConsumerThread()
            std::cout << "==>>>> Consumed: " << (uint32_t)encodeFrameInfo->gopPosition.inputOrder
                       << ", Order: " << (uint32_t)encodeFrameInfo->gopPosition.encodeOrder << std::endl << std::flush;
 
+           VK_VIDEO_TRACE_SCOPE("encode", "ConsumerThread", encodeFrameInfo->frameInputOrderNum);
            VkResult result;
            if (!m_encoderConfig->enableOutOfOrderRecording) {
                result = ProcessOrderedFrames(encodeFrameInfo, 0);
@@ -18,8 +18,12 @@
 #define _VKVIDEOENCODER_VKVIDEOENCODER_H_
 
 #include <assert.h>
+#include <string.h>
 #include <thread>
 #include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
 #include "VkCodecUtils/VkVideoRefCountBase.h"
 #include "VkVideoEncoderDef.h"
 #include "VkVideoEncoder/VkEncoderConfig.h"
@@ -35,6 +39,11 @@
 #include "VkCodecUtils/VkThreadSafeQueue.h"
 #include "VkEncoderDpbH264.h"
 #include "VkEncoderDpbAV1.h"
+#include "VkVideoEncoder/VkEncoderHrdVerifier.h"
+#include "VkVideoEncoder/VkEncoderLookahead.h"
+#include "VkVideoEncoder/VkEncoderQpMapGenerator.h"
+#include "VkVideoEncoder/VkEncoderRgbConverter.h"
+#include "VkVideoEncoder/VkEncoderSyntheticSource.h"
 #ifdef ENCODER_DISPLAY_QUEUE_SUPPORT
 #include "VkCodecUtils/VulkanVideoEncodeDisplayQueue.h"
 #include "VkShell/Shell.h"
@@ -61,6 +70,18 @@ public:
                     VK_STRUCTURE_TYPE_VIDEO_ENCODE_INFO_KHR : ((VkBaseInStructure*)encodeInfo.pNext)->sType;
         }
 
+        // Appends non-VCL data, such as SEI messages, after the parameter sets
+        // already in bitstreamHeaderBuffer.
+        bool AppendBitstreamHeader(const uint8_t* pData, size_t size) {
+            const size_t offset = bitstreamHeaderOffset + bitstreamHeaderBufferSize;
+            if ((offset + size) > sizeof(bitstreamHeaderBuffer)) {
+                return false;
+            }
+            memcpy(bitstreamHeaderBuffer + offset, pData, size);
+            bitstreamHeaderBufferSize += size;
+            return true;
+        }
+
         VkVideoEncodeFrameInfo(const void* pNext = nullptr)
             : encodeInfo{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_INFO_KHR, pNext}
             , quantizationMapInfo()
@@ -75,6 +96,7 @@ public:
             , bitstreamHeaderBuffer{}
             , constQp()
             , qualityLevel()
+            , lookaheadComplexity(1.0f)
             , islongTermReference(false)
             , sendControlCmd(false)
             , sendResetControlCmd(false)
@@ -87,8 +109,10 @@ public:
             , qualityLevelInfo { VK_STRUCTURE_TYPE_VIDEO_ENCODE_QUALITY_LEVEL_INFO_KHR }
             , rateControlInfo { VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_INFO_KHR }
             , rateControlLayersInfo{{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR },
+                { VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR },
                 { VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR },
                 { VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR }}
+            , hrdRateUpdate()
             , referenceSlotsInfo{}
             , setupReferenceSlotInfo{ VK_STRUCTURE_TYPE_VIDEO_REFERENCE_SLOT_INFO_KHR }
             , videoSession()
@@ -129,6 +153,7 @@ public:
         uint8_t                                            bitstreamHeaderBuffer[MAX_BITSTREAM_HEADER_BUFFER_SIZE];
         ConstQpSettings                                    constQp;
         uint32_t                                           qualityLevel;
+        float                                              lookaheadComplexity;         // motion of the frame relative to its shot, 1.0: average
         uint32_t                                           islongTermReference : 1;
         uint32_t                                           sendControlCmd      : 1;
         uint32_t                                           sendResetControlCmd : 1;
@@ -140,7 +165,8 @@ public:
         VkBaseInStructure *                                pControlCmdChain;
         VkVideoEncodeQualityLevelInfoKHR                   qualityLevelInfo;
         VkVideoEncodeRateControlInfoKHR                    rateControlInfo;
-        VkVideoEncodeRateControlLayerInfoKHR               rateControlLayersInfo[3];
+        VkVideoEncodeRateControlLayerInfoKHR               rateControlLayersInfo[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
+        VkEncoderHrdVerifier::RateUpdate                   hrdRateUpdate;               // applied to the HRD verifier in decode order
         VkVideoReferenceSlotInfoKHR                        referenceSlotsInfo[MAX_IMAGE_REF_RESOURCES];
         VkVideoReferenceSlotInfoKHR                        setupReferenceSlotInfo;
         VkSharedBaseObj<VulkanVideoSession>                videoSession;
@@ -267,6 +293,7 @@ public:
             bitstreamHeaderBufferSize = 0;
             bitstreamHeaderOffset = 0;
             qualityLevel = 0;
+            lookaheadComplexity = 1.0f;
             islongTermReference = false;
             sendControlCmd = false;
             sendResetControlCmd = false;
@@ -275,11 +302,13 @@ public:
             lastFrame = false;
             controlCmd = VkVideoCodingControlFlagsKHR();
             pControlCmdChain = nullptr;
+            hrdRateUpdate = VkEncoderHrdVerifier::RateUpdate();
             assert(qualityLevelInfo.sType == VK_STRUCTURE_TYPE_VIDEO_ENCODE_QUALITY_LEVEL_INFO_KHR);
             assert(rateControlInfo.sType == VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_INFO_KHR);
             assert(rateControlLayersInfo[0].sType == VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR);
             assert(rateControlLayersInfo[1].sType == VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR);
             assert(rateControlLayersInfo[2].sType == VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR);
+            assert(rateControlLayersInfo[3].sType == VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR);
             assert(referenceSlotsInfo[0].sType == VK_STRUCTURE_TYPE_VIDEO_REFERENCE_SLOT_INFO_KHR);
             assert(setupReferenceSlotInfo.sType == VK_STRUCTURE_TYPE_VIDEO_REFERENCE_SLOT_INFO_KHR);
 
@@ -430,6 +459,7 @@ public:
         , m_encodeEncodeFrameNum(0)
         , m_videoSession()
         , m_videoSessionParameters()
+        , m_parameterSetsHeader()
         , m_imageDpbFormat()
         , m_imageInFormat()
         , m_maxCodedExtent()
@@ -438,8 +468,11 @@ public:
         , m_streamBufferSize(m_minStreamBufferSize)
         , m_rateControlInfo{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_INFO_KHR }
         , m_rateControlLayersInfo{{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR },
             { VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR },
             { VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_LAYER_INFO_KHR }}
+        , m_rateControlLayerCount(1)
+        , m_beginRateControlState()
         , m_picIdxToDpb{}
         , m_gopState()
         , m_dpbSlotsMask(0)
@@ -478,6 +511,14 @@ public:
         , m_qpMapTiling()
         , m_linearQpMapImagePool()
         , m_qpMapImagePool()
+        , m_qpMapGenerator()
+        , m_hrdVerifier()
+        , m_lookaheadFrames()
+        , m_lookahead()
+        , m_rgbConverter()
+        , m_syntheticSource()
+        , m_reconfigureMutex()
+        , m_reconfigureRequest()
     { }
 
     // Factory Function
@@ -521,7 +562,7 @@ public:
 
     virtual VkResult InitEncoderCodec(VkSharedBaseObj<EncoderConfig>& encoderConfig) = 0; // Must be implemented by the codec
     VkResult LoadNextFrame(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo);
-    VkResult LoadNextQpMapFrameFromFile(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo);
+    VkResult LoadNextQpMapFrame(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo);
     VkResult StageInputFrame(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo);
     VkResult StageInputFrameQpMap(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo,
                                   VkCommandBuffer cmdBuf = VK_NULL_HANDLE);
@@ -553,6 +594,16 @@ public:
 
     virtual VkResult InitRateControl(VkCommandBuffer cmdBuf, uint32_t qp) = 0; // Must be implemented by the codec
 
+    // Runtime reconfiguration. These can be called from any thread while encoding: the
+    // requests are merged and applied at the next frame boundary, before the picture type
+    // of that frame is decided. Bitrates are in bits/sec and the CPB size in bits, a value
+    // of 0 keeps the current setting.
+    VkResult SetRateControl(uint32_t averageBitrate, uint32_t maxBitrate = 0, uint32_t cpbSize = 0);
+    VkResult SetFrameRate(uint32_t frameRateNumerator, uint32_t frameRateDenominator);
+    VkResult SetQualityLevel(uint32_t qualityLevel);
+    // The IDR is inserted at the first frame that does not split a group of B-frames.
+    VkResult RequestIdrFrame();
+
     const uint8_t* setPlaneOffset(const uint8_t* pFrameData, size_t bufferSize, size_t &currentReadOffset);
 
     bool WaitForThreadsToComplete();
@@ -562,6 +613,29 @@ protected:
     // Called by the InitEncoderCodec to initialize the common encoder code.
     VkResult InitEncoder(VkSharedBaseObj<EncoderConfig>& encoderConfig);
 
+    // (Re)loads m_rateControlInfo, m_rateControlLayersInfo, m_rateControlLayerCount and the
+    // codec-specific rate control structures from the encoder configuration.
+    virtual VkResult LoadRateControlParameters() = 0; // Must be implemented by the codec
+    // (Re)creates m_videoSessionParameters for the current configuration and quality level.
+    virtual VkResult InitVideoSessionParameters() = 0; // Must be implemented by the codec
+    // Creates m_videoSessionParameters with the quality level of the encoder configuration
+    // chained to pCreateInfo.
+    VkResult CreateVideoSessionParameters(VkVideoSessionParametersCreateInfoKHR* pCreateInfo);
+
+    // Sets the bitstreamHeaderBuffer of the frame to the parameter sets / sequence header of the
+    // session parameters. They are written on the CPU by writeHeader() from the Std structures on
+    // the first call after the session parameters are (re)created, and reused until then. The
+    // implementation's encoding is used instead when it overrides some of the Std parameters, or
+    // with --verifyParameterSets when it differs from the CPU one. pCodecFeedbackInfo, the codec
+    // specific feedback struct if there is one, is chained to the implementation's feedback.
+    VkResult SetCachedParameterSetsHeader(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo,
+                                          const VkVideoEncodeSessionParametersGetInfoKHR& getInfo,
+                                          void* pCodecFeedbackInfo,
+                                          const std::function<bool(std::vector<uint8_t>& header)>& writeHeader);
+
+    // Applies the pending Set*() / RequestIdrFrame() requests, called for each input frame.
+    VkResult ApplyReconfiguration(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo);
+
     VkDeviceSize GetBitstreamBuffer(VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer);
 
     VkImageLayout TransitionImageLayout(VkCommandBuffer cmdBuf,
@@ -663,6 +737,40 @@ protected:
                        int32_t frameIdx = -1, uint32_t ofTotalFrames = 0) const;
 
     typedef VkThreadSafeQueue<VkSharedBaseObj<VkVideoEncodeFrameInfo>> EncoderFrameQueue;
+
+    // The rate control state last set with vkCmdControlVideoCodingKHR, which has to be
+    // specified again in VkVideoBeginCodingInfoKHR of the following video coding scopes.
+    // The frame that carried the control command is recycled, so the structures are copied.
+    struct RateControlState {
+        VkVideoEncodeRateControlInfoKHR          rateControlInfo;
+        VkVideoEncodeRateControlLayerInfoKHR     rateControlLayersInfo[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
+        union {
+            VkVideoEncodeH264RateControlInfoKHR  h264;
+            VkVideoEncodeH265RateControlInfoKHR  h265;
+            VkVideoEncodeAV1RateControlInfoKHR   av1;
+        }                                        codecRateControlInfo;
+        union {
+            VkVideoEncodeH264RateControlLayerInfoKHR  h264;
+            VkVideoEncodeH265RateControlLayerInfoKHR  h265;
+            VkVideoEncodeAV1RateControlLayerInfoKHR   av1;
+        }                                        codecRateControlLayersInfo[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
+
+        RateControlState()
+        {
+            Reset();
+        }
+
+        // The default rate control state of a session after a reset.
+        void Reset()
+        {
+            rateControlInfo = VkVideoEncodeRateControlInfoKHR();
+            rateControlInfo.sType = VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_INFO_KHR;
+        }
+
+        // Copies the rate control structures of a control command chain.
+        void Save(const VkBaseInStructure* pControlCmdChain);
+    };
+
 private:
     std::atomic<int32_t> refCount;
 protected:
@@ -673,6 +781,7 @@ protected:
     uint64_t                                      m_encodeEncodeFrameNum;
     VkSharedBaseObj<VulkanVideoSession>           m_videoSession;
     VkSharedBaseObj<VulkanVideoSessionParameters> m_videoSessionParameters;
+    std::vector<uint8_t>                          m_parameterSetsHeader; // of m_videoSessionParameters, empty until the next IDR
     VkFormat                              m_imageDpbFormat;
     VkFormat                              m_imageInFormat;
     VkExtent2D                            m_maxCodedExtent;
@@ -681,8 +790,9 @@ protected:
     size_t                                m_streamBufferSize;
     VkVideoEncodeQualityLevelInfoKHR      m_qualityLevelInfo;
     VkVideoEncodeRateControlInfoKHR       m_rateControlInfo;
-    VkVideoEncodeRateControlInfoKHR       m_beginRateControlInfo;
-    VkVideoEncodeRateControlLayerInfoKHR  m_rateControlLayersInfo[3];
+    VkVideoEncodeRateControlLayerInfoKHR  m_rateControlLayersInfo[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
+    uint32_t                              m_rateControlLayerCount; // used with the CBR and VBR modes only
+    RateControlState                      m_beginRateControlState;
     int8_t   m_picIdxToDpb[17]; // MAX_DPB_SLOTS + 1
     VkVideoGopStructure::GopState         m_gopState;
     uint32_t m_dpbSlotsMask;
@@ -724,6 +834,33 @@ protected:
     VkImageTiling                            m_qpMapTiling;
     VkSharedBaseObj<VulkanVideoImagePool>    m_linearQpMapImagePool;
     VkSharedBaseObj<VulkanVideoImagePool>    m_qpMapImagePool;
+    VkEncoderQpMapGenerator                  m_qpMapGenerator;   // with --qpMapGenerate, instead of the qpMap file
+
+    VkEncoderHrdVerifier                     m_hrdVerifier;
+    std::vector<const uint8_t*>              m_lookaheadFrames;  // the input frames, read by the lookahead workers
+    VkEncoderLookahead                       m_lookahead;
+    VkEncoderRgbConverter                    m_rgbConverter;     // with a packed RGB --inputFormat
+    VkEncoderSyntheticSource                 m_syntheticSource;  // with --syntheticInput, instead of the input file
+
+    enum ReconfigureFlags {
+        RECONFIGURE_RATE_CONTROL  = (1 << 0),
+        RECONFIGURE_FRAME_RATE    = (1 << 1),
+        RECONFIGURE_QUALITY_LEVEL = (1 << 2),
+        RECONFIGURE_IDR           = (1 << 3),
+    };
+
+    struct ReconfigureRequest {
+        uint32_t flags;             // ReconfigureFlags
+        uint32_t averageBitrate;
+        uint32_t maxBitrate;
+        uint32_t cpbSize;
+        uint32_t frameRateNumerator;
+        uint32_t frameRateDenominator;
+        uint32_t qualityLevel;
+    };
+
+    std::mutex                               m_reconfigureMutex;
+    ReconfigureRequest                       m_reconfigureRequest;
 };
 
 VkResult CreateVideoEncoderH264(const VulkanDeviceContext* vkDevCtx,
@@ -16,7 +16,9 @@
 
 #include <chrono>
 #include "VkVideoEncoder/VkVideoEncoderAV1.h"
+#include "VkVideoEncoder/VkEncoderHeaderWriter.h"
 #include "VkVideoCore/VulkanVideoCapabilities.h"
+#include "VkCodecUtils/VkVideoTracer.h"
 #include "av1/ratectrl_rtc.h"
 
 
@@ -132,65 +134,88 @@ VkResult VkVideoEncoderAV1::InitEncoderCodec(VkSharedBaseObj<EncoderConfig>& enc
     assert(m_dpbAV1);
     m_dpbAV1->DpbSequenceStart(m_encoderConfig, m_maxDpbPicturesCount);
 
-    m_encoderConfig->GetRateControlParameters(&m_rateControlInfo, m_rateControlLayersInfo, &m_stateAV1.m_rateControlInfoAV1, m_stateAV1.m_rateControlLayersInfoAV1);
+    m_encoderConfig->InitSequenceHeader(&m_stateAV1.m_sequenceHeader, &m_stateAV1.m_colorConfig);
+
+    result = InitVideoSessionParameters();
+    if (result != VK_SUCCESS) {
+        return result;
+    }
 
-    m_encoderConfig->InitSequenceHeader(&m_stateAV1.m_sequenceHeader);
+    return LoadRateControlParameters();
+}
+
+VkResult VkVideoEncoderAV1::InitVideoSessionParameters()
+{
+    m_stateAV1.m_operatingPointsCount = m_encoderConfig->InitOperatingPoints(m_stateAV1.m_operatingPointsInfo,
+                                                                             ARRAYSIZE(m_stateAV1.m_operatingPointsInfo));
 
     VideoSessionParametersInfoAV1 videoSessionParametersInfo(*m_videoSession, &m_stateAV1.m_sequenceHeader,
                                                           nullptr/*decoderModelInfo*/,
-                                                          1, nullptr /*operatingPointsInfo*/,
-                                                          encoderConfig->enableQpMap, m_qpMapTexelSize);
+                                                          m_stateAV1.m_operatingPointsCount,
+                                                          m_stateAV1.m_operatingPointsInfo,
+                                                          m_encoderConfig->enableQpMap, m_qpMapTexelSize);
     VkVideoSessionParametersCreateInfoKHR* encodeSessionParametersCreateInfo = videoSessionParametersInfo.getVideoSessionParametersInfo();
-    VkVideoSessionParametersKHR sessionParameters;
-    result = m_vkDevCtx->CreateVideoSessionParametersKHR(*m_vkDevCtx,
-                                                         encodeSessionParametersCreateInfo,
-                                                         nullptr,
-                                                         &sessionParameters);
-    if (result != VK_SUCCESS) {
-        fprintf(stderr, "\nEncodeFrame Error: Failed to get create video session parameters.\n");
-        return result;
-    }
 
-    result = VulkanVideoSessionParameters::Create(m_vkDevCtx, m_videoSession,
-                                                  sessionParameters, m_videoSessionParameters);
-    if (result != VK_SUCCESS) {
-        fprintf(stderr, "\nEncodeFrame Error: Failed to get create video session object.\n");
-        return result;
-    }
-    
-    if (m_rateControlInfo.rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR) {
-        uint32_t min_q = 2;
-        uint32_t max_q = 35;
+    return CreateVideoSessionParameters(encodeSessionParametersCreateInfo);
+}
 
-        if (m_encoderConfig->minQp >= 0) {
-            min_q = (uint32_t)m_encoderConfig->minQp;
-        }
-        if (m_encoderConfig->maxQp >= 0) {
-            max_q = (uint32_t)m_encoderConfig->maxQp;
+void VkVideoEncoderAV1::GetAomRateControlConfig(aom::AV1RateControlRtcConfig& rtc_cfg)
+{
+    uint32_t min_q = 2;
+    uint32_t max_q = 35;
+
+    if (m_encoderConfig->minQp >= 0) {
+        min_q = (uint32_t)m_encoderConfig->minQp;
+    }
+    if (m_encoderConfig->maxQp >= 0) {
+        max_q = (uint32_t)m_encoderConfig->maxQp;
+    }
+
+    rtc_cfg.width = m_encoderConfig->encodeWidth;
+    rtc_cfg.height = m_encoderConfig->encodeHeight;
+    rtc_cfg.is_screen = false;
+    rtc_cfg.max_quantizer = std::min(m_encoderConfig->maxQIndex.intraQIndex, max_q);
+    rtc_cfg.min_quantizer = std::max(m_encoderConfig->minQIndex.intraQIndex, min_q);
+    rtc_cfg.target_bandwidth = m_encoderConfig->totalBitrate;
+    rtc_cfg.undershoot_pct = m_encoderConfig->undershoot_pct;
+    rtc_cfg.overshoot_pct = m_encoderConfig->overshoot_pct;
+    rtc_cfg.max_inter_bitrate_pct = 150;
+    rtc_cfg.max_intra_bitrate_pct = 150;
+    rtc_cfg.framerate = (double)m_encoderConfig->frameRateNumerator / m_encoderConfig->frameRateDenominator;
+    rtc_cfg.ss_number_layers = 1;
+    rtc_cfg.ts_number_layers = m_encoderConfig->gopStructure.GetTemporalLayerCount();
+    if (m_encoderConfig->gopStructure.GetTemporalLayerCount() > 1) {
+        // LIBAOM uses cumulative bitrates
+        uint32_t layerTargetBitrate = 0;
+        for (int i = 0; i < m_encoderConfig->gopStructure.GetTemporalLayerCount(); i++) {
+            layerTargetBitrate += m_encoderConfig->layerConfigs[i].averageBitrate;
+            rtc_cfg.layer_target_bitrate[i]= layerTargetBitrate;
+            rtc_cfg.ts_rate_decimator[i] = m_encoderConfig->layerConfigs[i].frameRateDecimator;
+            rtc_cfg.max_quantizers[i] = rtc_cfg.max_quantizer;
+            rtc_cfg.min_quantizers[i] = rtc_cfg.min_quantizer;
         }
+    }
+}
+
+VkResult VkVideoEncoderAV1::LoadRateControlParameters()
+{
+    m_encoderConfig->GetRateControlParameters(&m_rateControlInfo, m_rateControlLayersInfo, &m_stateAV1.m_rateControlInfoAV1, m_stateAV1.m_rateControlLayersInfoAV1);
+    m_rateControlLayerCount = m_encoderConfig->gopStructure.GetTemporalLayerCount();
+
+    if (m_rateControlInfo.rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR) {
 
         aom::AV1RateControlRtcConfig rtc_cfg;
-        rtc_cfg.width = m_encoderConfig->encodeWidth;
-        rtc_cfg.height = m_encoderConfig->encodeHeight;
-        rtc_cfg.is_screen = false;
-        rtc_cfg.max_quantizer = std::min(m_encoderConfig->maxQIndex.intraQIndex, max_q);
-        rtc_cfg.min_quantizer = std::max(m_encoderConfig->minQIndex.intraQIndex, min_q);
-        rtc_cfg.target_bandwidth = m_encoderConfig->totalBitrate;
-        rtc_cfg.undershoot_pct = m_encoderConfig->undershoot_pct;
-        rtc_cfg.overshoot_pct = m_encoderConfig->overshoot_pct;
-        rtc_cfg.max_inter_bitrate_pct = 150;
-        rtc_cfg.max_intra_bitrate_pct = 150;
-        rtc_cfg.framerate = (double)m_encoderConfig->frameRateNumerator / m_encoderConfig->frameRateDenominator;
-        rtc_cfg.ss_number_layers = 1;
-        rtc_cfg.ts_number_layers = m_encoderConfig->gopStructure.GetTemporalLayerCount();
-        if (m_encoderConfig->gopStructure.GetTemporalLayerCount() == 3) {
-            for (int i = 0; i < 3; i++) {
-                rtc_cfg.layer_target_bitrate[i]= m_encoderConfig->layerConfigs[i].averageBitrate;
-                rtc_cfg.ts_rate_decimator[i] = m_encoderConfig->layerConfigs[i].frameRateDecimator;
-                rtc_cfg.max_quantizers[i] = rtc_cfg.max_quantizer;
-                rtc_cfg.min_quantizers[i] = rtc_cfg.min_quantizer;
+        GetAomRateControlConfig(rtc_cfg);
+
+        if (m_aom_rtc) {
+            // Runtime reconfiguration, keep the rate control history
+            if (!m_aom_rtc->UpdateRateControl(rtc_cfg)) {
+                fprintf(stderr, "\nLoadRateControlParameters Error: Failed to update the AV1 RC.\n");
+                return VK_ERROR_INITIALIZATION_FAILED;
             }
+            return VK_SUCCESS;
         }
+
         if (m_encoderConfig->verbose) {
             std::cout << "Creating AV1 RC with config: (" << rtc_cfg.width << "x" << rtc_cfg.height
                       << ", minQ: " << rtc_cfg.min_quantizer << ", maxQ: " << rtc_cfg.max_quantizer
@@ -222,25 +247,18 @@ VkResult VkVideoEncoderAV1::EncodeVideoSessionParameters(VkSharedBaseObj<VkVideo
         *pFrameInfo->videoSessionParameters
     };
 
-    VkVideoEncodeSessionParametersFeedbackInfoKHR feedbackInfo = {
-        VK_STRUCTURE_TYPE_VIDEO_ENCODE_SESSION_PARAMETERS_FEEDBACK_INFO_KHR,
-        nullptr,
-    };
-
-    size_t bufferSize = sizeof(encodeFrameInfo->bitstreamHeaderBuffer);
-    VkResult result = m_vkDevCtx->GetEncodedVideoSessionParametersKHR(*m_vkDevCtx,
-                                                                      &getInfo,
-                                                                      &feedbackInfo,
-                                                                      &bufferSize,
-                                                                      encodeFrameInfo->bitstreamHeaderBuffer);
-    if (result != VK_SUCCESS) {
-        return result;
-    }
-    encodeFrameInfo->bitstreamHeaderBufferSize = bufferSize;
-
-    return result;
-
+    // The session parameters don't have a decoder model info, see InitVideoSessionParameters().
+    // AV1 has no codec specific session parameters feedback.
+    return SetCachedParameterSetsHeader(encodeFrameInfo, getInfo, nullptr,
+                                        [this](std::vector<uint8_t>& header) {
+                                            return VkEncoderHeaderWriter::AppendAv1SequenceHeader(&m_stateAV1.m_sequenceHeader,
+                                                                                                  nullptr,
+                                                                                                  m_stateAV1.m_operatingPointsCount,
+                                                                                                  m_stateAV1.m_operatingPointsInfo,
+                                                                                                  header);
+                                        });
 }
+
 VkResult VkVideoEncoderAV1::StartOfVideoCodingEncodeOrder(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo, uint32_t frameIdx, uint32_t ofTotalFrames)
 {
     VkVideoEncodeFrameInfoAV1* pFrameInfo = GetEncodeFrameInfoAV1(encodeFrameInfo);
@@ -337,6 +355,10 @@ VkResult VkVideoEncoderAV1::ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
             else if (pFrameInfo->gopPosition.temporalLayer == 1) {
                 flags = 1 << STD_VIDEO_AV1_REFERENCE_NAME_GOLDEN_FRAME;
             }
+            else if ((pFrameInfo->gopPosition.temporalLayer > 1) && pFrameInfo->bIsReference) {
+                // The referenced frames of the third layer of 4 keep their own buffer
+                flags = 1 << STD_VIDEO_AV1_REFERENCE_NAME_ALTREF2_FRAME;
+            }
         }
     }
     StdVideoAV1ReferenceName refName = m_dpbAV1->AssignReferenceFrameType(pFrameInfo->gopPosition.pictureType, flags, pFrameInfo->bIsReference);
@@ -1017,6 +1039,7 @@ VkResult VkVideoEncoderAV1::SubmitVideoCodingCmds(VkSharedBaseObj<VkVideoEncodeF
 VkResult VkVideoEncoderAV1::AssembleBitstreamData(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo,
                                                   uint32_t frameIdx, uint32_t ofTotalFrames)
 {
+    VK_VIDEO_TRACE_SCOPE("encode", "AssembleBitstreamData", encodeFrameInfo->frameInputOrderNum);
     VkVideoEncodeFrameInfoAV1* pFrameInfo = GetEncodeFrameInfoAV1(encodeFrameInfo);
 
     if (pFrameInfo->bShowExistingFrame) {
@@ -1087,6 +1110,9 @@ VkResult VkVideoEncoderAV1::AssembleBitstreamData(VkSharedBaseObj<VkVideoEncodeF
         m_aom_rtc->PostEncodeUpdate(encodeResult.bitstreamSize);
     }
 
+    // A rate control change is accounted for from the first frame of the temporal unit that carries it
+    m_hrdVerifier.UpdateRate(encodeFrameInfo->hrdRateUpdate);
+
     m_batchFramesIndxSetToAssemble.insert(frameIdx);
 
     if (flushFrameData) {
@@ -1133,6 +1159,8 @@ VkResult VkVideoEncoderAV1::AssembleBitstreamData(VkSharedBaseObj<VkVideoEncodeF
                        << std::endl << std::flush;
         }
 
+        m_hrdVerifier.VerifyAccessUnit(encodeFrameInfo->frameEncodeEncodeOrderNum, framesSize);
+
         encodeFrameInfo->inputTimeStamp = std::chrono::duration_cast<std::chrono::milliseconds>(
                                           std::chrono::high_resolution_clock::now().time_since_epoch())
                                                   .count();
@@ -1218,6 +1246,8 @@ void VkVideoEncoderAV1::WriteShowExistingFrameHeader(VkSharedBaseObj<VkVideoEnco
 
     // IVF frame header
     size_t frameSize = 2 + header.size() + payload.size(); /* 2 is temporal delimiter size */
+    m_hrdVerifier.UpdateRate(encodeFrameInfo->hrdRateUpdate);
+    m_hrdVerifier.VerifyAccessUnit(encodeFrameInfo->frameEncodeEncodeOrderNum, frameSize);
     uint64_t pts = encodeFrameInfo->inputTimeStamp;
     uint8_t frameHeader[12];
     mem_put_le32(frameHeader    , (uint32_t)frameSize); // updated with correct size lateron
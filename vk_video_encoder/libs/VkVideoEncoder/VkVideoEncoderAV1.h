@@ -48,7 +48,7 @@ public:
         StdVideoEncodeAV1ReferenceInfo stdReferenceInfo[STD_VIDEO_AV1_REFS_PER_FRAME];
         VkVideoEncodeAV1DpbSlotInfoKHR dpbSlotInfo[STD_VIDEO_AV1_REFS_PER_FRAME];
         VkVideoEncodeAV1RateControlInfoKHR rateControlInfoAV1;
-        VkVideoEncodeAV1RateControlLayerInfoKHR rateControlLayersInfoAV1[3];
+        VkVideoEncodeAV1RateControlLayerInfoKHR rateControlLayersInfoAV1[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
 
         VkVideoEncodeFrameInfoAV1()
             : VkVideoEncodeFrameInfo(&pictureInfo)
@@ -68,6 +68,7 @@ public:
             , bIsReference{}
             , rateControlInfoAV1{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_INFO_KHR }
             , rateControlLayersInfoAV1{{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_LAYER_INFO_KHR },
+                { VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_LAYER_INFO_KHR },
                 { VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_LAYER_INFO_KHR },
                 { VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_LAYER_INFO_KHR }}
         {
@@ -144,6 +145,8 @@ public:
 
     virtual VkResult InitEncoderCodec(VkSharedBaseObj<EncoderConfig>& encoderConfig);
     virtual VkResult InitRateControl(VkCommandBuffer cmdBuf, uint32_t qp);
+    virtual VkResult LoadRateControlParameters();
+    virtual VkResult InitVideoSessionParameters();
     virtual VkResult EncodeVideoSessionParameters(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo);
     virtual VkResult ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo,
                                 uint32_t frameIdx, uint32_t ofTotalframes);
@@ -197,6 +200,7 @@ private:
     void InitializeFrameHeader(StdVideoAV1SequenceHeader* pSequenceHdr, VkVideoEncodeFrameInfoAV1* pFrameInfo,
             StdVideoAV1ReferenceName& refName);
     void DumpFrameInfo(VkVideoEncodeFrameInfoAV1* frame);
+    void GetAomRateControlConfig(aom::AV1RateControlRtcConfig& rtc_cfg);
 
     VkSharedBaseObj<EncoderConfigAV1>   m_encoderConfig;
     EncoderAV1State                     m_stateAV1;
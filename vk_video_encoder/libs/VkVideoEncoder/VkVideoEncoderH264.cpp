@@ -16,6 +16,7 @@
 
 #include "VkVideoEncoder/VkVideoEncoderH264.h"
 #include "VkVideoCore/VulkanVideoCapabilities.h"
+#include "VkVideoEncoder/VkEncoderHeaderWriter.h"
 
 VkResult CreateVideoEncoderH264(const VulkanDeviceContext* vkDevCtx,
                                 VkSharedBaseObj<EncoderConfig>& encoderConfig,
@@ -51,17 +52,45 @@ VkResult VkVideoEncoderH264::InitEncoderCodec(VkSharedBaseObj<EncoderConfig>& en
         return result;
     }
 
+    const uint32_t intraRefreshPeriod = m_encoderConfig->gopStructure.GetIntraRefreshPeriod();
+    if (intraRefreshPeriod > 0) {
+        // The refresh needs one slice per band, with an I slice in a P picture.
+        const uint32_t mbRows = (m_encoderConfig->encodeHeight + 15) / 16;
+        const VkVideoEncodeH264CapabilitiesKHR& caps = m_encoderConfig->h264EncodeCapabilities;
+        if (((caps.flags & VK_VIDEO_ENCODE_H264_CAPABILITY_DIFFERENT_SLICE_TYPE_BIT_KHR) == 0) ||
+                (intraRefreshPeriod > caps.maxSliceCount) ||
+                (intraRefreshPeriod > MAX_NUM_SLICES_H264) || (intraRefreshPeriod > mbRows)) {
+            fprintf(stderr, "\nERROR: An intra refresh period of %u is not supported: %u slice(s) max, %u MB rows%s\n",
+                    intraRefreshPeriod, std::min<uint32_t>(caps.maxSliceCount, MAX_NUM_SLICES_H264), mbRows,
+                    ((caps.flags & VK_VIDEO_ENCODE_H264_CAPABILITY_DIFFERENT_SLICE_TYPE_BIT_KHR) == 0) ?
+                        ", different slice types not supported" : "");
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
     // Initialize DPB
     m_dpb264 = VkEncDpbH264::CreateInstance();
     assert(m_dpb264);
     m_dpb264->DpbSequenceStart(m_maxDpbPicturesCount);
 
-    m_encoderConfig->GetRateControlParameters(&m_rateControlInfo, m_rateControlLayersInfo, &m_h264.m_rateControlInfoH264, m_h264.m_rateControlLayersInfoH264);
+    LoadRateControlParameters();
 
     m_encoderConfig->InitSpsPpsParameters(&m_h264.m_spsInfo, &m_h264.m_ppsInfo,
             m_encoderConfig->InitVuiParameters(&m_h264.m_vuiInfo, &m_h264.m_hrdParameters));
 
+    return InitVideoSessionParameters();
+}
 
+VkResult VkVideoEncoderH264::LoadRateControlParameters()
+{
+    m_encoderConfig->GetRateControlParameters(&m_rateControlInfo, m_rateControlLayersInfo, &m_h264.m_rateControlInfoH264, m_h264.m_rateControlLayersInfoH264);
+    m_rateControlLayerCount = m_encoderConfig->gopStructure.GetTemporalLayerCount();
+
+    return VK_SUCCESS;
+}
+
+VkResult VkVideoEncoderH264::InitVideoSessionParameters()
+{
     // create SPS and PPS set
     VideoSessionParametersInfo videoSessionParametersInfo(*m_videoSession,
                                                           &m_h264.m_spsInfo,
@@ -71,24 +100,8 @@ VkResult VkVideoEncoderH264::InitEncoderCodec(VkSharedBaseObj<EncoderConfig>& en
 
     VkVideoSessionParametersCreateInfoKHR* encodeSessionParametersCreateInfo = videoSessionParametersInfo.getVideoSessionParametersInfo();
     encodeSessionParametersCreateInfo->flags = 0;
-    VkVideoSessionParametersKHR sessionParameters;
-    result = m_vkDevCtx->CreateVideoSessionParametersKHR(*m_vkDevCtx,
-                                                         encodeSessionParametersCreateInfo,
-                                                         nullptr,
-                                                         &sessionParameters);
-    if(result != VK_SUCCESS) {
-        fprintf(stderr, "\nEncodeFrame Error: Failed to get create video session parameters.\n");
-        return result;
-    }
-
-    result = VulkanVideoSessionParameters::Create(m_vkDevCtx, m_videoSession,
-                                                  sessionParameters, m_videoSessionParameters);
-    if(result != VK_SUCCESS) {
-        fprintf(stderr, "\nEncodeFrame Error: Failed to get create video session object.\n");
-        return result;
-    }
 
-    return VK_SUCCESS;
+    return CreateVideoSessionParameters(encodeSessionParametersCreateInfo);
 }
 
 VkResult VkVideoEncoderH264::InitRateControl(VkCommandBuffer cmdBuf, uint32_t qp)
@@ -172,7 +185,8 @@ VkResult VkVideoEncoderH264::SetupRefPicReorderingCommands(const PicInfoH264 *pP
                                                            uint8_t& m_refList0ModOpCount)
 {
     // Either the current picture requires no references, or the active
-    // reference list does not contain corrupted pictures. Skip reordering.
+    // reference list does not contain corrupted pictures or pictures of the
+    // temporal layers it can't reference. Skip reordering.
     if (!m_dpb264->NeedToReorder()) {
         return VK_SUCCESS;
     }
@@ -187,7 +201,8 @@ VkResult VkVideoEncoderH264::SetupRefPicReorderingCommands(const PicInfoH264 *pP
     int numSTR = 0, numLTR = 0;
     m_dpb264->GetNumRefFramesInDPB(0, &numSTR, &numLTR);
 
-    // Re-order the active list to skip all corrupted frames
+    // Re-order the active list to skip all corrupted frames and the frames of the
+    // temporal layers that can't be referenced
     pFlags->ref_pic_list_modification_flag_l0 = true;
     m_refList0ModOpCount = 0;
     if (numSTR) {
@@ -239,6 +254,7 @@ VkResult VkVideoEncoderH264::ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
     pictureInfo.frame_num = m_frameNumSyntax & ((1 << (m_h264.m_spsInfo.log2_max_frame_num_minus4 + 4)) - 1);
     pictureInfo.PicOrderCnt = (encodeFrameInfo->picOrderCntVal) & ((1 << (m_h264.m_spsInfo.log2_max_pic_order_cnt_lsb_minus4 + 4)) - 1);
     pictureInfo.timeStamp = encodeFrameInfo->inputTimeStamp;
+    pictureInfo.temporalLayer = encodeFrameInfo->gopPosition.temporalLayer;
     if (isReference) {
         m_frameNumSyntax++;
     }
@@ -279,7 +295,8 @@ VkResult VkVideoEncoderH264::ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
     uint8_t refList1ModOpCount = 0;
 
     StdVideoEncodeH264ReferenceListsInfoFlags refMgmtFlags = StdVideoEncodeH264ReferenceListsInfoFlags();
-    if ((m_dpb264->IsRefFramesCorrupted()) && ((picType == VkVideoGopStructure::FRAME_TYPE_P) || (picType == VkVideoGopStructure::FRAME_TYPE_B))) {
+    if (((picType == VkVideoGopStructure::FRAME_TYPE_P) || (picType == VkVideoGopStructure::FRAME_TYPE_B)) &&
+        m_dpb264->NeedToReorder()) {
         SetupRefPicReorderingCommands(&pictureInfo, &pFrameInfo->stdSliceHeader, &refMgmtFlags, pFrameInfo->refList0ModOperations, refList0ModOpCount);
     }
 
@@ -298,6 +315,12 @@ VkResult VkVideoEncoderH264::ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
         // do not use multiple references for l0
         pFrameInfo->stdSliceHeader.flags.num_ref_idx_active_override_flag = true;
         pFrameInfo->stdReferenceListsInfo.num_ref_idx_l0_active_minus1 = 0;
+    } else if (refList0ModOpCount > 1) {
+        // Only the reordered pictures are active, the skipped ones follow them in the list.
+        pFrameInfo->stdSliceHeader.flags.num_ref_idx_active_override_flag = true;
+        pFrameInfo->stdReferenceListsInfo.num_ref_idx_l0_active_minus1 =
+            std::min<uint8_t>((uint8_t)(refList0ModOpCount - 2), m_h264.m_ppsInfo.num_ref_idx_l0_default_active_minus1);
+        pFrameInfo->stdReferenceListsInfo.num_ref_idx_l1_active_minus1 = m_h264.m_ppsInfo.num_ref_idx_l1_default_active_minus1;
     }
 
     NvVideoEncodeH264DpbSlotInfoLists<STD_VIDEO_H264_MAX_NUM_LIST_REF> refLists;
@@ -333,7 +356,8 @@ VkResult VkVideoEncoderH264::ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
                                                    &m_h264.m_spsInfo, &pFrameInfo->stdSliceHeader,
                                                    &pFrameInfo->stdReferenceListsInfo, MAX_MEM_MGMNT_CTRL_OPS_COMMANDS);
     if (targetDpbSlot >= VkEncDpbH264::MAX_DPB_SLOTS) {
-        targetDpbSlot = static_cast<int8_t>((encodeFrameInfo->setupImageResource!=nullptr) + refLists.refPicListCount[0] + refLists.refPicListCount[1] + 1);
+        targetDpbSlot = m_dpb264->GetNonReferenceSetupSlot(&pFrameInfo->stdReferenceListsInfo);
+        assert(targetDpbSlot >= 0);
     }
     if (isReference) {
         assert(targetDpbSlot >= 0);
@@ -422,6 +446,26 @@ VkResult VkVideoEncoderH264::ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
 
     assert(m_dpb264->GetNumRefFramesInDPB(0) <= m_h264.m_spsInfo.max_num_ref_frames);
 
+    if ((encodeFrameInfo->gopPosition.flags & VkVideoGopStructure::FLAGS_INTRA_REFRESH) != 0) {
+        // One slice per refresh band, the implementation splits the picture
+        // in raster order. Only the slice of the current band is intra coded.
+        const uint32_t sliceCount = m_encoderConfig->gopStructure.GetIntraRefreshPeriod();
+        assert(sliceCount <= MAX_NUM_SLICES_H264);
+        for (uint32_t sliceIdx = 0; sliceIdx < sliceCount; sliceIdx++) {
+            pFrameInfo->stdSliceHeaders[sliceIdx] = pFrameInfo->stdSliceHeader;
+            pFrameInfo->naluSliceInfos[sliceIdx] = pFrameInfo->naluSliceInfo;
+            pFrameInfo->naluSliceInfos[sliceIdx].pStdSliceHeader = &pFrameInfo->stdSliceHeaders[sliceIdx];
+            if (sliceIdx == encodeFrameInfo->gopPosition.intraRefreshIndex) {
+                pFrameInfo->stdSliceHeaders[sliceIdx].slice_type = STD_VIDEO_H264_SLICE_TYPE_I;
+                if (m_rateControlInfo.rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR) {
+                    pFrameInfo->naluSliceInfos[sliceIdx].constantQp = encodeFrameInfo->constQp.qpIntra;
+                }
+            }
+        }
+        pFrameInfo->pictureInfo.naluSliceEntryCount = sliceCount;
+        pFrameInfo->pictureInfo.pNaluSliceEntries = pFrameInfo->naluSliceInfos;
+    }
+
     return VK_SUCCESS;
 }
 
@@ -454,23 +498,12 @@ VkResult VkVideoEncoderH264::EncodeVideoSessionParameters(VkSharedBaseObj<VkVide
         nullptr,
     };
 
-    VkVideoEncodeSessionParametersFeedbackInfoKHR feedbackInfo = {
-        VK_STRUCTURE_TYPE_VIDEO_ENCODE_SESSION_PARAMETERS_FEEDBACK_INFO_KHR,
-        &h264FeedbackInfo,
-    };
-
-    size_t bufferSize = sizeof(encodeFrameInfo->bitstreamHeaderBuffer);
-    VkResult result = m_vkDevCtx->GetEncodedVideoSessionParametersKHR(*m_vkDevCtx,
-                                                                      &getInfo,
-                                                                      &feedbackInfo,
-                                                                      &bufferSize,
-                                                                      encodeFrameInfo->bitstreamHeaderBuffer);
-    if (result != VK_SUCCESS) {
-        return result;
-    }
-    encodeFrameInfo->bitstreamHeaderBufferSize = bufferSize;
-
-    return result;
+    return SetCachedParameterSetsHeader(encodeFrameInfo, getInfo, &h264FeedbackInfo,
+                                        [this](std::vector<uint8_t>& header) {
+                                            return VkEncoderHeaderWriter::AppendH264ParameterSets(&m_h264.m_spsInfo,
+                                                                                                  &m_h264.m_ppsInfo,
+                                                                                                  header);
+                                        });
 }
 
 VkResult VkVideoEncoderH264::CreateFrameInfoBuffersQueue(uint32_t numPoolNodes)
@@ -574,13 +607,32 @@ VkResult VkVideoEncoderH264::EncodeFrame(VkSharedBaseObj<VkVideoEncodeFrameInfo>
         m_IDRPicId++;
     }
 
-    if (isIdr && (encodeFrameInfo->frameEncodeInputOrderNum == 0)) {
+    // Repeat the SPS and PPS with a requested IDR, the application may start a new stream there
+    if (isIdr && ((encodeFrameInfo->frameEncodeInputOrderNum == 0) ||
+                  ((encodeFrameInfo->gopPosition.flags & VkVideoGopStructure::FLAGS_FORCED_IDR) != 0))) {
         VkResult result = EncodeVideoSessionParameters(encodeFrameInfo);
         if (result != VK_SUCCESS) {
             return result;
         }
     }
 
+    // A decoder may start at the first picture of a refresh wave. The
+    // recovery count assumes that the refreshed bands only predict from the
+    // refreshed area, but the motion vectors are not constrained: a band
+    // refreshed earlier in the wave may be predicted from a band that is not
+    // refreshed yet. The picture at the recovery point is then only an
+    // approximate match, errors from before the wave may remain until the
+    // intra bands of the following waves replace them. Hence
+    // exact_match_flag = 0.
+    if ((encodeFrameInfo->gopPosition.flags & VkVideoGopStructure::FLAGS_RECOVERY_POINT) != 0) {
+        std::vector<uint8_t> sei;
+        VkEncoderHeaderWriter::AppendH264RecoveryPointSei(m_encoderConfig->gopStructure.GetIntraRefreshPeriod() - 1, false, sei);
+        if (!encodeFrameInfo->AppendBitstreamHeader(sei.data(), sei.size())) {
+            fprintf(stderr, "No room for the recovery point SEI of frame %llu\n",
+                    (unsigned long long)encodeFrameInfo->frameInputOrderNum);
+        }
+    }
+
     // XXX: We don't really test encoder state reset at the moment.
     // For simplicity, only indicate that the state is to be reset for the
     // first IDR picture.
@@ -37,13 +37,16 @@ public:
         StdVideoEncodeH264PictureInfo            stdPictureInfo;
         StdVideoEncodeH264SliceHeader            stdSliceHeader;
         VkVideoEncodeH264RateControlInfoKHR      rateControlInfoH264;
-        VkVideoEncodeH264RateControlLayerInfoKHR rateControlLayersInfoH264[1];
+        VkVideoEncodeH264RateControlLayerInfoKHR rateControlLayersInfoH264[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
         StdVideoEncodeH264ReferenceListsInfo     stdReferenceListsInfo;
         StdVideoEncodeH264ReferenceInfo          stdReferenceInfo[MAX_REFFERENCES];
         VkVideoEncodeH264DpbSlotInfoKHR          stdDpbSlotInfo[MAX_REFFERENCES];
         StdVideoEncodeH264RefListModEntry        refList0ModOperations[MAX_REFFERENCES];
         StdVideoEncodeH264RefListModEntry        refList1ModOperations[MAX_REFFERENCES];
         StdVideoEncodeH264RefPicMarkingEntry     refPicMarkingEntry[MAX_MEM_MGMNT_CTRL_OPS_COMMANDS];
+        // The slices of an intra refresh picture, one per refresh band
+        VkVideoEncodeH264NaluSliceInfoKHR        naluSliceInfos[MAX_NUM_SLICES_H264];
+        StdVideoEncodeH264SliceHeader            stdSliceHeaders[MAX_NUM_SLICES_H264];
 
         VkVideoEncodeFrameInfoH264()
           : VkVideoEncodeFrameInfo(&pictureInfo)
@@ -52,13 +55,18 @@ public:
           , stdPictureInfo()
           , stdSliceHeader()
           , rateControlInfoH264{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_INFO_KHR }
-          , rateControlLayersInfoH264 {{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_LAYER_INFO_KHR }}
+          , rateControlLayersInfoH264 {{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_LAYER_INFO_KHR }}
           , stdReferenceListsInfo()
           , stdReferenceInfo{}
           , stdDpbSlotInfo{}
           , refList0ModOperations{}
           , refList1ModOperations{}
           , refPicMarkingEntry{}
+          , naluSliceInfos{}
+          , stdSliceHeaders{}
         {
             pictureInfo.naluSliceEntryCount = 1; // FIXME: support more than one
             pictureInfo.pNaluSliceEntries = &naluSliceInfo;
@@ -91,6 +99,8 @@ public:
             // refList0ModOperations{}
             // refList1ModOperations{}
             // refPicMarkingEntry{}
+            pictureInfo.naluSliceEntryCount = 1;
+            pictureInfo.pNaluSliceEntries = &naluSliceInfo;
         }
 
         virtual ~VkVideoEncodeFrameInfoH264() {
@@ -107,6 +117,8 @@ public:
 
     virtual VkResult InitEncoderCodec(VkSharedBaseObj<EncoderConfig>& encoderConfig);
     virtual VkResult InitRateControl(VkCommandBuffer cmdBuf, uint32_t qp);
+    virtual VkResult LoadRateControlParameters();
+    virtual VkResult InitVideoSessionParameters();
     virtual VkResult EncodeVideoSessionParameters(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo);
     virtual VkResult ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo,
                                 uint32_t frameIdx, uint32_t ofTotalFrames);
@@ -16,6 +16,7 @@
 
 #include "VkVideoEncoder/VkVideoEncoderH265.h"
 #include "VkVideoCore/VulkanVideoCapabilities.h"
+#include "VkVideoEncoder/VkEncoderHeaderWriter.h"
 
 VkResult CreateVideoEncoderH265(const VulkanDeviceContext* vkDevCtx,
                                 VkSharedBaseObj<EncoderConfig>& encoderConfig,
@@ -51,6 +52,23 @@ VkResult VkVideoEncoderH265::InitEncoderCodec(VkSharedBaseObj<EncoderConfig>& en
         return result;
     }
 
+    const uint32_t intraRefreshPeriod = m_encoderConfig->gopStructure.GetIntraRefreshPeriod();
+    if (intraRefreshPeriod > 0) {
+        // The refresh needs one slice segment per band, with an I slice in a P picture.
+        const uint32_t ctbSize = 1U << (m_encoderConfig->cuSize + 3);
+        const uint32_t ctbRows = (m_encoderConfig->encodeHeight + ctbSize - 1) / ctbSize;
+        const VkVideoEncodeH265CapabilitiesKHR& caps = m_encoderConfig->h265EncodeCapabilities;
+        if (((caps.flags & VK_VIDEO_ENCODE_H265_CAPABILITY_DIFFERENT_SLICE_SEGMENT_TYPE_BIT_KHR) == 0) ||
+                (intraRefreshPeriod > caps.maxSliceSegmentCount) ||
+                (intraRefreshPeriod > MAX_NUM_SLICES) || (intraRefreshPeriod > ctbRows)) {
+            fprintf(stderr, "\nERROR: An intra refresh period of %u is not supported: %u slice segment(s) max, %u CTB rows%s\n",
+                    intraRefreshPeriod, std::min<uint32_t>(caps.maxSliceSegmentCount, MAX_NUM_SLICES), ctbRows,
+                    ((caps.flags & VK_VIDEO_ENCODE_H265_CAPABILITY_DIFFERENT_SLICE_SEGMENT_TYPE_BIT_KHR) == 0) ?
+                        ", different slice segment types not supported" : "");
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
     // Initialize DPB
     m_dpb.DpbSequenceStart(m_maxDpbPicturesCount, (m_encoderConfig->numRefL0 > 0));
 
@@ -59,14 +77,26 @@ VkResult VkVideoEncoderH265::InitEncoderCodec(VkSharedBaseObj<EncoderConfig>& en
                   << ", numRefL1: "    << (uint32_t)m_encoderConfig->numRefL1 << std::endl;
     }
 
-    m_encoderConfig->GetRateControlParameters(&m_rateControlInfo, m_rateControlLayersInfo, &m_rateControlInfoH265, m_rateControlLayersInfoH265);
+    LoadRateControlParameters();
 
     m_encoderConfig->InitParamameters(&m_vps, &m_sps, &m_pps,
             m_encoderConfig->InitVuiParameters(&m_sps.vuiInfo,
                                                    &m_sps.hrdParameters,
                                                    &m_sps.subLayerHrdParametersNal));
 
+    return InitVideoSessionParameters();
+}
 
+VkResult VkVideoEncoderH265::LoadRateControlParameters()
+{
+    m_encoderConfig->GetRateControlParameters(&m_rateControlInfo, m_rateControlLayersInfo, &m_rateControlInfoH265, m_rateControlLayersInfoH265);
+    m_rateControlLayerCount = m_encoderConfig->gopStructure.GetTemporalLayerCount();
+
+    return VK_SUCCESS;
+}
+
+VkResult VkVideoEncoderH265::InitVideoSessionParameters()
+{
     VkVideoEncodeH265SessionParametersAddInfoKHR encodeH265SessionParametersAddInfo = {
         VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_SESSION_PARAMETERS_ADD_INFO_KHR};
 
@@ -88,24 +118,7 @@ VkResult VkVideoEncoderH265::InitEncoderCodec(VkSharedBaseObj<EncoderConfig>& en
     encodeSessionParametersCreateInfo.videoSession = *m_videoSession;
     encodeSessionParametersCreateInfo.flags = 0;
 
-    VkVideoSessionParametersKHR sessionParameters;
-    result = m_vkDevCtx->CreateVideoSessionParametersKHR(*m_vkDevCtx,
-                                                         &encodeSessionParametersCreateInfo,
-                                                         nullptr,
-                                                         &sessionParameters);
-    if(result != VK_SUCCESS) {
-        fprintf(stderr, "\nEncodeFrame Error: Failed to get create video session parameters.\n");
-        return result;
-    }
-
-    result = VulkanVideoSessionParameters::Create(m_vkDevCtx, m_videoSession,
-                                                  sessionParameters, m_videoSessionParameters);
-    if(result != VK_SUCCESS) {
-        fprintf(stderr, "\nEncodeFrame Error: Failed to get create video session object.\n");
-        return result;
-    }
-
-    return VK_SUCCESS;
+    return CreateVideoSessionParameters(&encodeSessionParametersCreateInfo);
 }
 
 VkResult VkVideoEncoderH265::InitRateControl(VkCommandBuffer cmdBuf, uint32_t qp)
@@ -132,6 +145,12 @@ VkResult VkVideoEncoderH265::ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
 
         numRefL0 = (numRefL0 == 0) ? 1 : numRefL0;
 
+        // Predict only from the previous picture, so the pictures after a
+        // completed refresh wave never reference a picture from before it.
+        if ((encodeFrameInfo->gopPosition.flags & VkVideoGopStructure::FLAGS_INTRA_REFRESH) != 0) {
+            numRefL0 = 1;
+        }
+
         if (encodeFrameInfo->gopPosition.pictureType == VkVideoGopStructure::FRAME_TYPE_B) {
             numRefL1 = (numRefL1 == 0) ? 1 : numRefL1;
         }
@@ -139,7 +158,8 @@ VkResult VkVideoEncoderH265::ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
 
     m_dpb.ReferencePictureMarking(encodeFrameInfo->picOrderCntVal,
                                   (StdVideoH265PictureType)encodeFrameInfo->gopPosition.pictureType,
-                                  m_sps.sps.flags.long_term_ref_pics_present_flag);
+                                  m_sps.sps.flags.long_term_ref_pics_present_flag,
+                                  (encodeFrameInfo->gopPosition.flags & VkVideoGopStructure::FLAGS_RECOVERY_POINT) != 0);
 
 
     if (!pFrameInfo->stdPictureInfo.flags.no_output_of_prior_pics_flag) {
@@ -205,7 +225,8 @@ VkResult VkVideoEncoderH265::ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
         pFrameInfo->stdPictureInfo.pRefLists = nullptr;
     }
 
-    m_dpb.DpbPictureEnd(encodeFrameInfo->setupImageResource, 1 /* numTemporalLayers */, pFrameInfo->stdPictureInfo.flags.is_reference);
+    m_dpb.DpbPictureEnd(encodeFrameInfo->setupImageResource, m_encoderConfig->gopStructure.GetTemporalLayerCount(),
+                        pFrameInfo->stdPictureInfo.flags.is_reference);
 
     // ***************** Start Update DPB info ************** //
 
@@ -301,6 +322,27 @@ VkResult VkVideoEncoderH265::ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>&
 
     // ***************** End Update DPB info ************** //
 
+    if ((encodeFrameInfo->gopPosition.flags & VkVideoGopStructure::FLAGS_INTRA_REFRESH) != 0) {
+        // One slice segment per refresh band, the implementation splits the
+        // picture in raster order. Only the segment of the current band is intra coded.
+        const uint32_t sliceCount = m_encoderConfig->gopStructure.GetIntraRefreshPeriod();
+        assert(sliceCount <= MAX_NUM_SLICES);
+        for (uint32_t sliceIdx = 0; sliceIdx < sliceCount; sliceIdx++) {
+            pFrameInfo->stdSliceSegmentHeaders[sliceIdx] = pFrameInfo->stdSliceSegmentHeader;
+            pFrameInfo->stdSliceSegmentHeaders[sliceIdx].flags.first_slice_segment_in_pic_flag = (sliceIdx == 0);
+            pFrameInfo->naluSliceSegmentInfos[sliceIdx] = pFrameInfo->naluSliceSegmentInfo;
+            pFrameInfo->naluSliceSegmentInfos[sliceIdx].pStdSliceSegmentHeader = &pFrameInfo->stdSliceSegmentHeaders[sliceIdx];
+            if (sliceIdx == encodeFrameInfo->gopPosition.intraRefreshIndex) {
+                pFrameInfo->stdSliceSegmentHeaders[sliceIdx].slice_type = STD_VIDEO_H265_SLICE_TYPE_I;
+                if (m_rateControlInfo.rateControlMode == VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR) {
+                    pFrameInfo->naluSliceSegmentInfos[sliceIdx].constantQp = encodeFrameInfo->constQp.qpIntra;
+                }
+            }
+        }
+        pFrameInfo->pictureInfo.naluSliceSegmentEntryCount = sliceCount;
+        pFrameInfo->pictureInfo.pNaluSliceSegmentEntries = pFrameInfo->naluSliceSegmentInfos;
+    }
+
     return VK_SUCCESS;
 }
 
@@ -335,23 +377,13 @@ VkResult VkVideoEncoderH265::EncodeVideoSessionParameters(VkSharedBaseObj<VkVide
         nullptr,
     };
 
-    VkVideoEncodeSessionParametersFeedbackInfoKHR sessionParametersFeedbackInfo = {
-        VK_STRUCTURE_TYPE_VIDEO_ENCODE_SESSION_PARAMETERS_FEEDBACK_INFO_KHR,
-        &sessionParametersFeedbackInfoH265,
-    };
-
-    size_t bufferSize = sizeof(encodeFrameInfo->bitstreamHeaderBuffer);
-    VkResult result = m_vkDevCtx->GetEncodedVideoSessionParametersKHR(*m_vkDevCtx,
-                                                                      &sessionParametersGetInfo,
-                                                                      &sessionParametersFeedbackInfo,
-                                                                      &bufferSize,
-                                                                      encodeFrameInfo->bitstreamHeaderBuffer);
-    if (result != VK_SUCCESS) {
-        return result;
-    }
-    encodeFrameInfo->bitstreamHeaderBufferSize = bufferSize;
-
-    return result;
+    return SetCachedParameterSetsHeader(encodeFrameInfo, sessionParametersGetInfo, &sessionParametersFeedbackInfoH265,
+                                        [this](std::vector<uint8_t>& header) {
+                                            return VkEncoderHeaderWriter::AppendH265ParameterSets(&m_vps.vpsInfo,
+                                                                                                  &m_sps.sps,
+                                                                                                  &m_pps,
+                                                                                                  header);
+                                        });
 }
 
 VkResult VkVideoEncoderH265::CreateFrameInfoBuffersQueue(uint32_t numPoolNodes)
@@ -431,7 +463,9 @@ VkResult VkVideoEncoderH265::EncodeFrame(VkSharedBaseObj<VkVideoEncodeFrameInfo>
     // provided offset into the bitstream buffer.
     encodeFrameInfo->encodeInfo.dstBufferOffset = 0; // FIXME: pEncPicParams->bitstreamBufferOffset;
 
-    if (isIdr && (encodeFrameInfo->frameEncodeInputOrderNum == 0 /*|| pEncodeConfigH265->repeatSPSPPS || m_bReconfigForcedIDR*/)) {
+    // Repeat the VPS, SPS and PPS with a requested IDR, the application may start a new stream there
+    if (isIdr && ((encodeFrameInfo->frameEncodeInputOrderNum == 0) ||
+                  ((encodeFrameInfo->gopPosition.flags & VkVideoGopStructure::FLAGS_FORCED_IDR) != 0))) {
 
         result = EncodeVideoSessionParameters(encodeFrameInfo);
         if (result != VK_SUCCESS ) {
@@ -440,6 +474,23 @@ VkResult VkVideoEncoderH265::EncodeFrame(VkSharedBaseObj<VkVideoEncodeFrameInfo>
         }
     }
 
+    // A decoder may start at the first picture of a refresh wave. The
+    // recovery count assumes that the refreshed bands only predict from the
+    // refreshed area, but the motion vectors are not constrained: a band
+    // refreshed earlier in the wave may be predicted from a band that is not
+    // refreshed yet. The picture at the recovery point is then only an
+    // approximate match, errors from before the wave may remain until the
+    // intra bands of the following waves replace them. Hence
+    // exact_match_flag = 0.
+    if ((encodeFrameInfo->gopPosition.flags & VkVideoGopStructure::FLAGS_RECOVERY_POINT) != 0) {
+        std::vector<uint8_t> sei;
+        VkEncoderHeaderWriter::AppendH265RecoveryPointSei((int32_t)m_encoderConfig->gopStructure.GetIntraRefreshPeriod() - 1, false, sei);
+        if (!encodeFrameInfo->AppendBitstreamHeader(sei.data(), sei.size())) {
+            fprintf(stderr, "No room for the recovery point SEI of frame %llu\n",
+                    (unsigned long long)encodeFrameInfo->frameInputOrderNum);
+        }
+    }
+
     StdVideoH265PictureType stdPictureType = STD_VIDEO_H265_PICTURE_TYPE_INVALID;
     StdVideoH265SliceType sliceType = STD_VIDEO_H265_SLICE_TYPE_I;
     switch (encodeFrameInfo->gopPosition.pictureType) {
@@ -511,7 +562,7 @@ VkResult VkVideoEncoderH265::EncodeFrame(VkSharedBaseObj<VkVideoEncodeFrameInfo>
     pFrameInfo->stdPictureInfo.pps_seq_parameter_set_id = m_sps.sps.sps_seq_parameter_set_id;
     pFrameInfo->stdPictureInfo.pps_pic_parameter_set_id = m_pps.pps_pic_parameter_set_id;
     pFrameInfo->stdPictureInfo.PicOrderCntVal = encodeFrameInfo->picOrderCntVal;
-    pFrameInfo->stdPictureInfo.TemporalId = 0;
+    pFrameInfo->stdPictureInfo.TemporalId = (uint8_t)encodeFrameInfo->gopPosition.temporalLayer;
 
 
     if (m_sendControlCmd == true) {
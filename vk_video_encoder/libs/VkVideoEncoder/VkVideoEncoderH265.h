@@ -33,13 +33,16 @@ class VkVideoEncoderH265 : public VkVideoEncoder {
         VkVideoEncodeH265NaluSliceSegmentInfoKHR naluSliceSegmentInfo;
         StdVideoEncodeH265PictureInfo            stdPictureInfo;
         VkVideoEncodeH265RateControlInfoKHR      rateControlInfoH265;
-        VkVideoEncodeH265RateControlLayerInfoKHR rateControlLayersInfoH265[1];
+        VkVideoEncodeH265RateControlLayerInfoKHR rateControlLayersInfoH265[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
         StdVideoEncodeH265SliceSegmentHeader     stdSliceSegmentHeader;
         StdVideoEncodeH265ReferenceListsInfo     stdReferenceListsInfo;
         StdVideoH265ShortTermRefPicSet           stdShortTermRefPicSet;
         StdVideoEncodeH265LongTermRefPics        stdLongTermRefPics;
         StdVideoEncodeH265ReferenceInfo          stdReferenceInfo[MAX_REFFERENCES];
         VkVideoEncodeH265DpbSlotInfoKHR          stdDpbSlotInfo[MAX_REFFERENCES];
+        // The slice segments of an intra refresh picture, one per refresh band
+        VkVideoEncodeH265NaluSliceSegmentInfoKHR naluSliceSegmentInfos[MAX_NUM_SLICES];
+        StdVideoEncodeH265SliceSegmentHeader     stdSliceSegmentHeaders[MAX_NUM_SLICES];
 
         VkVideoEncodeFrameInfoH265()
           : VkVideoEncodeFrameInfo(&pictureInfo)
@@ -47,13 +50,18 @@ class VkVideoEncoderH265 : public VkVideoEncoder {
           , naluSliceSegmentInfo { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_NALU_SLICE_SEGMENT_INFO_KHR }
           , stdPictureInfo()
           , rateControlInfoH265{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_INFO_KHR }
-          , rateControlLayersInfoH265{{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_LAYER_INFO_KHR }}
+          , rateControlLayersInfoH265{{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_LAYER_INFO_KHR }}
           , stdSliceSegmentHeader()
           , stdReferenceListsInfo()
           , stdShortTermRefPicSet()
           , stdLongTermRefPics()
           , stdReferenceInfo{}
           , stdDpbSlotInfo{}
+          , naluSliceSegmentInfos{}
+          , stdSliceSegmentHeaders{}
         {
             pictureInfo.naluSliceSegmentEntryCount = 1;
             pictureInfo.pNaluSliceSegmentEntries = &naluSliceSegmentInfo;
@@ -87,6 +95,8 @@ class VkVideoEncoderH265 : public VkVideoEncoder {
             // stdLongTermRefPics()
             // stdReferenceInfo{}
             // stdDpbSlotInfo{}
+            pictureInfo.naluSliceSegmentEntryCount = 1;
+            pictureInfo.pNaluSliceSegmentEntries = &naluSliceSegmentInfo;
         }
 
         virtual ~VkVideoEncodeFrameInfoH265() {
@@ -103,12 +113,17 @@ public:
         , m_sps{}
         , m_pps{}
         , m_rateControlInfoH265{VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_INFO_KHR}
-        , m_rateControlLayersInfoH265{{VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_LAYER_INFO_KHR}}
+        , m_rateControlLayersInfoH265{{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H265_RATE_CONTROL_LAYER_INFO_KHR }}
         , m_dpb{}
     { }
 
     virtual VkResult InitEncoderCodec(VkSharedBaseObj<EncoderConfig>& encoderConfig);
     virtual VkResult InitRateControl(VkCommandBuffer cmdBuf, uint32_t qp);
+    virtual VkResult LoadRateControlParameters();
+    virtual VkResult InitVideoSessionParameters();
     virtual VkResult EncodeVideoSessionParameters(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo);
     virtual VkResult ProcessDpb(VkSharedBaseObj<VkVideoEncodeFrameInfo>& encodeFrameInfo,
                                 uint32_t frameIdx, uint32_t ofTotalFrames);
@@ -146,7 +161,7 @@ private:
     SpsH265                                    m_sps;
     StdVideoH265PictureParameterSet            m_pps;
     VkVideoEncodeH265RateControlInfoKHR        m_rateControlInfoH265;
-    VkVideoEncodeH265RateControlLayerInfoKHR   m_rateControlLayersInfoH265[1];
+    VkVideoEncodeH265RateControlLayerInfoKHR   m_rateControlLayersInfoH265[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
     VkEncDpbH265                               m_dpb;
     VkSharedBaseObj<VulkanBufferPool<VkVideoEncodeFrameInfoH265>> m_frameInfoBuffersQueue;
 };
@@ -17,6 +17,8 @@
 #ifndef _LIBS_VKVIDEOENCODER_VKVIDEOENCODERSTATEAV1_H_
 #define _LIBS_VKVIDEOENCODER_VKVIDEOENCODERSTATEAV1_H_
 
+#include "VkVideoEncoder/VkVideoTemporalLayers.h"
+
 class VideoSessionParametersInfoAV1 {
 public:
     VideoSessionParametersInfoAV1(VkVideoSessionKHR videoSession,
@@ -69,12 +71,14 @@ struct EncoderAV1State {
 
     EncoderAV1State()
         : m_sequenceHeader()
+        , m_colorConfig()
         , m_timingInfo()
         , m_decoderModelInfo()
         , m_operatingPointsCount()
         , m_operatingPointsInfo()
         , m_rateControlInfoAV1{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_INFO_KHR }
         , m_rateControlLayersInfoAV1{{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_LAYER_INFO_KHR },
             { VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_LAYER_INFO_KHR },
             { VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_LAYER_INFO_KHR }}
         , m_timing_info_present_flag()
@@ -84,12 +88,13 @@ struct EncoderAV1State {
 
 public:
     StdVideoAV1SequenceHeader               m_sequenceHeader;
+    StdVideoAV1ColorConfig                  m_colorConfig;
     StdVideoAV1TimingInfo                   m_timingInfo;
     StdVideoEncodeAV1DecoderModelInfo       m_decoderModelInfo;
     uint32_t                                m_operatingPointsCount;
     StdVideoEncodeAV1OperatingPointInfo     m_operatingPointsInfo[32];
     VkVideoEncodeAV1RateControlInfoKHR      m_rateControlInfoAV1;
-    VkVideoEncodeAV1RateControlLayerInfoKHR m_rateControlLayersInfoAV1[3];
+    VkVideoEncodeAV1RateControlLayerInfoKHR m_rateControlLayersInfoAV1[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
 
     bool m_timing_info_present_flag;
     bool m_decoder_model_info_present_flag;
@@ -17,6 +17,8 @@
 #ifndef _LIBS_VKVIDEOENCODER_VKVIDEOENCODERSTATEH264_H_
 #define _LIBS_VKVIDEOENCODER_VKVIDEOENCODERSTATEH264_H_
 
+#include "VkVideoEncoder/VkVideoTemporalLayers.h"
+
 class VideoSessionParametersInfo {
 public:
     VideoSessionParametersInfo(VkVideoSessionKHR videoSession,
@@ -75,7 +77,10 @@ struct EncoderH264State {
         , m_vuiInfo()
         , m_hrdParameters()
         , m_rateControlInfoH264{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_INFO_KHR }
-        , m_rateControlLayersInfoH264{{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_LAYER_INFO_KHR }}
+        , m_rateControlLayersInfoH264{{ VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_LAYER_INFO_KHR },
+            { VK_STRUCTURE_TYPE_VIDEO_ENCODE_H264_RATE_CONTROL_LAYER_INFO_KHR }}
     {
         m_spsInfo.pSequenceParameterSetVui = &m_vuiInfo;
     }
@@ -86,7 +91,7 @@ public:
     StdVideoH264SequenceParameterSetVui      m_vuiInfo;
     StdVideoH264HrdParameters                m_hrdParameters;
     VkVideoEncodeH264RateControlInfoKHR      m_rateControlInfoH264;
-    VkVideoEncodeH264RateControlLayerInfoKHR m_rateControlLayersInfoH264[1];
+    VkVideoEncodeH264RateControlLayerInfoKHR m_rateControlLayersInfoH264[VkVideoTemporalLayers::MAX_TEMPORAL_LAYERS];
 };
 
 #endif /* _LIBS_VKVIDEOENCODER_VKVIDEOENCODERSTATEH264_H_ */
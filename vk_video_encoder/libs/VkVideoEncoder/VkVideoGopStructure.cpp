@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cmath>
 #include "VkVideoGopStructure.h"
 
 VkVideoGopStructure::VkVideoGopStructure(uint8_t gopFrameCount,
@@ -30,12 +32,19 @@ VkVideoGopStructure::VkVideoGopStructure(uint8_t gopFrameCount,
     , m_lastFrameType(lastFrameType)
     , m_preClosedGopAnchorFrameType(preIdrAnchorFrameType)
     , m_closedGop(closedGop)
+    , m_intraRefreshPeriod(0)
 {
+    m_temporal_layers.SetTemporalLayerCount(temporalLayerCount);
     Init(uint64_t(-1));
 }
 
 bool VkVideoGopStructure::Init(uint64_t maxNumFrames)
 {
+    if (m_intraRefreshPeriod > 0) {
+        // The refresh wave replaces the periodic I and IDR pictures of a low latency P-only GOP
+        m_consecutiveBFrameCount = 0;
+        m_idrPeriod = 0;
+    }
     m_gopFrameCycle = (uint8_t)(m_consecutiveBFrameCount + 1);
     m_gopFrameCount = (uint8_t)std::min<uint64_t>(m_gopFrameCount, maxNumFrames);
     if (m_idrPeriod > 0) {
@@ -87,6 +96,11 @@ void VkVideoGopStructure::DumpFrameGopStructure(GopState& gopState,
               << "\t" << (uint32_t)gopPos.inGop   << ", "
               << "\t" << GetFrameTypeName(gopPos.pictureType);
 
+    if ((gopPos.flags & FLAGS_INTRA_REFRESH) != 0) {
+        std::cout << "\tband " << gopPos.intraRefreshIndex
+                  << (((gopPos.flags & FLAGS_RECOVERY_POINT) != 0) ? ", recovery point" : "");
+    }
+
     std::cout << std::endl;
 }
 
@@ -103,3 +117,67 @@ void VkVideoGopStructure::DumpFramesGopStructure(uint64_t firstFrameNumInInputOr
     DumpFrameGopStructure(gopState, true);
 
 }
+
+void VkVideoGopStructure::PrintIntraRefreshReport(uint64_t numFrames) const
+{
+    if (numFrames == 0) {
+        return;
+    }
+
+    // The share of each picture coded intra, and the frame where a decoder
+    // starting at a random access point gets a fully refreshed picture.
+    std::vector<double> intraShare(numFrames, 0.0);
+    std::vector<uint64_t> cleanFrame(numFrames, uint64_t(-1));
+    GopState gopState;
+    GopPosition gopPos(gopState.positionInInputOrder);
+    uint32_t numRecoveryPoints = 0;
+    for (uint64_t frameNum = 0; frameNum < numFrames; frameNum++) {
+        GetPositionInGOP(gopState, gopPos, (frameNum == 0), (uint32_t)std::min<uint64_t>(numFrames - frameNum, UINT32_MAX));
+        if ((gopPos.pictureType == FRAME_TYPE_IDR) || (gopPos.pictureType == FRAME_TYPE_I)) {
+            intraShare[frameNum] = 1.0;
+            cleanFrame[frameNum] = frameNum;
+        } else if ((gopPos.flags & FLAGS_INTRA_REFRESH) != 0) {
+            intraShare[frameNum] = 1.0 / m_intraRefreshPeriod;
+            if ((gopPos.flags & FLAGS_RECOVERY_POINT) != 0) {
+                cleanFrame[frameNum] = frameNum + m_intraRefreshPeriod - 1;
+                numRecoveryPoints++;
+            }
+        }
+    }
+
+    double sum = 0.0, sumSquares = 0.0, maxShare = 0.0, maxShareInter = 0.0;
+    for (uint64_t frameNum = 0; frameNum < numFrames; frameNum++) {
+        sum += intraShare[frameNum];
+        sumSquares += intraShare[frameNum] * intraShare[frameNum];
+        maxShare = std::max(maxShare, intraShare[frameNum]);
+        if (intraShare[frameNum] < 1.0) {
+            maxShareInter = std::max(maxShareInter, intraShare[frameNum]);
+        }
+    }
+    const double mean = sum / numFrames;
+    const double stdDev = std::sqrt(std::max(0.0, (sumSquares / numFrames) - (mean * mean)));
+
+    // Walk backwards to find, for each frame, the next random access point.
+    uint64_t nextClean = uint64_t(-1);
+    uint64_t maxDelay = 0, sumDelay = 0, numJoinable = 0;
+    for (uint64_t frameNum = numFrames; frameNum-- > 0; ) {
+        if ((cleanFrame[frameNum] != uint64_t(-1)) && (cleanFrame[frameNum] < numFrames)) {
+            nextClean = cleanFrame[frameNum];
+        }
+        if (nextClean != uint64_t(-1)) {
+            maxDelay = std::max(maxDelay, nextClean - frameNum);
+            sumDelay += nextClean - frameNum;
+            numJoinable++;
+        }
+    }
+
+    std::cout << std::endl << "Intra refresh period " << m_intraRefreshPeriod << ", " << numFrames << " frame(s), "
+              << numRecoveryPoints << " recovery point(s)" << std::endl;
+    std::cout << std::fixed << std::setprecision(1)
+              << "  Intra coded share of a picture: mean " << (100.0 * mean) << "%, std dev " << (100.0 * stdDev)
+              << "%, max " << (100.0 * maxShare) << "% (" << (100.0 * maxShareInter) << "% excluding the IDR pictures)"
+              << std::endl;
+    std::cout << "  Frames to a clean picture for a decoder joining the stream: max " << maxDelay << ", mean "
+              << ((numJoinable > 0) ? ((double)sumDelay / numJoinable) : 0.0) << std::endl;
+    std::cout.unsetf(std::ios_base::floatfield);
+}
@@ -39,17 +39,27 @@ public:
     enum Flags { FLAGS_IS_REF         = (1 << 0), // frame is a reference
                  FLAGS_CLOSE_GOP      = (1 << 1), // Last reference in the Gop. Indicates the end of a closed Gop.
                  FLAGS_NONUNIFORM_GOP = (1 << 2), // nonuniform  Gop part of sequence (usually used to terminate Gop).
+                 FLAGS_FORCED_IDR     = (1 << 3), // IDR requested by the application, not by the IDR period.
+                 FLAGS_SCENE_CUT      = (1 << 4), // IDR started at a scene cut found by the lookahead.
+                 FLAGS_INTRA_REFRESH  = (1 << 5), // The band intraRefreshIndex of the picture is coded intra.
+                 FLAGS_RECOVERY_POINT = (1 << 6), // First picture of an intra refresh cycle (recovery point SEI).
                };
 
     struct GopState {
         uint32_t positionInInputOrder;
         uint32_t lastRefInInputOrder;
         uint32_t lastRefInEncodeOrder;
+        bool     idrRequested;  // start a new IDR sequence as soon as no B-frames are pending
+        bool     sceneCutPending;   // a scene cut could not start an IDR sequence yet
+        uint32_t framesToSceneCut;  // distance to the next scene cut from the lookahead, uint32_t(-1) if none
 
         GopState()
         : positionInInputOrder(0)
         , lastRefInInputOrder(0)
-        , lastRefInEncodeOrder(0) {}
+        , lastRefInEncodeOrder(0)
+        , idrRequested(false)
+        , sceneCutPending(false)
+        , framesToSceneCut(uint32_t(-1)) {}
     };
 
     struct GopPosition {
@@ -62,6 +72,7 @@ public:
         uint8_t    temporalLayer; // The temporal layer of the picture
         int32_t    temporalIdx;   // The current index in the temporal pattern
         uint32_t   flags;         // one or multiple of flags of type Flags above
+        uint32_t   intraRefreshIndex; // The band refreshed with FLAGS_INTRA_REFRESH, 0 is the top band
 
         GopPosition(uint32_t positionInGopInInputOrder)
         : inputOrder(positionInGopInInputOrder)
@@ -73,6 +84,7 @@ public:
         , temporalLayer(0)
         , temporalIdx(0)
         , flags(0)
+        , intraRefreshIndex(0)
         {}
     };
 
@@ -120,23 +132,31 @@ public:
     void SetIdrPeriod(uint32_t idrPeriod) { m_idrPeriod = idrPeriod; }
     uint32_t GetIdrPeriod() const { return m_idrPeriod; }
 
+    // intraRefreshPeriod is the number of pictures of an intra refresh cycle, 0 disables intra refresh.
+    // The picture is split in intraRefreshPeriod horizontal bands and each P picture codes the next
+    // band intra, top to bottom. Only the first picture is an IDR, there are no I or B pictures and
+    // the IDR period is infinite. IDRs requested by the application or at scene cuts restart the wave.
+    void SetIntraRefreshPeriod(uint32_t intraRefreshPeriod) { m_intraRefreshPeriod = intraRefreshPeriod; }
+    uint32_t GetIntraRefreshPeriod() const { return m_intraRefreshPeriod; }
+
     // consecutiveBFrameCount is the number of consecutive B frames between I and/or P frames within the GOP.
     void SetConsecutiveBFrameCount(uint8_t consecutiveBFrameCount) { m_consecutiveBFrameCount = consecutiveBFrameCount; }
     uint8_t GetConsecutiveBFrameCount() const { return m_consecutiveBFrameCount; }
 
     // specifies the number of H.264/5 sub-layers that the application intends to use.
-    void SetTemporalLayerCount(uint8_t temporalLayerCount) { 
-        if (temporalLayerCount != 1 && temporalLayerCount != 3) {
+    // The frames are assigned to the layers with the dyadic pattern of that layer count.
+    bool SetTemporalLayerCount(uint8_t temporalLayerCount) {
+        if (!m_temporal_layers.SetTemporalLayerCount(temporalLayerCount)) {
             assert(!"Invalid temporal layer count");
-            return;
-        }
-        if (temporalLayerCount == 1) {
-            m_temporal_layers.SetTemporalLayerCountToOne();
-        }
-        if (temporalLayerCount == 3) {
-            m_temporal_layers.SetTemporalLayerCountToThree();
+            return false;
         }
+        return true;
     }
+    // Custom temporal layer of each frame position, repeated from each I frame.
+    bool SetTemporalPattern(const uint8_t* pLayers, uint32_t patternLength) {
+        return m_temporal_layers.SetTemporalPattern(pLayers, patternLength);
+    }
+    const VkVideoTemporalLayers& GetTemporalLayers() const { return m_temporal_layers; }
     uint8_t GetTemporalLayerCount() const {
         return m_temporal_layers.GetTemporalLayerCount();
     }
@@ -157,6 +177,11 @@ public:
 
     virtual void PrintGopStructure(uint64_t numFrames = uint64_t(-1)) const;
 
+    // Runs the GOP structure over numFrames frames and prints the share of each
+    // picture coded intra, a proxy of the frame size variance, and how many
+    // frames a decoder starting at any frame waits for a fully refreshed picture.
+    void PrintIntraRefreshReport(uint64_t numFrames) const;
+
     uint32_t GetPeriodDelta(const GopState& gopState, uint32_t period) const
     {
         if (period > 0) {
@@ -178,9 +203,31 @@ public:
 
         gopPos = GopPosition(gopState.positionInInputOrder);
 
-        if (firstFrame || ((m_idrPeriod > 0) &&
-                ((gopState.positionInInputOrder % m_idrPeriod) == 0))) {
+        // A requested IDR is only taken right after a reference frame, so that
+        // the B-frames already sent keep their forward anchor. This delays the
+        // IDR by at most consecutiveBFrameCount frames.
+        const bool afterReference = ((gopState.lastRefInInputOrder + 1U) == gopState.positionInInputOrder);
+        const bool forcedIdr = gopState.idrRequested && !firstFrame && afterReference;
+
+        // The B-frames ahead of a scene cut are closed like the ones ahead of
+        // a periodic IDR, so a cut known early enough is taken on its frame.
+        // A late one is taken like a requested IDR.
+        const bool sceneCut = (gopState.sceneCutPending || (gopState.framesToSceneCut == 0)) && !firstFrame;
+        if (sceneCut && !afterReference) {
+            gopState.sceneCutPending = true;
+        }
+
+        if (firstFrame || forcedIdr || (sceneCut && afterReference) ||
+                ((m_idrPeriod > 0) && ((gopState.positionInInputOrder % m_idrPeriod) == 0))) {
 
+            if (forcedIdr) {
+                gopPos.flags |= FLAGS_FORCED_IDR;
+            }
+            if (sceneCut) {
+                gopPos.flags |= FLAGS_SCENE_CUT;
+            }
+            gopState.idrRequested = false;
+            gopState.sceneCutPending = false;
             gopPos.pictureType = FRAME_TYPE_IDR;
             gopPos.inputOrder = 0;  // reset the IDR sequence
             gopPos.flags |= FLAGS_IS_REF | FLAGS_CLOSE_GOP;
@@ -200,7 +247,7 @@ public:
         gopPos.temporalIdx = gopPos.inGop % GetTemporalPatternLength();
         gopPos.temporalLayer = m_temporal_layers.GetTemporalLayer(gopPos.temporalIdx);
 
-        if (gopPos.inGop == 0) {
+        if ((gopPos.inGop == 0) && (m_intraRefreshPeriod == 0)) {
             // This is the start of a new (open or close) GOP.
             gopPos.pictureType = FRAME_TYPE_I;
             if (m_closedGop) {
@@ -225,6 +272,10 @@ public:
                 periodDelta = std::min(periodDelta, GetPeriodDelta(gopState, m_gopFrameCount));
             }
 
+            if (gopState.framesToSceneCut != uint32_t(-1)) { // The scene cut starts a new IDR sequence.
+                periodDelta = std::min(periodDelta, gopState.framesToSceneCut);
+            }
+
             uint32_t refDelta = INT32_MAX;    // the delta of this frame from the last reference. -1 if it is not a B-frame
             if (periodDelta < INT32_MAX) {
                 refDelta = GetRefDelta(gopState, periodDelta);
@@ -274,6 +325,15 @@ public:
             }
             gopState.lastRefInInputOrder  = gopState.positionInInputOrder;
             gopState.lastRefInEncodeOrder = gopPos.encodeOrder;
+
+            // The intra refresh wave restarts with each IDR sequence.
+            if ((m_intraRefreshPeriod > 0) && (gopPos.pictureType == FRAME_TYPE_P)) {
+                gopPos.intraRefreshIndex = (gopState.positionInInputOrder - 1) % m_intraRefreshPeriod;
+                gopPos.flags |= FLAGS_INTRA_REFRESH;
+                if (gopPos.intraRefreshIndex == 0) {
+                    gopPos.flags |= FLAGS_RECOVERY_POINT;
+                }
+            }
         }
 
         gopState.positionInInputOrder++;
@@ -303,6 +363,7 @@ private:
     FrameType             m_lastFrameType;
     FrameType             m_preClosedGopAnchorFrameType;
     uint32_t              m_closedGop : 1;
+    uint32_t              m_intraRefreshPeriod;
     VkVideoTemporalLayers m_temporal_layers;
 };
 #endif /* _VKVIDEOENCODER_VKVIDEOGOPSTRUCTURE_H_ */
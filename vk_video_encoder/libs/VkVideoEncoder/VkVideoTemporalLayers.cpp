@@ -16,30 +16,82 @@
 
 #include "VkVideoTemporalLayers.h"
 
-uint32_t PATTERN[4] = {
-    0, 2, 1, 2
-};
-
-uint32_t PATTERN_LENGTH = 4;
-
 VkVideoTemporalLayers::VkVideoTemporalLayers()
-    : pattern_index_(0)
-{ 
-    SetTemporalLayerCountToOne();
+    : temporal_layer_count_(1)
+    , pattern_index_(0)
+    , pattern_length_(1)
+    , dyadic_(true)
+    , pattern_()
+{
 }
 
-void VkVideoTemporalLayers::SetTemporalLayerCountToOne() {
-    temporal_layer_count_ = 1;
-    pattern_length_ = 1;
+bool VkVideoTemporalLayers::SetTemporalLayerCount(uint8_t temporalLayerCount) {
+    if ((temporalLayerCount < 1) || (temporalLayerCount > MAX_TEMPORAL_LAYERS)) {
+        return false;
+    }
+
+    // The layer of a position is given by its number of trailing zero bits:
+    // the odd positions are in the highest layer, every other one of the
+    // remaining positions in the layer below, and so on down to position 0.
+    const uint32_t patternLength = 1U << (temporalLayerCount - 1);
+    for (uint32_t i = 0; i < patternLength; i++) {
+        uint32_t trailingZeros = 0;
+        if (i == 0) {
+            trailingZeros = temporalLayerCount - 1;
+        } else {
+            while (((i >> trailingZeros) & 1) == 0) {
+                trailingZeros++;
+            }
+        }
+        pattern_[i] = (uint8_t)(temporalLayerCount - 1 - trailingZeros);
+    }
+
+    temporal_layer_count_ = temporalLayerCount;
+    pattern_length_ = patternLength;
+    pattern_index_ = 0;
+    dyadic_ = true;
+    return true;
 }
 
-void VkVideoTemporalLayers::SetTemporalLayerCountToThree() {
-    temporal_layer_count_ = 3;
-    pattern_length_ = PATTERN_LENGTH;
+bool VkVideoTemporalLayers::SetTemporalPattern(const uint8_t* pLayers, uint32_t patternLength) {
+    if ((pLayers == nullptr) || (patternLength < 1) || (patternLength > MAX_PATTERN_LENGTH) || (pLayers[0] != 0)) {
+        return false;
+    }
+
+    uint32_t usedLayers = 0;
+    uint8_t highestLayer = 0;
+    for (uint32_t i = 0; i < patternLength; i++) {
+        if (pLayers[i] >= MAX_TEMPORAL_LAYERS) {
+            return false;
+        }
+        usedLayers |= 1U << pLayers[i];
+        if (pLayers[i] > highestLayer) {
+            highestLayer = pLayers[i];
+        }
+    }
+    if (usedLayers != ((1U << (highestLayer + 1)) - 1)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < patternLength; i++) {
+        pattern_[i] = pLayers[i];
+    }
+    temporal_layer_count_ = highestLayer + 1;
+    pattern_length_ = patternLength;
+    pattern_index_ = 0;
+
+    VkVideoTemporalLayers dyadic;
+    dyadic.SetTemporalLayerCount(temporal_layer_count_);
+    dyadic_ = (dyadic.pattern_length_ == pattern_length_);
+    for (uint32_t i = 0; dyadic_ && (i < pattern_length_); i++) {
+        dyadic_ = (dyadic.pattern_[i] == pattern_[i]);
+    }
+    return true;
 }
 
 uint32_t VkVideoTemporalLayers::GetTemporalLayer(int temporal_idx) const {
-    return PATTERN[temporal_idx];
+    assert((temporal_idx >= 0) && ((uint32_t)temporal_idx < pattern_length_));
+    return pattern_[temporal_idx];
 }
 uint32_t VkVideoTemporalLayers::GetTemporalPatternIdx() const {
     return pattern_index_;
@@ -51,6 +103,16 @@ uint8_t VkVideoTemporalLayers::GetTemporalLayerCount() const {
     return temporal_layer_count_;
 }
 
+uint32_t VkVideoTemporalLayers::GetLayerFrameCount(uint32_t temporalLayer) const {
+    uint32_t frameCount = 0;
+    for (uint32_t i = 0; i < pattern_length_; i++) {
+        if (pattern_[i] <= temporalLayer) {
+            frameCount++;
+        }
+    }
+    return frameCount;
+}
+
 void VkVideoTemporalLayers::BeforeEncode(bool is_keyframe) {
     if (is_keyframe) {
         pattern_index_ = 0;
@@ -59,22 +121,19 @@ void VkVideoTemporalLayers::BeforeEncode(bool is_keyframe) {
     }
 }
 
-bool VkVideoTemporalLayers::CanReference(uint32_t current_temporal_index, uint32_t other_temporal_index) {
-    // we want the following pattern
+bool VkVideoTemporalLayers::CanReference(uint32_t current_temporal_layer, uint32_t other_temporal_layer) {
+    // With 3 layers:
     //     2     2
     //    /     /
     //   /   1-/
-    //  /   /   
+    //  /   /
     // 0-----------0 ....
-    if (current_temporal_index == 3) {
-        return other_temporal_index == 2;
-    } else if (other_temporal_index == 0) {
-        return true;
-    } else {
-        return false;
-    }
+    // A frame only depends on lower layers, which stay decodable when the
+    // higher layers are dropped. Layer 0 chains from the previous layer 0 frame.
+    return (other_temporal_layer < current_temporal_layer) || (other_temporal_layer == 0);
 }
 
 bool VkVideoTemporalLayers::CanBeReferenced(int temporal_idx) const {
-    return PATTERN[temporal_idx] < 2;
+    const uint32_t temporalLayer = GetTemporalLayer(temporal_idx);
+    return (temporalLayer == 0) || ((temporalLayer + 1) < temporal_layer_count_);
 }
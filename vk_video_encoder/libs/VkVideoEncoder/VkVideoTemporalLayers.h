@@ -22,30 +22,53 @@
 #include <atomic>
 #include <bitset>
 
+// Temporal layer assignment of the frames of a low-delay P sequence.
+//
+// The pattern gives the temporal layer of each frame position and repeats
+// from every key frame. The frames of a layer only reference frames of lower
+// layers, or the previous layer 0 frames, and the frames of the highest layer
+// are never referenced: dropping the layers above any given layer leaves a
+// decodable stream at a fraction of the frame rate.
+//
+// The default dyadic pattern of N layers has 2^(N-1) positions, e.g.
+//   2 layers: 0 1
+//   3 layers: 0 2 1 2
+//   4 layers: 0 3 2 3 1 3 2 3
 class VkVideoTemporalLayers {
 
 public:
+    enum { MAX_TEMPORAL_LAYERS = 4 };
+    enum { MAX_PATTERN_LENGTH = 16 };
+
     VkVideoTemporalLayers();
 
-    void SetTemporalLayerCountToOne();
-    void SetTemporalLayerCountToThree();
+    // Selects the dyadic pattern of temporalLayerCount layers.
+    bool SetTemporalLayerCount(uint8_t temporalLayerCount);
+    // Selects a custom pattern. The first position must be layer 0 and
+    // every layer below the highest one of the pattern must be used.
+    bool SetTemporalPattern(const uint8_t* pLayers, uint32_t patternLength);
 
     uint32_t GetTemporalLayer(int temporal_idx) const;
     uint32_t GetTemporalPatternIdx() const;
     uint32_t GetTemporalPatternLength() const;
     uint8_t GetTemporalLayerCount() const;
+    bool IsDyadicPattern() const { return dyadic_; }
+    // Number of the positions of the pattern in the layers up to and including temporalLayer,
+    // the frame rate of the layer being framerate * count / pattern length.
+    uint32_t GetLayerFrameCount(uint32_t temporalLayer) const;
     void BeforeEncode(bool is_keyframe);
 
-    // Returns true if frames of the current temporal layer can reference frames of `other_temporal_layer`
-    static bool CanReference(uint32_t current_temporal_index, uint32_t other_temporal_index);
+    // Returns true if frames of `current_temporal_layer` can reference frames of `other_temporal_layer`
+    static bool CanReference(uint32_t current_temporal_layer, uint32_t other_temporal_layer);
 
-    // Returns true if frames of the current temporal layer can be referenced by future frames
+    // Returns true if the frame at the pattern position `temporal_idx` can be referenced by future frames
     bool CanBeReferenced(int temporal_idx) const;
 
 private:
     uint8_t temporal_layer_count_;
     uint32_t pattern_index_;
     uint32_t pattern_length_;
+    bool dyadic_;
+    uint8_t pattern_[MAX_PATTERN_LENGTH];
 };
 #endif /* _VKVIDEOENCODER_VKVIDEOTEMPORALLAYERS_H_ */
-
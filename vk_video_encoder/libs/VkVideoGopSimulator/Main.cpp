@@ -0,0 +1,229 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "VkVideoGopSimulator.h"
+
+static void PrintHelp(const char* programName)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "Runs the encoder GOP structure and DPB management without a Vulkan device and checks\n"
+            "the references of every picture. The exit code is non-zero if a check fails.\n"
+            "  -c, --codec <name>           h264, h265, av1 or all (default all)\n"
+            "      --frames <n>             Input frames (default 100000)\n"
+            "      --width <w>, --height <h> Picture size (default 1920x1080)\n"
+            "      --gopFrameCount <n>      Frames per GOP (default 16)\n"
+            "      --idrPeriod <n>          Frames between IDR pictures, 0: only the first one (default 0)\n"
+            "      --bFrames <n>            Consecutive B frames (default 0)\n"
+            "      --temporalLayers <n>     Temporal layers, 1 to 4 (default 1)\n"
+            "      --closedGop              No reference across the GOP boundaries\n"
+            "      --intraRefreshPeriod <n> Periodic intra refresh instead of I pictures\n"
+            "      --forcedIdrPeriod <n>    An application IDR request every n frames\n"
+            "      --sceneCutPeriod <n>     A scene cut every n frames, known to the lookahead\n"
+            "      --numRefL0 <n>, --numRefL1 <n> H.265 reference list sizes (default 1)\n"
+            "      --decodedLayers <n>      Check that a decoder of the n lowest temporal layers, which\n"
+            "                               drops the others, has every reference it needs\n"
+            "      --sweep                  Run a set of configurations around the given one, for all\n"
+            "                               the selected codecs, with one line per configuration\n"
+            "      --maxErrors <n>          Errors printed per configuration (default 8)\n"
+            "  -v, --verbose                Print the references of every picture\n"
+            "  -h, --help                   Print this help\n",
+            programName);
+}
+
+static bool RunConfig(const VkVideoGopSimulator::Config& config, bool summaryOnly)
+{
+    VkVideoGopSimulator* pSimulator = VkVideoGopSimulator::Create(config);
+    if (pSimulator == nullptr) {
+        return false;
+    }
+
+    const bool success = pSimulator->Run();
+    if (summaryOnly) {
+        pSimulator->PrintSummary(stdout);
+    } else {
+        pSimulator->PrintReport(stdout);
+    }
+    delete pSimulator;
+
+    return success;
+}
+
+// The GOP structures the encoder accepts: B frames only with one temporal
+// layer, and no B frames or AV1 with the intra refresh.
+static void AddSweepConfigs(const VkVideoGopSimulator::Config& base, std::vector<VkVideoGopSimulator::Config>& configs)
+{
+    static const uint8_t  gopFrameCounts[] = { 8, 16, 30 };
+    static const uint32_t idrPeriods[] = { 0, 60 };
+
+    for (uint32_t g = 0; g < sizeof(gopFrameCounts) / sizeof(gopFrameCounts[0]); g++) {
+        for (uint32_t structure = 0; structure < 7; structure++) {
+            for (uint32_t closedGop = 0; closedGop < 2; closedGop++) {
+                for (uint32_t d = 0; d < sizeof(idrPeriods) / sizeof(idrPeriods[0]); d++) {
+                    VkVideoGopSimulator::Config config = base;
+                    config.gopFrameCount = gopFrameCounts[g];
+                    config.consecutiveBFrameCount = (structure < 4) ? (uint8_t)structure : 0;
+                    config.temporalLayerCount = (structure < 4) ? 1 : (uint8_t)(structure - 2);
+                    config.closedGop = (closedGop != 0);
+                    config.idrPeriod = idrPeriods[d];
+                    configs.push_back(config);
+                    // Every layer drop of the temporal layer structures
+                    for (uint32_t decodedLayerCount = 1; decodedLayerCount < config.temporalLayerCount; decodedLayerCount++) {
+                        VkVideoGopSimulator::Config layerDropConfig = config;
+                        layerDropConfig.decodedLayerCount = decodedLayerCount;
+                        configs.push_back(layerDropConfig);
+                    }
+                }
+            }
+        }
+    }
+
+    // The intra refresh, and the IDR pictures the GOP structure doesn't plan.
+    VkVideoGopSimulator::Config config = base;
+    config.consecutiveBFrameCount = 0;
+    config.temporalLayerCount = 1;
+    config.intraRefreshPeriod = 30;
+    configs.push_back(config);
+    config.intraRefreshPeriod = 8;
+    config.numRefL0 = 2;
+    config.forcedIdrPeriod = 47;
+    configs.push_back(config);
+    config.numRefL0 = base.numRefL0;
+    config.intraRefreshPeriod = 0;
+    config.forcedIdrPeriod = 47;
+    configs.push_back(config);
+    config.consecutiveBFrameCount = 3;
+    configs.push_back(config);
+    config.forcedIdrPeriod = 0;
+    config.sceneCutPeriod = 53;
+    configs.push_back(config);
+    config.consecutiveBFrameCount = 0;
+    config.temporalLayerCount = 3;
+    configs.push_back(config);
+}
+
+int main(int argc, const char** argv)
+{
+    VkVideoGopSimulator::Config config;
+    std::vector<VkVideoCodecOperationFlagBitsKHR> codecs;
+    bool sweep = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1) < argc;
+        if ((arg == "-h") || (arg == "--help")) {
+            PrintHelp(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (((arg == "-c") || (arg == "--codec")) && hasValue) {
+            const std::string codec = argv[++i];
+            if ((codec == "h264") || (codec == "all")) {
+                codecs.push_back(VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR);
+            }
+            if ((codec == "h265") || (codec == "all")) {
+                codecs.push_back(VK_VIDEO_CODEC_OPERATION_ENCODE_H265_BIT_KHR);
+            }
+            if ((codec == "av1") || (codec == "all")) {
+                codecs.push_back(VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR);
+            }
+            if (codecs.empty()) {
+                fprintf(stderr, "Unknown codec %s\n", codec.c_str());
+                return EXIT_FAILURE;
+            }
+        } else if ((arg == "--frames") && hasValue) {
+            config.numFrames = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if ((arg == "--width") && hasValue) {
+            config.width = (uint32_t)std::max(std::atoi(argv[++i]), 16);
+        } else if ((arg == "--height") && hasValue) {
+            config.height = (uint32_t)std::max(std::atoi(argv[++i]), 16);
+        } else if ((arg == "--gopFrameCount") && hasValue) {
+            config.gopFrameCount = (uint8_t)std::min(std::max(std::atoi(argv[++i]), 1), 255);
+        } else if ((arg == "--idrPeriod") && hasValue) {
+            config.idrPeriod = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--bFrames") && hasValue) {
+            config.consecutiveBFrameCount = (uint8_t)std::min(std::max(std::atoi(argv[++i]), 0), 255);
+        } else if ((arg == "--temporalLayers") && hasValue) {
+            config.temporalLayerCount = (uint8_t)std::min(std::max(std::atoi(argv[++i]), 1), 4);
+        } else if (arg == "--closedGop") {
+            config.closedGop = true;
+        } else if ((arg == "--intraRefreshPeriod") && hasValue) {
+            config.intraRefreshPeriod = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--forcedIdrPeriod") && hasValue) {
+            config.forcedIdrPeriod = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--sceneCutPeriod") && hasValue) {
+            config.sceneCutPeriod = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--numRefL0") && hasValue) {
+            config.numRefL0 = (uint32_t)std::min(std::max(std::atoi(argv[++i]), 0), 15);
+        } else if ((arg == "--numRefL1") && hasValue) {
+            config.numRefL1 = (uint32_t)std::min(std::max(std::atoi(argv[++i]), 0), 15);
+        } else if ((arg == "--decodedLayers") && hasValue) {
+            config.decodedLayerCount = (uint32_t)std::min(std::max(std::atoi(argv[++i]), 0), 4);
+        } else if (arg == "--sweep") {
+            sweep = true;
+        } else if ((arg == "--maxErrors") && hasValue) {
+            config.maxReportedErrors = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "-v") || (arg == "--verbose")) {
+            config.verbose = true;
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument %s\n", arg.c_str());
+            PrintHelp(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (codecs.empty()) {
+        codecs.push_back(VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR);
+        codecs.push_back(VK_VIDEO_CODEC_OPERATION_ENCODE_H265_BIT_KHR);
+        codecs.push_back(VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR);
+    }
+
+    std::vector<VkVideoGopSimulator::Config> configs;
+    if (sweep) {
+        AddSweepConfigs(config, configs);
+    } else {
+        configs.push_back(config);
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t numFailed = 0;
+    uint32_t numRuns = 0;
+    for (size_t c = 0; c < codecs.size(); c++) {
+        for (size_t i = 0; i < configs.size(); i++) {
+            configs[i].codec = codecs[c];
+            // The encoder only supports the intra refresh with H.264 and H.265.
+            if (sweep && (configs[i].intraRefreshPeriod > 0) && (codecs[c] == VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR)) {
+                continue;
+            }
+            if (!RunConfig(configs[i], sweep)) {
+                numFailed++;
+            }
+            numRuns++;
+        }
+    }
+    const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (numRuns > 1) {
+        printf("%u of %u configuration(s) failed, %.2f s\n", numFailed, numRuns, elapsedSec);
+    }
+
+    return (numFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
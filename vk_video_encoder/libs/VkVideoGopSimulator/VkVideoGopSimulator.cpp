@@ -0,0 +1,1289 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <stdarg.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "VkVideoGopSimulator.h"
+#include "VkVideoEncoder/VkEncoderConfigH264.h"
+#include "VkVideoEncoder/VkEncoderConfigH265.h"
+#include "VkVideoEncoder/VkEncoderConfigAV1.h"
+#include "VkVideoEncoder/VkEncoderDpbH264.h"
+#include "VkVideoEncoder/VkEncoderDpbH265.h"
+#include "VkVideoEncoder/VkEncoderDpbAV1.h"
+
+static void InitEncoderConfig(EncoderConfig* pEncoderConfig, VkVideoCodecOperationFlagBitsKHR codec,
+                              const VkVideoGopSimulator::Config& config, const VkVideoGopStructure& gopStructure)
+{
+    pEncoderConfig->codec = codec;
+    pEncoderConfig->encodeWidth = config.width;
+    pEncoderConfig->encodeHeight = config.height;
+    pEncoderConfig->numFrames = (uint32_t)std::min<uint64_t>(config.numFrames, UINT32_MAX);
+    pEncoderConfig->gopStructure = gopStructure;
+}
+
+// The picture resources of the DPBs are never allocated. The DPB asserts on
+// them are compiled out with VK_VIDEO_GOP_SIMULATOR.
+static VkSharedBaseObj<VulkanVideoImagePoolNode> s_nullImageResource;
+
+/******************************************************************************
+ * H.264: VkVideoEncoderH264::ProcessDpb()
+ ******************************************************************************/
+
+class VkVideoGopSimulatorH264 : public VkVideoGopSimulator {
+
+public:
+
+    explicit VkVideoGopSimulatorH264(const Config& config)
+        : VkVideoGopSimulator(config)
+        , m_encoderConfig()
+        , m_dpb(nullptr)
+        , m_decoderDpb(nullptr)
+        , m_spsInfo()
+        , m_ppsInfo()
+        , m_vuiInfo()
+        , m_hrdParameters()
+        , m_frameNumSyntax(0)
+        , m_idrPicId(0)
+    {
+    }
+
+    virtual ~VkVideoGopSimulatorH264()
+    {
+        if (m_dpb != nullptr) {
+            m_dpb->DpbDestroy();
+            m_dpb = nullptr;
+        }
+        if (m_decoderDpb != nullptr) {
+            m_decoderDpb->DpbDestroy();
+            m_decoderDpb = nullptr;
+        }
+    }
+
+protected:
+
+    enum { MAX_MEM_MGMNT_CTRL_OPS_COMMANDS = 16 };
+
+    virtual bool InitCodec()
+    {
+        m_encoderConfig = new EncoderConfigH264();
+        InitEncoderConfig(m_encoderConfig, VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR, m_config, m_gopStructure);
+        // Set by InitializeParameters() from the input, which is not there.
+        m_encoderConfig->pic_width_in_mbs = DivUp<uint32_t>(m_config.width, 16);
+        m_encoderConfig->pic_height_in_map_units = DivUp<uint32_t>(m_config.height, 16);
+
+        const int8_t maxDpbPicturesCount = m_encoderConfig->InitDpbCount();
+        m_dpb = VkEncDpbH264::CreateInstance();
+        if ((m_dpb == nullptr) || (maxDpbPicturesCount <= 0)) {
+            return false;
+        }
+        m_dpb->DpbSequenceStart(maxDpbPicturesCount);
+
+        if (m_config.decodedLayerCount > 0) {
+            m_decoderDpb = VkEncDpbH264::CreateInstance();
+            if (m_decoderDpb == nullptr) {
+                return false;
+            }
+            m_decoderDpb->DpbSequenceStart(maxDpbPicturesCount);
+        }
+
+        return m_encoderConfig->InitSpsPpsParameters(&m_spsInfo, &m_ppsInfo,
+                                                     m_encoderConfig->InitVuiParameters(&m_vuiInfo, &m_hrdParameters));
+    }
+
+    virtual uint32_t GetPicOrderCnt(const SimFrame& frame) const
+    {
+        return 2 * frame.gopPosition.inputOrder;
+    }
+
+    virtual uint32_t GetDpbCapacity() const
+    {
+        return m_spsInfo.max_num_ref_frames;
+    }
+
+    virtual bool ProcessDpb(SimFrame& frame, DpbResult& result)
+    {
+        const VkVideoGopStructure::FrameType picType = frame.gopPosition.pictureType;
+
+        // The picture info of EncodeFrame()
+        PicInfoH264 pictureInfo{};
+        pictureInfo.seq_parameter_set_id = m_spsInfo.seq_parameter_set_id;
+        pictureInfo.pic_parameter_set_id = m_ppsInfo.pic_parameter_set_id;
+        pictureInfo.flags.IdrPicFlag = frame.isIdr;
+        pictureInfo.flags.is_reference = frame.isReference;
+        pictureInfo.primary_pic_type = GetStdPictureType(picType);
+        if (frame.isIdr) {
+            pictureInfo.idr_pic_id = m_idrPicId & 1;
+            m_idrPicId++;
+        }
+
+        StdVideoEncodeH264SliceHeader sliceHeader{};
+        sliceHeader.slice_type = (picType == VkVideoGopStructure::FRAME_TYPE_P) ? STD_VIDEO_H264_SLICE_TYPE_P :
+                                 (picType == VkVideoGopStructure::FRAME_TYPE_B) ? STD_VIDEO_H264_SLICE_TYPE_B :
+                                                                                  STD_VIDEO_H264_SLICE_TYPE_I;
+
+        if (pictureInfo.flags.IdrPicFlag) {
+            m_frameNumSyntax = 0;
+        }
+        pictureInfo.frame_num = m_frameNumSyntax & ((1 << (m_spsInfo.log2_max_frame_num_minus4 + 4)) - 1);
+        pictureInfo.PicOrderCnt = frame.picOrderCntVal & ((1 << (m_spsInfo.log2_max_pic_order_cnt_lsb_minus4 + 4)) - 1);
+        pictureInfo.timeStamp = frame.frameInputOrderNum;
+        pictureInfo.temporalLayer = frame.gopPosition.temporalLayer;
+        if (frame.isReference) {
+            m_frameNumSyntax++;
+        }
+
+        const int8_t newDpbSlot = m_dpb->DpbPictureStart(&pictureInfo, &m_spsInfo);
+        if (newDpbSlot < 0) {
+            ReportError(frame, "no free DPB slot");
+            return false;
+        }
+
+        uint8_t refList0ModOpCount = 0;
+        StdVideoEncodeH264RefListModEntry refList0ModOperations[STD_VIDEO_H264_MAX_NUM_LIST_REF + 1];
+        StdVideoEncodeH264ReferenceListsInfoFlags refMgmtFlags = StdVideoEncodeH264ReferenceListsInfoFlags();
+        if (((picType == VkVideoGopStructure::FRAME_TYPE_P) || (picType == VkVideoGopStructure::FRAME_TYPE_B)) &&
+                m_dpb->NeedToReorder()) {
+            SetupRefPicReorderingCommands(&pictureInfo, &sliceHeader, &refMgmtFlags, refList0ModOperations, refList0ModOpCount);
+        }
+
+        StdVideoEncodeH264ReferenceListsInfo referenceListsInfo{};
+        referenceListsInfo.flags = refMgmtFlags;
+        referenceListsInfo.refList0ModOpCount = refList0ModOpCount;
+        referenceListsInfo.pRefList0ModOperations = refList0ModOperations;
+
+        if ((m_ppsInfo.num_ref_idx_l0_default_active_minus1 > 0) && (picType == VkVideoGopStructure::FRAME_TYPE_B)) {
+            sliceHeader.flags.num_ref_idx_active_override_flag = true;
+            referenceListsInfo.num_ref_idx_l0_active_minus1 = 0;
+        } else if (refList0ModOpCount > 1) {
+            sliceHeader.flags.num_ref_idx_active_override_flag = true;
+            referenceListsInfo.num_ref_idx_l0_active_minus1 =
+                std::min<uint8_t>((uint8_t)(refList0ModOpCount - 2), m_ppsInfo.num_ref_idx_l0_default_active_minus1);
+            referenceListsInfo.num_ref_idx_l1_active_minus1 = m_ppsInfo.num_ref_idx_l1_default_active_minus1;
+        }
+
+        NvVideoEncodeH264DpbSlotInfoLists<STD_VIDEO_H264_MAX_NUM_LIST_REF> refLists;
+        m_dpb->GetRefPicList(&pictureInfo, &refLists, &m_spsInfo, &m_ppsInfo, &sliceHeader, &referenceListsInfo);
+
+        memset(referenceListsInfo.RefPicList0, STD_VIDEO_H264_NO_REFERENCE_PICTURE, sizeof(referenceListsInfo.RefPicList0));
+        memset(referenceListsInfo.RefPicList1, STD_VIDEO_H264_NO_REFERENCE_PICTURE, sizeof(referenceListsInfo.RefPicList1));
+        memcpy(referenceListsInfo.RefPicList0, refLists.refPicList[0], refLists.refPicListCount[0]);
+        memcpy(referenceListsInfo.RefPicList1, refLists.refPicList[1], refLists.refPicListCount[1]);
+        referenceListsInfo.num_ref_idx_l0_active_minus1 = (refLists.refPicListCount[0] > 0) ? (uint8_t)(refLists.refPicListCount[0] - 1) : 0;
+        referenceListsInfo.num_ref_idx_l1_active_minus1 = (refLists.refPicListCount[1] > 0) ? (uint8_t)(refLists.refPicListCount[1] - 1) : 0;
+
+        // The marking the picture is encoded with, the sliding window of
+        // DpbPictureEnd() may drop the oldest reference right after.
+        result.maxRefs[0] = result.maxRefs[1] = 8;
+        for (uint32_t listNum = 0; listNum < 2; listNum++) {
+            result.numRefs[listNum] = std::min<uint32_t>(refLists.refPicListCount[listNum], MAX_REFS_PER_LIST);
+            for (uint32_t i = 0; i < result.numRefs[listNum]; i++) {
+                SimRef& ref = result.refs[listNum][i];
+                ref.slot = refLists.refPicList[listNum][i];
+                bool shortTerm = false, longTerm = false;
+                m_dpb->GetPicNumFromDpbIdx(ref.slot, &shortTerm, &longTerm);
+                ref.markedAsReference = shortTerm || longTerm;
+            }
+        }
+
+        int32_t picOrderCnt = 0;
+        m_dpb->GetUpdatedFrameNumAndPicOrderCnt(picOrderCnt);
+
+        const int8_t targetDpbSlot = m_dpb->DpbPictureEnd(&pictureInfo, s_nullImageResource, &m_spsInfo, &sliceHeader,
+                                                          &referenceListsInfo, MAX_MEM_MGMNT_CTRL_OPS_COMMANDS);
+
+        // Like the encoder, the reference info is filled after the DPB update.
+        for (uint32_t listNum = 0; listNum < 2; listNum++) {
+            for (uint32_t i = 0; i < result.numRefs[listNum]; i++) {
+                SimRef& ref = result.refs[listNum][i];
+                StdVideoEncodeH264ReferenceInfo referenceInfo{};
+                m_dpb->FillStdReferenceInfo((uint8_t)ref.slot, &referenceInfo);
+                ref.dpbPicOrderCnt = referenceInfo.PicOrderCnt;
+            }
+        }
+
+        DecodeLayerDrop(frame, pictureInfo, sliceHeader, referenceListsInfo, result);
+
+        result.setupSlot = targetDpbSlot;
+        if (targetDpbSlot >= VkEncDpbH264::MAX_DPB_SLOTS) {
+            result.setupSlot = m_dpb->GetNonReferenceSetupSlot(&referenceListsInfo);
+            if (result.setupSlot < 0) {
+                ReportError(frame, "no DPB slot to reconstruct the non-reference picture to");
+            }
+        }
+        result.dpbPicOrderCnt = picOrderCnt;
+        result.dpbOccupancy = (uint32_t)m_dpb->GetNumRefFramesInDPB(0);
+
+        return true;
+    }
+
+private:
+
+    static StdVideoH264PictureType GetStdPictureType(VkVideoGopStructure::FrameType pictureType)
+    {
+        switch (pictureType) {
+            case VkVideoGopStructure::FRAME_TYPE_IDR:
+            case VkVideoGopStructure::FRAME_TYPE_INTRA_REFRESH:
+                return STD_VIDEO_H264_PICTURE_TYPE_IDR;
+            case VkVideoGopStructure::FRAME_TYPE_I:
+                return STD_VIDEO_H264_PICTURE_TYPE_I;
+            case VkVideoGopStructure::FRAME_TYPE_P:
+                return STD_VIDEO_H264_PICTURE_TYPE_P;
+            case VkVideoGopStructure::FRAME_TYPE_B:
+                return STD_VIDEO_H264_PICTURE_TYPE_B;
+            default:
+                break;
+        }
+        assert(!"Invalid value");
+        return STD_VIDEO_H264_PICTURE_TYPE_INVALID;
+    }
+
+    // The decoder of the lower layers gets the frame_num of the dropped
+    // reference pictures as gaps, which take their place in the sliding window.
+    void DecodeLayerDrop(const SimFrame& frame, const PicInfoH264& pictureInfo, const StdVideoEncodeH264SliceHeader& sliceHeader,
+                         const StdVideoEncodeH264ReferenceListsInfo& referenceListsInfo, const DpbResult& result)
+    {
+        if ((m_decoderDpb == nullptr) || IsDroppedLayer(frame)) {
+            return;
+        }
+
+        if (m_decoderDpb->DpbPictureStart(&pictureInfo, &m_spsInfo) < 0) {
+            ReportError(frame, "no free DPB slot in the decoder of %u layer(s)", m_config.decodedLayerCount);
+            return;
+        }
+
+        DpbEntryH264 entries[VkEncDpbH264::MAX_DPB_SLOTS];
+        const int32_t numEntries = m_decoderDpb->GetValidEntries(entries);
+        for (uint32_t listNum = 0; listNum < 2; listNum++) {
+            for (uint32_t i = 0; i < result.numRefs[listNum]; i++) {
+                const SimRef& ref = result.refs[listNum][i];
+                bool found = false;
+                for (int32_t entry = 0; (entry < numEntries) && !found; entry++) {
+                    found = !entries[entry].not_existing && (entries[entry].picInfo.PicOrderCnt == ref.dpbPicOrderCnt);
+                }
+                if ((ref.slot >= 0) && !found) {
+                    ReportError(frame, "L%u[%u], POC %d, is not a reference picture of the decoder of %u layer(s)",
+                                listNum, i, ref.dpbPicOrderCnt, m_config.decodedLayerCount);
+                }
+            }
+        }
+
+        m_decoderDpb->DpbPictureEnd(&pictureInfo, s_nullImageResource, &m_spsInfo, &sliceHeader,
+                                    &referenceListsInfo, MAX_MEM_MGMNT_CTRL_OPS_COMMANDS);
+    }
+
+    // VkVideoEncoderH264::SetupRefPicReorderingCommands()
+    void SetupRefPicReorderingCommands(const PicInfoH264* pPicInfo, const StdVideoEncodeH264SliceHeader* slh,
+                                       StdVideoEncodeH264ReferenceListsInfoFlags* pFlags,
+                                       StdVideoEncodeH264RefListModEntry* refPicList0Mod, uint8_t& refList0ModOpCount)
+    {
+        NvVideoEncodeH264DpbSlotInfoLists<STD_VIDEO_H264_MAX_NUM_LIST_REF> refLists;
+        m_dpb->GetRefPicList(pPicInfo, &refLists, &m_spsInfo, &m_ppsInfo, slh, nullptr, true);
+
+        int maxPicNum = 1 << (m_spsInfo.log2_max_frame_num_minus4 + 4);
+        int picNumLXPred = m_dpb->GetCurrentDpbEntry()->frame_num % maxPicNum;
+        int numSTR = 0, numLTR = 0;
+        m_dpb->GetNumRefFramesInDPB(0, &numSTR, &numLTR);
+
+        pFlags->ref_pic_list_modification_flag_l0 = true;
+        refList0ModOpCount = 0;
+        if (numSTR) {
+            for (uint32_t i = 0; (i < refLists.refPicListCount[0]) && (i < STD_VIDEO_H264_MAX_NUM_LIST_REF); i++) {
+                int diff = m_dpb->GetPicNum(refLists.refPicList[0][i]) - picNumLXPred;
+                if (diff <= 0) {
+                    refPicList0Mod[refList0ModOpCount].modification_of_pic_nums_idc =
+                        STD_VIDEO_H264_MODIFICATION_OF_PIC_NUMS_IDC_SHORT_TERM_SUBTRACT;
+                    refPicList0Mod[refList0ModOpCount].abs_diff_pic_num_minus1 = (uint16_t)(abs(diff) ? abs(diff) - 1 : maxPicNum - 1);
+                } else {
+                    refPicList0Mod[refList0ModOpCount].modification_of_pic_nums_idc =
+                        STD_VIDEO_H264_MODIFICATION_OF_PIC_NUMS_IDC_SHORT_TERM_ADD;
+                    refPicList0Mod[refList0ModOpCount].abs_diff_pic_num_minus1 = (uint16_t)(abs(diff) - 1);
+                }
+                refList0ModOpCount++;
+                picNumLXPred = m_dpb->GetPicNum(refLists.refPicList[0][i]);
+            }
+        }
+
+        refPicList0Mod[refList0ModOpCount++].modification_of_pic_nums_idc = STD_VIDEO_H264_MODIFICATION_OF_PIC_NUMS_IDC_END;
+    }
+
+    VkSharedBaseObj<EncoderConfigH264>   m_encoderConfig;
+    VkEncDpbH264*                        m_dpb;
+    VkEncDpbH264*                        m_decoderDpb;      // the decoder of the lower layers
+    StdVideoH264SequenceParameterSet     m_spsInfo;
+    StdVideoH264PictureParameterSet      m_ppsInfo;
+    StdVideoH264SequenceParameterSetVui  m_vuiInfo;
+    StdVideoH264HrdParameters            m_hrdParameters;
+    uint32_t                             m_frameNumSyntax;
+    uint32_t                             m_idrPicId;
+};
+
+/******************************************************************************
+ * H.265: VkVideoEncoderH265::ProcessDpb()
+ ******************************************************************************/
+
+class VkVideoGopSimulatorH265 : public VkVideoGopSimulator {
+
+public:
+
+    explicit VkVideoGopSimulatorH265(const Config& config)
+        : VkVideoGopSimulator(config)
+        , m_encoderConfig()
+        , m_dpb()
+        , m_vps()
+        , m_sps()
+        , m_pps()
+        , m_decodedPicOrderCnts()
+    {
+    }
+
+protected:
+
+    virtual bool InitCodec()
+    {
+        m_encoderConfig = new EncoderConfigH265();
+        InitEncoderConfig(m_encoderConfig, VK_VIDEO_CODEC_OPERATION_ENCODE_H265_BIT_KHR, m_config, m_gopStructure);
+        m_encoderConfig->numRefL0 = m_config.numRefL0;
+        m_encoderConfig->numRefL1 = m_config.numRefL1;
+
+        const int8_t maxDpbPicturesCount = m_encoderConfig->InitDpbCount();
+        if (maxDpbPicturesCount <= 0) {
+            return false;
+        }
+        m_dpb.DpbSequenceStart(maxDpbPicturesCount, (m_encoderConfig->numRefL0 > 0));
+
+        return m_encoderConfig->InitParamameters(&m_vps, &m_sps, &m_pps,
+                                                 m_encoderConfig->InitVuiParameters(&m_sps.vuiInfo, &m_sps.hrdParameters,
+                                                                                    &m_sps.subLayerHrdParametersNal));
+    }
+
+    virtual uint32_t GetPicOrderCnt(const SimFrame& frame) const
+    {
+        return frame.gopPosition.inputOrder;
+    }
+
+    virtual uint32_t GetDpbCapacity() const
+    {
+        return m_sps.decPicBufMgr.max_dec_pic_buffering_minus1[m_sps.sps.sps_max_sub_layers_minus1] + 1U;
+    }
+
+    virtual bool ProcessDpb(SimFrame& frame, DpbResult& result)
+    {
+        const VkVideoGopStructure::FrameType picType = frame.gopPosition.pictureType;
+
+        // The picture info of EncodeFrame()
+        StdVideoEncodeH265PictureInfo pictureInfo{};
+        StdVideoH265ShortTermRefPicSet shortTermRefPicSet{};
+        pictureInfo.flags.is_reference = frame.isReference;
+        pictureInfo.flags.short_term_ref_pic_set_sps_flag = 1;
+        pictureInfo.flags.IrapPicFlag = ((picType == VkVideoGopStructure::FRAME_TYPE_IDR) ||
+                                         (picType == VkVideoGopStructure::FRAME_TYPE_I)) ? 1 : 0;
+        pictureInfo.flags.pic_output_flag = 1;
+        pictureInfo.flags.no_output_of_prior_pics_flag = frame.isIdr ? 1 : 0;
+        pictureInfo.pic_type = GetStdPictureType(picType);
+        pictureInfo.pps_seq_parameter_set_id = m_sps.sps.sps_seq_parameter_set_id;
+        pictureInfo.pps_pic_parameter_set_id = m_pps.pps_pic_parameter_set_id;
+        pictureInfo.PicOrderCntVal = frame.picOrderCntVal;
+        pictureInfo.TemporalId = (uint8_t)frame.gopPosition.temporalLayer;
+
+        uint32_t numRefL0 = m_encoderConfig->numRefL0;
+        uint32_t numRefL1 = m_encoderConfig->numRefL1;
+        if ((picType == VkVideoGopStructure::FRAME_TYPE_P) || (picType == VkVideoGopStructure::FRAME_TYPE_B)) {
+            numRefL0 = (numRefL0 == 0) ? 1 : numRefL0;
+            if ((frame.gopPosition.flags & VkVideoGopStructure::FLAGS_INTRA_REFRESH) != 0) {
+                numRefL0 = 1;
+            }
+            if (picType == VkVideoGopStructure::FRAME_TYPE_B) {
+                numRefL1 = (numRefL1 == 0) ? 1 : numRefL1;
+            }
+        }
+
+        m_dpb.ReferencePictureMarking(frame.picOrderCntVal, (StdVideoH265PictureType)picType,
+                                      m_sps.sps.flags.long_term_ref_pics_present_flag,
+                                      (frame.gopPosition.flags & VkVideoGopStructure::FLAGS_RECOVERY_POINT) != 0);
+
+        if (!pictureInfo.flags.no_output_of_prior_pics_flag) {
+            pictureInfo.pShortTermRefPicSet = &shortTermRefPicSet;
+            m_dpb.InitializeRPS(m_sps.sps.pShortTermRefPicSet, m_sps.sps.num_short_term_ref_pic_sets,
+                                &pictureInfo, &shortTermRefPicSet, numRefL0, numRefL1);
+        } else {
+            pictureInfo.pShortTermRefPicSet = nullptr;
+        }
+
+        const int32_t maxPicOrderCntLsb = 1 << (m_sps.sps.log2_max_pic_order_cnt_lsb_minus4 + 4);
+        const StdVideoH265ShortTermRefPicSet* pShortTermRefPicSet =
+            !pictureInfo.flags.short_term_ref_pic_set_sps_flag ? pictureInfo.pShortTermRefPicSet :
+                                                                 &m_sps.sps.pShortTermRefPicSet[pictureInfo.short_term_ref_pic_set_idx];
+        if ((pShortTermRefPicSet != nullptr) &&
+                ((uint32_t)(pShortTermRefPicSet->num_negative_pics + pShortTermRefPicSet->num_positive_pics) >= GetDpbCapacity())) {
+            ReportError(frame, "the RPS holds %u picture(s), the DPB %u with the current one",
+                        pShortTermRefPicSet->num_negative_pics + pShortTermRefPicSet->num_positive_pics, GetDpbCapacity());
+        }
+
+        VkEncDpbH265::RefPicSet refPicSet{};
+        const int8_t targetDpbSlot = m_dpb.DpbPictureStart(frame.frameInputOrderNum, &pictureInfo, pShortTermRefPicSet,
+                                                           nullptr, maxPicOrderCntLsb, frame.frameInputOrderNum, &refPicSet);
+        if (targetDpbSlot < 0) {
+            ReportError(frame, "no free DPB slot");
+            return false;
+        }
+
+        StdVideoEncodeH265ReferenceListsInfo referenceListsInfo{};
+        const bool interPicture = (picType == VkVideoGopStructure::FRAME_TYPE_P) || (picType == VkVideoGopStructure::FRAME_TYPE_B);
+        if (interPicture) {
+            m_dpb.SetupReferencePictureListLx((StdVideoH265PictureType)picType, &refPicSet, &referenceListsInfo, numRefL0, numRefL1);
+        }
+
+        m_dpb.DpbPictureEnd(s_nullImageResource, m_gopStructure.GetTemporalLayerCount(), frame.isReference);
+
+        DecodeLayerDrop(frame, pShortTermRefPicSet);
+
+        result.maxRefs[0] = numRefL0;
+        result.maxRefs[1] = numRefL1;
+        if (interPicture) {
+            result.numRefs[0] = referenceListsInfo.num_ref_idx_l0_active_minus1 + 1U;
+            result.numRefs[1] = (picType == VkVideoGopStructure::FRAME_TYPE_B) ? (referenceListsInfo.num_ref_idx_l1_active_minus1 + 1U) : 0;
+        }
+        for (uint32_t listNum = 0; listNum < 2; listNum++) {
+            result.numRefs[listNum] = std::min<uint32_t>(result.numRefs[listNum], MAX_REFS_PER_LIST);
+            const uint8_t* pRefPicList = (listNum == 0) ? referenceListsInfo.RefPicList0 : referenceListsInfo.RefPicList1;
+            for (uint32_t i = 0; i < result.numRefs[listNum]; i++) {
+                SimRef& ref = result.refs[listNum][i];
+                ref.slot = (pRefPicList[i] == STD_VIDEO_H265_NO_REFERENCE_PICTURE) ? -1 : pRefPicList[i];
+                if (ref.slot < 0) {
+                    continue;
+                }
+                StdVideoEncodeH265ReferenceInfo referenceInfo{};
+                m_dpb.FillStdReferenceInfo((uint8_t)ref.slot, &referenceInfo);
+                ref.markedAsReference = !referenceInfo.flags.unused_for_reference;
+                ref.dpbPicOrderCnt = referenceInfo.PicOrderCntVal;
+            }
+        }
+
+        result.setupSlot = targetDpbSlot;
+        result.dpbPicOrderCnt = pictureInfo.PicOrderCntVal;
+        for (uint8_t dpbIndex = 0; dpbIndex < STD_VIDEO_H265_MAX_DPB_SIZE; dpbIndex++) {
+            StdVideoEncodeH265ReferenceInfo referenceInfo{};
+            m_dpb.FillStdReferenceInfo(dpbIndex, &referenceInfo);
+            if (!referenceInfo.flags.unused_for_reference) {
+                result.dpbOccupancy++;
+            }
+        }
+
+        return true;
+    }
+
+private:
+
+    // The decoder of the lower layers applies the RPS of each picture it
+    // gets: the pictures the current one uses must be there, the following
+    // ones may be missing, and the DPB size is the one of the highest
+    // decoded sub-layer.
+    void DecodeLayerDrop(const SimFrame& frame, const StdVideoH265ShortTermRefPicSet* pShortTermRefPicSet)
+    {
+        if ((m_config.decodedLayerCount == 0) || IsDroppedLayer(frame)) {
+            return;
+        }
+
+        std::vector<int32_t> picOrderCnts;
+        if (frame.isIdr || (pShortTermRefPicSet == nullptr)) {
+            m_decodedPicOrderCnts.clear();
+        } else {
+            for (uint32_t setNum = 0; setNum < 2; setNum++) {
+                const uint32_t numPics = (setNum == 0) ? pShortTermRefPicSet->num_negative_pics : pShortTermRefPicSet->num_positive_pics;
+                const uint16_t* pDeltaPocMinus1 = (setNum == 0) ? pShortTermRefPicSet->delta_poc_s0_minus1 : pShortTermRefPicSet->delta_poc_s1_minus1;
+                const uint16_t usedByCurrPic = (setNum == 0) ? pShortTermRefPicSet->used_by_curr_pic_s0_flag : pShortTermRefPicSet->used_by_curr_pic_s1_flag;
+                int32_t picOrderCnt = (int32_t)frame.picOrderCntVal;
+                for (uint32_t i = 0; i < numPics; i++) {
+                    picOrderCnt += (setNum == 0) ? -(pDeltaPocMinus1[i] + 1) : (pDeltaPocMinus1[i] + 1);
+                    if (std::find(m_decodedPicOrderCnts.begin(), m_decodedPicOrderCnts.end(), picOrderCnt) != m_decodedPicOrderCnts.end()) {
+                        picOrderCnts.push_back(picOrderCnt);
+                    } else if ((usedByCurrPic & (1 << i)) != 0) {
+                        ReportError(frame, "uses the POC %d, not in the DPB of the decoder of %u layer(s)",
+                                    picOrderCnt, m_config.decodedLayerCount);
+                    }
+                }
+            }
+            m_decodedPicOrderCnts.swap(picOrderCnts);
+        }
+
+        const uint32_t highestTid = std::min<uint32_t>(m_config.decodedLayerCount - 1, m_sps.sps.sps_max_sub_layers_minus1);
+        const uint32_t dpbSize = m_sps.decPicBufMgr.max_dec_pic_buffering_minus1[m_sps.sps.flags.sps_sub_layer_ordering_info_present_flag ?
+                                                                                   highestTid : m_sps.sps.sps_max_sub_layers_minus1] + 1U;
+        if ((m_decodedPicOrderCnts.size() + 1) > dpbSize) {
+            ReportError(frame, "the decoder of %u layer(s) holds %u reference pictures and the current one, the DPB %u",
+                        m_config.decodedLayerCount, (uint32_t)m_decodedPicOrderCnts.size(), dpbSize);
+        }
+        if (frame.isReference) {
+            m_decodedPicOrderCnts.push_back((int32_t)frame.picOrderCntVal);
+        }
+    }
+
+    static StdVideoH265PictureType GetStdPictureType(VkVideoGopStructure::FrameType pictureType)
+    {
+        switch (pictureType) {
+            case VkVideoGopStructure::FRAME_TYPE_P:
+                return STD_VIDEO_H265_PICTURE_TYPE_P;
+            case VkVideoGopStructure::FRAME_TYPE_B:
+                return STD_VIDEO_H265_PICTURE_TYPE_B;
+            case VkVideoGopStructure::FRAME_TYPE_I:
+                return STD_VIDEO_H265_PICTURE_TYPE_I;
+            case VkVideoGopStructure::FRAME_TYPE_IDR:
+            case VkVideoGopStructure::FRAME_TYPE_INTRA_REFRESH:
+                return STD_VIDEO_H265_PICTURE_TYPE_IDR;
+            default:
+                break;
+        }
+        assert(!"Invalid picture type");
+        return STD_VIDEO_H265_PICTURE_TYPE_INVALID;
+    }
+
+    VkSharedBaseObj<EncoderConfigH265> m_encoderConfig;
+    VkEncDpbH265                       m_dpb;
+    VpsH265                            m_vps;
+    SpsH265                            m_sps;
+    StdVideoH265PictureParameterSet    m_pps;
+    std::vector<int32_t>               m_decodedPicOrderCnts;   // the references of the decoder of the lower layers
+};
+
+/******************************************************************************
+ * AV1: VkVideoEncoderAV1::ProcessDpb() and InitializeFrameHeader()
+ ******************************************************************************/
+
+class VkVideoGopSimulatorAV1 : public VkVideoGopSimulator {
+
+public:
+
+    explicit VkVideoGopSimulatorAV1(const Config& config)
+        : VkVideoGopSimulator(config)
+        , m_encoderConfig()
+        , m_dpb(nullptr)
+        , m_sequenceHeader()
+        , m_colorConfig()
+        , m_numBFramesToEncode(0)
+        , m_encodeEncodeFrameNum(0)
+        , m_hasShownFrame(false)
+        , m_lastShownFrameInputOrderNum(0)
+    {
+        for (uint32_t bufIdx = 0; bufIdx < STD_VIDEO_AV1_NUM_REF_FRAMES; bufIdx++) {
+            m_encodedRefBufs[bufIdx] = m_decodedRefBufs[bufIdx] = -1;
+        }
+    }
+
+    virtual ~VkVideoGopSimulatorAV1()
+    {
+        if (m_dpb != nullptr) {
+            m_dpb->DpbDestroy();
+            m_dpb = nullptr;
+        }
+    }
+
+protected:
+
+    virtual bool InitCodec()
+    {
+        m_encoderConfig = new EncoderConfigAV1();
+        InitEncoderConfig(m_encoderConfig, VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR, m_config, m_gopStructure);
+
+        // The capabilities of an implementation with all the prediction modes.
+        const uint32_t allReferenceNames = (1U << STD_VIDEO_AV1_REFS_PER_FRAME) - 1;
+        VkVideoEncodeAV1CapabilitiesKHR& caps = m_encoderConfig->av1EncodeCapabilities;
+        caps.maxSingleReferenceCount = 2;
+        caps.singleReferenceNameMask = allReferenceNames;
+        caps.maxUnidirectionalCompoundReferenceCount = 2;
+        caps.maxUnidirectionalCompoundGroup1ReferenceCount = 2;
+        caps.unidirectionalCompoundReferenceNameMask = allReferenceNames;
+        caps.maxBidirectionalCompoundReferenceCount = 2;
+        caps.maxBidirectionalCompoundGroup1ReferenceCount = 1;
+        caps.maxBidirectionalCompoundGroup2ReferenceCount = 1;
+        caps.bidirectionalCompoundReferenceNameMask = allReferenceNames;
+
+        const int8_t maxDpbPicturesCount = m_encoderConfig->InitDpbCount();
+        m_dpb = VkEncDpbAV1::CreateInstance();
+        if ((m_dpb == nullptr) || (maxDpbPicturesCount <= 0)) {
+            return false;
+        }
+        m_dpb->DpbSequenceStart(m_encoderConfig, maxDpbPicturesCount);
+
+        return m_encoderConfig->InitSequenceHeader(&m_sequenceHeader, &m_colorConfig);
+    }
+
+    virtual uint32_t GetPicOrderCnt(const SimFrame& frame) const
+    {
+        // Relative to the last key frame, where inputOrder restarts.
+        return frame.gopPosition.inputOrder;
+    }
+
+    virtual uint32_t GetDpbCapacity() const
+    {
+        return STD_VIDEO_AV1_NUM_REF_FRAMES;
+    }
+
+    virtual void InputFrame(SimFrame& frame)
+    {
+        if (frame.gopPosition.pictureType == VkVideoGopStructure::FRAME_TYPE_B) {
+            m_numBFramesToEncode++;
+        }
+    }
+
+    // VkVideoEncoderAV1::InsertOrdered(): the frames encoded ahead of their
+    // display order are shown later with a show existing frame header.
+    virtual void InsertOrdered(const SimFrame& frame)
+    {
+        std::vector<SimFrame>::iterator it = m_deferredFrames.begin();
+        while ((it != m_deferredFrames.end()) &&
+                (it->showExistingFrame || (it->gopPosition.encodeOrder < frame.gopPosition.encodeOrder))) {
+            ++it;
+        }
+        const bool hasDependantFrames = (it != m_deferredFrames.end());
+        m_deferredFrames.insert(it, frame);
+
+        if (hasDependantFrames) {
+            SimFrame showExistingFrame;
+            showExistingFrame.gopPosition = frame.gopPosition;
+            showExistingFrame.picOrderCntVal = frame.picOrderCntVal;
+            showExistingFrame.frameInputOrderNum = frame.frameInputOrderNum;
+            showExistingFrame.idrSequence = frame.idrSequence;
+            showExistingFrame.showExistingFrame = true;
+            m_deferredFrames.push_back(showExistingFrame);
+        }
+    }
+
+    virtual void StartOfEncodeOrder(SimFrame& frame)
+    {
+        if (!frame.showExistingFrame) {
+            frame.encodeNum = m_encodeEncodeFrameNum++;
+        }
+    }
+
+    virtual bool ProcessDpb(SimFrame& frame, DpbResult& result)
+    {
+        VkVideoGopStructure::GopPosition& gopPosition = frame.gopPosition;
+
+        uint32_t flags = 0;
+        if (gopPosition.pictureType != VkVideoGopStructure::FRAME_TYPE_B) {
+            if ((gopPosition.pictureType == VkVideoGopStructure::FRAME_TYPE_I) &&
+                    (gopPosition.inputOrder == gopPosition.encodeOrder)) {
+                flags = 1 << STD_VIDEO_AV1_REFERENCE_NAME_INTRA_FRAME;
+            } else if (m_gopStructure.GetConsecutiveBFrameCount() != 0) {
+                flags = (m_numBFramesToEncode == 0) ? (1 << STD_VIDEO_AV1_REFERENCE_NAME_GOLDEN_FRAME) :
+                                                      (1 << STD_VIDEO_AV1_REFERENCE_NAME_ALTREF_FRAME);
+            } else if (gopPosition.temporalLayer == 1) {
+                flags = 1 << STD_VIDEO_AV1_REFERENCE_NAME_GOLDEN_FRAME;
+            } else if ((gopPosition.temporalLayer > 1) && frame.isReference) {
+                flags = 1 << STD_VIDEO_AV1_REFERENCE_NAME_ALTREF2_FRAME;
+            }
+        }
+        StdVideoAV1ReferenceName refName = m_dpb->AssignReferenceFrameType(gopPosition.pictureType, flags, frame.isReference);
+
+        // The reference fields of InitializeFrameHeader()
+        const int32_t frameIdBits = m_sequenceHeader.delta_frame_id_length_minus_2 + 2 +
+                                    m_sequenceHeader.additional_frame_id_length_minus_1 + 1;
+        StdVideoAV1FrameType frameType = (gopPosition.pictureType == VkVideoGopStructure::FRAME_TYPE_IDR) ? STD_VIDEO_AV1_FRAME_TYPE_KEY :
+                                         (gopPosition.pictureType == VkVideoGopStructure::FRAME_TYPE_I) ? STD_VIDEO_AV1_FRAME_TYPE_INTRA_ONLY :
+                                                                                                        STD_VIDEO_AV1_FRAME_TYPE_INTER;
+        uint32_t frameId = (uint32_t)(gopPosition.encodeOrder % (1ULL << frameIdBits));
+        const bool overlayFrame = frame.showExistingFrame;
+        int32_t frameToShowBufId = VkEncDpbAV1::INVALID_IDX;
+        if (overlayFrame) {
+            frameToShowBufId = m_dpb->GetOverlayRefBufId(frame.picOrderCntVal);
+            const int32_t refBufDpbId = (frameToShowBufId != VkEncDpbAV1::INVALID_IDX) ?
+                                            m_dpb->GetRefBufDpbId(frameToShowBufId) : VkEncDpbAV1::INVALID_IDX;
+            if (refBufDpbId == VkEncDpbAV1::INVALID_IDX) {
+                ReportError(frame, "the frame to show is in no reference buffer");
+                return true;
+            }
+            refName = m_dpb->GetRefName(refBufDpbId);
+            frameType = m_dpb->GetFrameType(refBufDpbId);
+            frameId = m_dpb->GetFrameId(refBufDpbId);
+        }
+
+        const bool showFrame = !(((refName == STD_VIDEO_AV1_REFERENCE_NAME_BWDREF_FRAME) ||
+                                  (refName == STD_VIDEO_AV1_REFERENCE_NAME_ALTREF2_FRAME) ||
+                                  (refName == STD_VIDEO_AV1_REFERENCE_NAME_ALTREF_FRAME)) && !overlayFrame);
+        const bool errorResilientMode = (frameType == STD_VIDEO_AV1_FRAME_TYPE_KEY) && showFrame;
+        const bool shownKeyFrameOrSwitch = ((frameType == STD_VIDEO_AV1_FRAME_TYPE_KEY) && showFrame) ||
+                                           (frameType == STD_VIDEO_AV1_FRAME_TYPE_SWITCH);
+
+        if (!frame.showExistingFrame && (frameType == STD_VIDEO_AV1_FRAME_TYPE_INTER)) {
+            for (int32_t bufIdx = 0; bufIdx < STD_VIDEO_AV1_NUM_REF_FRAMES; bufIdx++) {
+                if (m_dpb->GetRefBufDpbId(bufIdx) == VkEncDpbAV1::INVALID_IDX) {
+                    ReportError(frame, "the reference buffer %d holds no picture", bufIdx);
+                }
+            }
+        }
+        m_dpb->GetPrimaryRefFrame(frameType, refName, errorResilientMode, overlayFrame);
+
+        if (!frame.showExistingFrame) {
+            m_dpb->SetupReferenceFrameGroups(gopPosition.pictureType, gopPosition, frameType, frame.picOrderCntVal);
+            if ((gopPosition.pictureType == VkVideoGopStructure::FRAME_TYPE_B) && (m_dpb->GetNumRefsL1() == 0)) {
+                gopPosition.pictureType = VkVideoGopStructure::FRAME_TYPE_P;
+                m_numBFramesToEncode--;
+                result.demotedToP = true;
+            }
+        }
+        const VkVideoEncoderAV1FrameUpdateType frameUpdateType = m_dpb->GetFrameUpdateType(refName, overlayFrame);
+
+        const int8_t dpbIndx = m_dpb->DpbPictureStart(frameType, refName, frame.picOrderCntVal, frameId,
+                                                      gopPosition.temporalLayer, gopPosition.temporalIdx,
+                                                      frame.showExistingFrame, frameToShowBufId);
+        if (dpbIndx < 0) {
+            ReportError(frame, "no free DPB slot");
+            return false;
+        }
+
+        m_dpb->ConfigureRefBufUpdate(shownKeyFrameOrSwitch, frame.showExistingFrame, frameUpdateType);
+        m_dpb->InvalidateStaleReferenceFrames((uint32_t)frame.encodeNum, frame.picOrderCntVal, &m_sequenceHeader);
+        const int32_t refreshFrameFlags = m_dpb->GetRefreshFrameFlags(shownKeyFrameOrSwitch, frame.showExistingFrame);
+
+        if (!frame.showExistingFrame) {
+            result.maxRefs[0] = result.maxRefs[1] = STD_VIDEO_AV1_REFS_PER_FRAME;
+            for (uint32_t groupId = 0; groupId < 2; groupId++) {
+                result.numRefs[groupId] = std::min<uint32_t>(m_dpb->GetNumRefsInGroup(groupId), MAX_REFS_PER_LIST);
+                for (uint32_t i = 0; i < result.numRefs[groupId]; i++) {
+                    SimRef& ref = result.refs[groupId][i];
+                    ref.slot = m_dpb->GetDpbIdx(groupId, i);
+                    if (ref.slot < 0) {
+                        continue;
+                    }
+                    ref.dpbPicOrderCnt = m_dpb->GetPicOrderCntVal(ref.slot);
+                    for (int32_t bufIdx = 0; (bufIdx < STD_VIDEO_AV1_NUM_REF_FRAMES) && !ref.markedAsReference; bufIdx++) {
+                        ref.markedAsReference = (m_dpb->GetRefBufDpbId(bufIdx) == ref.slot);
+                    }
+                }
+            }
+        }
+
+        DecodeLayerDrop(frame, frameType, refreshFrameFlags);
+
+        m_dpb->DpbPictureEnd(dpbIndx, s_nullImageResource, &m_sequenceHeader, frame.showExistingFrame,
+                             shownKeyFrameOrSwitch, errorResilientMode, overlayFrame, refName, frameUpdateType);
+
+        if (!frame.showExistingFrame && (gopPosition.pictureType == VkVideoGopStructure::FRAME_TYPE_B)) {
+            m_numBFramesToEncode--;
+        }
+
+        // The frames are displayed in input order, once.
+        if (showFrame) {
+            if (m_hasShownFrame && (frame.frameInputOrderNum <= m_lastShownFrameInputOrderNum)) {
+                ReportError(frame, "shown after frame %llu", (unsigned long long)m_lastShownFrameInputOrderNum);
+            }
+            m_hasShownFrame = true;
+            m_lastShownFrameInputOrderNum = frame.frameInputOrderNum;
+        }
+
+        result.setupSlot = frame.showExistingFrame ? -1 : dpbIndx;
+        result.dpbPicOrderCnt = (int32_t)frame.picOrderCntVal;
+        int8_t usedSlots[STD_VIDEO_AV1_NUM_REF_FRAMES];
+        for (int32_t bufIdx = 0; bufIdx < STD_VIDEO_AV1_NUM_REF_FRAMES; bufIdx++) {
+            const int8_t dpbId = m_dpb->GetRefBufDpbId(bufIdx);
+            bool counted = (dpbId == VkEncDpbAV1::INVALID_IDX);
+            for (uint32_t i = 0; (i < result.dpbOccupancy) && !counted; i++) {
+                counted = (usedSlots[i] == dpbId);
+            }
+            if (!counted) {
+                usedSlots[result.dpbOccupancy++] = dpbId;
+            }
+        }
+
+        return true;
+    }
+
+private:
+
+    // The decoder of the lower operating point skips the refresh_frame_flags
+    // of the dropped frames: each reference buffer a decoded frame uses
+    // must hold the frame the encoder put there.
+    void DecodeLayerDrop(const SimFrame& frame, StdVideoAV1FrameType frameType, int32_t refreshFrameFlags)
+    {
+        const bool dropped = IsDroppedLayer(frame);
+        if ((m_config.decodedLayerCount > 0) && !dropped && !frame.showExistingFrame &&
+                (frameType == STD_VIDEO_AV1_FRAME_TYPE_INTER)) {
+            for (uint32_t groupId = 0; groupId < 2; groupId++) {
+                for (int32_t i = 0; i < m_dpb->GetNumRefsInGroup(groupId); i++) {
+                    const StdVideoAV1ReferenceName refName = (StdVideoAV1ReferenceName)(m_dpb->GetRefNameMinus1(groupId, i) + 1);
+                    const int32_t bufIdx = m_dpb->GetRefBufId(refName);
+                    if ((bufIdx < 0) || (bufIdx >= STD_VIDEO_AV1_NUM_REF_FRAMES)) {
+                        continue;
+                    }
+                    if (m_decodedRefBufs[bufIdx] != m_encodedRefBufs[bufIdx]) {
+                        ReportError(frame, "references frame %lld in the buffer %d, the decoder of %u layer(s) has frame %lld there",
+                                    (long long)m_encodedRefBufs[bufIdx], bufIdx, m_config.decodedLayerCount,
+                                    (long long)m_decodedRefBufs[bufIdx]);
+                    }
+                }
+            }
+        }
+
+        for (int32_t bufIdx = 0; bufIdx < STD_VIDEO_AV1_NUM_REF_FRAMES; bufIdx++) {
+            if ((refreshFrameFlags & (1 << bufIdx)) != 0) {
+                m_encodedRefBufs[bufIdx] = (int64_t)frame.frameInputOrderNum;
+                if (!dropped) {
+                    m_decodedRefBufs[bufIdx] = (int64_t)frame.frameInputOrderNum;
+                }
+            }
+        }
+    }
+
+    VkSharedBaseObj<EncoderConfigAV1> m_encoderConfig;
+    VkEncDpbAV1*                      m_dpb;
+    StdVideoAV1SequenceHeader         m_sequenceHeader;
+    StdVideoAV1ColorConfig            m_colorConfig;
+    uint32_t                          m_numBFramesToEncode;
+    uint64_t                          m_encodeEncodeFrameNum;
+    bool                              m_hasShownFrame;
+    uint64_t                          m_lastShownFrameInputOrderNum;
+    int64_t                           m_encodedRefBufs[STD_VIDEO_AV1_NUM_REF_FRAMES];  // the frame in each buffer, -1: none
+    int64_t                           m_decodedRefBufs[STD_VIDEO_AV1_NUM_REF_FRAMES];  // as the decoder of the lower layers has it
+};
+
+/******************************************************************************
+ * The codec independent part: VkVideoEncoder::EncodeFrame() and EnqueueFrame()
+ ******************************************************************************/
+
+const char* VkVideoGopSimulator::GetCodecName(VkVideoCodecOperationFlagBitsKHR codec)
+{
+    switch (codec) {
+        case VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR:
+            return "H.264";
+        case VK_VIDEO_CODEC_OPERATION_ENCODE_H265_BIT_KHR:
+            return "H.265";
+        case VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR:
+            return "AV1";
+        default:
+            break;
+    }
+    return "Unknown";
+}
+
+VkVideoGopSimulator* VkVideoGopSimulator::Create(const Config& config)
+{
+    switch (config.codec) {
+        case VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR:
+            return new VkVideoGopSimulatorH264(config);
+        case VK_VIDEO_CODEC_OPERATION_ENCODE_H265_BIT_KHR:
+            return new VkVideoGopSimulatorH265(config);
+        case VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR:
+            return new VkVideoGopSimulatorAV1(config);
+        default:
+            break;
+    }
+    return nullptr;
+}
+
+VkVideoGopSimulator::VkVideoGopSimulator(const Config& config)
+    : m_config(config)
+    , m_gopStructure()
+    , m_deferredFrames()
+    , m_numDeferredRefFrames(0)
+    , m_encodeNum(0)
+    , m_idrSequence(0)
+    , m_refreshWaveStart(0)
+    , m_nextRefreshIndex(0)
+    , m_slots()
+    , m_timeHistogram(TIME_HISTOGRAM_SIZE + 1, 0)
+    , m_stats()
+{
+    m_gopStructure.SetGopFrameCount(config.gopFrameCount);
+    m_gopStructure.SetIdrPeriod(config.idrPeriod);
+    m_gopStructure.SetConsecutiveBFrameCount(config.consecutiveBFrameCount);
+    m_gopStructure.SetTemporalLayerCount(config.temporalLayerCount);
+    if (config.closedGop) {
+        m_gopStructure.SetClosedGop();
+    }
+    m_gopStructure.SetIntraRefreshPeriod(config.intraRefreshPeriod);
+    m_gopStructure.Init(config.numFrames);
+}
+
+void VkVideoGopSimulator::ReportError(const SimFrame& frame, const char* format, ...)
+{
+    if (m_stats.numErrors++ >= m_config.maxReportedErrors) {
+        return;
+    }
+
+    fprintf(stderr, "%s: frame %llu (%s%s, POC %u, layer %u): ", GetCodecName(m_config.codec),
+            (unsigned long long)frame.frameInputOrderNum, VkVideoGopStructure::GetFrameTypeName(frame.gopPosition.pictureType),
+            frame.showExistingFrame ? " shown" : "", frame.picOrderCntVal, frame.gopPosition.temporalLayer);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+}
+
+uint32_t VkVideoGopSimulator::GetGopIndex(const SimFrame& frame) const
+{
+    return frame.gopPosition.inputOrder / std::max<uint32_t>(m_gopStructure.GetGopFrameCount(), 1);
+}
+
+bool VkVideoGopSimulator::Run()
+{
+    m_stats = Stats();
+    m_stats.dpbCapacity = 0;
+    if (!InitCodec()) {
+        fprintf(stderr, "%s: the encoder configuration can't be set up\n", GetCodecName(m_config.codec));
+        return false;
+    }
+    m_stats.dpbCapacity = GetDpbCapacity();
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    VkVideoGopStructure::GopState gopState;
+    for (uint64_t frameNum = 0; frameNum < m_config.numFrames; frameNum++) {
+
+        // The IDR requests of the application and the scene cuts of the lookahead
+        if ((m_config.forcedIdrPeriod > 0) && (frameNum > 0) && ((frameNum % m_config.forcedIdrPeriod) == 0)) {
+            gopState.idrRequested = true;
+        }
+        if (m_config.sceneCutPeriod > 0) {
+            const uint32_t position = (uint32_t)(frameNum % m_config.sceneCutPeriod);
+            gopState.framesToSceneCut = (position == 0) ? 0 : (m_config.sceneCutPeriod - position);
+        }
+
+        SimFrame frame;
+        frame.frameInputOrderNum = frameNum;
+        frame.lastFrame = ((frameNum + 1) == m_config.numFrames);
+        frame.isIdr = m_gopStructure.GetPositionInGOP(gopState, frame.gopPosition, (frameNum == 0),
+                                                      (uint32_t)std::min<uint64_t>(m_config.numFrames - frameNum, UINT32_MAX));
+        frame.isReference = m_gopStructure.IsFrameReference(frame.gopPosition);
+        if (frame.isIdr) {
+            m_idrSequence++;
+        }
+        frame.idrSequence = m_idrSequence;
+        frame.picOrderCntVal = GetPicOrderCnt(frame);
+        InputFrame(frame);
+
+        EnqueueFrame(frame);
+    }
+
+    m_stats.elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    m_stats.numFrames = m_config.numFrames;
+    FinishTimeStats();
+
+    const uint64_t numCodedFrames = m_stats.numEncodedFrames - m_stats.numShowExistingFrames;
+    if (numCodedFrames != m_config.numFrames) {
+        m_stats.numErrors++;
+        fprintf(stderr, "%s: %llu of the %llu input frames were encoded\n", GetCodecName(m_config.codec),
+                (unsigned long long)numCodedFrames, (unsigned long long)m_config.numFrames);
+    }
+
+    return (m_stats.numErrors == 0);
+}
+
+void VkVideoGopSimulator::InsertOrdered(const SimFrame& frame)
+{
+    std::vector<SimFrame>::iterator it = m_deferredFrames.begin();
+    while ((it != m_deferredFrames.end()) && (it->gopPosition.encodeOrder < frame.gopPosition.encodeOrder)) {
+        ++it;
+    }
+    m_deferredFrames.insert(it, frame);
+}
+
+void VkVideoGopSimulator::EnqueueFrame(const SimFrame& frame)
+{
+    if (frame.isIdr) {
+        PushOrderedFrames();
+    }
+
+    InsertOrdered(frame);
+    if (frame.isReference) {
+        m_numDeferredRefFrames++;
+    }
+
+    // The encoder holds one reference frame in its queue.
+    if (frame.lastFrame || (frame.isReference && (m_numDeferredRefFrames == 1))) {
+        PushOrderedFrames();
+    }
+}
+
+void VkVideoGopSimulator::PushOrderedFrames()
+{
+    for (size_t i = 0; i < m_deferredFrames.size(); i++) {
+        m_deferredFrames[i].encodeNum = m_encodeNum;
+        StartOfEncodeOrder(m_deferredFrames[i]);
+        m_encodeNum++;
+    }
+
+    for (size_t i = 0; i < m_deferredFrames.size(); i++) {
+        SimFrame& frame = m_deferredFrames[i];
+
+        DpbResult result;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const bool success = ProcessDpb(frame, result);
+        RecordDpbTime((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+        m_stats.numEncodedFrames++;
+        if (IsDroppedLayer(frame)) {
+            m_stats.numDroppedPictures++;
+        }
+        if (frame.showExistingFrame) {
+            m_stats.numShowExistingFrames++;
+        } else if ((frame.gopPosition.pictureType >= VkVideoGopStructure::FRAME_TYPE_P) &&
+                   (frame.gopPosition.pictureType <= VkVideoGopStructure::FRAME_TYPE_IDR)) {
+            m_stats.numPictures[frame.gopPosition.pictureType]++;
+        }
+
+        if (!success) {
+            continue;
+        }
+        if (result.demotedToP) {
+            m_stats.numDemotedBFrames++;
+        }
+
+        CheckReferences(frame, result);
+        CheckIntraRefresh(frame, result);
+
+        if (frame.isReference && (result.setupSlot >= 0) && (result.setupSlot < MAX_DPB_SLOTS)) {
+            SlotShadow& slot = m_slots[result.setupSlot];
+            slot.valid = true;
+            slot.frameInputOrderNum = frame.frameInputOrderNum;
+            slot.idrSequence = frame.idrSequence;
+            slot.gopIndex = GetGopIndex(frame);
+            slot.temporalLayer = frame.gopPosition.temporalLayer;
+            slot.dpbPicOrderCnt = result.dpbPicOrderCnt;
+        }
+    }
+
+    m_deferredFrames.clear();
+    m_numDeferredRefFrames = 0;
+}
+
+void VkVideoGopSimulator::CheckReferences(const SimFrame& frame, const DpbResult& result)
+{
+    if (frame.showExistingFrame) {
+        return;
+    }
+
+    const VkVideoGopStructure::FrameType pictureType = frame.gopPosition.pictureType;
+    const bool closedGop = m_gopStructure.IsClosedGop() && (m_gopStructure.GetIntraRefreshPeriod() == 0);
+    const uint32_t numRefs = result.numRefs[0] + result.numRefs[1];
+
+    if (m_config.verbose) {
+        printf("%8llu enc %8llu %-3s POC %5u layer %u slot %2d refs", (unsigned long long)frame.frameInputOrderNum,
+               (unsigned long long)frame.encodeNum, VkVideoGopStructure::GetFrameTypeName(pictureType),
+               frame.picOrderCntVal, frame.gopPosition.temporalLayer, result.setupSlot);
+        for (uint32_t listNum = 0; listNum < 2; listNum++) {
+            printf(" L%u:", listNum);
+            for (uint32_t i = 0; i < result.numRefs[listNum]; i++) {
+                const int32_t slot = result.refs[listNum][i].slot;
+                printf(" %lld", ((slot >= 0) && (slot < MAX_DPB_SLOTS) && m_slots[slot].valid) ?
+                                    (long long)m_slots[slot].frameInputOrderNum : -1LL);
+            }
+        }
+        printf("  DPB %u\n", result.dpbOccupancy);
+    }
+
+    m_stats.numRefPictures += numRefs;
+    m_stats.maxRefsL0 = std::max(m_stats.maxRefsL0, result.numRefs[0]);
+    m_stats.maxRefsL1 = std::max(m_stats.maxRefsL1, result.numRefs[1]);
+    m_stats.maxDpbOccupancy = std::max(m_stats.maxDpbOccupancy, result.dpbOccupancy);
+
+    if (result.dpbOccupancy > GetDpbCapacity()) {
+        ReportError(frame, "the DPB holds %u reference pictures, %u max", result.dpbOccupancy, GetDpbCapacity());
+    }
+    for (uint32_t listNum = 0; listNum < 2; listNum++) {
+        if (result.numRefs[listNum] > result.maxRefs[listNum]) {
+            ReportError(frame, "%u references in list %u, %u max", result.numRefs[listNum], listNum, result.maxRefs[listNum]);
+        }
+    }
+
+    if ((pictureType == VkVideoGopStructure::FRAME_TYPE_IDR) || (pictureType == VkVideoGopStructure::FRAME_TYPE_I)) {
+        if (numRefs > 0) {
+            ReportError(frame, "an intra picture with %u reference(s)", numRefs);
+        }
+        return;
+    }
+    if (numRefs == 0) {
+        ReportError(frame, "an inter picture without reference");
+        return;
+    }
+
+    bool hasBackwardReference = false;
+    for (uint32_t listNum = 0; listNum < 2; listNum++) {
+        for (uint32_t i = 0; i < result.numRefs[listNum]; i++) {
+            const SimRef& ref = result.refs[listNum][i];
+            if ((ref.slot < 0) || (ref.slot >= MAX_DPB_SLOTS) || !m_slots[ref.slot].valid) {
+                ReportError(frame, "L%u[%u] is the empty DPB slot %d", listNum, i, ref.slot);
+                continue;
+            }
+
+            const SlotShadow& slot = m_slots[ref.slot];
+            const unsigned long long refFrameNum = (unsigned long long)slot.frameInputOrderNum;
+            if (ref.dpbPicOrderCnt != slot.dpbPicOrderCnt) {
+                ReportError(frame, "L%u[%u], slot %d, has the POC %d instead of %d of frame %llu",
+                            listNum, i, ref.slot, ref.dpbPicOrderCnt, slot.dpbPicOrderCnt, refFrameNum);
+                continue;
+            }
+            if (!ref.markedAsReference) {
+                ReportError(frame, "references frame %llu, no longer marked as a reference", refFrameNum);
+            }
+            if (slot.idrSequence != frame.idrSequence) {
+                ReportError(frame, "references frame %llu, from before the IDR picture", refFrameNum);
+            } else if (closedGop && (slot.gopIndex > GetGopIndex(frame))) {
+                ReportError(frame, "references frame %llu, across the closed GOP boundary", refFrameNum);
+            }
+            if (!VkVideoTemporalLayers::CanReference(frame.gopPosition.temporalLayer, slot.temporalLayer)) {
+                ReportError(frame, "references frame %llu of the temporal layer %u", refFrameNum, slot.temporalLayer);
+            }
+            if (ref.slot == result.setupSlot) {
+                ReportError(frame, "reconstructed to the slot %d of its reference frame %llu", ref.slot, refFrameNum);
+            }
+            if (slot.frameInputOrderNum == frame.frameInputOrderNum) {
+                ReportError(frame, "references itself");
+            } else if (slot.frameInputOrderNum > frame.frameInputOrderNum) {
+                if (pictureType == VkVideoGopStructure::FRAME_TYPE_P) {
+                    ReportError(frame, "a P picture referencing the following frame %llu", refFrameNum);
+                }
+                hasBackwardReference = true;
+            }
+        }
+    }
+
+    if ((pictureType == VkVideoGopStructure::FRAME_TYPE_B) && !hasBackwardReference) {
+        ReportError(frame, "a B picture without backward reference");
+    }
+}
+
+void VkVideoGopSimulator::CheckIntraRefresh(const SimFrame& frame, const DpbResult& result)
+{
+    const uint32_t intraRefreshPeriod = m_gopStructure.GetIntraRefreshPeriod();
+    if ((intraRefreshPeriod == 0) || frame.showExistingFrame) {
+        return;
+    }
+
+    const VkVideoGopStructure::GopPosition& gopPos = frame.gopPosition;
+    if (gopPos.pictureType == VkVideoGopStructure::FRAME_TYPE_IDR) {
+        m_refreshWaveStart = frame.frameInputOrderNum + 1;
+        m_nextRefreshIndex = 0;
+        return;
+    }
+    if (gopPos.pictureType != VkVideoGopStructure::FRAME_TYPE_P) {
+        ReportError(frame, "a %s picture with the intra refresh", VkVideoGopStructure::GetFrameTypeName(gopPos.pictureType));
+        return;
+    }
+    if ((gopPos.flags & VkVideoGopStructure::FLAGS_INTRA_REFRESH) == 0) {
+        ReportError(frame, "a P picture without refresh band");
+        return;
+    }
+
+    // The bands of a wave follow each other, only an IDR picture restarts it.
+    const bool recoveryPoint = ((gopPos.flags & VkVideoGopStructure::FLAGS_RECOVERY_POINT) != 0);
+    if (gopPos.intraRefreshIndex != m_nextRefreshIndex) {
+        ReportError(frame, "refreshes the band %u instead of %u", gopPos.intraRefreshIndex, m_nextRefreshIndex);
+    }
+    if (recoveryPoint != (gopPos.intraRefreshIndex == 0)) {
+        ReportError(frame, "the band %u is %sa recovery point", gopPos.intraRefreshIndex, recoveryPoint ? "" : "not ");
+    }
+    if (recoveryPoint) {
+        m_refreshWaveStart = frame.frameInputOrderNum;
+    }
+    m_nextRefreshIndex = (gopPos.intraRefreshIndex + 1) % intraRefreshPeriod;
+
+    // The refreshed bands stay clean only if each picture predicts from the
+    // previous one, and the recovery count of the SEI only holds if nothing
+    // after the recovery point reaches back before it.
+    if ((result.numRefs[0] != 1) || (result.numRefs[1] != 0)) {
+        ReportError(frame, "%u/%u references in a refresh wave, only the previous picture is allowed",
+                    result.numRefs[0], result.numRefs[1]);
+    } else {
+        const int32_t refSlot = result.refs[0][0].slot;
+        if ((refSlot >= 0) && (refSlot < MAX_DPB_SLOTS) && m_slots[refSlot].valid) {
+            const uint64_t refFrameNum = m_slots[refSlot].frameInputOrderNum;
+            if ((refFrameNum + 1) != frame.frameInputOrderNum) {
+                ReportError(frame, "references frame %llu instead of the previous picture in a refresh wave",
+                            (unsigned long long)refFrameNum);
+            }
+            if (!recoveryPoint && (refFrameNum < m_refreshWaveStart)) {
+                ReportError(frame, "references frame %llu, from before the recovery point %llu",
+                            (unsigned long long)refFrameNum, (unsigned long long)m_refreshWaveStart);
+            }
+        }
+    }
+
+    // Once the recovery point is referenced, the DPB only holds the pictures of the wave.
+    const uint64_t maxWavePictures = frame.frameInputOrderNum - m_refreshWaveStart + 1;
+    if (!recoveryPoint && (result.dpbOccupancy > maxWavePictures)) {
+        ReportError(frame, "the DPB holds %u reference pictures, %llu since the recovery point %llu",
+                    result.dpbOccupancy, (unsigned long long)maxWavePictures, (unsigned long long)m_refreshWaveStart);
+    }
+}
+
+void VkVideoGopSimulator::RecordDpbTime(uint64_t ns)
+{
+    m_stats.dpbTimeNs += ns;
+    m_stats.maxDpbTimeNs = std::max(m_stats.maxDpbTimeNs, ns);
+    m_timeHistogram[std::min<uint64_t>(ns, TIME_HISTOGRAM_SIZE)]++;
+}
+
+void VkVideoGopSimulator::FinishTimeStats()
+{
+    const uint64_t numSamples = m_stats.numEncodedFrames;
+    const uint64_t medianRank = (numSamples + 1) / 2;
+    const uint64_t p99Rank = numSamples - (numSamples / 100);
+    uint64_t count = 0;
+    for (uint32_t ns = 0; ns <= TIME_HISTOGRAM_SIZE; ns++) {
+        const uint64_t prevCount = count;
+        count += m_timeHistogram[ns];
+        if ((prevCount < medianRank) && (count >= medianRank)) {
+            m_stats.medianDpbTimeNs = ns;
+        }
+        if ((prevCount < p99Rank) && (count >= p99Rank)) {
+            m_stats.p99DpbTimeNs = ns;
+        }
+    }
+}
+
+void VkVideoGopSimulator::PrintSummary(FILE* fp) const
+{
+    char decodedLayers[32] = "";
+    if (m_config.decodedLayerCount > 0) {
+        snprintf(decodedLayers, sizeof(decodedLayers), " (%u decoded)", m_config.decodedLayerCount);
+    }
+    fprintf(fp, "%-5s GOP %3u, IDR period %4u, %u B, %u layer(s)%s, %s GOP, refresh %2u, L0/L1 %u/%u: "
+                "%llu frame(s), %llu error(s), %.0f ns/frame\n",
+            GetCodecName(m_config.codec), m_config.gopFrameCount, m_config.idrPeriod, m_config.consecutiveBFrameCount,
+            m_config.temporalLayerCount, decodedLayers, m_config.closedGop ? "closed" : "open", m_config.intraRefreshPeriod,
+            m_config.numRefL0, m_config.numRefL1, (unsigned long long)m_stats.numFrames,
+            (unsigned long long)m_stats.numErrors,
+            (m_stats.numEncodedFrames > 0) ? ((double)m_stats.dpbTimeNs / m_stats.numEncodedFrames) : 0.0);
+}
+
+void VkVideoGopSimulator::PrintReport(FILE* fp) const
+{
+    PrintSummary(fp);
+    fprintf(fp, "  Pictures: %llu IDR, %llu I, %llu P (%llu from B), %llu B, %llu show existing\n",
+            (unsigned long long)m_stats.numPictures[VkVideoGopStructure::FRAME_TYPE_IDR],
+            (unsigned long long)m_stats.numPictures[VkVideoGopStructure::FRAME_TYPE_I],
+            (unsigned long long)m_stats.numPictures[VkVideoGopStructure::FRAME_TYPE_P],
+            (unsigned long long)m_stats.numDemotedBFrames,
+            (unsigned long long)m_stats.numPictures[VkVideoGopStructure::FRAME_TYPE_B],
+            (unsigned long long)m_stats.numShowExistingFrames);
+    const uint64_t numInterPictures = m_stats.numPictures[VkVideoGopStructure::FRAME_TYPE_P] +
+                                      m_stats.numPictures[VkVideoGopStructure::FRAME_TYPE_B];
+    fprintf(fp, "  References: %.2f per inter picture, up to %u in L0 and %u in L1, DPB occupancy up to %u of %u\n",
+            (numInterPictures > 0) ? ((double)m_stats.numRefPictures / numInterPictures) : 0.0,
+            m_stats.maxRefsL0, m_stats.maxRefsL1, m_stats.maxDpbOccupancy, m_stats.dpbCapacity);
+    if (m_config.decodedLayerCount > 0) {
+        fprintf(fp, "  Layer drop: %llu picture(s) above the %u lowest layer(s) dropped\n",
+                (unsigned long long)m_stats.numDroppedPictures, m_config.decodedLayerCount);
+    }
+    fprintf(fp, "  DPB step: median %u ns, p99 %u%s ns, max %llu ns; %.2f M frames/s overall\n",
+            m_stats.medianDpbTimeNs, m_stats.p99DpbTimeNs, (m_stats.p99DpbTimeNs >= TIME_HISTOGRAM_SIZE) ? "+" : "",
+            (unsigned long long)m_stats.maxDpbTimeNs,
+            (m_stats.elapsedSec > 0.0) ? (m_stats.numFrames / m_stats.elapsedSec / 1e6) : 0.0);
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEOGOPSIMULATOR_VKVIDEOGOPSIMULATOR_H_
+#define _VKVIDEOGOPSIMULATOR_VKVIDEOGOPSIMULATOR_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "vulkan_interfaces.h"
+#include "VkVideoEncoder/VkVideoGopStructure.h"
+
+// Drives the encoder GOP structure and the H.264, H.265 and AV1 DPBs through
+// the same steps as VkVideoEncoder, without a Vulkan device: the frames are
+// queued and flushed in encode order like EnqueueFrame() does, and the DPB
+// calls of each codec's ProcessDpb() are made with null picture resources.
+//
+// Every reference of every picture is checked against a shadow copy of the
+// DPB slots: it must hold the expected picture, still be marked as a
+// reference, belong to the same IDR sequence (and closed GOP), come from a
+// temporal layer the picture can reference, and be in the past for a P
+// picture. With the intra refresh, the bands of each wave must follow each
+// other, and a wave picture may only reference the previous picture, from
+// the same wave after the recovery point. The DPB occupancy is checked
+// against the codec limits and the time of each picture's DPB step is
+// recorded.
+//
+// With decodedLayerCount, a decoder model of each codec only gets the
+// pictures of the lower temporal layers, as after a layer drop: the H.264
+// DPB with the frame_num gaps, the H.265 RPS with the sub-layer DPB size,
+// or the AV1 reference buffers without the refreshes of the dropped frames.
+// Every reference of a decoded picture must be in the model.
+class VkVideoGopSimulator {
+
+public:
+
+    enum { MAX_DPB_SLOTS = 32 };
+    enum { MAX_REFS_PER_LIST = 16 };
+    enum { TIME_HISTOGRAM_SIZE = 1 << 16 };    // in ns
+
+    struct Config {
+        VkVideoCodecOperationFlagBitsKHR codec;
+        uint64_t numFrames;
+        uint32_t width;
+        uint32_t height;
+        uint8_t  gopFrameCount;
+        uint32_t idrPeriod;             // 0: only the first picture is an IDR
+        uint8_t  consecutiveBFrameCount;
+        uint8_t  temporalLayerCount;
+        bool     closedGop;
+        uint32_t intraRefreshPeriod;
+        uint32_t forcedIdrPeriod;       // an application IDR request every n input frames, 0: none
+        uint32_t sceneCutPeriod;        // a scene cut known in advance every n input frames, 0: none
+        uint32_t numRefL0;              // H.265 only
+        uint32_t numRefL1;
+        uint32_t decodedLayerCount;     // the layers a decoder keeps to check the layer drop, 0: all
+        uint32_t maxReportedErrors;     // the following ones are only counted
+        bool     verbose;               // print the references of every picture
+
+        Config()
+        : codec(VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR)
+        , numFrames(100000)
+        , width(1920)
+        , height(1080)
+        , gopFrameCount(16)
+        , idrPeriod(0)
+        , consecutiveBFrameCount(0)
+        , temporalLayerCount(1)
+        , closedGop(false)
+        , intraRefreshPeriod(0)
+        , forcedIdrPeriod(0)
+        , sceneCutPeriod(0)
+        , numRefL0(1)
+        , numRefL1(1)
+        , decodedLayerCount(0)
+        , maxReportedErrors(8)
+        , verbose(false) {}
+    };
+
+    struct Stats {
+        uint64_t numFrames;             // input frames
+        uint64_t numEncodedFrames;      // in encode order, with the AV1 show existing frame headers
+        uint64_t numPictures[4];        // by VkVideoGopStructure::FrameType P, B, I, IDR, as encoded
+        uint64_t numShowExistingFrames;
+        uint64_t numDemotedBFrames;     // AV1: B pictures encoded as P for lack of a backward reference
+        uint64_t numDroppedPictures;    // of the layers above decodedLayerCount
+        uint64_t numRefPictures;        // references of all the pictures
+        uint32_t maxRefsL0;
+        uint32_t maxRefsL1;
+        uint32_t maxDpbOccupancy;       // reference pictures held after a picture
+        uint32_t dpbCapacity;
+        uint64_t numErrors;
+        double   elapsedSec;            // of the whole run
+        uint64_t dpbTimeNs;             // of the DPB steps only
+        uint64_t maxDpbTimeNs;
+        uint32_t medianDpbTimeNs;
+        uint32_t p99DpbTimeNs;
+    };
+
+    static const char* GetCodecName(VkVideoCodecOperationFlagBitsKHR codec);
+
+    // Returns nullptr if the codec is not one of the encode codecs.
+    static VkVideoGopSimulator* Create(const Config& config);
+    virtual ~VkVideoGopSimulator() {}
+
+    // Returns false if the codec can't be set up or a check failed.
+    bool Run();
+
+    const Stats& GetStats() const { return m_stats; }
+    // One line per configuration, for the sweeps.
+    void PrintSummary(FILE* fp = stdout) const;
+    void PrintReport(FILE* fp = stdout) const;
+
+protected:
+
+    // A frame on its way through the encoder, the fields of
+    // VkVideoEncodeFrameInfo that the DPB management uses.
+    struct SimFrame {
+        VkVideoGopStructure::GopPosition gopPosition;
+        uint64_t frameInputOrderNum;
+        uint64_t encodeNum;             // the encode order of the stream, set at the flush
+        uint32_t picOrderCntVal;
+        uint32_t idrSequence;           // IDR pictures before it, in input order
+        bool     isIdr;
+        bool     isReference;
+        bool     lastFrame;
+        bool     showExistingFrame;     // AV1
+
+        SimFrame()
+        : gopPosition(0)
+        , frameInputOrderNum(0)
+        , encodeNum(0)
+        , picOrderCntVal(0)
+        , idrSequence(0)
+        , isIdr(false)
+        , isReference(false)
+        , lastFrame(false)
+        , showExistingFrame(false) {}
+    };
+
+    struct SimRef {
+        int32_t  slot;
+        int32_t  dpbPicOrderCnt;        // as stored by the DPB
+        bool     markedAsReference;
+    };
+
+    // The result of a picture's DPB step.
+    struct DpbResult {
+        int32_t  setupSlot;             // the slot the picture is reconstructed to, -1 if none
+        int32_t  dpbPicOrderCnt;        // of the picture, as the DPB stores it
+        uint32_t numRefs[2];
+        SimRef   refs[2][MAX_REFS_PER_LIST];
+        uint32_t maxRefs[2];            // the limits of the lists
+        uint32_t dpbOccupancy;          // reference pictures held after the picture
+        bool     demotedToP;            // AV1: a B picture without backward reference
+
+        DpbResult()
+        : setupSlot(-1)
+        , dpbPicOrderCnt(0)
+        , numRefs()
+        , refs()
+        , maxRefs()
+        , dpbOccupancy(0)
+        , demotedToP(false) {}
+    };
+
+    explicit VkVideoGopSimulator(const Config& config);
+
+    virtual bool InitCodec() = 0;
+    virtual uint32_t GetPicOrderCnt(const SimFrame& frame) const = 0;
+    // The codec state updated by EncodeFrame(), in input order.
+    virtual void InputFrame(SimFrame& frame) { (void)frame; }
+    virtual void InsertOrdered(const SimFrame& frame);
+    // StartOfVideoCodingEncodeOrder(), then ProcessDpb() of each flushed frame.
+    virtual void StartOfEncodeOrder(SimFrame& frame) { (void)frame; }
+    virtual bool ProcessDpb(SimFrame& frame, DpbResult& result) = 0;
+    virtual uint32_t GetDpbCapacity() const = 0;
+
+    void ReportError(const SimFrame& frame, const char* format, ...);
+
+    // The picture is not decoded after the layer drop.
+    bool IsDroppedLayer(const SimFrame& frame) const {
+        return (m_config.decodedLayerCount > 0) && (frame.gopPosition.temporalLayer >= m_config.decodedLayerCount);
+    }
+
+    Config                   m_config;
+    VkVideoGopStructure      m_gopStructure;
+    std::vector<SimFrame>    m_deferredFrames;  // in encode order
+
+private:
+
+    // A reference picture, as the encoder put it in a DPB slot.
+    struct SlotShadow {
+        bool     valid;
+        uint64_t frameInputOrderNum;
+        uint32_t idrSequence;
+        uint32_t gopIndex;
+        uint32_t temporalLayer;
+        int32_t  dpbPicOrderCnt;
+    };
+
+    void EnqueueFrame(const SimFrame& frame);
+    void PushOrderedFrames();
+    void CheckReferences(const SimFrame& frame, const DpbResult& result);
+    void CheckIntraRefresh(const SimFrame& frame, const DpbResult& result);
+    void RecordDpbTime(uint64_t ns);
+    void FinishTimeStats();
+    uint32_t GetGopIndex(const SimFrame& frame) const;
+
+    uint32_t                 m_numDeferredRefFrames;
+    uint64_t                 m_encodeNum;
+    uint32_t                 m_idrSequence;
+    uint64_t                 m_refreshWaveStart;    // the recovery point of the current wave
+    uint32_t                 m_nextRefreshIndex;    // the band the next P picture refreshes
+    SlotShadow               m_slots[MAX_DPB_SLOTS];
+    std::vector<uint32_t>    m_timeHistogram;   // the last bucket counts the longer ones
+    Stats                    m_stats;
+};
+
+#endif /* _VKVIDEOGOPSIMULATOR_VKVIDEOGOPSIMULATOR_H_ */
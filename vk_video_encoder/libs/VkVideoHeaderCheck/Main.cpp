@@ -0,0 +1,84 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "VkVideoHeaderCheck.h"
+
+static void PrintHelp(const char* programName)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "Writes the encoder parameter sets and sequence headers, parses them back with the decoder\n"
+            "parser, without a Vulkan device, and compares the fields. The exit code is non-zero if a\n"
+            "case fails.\n"
+            "      --codec <codec>          h264, h265, av1 or all (default all)\n"
+            "      --maxErrors <n>          Errors printed per case (default 8)\n"
+            "  -v, --verbose                Also print the size of the headers of each case\n"
+            "  -h, --help                   Print this help\n",
+            programName);
+}
+
+int main(int argc, const char** argv)
+{
+    VkVideoHeaderCheck::Config config;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1) < argc;
+        if ((arg == "-h") || (arg == "--help")) {
+            PrintHelp(argv[0]);
+            return EXIT_SUCCESS;
+        } else if ((arg == "--codec") && hasValue) {
+            const std::string codec = argv[++i];
+            if (codec == "h264") {
+                config.codecMask = VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR;
+            } else if (codec == "h265") {
+                config.codecMask = VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR;
+            } else if (codec == "av1") {
+                config.codecMask = VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+            } else if (codec == "all") {
+                config.codecMask = VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR |
+                                   VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR |
+                                   VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+            } else {
+                fprintf(stderr, "Invalid codec %s\n", codec.c_str());
+                return EXIT_FAILURE;
+            }
+        } else if ((arg == "--maxErrors") && hasValue) {
+            config.maxReportedErrors = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "-v") || (arg == "--verbose")) {
+            config.verbose = true;
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument %s\n", arg.c_str());
+            PrintHelp(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    VkVideoHeaderCheck check(config);
+    const uint32_t numFailed = check.Run(stdout);
+    const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%u of %u configuration(s) failed, %.2f s\n", numFailed, check.GetNumCases(), elapsedSec);
+
+    return (numFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
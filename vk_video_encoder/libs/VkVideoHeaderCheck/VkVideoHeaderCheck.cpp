@@ -0,0 +1,1984 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <stdarg.h>
+#include <string.h>
+#include <algorithm>
+
+#include "VkVideoHeaderCheck.h"
+#include "NvVideoParser/nvVulkanVideoParser.h"
+#include "VkCodecUtils/VulkanBitstreamBufferHost.h"
+
+static const VkDeviceSize defaultMinBufferSize = 2 * 1024 * 1024;
+static const VkDeviceSize bitstreamBufferAlignment = 256;
+
+static void nvParserLog(const char* format, ...)
+{
+    va_list argptr;
+    va_start(argptr, format);
+    vfprintf(stderr, format, argptr);
+    va_end(argptr);
+}
+
+// Compares a field of the written and the parsed structure.
+#define CHECK_FIELD(written, parsed, field) Check(#field, (int64_t)(written).field, (int64_t)(parsed).field)
+
+// Names an element of an array field for the error reports.
+static const char* ElementName(char* name, size_t size, const char* field, uint32_t index)
+{
+    snprintf(name, size, "%s[%u]", field, index);
+    return name;
+}
+
+// Keeps the parameter sets the parser reports. The streams have no pictures,
+// so the picture callbacks are never called.
+class VkHeaderCheckParserClient : public VkParserVideoDecodeClient {
+public:
+    explicit VkHeaderCheckParserClient(std::vector<VkSharedBaseObj<StdVideoPictureParametersSet> >& parameterSets)
+    : m_parameterSets(parameterSets)
+    , m_bitstreamBuffers()
+    { }
+
+    virtual ~VkHeaderCheckParserClient() { }
+
+    virtual int32_t BeginSequence(const VkParserSequenceInfo*) { return 1; }
+    virtual bool AllocPictureBuffer(VkPicIf** ppPicBuf)
+    {
+        *ppPicBuf = nullptr;
+        return false;
+    }
+    virtual bool DecodePicture(VkParserPictureData*) { return false; }
+    virtual bool UpdatePictureParameters(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersObject,
+                                         VkSharedBaseObj<VkVideoRefCountBase>&)
+    {
+        m_parameterSets.push_back(pictureParametersObject);
+        return true;
+    }
+    virtual bool DisplayPicture(VkPicIf*, int64_t) { return false; }
+    virtual void UnhandledNALU(const uint8_t*, size_t) { }
+    virtual VkDeviceSize GetBitstreamBuffer(VkDeviceSize size,
+                                            VkDeviceSize minBitstreamBufferOffsetAlignment,
+                                            VkDeviceSize minBitstreamBufferSizeAlignment,
+                                            const uint8_t* pInitializeBufferMemory,
+                                            VkDeviceSize initializeBufferMemorySize,
+                                            VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer)
+    {
+        VkSharedBaseObj<VulkanBitstreamBufferHost> newBuffer;
+        VkResult result = VulkanBitstreamBufferHost::Create(std::max<VkDeviceSize>(size, defaultMinBufferSize),
+                                                            minBitstreamBufferOffsetAlignment,
+                                                            minBitstreamBufferSizeAlignment,
+                                                            pInitializeBufferMemory, initializeBufferMemorySize,
+                                                            newBuffer);
+        if (result != VK_SUCCESS) {
+            return 0;
+        }
+        m_bitstreamBuffers.push_back(newBuffer);
+        bitstreamBuffer = newBuffer;
+        return newBuffer->GetMaxSize();
+    }
+
+private:
+    std::vector<VkSharedBaseObj<StdVideoPictureParametersSet> >& m_parameterSets;
+    std::vector<VkSharedBaseObj<VulkanBitstreamBufferHost> >      m_bitstreamBuffers;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Cases
+
+struct VkVideoHeaderCheck::H264Case {
+    const char*                         name;
+    StdVideoH264SequenceParameterSet    sps;
+    StdVideoH264PictureParameterSet     pps;
+    StdVideoH264SequenceParameterSetVui vui;
+    StdVideoH264HrdParameters           hrd;
+    StdVideoH264ScalingLists            spsScalingLists;
+    StdVideoH264ScalingLists            ppsScalingLists;
+    int32_t                             offsetForRefFrame[255];
+};
+
+struct VkVideoHeaderCheck::H265Case {
+    enum { MAX_RPS = 8 };
+
+    const char*                         name;
+    StdVideoH265VideoParameterSet       vps;
+    StdVideoH265SequenceParameterSet    sps;
+    StdVideoH265PictureParameterSet     pps;
+    StdVideoH265ProfileTierLevel        ptl;
+    StdVideoH265DecPicBufMgr            vpsDpbMgr;
+    StdVideoH265DecPicBufMgr            spsDpbMgr;
+    StdVideoH265HrdParameters           vpsHrd;
+    StdVideoH265HrdParameters           spsHrd;
+    StdVideoH265SubLayerHrdParameters   vpsSubLayerHrdNal[STD_VIDEO_H265_SUBLAYERS_LIST_SIZE];
+    StdVideoH265SubLayerHrdParameters   vpsSubLayerHrdVcl[STD_VIDEO_H265_SUBLAYERS_LIST_SIZE];
+    StdVideoH265SubLayerHrdParameters   spsSubLayerHrdNal[STD_VIDEO_H265_SUBLAYERS_LIST_SIZE];
+    StdVideoH265SubLayerHrdParameters   spsSubLayerHrdVcl[STD_VIDEO_H265_SUBLAYERS_LIST_SIZE];
+    StdVideoH265SequenceParameterSetVui vui;
+    StdVideoH265ShortTermRefPicSet      stRps[MAX_RPS];
+    StdVideoH265LongTermRefPicsSps      ltRps;
+    StdVideoH265ScalingLists            spsScalingLists;
+    StdVideoH265ScalingLists            ppsScalingLists;
+};
+
+struct VkVideoHeaderCheck::Av1Case {
+    enum { MAX_OPERATING_POINTS = 4 };
+
+    const char*                         name;
+    StdVideoAV1SequenceHeader           seqHdr;
+    StdVideoAV1ColorConfig              colorConfig;
+    StdVideoAV1TimingInfo               timingInfo;
+    StdVideoEncodeAV1DecoderModelInfo   decoderModelInfo;
+    bool                                decoderModel;
+    uint32_t                            operatingPointCount;
+    StdVideoEncodeAV1OperatingPointInfo operatingPoints[MAX_OPERATING_POINTS];
+};
+
+// Fills a scaling list with factors from 1 to 255, with steps of both signs
+// beyond 127 that the delta coding has to wrap around.
+static void FillScalingList(uint8_t* pList, uint32_t size, uint32_t seed)
+{
+    for (uint32_t i = 0; i < size; i++) {
+        pList[i] = (uint8_t)(1 + ((seed * 37 + i * i * 13 + i * 59) % 255));
+    }
+}
+
+static void FillH264ScalingLists(StdVideoH264ScalingLists& lists, uint32_t seed)
+{
+    for (uint32_t i = 0; i < STD_VIDEO_H264_SCALING_LIST_4X4_NUM_LISTS; i++) {
+        FillScalingList(lists.ScalingList4x4[i], STD_VIDEO_H264_SCALING_LIST_4X4_NUM_ELEMENTS, seed + i);
+    }
+    for (uint32_t i = 0; i < STD_VIDEO_H264_SCALING_LIST_8X8_NUM_LISTS; i++) {
+        FillScalingList(lists.ScalingList8x8[i], STD_VIDEO_H264_SCALING_LIST_8X8_NUM_ELEMENTS, seed + 8 + i);
+    }
+}
+
+static void FillH265ScalingLists(StdVideoH265ScalingLists& lists, uint32_t seed)
+{
+    for (uint32_t i = 0; i < STD_VIDEO_H265_SCALING_LIST_4X4_NUM_LISTS; i++) {
+        FillScalingList(lists.ScalingList4x4[i], STD_VIDEO_H265_SCALING_LIST_4X4_NUM_ELEMENTS, seed + i);
+    }
+    for (uint32_t i = 0; i < STD_VIDEO_H265_SCALING_LIST_8X8_NUM_LISTS; i++) {
+        FillScalingList(lists.ScalingList8x8[i], STD_VIDEO_H265_SCALING_LIST_8X8_NUM_ELEMENTS, seed + 8 + i);
+    }
+    for (uint32_t i = 0; i < STD_VIDEO_H265_SCALING_LIST_16X16_NUM_LISTS; i++) {
+        FillScalingList(lists.ScalingList16x16[i], STD_VIDEO_H265_SCALING_LIST_16X16_NUM_ELEMENTS, seed + 16 + i);
+        lists.ScalingListDCCoef16x16[i] = (uint8_t)(1 + ((seed + i * 71) % 255));
+    }
+    for (uint32_t i = 0; i < STD_VIDEO_H265_SCALING_LIST_32X32_NUM_LISTS; i++) {
+        FillScalingList(lists.ScalingList32x32[i], STD_VIDEO_H265_SCALING_LIST_32X32_NUM_ELEMENTS, seed + 24 + i);
+        lists.ScalingListDCCoef32x32[i] = (uint8_t)(255 - ((seed + i * 53) % 255));
+    }
+}
+
+// The short term reference picture sets the way the parser keeps them: the
+// delta POCs of the pictures, instead of their differences minus 1.
+struct H265RefPicSetPocs {
+    uint32_t numNegativePics;
+    uint32_t numPositivePics;
+    int32_t  deltaPocS0[STD_VIDEO_H265_MAX_DPB_SIZE];
+    int32_t  deltaPocS1[STD_VIDEO_H265_MAX_DPB_SIZE];
+    uint32_t usedByCurrPicS0;
+    uint32_t usedByCurrPicS1;
+};
+
+// Derives the delta POCs of the SPS reference picture sets, with the inter
+// RPS prediction of the equations 7-61 and 7-62.
+static void GetH265RefPicSetPocs(const StdVideoH265ShortTermRefPicSet* pStRps, uint32_t numSets,
+                                 H265RefPicSetPocs* pPocs)
+{
+    for (uint32_t idx = 0; idx < numSets; idx++) {
+        const StdVideoH265ShortTermRefPicSet& rps = pStRps[idx];
+        H265RefPicSetPocs& pocs = pPocs[idx];
+        memset(&pocs, 0, sizeof(pocs));
+
+        if ((idx == 0) || !rps.flags.inter_ref_pic_set_prediction_flag) {
+            pocs.numNegativePics = rps.num_negative_pics;
+            pocs.numPositivePics = rps.num_positive_pics;
+            for (uint32_t i = 0; i < rps.num_negative_pics; i++) {
+                pocs.deltaPocS0[i] = ((i == 0) ? 0 : pocs.deltaPocS0[i - 1]) - (rps.delta_poc_s0_minus1[i] + 1);
+            }
+            for (uint32_t i = 0; i < rps.num_positive_pics; i++) {
+                pocs.deltaPocS1[i] = ((i == 0) ? 0 : pocs.deltaPocS1[i - 1]) + (rps.delta_poc_s1_minus1[i] + 1);
+            }
+            pocs.usedByCurrPicS0 = rps.used_by_curr_pic_s0_flag;
+            pocs.usedByCurrPicS1 = rps.used_by_curr_pic_s1_flag;
+            continue;
+        }
+
+        const H265RefPicSetPocs& ref = pPocs[idx - (rps.delta_idx_minus1 + 1)];
+        const int32_t deltaRps = (1 - 2 * (int32_t)rps.flags.delta_rps_sign) * (int32_t)(rps.abs_delta_rps_minus1 + 1);
+        const uint32_t numDeltaPocs = ref.numNegativePics + ref.numPositivePics;
+        const uint32_t useDelta = rps.use_delta_flag | rps.used_by_curr_pic_flag;
+        uint32_t i = 0;
+
+        for (int32_t j = (int32_t)ref.numPositivePics - 1; j >= 0; j--) {
+            const int32_t dPoc = ref.deltaPocS1[j] + deltaRps;
+            if ((dPoc < 0) && ((useDelta >> (ref.numNegativePics + j)) & 1)) {
+                pocs.usedByCurrPicS0 |= ((rps.used_by_curr_pic_flag >> (ref.numNegativePics + j)) & 1) << i;
+                pocs.deltaPocS0[i++] = dPoc;
+            }
+        }
+        if ((deltaRps < 0) && ((useDelta >> numDeltaPocs) & 1)) {
+            pocs.usedByCurrPicS0 |= ((rps.used_by_curr_pic_flag >> numDeltaPocs) & 1) << i;
+            pocs.deltaPocS0[i++] = deltaRps;
+        }
+        for (uint32_t j = 0; j < ref.numNegativePics; j++) {
+            const int32_t dPoc = ref.deltaPocS0[j] + deltaRps;
+            if ((dPoc < 0) && ((useDelta >> j) & 1)) {
+                pocs.usedByCurrPicS0 |= ((rps.used_by_curr_pic_flag >> j) & 1) << i;
+                pocs.deltaPocS0[i++] = dPoc;
+            }
+        }
+        pocs.numNegativePics = i;
+
+        i = 0;
+        for (int32_t j = (int32_t)ref.numNegativePics - 1; j >= 0; j--) {
+            const int32_t dPoc = ref.deltaPocS0[j] + deltaRps;
+            if ((dPoc > 0) && ((useDelta >> j) & 1)) {
+                pocs.usedByCurrPicS1 |= ((rps.used_by_curr_pic_flag >> j) & 1) << i;
+                pocs.deltaPocS1[i++] = dPoc;
+            }
+        }
+        if ((deltaRps > 0) && ((useDelta >> numDeltaPocs) & 1)) {
+            pocs.usedByCurrPicS1 |= ((rps.used_by_curr_pic_flag >> numDeltaPocs) & 1) << i;
+            pocs.deltaPocS1[i++] = deltaRps;
+        }
+        for (uint32_t j = 0; j < ref.numPositivePics; j++) {
+            const int32_t dPoc = ref.deltaPocS1[j] + deltaRps;
+            if ((dPoc > 0) && ((useDelta >> (ref.numNegativePics + j)) & 1)) {
+                pocs.usedByCurrPicS1 |= ((rps.used_by_curr_pic_flag >> (ref.numNegativePics + j)) & 1) << i;
+                pocs.deltaPocS1[i++] = dPoc;
+            }
+        }
+        pocs.numPositivePics = i;
+    }
+}
+
+bool VkVideoHeaderCheck::InitH264Case(uint32_t index, H264Case& c)
+{
+    memset(&c, 0, sizeof(c));
+    StdVideoH264SequenceParameterSet& sps = c.sps;
+    StdVideoH264PictureParameterSet& pps = c.pps;
+    StdVideoH264SequenceParameterSetVui& vui = c.vui;
+
+    // 1080p High profile with the inferred values of the fields that
+    // aren't sent, each case changes a part of it.
+    sps.profile_idc = STD_VIDEO_H264_PROFILE_IDC_HIGH;
+    sps.level_idc = STD_VIDEO_H264_LEVEL_IDC_4_1;
+    sps.chroma_format_idc = STD_VIDEO_H264_CHROMA_FORMAT_IDC_420;
+    sps.log2_max_frame_num_minus4 = 4;
+    sps.pic_order_cnt_type = STD_VIDEO_H264_POC_TYPE_0;
+    sps.log2_max_pic_order_cnt_lsb_minus4 = 4;
+    sps.max_num_ref_frames = 4;
+    sps.pic_width_in_mbs_minus1 = (1920 / 16) - 1;
+    sps.pic_height_in_map_units_minus1 = (1088 / 16) - 1;
+    sps.flags.frame_mbs_only_flag = 1;
+    sps.flags.direct_8x8_inference_flag = 1;
+    sps.flags.frame_cropping_flag = 1;
+    sps.frame_crop_bottom_offset = 4;
+
+    pps.flags.entropy_coding_mode_flag = 1;
+    pps.flags.deblocking_filter_control_present_flag = 1;
+    pps.weighted_bipred_idc = STD_VIDEO_H264_WEIGHTED_BIPRED_IDC_DEFAULT;
+
+    switch (index) {
+    case 0:
+        c.name = "h264 constrained baseline, poc type 2";
+        sps.profile_idc = STD_VIDEO_H264_PROFILE_IDC_BASELINE;
+        sps.level_idc = STD_VIDEO_H264_LEVEL_IDC_3_0;
+        sps.flags.constraint_set0_flag = 1;
+        sps.flags.constraint_set1_flag = 1;
+        sps.pic_order_cnt_type = STD_VIDEO_H264_POC_TYPE_2;
+        sps.log2_max_pic_order_cnt_lsb_minus4 = 0;
+        sps.max_num_ref_frames = 1;
+        sps.pic_width_in_mbs_minus1 = (1280 / 16) - 1;
+        sps.pic_height_in_map_units_minus1 = (720 / 16) - 1;
+        sps.flags.frame_cropping_flag = 0;
+        sps.frame_crop_bottom_offset = 0;
+        pps.flags.entropy_coding_mode_flag = 0;
+        break;
+    case 1:
+        c.name = "h264 main, vui";
+        sps.profile_idc = STD_VIDEO_H264_PROFILE_IDC_MAIN;
+        sps.level_idc = STD_VIDEO_H264_LEVEL_IDC_4_0;
+        sps.log2_max_pic_order_cnt_lsb_minus4 = 2;
+        sps.seq_parameter_set_id = 2;
+        sps.flags.vui_parameters_present_flag = 1;
+        sps.pSequenceParameterSetVui = &vui;
+        vui.flags.aspect_ratio_info_present_flag = 1;
+        vui.aspect_ratio_idc = STD_VIDEO_H264_ASPECT_RATIO_IDC_EXTENDED_SAR;
+        vui.sar_width = 4;
+        vui.sar_height = 3;
+        vui.flags.overscan_info_present_flag = 1;
+        vui.flags.overscan_appropriate_flag = 1;
+        vui.flags.video_signal_type_present_flag = 1;
+        vui.video_format = 5;
+        vui.flags.color_description_present_flag = 1;
+        vui.colour_primaries = 1;
+        vui.transfer_characteristics = 1;
+        vui.matrix_coefficients = 1;
+        vui.flags.chroma_loc_info_present_flag = 1;
+        vui.chroma_sample_loc_type_top_field = 1;
+        vui.chroma_sample_loc_type_bottom_field = 1;
+        vui.flags.timing_info_present_flag = 1;
+        vui.num_units_in_tick = 1001;
+        vui.time_scale = 60000;
+        vui.flags.fixed_frame_rate_flag = 1;
+        vui.flags.bitstream_restriction_flag = 1;
+        vui.max_num_reorder_frames = 2;
+        vui.max_dec_frame_buffering = 4;
+        pps.seq_parameter_set_id = 2;
+        pps.pic_parameter_set_id = 1;
+        pps.num_ref_idx_l0_default_active_minus1 = 2;
+        pps.weighted_bipred_idc = STD_VIDEO_H264_WEIGHTED_BIPRED_IDC_IMPLICIT;
+        pps.pic_init_qp_minus26 = -3;
+        pps.pic_init_qs_minus26 = 1;
+        pps.chroma_qp_index_offset = -2;
+        pps.second_chroma_qp_index_offset = -2;
+        break;
+    case 2:
+        c.name = "h264 high, interlaced, poc type 1";
+        sps.seq_parameter_set_id = 1;
+        sps.pic_order_cnt_type = STD_VIDEO_H264_POC_TYPE_1;
+        sps.log2_max_pic_order_cnt_lsb_minus4 = 0;
+        sps.offset_for_non_ref_pic = -2;
+        sps.offset_for_top_to_bottom_field = 1;
+        sps.num_ref_frames_in_pic_order_cnt_cycle = 3;
+        c.offsetForRefFrame[0] = 4;
+        c.offsetForRefFrame[1] = -1;
+        c.offsetForRefFrame[2] = 2;
+        sps.pOffsetForRefFrame = c.offsetForRefFrame;
+        sps.flags.frame_mbs_only_flag = 0;
+        sps.flags.mb_adaptive_frame_field_flag = 1;
+        sps.pic_height_in_map_units_minus1 = (1088 / 32) - 1;
+        sps.flags.gaps_in_frame_num_value_allowed_flag = 1;
+        pps.seq_parameter_set_id = 1;
+        pps.pic_parameter_set_id = 3;
+        pps.flags.bottom_field_pic_order_in_frame_present_flag = 1;
+        pps.flags.weighted_pred_flag = 1;
+        pps.weighted_bipred_idc = STD_VIDEO_H264_WEIGHTED_BIPRED_IDC_EXPLICIT;
+        pps.flags.transform_8x8_mode_flag = 1;
+        pps.flags.constrained_intra_pred_flag = 1;
+        pps.flags.redundant_pic_cnt_present_flag = 1;
+        pps.chroma_qp_index_offset = -1;
+        pps.second_chroma_qp_index_offset = 2;
+        break;
+    case 3:
+        c.name = "h264 high, scaling lists, hrd";
+        sps.level_idc = STD_VIDEO_H264_LEVEL_IDC_5_1;
+        sps.flags.seq_scaling_matrix_present_flag = 1;
+        sps.pScalingLists = &c.spsScalingLists;
+        FillH264ScalingLists(c.spsScalingLists, 3);
+        c.spsScalingLists.scaling_list_present_mask = 0xff;
+        c.spsScalingLists.use_default_scaling_matrix_mask = (1 << 2) | (1 << 6);
+        pps.flags.transform_8x8_mode_flag = 1;
+        pps.flags.pic_scaling_matrix_present_flag = 1;
+        pps.pScalingLists = &c.ppsScalingLists;
+        FillH264ScalingLists(c.ppsScalingLists, 100);
+        c.ppsScalingLists.scaling_list_present_mask = (1 << 0) | (1 << 1) | (1 << 4) | (1 << 6) | (1 << 7);
+        c.ppsScalingLists.use_default_scaling_matrix_mask = (1 << 1) | (1 << 7);
+        sps.flags.vui_parameters_present_flag = 1;
+        sps.pSequenceParameterSetVui = &vui;
+        vui.flags.timing_info_present_flag = 1;
+        vui.num_units_in_tick = 1;
+        vui.time_scale = 50;
+        vui.flags.nal_hrd_parameters_present_flag = 1;
+        vui.flags.vcl_hrd_parameters_present_flag = 1;
+        vui.pHrdParameters = &c.hrd;
+        c.hrd.cpb_cnt_minus1 = 1;
+        c.hrd.bit_rate_scale = 2;
+        c.hrd.cpb_size_scale = 3;
+        c.hrd.bit_rate_value_minus1[0] = 39062;
+        c.hrd.bit_rate_value_minus1[1] = 78124;
+        c.hrd.cpb_size_value_minus1[0] = 99999;
+        c.hrd.cpb_size_value_minus1[1] = 199999;
+        c.hrd.cbr_flag[1] = 1;
+        c.hrd.initial_cpb_removal_delay_length_minus1 = 23;
+        c.hrd.cpb_removal_delay_length_minus1 = 15;
+        c.hrd.dpb_output_delay_length_minus1 = 7;
+        c.hrd.time_offset_length = 24;
+        // A buffering of 0 gets replaced by the parser with the level limit.
+        vui.flags.bitstream_restriction_flag = 1;
+        break;
+    case 4:
+        c.name = "h264 high 4:4:4 10-bit, transform bypass";
+        sps.profile_idc = STD_VIDEO_H264_PROFILE_IDC_HIGH_444_PREDICTIVE;
+        sps.level_idc = STD_VIDEO_H264_LEVEL_IDC_5_2;
+        sps.chroma_format_idc = STD_VIDEO_H264_CHROMA_FORMAT_IDC_444;
+        sps.bit_depth_luma_minus8 = 2;
+        sps.bit_depth_chroma_minus8 = 2;
+        sps.flags.qpprime_y_zero_transform_bypass_flag = 1;
+        sps.frame_crop_bottom_offset = 8;
+        sps.seq_parameter_set_id = 31;
+        pps.seq_parameter_set_id = 31;
+        pps.pic_parameter_set_id = 255;
+        pps.flags.transform_8x8_mode_flag = 1;
+        pps.pic_init_qp_minus26 = -38;
+        pps.chroma_qp_index_offset = 12;
+        pps.second_chroma_qp_index_offset = -12;
+        break;
+    case 5:
+        c.name = "h264 high, 255 poc cycle offsets";
+        sps.level_idc = STD_VIDEO_H264_LEVEL_IDC_5_1;
+        sps.pic_order_cnt_type = STD_VIDEO_H264_POC_TYPE_1;
+        sps.log2_max_pic_order_cnt_lsb_minus4 = 0;
+        sps.flags.delta_pic_order_always_zero_flag = 0;
+        sps.offset_for_non_ref_pic = 1000;
+        sps.offset_for_top_to_bottom_field = -1000;
+        sps.num_ref_frames_in_pic_order_cnt_cycle = 255;
+        for (uint32_t i = 0; i < 255; i++) {
+            c.offsetForRefFrame[i] = (int32_t)((i * 7919) % 4001) - 2000;
+        }
+        sps.pOffsetForRefFrame = c.offsetForRefFrame;
+        sps.max_num_ref_frames = 16;
+        sps.log2_max_frame_num_minus4 = 12;
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+bool VkVideoHeaderCheck::InitH265Case(uint32_t index, H265Case& c)
+{
+    memset(&c, 0, sizeof(c));
+    StdVideoH265VideoParameterSet& vps = c.vps;
+    StdVideoH265SequenceParameterSet& sps = c.sps;
+    StdVideoH265PictureParameterSet& pps = c.pps;
+    StdVideoH265SequenceParameterSetVui& vui = c.vui;
+
+    // 1080p Main profile with 64x64 CTBs and the inferred values of the
+    // fields that aren't sent, each case changes a part of it.
+    c.ptl.general_profile_idc = STD_VIDEO_H265_PROFILE_IDC_MAIN;
+    c.ptl.general_level_idc = STD_VIDEO_H265_LEVEL_IDC_4_1;
+    c.ptl.flags.general_progressive_source_flag = 1;
+    c.ptl.flags.general_frame_only_constraint_flag = 1;
+
+    vps.flags.vps_temporal_id_nesting_flag = 1;
+    vps.flags.vps_sub_layer_ordering_info_present_flag = 1;
+    vps.pProfileTierLevel = &c.ptl;
+    vps.pDecPicBufMgr = &c.vpsDpbMgr;
+    c.vpsDpbMgr.max_dec_pic_buffering_minus1[0] = 4;
+    c.vpsDpbMgr.max_num_reorder_pics[0] = 2;
+
+    sps.flags.sps_temporal_id_nesting_flag = 1;
+    sps.flags.sps_sub_layer_ordering_info_present_flag = 1;
+    sps.pProfileTierLevel = &c.ptl;
+    sps.pDecPicBufMgr = &c.spsDpbMgr;
+    c.spsDpbMgr.max_dec_pic_buffering_minus1[0] = 4;
+    c.spsDpbMgr.max_num_reorder_pics[0] = 2;
+    sps.chroma_format_idc = STD_VIDEO_H265_CHROMA_FORMAT_IDC_420;
+    sps.pic_width_in_luma_samples = 1920;
+    sps.pic_height_in_luma_samples = 1080;
+    sps.log2_max_pic_order_cnt_lsb_minus4 = 4;
+    sps.log2_min_luma_coding_block_size_minus3 = 0;
+    sps.log2_diff_max_min_luma_coding_block_size = 3;
+    sps.log2_min_luma_transform_block_size_minus2 = 0;
+    sps.log2_diff_max_min_luma_transform_block_size = 3;
+    sps.max_transform_hierarchy_depth_inter = 2;
+    sps.max_transform_hierarchy_depth_intra = 2;
+    sps.flags.amp_enabled_flag = 1;
+    sps.flags.sample_adaptive_offset_enabled_flag = 1;
+    sps.flags.sps_temporal_mvp_enabled_flag = 1;
+    sps.flags.strong_intra_smoothing_enabled_flag = 1;
+
+    pps.flags.sign_data_hiding_enabled_flag = 1;
+    pps.flags.cabac_init_present_flag = 1;
+    pps.num_ref_idx_l0_default_active_minus1 = 3;
+    pps.flags.cu_qp_delta_enabled_flag = 1;
+    pps.diff_cu_qp_delta_depth = 1;
+    pps.flags.uniform_spacing_flag = 1;
+    pps.flags.loop_filter_across_tiles_enabled_flag = 1;
+    pps.flags.pps_loop_filter_across_slices_enabled_flag = 1;
+    pps.flags.deblocking_filter_control_present_flag = 1;
+    pps.flags.deblocking_filter_override_enabled_flag = 1;
+    pps.pps_beta_offset_div2 = 2;
+    pps.pps_tc_offset_div2 = -1;
+
+    switch (index) {
+    case 0:
+        c.name = "h265 main";
+        break;
+    case 1:
+        c.name = "h265 main 10, uniform tiles, vps timing";
+        c.ptl.general_profile_idc = STD_VIDEO_H265_PROFILE_IDC_MAIN_10;
+        c.ptl.general_level_idc = STD_VIDEO_H265_LEVEL_IDC_5_1;
+        c.ptl.flags.general_tier_flag = 1;
+        vps.vps_video_parameter_set_id = 3;
+        vps.flags.vps_timing_info_present_flag = 1;
+        vps.vps_num_units_in_tick = 1001;
+        vps.vps_time_scale = 60000;
+        vps.flags.vps_poc_proportional_to_timing_flag = 1;
+        vps.vps_num_ticks_poc_diff_one_minus1 = 1;
+        sps.sps_video_parameter_set_id = 3;
+        sps.sps_seq_parameter_set_id = 5;
+        sps.bit_depth_luma_minus8 = 2;
+        sps.bit_depth_chroma_minus8 = 2;
+        sps.pic_height_in_luma_samples = 1088;
+        sps.flags.conformance_window_flag = 1;
+        sps.conf_win_bottom_offset = 4;
+        pps.pps_seq_parameter_set_id = 5;
+        pps.pps_pic_parameter_set_id = 9;
+        pps.sps_video_parameter_set_id = 3;
+        pps.init_qp_minus26 = -38;
+        pps.flags.tiles_enabled_flag = 1;
+        pps.num_tile_columns_minus1 = 3;
+        pps.num_tile_rows_minus1 = 1;
+        pps.flags.loop_filter_across_tiles_enabled_flag = 0;
+        break;
+    case 2:
+        c.name = "h265 explicit tiles, wavefronts, dependent slices";
+        pps.flags.tiles_enabled_flag = 1;
+        pps.num_tile_columns_minus1 = 2;
+        pps.num_tile_rows_minus1 = 2;
+        pps.flags.uniform_spacing_flag = 0;
+        pps.column_width_minus1[0] = 9;
+        pps.column_width_minus1[1] = 11;
+        pps.row_height_minus1[0] = 4;
+        pps.row_height_minus1[1] = 6;
+        pps.flags.entropy_coding_sync_enabled_flag = 1;
+        pps.flags.dependent_slice_segments_enabled_flag = 1;
+        pps.flags.output_flag_present_flag = 1;
+        pps.num_extra_slice_header_bits = 2;
+        pps.flags.lists_modification_present_flag = 1;
+        pps.log2_parallel_merge_level_minus2 = 2;
+        pps.flags.slice_segment_header_extension_present_flag = 1;
+        pps.flags.transquant_bypass_enabled_flag = 1;
+        pps.flags.weighted_pred_flag = 1;
+        pps.flags.weighted_bipred_flag = 1;
+        pps.pps_cb_qp_offset = -3;
+        pps.pps_cr_qp_offset = 4;
+        pps.flags.pps_slice_chroma_qp_offsets_present_flag = 1;
+        pps.flags.pps_deblocking_filter_disabled_flag = 1;
+        pps.pps_beta_offset_div2 = 0;
+        pps.pps_tc_offset_div2 = 0;
+        pps.flags.transform_skip_enabled_flag = 1;
+        pps.flags.constrained_intra_pred_flag = 1;
+        pps.num_ref_idx_l1_default_active_minus1 = 1;
+        break;
+    case 3:
+        c.name = "h265 rps, long term, pcm, scaling, sub-layers";
+        vps.vps_max_sub_layers_minus1 = 2;
+        sps.sps_max_sub_layers_minus1 = 2;
+        for (uint32_t i = 0; i < 3; i++) {
+            c.vpsDpbMgr.max_dec_pic_buffering_minus1[i] = (uint8_t)(2 + i);
+            c.vpsDpbMgr.max_num_reorder_pics[i] = (uint8_t)i;
+            c.vpsDpbMgr.max_latency_increase_plus1[i] = (i == 2) ? 1 : 0;
+        }
+        // Only the values of the highest sub-layer are sent.
+        sps.flags.sps_sub_layer_ordering_info_present_flag = 0;
+        c.spsDpbMgr.max_dec_pic_buffering_minus1[2] = 5;
+        c.spsDpbMgr.max_num_reorder_pics[2] = 3;
+        c.spsDpbMgr.max_latency_increase_plus1[2] = 7;
+        sps.log2_max_pic_order_cnt_lsb_minus4 = 4;
+
+        sps.num_short_term_ref_pic_sets = 4;
+        sps.pShortTermRefPicSet = c.stRps;
+        // -1, -3 and +2.
+        c.stRps[0].num_negative_pics = 2;
+        c.stRps[0].delta_poc_s0_minus1[0] = 0;
+        c.stRps[0].delta_poc_s0_minus1[1] = 1;
+        c.stRps[0].used_by_curr_pic_s0_flag = 0x3;
+        c.stRps[0].num_positive_pics = 1;
+        c.stRps[0].delta_poc_s1_minus1[0] = 1;
+        c.stRps[0].used_by_curr_pic_s1_flag = 0x1;
+        // The set 0 moved by -1, without its +2 picture.
+        c.stRps[1].flags.inter_ref_pic_set_prediction_flag = 1;
+        c.stRps[1].flags.delta_rps_sign = 1;
+        c.stRps[1].abs_delta_rps_minus1 = 0;
+        c.stRps[1].used_by_curr_pic_flag = (1 << 0) | (1 << 2);
+        c.stRps[1].use_delta_flag = (1 << 1);
+        // -4, +1 and +2.
+        c.stRps[2].num_negative_pics = 1;
+        c.stRps[2].delta_poc_s0_minus1[0] = 3;
+        c.stRps[2].num_positive_pics = 2;
+        c.stRps[2].delta_poc_s1_minus1[0] = 0;
+        c.stRps[2].delta_poc_s1_minus1[1] = 0;
+        c.stRps[2].used_by_curr_pic_s1_flag = 0x1;
+        // The set 2 moved by +2.
+        c.stRps[3].flags.inter_ref_pic_set_prediction_flag = 1;
+        c.stRps[3].flags.delta_rps_sign = 0;
+        c.stRps[3].abs_delta_rps_minus1 = 1;
+        c.stRps[3].used_by_curr_pic_flag = 0xf;
+        {
+            // The writer reads the numbers of pictures of the sets the
+            // predicted ones refer to.
+            H265RefPicSetPocs pocs[H265Case::MAX_RPS];
+            GetH265RefPicSetPocs(c.stRps, sps.num_short_term_ref_pic_sets, pocs);
+            for (uint32_t i = 0; i < sps.num_short_term_ref_pic_sets; i++) {
+                c.stRps[i].num_negative_pics = (uint8_t)pocs[i].numNegativePics;
+                c.stRps[i].num_positive_pics = (uint8_t)pocs[i].numPositivePics;
+            }
+        }
+
+        sps.flags.long_term_ref_pics_present_flag = 1;
+        sps.num_long_term_ref_pics_sps = 2;
+        sps.pLongTermRefPicsSps = &c.ltRps;
+        c.ltRps.lt_ref_pic_poc_lsb_sps[0] = 5;
+        c.ltRps.lt_ref_pic_poc_lsb_sps[1] = 251;
+        c.ltRps.used_by_curr_pic_lt_sps_flag = 0x2;
+
+        sps.flags.pcm_enabled_flag = 1;
+        sps.pcm_sample_bit_depth_luma_minus1 = 7;
+        sps.pcm_sample_bit_depth_chroma_minus1 = 6;
+        sps.log2_min_pcm_luma_coding_block_size_minus3 = 0;
+        sps.log2_diff_max_min_pcm_luma_coding_block_size = 2;
+        sps.flags.pcm_loop_filter_disabled_flag = 1;
+
+        sps.flags.scaling_list_enabled_flag = 1;
+        sps.flags.sps_scaling_list_data_present_flag = 1;
+        sps.pScalingLists = &c.spsScalingLists;
+        FillH265ScalingLists(c.spsScalingLists, 7);
+        pps.flags.pps_scaling_list_data_present_flag = 1;
+        pps.pScalingLists = &c.ppsScalingLists;
+        FillH265ScalingLists(c.ppsScalingLists, 211);
+        sps.flags.amp_enabled_flag = 0;
+        sps.flags.strong_intra_smoothing_enabled_flag = 0;
+        break;
+    case 4:
+        c.name = "h265 vui, hrd";
+        vps.vps_max_sub_layers_minus1 = 1;
+        vps.flags.vps_temporal_id_nesting_flag = 0;
+        vps.flags.vps_sub_layer_ordering_info_present_flag = 0;
+        c.vpsDpbMgr.max_dec_pic_buffering_minus1[1] = 3;
+        c.vpsDpbMgr.max_num_reorder_pics[1] = 1;
+        vps.flags.vps_timing_info_present_flag = 1;
+        vps.vps_num_units_in_tick = 1001;
+        vps.vps_time_scale = 30000;
+        vps.pHrdParameters = &c.vpsHrd;
+        c.vpsHrd.flags.nal_hrd_parameters_present_flag = 1;
+        c.vpsHrd.pSubLayerHrdParametersNal = c.vpsSubLayerHrdNal;
+        c.vpsHrd.bit_rate_scale = 1;
+        c.vpsHrd.cpb_size_scale = 2;
+        c.vpsHrd.initial_cpb_removal_delay_length_minus1 = 20;
+        c.vpsHrd.au_cpb_removal_delay_length_minus1 = 10;
+        c.vpsHrd.dpb_output_delay_length_minus1 = 5;
+        c.vpsHrd.flags.fixed_pic_rate_within_cvs_flag = 0x1;
+        c.vpsHrd.elemental_duration_in_tc_minus1[0] = 1;
+        c.vpsHrd.flags.fixed_pic_rate_general_flag = 0x2;
+        c.vpsHrd.flags.fixed_pic_rate_within_cvs_flag |= 0x2;
+        c.vpsHrd.cpb_cnt_minus1[1] = 1;
+        for (uint32_t i = 0; i < 2; i++) {
+            for (uint32_t j = 0; j < 2; j++) {
+                c.vpsSubLayerHrdNal[i].bit_rate_value_minus1[j] = 10000 * (i + 1) + j;
+                c.vpsSubLayerHrdNal[i].cpb_size_value_minus1[j] = 30000 * (i + 1) + j;
+            }
+            c.vpsSubLayerHrdNal[i].cbr_flag = i;
+        }
+
+        sps.sps_max_sub_layers_minus1 = 1;
+        sps.flags.sps_temporal_id_nesting_flag = 0;
+        c.spsDpbMgr.max_dec_pic_buffering_minus1[1] = 3;
+        c.spsDpbMgr.max_num_reorder_pics[1] = 1;
+        sps.flags.vui_parameters_present_flag = 1;
+        sps.pSequenceParameterSetVui = &vui;
+        vui.flags.aspect_ratio_info_present_flag = 1;
+        vui.aspect_ratio_idc = STD_VIDEO_H265_ASPECT_RATIO_IDC_EXTENDED_SAR;
+        vui.sar_width = 64;
+        vui.sar_height = 45;
+        vui.flags.overscan_info_present_flag = 1;
+        vui.flags.video_signal_type_present_flag = 1;
+        vui.video_format = 1;
+        vui.flags.video_full_range_flag = 1;
+        vui.flags.colour_description_present_flag = 1;
+        vui.colour_primaries = 9;
+        vui.transfer_characteristics = 16;
+        vui.matrix_coeffs = 9;
+        vui.flags.chroma_loc_info_present_flag = 1;
+        vui.chroma_sample_loc_type_top_field = 2;
+        vui.chroma_sample_loc_type_bottom_field = 2;
+        vui.flags.frame_field_info_present_flag = 1;
+        vui.flags.default_display_window_flag = 1;
+        vui.def_disp_win_left_offset = 8;
+        vui.def_disp_win_right_offset = 8;
+        vui.flags.vui_timing_info_present_flag = 1;
+        vui.vui_num_units_in_tick = 1001;
+        vui.vui_time_scale = 30000;
+        vui.flags.vui_poc_proportional_to_timing_flag = 1;
+        vui.flags.vui_hrd_parameters_present_flag = 1;
+        vui.pHrdParameters = &c.spsHrd;
+        vui.flags.bitstream_restriction_flag = 1;
+        vui.flags.motion_vectors_over_pic_boundaries_flag = 1;
+        vui.flags.restricted_ref_pic_lists_flag = 1;
+        vui.max_bytes_per_pic_denom = 2;
+        vui.max_bits_per_min_cu_denom = 1;
+        vui.log2_max_mv_length_horizontal = 15;
+        vui.log2_max_mv_length_vertical = 15;
+
+        c.spsHrd.flags.nal_hrd_parameters_present_flag = 1;
+        c.spsHrd.flags.vcl_hrd_parameters_present_flag = 1;
+        c.spsHrd.pSubLayerHrdParametersNal = c.spsSubLayerHrdNal;
+        c.spsHrd.pSubLayerHrdParametersVcl = c.spsSubLayerHrdVcl;
+        c.spsHrd.flags.sub_pic_hrd_params_present_flag = 1;
+        c.spsHrd.tick_divisor_minus2 = 23;
+        c.spsHrd.du_cpb_removal_delay_increment_length_minus1 = 7;
+        c.spsHrd.flags.sub_pic_cpb_params_in_pic_timing_sei_flag = 1;
+        c.spsHrd.dpb_output_delay_du_length_minus1 = 4;
+        c.spsHrd.bit_rate_scale = 3;
+        c.spsHrd.cpb_size_scale = 5;
+        c.spsHrd.cpb_size_du_scale = 6;
+        c.spsHrd.initial_cpb_removal_delay_length_minus1 = 23;
+        c.spsHrd.au_cpb_removal_delay_length_minus1 = 15;
+        c.spsHrd.dpb_output_delay_length_minus1 = 15;
+        // Sub-layer 0 has a fixed picture rate, the within CVS flag is
+        // inferred from the general one.
+        c.spsHrd.flags.fixed_pic_rate_general_flag = 0x1;
+        c.spsHrd.flags.fixed_pic_rate_within_cvs_flag = 0x1;
+        c.spsHrd.cpb_cnt_minus1[0] = 1;
+        // Sub-layer 1 is low delay, its CPB count isn't sent and is inferred
+        // to be 1 whatever the structure holds.
+        c.spsHrd.flags.low_delay_hrd_flag = 0x2;
+        c.spsHrd.cpb_cnt_minus1[1] = 2;
+        for (uint32_t i = 0; i < 2; i++) {
+            for (uint32_t j = 0; j < 3; j++) {
+                c.spsSubLayerHrdNal[i].bit_rate_value_minus1[j] = 20000 * (i + 1) + j;
+                c.spsSubLayerHrdNal[i].cpb_size_value_minus1[j] = 40000 * (i + 1) + j;
+                c.spsSubLayerHrdNal[i].cpb_size_du_value_minus1[j] = 4000 * (i + 1) + j;
+                c.spsSubLayerHrdNal[i].bit_rate_du_value_minus1[j] = 2000 * (i + 1) + j;
+                c.spsSubLayerHrdVcl[i].bit_rate_value_minus1[j] = 18000 * (i + 1) + j;
+                c.spsSubLayerHrdVcl[i].cpb_size_value_minus1[j] = 36000 * (i + 1) + j;
+                c.spsSubLayerHrdVcl[i].cpb_size_du_value_minus1[j] = 3600 * (i + 1) + j;
+                c.spsSubLayerHrdVcl[i].bit_rate_du_value_minus1[j] = 1800 * (i + 1) + j;
+            }
+            c.spsSubLayerHrdNal[i].cbr_flag = 0x2;
+            c.spsSubLayerHrdVcl[i].cbr_flag = 0x1;
+        }
+        break;
+    case 5:
+        c.name = "h265 range extensions, 4:4:4 12-bit";
+        c.ptl.general_profile_idc = STD_VIDEO_H265_PROFILE_IDC_FORMAT_RANGE_EXTENSIONS;
+        c.ptl.general_level_idc = STD_VIDEO_H265_LEVEL_IDC_5_1;
+        sps.chroma_format_idc = STD_VIDEO_H265_CHROMA_FORMAT_IDC_444;
+        sps.bit_depth_luma_minus8 = 4;
+        sps.bit_depth_chroma_minus8 = 4;
+        sps.pic_width_in_luma_samples = 1280;
+        sps.pic_height_in_luma_samples = 720;
+        sps.log2_diff_max_min_luma_coding_block_size = 2;
+        sps.log2_diff_max_min_luma_transform_block_size = 2;
+        sps.flags.sps_extension_present_flag = 1;
+        sps.flags.sps_range_extension_flag = 1;
+        sps.flags.transform_skip_rotation_enabled_flag = 1;
+        sps.flags.transform_skip_context_enabled_flag = 1;
+        sps.flags.implicit_rdpcm_enabled_flag = 1;
+        sps.flags.explicit_rdpcm_enabled_flag = 1;
+        sps.flags.extended_precision_processing_flag = 1;
+        sps.flags.intra_smoothing_disabled_flag = 1;
+        sps.flags.high_precision_offsets_enabled_flag = 1;
+        sps.flags.persistent_rice_adaptation_enabled_flag = 1;
+        sps.flags.cabac_bypass_alignment_enabled_flag = 1;
+        pps.init_qp_minus26 = -50;
+        pps.flags.transform_skip_enabled_flag = 1;
+        pps.flags.pps_extension_present_flag = 1;
+        pps.flags.pps_range_extension_flag = 1;
+        pps.log2_max_transform_skip_block_size_minus2 = 2;
+        pps.flags.cross_component_prediction_enabled_flag = 1;
+        pps.flags.chroma_qp_offset_list_enabled_flag = 1;
+        pps.diff_cu_chroma_qp_offset_depth = 1;
+        pps.chroma_qp_offset_list_len_minus1 = 2;
+        pps.cb_qp_offset_list[0] = -2;
+        pps.cb_qp_offset_list[1] = 1;
+        pps.cb_qp_offset_list[2] = 12;
+        pps.cr_qp_offset_list[0] = 2;
+        pps.cr_qp_offset_list[1] = -1;
+        pps.cr_qp_offset_list[2] = -12;
+        pps.log2_sao_offset_scale_luma = 2;
+        pps.log2_sao_offset_scale_chroma = 1;
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+bool VkVideoHeaderCheck::InitAv1Case(uint32_t index, Av1Case& c)
+{
+    memset(&c, 0, sizeof(c));
+    StdVideoAV1SequenceHeader& seqHdr = c.seqHdr;
+    StdVideoAV1ColorConfig& colorConfig = c.colorConfig;
+
+    // 1080p 8-bit 4:2:0 Main profile with the inferred values of the fields
+    // that aren't sent, each case changes a part of it.
+    seqHdr.seq_profile = STD_VIDEO_AV1_PROFILE_MAIN;
+    seqHdr.frame_width_bits_minus_1 = 10;
+    seqHdr.frame_height_bits_minus_1 = 10;
+    seqHdr.max_frame_width_minus_1 = 1920 - 1;
+    seqHdr.max_frame_height_minus_1 = 1080 - 1;
+    seqHdr.flags.enable_filter_intra = 1;
+    seqHdr.flags.enable_intra_edge_filter = 1;
+    seqHdr.flags.enable_interintra_compound = 1;
+    seqHdr.flags.enable_masked_compound = 1;
+    seqHdr.flags.enable_dual_filter = 1;
+    seqHdr.flags.enable_order_hint = 1;
+    seqHdr.flags.enable_jnt_comp = 1;
+    seqHdr.flags.enable_ref_frame_mvs = 1;
+    seqHdr.seq_force_screen_content_tools = STD_VIDEO_AV1_SELECT_SCREEN_CONTENT_TOOLS;
+    seqHdr.seq_force_integer_mv = STD_VIDEO_AV1_SELECT_INTEGER_MV;
+    seqHdr.order_hint_bits_minus_1 = 6;
+    seqHdr.flags.enable_cdef = 1;
+    seqHdr.flags.enable_restoration = 1;
+    seqHdr.pColorConfig = &colorConfig;
+
+    colorConfig.BitDepth = 8;
+    colorConfig.subsampling_x = 1;
+    colorConfig.subsampling_y = 1;
+    colorConfig.color_primaries = STD_VIDEO_AV1_COLOR_PRIMARIES_BT_UNSPECIFIED;
+    colorConfig.transfer_characteristics = STD_VIDEO_AV1_TRANSFER_CHARACTERISTICS_UNSPECIFIED;
+    colorConfig.matrix_coefficients = STD_VIDEO_AV1_MATRIX_COEFFICIENTS_UNSPECIFIED;
+
+    c.operatingPointCount = 1;
+    c.operatingPoints[0].seq_level_idx = STD_VIDEO_AV1_LEVEL_4_0;
+
+    switch (index) {
+    case 0:
+        c.name = "av1 main 8-bit, bt.709";
+        colorConfig.flags.color_description_present_flag = 1;
+        colorConfig.color_primaries = STD_VIDEO_AV1_COLOR_PRIMARIES_BT_709;
+        colorConfig.transfer_characteristics = STD_VIDEO_AV1_TRANSFER_CHARACTERISTICS_BT_709;
+        colorConfig.matrix_coefficients = STD_VIDEO_AV1_MATRIX_COEFFICIENTS_BT_709;
+        colorConfig.chroma_sample_position = STD_VIDEO_AV1_CHROMA_SAMPLE_POSITION_VERTICAL;
+        break;
+    case 1:
+        c.name = "av1 main 10-bit monochrome, all tools";
+        colorConfig.BitDepth = 10;
+        colorConfig.flags.mono_chrome = 1;
+        colorConfig.flags.color_range = 1;
+        seqHdr.flags.use_128x128_superblock = 1;
+        seqHdr.flags.enable_warped_motion = 1;
+        seqHdr.flags.enable_superres = 1;
+        seqHdr.flags.film_grain_params_present = 1;
+        seqHdr.seq_force_screen_content_tools = 0;
+        seqHdr.order_hint_bits_minus_1 = 7;
+        // The timing info is sent without a decoder model, and the single
+        // operating point gets the level 31 of the writer.
+        seqHdr.flags.timing_info_present_flag = 1;
+        seqHdr.pTimingInfo = &c.timingInfo;
+        c.timingInfo.num_units_in_display_tick = 1001;
+        c.timingInfo.time_scale = 60000;
+        c.timingInfo.flags.equal_picture_interval = 1;
+        c.timingInfo.num_ticks_per_picture_minus_1 = 1;
+        c.operatingPointCount = 0;
+        break;
+    case 2:
+        c.name = "av1 high 4:4:4, srgb, screen content";
+        seqHdr.seq_profile = STD_VIDEO_AV1_PROFILE_HIGH;
+        colorConfig.flags.color_description_present_flag = 1;
+        colorConfig.color_primaries = STD_VIDEO_AV1_COLOR_PRIMARIES_BT_709;
+        colorConfig.transfer_characteristics = STD_VIDEO_AV1_TRANSFER_CHARACTERISTICS_SRGB;
+        colorConfig.matrix_coefficients = STD_VIDEO_AV1_MATRIX_COEFFICIENTS_IDENTITY;
+        colorConfig.flags.color_range = 1;
+        colorConfig.subsampling_x = 0;
+        colorConfig.subsampling_y = 0;
+        colorConfig.flags.separate_uv_delta_q = 1;
+        seqHdr.seq_force_screen_content_tools = 1;
+        seqHdr.seq_force_integer_mv = 0;
+        seqHdr.flags.enable_order_hint = 0;
+        seqHdr.flags.enable_jnt_comp = 0;
+        seqHdr.flags.enable_ref_frame_mvs = 0;
+        seqHdr.order_hint_bits_minus_1 = 0;
+        c.operatingPoints[0].seq_level_idx = STD_VIDEO_AV1_LEVEL_5_1;
+        c.operatingPoints[0].seq_tier = 1;
+        break;
+    case 3:
+        c.name = "av1 professional 12-bit 4:2:0, operating points";
+        seqHdr.seq_profile = STD_VIDEO_AV1_PROFILE_PROFESSIONAL;
+        colorConfig.BitDepth = 12;
+        colorConfig.chroma_sample_position = STD_VIDEO_AV1_CHROMA_SAMPLE_POSITION_COLOCATED;
+        seqHdr.frame_width_bits_minus_1 = 12;
+        seqHdr.frame_height_bits_minus_1 = 11;
+        seqHdr.max_frame_width_minus_1 = 4096 - 1;
+        seqHdr.max_frame_height_minus_1 = 2160 - 1;
+        seqHdr.flags.frame_id_numbers_present_flag = 1;
+        seqHdr.delta_frame_id_length_minus_2 = 5;
+        seqHdr.additional_frame_id_length_minus_1 = 3;
+        seqHdr.flags.timing_info_present_flag = 1;
+        seqHdr.pTimingInfo = &c.timingInfo;
+        c.timingInfo.num_units_in_display_tick = 1;
+        c.timingInfo.time_scale = 24;
+        c.decoderModel = true;
+        c.decoderModelInfo.buffer_delay_length_minus_1 = 9;
+        c.decoderModelInfo.num_units_in_decoding_tick = 1;
+        c.decoderModelInfo.buffer_removal_time_length_minus_1 = 9;
+        c.decoderModelInfo.frame_presentation_time_length_minus_1 = 9;
+        seqHdr.flags.initial_display_delay_present_flag = 1;
+        c.operatingPointCount = 3;
+        c.operatingPoints[0].operating_point_idc = 0x307;
+        c.operatingPoints[0].seq_level_idx = STD_VIDEO_AV1_LEVEL_5_0;
+        c.operatingPoints[0].seq_tier = 1;
+        c.operatingPoints[0].flags.decoder_model_present_for_this_op = 1;
+        c.operatingPoints[0].decoder_buffer_delay = 700;
+        c.operatingPoints[0].encoder_buffer_delay = 300;
+        c.operatingPoints[0].flags.initial_display_delay_present_for_this_op = 1;
+        c.operatingPoints[0].initial_display_delay_minus_1 = 9;
+        c.operatingPoints[1].operating_point_idc = 0x103;
+        c.operatingPoints[1].seq_level_idx = STD_VIDEO_AV1_LEVEL_4_1;
+        c.operatingPoints[1].flags.decoder_model_present_for_this_op = 1;
+        c.operatingPoints[1].decoder_buffer_delay = 1000;
+        c.operatingPoints[1].encoder_buffer_delay = 23;
+        c.operatingPoints[1].flags.low_delay_mode_flag = 1;
+        c.operatingPoints[2].operating_point_idc = 0x101;
+        c.operatingPoints[2].seq_level_idx = STD_VIDEO_AV1_LEVEL_3_1;
+        c.operatingPoints[2].flags.initial_display_delay_present_for_this_op = 1;
+        c.operatingPoints[2].initial_display_delay_minus_1 = 3;
+        break;
+    case 4:
+        c.name = "av1 professional 10-bit 4:2:2";
+        seqHdr.seq_profile = STD_VIDEO_AV1_PROFILE_PROFESSIONAL;
+        colorConfig.BitDepth = 10;
+        colorConfig.subsampling_x = 1;
+        colorConfig.subsampling_y = 0;
+        colorConfig.flags.color_description_present_flag = 1;
+        colorConfig.color_primaries = STD_VIDEO_AV1_COLOR_PRIMARIES_BT_2020;
+        colorConfig.transfer_characteristics = STD_VIDEO_AV1_TRANSFER_CHARACTERISTICS_SMPTE_2084;
+        colorConfig.matrix_coefficients = STD_VIDEO_AV1_MATRIX_COEFFICIENTS_BT_2020_NCL;
+        colorConfig.flags.separate_uv_delta_q = 1;
+        break;
+    case 5:
+        c.name = "av1 reduced still picture header";
+        seqHdr.flags.still_picture = 1;
+        seqHdr.flags.reduced_still_picture_header = 1;
+        seqHdr.flags.use_128x128_superblock = 1;
+        seqHdr.flags.enable_filter_intra = 0;
+        seqHdr.flags.enable_interintra_compound = 0;
+        seqHdr.flags.enable_masked_compound = 0;
+        seqHdr.flags.enable_dual_filter = 0;
+        seqHdr.flags.enable_order_hint = 0;
+        seqHdr.flags.enable_jnt_comp = 0;
+        seqHdr.flags.enable_ref_frame_mvs = 0;
+        seqHdr.order_hint_bits_minus_1 = 0;
+        seqHdr.flags.enable_restoration = 0;
+        c.operatingPoints[0].seq_level_idx = STD_VIDEO_AV1_LEVEL_3_1;
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Runs
+
+VkVideoHeaderCheck::VkVideoHeaderCheck(const Config& config)
+    : m_config(config)
+    , m_numCases(0)
+    , m_numErrors(0)
+    , m_caseName("")
+{
+}
+
+uint32_t VkVideoHeaderCheck::Run(FILE* fp)
+{
+    uint32_t numFailed = 0;
+    m_numCases = 0;
+
+    if (m_config.codecMask & VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR) {
+        H264Case c;
+        for (uint32_t i = 0; InitH264Case(i, c); i++) {
+            m_numCases++;
+            numFailed += RunH264Case(c, fp) ? 0 : 1;
+        }
+    }
+    if (m_config.codecMask & VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR) {
+        H265Case c;
+        for (uint32_t i = 0; InitH265Case(i, c); i++) {
+            m_numCases++;
+            numFailed += RunH265Case(c, fp) ? 0 : 1;
+        }
+    }
+    if (m_config.codecMask & VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+        Av1Case c;
+        for (uint32_t i = 0; InitAv1Case(i, c); i++) {
+            m_numCases++;
+            numFailed += RunAv1Case(c, fp) ? 0 : 1;
+        }
+    }
+
+    return numFailed;
+}
+
+bool VkVideoHeaderCheck::Parse(VkVideoCodecOperationFlagBitsKHR codec, const std::vector<uint8_t>& stream,
+                               std::vector<VkSharedBaseObj<StdVideoPictureParametersSet> >& parameterSets)
+{
+    static const VkExtensionProperties h264StdExtensionVersion = { VK_STD_VULKAN_VIDEO_CODEC_H264_DECODE_EXTENSION_NAME, VK_STD_VULKAN_VIDEO_CODEC_H264_DECODE_SPEC_VERSION };
+    static const VkExtensionProperties h265StdExtensionVersion = { VK_STD_VULKAN_VIDEO_CODEC_H265_DECODE_EXTENSION_NAME, VK_STD_VULKAN_VIDEO_CODEC_H265_DECODE_SPEC_VERSION };
+    static const VkExtensionProperties av1StdExtensionVersion = { VK_STD_VULKAN_VIDEO_CODEC_AV1_DECODE_EXTENSION_NAME, VK_STD_VULKAN_VIDEO_CODEC_AV1_DECODE_SPEC_VERSION };
+
+    const VkExtensionProperties* pStdExtensionVersion = &h264StdExtensionVersion;
+    if (codec == VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR) {
+        pStdExtensionVersion = &h265StdExtensionVersion;
+    } else if (codec == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+        pStdExtensionVersion = &av1StdExtensionVersion;
+    }
+
+    // The parser keeps a reference to the client, it goes away first.
+    VkHeaderCheckParserClient client(parameterSets);
+    {
+        VkParserInitDecodeParameters nvdp;
+        memset(&nvdp, 0, sizeof(nvdp));
+        nvdp.interfaceVersion = NV_VULKAN_VIDEO_PARSER_API_VERSION;
+        nvdp.pClient = &client;
+        nvdp.defaultMinBufferSize = (uint32_t)defaultMinBufferSize;
+        nvdp.bufferOffsetAlignment = (uint32_t)bitstreamBufferAlignment;
+        nvdp.bufferSizeAlignment = (uint32_t)bitstreamBufferAlignment;
+        nvdp.outOfBandPictureParameters = true;
+
+        VkSharedBaseObj<VulkanVideoDecodeParser> parser;
+        VkResult result = CreateVulkanVideoDecodeParser(codec, pStdExtensionVersion, &nvParserLog, 0, &nvdp, parser);
+        if (result != VK_SUCCESS) {
+            ReportError("the parser could not be created (%d)", result);
+            return false;
+        }
+
+        VkParserBitstreamPacket pkt;
+        memset(&pkt, 0, sizeof(pkt));
+        pkt.pByteStream = stream.data();
+        pkt.nDataLength = stream.size();
+        pkt.bEOP = true;
+
+        size_t parsedBytes = 0;
+        if (!parser->ParseByteStream(&pkt, &parsedBytes)) {
+            ReportError("the parser failed on the stream");
+            return false;
+        }
+
+        memset(&pkt, 0, sizeof(pkt));
+        pkt.bEOS = true;
+        if (!parser->ParseByteStream(&pkt, &parsedBytes)) {
+            ReportError("the parser failed at the end of the stream");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void VkVideoHeaderCheck::BeginCase(const char* name)
+{
+    m_caseName = name;
+    m_numErrors = 0;
+}
+
+bool VkVideoHeaderCheck::EndCase(size_t headerSize, FILE* fp)
+{
+    if (m_config.verbose) {
+        fprintf(fp, "%-56s %5u bytes  %s\n", m_caseName, (uint32_t)headerSize, (m_numErrors == 0) ? "ok" : "FAILED");
+    } else {
+        fprintf(fp, "%-56s %s\n", m_caseName, (m_numErrors == 0) ? "ok" : "FAILED");
+    }
+    if (m_numErrors > m_config.maxReportedErrors) {
+        fprintf(stderr, "%s: %u more error(s)\n", m_caseName, m_numErrors - m_config.maxReportedErrors);
+    }
+    return (m_numErrors == 0);
+}
+
+bool VkVideoHeaderCheck::RunH264Case(const H264Case& c, FILE* fp)
+{
+    BeginCase(c.name);
+
+    std::vector<uint8_t> stream;
+    if (!VkEncoderHeaderWriter::AppendH264ParameterSets(&c.sps, &c.pps, stream)) {
+        ReportError("the parameter sets could not be written");
+        return EndCase(0, fp);
+    }
+
+    std::vector<VkSharedBaseObj<StdVideoPictureParametersSet> > parameterSets;
+    if (Parse(VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR, stream, parameterSets)) {
+        const StdVideoH264SequenceParameterSet* pSps = nullptr;
+        const StdVideoH264PictureParameterSet* pPps = nullptr;
+        for (size_t i = 0; i < parameterSets.size(); i++) {
+            if (parameterSets[i]->GetStdType() == StdVideoPictureParametersSet::TYPE_H264_SPS) {
+                pSps = parameterSets[i]->GetStdH264Sps();
+            } else if (parameterSets[i]->GetStdType() == StdVideoPictureParametersSet::TYPE_H264_PPS) {
+                pPps = parameterSets[i]->GetStdH264Pps();
+            }
+        }
+
+        if (pSps == nullptr) {
+            ReportError("the SPS was not reported");
+        } else {
+            CompareH264Sps(c.sps, *pSps);
+        }
+        if (pPps == nullptr) {
+            ReportError("the PPS was not reported");
+        } else {
+            CompareH264Pps(c.pps, *pPps);
+        }
+    }
+
+    return EndCase(stream.size(), fp);
+}
+
+bool VkVideoHeaderCheck::RunH265Case(const H265Case& c, FILE* fp)
+{
+    BeginCase(c.name);
+
+    std::vector<uint8_t> stream;
+    if (!VkEncoderHeaderWriter::AppendH265ParameterSets(&c.vps, &c.sps, &c.pps, stream)) {
+        ReportError("the parameter sets could not be written");
+        return EndCase(0, fp);
+    }
+
+    std::vector<VkSharedBaseObj<StdVideoPictureParametersSet> > parameterSets;
+    if (Parse(VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR, stream, parameterSets)) {
+        const StdVideoH265VideoParameterSet* pVps = nullptr;
+        const StdVideoH265SequenceParameterSet* pSps = nullptr;
+        const StdVideoH265PictureParameterSet* pPps = nullptr;
+        for (size_t i = 0; i < parameterSets.size(); i++) {
+            switch (parameterSets[i]->GetStdType()) {
+            case StdVideoPictureParametersSet::TYPE_H265_VPS:
+                pVps = parameterSets[i]->GetStdH265Vps();
+                break;
+            case StdVideoPictureParametersSet::TYPE_H265_SPS:
+                pSps = parameterSets[i]->GetStdH265Sps();
+                break;
+            case StdVideoPictureParametersSet::TYPE_H265_PPS:
+                pPps = parameterSets[i]->GetStdH265Pps();
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (pVps == nullptr) {
+            ReportError("the VPS was not reported");
+        } else {
+            CompareH265Vps(c.vps, *pVps);
+        }
+        if (pSps == nullptr) {
+            ReportError("the SPS was not reported");
+        } else {
+            CompareH265Sps(c.sps, *pSps);
+        }
+        if (pPps == nullptr) {
+            ReportError("the PPS was not reported");
+        } else {
+            CompareH265Pps(c.pps, *pPps);
+        }
+    }
+
+    return EndCase(stream.size(), fp);
+}
+
+bool VkVideoHeaderCheck::RunAv1Case(const Av1Case& c, FILE* fp)
+{
+    BeginCase(c.name);
+
+    std::vector<uint8_t> stream;
+    if (!VkEncoderHeaderWriter::AppendAv1SequenceHeader(&c.seqHdr, c.decoderModel ? &c.decoderModelInfo : nullptr,
+                                                        c.operatingPointCount, c.operatingPoints, stream)) {
+        ReportError("the sequence header could not be written");
+        return EndCase(0, fp);
+    }
+
+    std::vector<VkSharedBaseObj<StdVideoPictureParametersSet> > parameterSets;
+    if (Parse(VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR, stream, parameterSets)) {
+        const StdVideoAV1SequenceHeader* pSeqHdr = nullptr;
+        for (size_t i = 0; i < parameterSets.size(); i++) {
+            if (parameterSets[i]->GetStdType() == StdVideoPictureParametersSet::TYPE_AV1_SPS) {
+                pSeqHdr = parameterSets[i]->GetStdAV1Sps();
+            }
+        }
+
+        if (pSeqHdr == nullptr) {
+            ReportError("the sequence header was not reported");
+        } else {
+            CompareAv1SequenceHeader(c.seqHdr, *pSeqHdr);
+        }
+    }
+
+    return EndCase(stream.size(), fp);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// H.264
+
+void VkVideoHeaderCheck::CompareH264Sps(const StdVideoH264SequenceParameterSet& written,
+                                        const StdVideoH264SequenceParameterSet& parsed)
+{
+    CHECK_FIELD(written, parsed, profile_idc);
+    CHECK_FIELD(written, parsed, flags.constraint_set0_flag);
+    CHECK_FIELD(written, parsed, flags.constraint_set1_flag);
+    CHECK_FIELD(written, parsed, flags.constraint_set2_flag);
+    CHECK_FIELD(written, parsed, flags.constraint_set3_flag);
+    CHECK_FIELD(written, parsed, flags.constraint_set4_flag);
+    CHECK_FIELD(written, parsed, flags.constraint_set5_flag);
+    CHECK_FIELD(written, parsed, level_idc);
+    CHECK_FIELD(written, parsed, seq_parameter_set_id);
+    CHECK_FIELD(written, parsed, chroma_format_idc);
+    CHECK_FIELD(written, parsed, flags.separate_colour_plane_flag);
+    CHECK_FIELD(written, parsed, bit_depth_luma_minus8);
+    CHECK_FIELD(written, parsed, bit_depth_chroma_minus8);
+    CHECK_FIELD(written, parsed, flags.qpprime_y_zero_transform_bypass_flag);
+
+    const bool scalingMatrix = written.flags.seq_scaling_matrix_present_flag && (written.pScalingLists != nullptr);
+    Check("flags.seq_scaling_matrix_present_flag", scalingMatrix, parsed.flags.seq_scaling_matrix_present_flag);
+    CheckPresent("pScalingLists", scalingMatrix, parsed.pScalingLists != nullptr);
+    if (scalingMatrix && (parsed.pScalingLists != nullptr)) {
+        // The parser reads the 8 lists of the 4:2:0 and 4:2:2 formats.
+        CompareH264ScalingLists("SPS", written.pScalingLists, parsed.pScalingLists, 8);
+    }
+
+    CHECK_FIELD(written, parsed, log2_max_frame_num_minus4);
+    CHECK_FIELD(written, parsed, pic_order_cnt_type);
+    if (written.pic_order_cnt_type == STD_VIDEO_H264_POC_TYPE_0) {
+        CHECK_FIELD(written, parsed, log2_max_pic_order_cnt_lsb_minus4);
+    } else if (written.pic_order_cnt_type == STD_VIDEO_H264_POC_TYPE_1) {
+        CHECK_FIELD(written, parsed, flags.delta_pic_order_always_zero_flag);
+        CHECK_FIELD(written, parsed, offset_for_non_ref_pic);
+        CHECK_FIELD(written, parsed, offset_for_top_to_bottom_field);
+        CHECK_FIELD(written, parsed, num_ref_frames_in_pic_order_cnt_cycle);
+        CheckPresent("pOffsetForRefFrame", true, parsed.pOffsetForRefFrame != nullptr);
+        if (parsed.pOffsetForRefFrame != nullptr) {
+            const uint32_t numRefFrames = std::min(written.num_ref_frames_in_pic_order_cnt_cycle,
+                                                   parsed.num_ref_frames_in_pic_order_cnt_cycle);
+            for (uint32_t i = 0; i < numRefFrames; i++) {
+                char name[64];
+                Check(ElementName(name, sizeof(name), "pOffsetForRefFrame", i),
+                      written.pOffsetForRefFrame[i], parsed.pOffsetForRefFrame[i]);
+            }
+        }
+    }
+    CHECK_FIELD(written, parsed, max_num_ref_frames);
+    CHECK_FIELD(written, parsed, flags.gaps_in_frame_num_value_allowed_flag);
+    CHECK_FIELD(written, parsed, pic_width_in_mbs_minus1);
+    CHECK_FIELD(written, parsed, pic_height_in_map_units_minus1);
+    CHECK_FIELD(written, parsed, flags.frame_mbs_only_flag);
+    CHECK_FIELD(written, parsed, flags.mb_adaptive_frame_field_flag);
+    CHECK_FIELD(written, parsed, flags.direct_8x8_inference_flag);
+    CHECK_FIELD(written, parsed, flags.frame_cropping_flag);
+    if (written.flags.frame_cropping_flag) {
+        CHECK_FIELD(written, parsed, frame_crop_left_offset);
+        CHECK_FIELD(written, parsed, frame_crop_right_offset);
+        CHECK_FIELD(written, parsed, frame_crop_top_offset);
+        CHECK_FIELD(written, parsed, frame_crop_bottom_offset);
+    }
+
+    const bool vui = written.flags.vui_parameters_present_flag && (written.pSequenceParameterSetVui != nullptr);
+    Check("flags.vui_parameters_present_flag", vui, parsed.flags.vui_parameters_present_flag);
+    CheckPresent("pSequenceParameterSetVui", vui, parsed.pSequenceParameterSetVui != nullptr);
+    if (!vui || (parsed.pSequenceParameterSetVui == nullptr)) {
+        return;
+    }
+
+    const StdVideoH264SequenceParameterSetVui& writtenVui = *written.pSequenceParameterSetVui;
+    const StdVideoH264SequenceParameterSetVui& parsedVui = *parsed.pSequenceParameterSetVui;
+    CHECK_FIELD(writtenVui, parsedVui, flags.aspect_ratio_info_present_flag);
+    if (writtenVui.flags.aspect_ratio_info_present_flag) {
+        CHECK_FIELD(writtenVui, parsedVui, aspect_ratio_idc);
+        // The parser sets the sample aspect ratio of the other indices from
+        // the table E-1.
+        if (writtenVui.aspect_ratio_idc == STD_VIDEO_H264_ASPECT_RATIO_IDC_EXTENDED_SAR) {
+            CHECK_FIELD(writtenVui, parsedVui, sar_width);
+            CHECK_FIELD(writtenVui, parsedVui, sar_height);
+        }
+    }
+    CHECK_FIELD(writtenVui, parsedVui, flags.overscan_info_present_flag);
+    if (writtenVui.flags.overscan_info_present_flag) {
+        CHECK_FIELD(writtenVui, parsedVui, flags.overscan_appropriate_flag);
+    }
+    CHECK_FIELD(writtenVui, parsedVui, flags.video_signal_type_present_flag);
+    if (writtenVui.flags.video_signal_type_present_flag) {
+        CHECK_FIELD(writtenVui, parsedVui, video_format);
+        CHECK_FIELD(writtenVui, parsedVui, flags.video_full_range_flag);
+        CHECK_FIELD(writtenVui, parsedVui, flags.color_description_present_flag);
+        if (writtenVui.flags.color_description_present_flag) {
+            CHECK_FIELD(writtenVui, parsedVui, colour_primaries);
+            CHECK_FIELD(writtenVui, parsedVui, transfer_characteristics);
+            CHECK_FIELD(writtenVui, parsedVui, matrix_coefficients);
+        }
+    }
+    // The parser skips the chroma sample locations.
+    CHECK_FIELD(writtenVui, parsedVui, flags.chroma_loc_info_present_flag);
+    CHECK_FIELD(writtenVui, parsedVui, flags.timing_info_present_flag);
+    if (writtenVui.flags.timing_info_present_flag) {
+        CHECK_FIELD(writtenVui, parsedVui, num_units_in_tick);
+        CHECK_FIELD(writtenVui, parsedVui, time_scale);
+        CHECK_FIELD(writtenVui, parsedVui, flags.fixed_frame_rate_flag);
+    }
+
+    const bool nalHrd = writtenVui.flags.nal_hrd_parameters_present_flag && (writtenVui.pHrdParameters != nullptr);
+    const bool vclHrd = writtenVui.flags.vcl_hrd_parameters_present_flag && (writtenVui.pHrdParameters != nullptr);
+    Check("flags.nal_hrd_parameters_present_flag", nalHrd, parsedVui.flags.nal_hrd_parameters_present_flag);
+    Check("flags.vcl_hrd_parameters_present_flag", vclHrd, parsedVui.flags.vcl_hrd_parameters_present_flag);
+    if ((nalHrd || vclHrd) && (parsedVui.pHrdParameters != nullptr)) {
+        // The parser keeps the CPB count and the time offset length of the
+        // NAL HRD, and the delay lengths of the last HRD it parsed. The bit
+        // rates and CPB sizes are only used to compute its own values.
+        const StdVideoH264HrdParameters& writtenHrd = *writtenVui.pHrdParameters;
+        const StdVideoH264HrdParameters& parsedHrd = *parsedVui.pHrdParameters;
+        if (nalHrd) {
+            CHECK_FIELD(writtenHrd, parsedHrd, cpb_cnt_minus1);
+            CHECK_FIELD(writtenHrd, parsedHrd, time_offset_length);
+        }
+        CHECK_FIELD(writtenHrd, parsedHrd, initial_cpb_removal_delay_length_minus1);
+        CHECK_FIELD(writtenHrd, parsedHrd, cpb_removal_delay_length_minus1);
+        CHECK_FIELD(writtenHrd, parsedHrd, dpb_output_delay_length_minus1);
+    }
+
+    CHECK_FIELD(writtenVui, parsedVui, flags.bitstream_restriction_flag);
+    // The parser replaces a buffering of 0 with the limit of the level, and
+    // clips the reordering to the buffering.
+    if (writtenVui.flags.bitstream_restriction_flag && (writtenVui.max_dec_frame_buffering != 0) &&
+        (writtenVui.max_num_reorder_frames <= writtenVui.max_dec_frame_buffering)) {
+        CHECK_FIELD(writtenVui, parsedVui, max_num_reorder_frames);
+        CHECK_FIELD(writtenVui, parsedVui, max_dec_frame_buffering);
+    }
+}
+
+void VkVideoHeaderCheck::CompareH264Pps(const StdVideoH264PictureParameterSet& written,
+                                        const StdVideoH264PictureParameterSet& parsed)
+{
+    CHECK_FIELD(written, parsed, pic_parameter_set_id);
+    CHECK_FIELD(written, parsed, seq_parameter_set_id);
+    CHECK_FIELD(written, parsed, flags.entropy_coding_mode_flag);
+    CHECK_FIELD(written, parsed, flags.bottom_field_pic_order_in_frame_present_flag);
+    CHECK_FIELD(written, parsed, num_ref_idx_l0_default_active_minus1);
+    CHECK_FIELD(written, parsed, num_ref_idx_l1_default_active_minus1);
+    CHECK_FIELD(written, parsed, flags.weighted_pred_flag);
+    CHECK_FIELD(written, parsed, weighted_bipred_idc);
+    CHECK_FIELD(written, parsed, pic_init_qp_minus26);
+    CHECK_FIELD(written, parsed, pic_init_qs_minus26);
+    CHECK_FIELD(written, parsed, chroma_qp_index_offset);
+    CHECK_FIELD(written, parsed, flags.deblocking_filter_control_present_flag);
+    CHECK_FIELD(written, parsed, flags.constrained_intra_pred_flag);
+    CHECK_FIELD(written, parsed, flags.redundant_pic_cnt_present_flag);
+    CHECK_FIELD(written, parsed, flags.transform_8x8_mode_flag);
+
+    const bool scalingMatrix = written.flags.pic_scaling_matrix_present_flag && (written.pScalingLists != nullptr);
+    Check("flags.pic_scaling_matrix_present_flag", scalingMatrix, parsed.flags.pic_scaling_matrix_present_flag);
+    CheckPresent("pScalingLists", scalingMatrix, parsed.pScalingLists != nullptr);
+    if (scalingMatrix && (parsed.pScalingLists != nullptr)) {
+        CompareH264ScalingLists("PPS", written.pScalingLists, parsed.pScalingLists,
+                                6 + (written.flags.transform_8x8_mode_flag ? 2 : 0));
+    }
+
+    CHECK_FIELD(written, parsed, second_chroma_qp_index_offset);
+}
+
+void VkVideoHeaderCheck::CompareH264ScalingLists(const char* name, const StdVideoH264ScalingLists* pWritten,
+                                                 const StdVideoH264ScalingLists* pParsed, uint32_t numLists)
+{
+    for (uint32_t i = 0; i < numLists; i++) {
+        // A list that selects the default one isn't marked as present by the
+        // parser.
+        const bool present = (pWritten->scaling_list_present_mask >> i) & 1;
+        const bool useDefault = present && ((pWritten->use_default_scaling_matrix_mask >> i) & 1);
+        const bool parsedPresent = (pParsed->scaling_list_present_mask >> i) & 1;
+        const bool parsedUseDefault = (pParsed->use_default_scaling_matrix_mask >> i) & 1;
+        if ((parsedPresent != (present && !useDefault)) || (parsedUseDefault != useDefault)) {
+            ReportError("%s scaling list %u written %s, parsed %s", name, i,
+                        useDefault ? "default" : (present ? "present" : "not present"),
+                        parsedUseDefault ? "default" : (parsedPresent ? "present" : "not present"));
+            continue;
+        }
+        if (!present || useDefault) {
+            continue;
+        }
+
+        const uint8_t* pWrittenList = (i < 6) ? pWritten->ScalingList4x4[i] : pWritten->ScalingList8x8[i - 6];
+        const uint8_t* pParsedList = (i < 6) ? pParsed->ScalingList4x4[i] : pParsed->ScalingList8x8[i - 6];
+        const uint32_t size = (i < 6) ? STD_VIDEO_H264_SCALING_LIST_4X4_NUM_ELEMENTS : STD_VIDEO_H264_SCALING_LIST_8X8_NUM_ELEMENTS;
+        for (uint32_t j = 0; j < size; j++) {
+            if (pWrittenList[j] != pParsedList[j]) {
+                ReportError("%s scaling list %u [%u] written %u, parsed %u", name, i, j, pWrittenList[j], pParsedList[j]);
+                break;
+            }
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// H.265
+
+void VkVideoHeaderCheck::CompareH265Ptl(const StdVideoH265ProfileTierLevel* pWritten,
+                                        const StdVideoH265ProfileTierLevel* pParsed)
+{
+    CheckPresent("pProfileTierLevel", pWritten != nullptr, pParsed != nullptr);
+    if ((pWritten == nullptr) || (pParsed == nullptr)) {
+        return;
+    }
+    // The parser only keeps the profile and the level.
+    CHECK_FIELD(*pWritten, *pParsed, general_profile_idc);
+    CHECK_FIELD(*pWritten, *pParsed, general_level_idc);
+}
+
+void VkVideoHeaderCheck::CompareH265DecPicBufMgr(const StdVideoH265DecPicBufMgr* pWritten,
+                                                 const StdVideoH265DecPicBufMgr* pParsed,
+                                                 bool subLayerOrderingInfoPresent, uint32_t maxSubLayersMinus1)
+{
+    CheckPresent("pDecPicBufMgr", pWritten != nullptr, pParsed != nullptr);
+    if ((pWritten == nullptr) || (pParsed == nullptr)) {
+        return;
+    }
+    for (uint32_t i = (subLayerOrderingInfoPresent ? 0 : maxSubLayersMinus1); i <= maxSubLayersMinus1; i++) {
+        char name[64];
+        Check(ElementName(name, sizeof(name), "max_dec_pic_buffering_minus1", i),
+              pWritten->max_dec_pic_buffering_minus1[i], pParsed->max_dec_pic_buffering_minus1[i]);
+        Check(ElementName(name, sizeof(name), "max_num_reorder_pics", i),
+              pWritten->max_num_reorder_pics[i], pParsed->max_num_reorder_pics[i]);
+        Check(ElementName(name, sizeof(name), "max_latency_increase_plus1", i),
+              pWritten->max_latency_increase_plus1[i], pParsed->max_latency_increase_plus1[i]);
+    }
+}
+
+void VkVideoHeaderCheck::CompareH265Hrd(const StdVideoH265HrdParameters* pWritten,
+                                        const StdVideoH265HrdParameters* pParsed,
+                                        uint32_t maxSubLayersMinus1)
+{
+    const StdVideoH265HrdParameters& written = *pWritten;
+    const StdVideoH265HrdParameters& parsed = *pParsed;
+    const bool nalHrd = written.flags.nal_hrd_parameters_present_flag && (written.pSubLayerHrdParametersNal != nullptr);
+    const bool vclHrd = written.flags.vcl_hrd_parameters_present_flag && (written.pSubLayerHrdParametersVcl != nullptr);
+
+    Check("flags.nal_hrd_parameters_present_flag", nalHrd, parsed.flags.nal_hrd_parameters_present_flag);
+    Check("flags.vcl_hrd_parameters_present_flag", vclHrd, parsed.flags.vcl_hrd_parameters_present_flag);
+    CheckPresent("pSubLayerHrdParametersNal", nalHrd, parsed.pSubLayerHrdParametersNal != nullptr);
+    CheckPresent("pSubLayerHrdParametersVcl", vclHrd, parsed.pSubLayerHrdParametersVcl != nullptr);
+    const bool subPicHrdParams = (nalHrd || vclHrd) && written.flags.sub_pic_hrd_params_present_flag;
+    if (nalHrd || vclHrd) {
+        CHECK_FIELD(written, parsed, flags.sub_pic_hrd_params_present_flag);
+        if (subPicHrdParams) {
+            CHECK_FIELD(written, parsed, tick_divisor_minus2);
+            CHECK_FIELD(written, parsed, du_cpb_removal_delay_increment_length_minus1);
+            CHECK_FIELD(written, parsed, flags.sub_pic_cpb_params_in_pic_timing_sei_flag);
+            CHECK_FIELD(written, parsed, dpb_output_delay_du_length_minus1);
+            CHECK_FIELD(written, parsed, cpb_size_du_scale);
+        }
+        CHECK_FIELD(written, parsed, bit_rate_scale);
+        CHECK_FIELD(written, parsed, cpb_size_scale);
+        CHECK_FIELD(written, parsed, initial_cpb_removal_delay_length_minus1);
+        CHECK_FIELD(written, parsed, au_cpb_removal_delay_length_minus1);
+        CHECK_FIELD(written, parsed, dpb_output_delay_length_minus1);
+    }
+
+    for (uint32_t i = 0; i <= maxSubLayersMinus1; i++) {
+        char name[64];
+        const bool fixedPicRateGeneral = (written.flags.fixed_pic_rate_general_flag >> i) & 1;
+        const bool fixedPicRateWithinCvs = fixedPicRateGeneral || ((written.flags.fixed_pic_rate_within_cvs_flag >> i) & 1);
+        const bool lowDelayHrd = !fixedPicRateWithinCvs && ((written.flags.low_delay_hrd_flag >> i) & 1);
+        Check(ElementName(name, sizeof(name), "fixed_pic_rate_general_flag", i),
+              fixedPicRateGeneral, (parsed.flags.fixed_pic_rate_general_flag >> i) & 1);
+        Check(ElementName(name, sizeof(name), "fixed_pic_rate_within_cvs_flag", i),
+              fixedPicRateWithinCvs, (parsed.flags.fixed_pic_rate_within_cvs_flag >> i) & 1);
+        Check(ElementName(name, sizeof(name), "low_delay_hrd_flag", i),
+              lowDelayHrd, (parsed.flags.low_delay_hrd_flag >> i) & 1);
+        if (fixedPicRateWithinCvs) {
+            Check(ElementName(name, sizeof(name), "elemental_duration_in_tc_minus1", i),
+                  written.elemental_duration_in_tc_minus1[i], parsed.elemental_duration_in_tc_minus1[i]);
+        }
+        // The CPB count of a low delay sub-layer isn't sent, it is inferred to be 1.
+        const uint32_t cpbCntMinus1 = lowDelayHrd ? 0 : written.cpb_cnt_minus1[i];
+        Check(ElementName(name, sizeof(name), "cpb_cnt_minus1", i), cpbCntMinus1, parsed.cpb_cnt_minus1[i]);
+
+        for (uint32_t nalVcl = 0; nalVcl < 2; nalVcl++) {
+            const StdVideoH265SubLayerHrdParameters* pWrittenSubLayers = nalVcl ? written.pSubLayerHrdParametersVcl : written.pSubLayerHrdParametersNal;
+            const StdVideoH265SubLayerHrdParameters* pParsedSubLayers = nalVcl ? parsed.pSubLayerHrdParametersVcl : parsed.pSubLayerHrdParametersNal;
+            if (!(nalVcl ? vclHrd : nalHrd) || (pParsedSubLayers == nullptr)) {
+                continue;
+            }
+            const StdVideoH265SubLayerHrdParameters& writtenSubLayer = pWrittenSubLayers[i];
+            const StdVideoH265SubLayerHrdParameters& parsedSubLayer = pParsedSubLayers[i];
+            for (uint32_t j = 0; j <= cpbCntMinus1; j++) {
+                if ((writtenSubLayer.bit_rate_value_minus1[j] != parsedSubLayer.bit_rate_value_minus1[j]) ||
+                    (writtenSubLayer.cpb_size_value_minus1[j] != parsedSubLayer.cpb_size_value_minus1[j]) ||
+                    (((writtenSubLayer.cbr_flag >> j) & 1) != ((parsedSubLayer.cbr_flag >> j) & 1)) ||
+                    (subPicHrdParams &&
+                     ((writtenSubLayer.cpb_size_du_value_minus1[j] != parsedSubLayer.cpb_size_du_value_minus1[j]) ||
+                      (writtenSubLayer.bit_rate_du_value_minus1[j] != parsedSubLayer.bit_rate_du_value_minus1[j])))) {
+                    ReportError("%s sub-layer %u CPB %u written %u/%u, parsed %u/%u (bit rate/CPB size)",
+                                nalVcl ? "VCL" : "NAL", i, j,
+                                writtenSubLayer.bit_rate_value_minus1[j], writtenSubLayer.cpb_size_value_minus1[j],
+                                parsedSubLayer.bit_rate_value_minus1[j], parsedSubLayer.cpb_size_value_minus1[j]);
+                }
+            }
+        }
+    }
+}
+
+void VkVideoHeaderCheck::CompareH265ScalingLists(const StdVideoH265ScalingLists* pWritten,
+                                                 const StdVideoH265ScalingLists* pParsed)
+{
+    struct ListSize {
+        const char* name;
+        uint32_t    numLists;
+        uint32_t    numElements;
+    };
+    static const ListSize listSizes[4] = {
+        { "4x4",   STD_VIDEO_H265_SCALING_LIST_4X4_NUM_LISTS,   STD_VIDEO_H265_SCALING_LIST_4X4_NUM_ELEMENTS },
+        { "8x8",   STD_VIDEO_H265_SCALING_LIST_8X8_NUM_LISTS,   STD_VIDEO_H265_SCALING_LIST_8X8_NUM_ELEMENTS },
+        { "16x16", STD_VIDEO_H265_SCALING_LIST_16X16_NUM_LISTS, STD_VIDEO_H265_SCALING_LIST_16X16_NUM_ELEMENTS },
+        { "32x32", STD_VIDEO_H265_SCALING_LIST_32X32_NUM_LISTS, STD_VIDEO_H265_SCALING_LIST_32X32_NUM_ELEMENTS },
+    };
+
+    for (uint32_t sizeId = 0; sizeId < 4; sizeId++) {
+        for (uint32_t matrixId = 0; matrixId < listSizes[sizeId].numLists; matrixId++) {
+            const uint8_t* pWrittenList = nullptr;
+            const uint8_t* pParsedList = nullptr;
+            switch (sizeId) {
+            case 0:
+                pWrittenList = pWritten->ScalingList4x4[matrixId];
+                pParsedList = pParsed->ScalingList4x4[matrixId];
+                break;
+            case 1:
+                pWrittenList = pWritten->ScalingList8x8[matrixId];
+                pParsedList = pParsed->ScalingList8x8[matrixId];
+                break;
+            case 2:
+                pWrittenList = pWritten->ScalingList16x16[matrixId];
+                pParsedList = pParsed->ScalingList16x16[matrixId];
+                break;
+            default:
+                pWrittenList = pWritten->ScalingList32x32[matrixId];
+                pParsedList = pParsed->ScalingList32x32[matrixId];
+                break;
+            }
+            for (uint32_t i = 0; i < listSizes[sizeId].numElements; i++) {
+                if (pWrittenList[i] != pParsedList[i]) {
+                    ReportError("%s scaling list %u [%u] written %u, parsed %u", listSizes[sizeId].name, matrixId, i,
+                                pWrittenList[i], pParsedList[i]);
+                    break;
+                }
+            }
+        }
+    }
+    for (uint32_t i = 0; i < STD_VIDEO_H265_SCALING_LIST_16X16_NUM_LISTS; i++) {
+        char name[64];
+        Check(ElementName(name, sizeof(name), "ScalingListDCCoef16x16", i),
+              pWritten->ScalingListDCCoef16x16[i], pParsed->ScalingListDCCoef16x16[i]);
+    }
+    for (uint32_t i = 0; i < STD_VIDEO_H265_SCALING_LIST_32X32_NUM_LISTS; i++) {
+        char name[64];
+        Check(ElementName(name, sizeof(name), "ScalingListDCCoef32x32", i),
+              pWritten->ScalingListDCCoef32x32[i], pParsed->ScalingListDCCoef32x32[i]);
+    }
+}
+
+void VkVideoHeaderCheck::CompareH265Vps(const StdVideoH265VideoParameterSet& written,
+                                        const StdVideoH265VideoParameterSet& parsed)
+{
+    const uint32_t maxSubLayersMinus1 = written.vps_max_sub_layers_minus1;
+
+    CHECK_FIELD(written, parsed, vps_video_parameter_set_id);
+    CHECK_FIELD(written, parsed, vps_max_sub_layers_minus1);
+    CHECK_FIELD(written, parsed, flags.vps_temporal_id_nesting_flag);
+    CompareH265Ptl(written.pProfileTierLevel, parsed.pProfileTierLevel);
+    CHECK_FIELD(written, parsed, flags.vps_sub_layer_ordering_info_present_flag);
+    CompareH265DecPicBufMgr(written.pDecPicBufMgr, parsed.pDecPicBufMgr,
+                            written.flags.vps_sub_layer_ordering_info_present_flag, maxSubLayersMinus1);
+
+    CHECK_FIELD(written, parsed, flags.vps_timing_info_present_flag);
+    if (!written.flags.vps_timing_info_present_flag) {
+        return;
+    }
+    CHECK_FIELD(written, parsed, vps_num_units_in_tick);
+    CHECK_FIELD(written, parsed, vps_time_scale);
+    CHECK_FIELD(written, parsed, flags.vps_poc_proportional_to_timing_flag);
+    if (written.flags.vps_poc_proportional_to_timing_flag) {
+        CHECK_FIELD(written, parsed, vps_num_ticks_poc_diff_one_minus1);
+    }
+
+    const bool hrd = (written.pHrdParameters != nullptr) &&
+                     (written.pHrdParameters->flags.nal_hrd_parameters_present_flag ||
+                      written.pHrdParameters->flags.vcl_hrd_parameters_present_flag);
+    CheckPresent("pHrdParameters", hrd, parsed.pHrdParameters != nullptr);
+    if (hrd && (parsed.pHrdParameters != nullptr)) {
+        CompareH265Hrd(written.pHrdParameters, parsed.pHrdParameters, maxSubLayersMinus1);
+    }
+}
+
+void VkVideoHeaderCheck::CompareH265Sps(const StdVideoH265SequenceParameterSet& written,
+                                        const StdVideoH265SequenceParameterSet& parsed)
+{
+    const uint32_t maxSubLayersMinus1 = written.sps_max_sub_layers_minus1;
+
+    CHECK_FIELD(written, parsed, sps_video_parameter_set_id);
+    CHECK_FIELD(written, parsed, sps_max_sub_layers_minus1);
+    CHECK_FIELD(written, parsed, flags.sps_temporal_id_nesting_flag);
+    CompareH265Ptl(written.pProfileTierLevel, parsed.pProfileTierLevel);
+    CHECK_FIELD(written, parsed, sps_seq_parameter_set_id);
+    CHECK_FIELD(written, parsed, chroma_format_idc);
+    CHECK_FIELD(written, parsed, flags.separate_colour_plane_flag);
+    CHECK_FIELD(written, parsed, pic_width_in_luma_samples);
+    CHECK_FIELD(written, parsed, pic_height_in_luma_samples);
+    // The parser doesn't keep the conformance window flag, only the offsets.
+    if (written.flags.conformance_window_flag) {
+        CHECK_FIELD(written, parsed, conf_win_left_offset);
+        CHECK_FIELD(written, parsed, conf_win_right_offset);
+        CHECK_FIELD(written, parsed, conf_win_top_offset);
+        CHECK_FIELD(written, parsed, conf_win_bottom_offset);
+    }
+    CHECK_FIELD(written, parsed, bit_depth_luma_minus8);
+    CHECK_FIELD(written, parsed, bit_depth_chroma_minus8);
+    CHECK_FIELD(written, parsed, log2_max_pic_order_cnt_lsb_minus4);
+    CompareH265DecPicBufMgr(written.pDecPicBufMgr, parsed.pDecPicBufMgr,
+                            written.flags.sps_sub_layer_ordering_info_present_flag, maxSubLayersMinus1);
+    CHECK_FIELD(written, parsed, log2_min_luma_coding_block_size_minus3);
+    CHECK_FIELD(written, parsed, log2_diff_max_min_luma_coding_block_size);
+    CHECK_FIELD(written, parsed, log2_min_luma_transform_block_size_minus2);
+    CHECK_FIELD(written, parsed, log2_diff_max_min_luma_transform_block_size);
+    CHECK_FIELD(written, parsed, max_transform_hierarchy_depth_inter);
+    CHECK_FIELD(written, parsed, max_transform_hierarchy_depth_intra);
+
+    CHECK_FIELD(written, parsed, flags.scaling_list_enabled_flag);
+    if (written.flags.scaling_list_enabled_flag) {
+        const bool scalingListData = written.flags.sps_scaling_list_data_present_flag && (written.pScalingLists != nullptr);
+        Check("flags.sps_scaling_list_data_present_flag", scalingListData, parsed.flags.sps_scaling_list_data_present_flag);
+        CheckPresent("pScalingLists", true, parsed.pScalingLists != nullptr);
+        if (scalingListData && (parsed.pScalingLists != nullptr)) {
+            CompareH265ScalingLists(written.pScalingLists, parsed.pScalingLists);
+        }
+    }
+    CHECK_FIELD(written, parsed, flags.amp_enabled_flag);
+    CHECK_FIELD(written, parsed, flags.sample_adaptive_offset_enabled_flag);
+    CHECK_FIELD(written, parsed, flags.pcm_enabled_flag);
+    if (written.flags.pcm_enabled_flag) {
+        CHECK_FIELD(written, parsed, pcm_sample_bit_depth_luma_minus1);
+        CHECK_FIELD(written, parsed, pcm_sample_bit_depth_chroma_minus1);
+        CHECK_FIELD(written, parsed, log2_min_pcm_luma_coding_block_size_minus3);
+        CHECK_FIELD(written, parsed, log2_diff_max_min_pcm_luma_coding_block_size);
+        CHECK_FIELD(written, parsed, flags.pcm_loop_filter_disabled_flag);
+    }
+
+    CHECK_FIELD(written, parsed, num_short_term_ref_pic_sets);
+    CheckPresent("pShortTermRefPicSet", written.num_short_term_ref_pic_sets > 0, parsed.pShortTermRefPicSet != nullptr);
+    if ((written.num_short_term_ref_pic_sets > 0) && (parsed.pShortTermRefPicSet != nullptr) &&
+        (written.num_short_term_ref_pic_sets == parsed.num_short_term_ref_pic_sets) &&
+        (written.num_short_term_ref_pic_sets <= H265Case::MAX_RPS)) {
+
+        H265RefPicSetPocs pocs[H265Case::MAX_RPS];
+        GetH265RefPicSetPocs(written.pShortTermRefPicSet, written.num_short_term_ref_pic_sets, pocs);
+        for (uint32_t idx = 0; idx < written.num_short_term_ref_pic_sets; idx++) {
+            const StdVideoH265ShortTermRefPicSet& writtenRps = written.pShortTermRefPicSet[idx];
+            const StdVideoH265ShortTermRefPicSet& parsedRps = parsed.pShortTermRefPicSet[idx];
+            const bool interRps = (idx > 0) && writtenRps.flags.inter_ref_pic_set_prediction_flag;
+            Check("flags.inter_ref_pic_set_prediction_flag", interRps, parsedRps.flags.inter_ref_pic_set_prediction_flag);
+            if (interRps) {
+                CHECK_FIELD(writtenRps, parsedRps, flags.delta_rps_sign);
+                CHECK_FIELD(writtenRps, parsedRps, abs_delta_rps_minus1);
+                CHECK_FIELD(writtenRps, parsedRps, used_by_curr_pic_flag);
+                // use_delta_flag is inferred to be 1 for the used pictures.
+                Check("use_delta_flag", writtenRps.use_delta_flag | writtenRps.used_by_curr_pic_flag,
+                      parsedRps.use_delta_flag);
+            }
+
+            // The parser keeps the delta POCs in the fields of their
+            // differences.
+            bool match = (pocs[idx].numNegativePics == parsedRps.num_negative_pics) &&
+                         (pocs[idx].numPositivePics == parsedRps.num_positive_pics) &&
+                         (pocs[idx].usedByCurrPicS0 == parsedRps.used_by_curr_pic_s0_flag) &&
+                         (pocs[idx].usedByCurrPicS1 == parsedRps.used_by_curr_pic_s1_flag);
+            for (uint32_t i = 0; match && (i < pocs[idx].numNegativePics); i++) {
+                match = ((uint16_t)pocs[idx].deltaPocS0[i] == parsedRps.delta_poc_s0_minus1[i]);
+            }
+            for (uint32_t i = 0; match && (i < pocs[idx].numPositivePics); i++) {
+                match = ((uint16_t)pocs[idx].deltaPocS1[i] == parsedRps.delta_poc_s1_minus1[i]);
+            }
+            if (!match) {
+                ReportError("short term RPS %u: %u negative and %u positive pictures, used 0x%x 0x%x, parsed %u and %u, used 0x%x 0x%x",
+                            idx, pocs[idx].numNegativePics, pocs[idx].numPositivePics,
+                            pocs[idx].usedByCurrPicS0, pocs[idx].usedByCurrPicS1,
+                            parsedRps.num_negative_pics, parsedRps.num_positive_pics,
+                            parsedRps.used_by_curr_pic_s0_flag, parsedRps.used_by_curr_pic_s1_flag);
+            }
+        }
+    }
+
+    CHECK_FIELD(written, parsed, flags.long_term_ref_pics_present_flag);
+    if (written.flags.long_term_ref_pics_present_flag) {
+        const uint32_t numLongTermRefPics = (written.pLongTermRefPicsSps != nullptr) ? written.num_long_term_ref_pics_sps : 0;
+        Check("num_long_term_ref_pics_sps", numLongTermRefPics, parsed.num_long_term_ref_pics_sps);
+        CheckPresent("pLongTermRefPicsSps", true, parsed.pLongTermRefPicsSps != nullptr);
+        if ((numLongTermRefPics > 0) && (parsed.pLongTermRefPicsSps != nullptr)) {
+            const uint32_t usedMask = (1u << numLongTermRefPics) - 1;
+            Check("used_by_curr_pic_lt_sps_flag", written.pLongTermRefPicsSps->used_by_curr_pic_lt_sps_flag & usedMask,
+                  parsed.pLongTermRefPicsSps->used_by_curr_pic_lt_sps_flag);
+            for (uint32_t i = 0; i < numLongTermRefPics; i++) {
+                char name[64];
+                Check(ElementName(name, sizeof(name), "lt_ref_pic_poc_lsb_sps", i),
+                      written.pLongTermRefPicsSps->lt_ref_pic_poc_lsb_sps[i],
+                      parsed.pLongTermRefPicsSps->lt_ref_pic_poc_lsb_sps[i]);
+            }
+        }
+    }
+    CHECK_FIELD(written, parsed, flags.sps_temporal_mvp_enabled_flag);
+    CHECK_FIELD(written, parsed, flags.strong_intra_smoothing_enabled_flag);
+
+    const bool vui = written.flags.vui_parameters_present_flag && (written.pSequenceParameterSetVui != nullptr);
+    Check("flags.vui_parameters_present_flag", vui, parsed.flags.vui_parameters_present_flag);
+    CheckPresent("pSequenceParameterSetVui", vui, parsed.pSequenceParameterSetVui != nullptr);
+    if (vui && (parsed.pSequenceParameterSetVui != nullptr)) {
+        const StdVideoH265SequenceParameterSetVui& writtenVui = *written.pSequenceParameterSetVui;
+        const StdVideoH265SequenceParameterSetVui& parsedVui = *parsed.pSequenceParameterSetVui;
+        CHECK_FIELD(writtenVui, parsedVui, flags.aspect_ratio_info_present_flag);
+        if (writtenVui.flags.aspect_ratio_info_present_flag) {
+            CHECK_FIELD(writtenVui, parsedVui, aspect_ratio_idc);
+            if (writtenVui.aspect_ratio_idc == STD_VIDEO_H265_ASPECT_RATIO_IDC_EXTENDED_SAR) {
+                CHECK_FIELD(writtenVui, parsedVui, sar_width);
+                CHECK_FIELD(writtenVui, parsedVui, sar_height);
+            }
+        }
+        CHECK_FIELD(writtenVui, parsedVui, flags.overscan_info_present_flag);
+        if (writtenVui.flags.overscan_info_present_flag) {
+            CHECK_FIELD(writtenVui, parsedVui, flags.overscan_appropriate_flag);
+        }
+        CHECK_FIELD(writtenVui, parsedVui, flags.video_signal_type_present_flag);
+        if (writtenVui.flags.video_signal_type_present_flag) {
+            CHECK_FIELD(writtenVui, parsedVui, video_format);
+            CHECK_FIELD(writtenVui, parsedVui, flags.video_full_range_flag);
+            CHECK_FIELD(writtenVui, parsedVui, flags.colour_description_present_flag);
+            if (writtenVui.flags.colour_description_present_flag) {
+                CHECK_FIELD(writtenVui, parsedVui, colour_primaries);
+                CHECK_FIELD(writtenVui, parsedVui, transfer_characteristics);
+                CHECK_FIELD(writtenVui, parsedVui, matrix_coeffs);
+            }
+        }
+        CHECK_FIELD(writtenVui, parsedVui, flags.chroma_loc_info_present_flag);
+        if (writtenVui.flags.chroma_loc_info_present_flag) {
+            CHECK_FIELD(writtenVui, parsedVui, chroma_sample_loc_type_top_field);
+            CHECK_FIELD(writtenVui, parsedVui, chroma_sample_loc_type_bottom_field);
+        }
+        CHECK_FIELD(writtenVui, parsedVui, flags.neutral_chroma_indication_flag);
+        CHECK_FIELD(writtenVui, parsedVui, flags.field_seq_flag);
+        CHECK_FIELD(writtenVui, parsedVui, flags.frame_field_info_present_flag);
+        CHECK_FIELD(writtenVui, parsedVui, flags.default_display_window_flag);
+        if (writtenVui.flags.default_display_window_flag) {
+            CHECK_FIELD(writtenVui, parsedVui, def_disp_win_left_offset);
+            CHECK_FIELD(writtenVui, parsedVui, def_disp_win_right_offset);
+            CHECK_FIELD(writtenVui, parsedVui, def_disp_win_top_offset);
+            CHECK_FIELD(writtenVui, parsedVui, def_disp_win_bottom_offset);
+        }
+        CHECK_FIELD(writtenVui, parsedVui, flags.vui_timing_info_present_flag);
+        if (writtenVui.flags.vui_timing_info_present_flag) {
+            CHECK_FIELD(writtenVui, parsedVui, vui_num_units_in_tick);
+            CHECK_FIELD(writtenVui, parsedVui, vui_time_scale);
+            CHECK_FIELD(writtenVui, parsedVui, flags.vui_poc_proportional_to_timing_flag);
+            if (writtenVui.flags.vui_poc_proportional_to_timing_flag) {
+                CHECK_FIELD(writtenVui, parsedVui, vui_num_ticks_poc_diff_one_minus1);
+            }
+            const bool hrd = writtenVui.flags.vui_hrd_parameters_present_flag && (writtenVui.pHrdParameters != nullptr);
+            Check("flags.vui_hrd_parameters_present_flag", hrd, parsedVui.flags.vui_hrd_parameters_present_flag);
+            CheckPresent("pHrdParameters", hrd, parsedVui.pHrdParameters != nullptr);
+            if (hrd && (parsedVui.pHrdParameters != nullptr)) {
+                CompareH265Hrd(writtenVui.pHrdParameters, parsedVui.pHrdParameters, maxSubLayersMinus1);
+            }
+        }
+        CHECK_FIELD(writtenVui, parsedVui, flags.bitstream_restriction_flag);
+        if (writtenVui.flags.bitstream_restriction_flag) {
+            CHECK_FIELD(writtenVui, parsedVui, flags.tiles_fixed_structure_flag);
+            CHECK_FIELD(writtenVui, parsedVui, flags.motion_vectors_over_pic_boundaries_flag);
+            CHECK_FIELD(writtenVui, parsedVui, flags.restricted_ref_pic_lists_flag);
+            CHECK_FIELD(writtenVui, parsedVui, min_spatial_segmentation_idc);
+            CHECK_FIELD(writtenVui, parsedVui, max_bytes_per_pic_denom);
+            CHECK_FIELD(writtenVui, parsedVui, max_bits_per_min_cu_denom);
+            CHECK_FIELD(writtenVui, parsedVui, log2_max_mv_length_horizontal);
+            CHECK_FIELD(writtenVui, parsedVui, log2_max_mv_length_vertical);
+        }
+    }
+
+    CHECK_FIELD(written, parsed, flags.sps_extension_present_flag);
+    if (written.flags.sps_extension_present_flag) {
+        CHECK_FIELD(written, parsed, flags.sps_range_extension_flag);
+        if (written.flags.sps_range_extension_flag) {
+            CHECK_FIELD(written, parsed, flags.transform_skip_rotation_enabled_flag);
+            CHECK_FIELD(written, parsed, flags.transform_skip_context_enabled_flag);
+            CHECK_FIELD(written, parsed, flags.implicit_rdpcm_enabled_flag);
+            CHECK_FIELD(written, parsed, flags.explicit_rdpcm_enabled_flag);
+            CHECK_FIELD(written, parsed, flags.extended_precision_processing_flag);
+            CHECK_FIELD(written, parsed, flags.intra_smoothing_disabled_flag);
+            CHECK_FIELD(written, parsed, flags.high_precision_offsets_enabled_flag);
+            CHECK_FIELD(written, parsed, flags.persistent_rice_adaptation_enabled_flag);
+            CHECK_FIELD(written, parsed, flags.cabac_bypass_alignment_enabled_flag);
+        }
+    }
+}
+
+void VkVideoHeaderCheck::CompareH265Pps(const StdVideoH265PictureParameterSet& written,
+                                        const StdVideoH265PictureParameterSet& parsed)
+{
+    CHECK_FIELD(written, parsed, pps_pic_parameter_set_id);
+    CHECK_FIELD(written, parsed, pps_seq_parameter_set_id);
+    CHECK_FIELD(written, parsed, sps_video_parameter_set_id);
+    CHECK_FIELD(written, parsed, flags.dependent_slice_segments_enabled_flag);
+    CHECK_FIELD(written, parsed, flags.output_flag_present_flag);
+    CHECK_FIELD(written, parsed, num_extra_slice_header_bits);
+    CHECK_FIELD(written, parsed, flags.sign_data_hiding_enabled_flag);
+    CHECK_FIELD(written, parsed, flags.cabac_init_present_flag);
+    CHECK_FIELD(written, parsed, num_ref_idx_l0_default_active_minus1);
+    CHECK_FIELD(written, parsed, num_ref_idx_l1_default_active_minus1);
+    CHECK_FIELD(written, parsed, init_qp_minus26);
+    CHECK_FIELD(written, parsed, flags.constrained_intra_pred_flag);
+    CHECK_FIELD(written, parsed, flags.transform_skip_enabled_flag);
+    CHECK_FIELD(written, parsed, flags.cu_qp_delta_enabled_flag);
+    if (written.flags.cu_qp_delta_enabled_flag) {
+        CHECK_FIELD(written, parsed, diff_cu_qp_delta_depth);
+    }
+    CHECK_FIELD(written, parsed, pps_cb_qp_offset);
+    CHECK_FIELD(written, parsed, pps_cr_qp_offset);
+    CHECK_FIELD(written, parsed, flags.pps_slice_chroma_qp_offsets_present_flag);
+    CHECK_FIELD(written, parsed, flags.weighted_pred_flag);
+    CHECK_FIELD(written, parsed, flags.weighted_bipred_flag);
+    CHECK_FIELD(written, parsed, flags.transquant_bypass_enabled_flag);
+    CHECK_FIELD(written, parsed, flags.tiles_enabled_flag);
+    CHECK_FIELD(written, parsed, flags.entropy_coding_sync_enabled_flag);
+    if (written.flags.tiles_enabled_flag) {
+        CHECK_FIELD(written, parsed, num_tile_columns_minus1);
+        CHECK_FIELD(written, parsed, num_tile_rows_minus1);
+        CHECK_FIELD(written, parsed, flags.uniform_spacing_flag);
+        if (!written.flags.uniform_spacing_flag) {
+            for (uint32_t i = 0; i < written.num_tile_columns_minus1; i++) {
+                char name[64];
+                Check(ElementName(name, sizeof(name), "column_width_minus1", i),
+                      written.column_width_minus1[i], parsed.column_width_minus1[i]);
+            }
+            for (uint32_t i = 0; i < written.num_tile_rows_minus1; i++) {
+                char name[64];
+                Check(ElementName(name, sizeof(name), "row_height_minus1", i),
+                      written.row_height_minus1[i], parsed.row_height_minus1[i]);
+            }
+        }
+    }
+    CHECK_FIELD(written, parsed, flags.loop_filter_across_tiles_enabled_flag);
+    CHECK_FIELD(written, parsed, flags.pps_loop_filter_across_slices_enabled_flag);
+    CHECK_FIELD(written, parsed, flags.deblocking_filter_control_present_flag);
+    if (written.flags.deblocking_filter_control_present_flag) {
+        CHECK_FIELD(written, parsed, flags.deblocking_filter_override_enabled_flag);
+        CHECK_FIELD(written, parsed, flags.pps_deblocking_filter_disabled_flag);
+        if (!written.flags.pps_deblocking_filter_disabled_flag) {
+            CHECK_FIELD(written, parsed, pps_beta_offset_div2);
+            CHECK_FIELD(written, parsed, pps_tc_offset_div2);
+        }
+    }
+
+    const bool scalingListData = written.flags.pps_scaling_list_data_present_flag && (written.pScalingLists != nullptr);
+    Check("flags.pps_scaling_list_data_present_flag", scalingListData, parsed.flags.pps_scaling_list_data_present_flag);
+    CheckPresent("pScalingLists", scalingListData, parsed.pScalingLists != nullptr);
+    if (scalingListData && (parsed.pScalingLists != nullptr)) {
+        CompareH265ScalingLists(written.pScalingLists, parsed.pScalingLists);
+    }
+    CHECK_FIELD(written, parsed, flags.lists_modification_present_flag);
+    CHECK_FIELD(written, parsed, log2_parallel_merge_level_minus2);
+    CHECK_FIELD(written, parsed, flags.slice_segment_header_extension_present_flag);
+
+    // The writer sends the extension flags when an extension is enabled.
+    const bool extension = written.flags.pps_extension_present_flag || written.flags.pps_range_extension_flag;
+    Check("flags.pps_extension_present_flag", extension, parsed.flags.pps_extension_present_flag);
+    CHECK_FIELD(written, parsed, flags.pps_range_extension_flag);
+    if (written.flags.pps_range_extension_flag) {
+        if (written.flags.transform_skip_enabled_flag) {
+            CHECK_FIELD(written, parsed, log2_max_transform_skip_block_size_minus2);
+        }
+        CHECK_FIELD(written, parsed, flags.cross_component_prediction_enabled_flag);
+        CHECK_FIELD(written, parsed, flags.chroma_qp_offset_list_enabled_flag);
+        if (written.flags.chroma_qp_offset_list_enabled_flag) {
+            CHECK_FIELD(written, parsed, diff_cu_chroma_qp_offset_depth);
+            CHECK_FIELD(written, parsed, chroma_qp_offset_list_len_minus1);
+            for (uint32_t i = 0; i <= written.chroma_qp_offset_list_len_minus1; i++) {
+                char name[64];
+                Check(ElementName(name, sizeof(name), "cb_qp_offset_list", i),
+                      written.cb_qp_offset_list[i], parsed.cb_qp_offset_list[i]);
+                Check(ElementName(name, sizeof(name), "cr_qp_offset_list", i),
+                      written.cr_qp_offset_list[i], parsed.cr_qp_offset_list[i]);
+            }
+        }
+        CHECK_FIELD(written, parsed, log2_sao_offset_scale_luma);
+        CHECK_FIELD(written, parsed, log2_sao_offset_scale_chroma);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// AV1
+
+void VkVideoHeaderCheck::CompareAv1SequenceHeader(const StdVideoAV1SequenceHeader& written,
+                                                  const StdVideoAV1SequenceHeader& parsed)
+{
+    // The parser keeps the timing info, the decoder model, the frame id
+    // lengths and the operating points outside of the Std structure.
+    CHECK_FIELD(written, parsed, seq_profile);
+    CHECK_FIELD(written, parsed, flags.still_picture);
+    CHECK_FIELD(written, parsed, flags.reduced_still_picture_header);
+    CHECK_FIELD(written, parsed, frame_width_bits_minus_1);
+    CHECK_FIELD(written, parsed, frame_height_bits_minus_1);
+    CHECK_FIELD(written, parsed, max_frame_width_minus_1);
+    CHECK_FIELD(written, parsed, max_frame_height_minus_1);
+    CHECK_FIELD(written, parsed, flags.frame_id_numbers_present_flag);
+    CHECK_FIELD(written, parsed, flags.use_128x128_superblock);
+    CHECK_FIELD(written, parsed, flags.enable_filter_intra);
+    CHECK_FIELD(written, parsed, flags.enable_intra_edge_filter);
+    CHECK_FIELD(written, parsed, flags.enable_interintra_compound);
+    CHECK_FIELD(written, parsed, flags.enable_masked_compound);
+    CHECK_FIELD(written, parsed, flags.enable_warped_motion);
+    CHECK_FIELD(written, parsed, flags.enable_dual_filter);
+    CHECK_FIELD(written, parsed, flags.enable_order_hint);
+    CHECK_FIELD(written, parsed, flags.enable_jnt_comp);
+    CHECK_FIELD(written, parsed, flags.enable_ref_frame_mvs);
+    CHECK_FIELD(written, parsed, seq_force_screen_content_tools);
+    CHECK_FIELD(written, parsed, seq_force_integer_mv);
+    CHECK_FIELD(written, parsed, order_hint_bits_minus_1);
+    CHECK_FIELD(written, parsed, flags.enable_superres);
+    CHECK_FIELD(written, parsed, flags.enable_cdef);
+    CHECK_FIELD(written, parsed, flags.enable_restoration);
+    CHECK_FIELD(written, parsed, flags.film_grain_params_present);
+
+    CheckPresent("pColorConfig", true, parsed.pColorConfig != nullptr);
+    if (parsed.pColorConfig == nullptr) {
+        return;
+    }
+    const StdVideoAV1ColorConfig& writtenColorConfig = *written.pColorConfig;
+    const StdVideoAV1ColorConfig& parsedColorConfig = *parsed.pColorConfig;
+    CHECK_FIELD(writtenColorConfig, parsedColorConfig, BitDepth);
+    CHECK_FIELD(writtenColorConfig, parsedColorConfig, flags.mono_chrome);
+    CHECK_FIELD(writtenColorConfig, parsedColorConfig, flags.color_description_present_flag);
+    CHECK_FIELD(writtenColorConfig, parsedColorConfig, color_primaries);
+    CHECK_FIELD(writtenColorConfig, parsedColorConfig, transfer_characteristics);
+    CHECK_FIELD(writtenColorConfig, parsedColorConfig, matrix_coefficients);
+    CHECK_FIELD(writtenColorConfig, parsedColorConfig, flags.color_range);
+    CHECK_FIELD(writtenColorConfig, parsedColorConfig, subsampling_x);
+    CHECK_FIELD(writtenColorConfig, parsedColorConfig, subsampling_y);
+    CHECK_FIELD(writtenColorConfig, parsedColorConfig, chroma_sample_position);
+    CHECK_FIELD(writtenColorConfig, parsedColorConfig, flags.separate_uv_delta_q);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Reports
+
+void VkVideoHeaderCheck::Check(const char* name, int64_t written, int64_t parsed)
+{
+    if (written != parsed) {
+        ReportError("%s written %lld, parsed %lld", name, (long long)written, (long long)parsed);
+    }
+}
+
+void VkVideoHeaderCheck::CheckPresent(const char* name, bool written, bool parsed)
+{
+    if (written != parsed) {
+        ReportError("%s %s, but %s by the parser", name, written ? "written" : "not written",
+                    parsed ? "reported" : "not reported");
+    }
+}
+
+void VkVideoHeaderCheck::ReportError(const char* format, ...)
+{
+    m_numErrors++;
+    if (m_numErrors > m_config.maxReportedErrors) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%s: ", m_caseName);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
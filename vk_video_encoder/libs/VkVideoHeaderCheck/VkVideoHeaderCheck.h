@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEOHEADERCHECK_VKVIDEOHEADERCHECK_H_
+#define _VKVIDEOHEADERCHECK_VKVIDEOHEADERCHECK_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "vulkan_interfaces.h"
+#include "vkvideo_parser/VulkanVideoParserIf.h"
+#include "vkvideo_parser/StdVideoPictureParametersSet.h"
+#include "VkVideoEncoder/VkEncoderHeaderWriter.h"
+
+// Writes H.264 SPS/PPS, H.265 VPS/SPS/PPS and AV1 sequence headers from a set
+// of Std structures with VkEncoderHeaderWriter, the way the encoder emits
+// them with the stream headers and on parameter set changes, parses them back
+// with NvVideoParser and compares the Std structures the parser reports with
+// the ones that were written.
+//
+// The cases cover the profiles, chroma formats and bit depths, the picture
+// order count types, the cropping windows, VUI and HRD, scaling lists, short
+// and long term reference picture sets, tiles and wavefronts, the range
+// extensions and the AV1 color configs, operating points and decoder model.
+// The fields a case doesn't send hold the values the syntax infers for them,
+// so that the parsed structures compare field by field. The fields the
+// parser doesn't keep in its Std structures (the H.265 profile compatibility
+// flags, the AV1 timing info and operating points, ...) are only checked
+// indirectly: the parameter set has to parse, and the fields after them
+// have to match.
+class VkVideoHeaderCheck {
+
+public:
+
+    struct Config {
+        uint32_t codecMask;             // VK_VIDEO_CODEC_OPERATION_DECODE_*_BIT_KHR of the codecs to check
+        uint32_t maxReportedErrors;     // per case, the following ones are only counted
+        bool     verbose;               // also print the size of the headers of each case
+
+        Config()
+        : codecMask(VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR |
+                    VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR |
+                    VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR)
+        , maxReportedErrors(8)
+        , verbose(false)
+        { }
+    };
+
+    explicit VkVideoHeaderCheck(const Config& config);
+
+    // Runs every case of the selected codecs, with one line per case.
+    // Returns the number of cases that failed.
+    uint32_t Run(FILE* fp = stdout);
+
+    uint32_t GetNumCases() const { return m_numCases; }
+
+private:
+
+    struct H264Case;
+    struct H265Case;
+    struct Av1Case;
+
+    static bool InitH264Case(uint32_t index, H264Case& c);
+    static bool InitH265Case(uint32_t index, H265Case& c);
+    static bool InitAv1Case(uint32_t index, Av1Case& c);
+
+    bool RunH264Case(const H264Case& c, FILE* fp);
+    bool RunH265Case(const H265Case& c, FILE* fp);
+    bool RunAv1Case(const Av1Case& c, FILE* fp);
+
+    // Feeds the stream to a new parser and collects the parameter sets it
+    // reports, in the order it reports them.
+    bool Parse(VkVideoCodecOperationFlagBitsKHR codec, const std::vector<uint8_t>& stream,
+               std::vector<VkSharedBaseObj<StdVideoPictureParametersSet> >& parameterSets);
+
+    void CompareH264Sps(const StdVideoH264SequenceParameterSet& written, const StdVideoH264SequenceParameterSet& parsed);
+    void CompareH264Pps(const StdVideoH264PictureParameterSet& written, const StdVideoH264PictureParameterSet& parsed);
+    void CompareH264ScalingLists(const char* name, const StdVideoH264ScalingLists* pWritten,
+                                 const StdVideoH264ScalingLists* pParsed, uint32_t numLists);
+    void CompareH265Vps(const StdVideoH265VideoParameterSet& written, const StdVideoH265VideoParameterSet& parsed);
+    void CompareH265Sps(const StdVideoH265SequenceParameterSet& written, const StdVideoH265SequenceParameterSet& parsed);
+    void CompareH265Pps(const StdVideoH265PictureParameterSet& written, const StdVideoH265PictureParameterSet& parsed);
+    void CompareH265Ptl(const StdVideoH265ProfileTierLevel* pWritten, const StdVideoH265ProfileTierLevel* pParsed);
+    void CompareH265DecPicBufMgr(const StdVideoH265DecPicBufMgr* pWritten, const StdVideoH265DecPicBufMgr* pParsed,
+                                 bool subLayerOrderingInfoPresent, uint32_t maxSubLayersMinus1);
+    void CompareH265Hrd(const StdVideoH265HrdParameters* pWritten, const StdVideoH265HrdParameters* pParsed,
+                        uint32_t maxSubLayersMinus1);
+    void CompareH265ScalingLists(const StdVideoH265ScalingLists* pWritten, const StdVideoH265ScalingLists* pParsed);
+    void CompareAv1SequenceHeader(const StdVideoAV1SequenceHeader& written, const StdVideoAV1SequenceHeader& parsed);
+
+    void BeginCase(const char* name);
+    // Prints the result line of the case, returns false if it failed.
+    bool EndCase(size_t headerSize, FILE* fp);
+
+    // Counts a mismatch of a field and prints the first ones.
+    void Check(const char* name, int64_t written, int64_t parsed);
+    void CheckPresent(const char* name, bool written, bool parsed);
+    void ReportError(const char* format, ...);
+
+    Config      m_config;
+    uint32_t    m_numCases;
+    uint32_t    m_numErrors;        // of the current case
+    const char* m_caseName;
+};
+
+#endif /* _VKVIDEOHEADERCHECK_VKVIDEOHEADERCHECK_H_ */
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "mio/mio.hpp"
+#include "VkVideoEncoder/VkEncoderLookahead.h"
+
+static void PrintHelp(const char* programName)
+{
+    fprintf(stderr,
+            "Usage: %s -i <input.yuv> --width <w> --height <h> [options]\n"
+            "Runs the encoder lookahead on a raw YUV 4:2:0 file and prints the scene cuts it finds.\n"
+            "  -i, --input <file>           Planar YUV 4:2:0, 16-bit little endian samples when --bpp > 8\n"
+            "      --width <w>, --height <h> Picture size\n"
+            "      --bpp <n>                Bits per sample, 8 to 16 (default 8)\n"
+            "      --frames <n>             Frames to analyze (default: the whole file)\n"
+            "      --depth <n>              Lookahead depth (default 16)\n"
+            "      --sceneCutThreshold <n>  1..100, higher values detect more cuts (default %u)\n"
+            "      --threads <n>            Worker threads, 0: up to 4 (default 0)\n"
+            "      --expectedCuts <list>    Comma separated frame numbers of the known cuts; the exit\n"
+            "                               code is non-zero unless exactly these cuts are found\n"
+            "      --tolerance <n>          Frames a found cut may be off from an expected one (default 0)\n"
+            "      --stats                  Print the statistics of every frame\n"
+            "  -h, --help                   Print this help\n",
+            programName, (uint32_t)VkEncoderLookahead::DEFAULT_SCENE_CUT_THRESHOLD);
+}
+
+static bool ParseFrameList(const char* pList, std::vector<uint64_t>& frames)
+{
+    while (*pList != 0) {
+        char* pEnd = nullptr;
+        frames.push_back(std::strtoull(pList, &pEnd, 10));
+        if (pEnd == pList) {
+            return false;
+        }
+        pList = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+    }
+    std::sort(frames.begin(), frames.end());
+    return true;
+}
+
+int main(int argc, const char** argv)
+{
+    VkEncoderLookahead::Config config;
+    config.depth = 16;
+    std::string inputFileName;
+    uint32_t bpp = 8;
+    uint64_t numFrames = 0;
+    std::vector<uint64_t> expectedCuts;
+    bool checkCuts = false;
+    uint64_t tolerance = 0;
+    bool printStats = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1) < argc;
+        if ((arg == "-h") || (arg == "--help")) {
+            PrintHelp(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (((arg == "-i") || (arg == "--input")) && hasValue) {
+            inputFileName = argv[++i];
+        } else if ((arg == "--width") && hasValue) {
+            config.width = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--height") && hasValue) {
+            config.height = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--bpp") && hasValue) {
+            bpp = (uint32_t)std::min(std::max(std::atoi(argv[++i]), 8), 16);
+        } else if ((arg == "--frames") && hasValue) {
+            numFrames = std::strtoull(argv[++i], nullptr, 10);
+        } else if ((arg == "--depth") && hasValue) {
+            config.depth = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--sceneCutThreshold") && hasValue) {
+            config.sceneCutThreshold = (uint32_t)std::min(std::max(std::atoi(argv[++i]), 0), 100);
+        } else if ((arg == "--threads") && hasValue) {
+            config.numThreads = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--expectedCuts") && hasValue) {
+            if (!ParseFrameList(argv[++i], expectedCuts)) {
+                fprintf(stderr, "Invalid frame list %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+            checkCuts = true;
+        } else if ((arg == "--tolerance") && hasValue) {
+            tolerance = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--stats") {
+            printStats = true;
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument %s\n", arg.c_str());
+            PrintHelp(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (inputFileName.empty() || (config.width == 0) || (config.height == 0)) {
+        PrintHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::error_code error;
+    mio::basic_mmap<mio::access_mode::read, uint8_t> inputFile;
+    inputFile.map(inputFileName, 0, mio::map_entire_file, error);
+    if (error) {
+        fprintf(stderr, "Can't map the input file %s: %s\n", inputFileName.c_str(), error.message().c_str());
+        return EXIT_FAILURE;
+    }
+
+    config.bytesPerSample = (bpp > 8) ? 2 : 1;
+    config.sampleShift = bpp - 8;
+    config.lumaPitch = config.width * config.bytesPerSample;
+    const uint64_t chromaSize = (uint64_t)((config.width + 1) / 2) * ((config.height + 1) / 2) * config.bytesPerSample;
+    const uint64_t frameSize = ((uint64_t)config.lumaPitch * config.height) + (2 * chromaSize);
+    const uint64_t fileFrames = inputFile.mapped_length() / frameSize;
+    config.numFrames = ((numFrames == 0) || (numFrames > fileFrames)) ? fileFrames : numFrames;
+    if (config.numFrames == 0) {
+        fprintf(stderr, "%s holds no complete %ux%u frame\n", inputFileName.c_str(), config.width, config.height);
+        return EXIT_FAILURE;
+    }
+
+    const uint8_t* pData = inputFile.data();
+    VkEncoderLookahead lookahead;
+    if (!lookahead.Configure(config, [pData, frameSize](uint64_t frameNum) { return pData + (frameNum * frameSize); })) {
+        return EXIT_FAILURE;
+    }
+
+    if (printStats) {
+        printf("frame,sad,histogramDelta,mean,variance,activity,complexity,sceneCut,flash\n");
+    }
+
+    std::vector<uint64_t> foundCuts;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint64_t frameNum = 0; frameNum < config.numFrames; frameNum++) {
+        uint32_t framesToSceneCut = 0;
+        const VkEncoderLookahead::FrameStats& stats = lookahead.GetFrameStats(frameNum, framesToSceneCut);
+        if (stats.sceneCut) {
+            foundCuts.push_back(frameNum);
+        }
+        if (printStats) {
+            printf("%llu,%.2f,%.3f,%.1f,%.1f,%.2f,%.2f,%u,%u\n", (unsigned long long)frameNum, stats.sad,
+                   stats.histogramDelta, stats.mean, stats.variance, stats.activity, stats.complexity,
+                   (uint32_t)stats.sceneCut, (uint32_t)stats.flash);
+        }
+    }
+    const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    lookahead.Stop();
+
+    fprintf(stderr, "%s: %llu frame(s) in %.3f s (%.1f frames/s), scene cuts:",
+            inputFileName.c_str(), (unsigned long long)config.numFrames, elapsedSec,
+            (elapsedSec > 0.0) ? (config.numFrames / elapsedSec) : 0.0);
+    for (size_t i = 0; i < foundCuts.size(); i++) {
+        fprintf(stderr, " %llu", (unsigned long long)foundCuts[i]);
+    }
+    fprintf(stderr, "\n");
+    lookahead.PrintReport(stderr);
+
+    if (!checkCuts) {
+        return EXIT_SUCCESS;
+    }
+
+    // Match every expected cut to one found cut within the tolerance.
+    uint32_t missed = 0;
+    std::vector<bool> matched(foundCuts.size(), false);
+    for (size_t i = 0; i < expectedCuts.size(); i++) {
+        bool found = false;
+        for (size_t j = 0; (j < foundCuts.size()) && !found; j++) {
+            const uint64_t delta = (foundCuts[j] > expectedCuts[i]) ? (foundCuts[j] - expectedCuts[i]) :
+                                                                      (expectedCuts[i] - foundCuts[j]);
+            if (!matched[j] && (delta <= tolerance)) {
+                matched[j] = true;
+                found = true;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "MISSED: expected cut at frame %llu\n", (unsigned long long)expectedCuts[i]);
+            missed++;
+        }
+    }
+    uint32_t falseCuts = 0;
+    for (size_t j = 0; j < foundCuts.size(); j++) {
+        if (!matched[j]) {
+            fprintf(stderr, "FALSE: unexpected cut at frame %llu\n", (unsigned long long)foundCuts[j]);
+            falseCuts++;
+        }
+    }
+
+    fprintf(stderr, "%s: %zu expected cut(s), %u missed, %u false\n",
+            ((missed + falseCuts) == 0) ? "PASS" : "FAIL", expectedCuts.size(), missed, falseCuts);
+    return ((missed + falseCuts) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
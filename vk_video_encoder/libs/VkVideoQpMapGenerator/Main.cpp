@@ -0,0 +1,178 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "VkVideoEncoder/VkEncoderQpMapGenerator.h"
+
+static void PrintHelp(const char* programName)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "Generates the quantization maps of a raw 8-bit 4:2:0 YCbCr file with the encoder's map\n"
+            "generator. Without an input file, generates the maps of random frames to measure the speed.\n"
+            "  -i, --input <file>           Raw 8-bit 4:2:0 input file (I420 or NV12, only the luma is used)\n"
+            "      --width <w>, --height <h> Picture size (default 1920x1080)\n"
+            "      --texelSize <n>          Luma samples per map texel in each direction (default 16)\n"
+            "      --emphasis               Emphasis map instead of a delta QP map\n"
+            "      --bytesPerTexel <n>      1, 2 or 4 (default 1)\n"
+            "      --activityStrength <f>   QP steps per doubling of the texel variance (default 1.0)\n"
+            "      --staticDeltaQp <n>      Delta QP of the static texels, 0: none (default -2)\n"
+            "      --threads <n>            Band workers, 0: up to 4 depending on the CPU (default 0)\n"
+            "      --frames <n>             Frames to process, 0: the whole file or 100 random frames\n"
+            "      --selfCheck              Check the ROI, static region, activity masking and clamping\n"
+            "                               rules on synthetic frames, then exit\n"
+            "  -v, --verbose                Print the generator setup\n"
+            "  -h, --help                   Print this help\n",
+            programName);
+}
+
+int main(int argc, const char** argv)
+{
+    VkEncoderQpMapGenerator::Config config;
+    config.width = 1920;
+    config.height = 1080;
+    std::string inputFileName;
+    uint64_t numFrames = 0;
+    bool selfCheck = false;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1) < argc;
+        if ((arg == "-h") || (arg == "--help")) {
+            PrintHelp(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (((arg == "-i") || (arg == "--input")) && hasValue) {
+            inputFileName = argv[++i];
+        } else if ((arg == "--width") && hasValue) {
+            config.width = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--height") && hasValue) {
+            config.height = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--texelSize") && hasValue) {
+            config.texelWidth = config.texelHeight = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--emphasis") {
+            config.mapType = VkEncoderQpMapGenerator::EMPHASIS_MAP;
+        } else if ((arg == "--bytesPerTexel") && hasValue) {
+            config.bytesPerTexel = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--activityStrength") && hasValue) {
+            config.activityStrength = (float)std::atof(argv[++i]);
+        } else if ((arg == "--staticDeltaQp") && hasValue) {
+            config.staticDeltaQp = std::atoi(argv[++i]);
+        } else if ((arg == "--threads") && hasValue) {
+            config.numThreads = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--frames") && hasValue) {
+            numFrames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--selfCheck") {
+            selfCheck = true;
+        } else if ((arg == "-v") || (arg == "--verbose")) {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument %s\n", arg.c_str());
+            PrintHelp(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (selfCheck) {
+        return VkEncoderQpMapGenerator::SelfCheck(verbose) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    config.lumaPitch = config.width;
+    config.mapWidth = (config.width + config.texelWidth - 1) / config.texelWidth;
+    config.mapHeight = (config.height + config.texelHeight - 1) / config.texelHeight;
+    VkEncoderQpMapGenerator generator;
+    if (!generator.Configure(config, verbose)) {
+        return EXIT_FAILURE;
+    }
+
+    FILE* pInputFile = nullptr;
+    if (!inputFileName.empty()) {
+        pInputFile = fopen(inputFileName.c_str(), "rb");
+        if (pInputFile == nullptr) {
+            fprintf(stderr, "Failed to open the input file %s\n", inputFileName.c_str());
+            return EXIT_FAILURE;
+        }
+    } else if (numFrames == 0) {
+        numFrames = 100;
+    }
+
+    const size_t lumaSize = (size_t)config.lumaPitch * config.height;
+    const size_t chromaSize = 2 * (size_t)((config.width + 1) / 2) * ((config.height + 1) / 2);
+    // Two frames, the current one and the previous one
+    std::vector<uint8_t> luma[2];
+    luma[0].resize(lumaSize);
+    luma[1].resize(lumaSize);
+    if (pInputFile == nullptr) {
+        // A flat left half and a noisy right half
+        uint32_t random = 0x2468ace1;
+        for (size_t i = 0; i < lumaSize; i++) {
+            random = (random * 1664525U) + 1013904223U;
+            luma[0][i] = luma[1][i] = (uint8_t)(((i % config.width) < (config.width / 2)) ? 96 : (random >> 24));
+        }
+    }
+
+    const size_t mapPitch = (size_t)config.mapWidth * config.bytesPerTexel;
+    std::vector<uint8_t> map(mapPitch * config.mapHeight);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t frame = 0;
+    bool success = true;
+    for (; (numFrames == 0) || (frame < numFrames); frame++) {
+        std::vector<uint8_t>& current = luma[frame & 1];
+        if (pInputFile != nullptr) {
+            if ((fread(current.data(), 1, lumaSize, pInputFile) != lumaSize) ||
+                    (fseek(pInputFile, (long)chromaSize, SEEK_CUR) != 0)) {
+                break;
+            }
+        } else {
+            // The buffer holds the frame before the previous one: bring it
+            // up to the previous frame, which changed a band of texel rows,
+            // and change the next band, the rest of the frame stays static.
+            const std::vector<uint8_t>& prev = luma[(frame + 1) & 1];
+            for (uint64_t f = (frame > 0) ? (frame - 1) : frame; f <= frame; f++) {
+                const uint32_t y = (uint32_t)((f * config.texelHeight) % config.height);
+                const uint32_t numRows = std::min(config.texelHeight, config.height - y);
+                for (size_t i = (size_t)y * config.lumaPitch; i < ((size_t)(y + numRows) * config.lumaPitch); i++) {
+                    current[i] = (f < frame) ? prev[i] : (uint8_t)(prev[i] + 7);
+                }
+            }
+        }
+
+        const uint8_t* pPrevLuma = (frame > 0) ? luma[(frame + 1) & 1].data() : nullptr;
+        success = generator.Generate(current.data(), pPrevLuma, map.data(), mapPitch);
+        if (!success) {
+            fprintf(stderr, "Failed to generate the map of frame %llu\n", (unsigned long long)frame);
+            break;
+        }
+    }
+    const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (pInputFile != nullptr) {
+        fclose(pInputFile);
+    }
+
+    generator.PrintReport(stdout);
+    printf("%llu frame(s) in %.2f s, %.3f ms per frame\n", (unsigned long long)frame, elapsedSec,
+           (frame > 0) ? ((elapsedSec * 1e3) / (double)frame) : 0.0);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
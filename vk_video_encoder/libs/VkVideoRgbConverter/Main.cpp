@@ -0,0 +1,219 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "VkVideoEncoder/VkEncoderRgbConverter.h"
+
+static void PrintHelp(const char* programName)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "Converts a raw RGB file to 4:2:0 YCbCr with the encoder input converter. Without an input\n"
+            "file, converts random frames to measure the conversion speed.\n"
+            "  -i, --input <file>           Raw RGB input file\n"
+            "  -o, --output <file>          Raw YCbCr output file\n"
+            "      --width <w>, --height <h> Picture size (default 1920x1080)\n"
+            "      --format <name>          rgba, bgra, rgb, bgr, rgb10a2 or bgr10a2 (default rgba)\n"
+            "      --outputFormat <name>    nv12, p010, i420 or i420-10bit (default nv12)\n"
+            "      --matrix <name>          bt601, bt709 or bt2020 (default bt709)\n"
+            "      --fullRange              Full range output instead of the limited (video) range\n"
+            "      --threads <n>            Conversion threads, 0: up to 4 depending on the CPU (default 0)\n"
+            "      --frames <n>             Frames to convert, 0: the whole file or 100 random frames\n"
+            "      --reference              Use the floating point reference conversion\n"
+            "      --selfCheck              Compare the fixed point conversion with the reference for all\n"
+            "                               the formats, matrices and ranges, then exit\n"
+            "  -v, --verbose                Print the conversion setup\n"
+            "  -h, --help                   Print this help\n",
+            programName);
+}
+
+int main(int argc, const char** argv)
+{
+    VkEncoderRgbConverter::Config config;
+    config.width = 1920;
+    config.height = 1080;
+    config.rgbFormat = VkEncoderRgbConverter::RGB_FORMAT_RGBA8;
+    std::string inputFileName;
+    std::string outputFileName;
+    uint64_t numFrames = 0;
+    bool useReference = false;
+    bool selfCheck = false;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1) < argc;
+        if ((arg == "-h") || (arg == "--help")) {
+            PrintHelp(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (((arg == "-i") || (arg == "--input")) && hasValue) {
+            inputFileName = argv[++i];
+        } else if (((arg == "-o") || (arg == "--output")) && hasValue) {
+            outputFileName = argv[++i];
+        } else if ((arg == "--width") && hasValue) {
+            config.width = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--height") && hasValue) {
+            config.height = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--format") && hasValue) {
+            config.rgbFormat = VkEncoderRgbConverter::GetRgbFormat(argv[++i]);
+            if (config.rgbFormat == VkEncoderRgbConverter::RGB_FORMAT_NONE) {
+                fprintf(stderr, "Unknown RGB format %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if ((arg == "--outputFormat") && hasValue) {
+            const std::string name = argv[++i];
+            uint32_t f = 0;
+            while ((f < VkEncoderRgbConverter::OUTPUT_FORMAT_COUNT) &&
+                    (name != VkEncoderRgbConverter::GetOutputFormatName((VkEncoderRgbConverter::OutputFormat)f))) {
+                f++;
+            }
+            if (f == VkEncoderRgbConverter::OUTPUT_FORMAT_COUNT) {
+                fprintf(stderr, "Unknown output format %s\n", name.c_str());
+                return EXIT_FAILURE;
+            }
+            config.outputFormat = (VkEncoderRgbConverter::OutputFormat)f;
+        } else if ((arg == "--matrix") && hasValue) {
+            const std::string matrix = argv[++i];
+            if (matrix == "bt601") {
+                config.colorStandard = YcbcrBtStandardBt601Ebu;
+            } else if (matrix == "bt709") {
+                config.colorStandard = YcbcrBtStandardBt709;
+            } else if (matrix == "bt2020") {
+                config.colorStandard = YcbcrBtStandardBt2020;
+            } else {
+                fprintf(stderr, "Unknown matrix %s\n", matrix.c_str());
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--fullRange") {
+            config.fullRange = true;
+        } else if ((arg == "--threads") && hasValue) {
+            config.numThreads = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--frames") && hasValue) {
+            numFrames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--reference") {
+            useReference = true;
+        } else if (arg == "--selfCheck") {
+            selfCheck = true;
+        } else if ((arg == "-v") || (arg == "--verbose")) {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument %s\n", arg.c_str());
+            PrintHelp(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (selfCheck) {
+        return VkEncoderRgbConverter::SelfCheck(verbose) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    VkEncoderRgbConverter converter;
+    if (!converter.Configure(config, verbose)) {
+        return EXIT_FAILURE;
+    }
+
+    FILE* pInputFile = nullptr;
+    if (!inputFileName.empty()) {
+        pInputFile = fopen(inputFileName.c_str(), "rb");
+        if (pInputFile == nullptr) {
+            fprintf(stderr, "Failed to open the input file %s\n", inputFileName.c_str());
+            return EXIT_FAILURE;
+        }
+    } else if (numFrames == 0) {
+        numFrames = 100;
+    }
+
+    FILE* pOutputFile = nullptr;
+    if (!outputFileName.empty()) {
+        pOutputFile = fopen(outputFileName.c_str(), "wb");
+        if (pOutputFile == nullptr) {
+            fprintf(stderr, "Failed to open the output file %s\n", outputFileName.c_str());
+            if (pInputFile != nullptr) {
+                fclose(pInputFile);
+            }
+            return EXIT_FAILURE;
+        }
+    }
+
+    const size_t srcPitch = (size_t)config.width * VkEncoderRgbConverter::GetBytesPerPixel(config.rgbFormat);
+    std::vector<uint8_t> src(srcPitch * config.height);
+    if (pInputFile == nullptr) {
+        uint32_t random = 0x2468ace1;
+        for (size_t i = 0; i < src.size(); i++) {
+            random = (random * 1664525U) + 1013904223U;
+            src[i] = (uint8_t)(random >> 24);
+        }
+    }
+
+    const uint32_t bytesPerSample = (VkEncoderRgbConverter::GetOutputBitDepth(config.outputFormat) > 8) ? 2 : 1;
+    const uint32_t numPlanes = VkEncoderRgbConverter::GetOutputNumPlanes(config.outputFormat);
+    const uint32_t chromaWidth = (config.width + 1) / 2;
+    const uint32_t chromaHeight = (config.height + 1) / 2;
+    const size_t dstPitches[3] = { (size_t)config.width * bytesPerSample,
+                                   (size_t)chromaWidth * bytesPerSample * ((numPlanes == 2) ? 2 : 1),
+                                   (size_t)chromaWidth * bytesPerSample };
+    const size_t planeSizes[3] = { dstPitches[0] * config.height, dstPitches[1] * chromaHeight,
+                                   (numPlanes > 2) ? (dstPitches[2] * chromaHeight) : 0 };
+    std::vector<uint8_t> dst(planeSizes[0] + planeSizes[1] + planeSizes[2]);
+    uint8_t* const pDstPlanes[3] = { dst.data(), dst.data() + planeSizes[0],
+                                     dst.data() + planeSizes[0] + planeSizes[1] };
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t frame = 0;
+    bool success = true;
+    for (; (numFrames == 0) || (frame < numFrames); frame++) {
+        if ((pInputFile != nullptr) && (fread(src.data(), 1, src.size(), pInputFile) != src.size())) {
+            break;
+        }
+
+        success = useReference ? converter.ConvertReference(src.data(), srcPitch, pDstPlanes, dstPitches) :
+                                 converter.Convert(src.data(), srcPitch, pDstPlanes, dstPitches);
+        if (!success) {
+            fprintf(stderr, "Failed to convert frame %llu\n", (unsigned long long)frame);
+            break;
+        }
+
+        if ((pOutputFile != nullptr) && (fwrite(dst.data(), 1, dst.size(), pOutputFile) != dst.size())) {
+            fprintf(stderr, "Failed to write frame %llu\n", (unsigned long long)frame);
+            success = false;
+            break;
+        }
+    }
+    const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (pInputFile != nullptr) {
+        fclose(pInputFile);
+    }
+    if (pOutputFile != nullptr) {
+        fclose(pOutputFile);
+    }
+
+    if (useReference) {
+        printf("Reference: %llu frame(s), %.3f ms per frame\n", (unsigned long long)frame,
+               (frame > 0) ? ((elapsedSec * 1e3) / (double)frame) : 0.0);
+    } else {
+        converter.PrintReport(stdout);
+    }
+    printf("%llu frame(s) in %.2f s\n", (unsigned long long)frame, elapsedSec);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "VkVideoStreamGenerator/VkVideoStreamGenerator.h"
+
+static void PrintHelp(const char* programName)
+{
+    fprintf(stderr,
+            "Usage: %s -o <output file> [options]\n"
+            "Writes a synthetic, seeded H.264/H.265 Annex B or AV1 stream for parser benchmarks.\n"
+            "  -o, --output <file>          .264/.h264, .265/.h265, .ivf (AV1 in IVF) or .obu (AV1 low-overhead OBUs)\n"
+            "  -c, --codec <name>           h264 | h265 | av1 (default: from the file extension)\n"
+            "      --seed <n>               Seed of the random payloads and header values (default 1)\n"
+            "      --width <w>, --height <h> Picture size (default 1920x1080)\n"
+            "      --frames <n>             Number of frames / temporal units (default 300)\n"
+            "      --fps <n>                Frame rate of the VUI / timing info (default 30)\n"
+            "      --idrPeriod <n>          Frames between key frames, 0: first frame only (default 60)\n"
+            "      --frameSize <bytes>      Average inter frame payload, key frames are 4x (default 16384)\n"
+            "      --slices <n>             H.26x slices / AV1 tiles per picture (default 1)\n"
+            "      --parameterSetInterval <n> Also repeat the parameter sets every n frames (default: key frames only)\n"
+            "      --changeParameterSets    Alternate the PPS, and the SPS / sequence header at key frames\n"
+            "      --seiSize <bytes>        Add a user data SEI / metadata OBU of this size to each picture\n"
+            "      --emulationRuns <n>      Insert runs of n zero bytes in the payloads (emulation prevention)\n"
+            "      --mvc                    H.264: add a second view (subset SPS, prefix and slice extension NAL units)\n"
+            "      --tileGroups <n>         AV1: split the tiles of each frame into n tile group OBUs\n"
+            "      --hiddenFrames <n>       AV1: code a frame that is not shown ahead of every n-th frame\n"
+            "      --tusPerPacket <n>       AV1 IVF: temporal units per IVF frame (default 1). NvVideoParser outputs\n"
+            "                               one shown frame per packet, so n > 1 is a demuxer stress input\n"
+            "  -h, --help                   Print this help\n",
+            programName);
+}
+
+static bool GetCodecFromName(const std::string& name, VkVideoStreamGeneratorConfig& config)
+{
+    if ((name == "h264") || (name == "264") || (name == "avc")) {
+        config.codec = VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR;
+        config.container = VkVideoStreamGeneratorConfig::CONTAINER_ANNEXB;
+    } else if ((name == "h265") || (name == "265") || (name == "hevc")) {
+        config.codec = VK_VIDEO_CODEC_OPERATION_ENCODE_H265_BIT_KHR;
+        config.container = VkVideoStreamGeneratorConfig::CONTAINER_ANNEXB;
+    } else if ((name == "av1") || (name == "ivf")) {
+        config.codec = VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR;
+        config.container = VkVideoStreamGeneratorConfig::CONTAINER_IVF;
+    } else if (name == "obu") {
+        config.codec = VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR;
+        config.container = VkVideoStreamGeneratorConfig::CONTAINER_OBU;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, const char** argv)
+{
+    VkVideoStreamGeneratorConfig config;
+    std::string outputFileName;
+    std::string codecName;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1) < argc;
+        if ((arg == "-h") || (arg == "--help")) {
+            PrintHelp(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (((arg == "-o") || (arg == "--output")) && hasValue) {
+            outputFileName = argv[++i];
+        } else if (((arg == "-c") || (arg == "--codec")) && hasValue) {
+            codecName = argv[++i];
+        } else if ((arg == "--seed") && hasValue) {
+            config.seed = std::strtoull(argv[++i], nullptr, 0);
+        } else if ((arg == "--width") && hasValue) {
+            config.width = (uint32_t)std::max(std::atoi(argv[++i]), 16);
+        } else if ((arg == "--height") && hasValue) {
+            config.height = (uint32_t)std::max(std::atoi(argv[++i]), 16);
+        } else if ((arg == "--frames") && hasValue) {
+            config.numFrames = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--fps") && hasValue) {
+            config.frameRate = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--idrPeriod") && hasValue) {
+            config.idrPeriod = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--frameSize") && hasValue) {
+            config.frameSize = (uint32_t)std::max(std::atoi(argv[++i]), 16);
+        } else if ((arg == "--slices") && hasValue) {
+            config.slicesPerPicture = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--parameterSetInterval") && hasValue) {
+            config.parameterSetInterval = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if (arg == "--changeParameterSets") {
+            config.changeParameterSets = true;
+        } else if ((arg == "--seiSize") && hasValue) {
+            config.seiSize = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--emulationRuns") && hasValue) {
+            config.emulationRunLength = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if (arg == "--mvc") {
+            config.mvc = true;
+        } else if ((arg == "--tileGroups") && hasValue) {
+            config.tileGroups = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--hiddenFrames") && hasValue) {
+            config.hiddenFramePeriod = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--tusPerPacket") && hasValue) {
+            config.temporalUnitsPerPacket = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument %s\n", arg.c_str());
+            PrintHelp(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (outputFileName.empty()) {
+        PrintHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::string extension;
+    const size_t dot = outputFileName.find_last_of('.');
+    if (dot != std::string::npos) {
+        extension = outputFileName.substr(dot + 1);
+    }
+    if (!GetCodecFromName(codecName.empty() ? extension : codecName, config)) {
+        fprintf(stderr, "Unknown codec \"%s\", use --codec\n", codecName.empty() ? extension.c_str() : codecName.c_str());
+        return EXIT_FAILURE;
+    }
+    // AV1 goes to an IVF file unless the output is an .obu file.
+    if ((config.codec == VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR) && (extension == "obu")) {
+        config.container = VkVideoStreamGeneratorConfig::CONTAINER_OBU;
+    }
+
+    FILE* outputFile = fopen(outputFileName.c_str(), "wb");
+    if (outputFile == nullptr) {
+        fprintf(stderr, "Can't open the output file %s\n", outputFileName.c_str());
+        return EXIT_FAILURE;
+    }
+
+    VkVideoStreamGenerator generator(config);
+    const VkResult result = generator.Generate(outputFile);
+    fclose(outputFile);
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "Generating %s failed, error %d\n", outputFileName.c_str(), result);
+        return EXIT_FAILURE;
+    }
+
+    const VkVideoStreamGenerator::Stats& stats = generator.GetStats();
+    fprintf(stderr, "%s: %llu bytes, %u frame(s) (%u key), %u slice(s)/tile(s), %u NAL unit(s)/OBU(s), "
+            "%u parameter set(s), %u SEI/metadata, %u packet(s), %u emulation prevention byte(s)\n",
+            outputFileName.c_str(), (unsigned long long)stats.numBytes, stats.numFrames, stats.numKeyFrames,
+            stats.numSlices, stats.numUnits, stats.numParameterSets, stats.numMetadata, stats.numPackets,
+            stats.emulationPreventionBytes);
+
+    return EXIT_SUCCESS;
+}
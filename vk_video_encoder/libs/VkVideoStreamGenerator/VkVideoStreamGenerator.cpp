@@ -0,0 +1,950 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include "VkVideoEncoder/VkVideoEncoderDef.h"
+#include "VkVideoStreamGenerator/VkVideoStreamGenerator.h"
+
+// NAL unit types and OBU types written by the generator, in addition to the
+// parameter sets of VkEncoderHeaderWriter.
+enum {
+    H264_NAL_SLICE = 1, H264_NAL_SLICE_IDR = 5, H264_NAL_SEI = 6,
+    H264_NAL_PREFIX = 14, H264_NAL_SUBSET_SPS = 15, H264_NAL_SLICE_EXTENSION = 20,
+};
+enum { H265_NAL_TRAIL_R = 1, H265_NAL_IDR_W_RADL = 19, H265_NAL_PREFIX_SEI = 39 };
+enum {
+    AV1_OBU_TEMPORAL_DELIMITER = 2, AV1_OBU_FRAME_HEADER = 3, AV1_OBU_TILE_GROUP = 4,
+    AV1_OBU_METADATA = 5, AV1_OBU_FRAME = 6,
+};
+
+static const uint32_t seiUserDataUnregistered = 5;
+static const uint32_t av1MetadataTypeUserPrivate = 6;     // METADATA_TYPE_UNREGISTERED_USER_PRIVATE_6
+static const uint32_t av1TileSizeBytes = 4;
+
+// uuid_iso_iec_11578 of the user data SEI messages.
+static const uint8_t generatorUuid[16] = {
+    0x8c, 0x1f, 0x3a, 0x52, 0x64, 0xd0, 0x4e, 0x11, 0x9b, 0x07, 0x5e, 0x6a, 0x20, 0x41, 0xc3, 0x9d
+};
+
+// Smallest k such that (blkSize << k) >= target, AV1 tile_log2().
+static uint32_t TileLog2(uint32_t blkSize, uint32_t target)
+{
+    uint32_t k = 0;
+    while ((blkSize << k) < target) {
+        k++;
+    }
+    return k;
+}
+
+VkVideoStreamGenerator::VkVideoStreamGenerator(const VkVideoStreamGeneratorConfig& config)
+    : m_config(config)
+    , m_stats()
+    , m_randomState(config.seed)
+    , m_parameterSetVariant(0)
+    , m_sequenceVariant(0)
+    , m_fp(nullptr)
+    , m_pStream(nullptr)
+    , m_h264State()
+    , m_h264FrameNum(0)
+    , m_h264IdrPicId(0)
+    , m_h265Vps()
+    , m_h265Sps()
+    , m_h265Pps()
+    , m_h265CtbSizeY(32)
+    , m_h265PicSizeInCtbsY(0)
+    , m_h265PocIdr(0)
+    , m_av1State()
+    , m_av1ColorConfig()
+    , m_av1TileColsLog2(0)
+    , m_av1TileRowsLog2(0)
+    , m_av1MinTileColsLog2(0)
+    , m_av1MaxTileColsLog2(0)
+    , m_av1MinTileRowsLog2(0)
+    , m_av1MaxTileRowsLog2(0)
+    , m_av1NumTiles(1)
+    , m_av1OrderHint(0)
+{
+    m_config.width = std::max<uint32_t>(m_config.width, 16);
+    m_config.height = std::max<uint32_t>(m_config.height, 16);
+    m_config.frameRate = std::max<uint32_t>(m_config.frameRate, 1);
+    m_config.slicesPerPicture = std::max<uint32_t>(m_config.slicesPerPicture, 1);
+    m_config.tileGroups = std::max<uint32_t>(m_config.tileGroups, 1);
+    m_config.temporalUnitsPerPacket = std::max<uint32_t>(m_config.temporalUnitsPerPacket, 1);
+    if ((m_config.seiSize > 0) && (m_config.seiSize < sizeof(generatorUuid))) {
+        m_config.seiSize = sizeof(generatorUuid);
+    }
+}
+
+// splitmix64: cheap, and the same sequence on every platform.
+uint32_t VkVideoStreamGenerator::Random()
+{
+    uint64_t z = (m_randomState += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+uint32_t VkVideoStreamGenerator::Random(uint32_t minValue, uint32_t maxValue)
+{
+    assert(minValue <= maxValue);
+    return minValue + (uint32_t)(((uint64_t)Random() * (maxValue - minValue + 1)) >> 32);
+}
+
+// Size of one slice / tile: the frame size -25%..+25%, key frames 4x.
+uint32_t VkVideoStreamGenerator::GetPayloadSize(bool keyFrame, uint32_t numParts)
+{
+    const uint32_t frameSize = keyFrame ? (4 * m_config.frameSize) : m_config.frameSize;
+    const uint32_t partSize = std::max<uint32_t>(frameSize / numParts, 4);
+    return Random(partSize - (partSize / 4), partSize + (partSize / 4));
+}
+
+void VkVideoStreamGenerator::PutPayload(VkEncoderBitWriter& bs, uint32_t size)
+{
+    assert(bs.IsByteAligned());
+    std::vector<uint8_t> payload(size);
+
+    for (uint32_t i = 0; i < size; i += 4) {
+        const uint32_t value = Random();
+        const uint32_t numBytes = std::min<uint32_t>(size - i, 4);
+        memcpy(&payload[i], &value, numBytes);
+    }
+
+    // Zero runs followed by a byte below 4, every 64..511 bytes: each one
+    // needs emulation prevention bytes and looks like a start code prefix.
+    if (m_config.emulationRunLength > 0) {
+        uint32_t offset = Random(0, 63);
+        while ((offset + m_config.emulationRunLength + 1) < size) {
+            memset(&payload[offset], 0, m_config.emulationRunLength);
+            payload[offset + m_config.emulationRunLength] = (uint8_t)Random(0, 3);
+            offset += m_config.emulationRunLength + 1 + Random(64, 511);
+        }
+    }
+
+    // rbsp_slice_trailing_bits(): the stop bit and the alignment zero bits.
+    payload[size - 1] = 0x80;
+    bs.PutBytes(payload.data(), payload.size());
+}
+
+void VkVideoStreamGenerator::AppendNalUnit(std::vector<uint8_t>& out, uint32_t nalRefIdc, uint32_t nalUnitType,
+                                           const VkEncoderBitWriter& bs, bool parameterSet)
+{
+    assert(bs.IsByteAligned());
+    if (m_config.codec == VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR) {
+        m_stats.emulationPreventionBytes += VkEncoderHeaderWriter::AppendH264NalUnit(nalRefIdc, nalUnitType,
+                                                                                     bs.GetData().data(), bs.GetData().size(), out);
+    } else {
+        m_stats.emulationPreventionBytes += VkEncoderHeaderWriter::AppendH265NalUnit(nalUnitType, 0,
+                                                                                     bs.GetData().data(), bs.GetData().size(), out);
+    }
+    m_stats.numUnits++;
+    if (parameterSet) {
+        m_stats.numParameterSets++;
+    }
+}
+
+void VkVideoStreamGenerator::AppendObu(std::vector<uint8_t>& out, uint32_t obuType, const VkEncoderBitWriter& bs)
+{
+    assert(bs.IsByteAligned());
+    VkEncoderHeaderWriter::AppendObu(obuType, bs.GetData().data(), bs.GetData().size(), out);
+    m_stats.numUnits++;
+}
+
+// sei_message() of a user_data_unregistered() payload of m_config.seiSize bytes.
+void VkVideoStreamGenerator::PutSeiMessage(VkEncoderBitWriter& bs)
+{
+    bs.PutBits(seiUserDataUnregistered, 8);
+    uint32_t payloadSize = m_config.seiSize;
+    while (payloadSize >= 255) {
+        bs.PutBits(0xff, 8);
+        payloadSize -= 255;
+    }
+    bs.PutBits(payloadSize, 8);
+
+    bs.PutBytes(generatorUuid, sizeof(generatorUuid));
+    for (uint32_t i = sizeof(generatorUuid); i < m_config.seiSize; i++) {
+        bs.PutBits(Random() & 0xff, 8);
+    }
+    bs.PutTrailingBits();
+}
+
+VkResult VkVideoStreamGenerator::Generate(FILE* fp)
+{
+    return Generate(fp, nullptr);
+}
+
+VkResult VkVideoStreamGenerator::Generate(std::vector<uint8_t>& stream)
+{
+    return Generate(nullptr, &stream);
+}
+
+bool VkVideoStreamGenerator::Output(const std::vector<uint8_t>& data)
+{
+    m_stats.numBytes += data.size();
+    if (m_pStream != nullptr) {
+        m_pStream->insert(m_pStream->end(), data.begin(), data.end());
+        return true;
+    }
+    return (fwrite(data.data(), 1, data.size(), m_fp) == data.size());
+}
+
+VkResult VkVideoStreamGenerator::Generate(FILE* fp, std::vector<uint8_t>* pStream)
+{
+    const bool isAv1 = (m_config.codec == VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR);
+    if ((m_config.codec != VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR) &&
+        (m_config.codec != VK_VIDEO_CODEC_OPERATION_ENCODE_H265_BIT_KHR) && !isAv1) {
+        return VK_ERROR_VIDEO_PROFILE_CODEC_NOT_SUPPORTED_KHR;
+    }
+    if (isAv1 == (m_config.container == VkVideoStreamGeneratorConfig::CONTAINER_ANNEXB)) {
+        return VK_ERROR_FORMAT_NOT_SUPPORTED;
+    }
+
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_randomState = m_config.seed;
+    m_parameterSetVariant = 0;
+    m_sequenceVariant = 0;
+    m_fp = fp;
+    m_pStream = pStream;
+
+    if (m_config.codec == VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR) {
+        InitH264ParameterSets();
+    } else if (m_config.codec == VK_VIDEO_CODEC_OPERATION_ENCODE_H265_BIT_KHR) {
+        InitH265ParameterSets();
+    } else {
+        InitAv1SequenceHeader();
+    }
+
+    const bool ivf = (m_config.container == VkVideoStreamGeneratorConfig::CONTAINER_IVF);
+    const uint32_t numPackets = ivf ? DivUp(m_config.numFrames, m_config.temporalUnitsPerPacket) : m_config.numFrames;
+    std::vector<uint8_t> packet;
+
+    if (ivf) {
+        // IVF file header: signature, version, header size, fourcc, size, time base and frame count.
+        const uint8_t header[32] = {
+            'D', 'K', 'I', 'F', 0, 0, 32, 0, 'A', 'V', '0', '1',
+            (uint8_t)m_config.width, (uint8_t)(m_config.width >> 8),
+            (uint8_t)m_config.height, (uint8_t)(m_config.height >> 8),
+            (uint8_t)m_config.frameRate, (uint8_t)(m_config.frameRate >> 8),
+            (uint8_t)(m_config.frameRate >> 16), (uint8_t)(m_config.frameRate >> 24),
+            1, 0, 0, 0,
+            (uint8_t)numPackets, (uint8_t)(numPackets >> 8), (uint8_t)(numPackets >> 16), (uint8_t)(numPackets >> 24),
+            0, 0, 0, 0
+        };
+        packet.assign(header, header + sizeof(header));
+        if (!Output(packet)) {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    const uint32_t ivfFrameHeaderSize = 12;
+    for (uint32_t frameIndex = 0; frameIndex < m_config.numFrames; ) {
+        packet.clear();
+        if (ivf) {
+            packet.resize(ivfFrameHeaderSize, 0);
+        }
+
+        const uint32_t numUnits = ivf ? std::min(m_config.temporalUnitsPerPacket, m_config.numFrames - frameIndex) : 1;
+        for (uint32_t i = 0; i < numUnits; i++, frameIndex++) {
+            const bool keyFrame = (frameIndex == 0) || ((m_config.idrPeriod > 0) && ((frameIndex % m_config.idrPeriod) == 0));
+            if (keyFrame) {
+                m_stats.numKeyFrames++;
+            }
+            if (m_config.codec == VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR) {
+                GenerateH264AccessUnit(frameIndex, keyFrame, packet);
+            } else if (m_config.codec == VK_VIDEO_CODEC_OPERATION_ENCODE_H265_BIT_KHR) {
+                GenerateH265AccessUnit(frameIndex, keyFrame, packet);
+            } else {
+                GenerateAv1TemporalUnit(frameIndex, keyFrame, packet);
+            }
+        }
+
+        if (ivf) {
+            // IVF frame header: frame size and the timestamp of the first temporal unit.
+            const uint32_t frameSize = (uint32_t)(packet.size() - ivfFrameHeaderSize);
+            const uint64_t timestamp = frameIndex - numUnits;
+            for (uint32_t i = 0; i < 4; i++) {
+                packet[i] = (uint8_t)(frameSize >> (8 * i));
+            }
+            for (uint32_t i = 0; i < 8; i++) {
+                packet[4 + i] = (uint8_t)(timestamp >> (8 * i));
+            }
+        }
+        m_stats.numPackets++;
+        if (!Output(packet)) {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// H.264
+
+// The SPS / PPS of EncoderConfigH264::InitSpsPpsParameters() for a High
+// profile, CABAC, P-frame only configuration.
+void VkVideoStreamGenerator::InitH264ParameterSets()
+{
+    StdVideoH264SequenceParameterSet& sps = m_h264State.m_spsInfo;
+    StdVideoH264PictureParameterSet& pps = m_h264State.m_ppsInfo;
+    StdVideoH264SequenceParameterSetVui& vui = m_h264State.m_vuiInfo;
+
+    const uint32_t picWidthInMbs = DivUp<uint32_t>(m_config.width, H264MbSizeAlignment);
+    const uint32_t picHeightInMapUnits = DivUp<uint32_t>(m_config.height, H264MbSizeAlignment);
+    const uint32_t frameSizeInMbs = picWidthInMbs * picHeightInMapUnits;
+
+    sps = StdVideoH264SequenceParameterSet();
+    sps.pSequenceParameterSetVui = &vui;
+    vui = StdVideoH264SequenceParameterSetVui();
+    pps = StdVideoH264PictureParameterSet();
+
+    sps.profile_idc = STD_VIDEO_H264_PROFILE_IDC_HIGH;
+    sps.level_idc = (frameSizeInMbs <= 8192) ? STD_VIDEO_H264_LEVEL_IDC_4_1 :
+                    (frameSizeInMbs <= 36864) ? STD_VIDEO_H264_LEVEL_IDC_5_1 : STD_VIDEO_H264_LEVEL_IDC_6_2;
+    sps.chroma_format_idc = STD_VIDEO_H264_CHROMA_FORMAT_IDC_420;
+    sps.pic_width_in_mbs_minus1 = picWidthInMbs - 1;
+    sps.pic_height_in_map_units_minus1 = picHeightInMapUnits - 1;
+    sps.flags.frame_mbs_only_flag = true;
+    sps.flags.direct_8x8_inference_flag = true;
+    if ((16 * picWidthInMbs > m_config.width) || (16 * picHeightInMapUnits > m_config.height)) {
+        sps.flags.frame_cropping_flag = true;
+        sps.frame_crop_right_offset = (16 * picWidthInMbs - m_config.width) >> 1;
+        sps.frame_crop_bottom_offset = (16 * picHeightInMapUnits - m_config.height) >> 1;
+    }
+    sps.seq_parameter_set_id = 0;
+    sps.log2_max_frame_num_minus4 = 4;
+    sps.log2_max_pic_order_cnt_lsb_minus4 = 4;
+    sps.pic_order_cnt_type = STD_VIDEO_H264_POC_TYPE_2;
+    sps.max_num_ref_frames = m_config.mvc ? 2 : 1;
+    sps.flags.vui_parameters_present_flag = true;
+
+    vui.flags.timing_info_present_flag = true;
+    vui.flags.fixed_frame_rate_flag = true;
+    vui.num_units_in_tick = 1;
+    vui.time_scale = 2 * m_config.frameRate;
+    vui.video_format = 5;           // Unspecified video format
+    vui.colour_primaries = 1;       // BT.709
+    vui.transfer_characteristics = 1;
+    vui.matrix_coefficients = 1;
+    vui.flags.bitstream_restriction_flag = true;
+    vui.max_num_reorder_frames = 0;
+    vui.max_dec_frame_buffering = sps.max_num_ref_frames;
+
+    pps.seq_parameter_set_id = sps.seq_parameter_set_id;
+    pps.pic_parameter_set_id = 0;
+    pps.weighted_bipred_idc = STD_VIDEO_H264_WEIGHTED_BIPRED_IDC_DEFAULT;
+    pps.num_ref_idx_l0_default_active_minus1 = 0;
+    pps.flags.transform_8x8_mode_flag = true;
+    pps.flags.entropy_coding_mode_flag = true;
+    pps.flags.deblocking_filter_control_present_flag = true;
+    m_h264FrameNum = 0;
+    m_h264IdrPicId = 0;
+}
+
+void VkVideoStreamGenerator::GenerateH264AccessUnit(uint32_t frameIndex, bool keyFrame, std::vector<uint8_t>& out)
+{
+    StdVideoH264SequenceParameterSet& sps = m_h264State.m_spsInfo;
+    StdVideoH264PictureParameterSet& pps = m_h264State.m_ppsInfo;
+    StdVideoH264SequenceParameterSetVui& vui = m_h264State.m_vuiInfo;
+    VkEncoderBitWriter bs;
+
+    const bool parameterSets = keyFrame ||
+        ((m_config.parameterSetInterval > 0) && ((frameIndex % m_config.parameterSetInterval) == 0));
+    if (parameterSets) {
+        if (m_config.changeParameterSets) {
+            // The SPS only changes at IDR pictures, the PPS every time it is sent.
+            if (keyFrame) {
+                vui.flags.video_signal_type_present_flag = (m_sequenceVariant & 1);
+                vui.flags.color_description_present_flag = (m_sequenceVariant & 1);
+                m_sequenceVariant++;
+            }
+            pps.pic_init_qp_minus26 = (m_parameterSetVariant & 1) ? -4 : 0;
+            pps.chroma_qp_index_offset = pps.second_chroma_qp_index_offset = (int8_t)(m_parameterSetVariant % 3);
+            m_parameterSetVariant++;
+        }
+
+        VkEncoderHeaderWriter::WriteH264Sps(&sps, bs);
+        AppendNalUnit(out, 3, VkEncoderHeaderWriter::H264_NAL_SPS, bs, true);
+
+        if (m_config.mvc) {
+            // subset_seq_parameter_set_rbsp() of a Stereo High stream with
+            // view 1 predicted from view 0.
+            StdVideoH264SequenceParameterSet subsetSps = sps;
+            subsetSps.profile_idc = (StdVideoH264ProfileIdc)128;
+            bs.Reset();
+            VkEncoderHeaderWriter::WriteH264Sps(&subsetSps, bs, false);
+            bs.PutFlag(true);       // bit_equal_to_one
+            bs.PutUe(1);            // num_views_minus1
+            bs.PutUe(0);            // view_id[0]
+            bs.PutUe(1);            // view_id[1]
+            bs.PutUe(1);            // num_anchor_refs_l0[1]
+            bs.PutUe(0);            // anchor_ref_l0[1][0]
+            bs.PutUe(0);            // num_anchor_refs_l1[1]
+            bs.PutUe(1);            // num_non_anchor_refs_l0[1]
+            bs.PutUe(0);            // non_anchor_ref_l0[1][0]
+            bs.PutUe(0);            // num_non_anchor_refs_l1[1]
+            bs.PutUe(0);            // num_level_values_signalled_minus1
+            bs.PutBits(VkEncoderHeaderWriter::GetH264LevelIdc(sps.level_idc), 8);
+            bs.PutUe(0);            // num_applicable_ops_minus1[0]
+            bs.PutBits(0, 3);       // applicable_op_temporal_id[0][0]
+            bs.PutUe(1);            // applicable_op_num_target_views_minus1[0][0]
+            bs.PutUe(0);            // applicable_op_target_view_id[0][0][0]
+            bs.PutUe(1);            // applicable_op_target_view_id[0][0][1]
+            bs.PutUe(1);            // applicable_op_num_views_minus1[0][0]
+            bs.PutFlag(false);      // mvc_vui_parameters_present_flag
+            bs.PutFlag(false);      // additional_extension2_flag
+            bs.PutTrailingBits();
+            AppendNalUnit(out, 3, H264_NAL_SUBSET_SPS, bs, true);
+        }
+
+        bs.Reset();
+        VkEncoderHeaderWriter::WriteH264Pps(&sps, &pps, bs);
+        AppendNalUnit(out, 3, VkEncoderHeaderWriter::H264_NAL_PPS, bs, true);
+    }
+
+    if (m_config.seiSize > 0) {
+        bs.Reset();
+        PutSeiMessage(bs);
+        AppendNalUnit(out, 0, H264_NAL_SEI, bs);
+        m_stats.numMetadata++;
+    }
+
+    if (keyFrame) {
+        m_h264FrameNum = 0;
+    }
+
+    const uint32_t frameSizeInMbs = (sps.pic_width_in_mbs_minus1 + 1) * (sps.pic_height_in_map_units_minus1 + 1);
+    const uint32_t numSlices = std::min(m_config.slicesPerPicture, frameSizeInMbs);
+    const uint32_t nalRefIdc = keyFrame ? 3 : 2;
+    const uint32_t numViews = m_config.mvc ? 2 : 1;
+
+    for (uint32_t view = 0; view < numViews; view++) {
+        // nal_unit_header_mvc_extension(): non_idr_flag, priority_id, view_id,
+        // temporal_id, anchor_pic_flag, inter_view_flag and reserved_one_bit.
+        const uint32_t mvcExtension = ((keyFrame ? 0 : 1) << 22) | (view << 6) | ((keyFrame ? 1 : 0) << 2) |
+                                      ((view == 0) ? (1 << 1) : 0) | 1;
+        for (uint32_t slice = 0; slice < numSlices; slice++) {
+            if (m_config.mvc) {
+                const uint32_t nalUnitType = (view == 0) ? (uint32_t)H264_NAL_PREFIX : (uint32_t)H264_NAL_SLICE_EXTENSION;
+                bs.Reset();
+                bs.PutBits((nalRefIdc << 5) | nalUnitType, 8);
+                bs.PutBits(mvcExtension, 24);   // svc_extension_flag = 0
+                if (view == 0) {
+                    // prefix_nal_unit_rbsp() is empty for MVC.
+                    m_stats.emulationPreventionBytes += VkEncoderHeaderWriter::AppendNalUnit(bs.GetData().data(), 4,
+                                                                                             bs.GetData().size(), out);
+                    m_stats.numUnits++;
+                    bs.Reset();
+                }
+            } else {
+                bs.Reset();
+            }
+
+            const uint32_t firstMb = (uint32_t)(((uint64_t)slice * frameSizeInMbs) / numSlices);
+            bs.PutUe(firstMb);                  // first_mb_in_slice
+            bs.PutUe(keyFrame ? 7 : 5);         // slice_type: all I / all P slices
+            bs.PutUe(pps.pic_parameter_set_id);
+            bs.PutBits(m_h264FrameNum, sps.log2_max_frame_num_minus4 + 4);
+            if (keyFrame) {
+                bs.PutUe(m_h264IdrPicId);       // idr_pic_id
+            }
+            if (!keyFrame) {
+                bs.PutFlag(false);              // num_ref_idx_active_override_flag
+                bs.PutFlag(false);              // ref_pic_list_modification_flag_l0
+            }
+            if (keyFrame) {
+                bs.PutFlag(false);              // no_output_of_prior_pics_flag
+                bs.PutFlag(false);              // long_term_reference_flag
+            } else {
+                bs.PutFlag(false);              // adaptive_ref_pic_marking_mode_flag
+            }
+            if (pps.flags.entropy_coding_mode_flag && !keyFrame) {
+                bs.PutUe(0);                    // cabac_init_idc
+            }
+            bs.PutSe((int32_t)Random(0, 8) - 4); // slice_qp_delta
+            if (pps.flags.deblocking_filter_control_present_flag) {
+                bs.PutUe(0);                    // disable_deblocking_filter_idc
+                bs.PutSe(0);                    // slice_alpha_c0_offset_div2
+                bs.PutSe(0);                    // slice_beta_offset_div2
+            }
+            if (pps.flags.entropy_coding_mode_flag) {
+                bs.PutAlignmentBits(true);      // cabac_alignment_one_bit
+            } else {
+                bs.PutAlignmentBits();
+            }
+            PutPayload(bs, GetPayloadSize(keyFrame, numSlices));
+
+            if (view == 0) {
+                AppendNalUnit(out, nalRefIdc, keyFrame ? H264_NAL_SLICE_IDR : H264_NAL_SLICE, bs);
+            } else {
+                m_stats.emulationPreventionBytes += VkEncoderHeaderWriter::AppendNalUnit(bs.GetData().data(), 4,
+                                                                                         bs.GetData().size(), out);
+                m_stats.numUnits++;
+            }
+            m_stats.numSlices++;
+        }
+    }
+
+    if (keyFrame) {
+        m_h264IdrPicId = (m_h264IdrPicId + 1) & 0xffff;
+    }
+    m_h264FrameNum = (m_h264FrameNum + 1) % (1u << (sps.log2_max_frame_num_minus4 + 4));
+    m_stats.numFrames++;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// H.265
+
+// The VPS / SPS / PPS of EncoderConfigH265::InitParamameters() for a Main
+// profile configuration with 32x32 CTBs and a single reference picture.
+void VkVideoStreamGenerator::InitH265ParameterSets()
+{
+    StdVideoH265SequenceParameterSet& sps = m_h265Sps.sps;
+    StdVideoH265VideoParameterSet& vps = m_h265Vps.vpsInfo;
+    StdVideoH265SequenceParameterSetVui& vui = m_h265Sps.vuiInfo;
+    StdVideoH265PictureParameterSet& pps = m_h265Pps;
+
+    const uint32_t ctbLog2SizeY = 5;
+    const uint32_t minCbLog2SizeY = 3;
+    const uint32_t log2MinTransformBlockSize = 2;
+    const uint32_t log2MaxTransformBlockSize = 5;
+    const uint32_t picWidthAlignedToMinCbsY = AlignSize<uint32_t>(m_config.width, 1 << minCbLog2SizeY);
+    const uint32_t picHeightAlignedToMinCbsY = AlignSize<uint32_t>(m_config.height, 1 << minCbLog2SizeY);
+    const uint32_t lumaPictureSize = picWidthAlignedToMinCbsY * picHeightAlignedToMinCbsY;
+    const uint32_t dpbCount = 2;
+
+    // SpsH265 links its members together, only the variable parts are reset.
+    vui.flags = StdVideoH265SpsVuiFlags();
+    pps = StdVideoH265PictureParameterSet();
+
+    m_h265CtbSizeY = 1 << ctbLog2SizeY;
+    m_h265PicSizeInCtbsY = DivUp(picWidthAlignedToMinCbsY, m_h265CtbSizeY) * DivUp(picHeightAlignedToMinCbsY, m_h265CtbSizeY);
+
+    m_h265Sps.decPicBufMgr.max_dec_pic_buffering_minus1[0] = (uint8_t)(dpbCount - 1);
+    m_h265Sps.decPicBufMgr.max_num_reorder_pics[0] = 0;
+
+    m_h265Sps.profileTierLevel.general_profile_idc = STD_VIDEO_H265_PROFILE_IDC_MAIN;
+    m_h265Sps.profileTierLevel.general_level_idc = (lumaPictureSize <= 2228224) ? STD_VIDEO_H265_LEVEL_IDC_4_1 :
+                                                   (lumaPictureSize <= 8912896) ? STD_VIDEO_H265_LEVEL_IDC_5_1 :
+                                                                                  STD_VIDEO_H265_LEVEL_IDC_6_2;
+    m_h265Sps.profileTierLevel.flags.general_progressive_source_flag = 1;
+    m_h265Sps.profileTierLevel.flags.general_frame_only_constraint_flag = 1;
+
+    sps.flags.sps_temporal_id_nesting_flag = 1;
+    sps.flags.sps_sub_layer_ordering_info_present_flag = 1;
+    sps.flags.amp_enabled_flag = 1;
+    sps.flags.sample_adaptive_offset_enabled_flag = 1;
+    sps.flags.vui_parameters_present_flag = 1;
+    sps.chroma_format_idc = STD_VIDEO_H265_CHROMA_FORMAT_IDC_420;
+    sps.pic_width_in_luma_samples = picWidthAlignedToMinCbsY;
+    sps.pic_height_in_luma_samples = picHeightAlignedToMinCbsY;
+    sps.sps_video_parameter_set_id = 0;
+    sps.sps_max_sub_layers_minus1 = 0;
+    sps.sps_seq_parameter_set_id = 0;
+    sps.log2_max_pic_order_cnt_lsb_minus4 = 4;
+    sps.log2_min_luma_coding_block_size_minus3 = (uint8_t)(minCbLog2SizeY - 3);
+    sps.log2_diff_max_min_luma_coding_block_size = (uint8_t)(ctbLog2SizeY - minCbLog2SizeY);
+    sps.log2_min_luma_transform_block_size_minus2 = (uint8_t)(log2MinTransformBlockSize - 2);
+    sps.log2_diff_max_min_luma_transform_block_size = (uint8_t)(log2MaxTransformBlockSize - log2MinTransformBlockSize);
+    sps.max_transform_hierarchy_depth_inter = (uint8_t)(ctbLog2SizeY - log2MinTransformBlockSize);
+    sps.max_transform_hierarchy_depth_intra = 3;
+    sps.conf_win_right_offset = (picWidthAlignedToMinCbsY - m_config.width) / 2;
+    sps.conf_win_bottom_offset = (picHeightAlignedToMinCbsY - m_config.height) / 2;
+    sps.flags.conformance_window_flag = (sps.conf_win_right_offset != 0) || (sps.conf_win_bottom_offset != 0);
+
+    // InitializeSpsRefPicSet(): the previous max_dec_pic_buffering_minus1 pictures.
+    sps.num_short_term_ref_pic_sets = 1;
+    m_h265Sps.shortTermRefPicSet.num_negative_pics = m_h265Sps.decPicBufMgr.max_dec_pic_buffering_minus1[0];
+    m_h265Sps.shortTermRefPicSet.used_by_curr_pic_s0_flag = (uint16_t)((1 << m_h265Sps.shortTermRefPicSet.num_negative_pics) - 1);
+
+    vui.flags.vui_timing_info_present_flag = 1;
+    vui.vui_num_units_in_tick = 1;
+    vui.vui_time_scale = m_config.frameRate;
+    vui.video_format = 5;
+    vui.colour_primaries = 1;
+    vui.transfer_characteristics = 1;
+    vui.matrix_coeffs = 1;
+
+    vps.flags.vps_temporal_id_nesting_flag = sps.flags.sps_temporal_id_nesting_flag;
+    vps.flags.vps_sub_layer_ordering_info_present_flag = 1;
+    vps.vps_video_parameter_set_id = 0;
+    vps.vps_max_sub_layers_minus1 = 0;
+    vps.pHrdParameters = &m_h265Sps.hrdParameters;
+    vps.pProfileTierLevel = &m_h265Sps.profileTierLevel;
+    vps.pDecPicBufMgr = &m_h265Sps.decPicBufMgr;
+
+    pps.flags.cabac_init_present_flag = 1;
+    pps.flags.transform_skip_enabled_flag = 1;
+    pps.flags.cu_qp_delta_enabled_flag = 1;
+    pps.flags.pps_loop_filter_across_slices_enabled_flag = 1;
+    pps.flags.deblocking_filter_control_present_flag = 1;
+    pps.pps_pic_parameter_set_id = 0;
+    pps.pps_seq_parameter_set_id = 0;
+    pps.sps_video_parameter_set_id = 0;
+    m_h265PocIdr = 0;
+}
+
+void VkVideoStreamGenerator::GenerateH265AccessUnit(uint32_t frameIndex, bool keyFrame, std::vector<uint8_t>& out)
+{
+    StdVideoH265SequenceParameterSet& sps = m_h265Sps.sps;
+    StdVideoH265PictureParameterSet& pps = m_h265Pps;
+    VkEncoderBitWriter bs;
+
+    const bool parameterSets = keyFrame ||
+        ((m_config.parameterSetInterval > 0) && ((frameIndex % m_config.parameterSetInterval) == 0));
+    if (parameterSets) {
+        if (m_config.changeParameterSets) {
+            if (keyFrame) {
+                m_h265Sps.vuiInfo.flags.video_signal_type_present_flag = (m_sequenceVariant & 1);
+                m_h265Sps.vuiInfo.flags.colour_description_present_flag = (m_sequenceVariant & 1);
+                m_sequenceVariant++;
+            }
+            pps.init_qp_minus26 = (m_parameterSetVariant & 1) ? -4 : 0;
+            pps.pps_cb_qp_offset = pps.pps_cr_qp_offset = (int8_t)(m_parameterSetVariant % 3);
+            m_parameterSetVariant++;
+        }
+
+        VkEncoderHeaderWriter::WriteH265Vps(&m_h265Vps.vpsInfo, bs);
+        AppendNalUnit(out, 0, VkEncoderHeaderWriter::H265_NAL_VPS, bs, true);
+        bs.Reset();
+        VkEncoderHeaderWriter::WriteH265Sps(&sps, bs);
+        AppendNalUnit(out, 0, VkEncoderHeaderWriter::H265_NAL_SPS, bs, true);
+        bs.Reset();
+        VkEncoderHeaderWriter::WriteH265Pps(&pps, bs);
+        AppendNalUnit(out, 0, VkEncoderHeaderWriter::H265_NAL_PPS, bs, true);
+    }
+
+    if (m_config.seiSize > 0) {
+        bs.Reset();
+        PutSeiMessage(bs);
+        AppendNalUnit(out, 0, H265_NAL_PREFIX_SEI, bs);
+        m_stats.numMetadata++;
+    }
+
+    if (keyFrame) {
+        m_h265PocIdr = frameIndex;
+    }
+    const uint32_t pocLsb = (frameIndex - m_h265PocIdr) & ((1u << (sps.log2_max_pic_order_cnt_lsb_minus4 + 4)) - 1);
+    const uint32_t numSlices = std::min(m_config.slicesPerPicture, m_h265PicSizeInCtbsY);
+    const uint32_t addressBits = FastIntLog2(m_h265PicSizeInCtbsY - 1);    // Ceil(Log2(PicSizeInCtbsY))
+
+    for (uint32_t slice = 0; slice < numSlices; slice++) {
+        bs.Reset();
+        bs.PutFlag(slice == 0);             // first_slice_segment_in_pic_flag
+        if (keyFrame) {
+            bs.PutFlag(false);              // no_output_of_prior_pics_flag
+        }
+        bs.PutUe(pps.pps_pic_parameter_set_id);
+        if (slice > 0) {
+            bs.PutBits((uint32_t)(((uint64_t)slice * m_h265PicSizeInCtbsY) / numSlices), addressBits);
+        }
+        bs.PutUe(keyFrame ? 2 : 1);         // slice_type: I / P
+        if (!keyFrame) {
+            bs.PutBits(pocLsb, sps.log2_max_pic_order_cnt_lsb_minus4 + 4);
+            bs.PutFlag(true);               // short_term_ref_pic_set_sps_flag, the only SPS set
+        }
+        if (sps.flags.sample_adaptive_offset_enabled_flag) {
+            bs.PutFlag(true);               // slice_sao_luma_flag
+            bs.PutFlag(true);               // slice_sao_chroma_flag
+        }
+        if (!keyFrame) {
+            bs.PutFlag(false);              // num_ref_idx_active_override_flag
+            if (pps.flags.cabac_init_present_flag) {
+                bs.PutFlag(false);          // cabac_init_flag
+            }
+            bs.PutUe(0);                    // five_minus_max_num_merge_cand
+        }
+        bs.PutSe((int32_t)Random(0, 8) - 4); // slice_qp_delta
+        if (pps.flags.pps_loop_filter_across_slices_enabled_flag) {
+            bs.PutFlag(true);               // slice_loop_filter_across_slices_enabled_flag
+        }
+        bs.PutTrailingBits();               // byte_alignment()
+        PutPayload(bs, GetPayloadSize(keyFrame, numSlices));
+
+        AppendNalUnit(out, 0, keyFrame ? H265_NAL_IDR_W_RADL : H265_NAL_TRAIL_R, bs);
+        m_stats.numSlices++;
+    }
+
+    m_stats.numFrames++;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// AV1
+
+// The sequence header of EncoderConfigAV1::InitSequenceHeader(), with timing
+// info and one operating point, and the largest uniform tile layout of at
+// most slicesPerPicture tiles.
+void VkVideoStreamGenerator::InitAv1SequenceHeader()
+{
+    StdVideoAV1SequenceHeader& seqHdr = m_av1State.m_sequenceHeader;
+    memset(&seqHdr, 0, sizeof(seqHdr));
+
+    seqHdr.seq_profile = STD_VIDEO_AV1_PROFILE_MAIN;
+    seqHdr.max_frame_width_minus_1 = (uint16_t)(m_config.width - 1);
+    seqHdr.max_frame_height_minus_1 = (uint16_t)(m_config.height - 1);
+    seqHdr.frame_width_bits_minus_1 = (uint8_t)(std::max((int)FastIntLog2(m_config.width) - 1, 0));
+    seqHdr.frame_height_bits_minus_1 = (uint8_t)(std::max((int)FastIntLog2(m_config.height) - 1, 0));
+    seqHdr.flags.enable_order_hint = 1;
+    seqHdr.order_hint_bits_minus_1 = 7 - 1;
+    seqHdr.flags.enable_cdef = 1;
+    seqHdr.flags.enable_restoration = 1;
+
+    m_av1State.m_timingInfo.flags.equal_picture_interval = 1;
+    m_av1State.m_timingInfo.num_units_in_display_tick = 1;
+    m_av1State.m_timingInfo.time_scale = m_config.frameRate;
+    m_av1State.m_timingInfo.num_ticks_per_picture_minus_1 = 0;
+    m_av1State.m_timing_info_present_flag = true;
+    seqHdr.flags.timing_info_present_flag = 1;
+    seqHdr.pTimingInfo = &m_av1State.m_timingInfo;
+
+    m_av1ColorConfig.BitDepth = 8;
+    m_av1ColorConfig.subsampling_x = 1;
+    m_av1ColorConfig.subsampling_y = 1;
+    m_av1ColorConfig.color_primaries = STD_VIDEO_AV1_COLOR_PRIMARIES_BT_709;
+    m_av1ColorConfig.transfer_characteristics = STD_VIDEO_AV1_TRANSFER_CHARACTERISTICS_BT_709;
+    m_av1ColorConfig.matrix_coefficients = STD_VIDEO_AV1_MATRIX_COEFFICIENTS_BT_709;
+    seqHdr.pColorConfig = &m_av1ColorConfig;
+
+    // seq_level_idx 13 is level 5.1.
+    m_av1State.m_operatingPointsCount = 1;
+    m_av1State.m_operatingPointsInfo[0].seq_level_idx = ((m_config.width * m_config.height) <= 8912896) ? 13 : 31;
+
+    // tile_info() bounds for 64x64 superblocks.
+    const uint32_t miCols = 2 * ((m_config.width + 7) >> 3);
+    const uint32_t miRows = 2 * ((m_config.height + 7) >> 3);
+    const uint32_t sbCols = (miCols + 15) >> 4;
+    const uint32_t sbRows = (miRows + 15) >> 4;
+    const uint32_t maxTileWidthSb = 4096 >> 6;
+    const uint32_t maxTileAreaSb = (4096 * 2304) >> 12;
+    m_av1MinTileColsLog2 = TileLog2(maxTileWidthSb, sbCols);
+    m_av1MaxTileColsLog2 = TileLog2(1, std::min<uint32_t>(sbCols, 64));
+    m_av1MaxTileRowsLog2 = TileLog2(1, std::min<uint32_t>(sbRows, 64));
+    const uint32_t minLog2Tiles = std::max(m_av1MinTileColsLog2, TileLog2(maxTileAreaSb, sbRows * sbCols));
+
+    const uint32_t tilesLog2 = TileLog2(1, m_config.slicesPerPicture);
+    m_av1TileColsLog2 = std::max(m_av1MinTileColsLog2, std::min(tilesLog2, m_av1MaxTileColsLog2));
+    m_av1MinTileRowsLog2 = (minLog2Tiles > m_av1TileColsLog2) ? (minLog2Tiles - m_av1TileColsLog2) : 0;
+    m_av1TileRowsLog2 = (tilesLog2 > m_av1TileColsLog2) ? (tilesLog2 - m_av1TileColsLog2) : 0;
+    m_av1TileRowsLog2 = std::max(m_av1MinTileRowsLog2, std::min(m_av1TileRowsLog2, m_av1MaxTileRowsLog2));
+
+    const uint32_t tileWidthSb = (sbCols + (1 << m_av1TileColsLog2) - 1) >> m_av1TileColsLog2;
+    const uint32_t tileHeightSb = (sbRows + (1 << m_av1TileRowsLog2) - 1) >> m_av1TileRowsLog2;
+    m_av1NumTiles = DivUp(sbCols, tileWidthSb) * DivUp(sbRows, tileHeightSb);
+    m_av1OrderHint = 0;
+}
+
+// uncompressed_header() of a shown key frame, or of an inter frame that only
+// refers to the reference slots refreshed by the previous key frame.
+void VkVideoStreamGenerator::PutAv1FrameHeader(VkEncoderBitWriter& bs, bool keyFrame, bool showFrame, uint32_t orderHint)
+{
+    const StdVideoAV1SequenceHeader& seqHdr = m_av1State.m_sequenceHeader;
+    assert(showFrame || !keyFrame);
+
+    bs.PutFlag(false);                      // show_existing_frame
+    bs.PutBits(keyFrame ? 0 : 1, 2);        // frame_type: KEY_FRAME / INTER_FRAME
+    bs.PutFlag(showFrame);
+    if (!showFrame) {
+        bs.PutFlag(false);                  // showable_frame
+    }
+    if (!keyFrame) {
+        bs.PutFlag(false);                  // error_resilient_mode
+    }
+    bs.PutFlag(false);                      // disable_cdf_update
+    bs.PutFlag(false);                      // frame_size_override_flag
+    bs.PutBits(orderHint & ((1u << (seqHdr.order_hint_bits_minus_1 + 1)) - 1), seqHdr.order_hint_bits_minus_1 + 1);
+    if (!keyFrame) {
+        bs.PutBits(7, 3);                   // primary_ref_frame = PRIMARY_REF_NONE
+        bs.PutBits(1u << (orderHint % 8), 8); // refresh_frame_flags
+        bs.PutFlag(false);                  // frame_refs_short_signaling
+        for (uint32_t i = 0; i < 7; i++) {
+            bs.PutBits(i, 3);               // ref_frame_idx[i]
+        }
+    }
+    if (seqHdr.flags.enable_superres) {
+        bs.PutFlag(false);                  // use_superres
+    }
+    bs.PutFlag(false);                      // render_and_frame_size_different
+    if (!keyFrame) {
+        bs.PutFlag(true);                   // allow_high_precision_mv
+        bs.PutFlag(true);                   // is_filter_switchable
+        bs.PutFlag(false);                  // is_motion_mode_switchable
+        if (seqHdr.flags.enable_ref_frame_mvs) {
+            bs.PutFlag(false);              // use_ref_frame_mvs
+        }
+    }
+    bs.PutFlag(false);                      // disable_frame_end_update_cdf
+
+    // tile_info()
+    bs.PutFlag(true);                       // uniform_tile_spacing_flag
+    for (uint32_t i = m_av1MinTileColsLog2; i < m_av1MaxTileColsLog2; i++) {
+        bs.PutFlag(i < m_av1TileColsLog2);  // increment_tile_cols_log2
+        if (i >= m_av1TileColsLog2) {
+            break;
+        }
+    }
+    for (uint32_t i = m_av1MinTileRowsLog2; i < m_av1MaxTileRowsLog2; i++) {
+        bs.PutFlag(i < m_av1TileRowsLog2);  // increment_tile_rows_log2
+        if (i >= m_av1TileRowsLog2) {
+            break;
+        }
+    }
+    if ((m_av1TileColsLog2 + m_av1TileRowsLog2) > 0) {
+        bs.PutBits(0, m_av1TileColsLog2 + m_av1TileRowsLog2);  // context_update_tile_id
+        bs.PutBits(av1TileSizeBytes - 1, 2);                    // tile_size_bytes_minus_1
+    }
+
+    // quantization_params(), a non-zero base_q_idx keeps the frame lossy.
+    bs.PutBits(Random(32, 224), 8);         // base_q_idx
+    bs.PutFlag(false);                      // DeltaQYDc delta_coded
+    if (m_av1ColorConfig.flags.separate_uv_delta_q) {
+        bs.PutFlag(false);                  // diff_uv_delta
+    }
+    bs.PutFlag(false);                      // DeltaQUDc delta_coded
+    bs.PutFlag(false);                      // DeltaQUAc delta_coded
+    bs.PutFlag(false);                      // using_qmatrix
+    bs.PutFlag(false);                      // segmentation_enabled
+    bs.PutFlag(false);                      // delta_q_present
+
+    // loop_filter_params()
+    const uint32_t loopFilterLevel = Random(0, 32);
+    bs.PutBits(loopFilterLevel, 6);         // loop_filter_level[0]
+    bs.PutBits(loopFilterLevel, 6);         // loop_filter_level[1]
+    if (loopFilterLevel != 0) {
+        bs.PutBits(loopFilterLevel / 2, 6); // loop_filter_level[2]
+        bs.PutBits(loopFilterLevel / 2, 6); // loop_filter_level[3]
+    }
+    bs.PutBits(0, 3);                       // loop_filter_sharpness
+    bs.PutFlag(false);                      // loop_filter_delta_enabled
+
+    if (seqHdr.flags.enable_cdef) {
+        bs.PutBits(0, 2);                   // cdef_damping_minus_3
+        bs.PutBits(0, 2);                   // cdef_bits
+        bs.PutBits(Random(0, 15), 4);       // cdef_y_pri_strength[0]
+        bs.PutBits(Random(0, 3), 2);        // cdef_y_sec_strength[0]
+        bs.PutBits(Random(0, 15), 4);       // cdef_uv_pri_strength[0]
+        bs.PutBits(Random(0, 3), 2);        // cdef_uv_sec_strength[0]
+    }
+    if (seqHdr.flags.enable_restoration) {
+        bs.PutBits(0, 2 * 3);               // lr_type[] = RESTORE_NONE
+    }
+    bs.PutFlag(true);                       // tx_mode_select
+    if (!keyFrame) {
+        bs.PutFlag(false);                  // reference_select
+        if (seqHdr.flags.enable_warped_motion) {
+            bs.PutFlag(false);              // allow_warped_motion
+        }
+    }
+    bs.PutFlag(false);                      // reduced_tx_set
+    if (!keyFrame) {
+        bs.PutBits(0, 7);                   // is_global[LAST_FRAME..ALTREF_FRAME]
+    }
+}
+
+// A frame as one OBU_FRAME, or as a frame header OBU followed by
+// m_config.tileGroups tile group OBUs.
+void VkVideoStreamGenerator::AppendAv1Frame(std::vector<uint8_t>& out, bool keyFrame, bool showFrame, uint32_t orderHint)
+{
+    const uint32_t numTileGroups = std::min(m_config.tileGroups, m_av1NumTiles);
+    const uint32_t tileBits = m_av1TileColsLog2 + m_av1TileRowsLog2;
+    VkEncoderBitWriter bs;
+
+    PutAv1FrameHeader(bs, keyFrame, showFrame, orderHint);
+    if (numTileGroups > 1) {
+        bs.PutTrailingBits();
+        AppendObu(out, AV1_OBU_FRAME_HEADER, bs);
+        bs.Reset();
+    } else {
+        bs.PutAlignmentBits();              // byte_alignment()
+    }
+
+    for (uint32_t tileGroup = 0; tileGroup < numTileGroups; tileGroup++) {
+        const uint32_t tgStart = (tileGroup * m_av1NumTiles) / numTileGroups;
+        const uint32_t tgEnd = (((tileGroup + 1) * m_av1NumTiles) / numTileGroups) - 1;
+        if (m_av1NumTiles > 1) {
+            bs.PutFlag(numTileGroups > 1);  // tile_start_and_end_present_flag
+            if (numTileGroups > 1) {
+                bs.PutBits(tgStart, tileBits);
+                bs.PutBits(tgEnd, tileBits);
+            }
+        }
+        bs.PutAlignmentBits();
+
+        for (uint32_t tile = tgStart; tile <= tgEnd; tile++) {
+            const uint32_t tileSize = GetPayloadSize(keyFrame, m_av1NumTiles);
+            if (tile != tgEnd) {
+                const uint32_t tileSizeMinus1 = tileSize - 1;
+                for (uint32_t i = 0; i < av1TileSizeBytes; i++) {
+                    bs.PutBits((tileSizeMinus1 >> (8 * i)) & 0xff, 8);  // le(TileSizeBytes)
+                }
+            }
+            PutPayload(bs, tileSize);
+            m_stats.numSlices++;
+        }
+
+        AppendObu(out, (numTileGroups > 1) ? AV1_OBU_TILE_GROUP : AV1_OBU_FRAME, bs);
+        bs.Reset();
+    }
+    m_stats.numFrames++;
+}
+
+void VkVideoStreamGenerator::GenerateAv1TemporalUnit(uint32_t frameIndex, bool keyFrame, std::vector<uint8_t>& out)
+{
+    StdVideoAV1SequenceHeader& seqHdr = m_av1State.m_sequenceHeader;
+    VkEncoderBitWriter bs;
+
+    AppendObu(out, AV1_OBU_TEMPORAL_DELIMITER, bs);
+
+    const bool sequenceHeader = keyFrame ||
+        ((m_config.parameterSetInterval > 0) && ((frameIndex % m_config.parameterSetInterval) == 0));
+    if (sequenceHeader) {
+        // A different sequence header starts a new coded video sequence, so
+        // it can only change at key frames.
+        if (m_config.changeParameterSets && keyFrame) {
+            seqHdr.flags.enable_cdef = !(m_sequenceVariant & 1);
+            m_av1ColorConfig.flags.color_description_present_flag = (m_sequenceVariant & 1);
+            m_sequenceVariant++;
+        }
+        VkEncoderHeaderWriter::WriteAv1SequenceHeader(&seqHdr, nullptr, m_av1State.m_operatingPointsCount,
+                                                      m_av1State.m_operatingPointsInfo, bs);
+        AppendObu(out, VkEncoderHeaderWriter::AV1_OBU_SEQUENCE_HEADER, bs);
+        m_stats.numParameterSets++;
+        bs.Reset();
+    }
+
+    if (m_config.seiSize > 0) {
+        bs.PutBits(av1MetadataTypeUserPrivate, 8);  // metadata_type, leb128() of a value below 128
+        for (uint32_t i = 1; i < m_config.seiSize; i++) {
+            bs.PutBits(Random() & 0xff, 8);
+        }
+        bs.PutTrailingBits();
+        AppendObu(out, AV1_OBU_METADATA, bs);
+        m_stats.numMetadata++;
+        bs.Reset();
+    }
+
+    if (keyFrame) {
+        m_av1OrderHint = 0;
+    }
+    const bool hiddenFrame = !keyFrame && (m_config.hiddenFramePeriod > 0) && ((frameIndex % m_config.hiddenFramePeriod) == 0);
+    if (hiddenFrame) {
+        // A frame that is only used for reference, coded ahead of the shown
+        // frame like an alternate reference frame.
+        AppendAv1Frame(out, false, false, m_av1OrderHint + 1);
+    }
+    AppendAv1Frame(out, keyFrame, true, m_av1OrderHint);
+    m_av1OrderHint += hiddenFrame ? 2 : 1;
+}
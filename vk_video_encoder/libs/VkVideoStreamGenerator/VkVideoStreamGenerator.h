@@ -0,0 +1,146 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _VKVIDEOSTREAMGENERATOR_H_
+#define _VKVIDEOSTREAMGENERATOR_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "vulkan/vulkan.h"
+#include "VkVideoEncoder/VkEncoderHeaderWriter.h"
+#include "VkVideoEncoder/VkVideoEncoderStateH264.h"
+#include "VkVideoEncoder/VkVideoEncoderStateH265.h"
+#include "VkVideoEncoder/VkVideoEncoderStateAV1.h"
+
+// Shape of a synthetic stream. The defaults produce a 1080p stream of 300
+// frames with one slice / tile per picture and a key frame every 60 frames.
+struct VkVideoStreamGeneratorConfig {
+
+    enum Container {
+        CONTAINER_ANNEXB = 0,   // H.264 / H.265 byte stream
+        CONTAINER_OBU,          // AV1 low-overhead OBU stream (Section 5)
+        CONTAINER_IVF,          // AV1 temporal units in IVF frames
+    };
+
+    VkVideoCodecOperationFlagBitsKHR codec = VK_VIDEO_CODEC_OPERATION_ENCODE_H264_BIT_KHR;
+    Container container = CONTAINER_ANNEXB;
+    uint64_t  seed = 1;
+    uint32_t  width = 1920;
+    uint32_t  height = 1080;
+    uint32_t  frameRate = 30;
+    uint32_t  numFrames = 300;
+    uint32_t  idrPeriod = 60;               // frames between key frames, 0: only the first frame
+    uint32_t  frameSize = 16 * 1024;        // average payload bytes of an inter frame, key frames get 4x
+    uint32_t  slicesPerPicture = 1;         // H.26x slices, AV1 tiles
+    uint32_t  parameterSetInterval = 0;     // also repeat the parameter sets every n frames, 0: key frames only
+    bool      changeParameterSets = false;  // alternate the PPS (and the SPS / sequence header at key frames)
+    uint32_t  seiSize = 0;                  // user data SEI / metadata OBU bytes per picture, 0: none
+    uint32_t  emulationRunLength = 0;       // zero byte runs inserted in the payloads, 0: random payloads only
+    bool      mvc = false;                  // H.264: stereo high subset SPS, prefix and non-base view NAL units
+    uint32_t  tileGroups = 1;               // AV1: tile group OBUs per frame, 1: OBU_FRAME
+    uint32_t  hiddenFramePeriod = 0;        // AV1: every n-th temporal unit starts with a frame that is not shown
+    uint32_t  temporalUnitsPerPacket = 1;   // AV1 IVF: temporal units per IVF frame
+};
+
+// Writes syntactically valid H.264 / H.265 Annex B and AV1 OBU streams for
+// the parser benchmarks. The parameter sets live in the encoder state
+// structures, filled in like the EncoderConfig classes do and written by
+// VkEncoderHeaderWriter; the slice and tile data are seeded random filler,
+// so a given configuration always produces the same bytes.
+class VkVideoStreamGenerator {
+
+public:
+
+    struct Stats {
+        uint32_t numFrames;             // coded pictures / frames, hidden AV1 frames included
+        uint32_t numKeyFrames;
+        uint32_t numSlices;             // H.26x slices (all views), AV1 tiles
+        uint32_t numUnits;              // NAL units / OBUs
+        uint32_t numParameterSets;      // VPS/SPS/PPS (subset SPS included) NAL units or sequence header OBUs
+        uint32_t numMetadata;           // SEI NAL units / metadata OBUs
+        uint32_t numPackets;            // access units / IVF frames
+        uint32_t emulationPreventionBytes;
+        uint64_t numBytes;
+    };
+
+    explicit VkVideoStreamGenerator(const VkVideoStreamGeneratorConfig& config);
+
+    // Writes the whole stream to fp, one access unit / IVF frame at a time.
+    VkResult Generate(FILE* fp);
+    VkResult Generate(std::vector<uint8_t>& stream);
+
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    VkResult Generate(FILE* fp, std::vector<uint8_t>* pStream);
+    bool Output(const std::vector<uint8_t>& data);
+
+    uint32_t Random();
+    uint32_t Random(uint32_t minValue, uint32_t maxValue);
+    uint32_t GetPayloadSize(bool keyFrame, uint32_t numParts);
+    // Random filler of size bytes with the configured zero runs, ending in a
+    // non-zero byte. The writer must be byte aligned.
+    void PutPayload(VkEncoderBitWriter& bs, uint32_t size);
+    void AppendNalUnit(std::vector<uint8_t>& out, uint32_t nalRefIdc, uint32_t nalUnitType,
+                       const VkEncoderBitWriter& bs, bool parameterSet = false);
+    void AppendObu(std::vector<uint8_t>& out, uint32_t obuType, const VkEncoderBitWriter& bs);
+    void PutSeiMessage(VkEncoderBitWriter& bs);
+
+    void InitH264ParameterSets();
+    void GenerateH264AccessUnit(uint32_t frameIndex, bool keyFrame, std::vector<uint8_t>& out);
+    void InitH265ParameterSets();
+    void GenerateH265AccessUnit(uint32_t frameIndex, bool keyFrame, std::vector<uint8_t>& out);
+    void InitAv1SequenceHeader();
+    void PutAv1FrameHeader(VkEncoderBitWriter& bs, bool keyFrame, bool showFrame, uint32_t orderHint);
+    void AppendAv1Frame(std::vector<uint8_t>& out, bool keyFrame, bool showFrame, uint32_t orderHint);
+    void GenerateAv1TemporalUnit(uint32_t frameIndex, bool keyFrame, std::vector<uint8_t>& out);
+
+    VkVideoStreamGeneratorConfig m_config;
+    Stats    m_stats;
+    uint64_t m_randomState;
+    uint32_t m_parameterSetVariant;
+    uint32_t m_sequenceVariant;
+    FILE*    m_fp;
+    std::vector<uint8_t>* m_pStream;
+
+    // H.264
+    EncoderH264State m_h264State;
+    uint32_t m_h264FrameNum;
+    uint32_t m_h264IdrPicId;
+
+    // H.265
+    VpsH265  m_h265Vps;
+    SpsH265  m_h265Sps;
+    StdVideoH265PictureParameterSet m_h265Pps;
+    uint32_t m_h265CtbSizeY;
+    uint32_t m_h265PicSizeInCtbsY;
+    uint32_t m_h265PocIdr;
+
+    // AV1
+    EncoderAV1State        m_av1State;
+    StdVideoAV1ColorConfig m_av1ColorConfig;
+    uint32_t m_av1TileColsLog2;
+    uint32_t m_av1TileRowsLog2;
+    uint32_t m_av1MinTileColsLog2;
+    uint32_t m_av1MaxTileColsLog2;
+    uint32_t m_av1MinTileRowsLog2;
+    uint32_t m_av1MaxTileRowsLog2;
+    uint32_t m_av1NumTiles;
+    uint32_t m_av1OrderHint;
+};
+
+#endif /* _VKVIDEOSTREAMGENERATOR_H_ */
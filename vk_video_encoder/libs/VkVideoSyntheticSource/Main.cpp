@@ -0,0 +1,170 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "VkVideoEncoder/VkEncoderSyntheticSource.h"
+
+static void PrintHelp(const char* programName)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "Generates the synthetic input frames of the encoder and measures the generation speed.\n"
+            "  -o, --output <file>          Raw YCbCr output file\n"
+            "      --width <w>, --height <h> Picture size (default 7680x4320)\n"
+            "      --outputFormat <name>    nv12, p010 or i420 (default nv12)\n"
+            "      --frames <n>             Frames to generate (default 120)\n"
+            "      --noiseBits <n>          Random bits per luma sample, 0 to 8 (default 4)\n"
+            "      --motion <n>             Pixels per frame of the panning and the scrolling (default 4)\n"
+            "      --textDensity <n>        Percent of the 16-row lines with text (default 30)\n"
+            "      --sceneChangeInterval <n> Frames per scene, 0: a single scene (default 0)\n"
+            "      --seed <n>               Seed of the content (default 1)\n"
+            "      --threads <n>            Generation threads, 0: up to 4 depending on the CPU (default 0)\n"
+            "      --fps <n>                Frame rate of the real time (default 60)\n"
+            "  -v, --verbose                Print the generation setup\n"
+            "  -h, --help                   Print this help\n",
+            programName);
+}
+
+int main(int argc, const char** argv)
+{
+    VkEncoderSyntheticSource::Config config;
+    config.width = 7680;
+    config.height = 4320;
+    std::string outputFileName;
+    uint64_t numFrames = 120;
+    double frameRate = 60.0;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1) < argc;
+        if ((arg == "-h") || (arg == "--help")) {
+            PrintHelp(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (((arg == "-o") || (arg == "--output")) && hasValue) {
+            outputFileName = argv[++i];
+        } else if ((arg == "--width") && hasValue) {
+            config.width = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--height") && hasValue) {
+            config.height = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+        } else if ((arg == "--outputFormat") && hasValue) {
+            const std::string name = argv[++i];
+            uint32_t f = 0;
+            while ((f < VkEncoderSyntheticSource::OUTPUT_FORMAT_COUNT) &&
+                    (name != VkEncoderSyntheticSource::GetOutputFormatName((VkEncoderSyntheticSource::OutputFormat)f))) {
+                f++;
+            }
+            if (f == VkEncoderSyntheticSource::OUTPUT_FORMAT_COUNT) {
+                fprintf(stderr, "Unknown output format %s\n", name.c_str());
+                return EXIT_FAILURE;
+            }
+            config.outputFormat = (VkEncoderSyntheticSource::OutputFormat)f;
+        } else if ((arg == "--frames") && hasValue) {
+            numFrames = std::strtoull(argv[++i], nullptr, 10);
+        } else if ((arg == "--noiseBits") && hasValue) {
+            config.noiseBits = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--motion") && hasValue) {
+            config.motion = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--textDensity") && hasValue) {
+            config.textDensity = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--sceneChangeInterval") && hasValue) {
+            config.sceneChangeInterval = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--seed") && hasValue) {
+            config.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if ((arg == "--threads") && hasValue) {
+            config.numThreads = (uint32_t)std::max(std::atoi(argv[++i]), 0);
+        } else if ((arg == "--fps") && hasValue) {
+            frameRate = std::max(std::atof(argv[++i]), 1.0);
+        } else if ((arg == "-v") || (arg == "--verbose")) {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument %s\n", arg.c_str());
+            PrintHelp(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    VkEncoderSyntheticSource source;
+    if (!source.Configure(config, verbose)) {
+        return EXIT_FAILURE;
+    }
+
+    FILE* pOutputFile = nullptr;
+    if (!outputFileName.empty()) {
+        pOutputFile = fopen(outputFileName.c_str(), "wb");
+        if (pOutputFile == nullptr) {
+            fprintf(stderr, "Failed to open the output file %s\n", outputFileName.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    const bool nv12 = (config.outputFormat != VkEncoderSyntheticSource::OUTPUT_I420);
+    const uint32_t bytesPerSample = (config.outputFormat == VkEncoderSyntheticSource::OUTPUT_P010) ? 2 : 1;
+    const uint32_t chromaWidth = (config.width + 1) / 2;
+    const uint32_t chromaHeight = (config.height + 1) / 2;
+    const size_t dstPitches[3] = { (size_t)config.width * bytesPerSample,
+                                   (size_t)chromaWidth * bytesPerSample * (nv12 ? 2 : 1),
+                                   (size_t)chromaWidth * bytesPerSample };
+    const size_t planeSizes[3] = { dstPitches[0] * config.height, dstPitches[1] * chromaHeight,
+                                   nv12 ? 0 : (dstPitches[2] * chromaHeight) };
+    std::vector<uint8_t> dst(planeSizes[0] + planeSizes[1] + planeSizes[2]);
+    uint8_t* const pDstPlanes[3] = { dst.data(), dst.data() + planeSizes[0],
+                                     dst.data() + planeSizes[0] + planeSizes[1] };
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t frame = 0;
+    uint64_t numSceneChanges = 0;
+    bool success = true;
+    for (; frame < numFrames; frame++) {
+        if (!source.Generate(frame, pDstPlanes, dstPitches)) {
+            fprintf(stderr, "Failed to generate frame %llu\n", (unsigned long long)frame);
+            success = false;
+            break;
+        }
+        if (source.IsSceneChange(frame)) {
+            numSceneChanges++;
+        }
+
+        if ((pOutputFile != nullptr) && (fwrite(dst.data(), 1, dst.size(), pOutputFile) != dst.size())) {
+            fprintf(stderr, "Failed to write frame %llu\n", (unsigned long long)frame);
+            success = false;
+            break;
+        }
+    }
+    const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (pOutputFile != nullptr) {
+        fclose(pOutputFile);
+    }
+
+    source.PrintReport(stdout);
+    const VkEncoderSyntheticSource::Stats& stats = source.GetStats();
+    if (stats.numFrames > 0) {
+        const double generateSec = (double)stats.generateTimeNs / 1e9;
+        printf("%.1fx real time at %.0f frames/s, %llu scene change(s)\n",
+               (generateSec > 0.0) ? (((double)stats.numFrames / frameRate) / generateSec) : 0.0,
+               frameRate, (unsigned long long)numSceneChanges);
+    }
+    printf("%llu frame(s) in %.2f s\n", (unsigned long long)frame, elapsedSec);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
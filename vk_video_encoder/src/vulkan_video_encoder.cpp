@@ -31,6 +31,26 @@ public:
     virtual VkResult EncodeNextFrame(int64_t& frameNumEncoded);
     virtual VkResult GetBitstream() { return VK_SUCCESS; }
 
+    virtual VkResult SetRateControl(uint32_t averageBitrate, uint32_t maxBitrate, uint32_t cpbSize)
+    {
+        return m_encoder ? m_encoder->SetRateControl(averageBitrate, maxBitrate, cpbSize) : VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    virtual VkResult SetFrameRate(uint32_t frameRateNumerator, uint32_t frameRateDenominator)
+    {
+        return m_encoder ? m_encoder->SetFrameRate(frameRateNumerator, frameRateDenominator) : VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    virtual VkResult SetQualityLevel(uint32_t qualityLevel)
+    {
+        return m_encoder ? m_encoder->SetQualityLevel(qualityLevel) : VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    virtual VkResult RequestIdrFrame()
+    {
+        return m_encoder ? m_encoder->RequestIdrFrame() : VK_ERROR_INITIALIZATION_FAILED;
+    }
+
     VulkanVideoEncoderImpl()
     : m_refCount(0)
     , m_vkDevCtxt()